@@ -0,0 +1,660 @@
+#include "AssetArchive.h"
+#include "Lz4.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+	//1つの塊で圧縮、展開する最小のブロックの数
+	const size_t kMinBlockChunkSize = 2;
+
+	//圧縮してもこの割合より小さくならなければそのまま置く(マップしたまま使える方を選ぶ)
+	const double kMaxCompressedRatio = 0.9;
+
+	const uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+
+	const uint64_t kFnvPrime = 1099511628211ull;
+
+	char NormalizeCharacter(char c) {
+		if (c == '\\') {
+			return '/';
+		}
+		return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+	}
+
+	//正規化した名前どうしを比べる(bは比べながら正規化する)
+	int CompareNormalizedName(std::string_view normalized, std::string_view name) {
+
+		size_t length = (std::min)(normalized.size(), name.size());
+
+		for (size_t i = 0; i < length; ++i) {
+
+			unsigned char a = static_cast<unsigned char>(normalized[i]);
+			unsigned char b = static_cast<unsigned char>(NormalizeCharacter(name[i]));
+
+			if (a != b) {
+				return a < b ? -1 : 1;
+			}
+
+		}
+
+		return normalized.size() == name.size() ? 0 : (normalized.size() < name.size() ? -1 : 1);
+
+	}
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	uint64_t ComputeBlockCount(uint64_t size) {
+		return (size + kAssetArchiveBlockSize - 1) / kAssetArchiveBlockSize;
+	}
+
+	//offsetからsizeバイトがtotalSizeに収まるか(足し算のあふれも考える)
+	bool IsRangeInside(uint64_t offset, uint64_t size, uint64_t totalSize) {
+		return offset <= totalSize && size <= totalSize - offset;
+	}
+
+}
+
+uint64_t ComputeAssetNameHash(std::string_view name) {
+
+	uint64_t hash = kFnvOffsetBasis;
+
+	for (char c : name) {
+		hash ^= static_cast<unsigned char>(NormalizeCharacter(c));
+		hash *= kFnvPrime;
+	}
+
+	return hash;
+
+}
+
+void AssetArchiveWriter::AddEntry(std::string_view name, const void* data, size_t size, AssetCompression compression) {
+
+	PendingEntry entry;
+
+	entry.name.resize(name.size());
+
+	std::transform(name.begin(), name.end(), entry.name.begin(), NormalizeCharacter);
+
+	entry.data = static_cast<const uint8_t*>(data);
+	entry.size = size;
+	entry.compression = compression;
+
+	entries_.push_back(std::move(entry));
+
+}
+
+std::vector<uint8_t> AssetArchiveWriter::WriteToMemory(JobSystem* jobSystem) const {
+
+	//目次の順(ハッシュ、名前の順)。同じ名前が2つあれば書き出さない
+	std::vector<uint32_t> order(entries_.size());
+
+	std::vector<uint64_t> hashes(entries_.size());
+
+	for (uint32_t i = 0; i < entries_.size(); ++i) {
+		order[i] = i;
+		hashes[i] = ComputeAssetNameHash(entries_[i].name);
+	}
+
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		if (hashes[a] != hashes[b]) {
+			return hashes[a] < hashes[b];
+		}
+		return entries_[a].name < entries_[b].name;
+	});
+
+	for (size_t i = 1; i < order.size(); ++i) {
+		if (entries_[order[i - 1]].name == entries_[order[i]].name) {
+			return {};
+		}
+	}
+
+	//圧縮するアセットの全ブロックを1列に並べて並列に圧縮する
+	struct BlockJob {
+		uint32_t entryIndex;
+		uint32_t blockIndex;
+	};
+
+	std::vector<BlockJob> blockJobs;
+
+	std::vector<uint32_t> firstBlockJobs(entries_.size(), 0);
+
+	for (uint32_t i = 0; i < entries_.size(); ++i) {
+
+		firstBlockJobs[i] = static_cast<uint32_t>(blockJobs.size());
+
+		if (entries_[i].compression == AssetCompression::kLz4) {
+			for (uint32_t block = 0; block < ComputeBlockCount(entries_[i].size); ++block) {
+				blockJobs.push_back({ i, block });
+			}
+		}
+
+	}
+
+	std::vector<std::vector<uint8_t>> compressedBlocks(blockJobs.size());
+
+	auto compressBlocks = [&](size_t begin, size_t end) {
+
+		for (size_t job = begin; job < end; ++job) {
+
+			const PendingEntry& entry = entries_[blockJobs[job].entryIndex];
+
+			size_t offset = size_t(blockJobs[job].blockIndex) * kAssetArchiveBlockSize;
+
+			size_t blockSize = (std::min)(entry.size - offset, size_t(kAssetArchiveBlockSize));
+
+			std::vector<uint8_t>& compressed = compressedBlocks[job];
+
+			compressed.resize(GetLz4CompressBound(blockSize));
+
+			//小さくならなければ空にしておき、そのまま置く
+			size_t compressedSize = CompressLz4(entry.data + offset, blockSize, compressed.data(), compressed.size());
+
+			compressed.resize(compressedSize != 0 && compressedSize < blockSize ? compressedSize : 0);
+
+		}
+
+	};
+
+	if (jobSystem != nullptr) {
+		jobSystem->ParallelFor(blockJobs.size(), kMinBlockChunkSize, compressBlocks);
+	} else {
+		compressBlocks(0, blockJobs.size());
+	}
+
+	//アセットごとに圧縮するかどうか決めて、置く場所を求める
+	std::vector<AssetArchiveEntry> tableEntries(entries_.size());
+
+	std::vector<AssetArchiveBlock> tableBlocks;
+
+	std::string names;
+
+	uint64_t offset = AlignUp(sizeof(AssetArchiveHeader), kAssetArchiveAlignment);
+
+	for (size_t i = 0; i < order.size(); ++i) {
+
+		const PendingEntry& entry = entries_[order[i]];
+
+		AssetArchiveEntry& tableEntry = tableEntries[i];
+
+		tableEntry = {};
+		tableEntry.nameHash = hashes[order[i]];
+		tableEntry.size = entry.size;
+		tableEntry.nameOffset = static_cast<uint32_t>(names.size());
+		tableEntry.nameLength = static_cast<uint32_t>(entry.name.size());
+
+		names += entry.name;
+
+		uint32_t blockCount = entry.compression == AssetCompression::kLz4 ? static_cast<uint32_t>(ComputeBlockCount(entry.size)) : 0;
+
+		uint64_t compressedSize = 0;
+
+		for (uint32_t block = 0; block < blockCount; ++block) {
+
+			const std::vector<uint8_t>& compressed = compressedBlocks[firstBlockJobs[order[i]] + block];
+
+			compressedSize += compressed.empty() ? (std::min)(entry.size - size_t(block) * kAssetArchiveBlockSize, size_t(kAssetArchiveBlockSize)) : compressed.size();
+
+		}
+
+		offset = AlignUp(offset, kAssetArchiveAlignment);
+
+		tableEntry.offset = offset;
+
+		if (blockCount != 0 && static_cast<double>(compressedSize) <= static_cast<double>(entry.size) * kMaxCompressedRatio) {
+
+			tableEntry.compression = static_cast<uint32_t>(AssetCompression::kLz4);
+			tableEntry.firstBlock = static_cast<uint32_t>(tableBlocks.size());
+			tableEntry.blockCount = blockCount;
+
+			for (uint32_t block = 0; block < blockCount; ++block) {
+
+				const std::vector<uint8_t>& compressed = compressedBlocks[firstBlockJobs[order[i]] + block];
+
+				uint32_t rawSize = static_cast<uint32_t>((std::min)(entry.size - size_t(block) * kAssetArchiveBlockSize, size_t(kAssetArchiveBlockSize)));
+
+				AssetArchiveBlock tableBlock{};
+
+				tableBlock.offset = offset;
+				tableBlock.compressedSize = compressed.empty() ? rawSize : static_cast<uint32_t>(compressed.size());
+				tableBlock.isCompressed = compressed.empty() ? 0 : 1;
+
+				tableBlocks.push_back(tableBlock);
+
+				offset += tableBlock.compressedSize;
+
+			}
+
+		} else {
+
+			tableEntry.compression = static_cast<uint32_t>(AssetCompression::kNone);
+
+			offset += entry.size;
+
+		}
+
+	}
+
+	AssetArchiveHeader header{};
+
+	header.magic = kAssetArchiveMagic;
+	header.version = kAssetArchiveVersion;
+	header.headerSize = sizeof(AssetArchiveHeader);
+	header.entryCount = static_cast<uint32_t>(tableEntries.size());
+	header.entryOffset = AlignUp(offset, 8);
+	header.blockOffset = header.entryOffset + sizeof(AssetArchiveEntry) * tableEntries.size();
+	header.nameOffset = header.blockOffset + sizeof(AssetArchiveBlock) * tableBlocks.size();
+	header.blockCount = static_cast<uint32_t>(tableBlocks.size());
+	header.blockSize = kAssetArchiveBlockSize;
+	header.nameTableSize = static_cast<uint32_t>(names.size());
+	header.fileSize = header.nameOffset + names.size();
+
+	std::vector<uint8_t> data(header.fileSize, 0);
+
+	std::memcpy(data.data(), &header, sizeof(header));
+
+	for (size_t i = 0; i < order.size(); ++i) {
+
+		const PendingEntry& entry = entries_[order[i]];
+
+		const AssetArchiveEntry& tableEntry = tableEntries[i];
+
+		if (tableEntry.compression == static_cast<uint32_t>(AssetCompression::kNone)) {
+
+			if (entry.size != 0) {
+				std::memcpy(data.data() + tableEntry.offset, entry.data, entry.size);
+			}
+
+			continue;
+
+		}
+
+		for (uint32_t block = 0; block < tableEntry.blockCount; ++block) {
+
+			const std::vector<uint8_t>& compressed = compressedBlocks[firstBlockJobs[order[i]] + block];
+
+			const AssetArchiveBlock& tableBlock = tableBlocks[tableEntry.firstBlock + block];
+
+			const uint8_t* source = compressed.empty() ? entry.data + size_t(block) * kAssetArchiveBlockSize : compressed.data();
+
+			std::memcpy(data.data() + tableBlock.offset, source, tableBlock.compressedSize);
+
+		}
+
+	}
+
+	if (!tableEntries.empty()) {
+		std::memcpy(data.data() + header.entryOffset, tableEntries.data(), sizeof(AssetArchiveEntry) * tableEntries.size());
+	}
+
+	if (!tableBlocks.empty()) {
+		std::memcpy(data.data() + header.blockOffset, tableBlocks.data(), sizeof(AssetArchiveBlock) * tableBlocks.size());
+	}
+
+	if (!names.empty()) {
+		std::memcpy(data.data() + header.nameOffset, names.data(), names.size());
+	}
+
+	return data;
+
+}
+
+bool AssetArchiveWriter::Write(const char* path, JobSystem* jobSystem) const {
+
+	std::vector<uint8_t> data = WriteToMemory(jobSystem);
+
+	if (data.empty()) {
+		return false;
+	}
+
+	FILE* file = std::fopen(path, "wb");
+
+	if (file == nullptr) {
+		return false;
+	}
+
+	bool isWritten = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+
+	return std::fclose(file) == 0 && isWritten;
+
+}
+
+bool AssetArchive::Open(const char* path) {
+
+	Close();
+
+	if (!file_.Open(path)) {
+		return false;
+	}
+
+	data_ = file_.GetData();
+	size_ = file_.GetSize();
+
+	if (!Validate()) {
+		Close();
+		return false;
+	}
+
+	return true;
+
+}
+
+bool AssetArchive::OpenMemory(const uint8_t* data, size_t size) {
+
+	Close();
+
+	data_ = data;
+	size_ = size;
+
+	if (!Validate()) {
+		Close();
+		return false;
+	}
+
+	return true;
+
+}
+
+void AssetArchive::Close() {
+
+	file_.Close();
+
+	data_ = nullptr;
+	size_ = 0;
+	entries_ = nullptr;
+	entryCount_ = 0;
+	blocks_ = nullptr;
+	blockCount_ = 0;
+	names_ = nullptr;
+	nameTableSize_ = 0;
+
+}
+
+bool AssetArchive::Validate() {
+
+	if (data_ == nullptr || size_ < sizeof(AssetArchiveHeader)) {
+		return false;
+	}
+
+	AssetArchiveHeader header;
+
+	std::memcpy(&header, data_, sizeof(header));
+
+	if (header.magic != kAssetArchiveMagic || header.version != kAssetArchiveVersion || header.headerSize != sizeof(AssetArchiveHeader) ||
+		header.fileSize != size_ || header.blockSize != kAssetArchiveBlockSize) {
+		return false;
+	}
+
+	//表はマップしたまま構造体として読むので揃っていること
+	if (header.entryOffset % 8 != 0 || header.blockOffset % 8 != 0 ||
+		!IsRangeInside(header.entryOffset, uint64_t(header.entryCount) * sizeof(AssetArchiveEntry), size_) ||
+		!IsRangeInside(header.blockOffset, uint64_t(header.blockCount) * sizeof(AssetArchiveBlock), size_) ||
+		!IsRangeInside(header.nameOffset, header.nameTableSize, size_)) {
+		return false;
+	}
+
+	entries_ = reinterpret_cast<const AssetArchiveEntry*>(data_ + header.entryOffset);
+	entryCount_ = header.entryCount;
+	blocks_ = reinterpret_cast<const AssetArchiveBlock*>(data_ + header.blockOffset);
+	blockCount_ = header.blockCount;
+	names_ = reinterpret_cast<const char*>(data_ + header.nameOffset);
+	nameTableSize_ = header.nameTableSize;
+
+	for (size_t i = 0; i < entryCount_; ++i) {
+
+		const AssetArchiveEntry& entry = entries_[i];
+
+		if (!IsRangeInside(entry.nameOffset, entry.nameLength, nameTableSize_)) {
+			return false;
+		}
+
+		std::string_view name = GetName(static_cast<uint32_t>(i));
+
+		if (entry.nameHash != ComputeAssetNameHash(name)) {
+			return false;
+		}
+
+		//二分探索できるように並んでいること
+		if (i != 0 && (entries_[i - 1].nameHash > entry.nameHash ||
+			(entries_[i - 1].nameHash == entry.nameHash && CompareNormalizedName(GetName(static_cast<uint32_t>(i - 1)), name) >= 0))) {
+			return false;
+		}
+
+		if (entry.compression == static_cast<uint32_t>(AssetCompression::kNone)) {
+
+			if (!IsRangeInside(entry.offset, entry.size, size_)) {
+				return false;
+			}
+
+			continue;
+
+		}
+
+		//ブロックの数を求める前に大きさを確かめる(大きすぎると切り上げの足し算があふれて0ブロックになる)
+		if (entry.compression != static_cast<uint32_t>(AssetCompression::kLz4) || entry.size > uint64_t(UINT32_MAX) * kAssetArchiveBlockSize) {
+			return false;
+		}
+
+		if (entry.blockCount != ComputeBlockCount(entry.size) || (entry.size != 0 && entry.blockCount == 0) ||
+			!IsRangeInside(entry.firstBlock, entry.blockCount, blockCount_)) {
+			return false;
+		}
+
+		for (uint32_t block = 0; block < entry.blockCount; ++block) {
+
+			const AssetArchiveBlock& archiveBlock = blocks_[entry.firstBlock + block];
+
+			uint64_t rawSize = (std::min)(entry.size - uint64_t(block) * kAssetArchiveBlockSize, uint64_t(kAssetArchiveBlockSize));
+
+			if (!IsRangeInside(archiveBlock.offset, archiveBlock.compressedSize, size_) || (archiveBlock.isCompressed == 0 && archiveBlock.compressedSize != rawSize)) {
+				return false;
+			}
+
+		}
+
+	}
+
+	return true;
+
+}
+
+uint32_t AssetArchive::Find(std::string_view name) const {
+
+	uint64_t hash = ComputeAssetNameHash(name);
+
+	const AssetArchiveEntry* end = entries_ + entryCount_;
+
+	const AssetArchiveEntry* entry = std::lower_bound(entries_, end, hash, [](const AssetArchiveEntry& a, uint64_t value) {
+		return a.nameHash < value;
+	});
+
+	for (; entry != end && entry->nameHash == hash; ++entry) {
+
+		uint32_t index = static_cast<uint32_t>(entry - entries_);
+
+		if (CompareNormalizedName(GetName(index), name) == 0) {
+			return index;
+		}
+
+	}
+
+	return kInvalidIndex;
+
+}
+
+std::string_view AssetArchive::GetName(uint32_t index) const {
+	return std::string_view(names_ + entries_[index].nameOffset, entries_[index].nameLength);
+}
+
+const uint8_t* AssetArchive::GetMappedData(uint32_t index) const {
+
+	if (IsCompressed(index)) {
+		return nullptr;
+	}
+
+	return data_ + entries_[index].offset;
+
+}
+
+bool AssetArchive::DecompressBlock(const AssetArchiveEntry& entry, uint32_t blockIndex, const uint8_t* stored, uint64_t storedOffset, uint8_t* destination) const {
+
+	const AssetArchiveBlock& block = blocks_[entry.firstBlock + blockIndex];
+
+	size_t rawSize = static_cast<size_t>((std::min)(entry.size - uint64_t(blockIndex) * kAssetArchiveBlockSize, uint64_t(kAssetArchiveBlockSize)));
+
+	const uint8_t* source = stored + (block.offset - storedOffset);
+
+	if (block.isCompressed == 0) {
+		std::memcpy(destination, source, rawSize);
+		return true;
+	}
+
+	return DecompressLz4(source, block.compressedSize, destination, rawSize);
+
+}
+
+bool AssetArchive::GetStoredRange(uint32_t index, uint64_t offset, uint64_t size, uint64_t& storedOffset, uint64_t& storedSize) const {
+
+	const AssetArchiveEntry& entry = entries_[index];
+
+	if (!IsRangeInside(offset, size, entry.size)) {
+		return false;
+	}
+
+	if (!IsCompressed(index) || size == 0) {
+		storedOffset = entry.offset + (IsCompressed(index) ? 0 : offset);
+		storedSize = IsCompressed(index) ? 0 : size;
+		return true;
+	}
+
+	//ブロックは書き出す時に順に並べているが、表の位置から範囲を求める
+	uint32_t firstBlock = static_cast<uint32_t>(offset / kAssetArchiveBlockSize);
+
+	uint32_t lastBlock = static_cast<uint32_t>((offset + size - 1) / kAssetArchiveBlockSize);
+
+	uint64_t begin = UINT64_MAX;
+
+	uint64_t end = 0;
+
+	for (uint32_t block = firstBlock; block <= lastBlock; ++block) {
+
+		const AssetArchiveBlock& record = blocks_[entry.firstBlock + block];
+
+		uint64_t storedBlockSize = record.isCompressed != 0 ? record.compressedSize : (std::min)(entry.size - uint64_t(block) * kAssetArchiveBlockSize, uint64_t(kAssetArchiveBlockSize));
+
+		begin = (std::min)(begin, record.offset);
+
+		end = (std::max)(end, record.offset + storedBlockSize);
+
+	}
+
+	storedOffset = begin;
+
+	storedSize = end - begin;
+
+	return true;
+
+}
+
+bool AssetArchive::Read(uint32_t index, uint64_t offset, uint64_t size, void* destination) const {
+	return DecodeStored(index, offset, size, data_, 0, destination);
+}
+
+bool AssetArchive::DecodeStored(uint32_t index, uint64_t offset, uint64_t size, const uint8_t* stored, uint64_t storedOffset, void* destination) const {
+
+	const AssetArchiveEntry& entry = entries_[index];
+
+	if (!IsRangeInside(offset, size, entry.size)) {
+		return false;
+	}
+
+	if (size == 0) {
+		return true;
+	}
+
+	uint8_t* output = static_cast<uint8_t*>(destination);
+
+	if (!IsCompressed(index)) {
+		std::memcpy(output, stored + (entry.offset + offset - storedOffset), static_cast<size_t>(size));
+		return true;
+	}
+
+	//一部だけ使うブロックは作業用の領域に展開してから写す
+	thread_local std::vector<uint8_t> scratch;
+
+	uint32_t firstBlock = static_cast<uint32_t>(offset / kAssetArchiveBlockSize);
+
+	uint32_t lastBlock = static_cast<uint32_t>((offset + size - 1) / kAssetArchiveBlockSize);
+
+	for (uint32_t block = firstBlock; block <= lastBlock; ++block) {
+
+		uint64_t blockBegin = uint64_t(block) * kAssetArchiveBlockSize;
+
+		uint64_t blockEnd = (std::min)(blockBegin + kAssetArchiveBlockSize, entry.size);
+
+		uint64_t copyBegin = (std::max)(blockBegin, offset);
+
+		uint64_t copyEnd = (std::min)(blockEnd, offset + size);
+
+		uint8_t* blockOutput = output + (copyBegin - offset);
+
+		if (copyBegin == blockBegin && copyEnd == blockEnd) {
+
+			if (!DecompressBlock(entry, block, stored, storedOffset, blockOutput)) {
+				return false;
+			}
+
+			continue;
+
+		}
+
+		scratch.resize(kAssetArchiveBlockSize);
+
+		if (!DecompressBlock(entry, block, stored, storedOffset, scratch.data())) {
+			return false;
+		}
+
+		std::memcpy(blockOutput, scratch.data() + (copyBegin - blockBegin), static_cast<size_t>(copyEnd - copyBegin));
+
+	}
+
+	return true;
+
+}
+
+bool AssetArchive::ReadAll(uint32_t index, void* destination, JobSystem* jobSystem) const {
+
+	const AssetArchiveEntry& entry = entries_[index];
+
+	if (!IsCompressed(index) || jobSystem == nullptr) {
+		return Read(index, 0, entry.size, destination);
+	}
+
+	uint8_t* output = static_cast<uint8_t*>(destination);
+
+	std::atomic<bool> isFailed = false;
+
+	jobSystem->ParallelFor(entry.blockCount, kMinBlockChunkSize, [&](size_t begin, size_t end) {
+		for (size_t block = begin; block < end; ++block) {
+			if (!DecompressBlock(entry, static_cast<uint32_t>(block), data_, 0, output + block * kAssetArchiveBlockSize)) {
+				isFailed.store(true, std::memory_order_relaxed);
+			}
+		}
+	});
+
+	return !isFailed.load();
+
+}
+
+bool AssetArchive::ReadAll(uint32_t index, std::vector<uint8_t>& destination, JobSystem* jobSystem) const {
+
+	destination.resize(static_cast<size_t>(entries_[index].size));
+
+	return ReadAll(index, destination.data(), jobSystem);
+
+}
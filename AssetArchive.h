@@ -0,0 +1,188 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+
+class JobSystem;
+
+//アセットをまとめた入れ物のファイル(.pak)
+//ヘッダー、各アセットの中身、目次(名前のハッシュ順)、ブロックの表、名前の表の順に並ぶ
+//中身はkAssetArchiveAlignmentに揃えて置き、圧縮したものはkAssetArchiveBlockSizeごとにLZ4で圧縮する
+//圧縮しても小さくならないアセットはそのまま置き、マップしたまま使えるようにする
+
+const uint32_t kAssetArchiveMagic = 0x4b504743; //"CGPK"
+
+//形式を変えたら上げる
+const uint32_t kAssetArchiveVersion = 1;
+
+//ページの大きさに揃える(そのまま置いたアセットの中の揃えも保たれる)
+const uint32_t kAssetArchiveAlignment = 4096;
+
+const uint32_t kAssetArchiveBlockSize = 64 * 1024;
+
+enum class AssetCompression : uint32_t {
+	kNone = 0,
+	kLz4 = 1,
+};
+
+struct AssetArchiveHeader {
+
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t entryCount;
+
+	uint64_t fileSize;
+
+	uint64_t entryOffset;
+	uint64_t blockOffset;
+	uint64_t nameOffset;
+
+	uint32_t blockCount;
+	uint32_t blockSize;
+
+	uint32_t nameTableSize;
+	uint32_t reserved;
+
+};
+
+static_assert(sizeof(AssetArchiveHeader) == 64, "AssetArchiveHeader layout changed");
+
+//目次の1項目(nameHashの順、同じなら名前の順に並ぶ)
+struct AssetArchiveEntry {
+
+	uint64_t nameHash;
+
+	//そのまま置いたものは中身の位置、圧縮したものは最初のブロックの位置
+	uint64_t offset;
+
+	//展開した大きさ
+	uint64_t size;
+
+	uint32_t nameOffset;
+	uint32_t nameLength;
+
+	//圧縮したものだけが使う
+	uint32_t firstBlock;
+	uint32_t blockCount;
+
+	uint32_t compression;
+	uint32_t reserved;
+
+};
+
+static_assert(sizeof(AssetArchiveEntry) == 48, "AssetArchiveEntry layout changed");
+
+struct AssetArchiveBlock {
+
+	uint64_t offset;
+
+	uint32_t compressedSize;
+
+	//0ならブロックをそのまま置いている(圧縮しても小さくならなかった)
+	uint32_t isCompressed;
+
+};
+
+static_assert(sizeof(AssetArchiveBlock) == 16, "AssetArchiveBlock layout changed");
+
+//名前を正規化したハッシュ(小文字にして'\\'を'/'にする)
+uint64_t ComputeAssetNameHash(std::string_view name);
+
+class AssetArchiveWriter {
+
+public:
+
+	//dataは書き出すまで残しておくこと。名前は正規化して保存する
+	void AddEntry(std::string_view name, const void* data, size_t size, AssetCompression compression = AssetCompression::kLz4);
+
+	//ブロックの圧縮はjobSystemで並列に行う(nullptrなら1スレッド)
+	bool Write(const char* path, JobSystem* jobSystem = nullptr) const;
+
+	std::vector<uint8_t> WriteToMemory(JobSystem* jobSystem = nullptr) const;
+
+private:
+
+	struct PendingEntry {
+		std::string name;
+		const uint8_t* data;
+		size_t size;
+		AssetCompression compression;
+	};
+
+	std::vector<PendingEntry> entries_;
+
+};
+
+class AssetArchive {
+
+public:
+
+	static const uint32_t kInvalidIndex = 0xffffffff;
+
+	//ファイルをマップしてヘッダーと表を確かめる(中身は読まない)
+	bool Open(const char* path);
+
+	//メモリ上のデータを使う(dataは使い終わるまで残しておくこと)
+	bool OpenMemory(const uint8_t* data, size_t size);
+
+	void Close();
+
+	//名前で目次を二分探索する(なければkInvalidIndex)
+	uint32_t Find(std::string_view name) const;
+
+	size_t GetEntryCount() const { return entryCount_; }
+
+	std::string_view GetName(uint32_t index) const;
+
+	uint64_t GetSize(uint32_t index) const { return entries_[index].size; }
+
+	bool IsCompressed(uint32_t index) const { return entries_[index].compression != static_cast<uint32_t>(AssetCompression::kNone); }
+
+	//そのまま置いたアセットのマップした中身(圧縮していればnullptr)
+	const uint8_t* GetMappedData(uint32_t index) const;
+
+	//offsetからsizeバイトを読む(触れるブロックだけを展開する)
+	bool Read(uint32_t index, uint64_t offset, uint64_t size, void* destination) const;
+
+	//[offset, offset + size)を読むのに要るファイルの中の範囲(マップせずに自分で読む時に使う)
+	bool GetStoredRange(uint32_t index, uint64_t offset, uint64_t size, uint64_t& storedOffset, uint64_t& storedSize) const;
+
+	//GetStoredRangeの範囲を読んだstoredから[offset, offset + size)を取り出す
+	bool DecodeStored(uint32_t index, uint64_t offset, uint64_t size, const uint8_t* stored, uint64_t storedOffset, void* destination) const;
+
+	//全体を読む。ブロックはjobSystemで並列に展開する(nullptrなら1スレッド)
+	bool ReadAll(uint32_t index, void* destination, JobSystem* jobSystem = nullptr) const;
+
+	bool ReadAll(uint32_t index, std::vector<uint8_t>& destination, JobSystem* jobSystem = nullptr) const;
+
+private:
+
+	bool Validate();
+
+	//blockIndex番目のブロックを展開する(最後のブロック以外はkAssetArchiveBlockSizeバイト)
+	//storedはファイルのstoredOffsetの位置から読んだもの
+	bool DecompressBlock(const AssetArchiveEntry& entry, uint32_t blockIndex, const uint8_t* stored, uint64_t storedOffset, uint8_t* destination) const;
+
+	MappedFile file_;
+
+	const uint8_t* data_ = nullptr;
+
+	size_t size_ = 0;
+
+	const AssetArchiveEntry* entries_ = nullptr;
+
+	size_t entryCount_ = 0;
+
+	const AssetArchiveBlock* blocks_ = nullptr;
+
+	size_t blockCount_ = 0;
+
+	const char* names_ = nullptr;
+
+	size_t nameTableSize_ = 0;
+
+};
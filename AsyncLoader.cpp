@@ -0,0 +1,1059 @@
+#include "AsyncLoader.h"
+#include "AssetArchive.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+	const intptr_t kInvalidFile = -1;
+
+	//1回の読み込みで読む最大のバイト数
+	const uint64_t kMaxReadChunkSize = 1ull << 30;
+
+	//io_uringの列の長さ(まとめた読み込みがこれより多ければ何回かに分けて出す)
+	const uint32_t kIoRingEntryCount = 64;
+
+	//IORING_REGISTER_PROBEで問い合わせる命令の数
+	const uint32_t kIoRingProbeOpCount = 256;
+
+	float ElapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//まとめて出す1つの読み込み
+	struct ReadOperation {
+
+		intptr_t file;
+
+		uint64_t offset;
+		uint64_t size;
+
+		uint8_t* destination;
+
+		//読めたバイト数
+		uint64_t doneSize;
+
+		bool isFailed;
+
+		//io_uringの結果を受け取れなかった(カーネルがまだ書き込むかもしれないので、destinationを手放してはいけない)
+		bool isAbandoned;
+
+		void* userData;
+
+	};
+
+#if defined(_WIN32)
+
+	intptr_t OpenReadFile(const char* path) {
+
+		//パスはUTF-8で受け取る
+		int length = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+		std::wstring widePath(length, L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, path, -1, &widePath[0], length);
+
+		HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		return file == INVALID_HANDLE_VALUE ? kInvalidFile : reinterpret_cast<intptr_t>(file);
+
+	}
+
+	bool GetReadFileSize(intptr_t file, uint64_t& size) {
+
+		LARGE_INTEGER fileSize{};
+
+		if (!GetFileSizeEx(reinterpret_cast<HANDLE>(file), &fileSize)) {
+			return false;
+		}
+
+		size = static_cast<uint64_t>(fileSize.QuadPart);
+
+		return true;
+
+	}
+
+	//位置を指定して読む(同期のハンドルでもOVERLAPPEDで位置を渡せば、ほかのスレッドと位置を取り合わない)
+	bool ReadFileAt(intptr_t file, uint64_t offset, uint64_t size, uint8_t* destination) {
+
+		while (size > 0) {
+
+			OVERLAPPED overlapped{};
+
+			overlapped.Offset = static_cast<DWORD>(offset);
+			overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+			DWORD readSize = 0;
+
+			if (!ReadFile(reinterpret_cast<HANDLE>(file), destination, static_cast<DWORD>((std::min)(size, kMaxReadChunkSize)), &readSize, &overlapped) || readSize == 0) {
+				return false;
+			}
+
+			offset += readSize;
+			size -= readSize;
+			destination += readSize;
+
+		}
+
+		return true;
+
+	}
+
+	void CloseReadFile(intptr_t file) {
+		CloseHandle(reinterpret_cast<HANDLE>(file));
+	}
+
+#else
+
+	intptr_t OpenReadFile(const char* path) {
+
+		int file = open(path, O_RDONLY | O_CLOEXEC);
+
+		return file < 0 ? kInvalidFile : file;
+
+	}
+
+	bool GetReadFileSize(intptr_t file, uint64_t& size) {
+
+		struct stat status{};
+
+		if (fstat(static_cast<int>(file), &status) != 0) {
+			return false;
+		}
+
+		size = static_cast<uint64_t>(status.st_size);
+
+		return true;
+
+	}
+
+	bool ReadFileAt(intptr_t file, uint64_t offset, uint64_t size, uint8_t* destination) {
+
+		while (size > 0) {
+
+			ssize_t readSize = pread(static_cast<int>(file), destination, static_cast<size_t>((std::min)(size, kMaxReadChunkSize)), static_cast<off_t>(offset));
+
+			if (readSize < 0 && errno == EINTR) {
+				continue;
+			}
+
+			if (readSize <= 0) {
+				return false;
+			}
+
+			offset += static_cast<uint64_t>(readSize);
+			size -= static_cast<uint64_t>(readSize);
+			destination += readSize;
+
+		}
+
+		return true;
+
+	}
+
+	void CloseReadFile(intptr_t file) {
+		close(static_cast<int>(file));
+	}
+
+#endif
+
+}
+
+//読み込みをまとめてカーネルに渡す列(Linuxのio_uring)
+//liburingは使わず、システムコールで直接列を作る
+struct AsyncLoader::IoRing {
+
+#if defined(__linux__)
+
+	int ringFile = -1;
+
+	void* submissionRing = nullptr;
+	size_t submissionRingSize = 0;
+
+	void* completionRing = nullptr;
+	size_t completionRingSize = 0;
+
+	io_uring_sqe* submissionEntries = nullptr;
+	size_t submissionEntriesSize = 0;
+
+	uint32_t* submissionHead = nullptr;
+	uint32_t* submissionTail = nullptr;
+	uint32_t* submissionMask = nullptr;
+	uint32_t* submissionArray = nullptr;
+
+	uint32_t* completionHead = nullptr;
+	uint32_t* completionTail = nullptr;
+	uint32_t* completionMask = nullptr;
+	io_uring_cqe* completionEntries = nullptr;
+
+	uint32_t entryCount = 0;
+
+	//出し損ねた読み込みが列に残っているかもしれないので、以降は使わない
+	bool isUsable = true;
+
+	bool Initialize(uint32_t requestedEntryCount) {
+
+		io_uring_params parameters{};
+
+		ringFile = static_cast<int>(syscall(__NR_io_uring_setup, requestedEntryCount, &parameters));
+
+		if (ringFile < 0) {
+			return false;
+		}
+
+		entryCount = parameters.sq_entries;
+
+		submissionRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof(uint32_t);
+
+		completionRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe);
+
+		//新しいカーネルでは2つの列を1つのマップで使う
+		bool isSingleMap = (parameters.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+		if (isSingleMap) {
+			submissionRingSize = completionRingSize = (std::max)(submissionRingSize, completionRingSize);
+		}
+
+		submissionRing = mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFile, IORING_OFF_SQ_RING);
+
+		if (submissionRing == MAP_FAILED) {
+			submissionRing = nullptr;
+			Finalize();
+			return false;
+		}
+
+		if (isSingleMap) {
+			completionRing = submissionRing;
+		} else {
+			completionRing = mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFile, IORING_OFF_CQ_RING);
+			if (completionRing == MAP_FAILED) {
+				completionRing = nullptr;
+				Finalize();
+				return false;
+			}
+		}
+
+		submissionEntriesSize = parameters.sq_entries * sizeof(io_uring_sqe);
+
+		void* entries = mmap(nullptr, submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFile, IORING_OFF_SQES);
+
+		if (entries == MAP_FAILED) {
+			Finalize();
+			return false;
+		}
+
+		submissionEntries = static_cast<io_uring_sqe*>(entries);
+
+		uint8_t* submission = static_cast<uint8_t*>(submissionRing);
+
+		submissionHead = reinterpret_cast<uint32_t*>(submission + parameters.sq_off.head);
+		submissionTail = reinterpret_cast<uint32_t*>(submission + parameters.sq_off.tail);
+		submissionMask = reinterpret_cast<uint32_t*>(submission + parameters.sq_off.ring_mask);
+		submissionArray = reinterpret_cast<uint32_t*>(submission + parameters.sq_off.array);
+
+		uint8_t* completion = static_cast<uint8_t*>(completionRing);
+
+		completionHead = reinterpret_cast<uint32_t*>(completion + parameters.cq_off.head);
+		completionTail = reinterpret_cast<uint32_t*>(completion + parameters.cq_off.tail);
+		completionMask = reinterpret_cast<uint32_t*>(completion + parameters.cq_off.ring_mask);
+		completionEntries = reinterpret_cast<io_uring_cqe*>(completion + parameters.cq_off.cqes);
+
+		//IORING_OP_READは5.6から。知らないカーネル(5.1から5.5)では全部の読み込みが-EINVALになるので、使えるか確かめる
+		if (!IsReadSupported()) {
+			Finalize();
+			return false;
+		}
+
+		return true;
+
+	}
+
+	//IORING_REGISTER_PROBEも5.6からなので、問い合わせが失敗すればIORING_OP_READもない
+	bool IsReadSupported() const {
+
+		std::vector<uint8_t> buffer(sizeof(io_uring_probe) + kIoRingProbeOpCount * sizeof(io_uring_probe_op), 0);
+
+		io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+
+		if (syscall(__NR_io_uring_register, ringFile, IORING_REGISTER_PROBE, probe, kIoRingProbeOpCount) < 0) {
+			return false;
+		}
+
+		return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0;
+
+	}
+
+	void Finalize() {
+
+		if (submissionEntries != nullptr) {
+			munmap(submissionEntries, submissionEntriesSize);
+		}
+
+		if (completionRing != nullptr && completionRing != submissionRing) {
+			munmap(completionRing, completionRingSize);
+		}
+
+		if (submissionRing != nullptr) {
+			munmap(submissionRing, submissionRingSize);
+		}
+
+		if (ringFile >= 0) {
+			close(ringFile);
+		}
+
+		ringFile = -1;
+		submissionRing = nullptr;
+		completionRing = nullptr;
+		submissionEntries = nullptr;
+
+		abandonedBuffers.clear();
+
+	}
+
+	//operationsを全部読む(短く読めた分は続きを出し直す)。列が使えなくなったらfalseを返し、残りは呼び出し側が読む
+	//カーネルに渡したものは結果を受け取るまで待つ。待てなかったものはisAbandonedにして、バッファを使い回させない
+	bool Read(ReadOperation* operations, size_t count) {
+
+		size_t nextOperation = 0;
+
+		//読み終わっていないもの(短く読めて出し直すもの)
+		std::vector<uint32_t> retryOperations;
+
+		//列に積んで、まだ結果を受け取っていないもの
+		std::vector<bool> isPending(count, false);
+
+		uint32_t pendingCount = 0;
+
+		//届いた結果を受け取る
+		auto reap = [&]() {
+
+			uint32_t head = *completionHead;
+
+			uint32_t completionTailValue = __atomic_load_n(completionTail, __ATOMIC_ACQUIRE);
+
+			for (; head != completionTailValue; ++head) {
+
+				const io_uring_cqe& entry = completionEntries[head & *completionMask];
+
+				uint32_t operationIndex = static_cast<uint32_t>(entry.user_data);
+
+				ReadOperation& operation = operations[operationIndex];
+
+				isPending[operationIndex] = false;
+
+				--pendingCount;
+
+				if (entry.res == -EINVAL || entry.res == -EOPNOTSUPP) {
+					//この列では読めない。残りは呼び出し側がスレッドで読む
+					isUsable = false;
+				} else if (entry.res == -EINTR || entry.res == -EAGAIN) {
+					retryOperations.push_back(operationIndex);
+				} else if (entry.res <= 0) {
+					//ファイルの終わりより先を読もうとしたか、読めなかった
+					operation.isFailed = true;
+				} else {
+					operation.doneSize += static_cast<uint64_t>(entry.res);
+					if (operation.doneSize < operation.size) {
+						retryOperations.push_back(operationIndex);
+					}
+				}
+
+			}
+
+			__atomic_store_n(completionHead, head, __ATOMIC_RELEASE);
+
+		};
+
+		while (isUsable && (nextOperation < count || !retryOperations.empty())) {
+
+			uint32_t tail = *submissionTail;
+
+			auto push = [&](uint32_t operationIndex) {
+
+				ReadOperation& operation = operations[operationIndex];
+
+				uint32_t slot = tail & *submissionMask;
+
+				io_uring_sqe& entry = submissionEntries[slot];
+
+				std::memset(&entry, 0, sizeof(entry));
+
+				entry.opcode = IORING_OP_READ;
+				entry.fd = static_cast<int>(operation.file);
+				entry.off = operation.offset + operation.doneSize;
+				entry.addr = reinterpret_cast<uint64_t>(operation.destination + operation.doneSize);
+				entry.len = static_cast<uint32_t>((std::min)(operation.size - operation.doneSize, kMaxReadChunkSize));
+				entry.user_data = operationIndex;
+
+				submissionArray[slot] = slot;
+
+				isPending[operationIndex] = true;
+
+				++tail;
+				++pendingCount;
+
+			};
+
+			while (pendingCount < entryCount && !retryOperations.empty()) {
+				push(retryOperations.back());
+				retryOperations.pop_back();
+			}
+
+			while (pendingCount < entryCount && nextOperation < count) {
+				push(static_cast<uint32_t>(nextOperation++));
+			}
+
+			//カーネルが列の中身を読む前に書き込みを見えるようにする
+			__atomic_store_n(submissionTail, tail, __ATOMIC_RELEASE);
+
+			while (pendingCount > 0) {
+
+				//カーネルがまだ取り出していない分を出す(割り込まれた時は出し直す)
+				uint32_t unsubmittedCount = tail - __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+
+				int result = static_cast<int>(syscall(__NR_io_uring_enter, ringFile, unsubmittedCount, pendingCount, IORING_ENTER_GETEVENTS, nullptr, 0));
+
+				if (result < 0 && errno != EINTR) {
+					isUsable = false;
+					Abandon(operations, isPending, pendingCount, tail, reap);
+					return false;
+				}
+
+				reap();
+
+			}
+
+		}
+
+		return isUsable;
+
+	}
+
+	//io_uring_enterが失敗した時の後始末。カーネルが取り出していないものは列から外し(呼び出し側が読み直す)、
+	//取り出したものは結果が届くまで待つ。それでも届かないものは失敗にして、バッファを手放させない
+	template<typename Reap>
+	void Abandon(ReadOperation* operations, std::vector<bool>& isPending, uint32_t& pendingCount, uint32_t tail, Reap& reap) {
+
+		uint32_t head = __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+
+		for (uint32_t i = head; i != tail; ++i) {
+
+			uint32_t operationIndex = static_cast<uint32_t>(submissionEntries[submissionArray[i & *submissionMask]].user_data);
+
+			isPending[operationIndex] = false;
+
+			--pendingCount;
+
+		}
+
+		//SQPOLLを使わないので、取り出されるのはio_uring_enterの中だけ。tailを戻せばもう読まれない
+		__atomic_store_n(submissionTail, head, __ATOMIC_RELEASE);
+
+		reap();
+
+		while (pendingCount > 0) {
+
+			int result = static_cast<int>(syscall(__NR_io_uring_enter, ringFile, 0, pendingCount, IORING_ENTER_GETEVENTS, nullptr, 0));
+
+			if (result < 0 && errno != EINTR) {
+				break;
+			}
+
+			reap();
+
+		}
+
+		for (size_t i = 0; i < isPending.size(); ++i) {
+			if (isPending[i]) {
+				operations[i].isFailed = true;
+				operations[i].isAbandoned = true;
+			}
+		}
+
+	}
+
+	//結果を受け取れなかった読み込みのバッファ(列を閉じるまで持っておく)
+	std::vector<std::vector<uint8_t>> abandonedBuffers;
+
+#else
+
+	bool isUsable = false;
+
+	bool Initialize(uint32_t) {
+		return false;
+	}
+
+	void Finalize() {
+	}
+
+	bool Read(ReadOperation*, size_t) {
+		return false;
+	}
+
+	std::vector<std::vector<uint8_t>> abandonedBuffers;
+
+#endif
+
+};
+
+AsyncLoader::AsyncLoader() = default;
+
+AsyncLoader::~AsyncLoader() = default;
+
+void AsyncLoader::Initialize(const AsyncLoaderSettings& settings, JobSystem* jobSystem) {
+
+	settings_ = settings;
+
+	settings_.maxBatchSize = (std::max)(settings_.maxBatchSize, 1u);
+
+	jobSystem_ = jobSystem;
+
+	isExit_ = false;
+
+	statistics_ = {};
+
+	uint32_t ioThreadCount = (std::max)(settings_.ioThreadCount, 1u);
+
+	if (settings_.useIoUring) {
+
+		ioRing_ = std::make_unique<IoRing>();
+
+		if (ioRing_->Initialize(kIoRingEntryCount)) {
+			//まとめた読み込みはカーネルが並べて進めるので、スレッドは1つでよい
+			ioThreadCount = 1;
+		} else {
+			ioRing_.reset();
+		}
+
+	}
+
+	statistics_.isIoUringEnabled = ioRing_ != nullptr;
+
+	for (uint32_t i = 0; i < ioThreadCount; ++i) {
+		ioThreads_.emplace_back(&AsyncLoader::IoThreadMain, this, i);
+	}
+
+}
+
+void AsyncLoader::Finalize() {
+
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		isExit_ = true;
+
+		for (std::deque<Request*>& queue : queues_) {
+			queue.clear();
+		}
+	}
+
+	condition_.notify_all();
+
+	for (std::thread& thread : ioThreads_) {
+		thread.join();
+	}
+
+	ioThreads_.clear();
+
+	//JobSystemに積んだ展開が終わるのを待つ
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		idleCondition_.wait(lock, [this] { return statistics_.inFlightCount == 0; });
+
+		readyRequests_.clear();
+
+		requests_.clear();
+	}
+
+	if (ioRing_ != nullptr) {
+		ioRing_->Finalize();
+		ioRing_.reset();
+	}
+
+	for (auto& [path, file] : archiveFiles_) {
+		CloseReadFile(file);
+	}
+
+	archiveFiles_.clear();
+
+}
+
+uint64_t AsyncLoader::RequestFile(const char* path, AsyncLoadPriority priority, AsyncLoadCallback callback) {
+
+	std::unique_ptr<Request> request = std::make_unique<Request>();
+
+	request->priority = priority;
+	request->callback = std::move(callback);
+	request->path = path;
+	request->archive = nullptr;
+	request->assetIndex = 0;
+	request->assetOffset = 0;
+	request->assetSize = 0;
+
+	//大きさは読み込み用のスレッドで開いた時に決める
+	request->fileOffset = 0;
+	request->fileSize = 0;
+
+	return Enqueue(std::move(request));
+
+}
+
+uint64_t AsyncLoader::RequestAsset(const AssetArchive* archive, const char* archivePath, uint32_t index, uint64_t offset, uint64_t size, AsyncLoadPriority priority, AsyncLoadCallback callback) {
+
+	uint64_t storedOffset = 0;
+
+	uint64_t storedSize = 0;
+
+	if (!archive->GetStoredRange(index, offset, size, storedOffset, storedSize)) {
+		return kInvalidId;
+	}
+
+	std::unique_ptr<Request> request = std::make_unique<Request>();
+
+	request->priority = priority;
+	request->callback = std::move(callback);
+	request->path = archivePath;
+	request->archive = archive;
+	request->assetIndex = index;
+	request->assetOffset = offset;
+	request->assetSize = size;
+	request->fileOffset = storedOffset;
+	request->fileSize = storedSize;
+
+	return Enqueue(std::move(request));
+
+}
+
+uint64_t AsyncLoader::Enqueue(std::unique_ptr<Request> request) {
+
+	uint64_t id = kInvalidId;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		id = nextId_++;
+
+		request->id = id;
+		request->state = RequestState::kQueued;
+		request->isCanceled = false;
+		request->status = AsyncLoadStatus::kCompleted;
+		request->requestTime = std::chrono::steady_clock::now();
+
+		queues_[static_cast<size_t>(request->priority)].push_back(request.get());
+
+		requests_.emplace(id, std::move(request));
+	}
+
+	condition_.notify_one();
+
+	return id;
+
+}
+
+bool AsyncLoader::Cancel(uint64_t id) {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto it = requests_.find(id);
+
+	if (it == requests_.end()) {
+		return false;
+	}
+
+	Request* request = it->second.get();
+
+	switch (request->state) {
+
+	case RequestState::kQueued: {
+
+		std::deque<Request*>& queue = queues_[static_cast<size_t>(request->priority)];
+
+		queue.erase(std::find(queue.begin(), queue.end(), request));
+
+		request->status = AsyncLoadStatus::kCanceled;
+
+		request->state = RequestState::kReady;
+
+		readyRequests_.push_back(request);
+
+		break;
+
+	}
+
+	case RequestState::kInFlight:
+
+		request->isCanceled = true;
+
+		break;
+
+	case RequestState::kReady:
+
+		//コールバックを待っている間なら結果を捨てる
+		request->status = AsyncLoadStatus::kCanceled;
+
+		request->data = {};
+
+		break;
+
+	case RequestState::kDispatched:
+
+		//コールバックに渡した後(呼んでいる途中を含む)は変えられない
+		return false;
+
+	}
+
+	return true;
+
+}
+
+void AsyncLoader::DispatchCompletions() {
+
+	auto start = std::chrono::steady_clock::now();
+
+	while (true) {
+
+		Request* request = nullptr;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			if (readyRequests_.empty()) {
+				return;
+			}
+
+			request = readyRequests_.front();
+
+			readyRequests_.pop_front();
+
+			//ここからはCancelで結果を変えない
+			request->state = RequestState::kDispatched;
+		}
+
+		AsyncLoadResult result{ request->id, request->status, std::move(request->data) };
+
+		float latency = ElapsedMilliseconds(request->requestTime);
+
+		if (request->callback) {
+			request->callback(result);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			switch (result.status) {
+			case AsyncLoadStatus::kCompleted:
+				statistics_.completedCount++;
+				break;
+			case AsyncLoadStatus::kFailed:
+				statistics_.failedCount++;
+				break;
+			case AsyncLoadStatus::kCanceled:
+				statistics_.canceledCount++;
+				break;
+			}
+
+			statistics_.lastLatencyMilliseconds = latency;
+
+			statistics_.maxLatencyMilliseconds = (std::max)(statistics_.maxLatencyMilliseconds, latency);
+
+			statistics_.totalLatencyMilliseconds += latency;
+
+			requests_.erase(result.id);
+		}
+
+		if (settings_.completionBudgetMilliseconds > 0.0f && ElapsedMilliseconds(start) >= settings_.completionBudgetMilliseconds) {
+			return;
+		}
+
+	}
+
+}
+
+AsyncLoadStatistics AsyncLoader::GetStatistics() const {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	AsyncLoadStatistics statistics = statistics_;
+
+	statistics.queuedCount = 0;
+
+	for (const std::deque<Request*>& queue : queues_) {
+		statistics.queuedCount += static_cast<uint32_t>(queue.size());
+	}
+
+	statistics.readyCount = static_cast<uint32_t>(readyRequests_.size());
+
+	return statistics;
+
+}
+
+void AsyncLoader::IoThreadMain(uint32_t threadIndex) {
+
+	std::vector<Request*> batch;
+
+	while (true) {
+
+		batch.clear();
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+
+			condition_.wait(lock, [this] {
+				return isExit_ || std::any_of(std::begin(queues_), std::end(queues_), [](const std::deque<Request*>& queue) { return !queue.empty(); });
+			});
+
+			if (isExit_) {
+				return;
+			}
+
+			//優先度の高い列から取り出す
+			for (std::deque<Request*>& queue : queues_) {
+				while (batch.size() < settings_.maxBatchSize && !queue.empty()) {
+					Request* request = queue.front();
+					queue.pop_front();
+					request->state = RequestState::kInFlight;
+					batch.push_back(request);
+				}
+			}
+
+			statistics_.inFlightCount += static_cast<uint32_t>(batch.size());
+		}
+
+		ProcessBatch(batch, threadIndex);
+
+	}
+
+}
+
+void AsyncLoader::ProcessBatch(std::vector<Request*>& batch, uint32_t threadIndex) {
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<ReadOperation> operations;
+
+	operations.reserve(batch.size());
+
+	//アーカイブでないファイルは読み終わったら閉じる
+	std::vector<intptr_t> looseFiles;
+
+	for (Request* request : batch) {
+
+		intptr_t file = kInvalidFile;
+
+		if (request->archive != nullptr) {
+
+			file = GetArchiveFile(request->path);
+
+		} else {
+
+			file = OpenReadFile(request->path.c_str());
+
+			if (file != kInvalidFile) {
+				looseFiles.push_back(file);
+				if (!GetReadFileSize(file, request->fileSize)) {
+					file = kInvalidFile;
+				}
+			}
+
+		}
+
+		if (file == kInvalidFile || request->isCanceled) {
+			operations.push_back({ kInvalidFile, 0, 0, nullptr, 0, file == kInvalidFile, false, request });
+			continue;
+		}
+
+		//そのまま置いたものは読んだものをそのまま返す
+		bool isDecompressed = request->archive != nullptr && request->archive->IsCompressed(request->assetIndex);
+
+		std::vector<uint8_t>& destination = isDecompressed ? request->stored : request->data;
+
+		destination.resize(static_cast<size_t>(request->fileSize));
+
+		operations.push_back({ file, request->fileOffset, request->fileSize, destination.data(), 0, false, false, request });
+
+	}
+
+	//読まないもの(開けなかったもの、取り消されたもの、大きさ0のもの)を前に集め、残りは同じファイルを位置の順に読む
+	auto isSkipped = [](const ReadOperation& operation) { return operation.file == kInvalidFile || operation.size == 0; };
+
+	std::sort(operations.begin(), operations.end(), [&](const ReadOperation& a, const ReadOperation& b) {
+		if (isSkipped(a) != isSkipped(b)) {
+			return isSkipped(a);
+		}
+		return a.file != b.file ? a.file < b.file : a.offset < b.offset;
+	});
+
+	size_t firstOperation = std::find_if_not(operations.begin(), operations.end(), isSkipped) - operations.begin();
+
+	ReadOperation* readOperations = operations.data() + firstOperation;
+
+	size_t readCount = operations.size() - firstOperation;
+
+	bool isRingRead = false;
+
+	if (threadIndex == 0 && ioRing_ != nullptr && ioRing_->isUsable && readCount > 0) {
+
+		isRingRead = ioRing_->Read(readOperations, readCount);
+
+		//列が使えなくなったら以降はスレッドで読む
+		if (!ioRing_->isUsable) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			statistics_.isIoUringEnabled = false;
+		}
+
+	}
+
+	if (!isRingRead) {
+		for (size_t i = 0; i < readCount; ++i) {
+			ReadOperation& operation = readOperations[i];
+			if (operation.isFailed || operation.doneSize == operation.size) {
+				continue;
+			}
+			//io_uringの途中で列が使えなくなった時は残りから読む
+			operation.isFailed = !ReadFileAt(operation.file, operation.offset + operation.doneSize, operation.size - operation.doneSize, operation.destination + operation.doneSize);
+			if (!operation.isFailed) {
+				operation.doneSize = operation.size;
+			}
+		}
+	}
+
+	for (intptr_t file : looseFiles) {
+		CloseReadFile(file);
+	}
+
+	uint64_t readSize = 0;
+
+	for (const ReadOperation& operation : operations) {
+		readSize += operation.doneSize;
+	}
+
+	float milliseconds = ElapsedMilliseconds(start);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		statistics_.batchCount++;
+
+		statistics_.readSize += readSize;
+
+		statistics_.readMilliseconds += milliseconds;
+	}
+
+	for (const ReadOperation& operation : operations) {
+
+		Request* request = static_cast<Request*>(operation.userData);
+
+		//カーネルがまだ書き込むかもしれないバッファは、列を閉じるまで手放さない
+		if (operation.isAbandoned) {
+			ioRing_->abandonedBuffers.push_back(std::move(request->data));
+			ioRing_->abandonedBuffers.push_back(std::move(request->stored));
+		}
+
+		if (operation.isFailed) {
+			Finish(request, AsyncLoadStatus::kFailed);
+			continue;
+		}
+
+		if (request->archive == nullptr || !request->archive->IsCompressed(request->assetIndex) || request->isCanceled) {
+			Finish(request, AsyncLoadStatus::kCompleted);
+			continue;
+		}
+
+		if (jobSystem_ != nullptr) {
+			jobSystem_->Schedule([this, request] { Decompress(request); });
+		} else {
+			Decompress(request);
+		}
+
+	}
+
+}
+
+void AsyncLoader::Decompress(Request* request) {
+
+	if (request->isCanceled) {
+		Finish(request, AsyncLoadStatus::kCanceled);
+		return;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	request->data.resize(static_cast<size_t>(request->assetSize));
+
+	bool isDecoded = request->archive->DecodeStored(request->assetIndex, request->assetOffset, request->assetSize, request->stored.data(), request->fileOffset, request->data.data());
+
+	request->stored = {};
+
+	float milliseconds = ElapsedMilliseconds(start);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		statistics_.decompressedSize += request->assetSize;
+
+		statistics_.decompressMilliseconds += milliseconds;
+	}
+
+	Finish(request, isDecoded ? AsyncLoadStatus::kCompleted : AsyncLoadStatus::kFailed);
+
+}
+
+void AsyncLoader::Finish(Request* request, AsyncLoadStatus status) {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	request->status = request->isCanceled ? AsyncLoadStatus::kCanceled : status;
+
+	if (request->status != AsyncLoadStatus::kCompleted) {
+		request->data = {};
+	}
+
+	request->stored = {};
+
+	request->state = RequestState::kReady;
+
+	readyRequests_.push_back(request);
+
+	//Finalizeが待ちを抜けるとすぐに破棄されうるので、ロックを持ったまま知らせる
+	if (--statistics_.inFlightCount == 0) {
+		idleCondition_.notify_all();
+	}
+
+}
+
+intptr_t AsyncLoader::GetArchiveFile(const std::string& path) {
+
+	std::lock_guard<std::mutex> lock(archiveFileMutex_);
+
+	auto it = archiveFiles_.find(path);
+
+	if (it != archiveFiles_.end()) {
+		return it->second;
+	}
+
+	intptr_t file = OpenReadFile(path.c_str());
+
+	//開けなかったものは覚えない(次の要求でもう一度開く)
+	if (file != kInvalidFile) {
+		archiveFiles_.emplace(path, file);
+	}
+
+	return file;
+
+}
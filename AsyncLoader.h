@@ -0,0 +1,229 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+
+class JobSystem;
+class AssetArchive;
+
+//ファイルを非同期に読み込むサービス
+//要求は優先度ごとの列に積み、読み込み用のスレッドが優先度の高い順にまとめて取り出して読む
+//Linuxではまとめた読み込みをio_uringで1度に出し、使えなければ(Windowsも)スレッドごとに順に読む
+//アーカイブの圧縮したアセットはJobSystemのワーカーで展開し、完了のコールバックはDispatchCompletionsを呼んだスレッドで呼ぶ
+
+enum class AsyncLoadPriority : uint32_t {
+	kHigh,
+	kNormal,
+	kLow,
+	kCount,
+};
+
+enum class AsyncLoadStatus : uint32_t {
+	kCompleted,
+	kFailed,
+	kCanceled,
+};
+
+struct AsyncLoadResult {
+
+	uint64_t id;
+
+	AsyncLoadStatus status;
+
+	//読んだ中身(kCompleted以外は空)
+	std::vector<uint8_t> data;
+
+};
+
+using AsyncLoadCallback = std::function<void(AsyncLoadResult& result)>;
+
+struct AsyncLoaderSettings {
+
+	//読み込み用のスレッドの数(io_uringを使う時は1つのスレッドでまとめて出す)
+	uint32_t ioThreadCount = 2;
+
+	//1回にまとめて取り出す要求の数
+	uint32_t maxBatchSize = 16;
+
+	//1回のDispatchCompletionsでコールバックに使う時間(ミリ秒、0なら全部呼ぶ)
+	//超えた分は次のフレームに回す(少なくとも1つは呼ぶ)
+	float completionBudgetMilliseconds = 1.0f;
+
+	bool useIoUring = true;
+
+};
+
+//読み込みの計測値
+struct AsyncLoadStatistics {
+
+	//列で待っている数、読み込みか展開の途中の数、コールバックを待っている数
+	uint32_t queuedCount;
+	uint32_t inFlightCount;
+	uint32_t readyCount;
+
+	uint64_t completedCount;
+	uint64_t failedCount;
+	uint64_t canceledCount;
+
+	//まとめて出した読み込みの回数
+	uint64_t batchCount;
+
+	//ファイルから読んだバイト数と、読み込みにかかった時間(まとめた読み込みごとの合計)
+	uint64_t readSize;
+	float readMilliseconds;
+
+	//展開したバイト数と展開にかかった時間(ワーカーごとの合計)
+	uint64_t decompressedSize;
+	float decompressMilliseconds;
+
+	//要求からコールバックまでの時間
+	float lastLatencyMilliseconds;
+	float maxLatencyMilliseconds;
+	float totalLatencyMilliseconds;
+
+	bool isIoUringEnabled;
+
+};
+
+class AsyncLoader {
+
+public:
+
+	static const uint64_t kInvalidId = 0;
+
+	//IoRingは.cppの中だけで定義する
+	AsyncLoader();
+
+	~AsyncLoader();
+
+	//jobSystemは展開に使う(nullptrなら読み込み用のスレッドで展開する)
+	void Initialize(const AsyncLoaderSettings& settings, JobSystem* jobSystem);
+
+	//待っている要求は捨て、読み込みと展開の途中のものは終わるのを待つ(コールバックは呼ばない)
+	void Finalize();
+
+	//ファイル全体を読む
+	uint64_t RequestFile(const char* path, AsyncLoadPriority priority, AsyncLoadCallback callback);
+
+	//アーカイブのアセットの[offset, offset + size)を読んで展開する(範囲が外れていればkInvalidId)
+	//archiveはarchivePathを開いたもので、完了のコールバックまで開いたままにしておくこと
+	uint64_t RequestAsset(const AssetArchive* archive, const char* archivePath, uint32_t index, uint64_t offset, uint64_t size, AsyncLoadPriority priority, AsyncLoadCallback callback);
+
+	//要求を取り消す(コールバックはkCanceledで呼ぶ)。列で待っていればすぐ外し、途中なら終わった時に結果を捨てる
+	//コールバックに渡した後(コールバックの中から呼んだ時を含む)はfalseで、結果は変えない
+	bool Cancel(uint64_t id);
+
+	//終わった要求のコールバックを呼ぶ(フレームの区切りで呼ぶ)
+	void DispatchCompletions();
+
+	AsyncLoadStatistics GetStatistics() const;
+
+private:
+
+	enum class RequestState : uint32_t {
+		//列で待っている
+		kQueued,
+		//読み込みか展開の途中
+		kInFlight,
+		//コールバックを待っている
+		kReady,
+		//コールバックに渡した(もう取り消せない)
+		kDispatched,
+	};
+
+	struct Request {
+
+		uint64_t id;
+
+		AsyncLoadPriority priority;
+
+		AsyncLoadCallback callback;
+
+		std::string path;
+
+		//アーカイブのアセットなら展開する範囲(archiveがnullptrならファイル全体を読む)
+		const AssetArchive* archive;
+		uint32_t assetIndex;
+		uint64_t assetOffset;
+		uint64_t assetSize;
+
+		//ファイルの中の読む範囲
+		uint64_t fileOffset;
+		uint64_t fileSize;
+
+		//ファイルから読んだものと、展開したもの
+		std::vector<uint8_t> stored;
+		std::vector<uint8_t> data;
+
+		RequestState state;
+
+		//途中で取り消された(読み込み用のスレッドとワーカーが見る)
+		std::atomic<bool> isCanceled;
+
+		AsyncLoadStatus status;
+
+		std::chrono::steady_clock::time_point requestTime;
+
+	};
+
+	uint64_t Enqueue(std::unique_ptr<Request> request);
+
+	void IoThreadMain(uint32_t threadIndex);
+
+	//batchを読んで、展開が要るものは展開に回す
+	void ProcessBatch(std::vector<Request*>& batch, uint32_t threadIndex);
+
+	//storedから展開してdataにする
+	void Decompress(Request* request);
+
+	//結果を決めてコールバックを待つ列に移す
+	void Finish(Request* request, AsyncLoadStatus status);
+
+	//アーカイブは開いたままにしておき、同じパスの要求で使い回す(読み込み用のスレッドだけが使う)
+	intptr_t GetArchiveFile(const std::string& path);
+
+	AsyncLoaderSettings settings_;
+
+	JobSystem* jobSystem_ = nullptr;
+
+	std::vector<std::thread> ioThreads_;
+
+	//io_uringはスレッド0だけが使う(使えなければnullptr)
+	struct IoRing;
+
+	std::unique_ptr<IoRing> ioRing_;
+
+	std::unordered_map<uint64_t, std::unique_ptr<Request>> requests_;
+
+	std::deque<Request*> queues_[static_cast<size_t>(AsyncLoadPriority::kCount)];
+
+	std::deque<Request*> readyRequests_;
+
+	std::unordered_map<std::string, intptr_t> archiveFiles_;
+
+	std::mutex archiveFileMutex_;
+
+	uint64_t nextId_ = 1;
+
+	mutable std::mutex mutex_;
+
+	std::condition_variable condition_;
+
+	//読み込みと展開の途中のものがなくなったことを知らせる
+	std::condition_variable idleCondition_;
+
+	bool isExit_ = false;
+
+	AsyncLoadStatistics statistics_{};
+
+};
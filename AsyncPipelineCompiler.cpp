@@ -0,0 +1,151 @@
+#include "AsyncPipelineCompiler.h"
+#include "PipelineStateCache.h"
+#include <chrono>
+#include <algorithm>
+
+void AsyncPipelineCompiler::Initialize(PipelineStateCache* pipelineStateCache, uint32_t workerCount) {
+
+	pipelineStateCache_ = pipelineStateCache;
+
+	isExit_ = false;
+
+	for (uint32_t i = 0; i < (std::max)(workerCount, 1u); ++i) {
+		workers_.emplace_back(&AsyncPipelineCompiler::WorkerMain, this);
+	}
+
+}
+
+uint64_t AsyncPipelineCompiler::Request(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) {
+
+	uint64_t hash = pipelineStateCache_->ComputeHash(desc);
+
+	if (pipelineStateCache_->FindGraphicsPipelineState(hash) != nullptr) {
+		return hash;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		//既に依頼済みか、作成に失敗したものなら何もしない
+		if (failedHashes_.contains(hash) || !pendingHashes_.insert(hash).second) {
+			return hash;
+		}
+
+		jobs_.push_back(std::make_unique<Job>(hash, desc));
+
+		statistics_.queueDepth = static_cast<uint32_t>(jobs_.size());
+
+		statistics_.maxQueueDepth = (std::max)(statistics_.maxQueueDepth, statistics_.queueDepth);
+	}
+
+	condition_.notify_one();
+
+	return hash;
+
+}
+
+ID3D12PipelineState* AsyncPipelineCompiler::GetPipelineState(uint64_t hash, ID3D12PipelineState* fallback) const {
+
+	ID3D12PipelineState* pipelineState = pipelineStateCache_->FindGraphicsPipelineState(hash);
+
+	return pipelineState != nullptr ? pipelineState : fallback;
+
+}
+
+bool AsyncPipelineCompiler::IsPending(uint64_t hash) const {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return pendingHashes_.contains(hash);
+
+}
+
+bool AsyncPipelineCompiler::IsFailed(uint64_t hash) const {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return failedHashes_.contains(hash);
+
+}
+
+PipelineCompileStatistics AsyncPipelineCompiler::GetStatistics() const {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return statistics_;
+
+}
+
+void AsyncPipelineCompiler::Finalize() {
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		isExit_ = true;
+
+		jobs_.clear();
+
+		pendingHashes_.clear();
+	}
+
+	condition_.notify_all();
+
+	for (std::thread& worker : workers_) {
+		worker.join();
+	}
+
+	workers_.clear();
+
+}
+
+void AsyncPipelineCompiler::WorkerMain() {
+
+	while (true) {
+
+		std::unique_ptr<Job> job;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+
+			condition_.wait(lock, [this] { return isExit_ || !jobs_.empty(); });
+
+			if (isExit_) {
+				return;
+			}
+
+			job = std::move(jobs_.front());
+
+			jobs_.pop_front();
+
+			statistics_.queueDepth = static_cast<uint32_t>(jobs_.size());
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		ID3D12PipelineState* pipelineState = pipelineStateCache_->CompileGraphicsPipelineState(job->hash, job->desc.Get());
+
+		float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			pendingHashes_.erase(job->hash);
+
+			//失敗したものは覚えておき、毎フレームの依頼で作り直さない
+			if (pipelineState != nullptr) {
+				statistics_.compiledCount++;
+			} else {
+				failedHashes_.insert(job->hash);
+				statistics_.failedCount++;
+			}
+
+			statistics_.lastMilliseconds = milliseconds;
+
+			statistics_.maxMilliseconds = (std::max)(statistics_.maxMilliseconds, milliseconds);
+
+			statistics_.totalMilliseconds += milliseconds;
+		}
+
+	}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_set>
+#include "PipelineStateDesc.h"
+
+class PipelineStateCache;
+
+//PSO作成の計測値
+struct PipelineCompileStatistics {
+
+	uint32_t queueDepth;
+	uint32_t maxQueueDepth;
+	uint32_t compiledCount;
+	uint32_t failedCount;
+	float lastMilliseconds;
+	float maxMilliseconds;
+	float totalMilliseconds;
+
+};
+
+//ワーカースレッドでPSOを作成する
+//作成中はフォールバックのPSOを返すので描画スレッドが止まらない
+class AsyncPipelineCompiler {
+
+public:
+
+	void Initialize(PipelineStateCache* pipelineStateCache, uint32_t workerCount);
+
+	//PSOの作成を依頼してハッシュを返す(作成済みならすぐに返る)
+	uint64_t Request(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+	//作成が終わっていればそのPSOを、まだか作成に失敗したならfallbackを返す(nullptrなら描画をスキップする)
+	ID3D12PipelineState* GetPipelineState(uint64_t hash, ID3D12PipelineState* fallback) const;
+
+	bool IsPending(uint64_t hash) const;
+
+	//作成に失敗したPSOは二度と依頼しない(fallbackのまま)
+	bool IsFailed(uint64_t hash) const;
+
+	PipelineCompileStatistics GetStatistics() const;
+
+	//待ちのジョブは破棄し、作成中のものは終わるのを待つ
+	void Finalize();
+
+private:
+
+	//Descが指すシェーダーや入力レイアウトを依頼側の寿命から切り離すためにコピーしておく
+	struct Job {
+
+		Job(uint64_t hash, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) : hash(hash), desc(desc) {}
+
+		uint64_t hash;
+
+		GraphicsPipelineStateDescCopy desc;
+
+	};
+
+	void WorkerMain();
+
+	PipelineStateCache* pipelineStateCache_ = nullptr;
+
+	std::vector<std::thread> workers_;
+
+	std::deque<std::unique_ptr<Job>> jobs_;
+
+	std::unordered_set<uint64_t> pendingHashes_;
+
+	std::unordered_set<uint64_t> failedHashes_;
+
+	mutable std::mutex mutex_;
+
+	std::condition_variable condition_;
+
+	bool isExit_ = false;
+
+	PipelineCompileStatistics statistics_{};
+
+};
@@ -0,0 +1,427 @@
+#include "BinaryMesh.h"
+#include <cstring>
+#include <cstdio>
+
+namespace {
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	uint64_t RotateLeft(uint64_t value, int shift) {
+		return (value << shift) | (value >> (64 - shift));
+	}
+
+	//ヘッダー(チェックサムの欄は0にする)と、それ以降の全体のチェックサム
+	uint64_t ComputeFileChecksum(const BinaryMeshHeader& header, const uint8_t* data, size_t size) {
+
+		BinaryMeshHeader headerCopy = header;
+
+		headerCopy.checksum = 0;
+
+		uint64_t headerChecksum = ComputeBinaryMeshChecksum(reinterpret_cast<const uint8_t*>(&headerCopy), sizeof(headerCopy));
+
+		return ComputeBinaryMeshChecksum(data + sizeof(BinaryMeshHeader), size - sizeof(BinaryMeshHeader)) ^ RotateLeft(headerChecksum, 17);
+
+	}
+
+	//種類ごとに決まっている要素の大きさ(決まっていなければ0)
+	uint32_t GetExpectedElementSize(uint32_t type) {
+		switch (static_cast<BinaryMeshSectionType>(type)) {
+		case BinaryMeshSectionType::kVertices:
+			return sizeof(MeshVertex);
+		case BinaryMeshSectionType::kIndices:
+			return sizeof(uint32_t);
+		case BinaryMeshSectionType::kLods:
+			return sizeof(MeshLod);
+		case BinaryMeshSectionType::kMeshlets:
+			return sizeof(Meshlet);
+		case BinaryMeshSectionType::kMeshletVertices:
+		case BinaryMeshSectionType::kMeshletTriangles:
+			return sizeof(uint32_t);
+		default:
+			return 0;
+		}
+	}
+
+}
+
+uint64_t ComputeBinaryMeshChecksum(const uint8_t* data, size_t size) {
+
+	const uint64_t kPrime1 = 0x9e3779b185ebca87ull;
+	const uint64_t kPrime2 = 0xc2b2ae3d27d4eb4full;
+
+	//8バイトずつ4本並べて混ぜ、最後にまとめる
+	uint64_t lanes[4] = { kPrime1, kPrime2, kPrime1 ^ kPrime2, ~kPrime1 };
+
+	size_t i = 0;
+
+	for (; i + 32 <= size; i += 32) {
+		for (int lane = 0; lane < 4; ++lane) {
+			uint64_t word;
+			std::memcpy(&word, data + i + lane * 8, sizeof(word));
+			lanes[lane] = RotateLeft(lanes[lane] + word * kPrime2, 31) * kPrime1;
+		}
+	}
+
+	uint64_t hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+
+	for (; i < size; ++i) {
+		hash = (hash ^ data[i]) * kPrime1;
+	}
+
+	hash ^= static_cast<uint64_t>(size);
+	hash ^= hash >> 33;
+	hash *= kPrime2;
+	hash ^= hash >> 29;
+
+	return hash;
+
+}
+
+void BinaryMeshWriter::AddSection(BinaryMeshSectionType type, uint32_t elementSize, const void* data, size_t count) {
+	sections_.push_back({ type, elementSize, data, count });
+}
+
+std::vector<uint8_t> BinaryMeshWriter::WriteToMemory(const AABB& bounds) const {
+
+	uint64_t tableOffset = sizeof(BinaryMeshHeader);
+
+	uint64_t offset = AlignUp(tableOffset + sizeof(BinaryMeshSection) * sections_.size(), kBinaryMeshAlignment);
+
+	std::vector<BinaryMeshSection> table(sections_.size());
+
+	for (size_t i = 0; i < sections_.size(); ++i) {
+
+		table[i].type = static_cast<uint32_t>(sections_[i].type);
+		table[i].elementSize = sections_[i].elementSize;
+		table[i].offset = offset;
+		table[i].count = sections_[i].count;
+
+		offset = AlignUp(offset + uint64_t(sections_[i].elementSize) * sections_[i].count, kBinaryMeshAlignment);
+
+	}
+
+	//隙間は0で埋める
+	std::vector<uint8_t> data(static_cast<size_t>(offset), 0);
+
+	std::memcpy(data.data() + tableOffset, table.data(), sizeof(BinaryMeshSection) * table.size());
+
+	for (size_t i = 0; i < sections_.size(); ++i) {
+		if (sections_[i].count > 0) {
+			std::memcpy(data.data() + table[i].offset, sections_[i].data, static_cast<size_t>(sections_[i].elementSize * sections_[i].count));
+		}
+	}
+
+	BinaryMeshHeader header{};
+
+	header.magic = kBinaryMeshMagic;
+	header.version = kBinaryMeshVersion;
+	header.headerSize = sizeof(BinaryMeshHeader);
+	header.sectionCount = static_cast<uint32_t>(sections_.size());
+	header.fileSize = offset;
+	header.boundsMin[0] = bounds.min.x;
+	header.boundsMin[1] = bounds.min.y;
+	header.boundsMin[2] = bounds.min.z;
+	header.boundsMax[0] = bounds.max.x;
+	header.boundsMax[1] = bounds.max.y;
+	header.boundsMax[2] = bounds.max.z;
+	header.checksum = ComputeFileChecksum(header, data.data(), data.size());
+
+	std::memcpy(data.data(), &header, sizeof(header));
+
+	return data;
+
+}
+
+bool BinaryMeshWriter::Write(const char* path, const AABB& bounds) const {
+
+	std::vector<uint8_t> data = WriteToMemory(bounds);
+
+	FILE* file = std::fopen(path, "wb");
+
+	if (file == nullptr) {
+		return false;
+	}
+
+	bool isWritten = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+
+	return std::fclose(file) == 0 && isWritten;
+
+}
+
+bool WriteBinaryMesh(const char* path, const MeshData& mesh) {
+
+	BinaryMeshWriter writer;
+
+	writer.AddSection(BinaryMeshSectionType::kVertices, sizeof(MeshVertex), mesh.vertices.data(), mesh.vertices.size());
+
+	writer.AddSection(BinaryMeshSectionType::kIndices, sizeof(uint32_t), mesh.indices.data(), mesh.indices.size());
+
+	if (!mesh.lods.empty()) {
+		writer.AddSection(BinaryMeshSectionType::kLods, sizeof(MeshLod), mesh.lods.data(), mesh.lods.size());
+	}
+
+	if (!mesh.meshlets.empty()) {
+		writer.AddSection(BinaryMeshSectionType::kMeshlets, sizeof(Meshlet), mesh.meshlets.data(), mesh.meshlets.size());
+		writer.AddSection(BinaryMeshSectionType::kMeshletVertices, sizeof(uint32_t), mesh.meshletVertices.data(), mesh.meshletVertices.size());
+		writer.AddSection(BinaryMeshSectionType::kMeshletTriangles, sizeof(uint32_t), mesh.meshletTriangles.data(), mesh.meshletTriangles.size());
+	}
+
+	return writer.Write(path, mesh.bounds);
+
+}
+
+bool BinaryMesh::Open(const char* path, uint32_t verifyFlags) {
+
+	Close();
+
+	if (!file_.Open(path)) {
+		return false;
+	}
+
+	data_ = file_.GetData();
+	size_ = file_.GetSize();
+
+	if (!Validate(verifyFlags)) {
+		Close();
+		return false;
+	}
+
+	return true;
+
+}
+
+bool BinaryMesh::OpenMemory(const uint8_t* data, size_t size, uint32_t verifyFlags) {
+
+	Close();
+
+	data_ = data;
+	size_ = size;
+
+	if (!Validate(verifyFlags)) {
+		Close();
+		return false;
+	}
+
+	return true;
+
+}
+
+void BinaryMesh::Close() {
+
+	file_.Close();
+
+	data_ = nullptr;
+	size_ = 0;
+	sections_ = nullptr;
+	sectionCount_ = 0;
+	vertices_ = nullptr;
+	vertexCount_ = 0;
+	indices_ = nullptr;
+	indexCount_ = 0;
+	lods_ = nullptr;
+	lodCount_ = 0;
+	meshlets_ = nullptr;
+	meshletCount_ = 0;
+	meshletVertices_ = nullptr;
+	meshletVertexCount_ = 0;
+	meshletTriangles_ = nullptr;
+	meshletTriangleCount_ = 0;
+	bounds_ = {};
+
+}
+
+bool BinaryMesh::Validate(uint32_t verifyFlags) {
+
+	//中身をそのまま構造体として指すので、先頭は揃っている必要がある
+	if (data_ == nullptr || size_ < sizeof(BinaryMeshHeader) || reinterpret_cast<uintptr_t>(data_) % alignof(uint64_t) != 0) {
+		return false;
+	}
+
+	BinaryMeshHeader header;
+
+	std::memcpy(&header, data_, sizeof(header));
+
+	if (header.magic != kBinaryMeshMagic || header.version != kBinaryMeshVersion || header.headerSize != sizeof(BinaryMeshHeader)) {
+		return false;
+	}
+
+	if (header.fileSize != size_ || header.sectionCount > kMaxBinaryMeshSections) {
+		return false;
+	}
+
+	uint64_t dataBegin = sizeof(BinaryMeshHeader) + uint64_t(sizeof(BinaryMeshSection)) * header.sectionCount;
+
+	if (dataBegin > size_) {
+		return false;
+	}
+
+	sections_ = reinterpret_cast<const BinaryMeshSection*>(data_ + sizeof(BinaryMeshHeader));
+	sectionCount_ = header.sectionCount;
+
+	bool hasVertices = false;
+	bool hasIndices = false;
+
+	for (uint32_t i = 0; i < sectionCount_; ++i) {
+
+		const BinaryMeshSection& section = sections_[i];
+
+		if (section.elementSize == 0 || section.offset % kBinaryMeshAlignment != 0 || section.offset < dataBegin || section.offset > size_) {
+			return false;
+		}
+
+		//掛け算が溢れないように割り算で比べる
+		if (section.count > (size_ - section.offset) / section.elementSize) {
+			return false;
+		}
+
+		uint32_t expectedElementSize = GetExpectedElementSize(section.type);
+
+		if (expectedElementSize != 0 && section.elementSize != expectedElementSize) {
+			return false;
+		}
+
+		//知らない種類は読み飛ばす(後から足したセクションがあっても開ける)
+		if (section.type == static_cast<uint32_t>(BinaryMeshSectionType::kVertices)) {
+
+			if (hasVertices) {
+				return false;
+			}
+
+			hasVertices = true;
+			vertices_ = reinterpret_cast<const MeshVertex*>(data_ + section.offset);
+			vertexCount_ = static_cast<size_t>(section.count);
+
+		} else if (section.type == static_cast<uint32_t>(BinaryMeshSectionType::kIndices)) {
+
+			if (hasIndices || section.count % 3 != 0) {
+				return false;
+			}
+
+			hasIndices = true;
+			indices_ = reinterpret_cast<const uint32_t*>(data_ + section.offset);
+			indexCount_ = static_cast<size_t>(section.count);
+
+		} else if (section.type == static_cast<uint32_t>(BinaryMeshSectionType::kLods)) {
+
+			if (lods_ != nullptr) {
+				return false;
+			}
+
+			lods_ = reinterpret_cast<const MeshLod*>(data_ + section.offset);
+			lodCount_ = static_cast<size_t>(section.count);
+
+		} else if (section.type == static_cast<uint32_t>(BinaryMeshSectionType::kMeshlets)) {
+
+			if (meshlets_ != nullptr) {
+				return false;
+			}
+
+			meshlets_ = reinterpret_cast<const Meshlet*>(data_ + section.offset);
+			meshletCount_ = static_cast<size_t>(section.count);
+
+		} else if (section.type == static_cast<uint32_t>(BinaryMeshSectionType::kMeshletVertices)) {
+
+			if (meshletVertices_ != nullptr) {
+				return false;
+			}
+
+			meshletVertices_ = reinterpret_cast<const uint32_t*>(data_ + section.offset);
+			meshletVertexCount_ = static_cast<size_t>(section.count);
+
+		} else if (section.type == static_cast<uint32_t>(BinaryMeshSectionType::kMeshletTriangles)) {
+
+			if (meshletTriangles_ != nullptr) {
+				return false;
+			}
+
+			meshletTriangles_ = reinterpret_cast<const uint32_t*>(data_ + section.offset);
+			meshletTriangleCount_ = static_cast<size_t>(section.count);
+
+		}
+
+	}
+
+	if (!hasVertices || !hasIndices || vertexCount_ > 0xffffffffull) {
+		return false;
+	}
+
+	//LODの範囲はインデックスの中に収まっていること(表は小さいので常に確かめる)
+	for (size_t i = 0; i < lodCount_; ++i) {
+		const MeshLod& lod = lods_[i];
+		if (lod.indexCount % 3 != 0 || lod.indexOffset % 3 != 0 || uint64_t(lod.indexOffset) + lod.indexCount > indexCount_) {
+			return false;
+		}
+	}
+
+	//メッシュレットは3つそろっていて、範囲がそれぞれの配列とLOD0の中に収まっていること
+	if (meshlets_ != nullptr || meshletVertices_ != nullptr || meshletTriangles_ != nullptr) {
+
+		if (meshlets_ == nullptr || meshletVertices_ == nullptr || meshletTriangles_ == nullptr) {
+			return false;
+		}
+
+		size_t lod0TriangleCount = (lodCount_ != 0 ? lods_[0].indexCount : indexCount_) / 3;
+
+		for (size_t i = 0; i < meshletCount_; ++i) {
+			const Meshlet& meshlet = meshlets_[i];
+			if (uint64_t(meshlet.vertexOffset) + meshlet.vertexCount > meshletVertexCount_ || uint64_t(meshlet.triangleOffset) + meshlet.triangleCount > meshletTriangleCount_ ||
+				uint64_t(meshlet.triangleOffset) + meshlet.triangleCount > lod0TriangleCount) {
+				return false;
+			}
+		}
+
+	}
+
+	if ((verifyFlags & kBinaryMeshVerifyChecksum) && ComputeFileChecksum(header, data_, size_) != header.checksum) {
+		return false;
+	}
+
+	if (verifyFlags & kBinaryMeshVerifyIndices) {
+		for (size_t i = 0; i < indexCount_; ++i) {
+			if (indices_[i] >= vertexCount_) {
+				return false;
+			}
+		}
+
+		for (size_t i = 0; i < meshletVertexCount_; ++i) {
+			if (meshletVertices_[i] >= vertexCount_) {
+				return false;
+			}
+		}
+
+		//三角形の頂点の番号がメッシュレットの頂点の数を超えていないか
+		for (size_t i = 0; i < meshletCount_; ++i) {
+			const Meshlet& meshlet = meshlets_[i];
+			for (uint32_t j = 0; j < meshlet.triangleCount; ++j) {
+				uint32_t triangle = meshletTriangles_[meshlet.triangleOffset + j];
+				if ((triangle & 0xff) >= meshlet.vertexCount || ((triangle >> 8) & 0xff) >= meshlet.vertexCount || ((triangle >> 16) & 0xff) >= meshlet.vertexCount) {
+					return false;
+				}
+			}
+		}
+	}
+
+	bounds_ = { { header.boundsMin[0], header.boundsMin[1], header.boundsMin[2] }, { header.boundsMax[0], header.boundsMax[1], header.boundsMax[2] } };
+
+	return true;
+
+}
+
+const void* BinaryMesh::GetSection(BinaryMeshSectionType type, size_t& count, uint32_t& elementSize) const {
+
+	for (uint32_t i = 0; i < sectionCount_; ++i) {
+		if (sections_[i].type == static_cast<uint32_t>(type)) {
+			count = static_cast<size_t>(sections_[i].count);
+			elementSize = sections_[i].elementSize;
+			return data_ + sections_[i].offset;
+		}
+	}
+
+	count = 0;
+	elementSize = 0;
+
+	return nullptr;
+
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "MeshImporter.h"
+#include "MappedFile.h"
+
+//焼き込み済みのメッシュのファイル(.mesh)
+//ヘッダー、セクションの表、各セクションの中身の順に並び、中身はkBinaryMeshAlignmentに揃えて置く
+//読み込みはファイルをマップして、セクションの先頭のポインタをそのまま渡すだけにする
+
+const uint32_t kBinaryMeshMagic = 0x4853454d; //"MESH"
+
+//形式を変えたら上げる(違うものは読まずに焼き直す)
+const uint32_t kBinaryMeshVersion = 3;
+
+const uint32_t kBinaryMeshAlignment = 256;
+
+const uint32_t kMaxBinaryMeshSections = 64;
+
+enum class BinaryMeshSectionType : uint32_t {
+	kVertices = 1,
+	kIndices = 2,
+	kMeshlets = 3,
+	kMeshletVertices = 4,
+	kMeshletTriangles = 5,
+	kLods = 6,
+};
+
+struct BinaryMeshHeader {
+
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t sectionCount;
+
+	uint64_t fileSize;
+
+	//ファイル全体のチェックサム(この欄は0として計算する。Openで確かめるかどうか選べる)
+	uint64_t checksum;
+
+	float boundsMin[3];
+	float boundsMax[3];
+
+	uint32_t reserved[2];
+
+};
+
+static_assert(sizeof(BinaryMeshHeader) == 64, "BinaryMeshHeader layout changed");
+
+struct BinaryMeshSection {
+
+	uint32_t type;
+	uint32_t elementSize;
+
+	uint64_t offset;
+	uint64_t count;
+
+};
+
+static_assert(sizeof(BinaryMeshSection) == 24, "BinaryMeshSection layout changed");
+
+//セクションを積んで1つのファイルに書き出す
+class BinaryMeshWriter {
+
+public:
+
+	//dataは書き出すまで残しておくこと
+	void AddSection(BinaryMeshSectionType type, uint32_t elementSize, const void* data, size_t count);
+
+	bool Write(const char* path, const AABB& bounds) const;
+
+	//メモリ上に書き出す(検証や別の入れ物に入れる時に使う)
+	std::vector<uint8_t> WriteToMemory(const AABB& bounds) const;
+
+private:
+
+	struct PendingSection {
+		BinaryMeshSectionType type;
+		uint32_t elementSize;
+		const void* data;
+		size_t count;
+	};
+
+	std::vector<PendingSection> sections_;
+
+};
+
+//頂点とインデックス(LODやメッシュレットがあればそれも)を書き出す
+bool WriteBinaryMesh(const char* path, const MeshData& mesh);
+
+//中身を確かめる時の選択
+enum BinaryMeshVerifyFlags : uint32_t {
+	kBinaryMeshVerifyNone = 0,
+	//チェックサムを確かめる(ファイル全体を読む)
+	kBinaryMeshVerifyChecksum = 1 << 0,
+	//インデックスが頂点の数を超えていないか確かめる
+	kBinaryMeshVerifyIndices = 1 << 1,
+};
+
+class BinaryMesh {
+
+public:
+
+	//ファイルをマップしてヘッダーとセクションの表を確かめる。中身は読まない(verifyFlagsで指定したものだけ読む)
+	bool Open(const char* path, uint32_t verifyFlags = kBinaryMeshVerifyNone);
+
+	//メモリ上のデータを使う(dataは使い終わるまで残しておくこと)
+	bool OpenMemory(const uint8_t* data, size_t size, uint32_t verifyFlags = kBinaryMeshVerifyNone);
+
+	void Close();
+
+	//セクションの先頭(なければnullptr)
+	const void* GetSection(BinaryMeshSectionType type, size_t& count, uint32_t& elementSize) const;
+
+	const MeshVertex* GetVertices() const { return vertices_; }
+
+	size_t GetVertexCount() const { return vertexCount_; }
+
+	const uint32_t* GetIndices() const { return indices_; }
+
+	size_t GetIndexCount() const { return indexCount_; }
+
+	const AABB& GetBounds() const { return bounds_; }
+
+	//LODの表(なければnullptr)
+	const MeshLod* GetLods() const { return lods_; }
+
+	size_t GetLodCount() const { return lodCount_; }
+
+	//メッシュレット(なければnullptr)
+	const Meshlet* GetMeshlets() const { return meshlets_; }
+
+	size_t GetMeshletCount() const { return meshletCount_; }
+
+	MeshView GetView() const {
+		return { vertices_, vertexCount_, indices_, indexCount_, bounds_, lods_, lodCount_,
+			meshlets_, meshletCount_, meshletVertices_, meshletVertexCount_, meshletTriangles_, meshletTriangleCount_ };
+	}
+
+private:
+
+	bool Validate(uint32_t verifyFlags);
+
+	MappedFile file_;
+
+	const uint8_t* data_ = nullptr;
+
+	size_t size_ = 0;
+
+	const BinaryMeshSection* sections_ = nullptr;
+
+	uint32_t sectionCount_ = 0;
+
+	const MeshVertex* vertices_ = nullptr;
+
+	size_t vertexCount_ = 0;
+
+	const uint32_t* indices_ = nullptr;
+
+	size_t indexCount_ = 0;
+
+	const MeshLod* lods_ = nullptr;
+
+	size_t lodCount_ = 0;
+
+	const Meshlet* meshlets_ = nullptr;
+
+	size_t meshletCount_ = 0;
+
+	const uint32_t* meshletVertices_ = nullptr;
+
+	size_t meshletVertexCount_ = 0;
+
+	const uint32_t* meshletTriangles_ = nullptr;
+
+	size_t meshletTriangleCount_ = 0;
+
+	AABB bounds_ = {};
+
+};
+
+//バイト列のチェックサム
+uint64_t ComputeBinaryMeshChecksum(const uint8_t* data, size_t size);
@@ -0,0 +1,945 @@
+#include "BlockCompression.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+	//1つの塊で処理する最小のブロックの行数
+	const size_t kMinBlockRowChunkSize = 4;
+
+	//最小二乗で端点を直す回数
+	const int kRefineIterationCount = 2;
+
+	//BC7の4bitの補間の重み(64分率)
+	const int kBC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	//BC1の番号ごとの2つ目の端点の割合
+	const float kBC1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	struct BitWriter {
+
+		uint8_t* data;
+
+		uint32_t position = 0;
+
+		void Write(uint32_t value, uint32_t bitCount) {
+			for (uint32_t i = 0; i < bitCount; ++i, ++position) {
+				if ((value >> i) & 1) {
+					data[position >> 3] |= static_cast<uint8_t>(1 << (position & 7));
+				}
+			}
+		}
+
+	};
+
+	struct BitReader {
+
+		const uint8_t* data;
+
+		uint32_t position = 0;
+
+		uint32_t Read(uint32_t bitCount) {
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < bitCount; ++i, ++position) {
+				value |= static_cast<uint32_t>((data[position >> 3] >> (position & 7)) & 1) << i;
+			}
+			return value;
+		}
+
+	};
+
+	//点の集まりの平均と、主成分の向き(べき乗法で求める。ばらつきがなければ0)
+	void ComputePrincipalAxis(const float (*points)[4], uint32_t channelCount, float* mean, float* axis) {
+
+		for (uint32_t c = 0; c < 4; ++c) {
+			mean[c] = 0.0f;
+			axis[c] = 0.0f;
+		}
+
+		for (int i = 0; i < 16; ++i) {
+			for (uint32_t c = 0; c < channelCount; ++c) {
+				mean[c] += points[i][c] * (1.0f / 16.0f);
+			}
+		}
+
+		float covariance[4][4] = {};
+
+		for (int i = 0; i < 16; ++i) {
+			for (uint32_t a = 0; a < channelCount; ++a) {
+				for (uint32_t b = a; b < channelCount; ++b) {
+					covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+				}
+			}
+		}
+
+		for (uint32_t a = 0; a < channelCount; ++a) {
+			for (uint32_t b = 0; b < a; ++b) {
+				covariance[a][b] = covariance[b][a];
+			}
+		}
+
+		//最初の向きは対角成分の大きさにする(全部同じ向きにするより収束が速い)
+		float vector[4] = {};
+
+		for (uint32_t c = 0; c < channelCount; ++c) {
+			vector[c] = covariance[c][c] + 1.0f;
+		}
+
+		for (int iteration = 0; iteration < 8; ++iteration) {
+
+			float next[4] = {};
+
+			float maxComponent = 0.0f;
+
+			for (uint32_t a = 0; a < channelCount; ++a) {
+				for (uint32_t b = 0; b < channelCount; ++b) {
+					next[a] += covariance[a][b] * vector[b];
+				}
+				maxComponent = (std::max)(maxComponent, std::fabs(next[a]));
+			}
+
+			if (maxComponent == 0.0f) {
+				return;
+			}
+
+			for (uint32_t c = 0; c < channelCount; ++c) {
+				vector[c] = next[c] / maxComponent;
+			}
+
+		}
+
+		float lengthSquared = 0.0f;
+
+		for (uint32_t c = 0; c < channelCount; ++c) {
+			lengthSquared += vector[c] * vector[c];
+		}
+
+		float inverseLength = 1.0f / std::sqrt(lengthSquared);
+
+		for (uint32_t c = 0; c < channelCount; ++c) {
+			axis[c] = vector[c] * inverseLength;
+		}
+
+	}
+
+	//主成分の向きに並べた時の両端を、範囲の1/16だけ内側に寄せた端点
+	void ComputeAxisEndpoints(const float (*points)[4], uint32_t channelCount, float* endpoint0, float* endpoint1) {
+
+		float mean[4];
+		float axis[4];
+
+		ComputePrincipalAxis(points, channelCount, mean, axis);
+
+		float minProjection = (std::numeric_limits<float>::max)();
+		float maxProjection = -(std::numeric_limits<float>::max)();
+
+		for (int i = 0; i < 16; ++i) {
+
+			float projection = 0.0f;
+
+			for (uint32_t c = 0; c < channelCount; ++c) {
+				projection += (points[i][c] - mean[c]) * axis[c];
+			}
+
+			minProjection = (std::min)(minProjection, projection);
+			maxProjection = (std::max)(maxProjection, projection);
+
+		}
+
+		float inset = (maxProjection - minProjection) / 16.0f;
+
+		for (uint32_t c = 0; c < channelCount; ++c) {
+			endpoint0[c] = mean[c] + axis[c] * (maxProjection - inset);
+			endpoint1[c] = mean[c] + axis[c] * (minProjection + inset);
+		}
+
+	}
+
+	//番号ごとの割合(2つ目の端点の重み)を固定して、誤差が最小になる端点を解く(解けなければfalse)
+	bool SolveLeastSquaresEndpoints(const float (*points)[4], uint32_t channelCount, const float* weights, float* endpoint0, float* endpoint1) {
+
+		float a00 = 0.0f;
+		float a01 = 0.0f;
+		float a11 = 0.0f;
+
+		float b0[4] = {};
+		float b1[4] = {};
+
+		for (int i = 0; i < 16; ++i) {
+
+			float t = weights[i];
+			float s = 1.0f - t;
+
+			a00 += s * s;
+			a01 += s * t;
+			a11 += t * t;
+
+			for (uint32_t c = 0; c < channelCount; ++c) {
+				b0[c] += s * points[i][c];
+				b1[c] += t * points[i][c];
+			}
+
+		}
+
+		float determinant = a00 * a11 - a01 * a01;
+
+		if (std::fabs(determinant) < 1e-6f) {
+			return false;
+		}
+
+		float inverseDeterminant = 1.0f / determinant;
+
+		for (uint32_t c = 0; c < channelCount; ++c) {
+			endpoint0[c] = (std::clamp)((a11 * b0[c] - a01 * b1[c]) * inverseDeterminant, 0.0f, 255.0f);
+			endpoint1[c] = (std::clamp)((a00 * b1[c] - a01 * b0[c]) * inverseDeterminant, 0.0f, 255.0f);
+		}
+
+		return true;
+
+	}
+
+	void LoadBlockPoints(const uint8_t* blockPixels, float (*points)[4]) {
+		for (int i = 0; i < 16; ++i) {
+			for (int c = 0; c < 4; ++c) {
+				points[i][c] = static_cast<float>(blockPixels[i * 4 + c]);
+			}
+		}
+	}
+
+	//BC1
+
+	uint16_t PackRgb565(const float* color) {
+
+		uint32_t r = static_cast<uint32_t>((std::clamp)(color[0] * (31.0f / 255.0f) + 0.5f, 0.0f, 31.0f));
+		uint32_t g = static_cast<uint32_t>((std::clamp)(color[1] * (63.0f / 255.0f) + 0.5f, 0.0f, 63.0f));
+		uint32_t b = static_cast<uint32_t>((std::clamp)(color[2] * (31.0f / 255.0f) + 0.5f, 0.0f, 31.0f));
+
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+
+	}
+
+	void UnpackRgb565(uint16_t packed, int* color) {
+
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+
+	}
+
+	//4色のパレット(0:端点0、1:端点1、2と3:間の色)
+	void MakeBC1Palette(uint16_t color0, uint16_t color1, bool isFourColor, int (*palette)[4]) {
+
+		UnpackRgb565(color0, palette[0]);
+		UnpackRgb565(color1, palette[1]);
+
+		for (int c = 0; c < 3; ++c) {
+			if (isFourColor) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			} else {
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+
+		for (int i = 0; i < 4; ++i) {
+			palette[i][3] = (isFourColor || i != 3) ? 255 : 0;
+		}
+
+	}
+
+	//各画素に一番近い色を選び、誤差の合計を返す
+	uint32_t SelectBC1Indices(const uint8_t* blockPixels, uint16_t color0, uint16_t color1, uint8_t* indices) {
+
+		int palette[4][4];
+
+		MakeBC1Palette(color0, color1, true, palette);
+
+		uint32_t totalError = 0;
+
+		for (int i = 0; i < 16; ++i) {
+
+			const uint8_t* pixel = blockPixels + i * 4;
+
+			uint32_t bestError = (std::numeric_limits<uint32_t>::max)();
+
+			for (uint8_t k = 0; k < 4; ++k) {
+
+				uint32_t error = 0;
+
+				for (int c = 0; c < 3; ++c) {
+					int difference = pixel[c] - palette[k][c];
+					error += static_cast<uint32_t>(difference * difference);
+				}
+
+				if (error < bestError) {
+					bestError = error;
+					indices[i] = k;
+				}
+
+			}
+
+			totalError += bestError;
+
+		}
+
+		return totalError;
+
+	}
+
+	//BC4
+
+	void MakeBC4Palette(uint8_t value0, uint8_t value1, int* palette) {
+
+		palette[0] = value0;
+		palette[1] = value1;
+
+		if (value0 > value1) {
+			for (int k = 2; k < 8; ++k) {
+				palette[k] = ((8 - k) * value0 + (k - 1) * value1) / 7;
+			}
+		} else {
+			for (int k = 2; k < 6; ++k) {
+				palette[k] = ((6 - k) * value0 + (k - 1) * value1) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+	}
+
+	void DecodeBC1Block(const uint8_t* block, bool allowsThreeColor, uint8_t* blockPixels) {
+
+		uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+		uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+
+		uint32_t indices = static_cast<uint32_t>(block[4]) | (static_cast<uint32_t>(block[5]) << 8) | (static_cast<uint32_t>(block[6]) << 16) | (static_cast<uint32_t>(block[7]) << 24);
+
+		int palette[4][4];
+
+		MakeBC1Palette(color0, color1, !allowsThreeColor || color0 > color1, palette);
+
+		for (int i = 0; i < 16; ++i) {
+			const int* color = palette[(indices >> (i * 2)) & 3];
+			for (int c = 0; c < 4; ++c) {
+				blockPixels[i * 4 + c] = static_cast<uint8_t>(color[c]);
+			}
+		}
+
+	}
+
+	void DecodeBC4Block(const uint8_t* block, uint32_t channel, uint8_t* blockPixels) {
+
+		int palette[8];
+
+		MakeBC4Palette(block[0], block[1], palette);
+
+		uint64_t indices = 0;
+
+		for (int i = 0; i < 6; ++i) {
+			indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+		}
+
+		for (int i = 0; i < 16; ++i) {
+			blockPixels[i * 4 + channel] = static_cast<uint8_t>(palette[(indices >> (i * 3)) & 7]);
+		}
+
+	}
+
+	//BC7 mode 6
+
+	struct BC7Endpoints {
+
+		//7bitの値とpビット
+		uint32_t values[2][4];
+		uint32_t pBits[2];
+
+	};
+
+	uint32_t ExpandBC7Endpoint(uint32_t value, uint32_t pBit) {
+		return (value << 1) | pBit;
+	}
+
+	void QuantizeBC7Endpoints(const float* endpoint0, const float* endpoint1, uint32_t pBit0, uint32_t pBit1, BC7Endpoints& endpoints) {
+
+		endpoints.pBits[0] = pBit0;
+		endpoints.pBits[1] = pBit1;
+
+		for (int c = 0; c < 4; ++c) {
+			endpoints.values[0][c] = static_cast<uint32_t>((std::clamp)((endpoint0[c] - pBit0) * 0.5f + 0.5f, 0.0f, 127.0f));
+			endpoints.values[1][c] = static_cast<uint32_t>((std::clamp)((endpoint1[c] - pBit1) * 0.5f + 0.5f, 0.0f, 127.0f));
+		}
+
+	}
+
+	void MakeBC7Palette(const BC7Endpoints& endpoints, int (*palette)[4]) {
+
+		for (int c = 0; c < 4; ++c) {
+
+			int value0 = static_cast<int>(ExpandBC7Endpoint(endpoints.values[0][c], endpoints.pBits[0]));
+			int value1 = static_cast<int>(ExpandBC7Endpoint(endpoints.values[1][c], endpoints.pBits[1]));
+
+			for (int k = 0; k < 16; ++k) {
+				palette[k][c] = ((64 - kBC7Weights[k]) * value0 + kBC7Weights[k] * value1 + 32) >> 6;
+			}
+
+		}
+
+	}
+
+	//重み(0～64)から一番近い番号を引く表
+	struct BC7WeightTable {
+
+		uint8_t nearestIndex[65];
+
+		BC7WeightTable() {
+			for (int w = 0; w <= 64; ++w) {
+				int best = 0;
+				for (int k = 1; k < 16; ++k) {
+					if (std::abs(kBC7Weights[k] - w) < std::abs(kBC7Weights[best] - w)) {
+						best = k;
+					}
+				}
+				nearestIndex[w] = static_cast<uint8_t>(best);
+			}
+		}
+
+	};
+
+	//端点を結ぶ線に射影して番号の見当を付け、前後の番号も試して一番近いものを選ぶ
+	uint32_t SelectBC7Indices(const uint8_t* blockPixels, const BC7Endpoints& endpoints, uint8_t* indices) {
+
+		static const BC7WeightTable table;
+
+		int palette[16][4];
+
+		MakeBC7Palette(endpoints, palette);
+
+		int direction[4];
+
+		int lengthSquared = 0;
+
+		for (int c = 0; c < 4; ++c) {
+			direction[c] = palette[15][c] - palette[0][c];
+			lengthSquared += direction[c] * direction[c];
+		}
+
+		uint32_t totalError = 0;
+
+		for (int i = 0; i < 16; ++i) {
+
+			const uint8_t* pixel = blockPixels + i * 4;
+
+			int guess = 0;
+
+			if (lengthSquared > 0) {
+
+				int projection = 0;
+
+				for (int c = 0; c < 4; ++c) {
+					projection += (pixel[c] - palette[0][c]) * direction[c];
+				}
+
+				int weight = (std::clamp)((projection * 64 + lengthSquared / 2) / lengthSquared, 0, 64);
+
+				guess = table.nearestIndex[weight];
+
+			}
+
+			uint32_t bestError = (std::numeric_limits<uint32_t>::max)();
+
+			for (int k = (std::max)(guess - 1, 0); k <= (std::min)(guess + 1, 15); ++k) {
+
+				uint32_t error = 0;
+
+				for (int c = 0; c < 4; ++c) {
+					int difference = pixel[c] - palette[k][c];
+					error += static_cast<uint32_t>(difference * difference);
+				}
+
+				if (error < bestError) {
+					bestError = error;
+					indices[i] = static_cast<uint8_t>(k);
+				}
+
+			}
+
+			totalError += bestError;
+
+		}
+
+		return totalError;
+
+	}
+
+	//4通りのpビットを試して一番誤差の小さい量子化を選ぶ
+	uint32_t FindBestBC7Quantization(const uint8_t* blockPixels, const float* endpoint0, const float* endpoint1, BC7Endpoints& bestEndpoints, uint8_t* bestIndices) {
+
+		uint32_t bestError = (std::numeric_limits<uint32_t>::max)();
+
+		for (uint32_t pBits = 0; pBits < 4; ++pBits) {
+
+			BC7Endpoints endpoints;
+
+			uint8_t indices[16];
+
+			QuantizeBC7Endpoints(endpoint0, endpoint1, pBits & 1, pBits >> 1, endpoints);
+
+			uint32_t error = SelectBC7Indices(blockPixels, endpoints, indices);
+
+			if (error < bestError) {
+				bestError = error;
+				bestEndpoints = endpoints;
+				std::memcpy(bestIndices, indices, 16);
+			}
+
+		}
+
+		return bestError;
+
+	}
+
+	//ブロックの画素を切り出す(端をはみ出した分は端の画素を繰り返す)
+	void LoadBlockPixels(const TextureData& texture, const TextureMip& level, uint32_t blockX, uint32_t blockY, uint8_t* blockPixels) {
+
+		const uint8_t* pixels = texture.pixels.data() + level.offset;
+
+		for (uint32_t y = 0; y < 4; ++y) {
+
+			uint32_t sourceY = (std::min)(blockY * 4 + y, level.height - 1);
+
+			for (uint32_t x = 0; x < 4; ++x) {
+
+				uint32_t sourceX = (std::min)(blockX * 4 + x, level.width - 1);
+
+				std::memcpy(blockPixels + (y * 4 + x) * 4, pixels + size_t(sourceY) * level.rowPitch + size_t(sourceX) * 4, 4);
+
+			}
+
+		}
+
+	}
+
+	void EncodeBlock(TextureFormat format, const uint8_t* blockPixels, uint8_t* block) {
+		switch (format) {
+		case TextureFormat::kBC1:
+		case TextureFormat::kBC1Srgb:
+			EncodeBC1Block(blockPixels, block);
+			break;
+		case TextureFormat::kBC3:
+		case TextureFormat::kBC3Srgb:
+			EncodeBC3Block(blockPixels, block);
+			break;
+		case TextureFormat::kBC5:
+			EncodeBC5Block(blockPixels, block);
+			break;
+		case TextureFormat::kBC7:
+		case TextureFormat::kBC7Srgb:
+			EncodeBC7Block(blockPixels, block);
+			break;
+		default:
+			break;
+		}
+	}
+
+}
+
+void EncodeBC1Block(const uint8_t* blockPixels, uint8_t* block) {
+
+	float points[16][4];
+
+	LoadBlockPoints(blockPixels, points);
+
+	float endpoint0[4];
+	float endpoint1[4];
+
+	ComputeAxisEndpoints(points, 3, endpoint0, endpoint1);
+
+	uint16_t bestColor0 = PackRgb565(endpoint0);
+	uint16_t bestColor1 = PackRgb565(endpoint1);
+
+	uint8_t bestIndices[16];
+
+	uint32_t bestError = SelectBC1Indices(blockPixels, bestColor0, bestColor1, bestIndices);
+
+	for (int iteration = 0; iteration < kRefineIterationCount && bestError > 0; ++iteration) {
+
+		float weights[16];
+
+		for (int i = 0; i < 16; ++i) {
+			weights[i] = kBC1Weights[bestIndices[i]];
+		}
+
+		if (!SolveLeastSquaresEndpoints(points, 3, weights, endpoint0, endpoint1)) {
+			break;
+		}
+
+		uint16_t color0 = PackRgb565(endpoint0);
+		uint16_t color1 = PackRgb565(endpoint1);
+
+		uint8_t indices[16];
+
+		uint32_t error = SelectBC1Indices(blockPixels, color0, color1, indices);
+
+		if (error >= bestError) {
+			break;
+		}
+
+		bestError = error;
+		bestColor0 = color0;
+		bestColor1 = color1;
+		std::memcpy(bestIndices, indices, 16);
+
+	}
+
+	//4色のモードにするため端点0を大きい方にする(入れ替えたら番号も0と1、2と3を入れ替える)
+	if (bestColor0 < bestColor1) {
+		std::swap(bestColor0, bestColor1);
+		for (int i = 0; i < 16; ++i) {
+			bestIndices[i] ^= 1;
+		}
+	} else if (bestColor0 == bestColor1) {
+		std::memset(bestIndices, 0, 16);
+	}
+
+	uint32_t packedIndices = 0;
+
+	for (int i = 0; i < 16; ++i) {
+		packedIndices |= static_cast<uint32_t>(bestIndices[i]) << (i * 2);
+	}
+
+	block[0] = static_cast<uint8_t>(bestColor0);
+	block[1] = static_cast<uint8_t>(bestColor0 >> 8);
+	block[2] = static_cast<uint8_t>(bestColor1);
+	block[3] = static_cast<uint8_t>(bestColor1 >> 8);
+
+	for (int i = 0; i < 4; ++i) {
+		block[4 + i] = static_cast<uint8_t>(packedIndices >> (i * 8));
+	}
+
+}
+
+void EncodeBC4Block(const uint8_t* blockPixels, uint32_t channel, uint8_t* block) {
+
+	uint8_t minValue = 255;
+	uint8_t maxValue = 0;
+
+	for (int i = 0; i < 16; ++i) {
+		minValue = (std::min)(minValue, blockPixels[i * 4 + channel]);
+		maxValue = (std::max)(maxValue, blockPixels[i * 4 + channel]);
+	}
+
+	//8段階のモード(端点0が大きい方)。全部同じ値なら番号は全部0
+	int palette[8];
+
+	MakeBC4Palette(maxValue, minValue, palette);
+
+	uint64_t packedIndices = 0;
+
+	if (maxValue != minValue) {
+
+		for (int i = 0; i < 16; ++i) {
+
+			int value = blockPixels[i * 4 + channel];
+
+			uint64_t bestIndex = 0;
+
+			int bestError = 256;
+
+			for (int k = 0; k < 8; ++k) {
+				int error = std::abs(value - palette[k]);
+				if (error < bestError) {
+					bestError = error;
+					bestIndex = static_cast<uint64_t>(k);
+				}
+			}
+
+			packedIndices |= bestIndex << (i * 3);
+
+		}
+
+	}
+
+	block[0] = maxValue;
+	block[1] = minValue;
+
+	for (int i = 0; i < 6; ++i) {
+		block[2 + i] = static_cast<uint8_t>(packedIndices >> (i * 8));
+	}
+
+}
+
+void EncodeBC3Block(const uint8_t* blockPixels, uint8_t* block) {
+	EncodeBC4Block(blockPixels, 3, block);
+	EncodeBC1Block(blockPixels, block + 8);
+}
+
+void EncodeBC5Block(const uint8_t* blockPixels, uint8_t* block) {
+	EncodeBC4Block(blockPixels, 0, block);
+	EncodeBC4Block(blockPixels, 1, block + 8);
+}
+
+void EncodeBC7Block(const uint8_t* blockPixels, uint8_t* block) {
+
+	float points[16][4];
+
+	LoadBlockPoints(blockPixels, points);
+
+	float endpoint0[4];
+	float endpoint1[4];
+
+	ComputeAxisEndpoints(points, 4, endpoint0, endpoint1);
+
+	BC7Endpoints bestEndpoints;
+
+	uint8_t bestIndices[16];
+
+	uint32_t bestError = FindBestBC7Quantization(blockPixels, endpoint0, endpoint1, bestEndpoints, bestIndices);
+
+	for (int iteration = 0; iteration < kRefineIterationCount && bestError > 0; ++iteration) {
+
+		float weights[16];
+
+		for (int i = 0; i < 16; ++i) {
+			weights[i] = static_cast<float>(kBC7Weights[bestIndices[i]]) / 64.0f;
+		}
+
+		if (!SolveLeastSquaresEndpoints(points, 4, weights, endpoint0, endpoint1)) {
+			break;
+		}
+
+		BC7Endpoints endpoints;
+
+		uint8_t indices[16];
+
+		uint32_t error = FindBestBC7Quantization(blockPixels, endpoint0, endpoint1, endpoints, indices);
+
+		if (error >= bestError) {
+			break;
+		}
+
+		bestError = error;
+		bestEndpoints = endpoints;
+		std::memcpy(bestIndices, indices, 16);
+
+	}
+
+	//最初の画素の番号は最上位bitを省くので、8以上なら端点を入れ替えて番号を反転する(重みが対称なので結果は同じ)
+	if (bestIndices[0] >= 8) {
+
+		for (int c = 0; c < 4; ++c) {
+			std::swap(bestEndpoints.values[0][c], bestEndpoints.values[1][c]);
+		}
+
+		std::swap(bestEndpoints.pBits[0], bestEndpoints.pBits[1]);
+
+		for (int i = 0; i < 16; ++i) {
+			bestIndices[i] = static_cast<uint8_t>(15 - bestIndices[i]);
+		}
+
+	}
+
+	std::memset(block, 0, 16);
+
+	BitWriter writer{ block };
+
+	writer.Write(1 << 6, 7);
+
+	for (int c = 0; c < 4; ++c) {
+		writer.Write(bestEndpoints.values[0][c], 7);
+		writer.Write(bestEndpoints.values[1][c], 7);
+	}
+
+	writer.Write(bestEndpoints.pBits[0], 1);
+	writer.Write(bestEndpoints.pBits[1], 1);
+
+	for (int i = 0; i < 16; ++i) {
+		writer.Write(bestIndices[i], i == 0 ? 3 : 4);
+	}
+
+}
+
+void DecodeBlock(TextureFormat format, const uint8_t* block, uint8_t* blockPixels) {
+
+	switch (format) {
+	case TextureFormat::kBC1:
+	case TextureFormat::kBC1Srgb:
+		DecodeBC1Block(block, true, blockPixels);
+		break;
+	case TextureFormat::kBC3:
+	case TextureFormat::kBC3Srgb:
+		DecodeBC1Block(block + 8, false, blockPixels);
+		DecodeBC4Block(block, 3, blockPixels);
+		break;
+	case TextureFormat::kBC5:
+		for (int i = 0; i < 16; ++i) {
+			blockPixels[i * 4 + 2] = 0;
+			blockPixels[i * 4 + 3] = 255;
+		}
+		DecodeBC4Block(block, 0, blockPixels);
+		DecodeBC4Block(block + 8, 1, blockPixels);
+		break;
+	case TextureFormat::kBC7:
+	case TextureFormat::kBC7Srgb: {
+
+		std::memset(blockPixels, 0, 64);
+
+		BitReader reader{ block };
+
+		if (reader.Read(7) != (1 << 6)) {
+			break;
+		}
+
+		BC7Endpoints endpoints;
+
+		for (int c = 0; c < 4; ++c) {
+			endpoints.values[0][c] = reader.Read(7);
+			endpoints.values[1][c] = reader.Read(7);
+		}
+
+		endpoints.pBits[0] = reader.Read(1);
+		endpoints.pBits[1] = reader.Read(1);
+
+		int palette[16][4];
+
+		MakeBC7Palette(endpoints, palette);
+
+		for (int i = 0; i < 16; ++i) {
+			const int* color = palette[reader.Read(i == 0 ? 3 : 4)];
+			for (int c = 0; c < 4; ++c) {
+				blockPixels[i * 4 + c] = static_cast<uint8_t>(color[c]);
+			}
+		}
+
+		break;
+
+	}
+	default:
+		std::memset(blockPixels, 0, 64);
+		break;
+	}
+
+}
+
+bool CompressTexture(const TextureData& source, TextureFormat format, TextureData& destination, JobSystem* jobSystem) {
+
+	if ((source.format != TextureFormat::kRGBA8 && source.format != TextureFormat::kRGBA8Srgb) || !IsBlockCompressed(format)) {
+		return false;
+	}
+
+	InitializeTexture(destination, MakeSrgbFormat(format, IsSrgbFormat(source.format)), source.width, source.height, static_cast<uint32_t>(source.mips.size()));
+
+	//段ごとのブロックの行の始まり(全段のブロックの行を1列に並べて分ける)
+	std::vector<size_t> firstBlockRows(destination.mips.size() + 1, 0);
+
+	for (size_t mip = 0; mip < destination.mips.size(); ++mip) {
+		firstBlockRows[mip + 1] = firstBlockRows[mip] + destination.mips[mip].rowCount;
+	}
+
+	uint32_t bytesPerBlock = GetBytesPerBlock(format);
+
+	auto compressRows = [&](size_t begin, size_t end) {
+
+		uint8_t blockPixels[64];
+
+		for (size_t row = begin; row < end; ++row) {
+
+			size_t mip = static_cast<size_t>(std::upper_bound(firstBlockRows.begin(), firstBlockRows.end(), row) - firstBlockRows.begin()) - 1;
+
+			const TextureMip& sourceLevel = source.mips[mip];
+			const TextureMip& level = destination.mips[mip];
+
+			uint32_t blockY = static_cast<uint32_t>(row - firstBlockRows[mip]);
+
+			uint8_t* blocks = destination.pixels.data() + level.offset + size_t(blockY) * level.rowPitch;
+
+			for (uint32_t blockX = 0; blockX < level.rowPitch / bytesPerBlock; ++blockX) {
+				LoadBlockPixels(source, sourceLevel, blockX, blockY, blockPixels);
+				EncodeBlock(destination.format, blockPixels, blocks + size_t(blockX) * bytesPerBlock);
+			}
+
+		}
+
+	};
+
+	if (jobSystem != nullptr) {
+		jobSystem->ParallelFor(firstBlockRows.back(), kMinBlockRowChunkSize, compressRows);
+	} else {
+		compressRows(0, firstBlockRows.back());
+	}
+
+	return true;
+
+}
+
+bool DecompressTexture(const TextureData& source, TextureData& destination) {
+
+	if (!IsBlockCompressed(source.format)) {
+		return false;
+	}
+
+	InitializeTexture(destination, MakeSrgbFormat(TextureFormat::kRGBA8, IsSrgbFormat(source.format)), source.width, source.height, static_cast<uint32_t>(source.mips.size()));
+
+	uint32_t bytesPerBlock = GetBytesPerBlock(source.format);
+
+	uint8_t blockPixels[64];
+
+	for (size_t mip = 0; mip < source.mips.size(); ++mip) {
+
+		const TextureMip& sourceLevel = source.mips[mip];
+		const TextureMip& level = destination.mips[mip];
+
+		for (uint32_t blockY = 0; blockY < sourceLevel.rowCount; ++blockY) {
+			for (uint32_t blockX = 0; blockX < sourceLevel.rowPitch / bytesPerBlock; ++blockX) {
+
+				DecodeBlock(source.format, source.pixels.data() + sourceLevel.offset + size_t(blockY) * sourceLevel.rowPitch + size_t(blockX) * bytesPerBlock, blockPixels);
+
+				//はみ出した画素は捨てる
+				for (uint32_t y = 0; y < 4 && blockY * 4 + y < level.height; ++y) {
+					for (uint32_t x = 0; x < 4 && blockX * 4 + x < level.width; ++x) {
+						std::memcpy(destination.pixels.data() + level.offset + size_t(blockY * 4 + y) * level.rowPitch + size_t(blockX * 4 + x) * 4, blockPixels + (y * 4 + x) * 4, 4);
+					}
+				}
+
+			}
+		}
+
+	}
+
+	return true;
+
+}
+
+double ComputePsnr(const TextureData& reference, const TextureData& test, uint32_t channelCount) {
+
+	if (reference.pixels.size() != test.pixels.size() || GetBytesPerBlock(reference.format) != 4 || GetBytesPerBlock(test.format) != 4) {
+		return 0.0;
+	}
+
+	double squaredError = 0.0;
+
+	size_t sampleCount = 0;
+
+	for (size_t i = 0; i < reference.pixels.size(); i += 4) {
+		for (uint32_t c = 0; c < channelCount; ++c) {
+			double difference = static_cast<double>(reference.pixels[i + c]) - static_cast<double>(test.pixels[i + c]);
+			squaredError += difference * difference;
+		}
+		sampleCount += channelCount;
+	}
+
+	if (squaredError == 0.0) {
+		return std::numeric_limits<double>::infinity();
+	}
+
+	return 10.0 * std::log10(255.0 * 255.0 * static_cast<double>(sampleCount) / squaredError);
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "Texture.h"
+
+class JobSystem;
+
+//4x4画素のブロック圧縮(BC1/BC3/BC5/BC7)
+//blockPixelsは左上から行順に16画素のRGBA8。sRGBの形式でも保存されている値のまま誤差を測る
+
+//BC1(8バイト)。アルファは持たず、常に4色のモードにする
+void EncodeBC1Block(const uint8_t* blockPixels, uint8_t* block);
+
+//BC4(8バイト)。channelの1チャンネルだけを圧縮する
+void EncodeBC4Block(const uint8_t* blockPixels, uint32_t channel, uint8_t* block);
+
+//BC3(16バイト) = アルファのBC4 + 色のBC1
+void EncodeBC3Block(const uint8_t* blockPixels, uint8_t* block);
+
+//BC5(16バイト) = RのBC4 + GのBC4(法線マップ向け)
+void EncodeBC5Block(const uint8_t* blockPixels, uint8_t* block);
+
+//BC7(16バイト)。RGBAを1組の端点で表すmode 6だけを使う(分割のあるモードは探さない)
+void EncodeBC7Block(const uint8_t* blockPixels, uint8_t* block);
+
+//ブロックを16画素のRGBA8に戻す(BC7はmode 6以外なら0にする)
+void DecodeBlock(TextureFormat format, const uint8_t* block, uint8_t* blockPixels);
+
+//RGBA8のテクスチャの全段をformatのブロック圧縮にする(sRGBかどうかはsourceに合わせる)
+//段をまたいだブロックの行をjobSystemで分ける(nullptrなら1スレッド)。端の半端なブロックは端の画素を繰り返す
+bool CompressTexture(const TextureData& source, TextureFormat format, TextureData& destination, JobSystem* jobSystem = nullptr);
+
+//ブロック圧縮のテクスチャの全段をRGBA8に戻す
+bool DecompressTexture(const TextureData& source, TextureData& destination);
+
+//同じ大きさのRGBA8のテクスチャの全段について、先頭からchannelCountチャンネルのPSNR(dB)を求める
+double ComputePsnr(const TextureData& reference, const TextureData& test, uint32_t channelCount = 4);
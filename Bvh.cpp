@@ -0,0 +1,623 @@
+#include "Bvh.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+	//葉に入れるオブジェクトの最大数(これ以下なら分割しない)
+	const uint32_t kMaxLeafObjects = 4;
+
+	//SAHで分割位置を探す時のビンの数
+	const uint32_t kBinCount = 16;
+
+	//構築時からこの割合よりコストが悪化したら作り直す
+	const float kRebuildCostRatio = 1.5f;
+
+	float GetAxis(const Vector3& v, int axis) {
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	float SurfaceArea(const Vector3& min, const Vector3& max) {
+
+		float x = max.x - min.x;
+		float y = max.y - min.y;
+		float z = max.z - min.z;
+
+		if (x < 0.0f || y < 0.0f || z < 0.0f) {
+			return 0.0f;
+		}
+
+		return 2.0f * (x * y + y * z + z * x);
+
+	}
+
+	void Grow(Vector3& min, Vector3& max, const Vector3& otherMin, const Vector3& otherMax) {
+
+		min.x = (std::min)(min.x, otherMin.x);
+		min.y = (std::min)(min.y, otherMin.y);
+		min.z = (std::min)(min.z, otherMin.z);
+		max.x = (std::max)(max.x, otherMax.x);
+		max.y = (std::max)(max.y, otherMax.y);
+		max.z = (std::max)(max.z, otherMax.z);
+
+	}
+
+	Vector3 Centroid(const AABB& aabb) {
+		return { (aabb.min.x + aabb.max.x) * 0.5f, (aabb.min.y + aabb.max.y) * 0.5f, (aabb.min.z + aabb.max.z) * 0.5f };
+	}
+
+	const Vector3 kEmptyMin = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+	const Vector3 kEmptyMax = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+
+	//AABBと平面の関係(-1:外側 0:交差 1:内側)
+	int ClassifyAABB(const Vector4& plane, const Vector3& min, const Vector3& max) {
+
+		float centerX = (min.x + max.x) * 0.5f;
+		float centerY = (min.y + max.y) * 0.5f;
+		float centerZ = (min.z + max.z) * 0.5f;
+
+		float distance = plane.x * centerX + plane.y * centerY + plane.z * centerZ + plane.w;
+
+		float radius = std::fabs(plane.x) * (max.x - centerX) + std::fabs(plane.y) * (max.y - centerY) + std::fabs(plane.z) * (max.z - centerZ);
+
+		if (distance + radius < 0.0f) {
+			return -1;
+		}
+
+		return distance - radius >= 0.0f ? 1 : 0;
+
+	}
+
+	//レイがAABBに入る距離(当たらなければfalse)
+	bool IntersectRayAABB(const Vector3& origin, const Vector3& inverseDirection, const Vector3& min, const Vector3& max, float maxDistance, float& distance) {
+
+		float tx0 = (min.x - origin.x) * inverseDirection.x;
+		float tx1 = (max.x - origin.x) * inverseDirection.x;
+		float ty0 = (min.y - origin.y) * inverseDirection.y;
+		float ty1 = (max.y - origin.y) * inverseDirection.y;
+		float tz0 = (min.z - origin.z) * inverseDirection.z;
+		float tz1 = (max.z - origin.z) * inverseDirection.z;
+
+		float tNear = (std::max)({ (std::min)(tx0, tx1), (std::min)(ty0, ty1), (std::min)(tz0, tz1), 0.0f });
+		float tFar = (std::min)({ (std::max)(tx0, tx1), (std::max)(ty0, ty1), (std::max)(tz0, tz1), maxDistance });
+
+		distance = tNear;
+
+		return tNear <= tFar;
+
+	}
+
+}
+
+void Bvh::Build(const AABB* bounds, size_t count) {
+
+	bounds_.assign(bounds, bounds + count);
+
+	Rebuild();
+
+}
+
+void Bvh::Rebuild() {
+
+	size_t count = bounds_.size();
+
+	nodes_.clear();
+
+	buildCost_ = 0.0f;
+
+	objectIndices_.resize(count);
+
+	if (count == 0) {
+		return;
+	}
+
+	buildPrimitives_.resize(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		buildPrimitives_[i] = { bounds_[i], Centroid(bounds_[i]), static_cast<uint32_t>(i) };
+	}
+
+	//最悪でも葉1つにオブジェクト1つなのでノードは2n-1個に収まる
+	nodes_.reserve(count * 2);
+
+	nodes_.push_back({ {}, 0, {}, static_cast<uint32_t>(count) });
+
+	UpdateBuildNodeBounds(0);
+
+	Subdivide(0);
+
+	for (size_t i = 0; i < count; ++i) {
+		objectIndices_[i] = buildPrimitives_[i].objectIndex;
+	}
+
+	buildCost_ = ComputeCost();
+
+}
+
+void Bvh::Update(uint32_t objectIndex, const AABB& bounds) {
+
+	bounds_[objectIndex] = bounds;
+
+}
+
+void Bvh::Refit() {
+
+	//子は必ず親より後ろにあるので、後ろから詰めれば下から順に合わせられる
+	for (size_t i = nodes_.size(); i-- > 0;) {
+
+		BvhNode& node = nodes_[i];
+
+		if (node.count > 0) {
+			UpdateNodeBounds(static_cast<uint32_t>(i));
+			continue;
+		}
+
+		const BvhNode& left = nodes_[node.leftOrFirst];
+		const BvhNode& right = nodes_[node.leftOrFirst + 1];
+
+		node.min = left.min;
+		node.max = left.max;
+
+		Grow(node.min, node.max, right.min, right.max);
+
+	}
+
+}
+
+bool Bvh::RefitOrRebuild() {
+
+	Refit();
+
+	if (ComputeCost() <= buildCost_ * kRebuildCostRatio) {
+		return false;
+	}
+
+	Rebuild();
+
+	return true;
+
+}
+
+size_t Bvh::QueryFrustum(const Frustum& frustum, uint32_t* visibleIndices) const {
+
+	if (nodes_.empty()) {
+		return 0;
+	}
+
+	size_t visibleCount = 0;
+
+	//ノードと、まだ判定が必要な平面のビットマスク
+	struct StackEntry {
+		uint32_t nodeIndex;
+		uint32_t planeMask;
+	};
+
+	std::vector<StackEntry> stack;
+
+	stack.reserve(64);
+
+	stack.push_back({ 0, 0x3f });
+
+	while (!stack.empty()) {
+
+		StackEntry entry = stack.back();
+
+		stack.pop_back();
+
+		const BvhNode& node = nodes_[entry.nodeIndex];
+
+		uint32_t planeMask = entry.planeMask;
+
+		bool isOutside = false;
+
+		for (uint32_t plane = 0; plane < 6 && !isOutside; ++plane) {
+
+			if (!(planeMask & (1u << plane))) {
+				continue;
+			}
+
+			int result = ClassifyAABB(frustum.planes[plane], node.min, node.max);
+
+			if (result < 0) {
+				isOutside = true;
+			} else if (result > 0) {
+				//完全に内側の平面は子では判定しない
+				planeMask &= ~(1u << plane);
+			}
+
+		}
+
+		if (isOutside) {
+			continue;
+		}
+
+		if (node.count == 0) {
+			stack.push_back({ node.leftOrFirst, planeMask });
+			stack.push_back({ node.leftOrFirst + 1, planeMask });
+			continue;
+		}
+
+		for (uint32_t i = 0; i < node.count; ++i) {
+
+			uint32_t objectIndex = objectIndices_[node.leftOrFirst + i];
+
+			const AABB& bounds = bounds_[objectIndex];
+
+			bool isVisible = true;
+
+			for (uint32_t plane = 0; plane < 6 && isVisible; ++plane) {
+				if ((planeMask & (1u << plane)) && ClassifyAABB(frustum.planes[plane], bounds.min, bounds.max) < 0) {
+					isVisible = false;
+				}
+			}
+
+			if (isVisible) {
+				visibleIndices[visibleCount++] = objectIndex;
+			}
+
+		}
+
+	}
+
+	return visibleCount;
+
+}
+
+void Bvh::QuerySphere(const Vector3& center, float radius, std::vector<uint32_t>& result) const {
+
+	if (nodes_.empty()) {
+		return;
+	}
+
+	float radiusSquared = radius * radius;
+
+	//球の中心からAABBまでの最短距離の2乗
+	auto distanceSquared = [&](const Vector3& min, const Vector3& max) {
+		float x = (std::max)({ min.x - center.x, 0.0f, center.x - max.x });
+		float y = (std::max)({ min.y - center.y, 0.0f, center.y - max.y });
+		float z = (std::max)({ min.z - center.z, 0.0f, center.z - max.z });
+		return x * x + y * y + z * z;
+	};
+
+	std::vector<uint32_t> stack;
+
+	stack.reserve(64);
+
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+
+		const BvhNode& node = nodes_[stack.back()];
+
+		stack.pop_back();
+
+		if (distanceSquared(node.min, node.max) > radiusSquared) {
+			continue;
+		}
+
+		if (node.count == 0) {
+			stack.push_back(node.leftOrFirst);
+			stack.push_back(node.leftOrFirst + 1);
+			continue;
+		}
+
+		for (uint32_t i = 0; i < node.count; ++i) {
+			uint32_t objectIndex = objectIndices_[node.leftOrFirst + i];
+			if (distanceSquared(bounds_[objectIndex].min, bounds_[objectIndex].max) <= radiusSquared) {
+				result.push_back(objectIndex);
+			}
+		}
+
+	}
+
+}
+
+uint32_t Bvh::Raycast(const Ray& ray, float maxDistance, const std::function<bool(uint32_t objectIndex, float& distance)>& intersect, float* hitDistance) const {
+
+	if (nodes_.empty()) {
+		return kInvalidIndex;
+	}
+
+	Vector3 inverseDirection = { 1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z };
+
+	float closestDistance = maxDistance;
+
+	uint32_t closestObject = kInvalidIndex;
+
+	float rootDistance = 0.0f;
+
+	if (!IntersectRayAABB(ray.origin, inverseDirection, nodes_[0].min, nodes_[0].max, closestDistance, rootDistance)) {
+		return kInvalidIndex;
+	}
+
+	struct StackEntry {
+		uint32_t nodeIndex;
+		float distance;
+	};
+
+	std::vector<StackEntry> stack;
+
+	stack.reserve(64);
+
+	stack.push_back({ 0, rootDistance });
+
+	while (!stack.empty()) {
+
+		StackEntry entry = stack.back();
+
+		stack.pop_back();
+
+		//もっと近くで当たっていれば調べなくてよい
+		if (entry.distance > closestDistance) {
+			continue;
+		}
+
+		const BvhNode& node = nodes_[entry.nodeIndex];
+
+		if (node.count > 0) {
+
+			for (uint32_t i = 0; i < node.count; ++i) {
+
+				uint32_t objectIndex = objectIndices_[node.leftOrFirst + i];
+
+				const AABB& bounds = bounds_[objectIndex];
+
+				float distance = 0.0f;
+
+				if (!IntersectRayAABB(ray.origin, inverseDirection, bounds.min, bounds.max, closestDistance, distance)) {
+					continue;
+				}
+
+				if (intersect && !intersect(objectIndex, distance)) {
+					continue;
+				}
+
+				if (distance >= 0.0f && distance < closestDistance) {
+					closestDistance = distance;
+					closestObject = objectIndex;
+				}
+
+			}
+
+			continue;
+
+		}
+
+		//近い子から先に調べるように、遠い方を先に積む
+		uint32_t childIndices[2] = { node.leftOrFirst, node.leftOrFirst + 1 };
+
+		float childDistances[2];
+
+		bool isHit[2];
+
+		for (int i = 0; i < 2; ++i) {
+			const BvhNode& child = nodes_[childIndices[i]];
+			isHit[i] = IntersectRayAABB(ray.origin, inverseDirection, child.min, child.max, closestDistance, childDistances[i]);
+		}
+
+		int nearChild = childDistances[0] <= childDistances[1] ? 0 : 1;
+
+		int farChild = 1 - nearChild;
+
+		if (isHit[farChild]) {
+			stack.push_back({ childIndices[farChild], childDistances[farChild] });
+		}
+
+		if (isHit[nearChild]) {
+			stack.push_back({ childIndices[nearChild], childDistances[nearChild] });
+		}
+
+	}
+
+	if (closestObject != kInvalidIndex && hitDistance != nullptr) {
+		*hitDistance = closestDistance;
+	}
+
+	return closestObject;
+
+}
+
+float Bvh::ComputeCost() const {
+
+	if (nodes_.empty()) {
+		return 0.0f;
+	}
+
+	float rootArea = SurfaceArea(nodes_[0].min, nodes_[0].max);
+
+	if (rootArea <= 0.0f) {
+		return 0.0f;
+	}
+
+	//内部ノードは辿るコスト1、葉はオブジェクト1つにつき1
+	float cost = 0.0f;
+
+	for (const BvhNode& node : nodes_) {
+		cost += SurfaceArea(node.min, node.max) * (node.count > 0 ? static_cast<float>(node.count) : 1.0f);
+	}
+
+	return cost / rootArea;
+
+}
+
+void Bvh::UpdateNodeBounds(uint32_t nodeIndex) {
+
+	BvhNode& node = nodes_[nodeIndex];
+
+	node.min = kEmptyMin;
+	node.max = kEmptyMax;
+
+	for (uint32_t i = 0; i < node.count; ++i) {
+		const AABB& bounds = bounds_[objectIndices_[node.leftOrFirst + i]];
+		Grow(node.min, node.max, bounds.min, bounds.max);
+	}
+
+}
+
+void Bvh::UpdateBuildNodeBounds(uint32_t nodeIndex) {
+
+	BvhNode& node = nodes_[nodeIndex];
+
+	node.min = kEmptyMin;
+	node.max = kEmptyMax;
+
+	for (uint32_t i = 0; i < node.count; ++i) {
+		const AABB& bounds = buildPrimitives_[node.leftOrFirst + i].bounds;
+		Grow(node.min, node.max, bounds.min, bounds.max);
+	}
+
+}
+
+void Bvh::Subdivide(uint32_t rootIndex) {
+
+	struct Bin {
+		Vector3 min;
+		Vector3 max;
+		uint32_t count;
+	};
+
+	std::vector<uint32_t> stack;
+
+	stack.push_back(rootIndex);
+
+	while (!stack.empty()) {
+
+		uint32_t nodeIndex = stack.back();
+
+		stack.pop_back();
+
+		BvhNode node = nodes_[nodeIndex];
+
+		if (node.count <= kMaxLeafObjects) {
+			continue;
+		}
+
+		uint32_t first = node.leftOrFirst;
+
+		uint32_t last = first + node.count;
+
+		//重心の範囲でビンを切る
+		Vector3 centroidMin = kEmptyMin;
+		Vector3 centroidMax = kEmptyMax;
+
+		for (uint32_t i = first; i < last; ++i) {
+			const Vector3& centroid = buildPrimitives_[i].centroid;
+			Grow(centroidMin, centroidMax, centroid, centroid);
+		}
+
+		float bestCost = std::numeric_limits<float>::max();
+		int bestAxis = -1;
+		uint32_t bestSplit = 0;
+
+		for (int axis = 0; axis < 3; ++axis) {
+
+			float axisMin = GetAxis(centroidMin, axis);
+			float extent = GetAxis(centroidMax, axis) - axisMin;
+
+			if (extent <= 0.0f) {
+				continue;
+			}
+
+			float scale = static_cast<float>(kBinCount) / extent;
+
+			Bin bins[kBinCount];
+
+			for (Bin& bin : bins) {
+				bin = { kEmptyMin, kEmptyMax, 0 };
+			}
+
+			for (uint32_t i = first; i < last; ++i) {
+				const BuildPrimitive& primitive = buildPrimitives_[i];
+				uint32_t binIndex = (std::min)(kBinCount - 1, static_cast<uint32_t>((GetAxis(primitive.centroid, axis) - axisMin) * scale));
+				bins[binIndex].count++;
+				Grow(bins[binIndex].min, bins[binIndex].max, primitive.bounds.min, primitive.bounds.max);
+			}
+
+			//左右から累積して、各分割位置の面積と数を求める
+			float leftArea[kBinCount - 1];
+			float rightArea[kBinCount - 1];
+			uint32_t leftCount[kBinCount - 1];
+			uint32_t rightCount[kBinCount - 1];
+
+			Vector3 leftMin = kEmptyMin;
+			Vector3 leftMax = kEmptyMax;
+			Vector3 rightMin = kEmptyMin;
+			Vector3 rightMax = kEmptyMax;
+
+			uint32_t leftSum = 0;
+			uint32_t rightSum = 0;
+
+			for (uint32_t i = 0; i < kBinCount - 1; ++i) {
+
+				leftSum += bins[i].count;
+				Grow(leftMin, leftMax, bins[i].min, bins[i].max);
+				leftCount[i] = leftSum;
+				leftArea[i] = SurfaceArea(leftMin, leftMax);
+
+				uint32_t j = kBinCount - 1 - i;
+				rightSum += bins[j].count;
+				Grow(rightMin, rightMax, bins[j].min, bins[j].max);
+				rightCount[j - 1] = rightSum;
+				rightArea[j - 1] = SurfaceArea(rightMin, rightMax);
+
+			}
+
+			for (uint32_t i = 0; i < kBinCount - 1; ++i) {
+
+				if (leftCount[i] == 0 || rightCount[i] == 0) {
+					continue;
+				}
+
+				float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = i;
+				}
+
+			}
+
+		}
+
+		//分けない方が安ければ葉のままにする
+		if (bestAxis < 0 || bestCost >= static_cast<float>(node.count) * SurfaceArea(node.min, node.max)) {
+			continue;
+		}
+
+		float axisMin = GetAxis(centroidMin, bestAxis);
+		float scale = static_cast<float>(kBinCount) / (GetAxis(centroidMax, bestAxis) - axisMin);
+
+		BuildPrimitive* middle = std::partition(buildPrimitives_.data() + first, buildPrimitives_.data() + last, [&](const BuildPrimitive& primitive) {
+			uint32_t binIndex = (std::min)(kBinCount - 1, static_cast<uint32_t>((GetAxis(primitive.centroid, bestAxis) - axisMin) * scale));
+			return binIndex <= bestSplit;
+		});
+
+		uint32_t leftCount = static_cast<uint32_t>(middle - buildPrimitives_.data()) - first;
+
+		if (leftCount == 0 || leftCount == node.count) {
+			continue;
+		}
+
+		uint32_t leftIndex = static_cast<uint32_t>(nodes_.size());
+
+		nodes_.push_back({ {}, first, {}, leftCount });
+
+		nodes_.push_back({ {}, first + leftCount, {}, node.count - leftCount });
+
+		UpdateBuildNodeBounds(leftIndex);
+
+		UpdateBuildNodeBounds(leftIndex + 1);
+
+		nodes_[nodeIndex].leftOrFirst = leftIndex;
+
+		nodes_[nodeIndex].count = 0;
+
+		stack.push_back(leftIndex);
+
+		stack.push_back(leftIndex + 1);
+
+	}
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <functional>
+#include "MathTypes.h"
+#include "FrustumCulling.h"
+
+//レイ(directionは正規化しなくてよい。距離はdirectionの長さが単位になる)
+struct Ray {
+
+	Vector3 origin;
+	Vector3 direction;
+
+};
+
+//BVHのノード(32バイト)
+//内部ノードはleftOrFirstが左の子で右の子はその次、葉はleftOrFirstからcount個のオブジェクトを持つ
+struct BvhNode {
+
+	Vector3 min;
+	uint32_t leftOrFirst;
+	Vector3 max;
+	uint32_t count;
+
+};
+
+//オブジェクトのAABBに対するBVH
+//SAHで構築して配列に平らに並べる。動いたオブジェクトはRefitで追従し、質が落ちたら作り直す
+class Bvh {
+
+public:
+
+	static const uint32_t kInvalidIndex = 0xffffffff;
+
+	//オブジェクトのAABBから作り直す
+	void Build(const AABB* bounds, size_t count);
+
+	//オブジェクトのAABBを更新する(木に反映するのはRefit/RefitOrRebuild)
+	void Update(uint32_t objectIndex, const AABB& bounds);
+
+	//木の形はそのままでノードの大きさだけ合わせる
+	void Refit();
+
+	//Refitして、構築時よりコストが大きく悪化していれば作り直す(作り直したらtrue)
+	bool RefitOrRebuild();
+
+	//見えるオブジェクトのインデックスをvisibleIndicesに書く(GetObjectCount()ぶん必要)
+	size_t QueryFrustum(const Frustum& frustum, uint32_t* visibleIndices) const;
+
+	//球と重なるオブジェクトをresultに追加する
+	void QuerySphere(const Vector3& center, float radius, std::vector<uint32_t>& result) const;
+
+	//レイと最初に当たるオブジェクトを返す(なければkInvalidIndex)
+	//intersectはオブジェクトごとの細かい判定で、当たれば距離を書いてtrueを返す(空ならAABBで判定する)
+	uint32_t Raycast(const Ray& ray, float maxDistance, const std::function<bool(uint32_t objectIndex, float& distance)>& intersect, float* hitDistance) const;
+
+	size_t GetObjectCount() const { return bounds_.size(); }
+
+	size_t GetNodeCount() const { return nodes_.size(); }
+
+	const AABB& GetBounds(uint32_t objectIndex) const { return bounds_[objectIndex]; }
+
+	//表面積ヒューリスティックによる木のコスト(根の面積で割ったもの)
+	float ComputeCost() const;
+
+	float GetBuildCost() const { return buildCost_; }
+
+private:
+
+	//今のAABBで木を作り直す
+	void Rebuild();
+
+	void UpdateNodeBounds(uint32_t nodeIndex);
+
+	//構築中のノードの大きさをbuildPrimitives_から求める
+	void UpdateBuildNodeBounds(uint32_t nodeIndex);
+
+	void Subdivide(uint32_t rootIndex);
+
+	std::vector<AABB> bounds_;
+
+	//葉が指す範囲に並べたオブジェクトのインデックス
+	std::vector<uint32_t> objectIndices_;
+
+	//構築中はAABBと重心をオブジェクトのインデックスと一緒に並べ替える(間接参照しないで済む)
+	struct BuildPrimitive {
+
+		AABB bounds;
+		Vector3 centroid;
+		uint32_t objectIndex;
+
+	};
+
+	std::vector<BuildPrimitive> buildPrimitives_;
+
+	std::vector<BvhNode> nodes_;
+
+	float buildCost_ = 0.0f;
+
+};
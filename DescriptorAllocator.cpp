@@ -0,0 +1,109 @@
+#include "DescriptorAllocator.h"
+#include <cassert>
+
+void DescriptorAllocator::Initialize(uint32_t persistentCount, uint32_t transientCount) {
+
+	persistentCount_ = persistentCount;
+
+	transientCount_ = transientCount;
+
+	//小さいインデックスから使われるように逆順で積む
+	freeList_.resize(persistentCount_);
+
+	for (uint32_t i = 0; i < persistentCount_; ++i) {
+		freeList_[i] = persistentCount_ - 1 - i;
+	}
+
+	isAllocated_.assign(persistentCount_, false);
+
+	transientHead_ = 0;
+
+	transientUsed_ = 0;
+
+	currentFrameSize_ = 0;
+
+	frameRanges_.clear();
+
+}
+
+uint32_t DescriptorAllocator::AllocatePersistent() {
+
+	if (freeList_.empty()) {
+		return kInvalidIndex;
+	}
+
+	uint32_t index = freeList_.back();
+
+	freeList_.pop_back();
+
+	isAllocated_[index] = true;
+
+	return index;
+
+}
+
+void DescriptorAllocator::FreePersistent(uint32_t index) {
+
+	assert(index < persistentCount_);
+
+	assert(isAllocated_[index]);
+
+	isAllocated_[index] = false;
+
+	freeList_.push_back(index);
+
+}
+
+uint32_t DescriptorAllocator::AllocateTransient(uint32_t count) {
+
+	if (count == 0 || count > transientCount_) {
+		return kInvalidIndex;
+	}
+
+	uint32_t wasted = 0;
+
+	//末尾に収まらない場合は先頭まで飛ばす(連続した領域が必要なため)
+	if (transientHead_ + count > transientCount_) {
+		wasted = transientCount_ - transientHead_;
+	}
+
+	if (transientCount_ - transientUsed_ < wasted + count) {
+		return kInvalidIndex;
+	}
+
+	if (wasted != 0) {
+		transientHead_ = 0;
+	}
+
+	uint32_t start = transientHead_;
+
+	transientHead_ = (transientHead_ + count) % transientCount_;
+
+	transientUsed_ += wasted + count;
+
+	currentFrameSize_ += wasted + count;
+
+	//常駐スロットの後ろに配置されている
+	return persistentCount_ + start;
+
+}
+
+void DescriptorAllocator::FinishFrame(uint64_t fenceValue) {
+
+	frameRanges_.push_back({ fenceValue, currentFrameSize_ });
+
+	currentFrameSize_ = 0;
+
+}
+
+void DescriptorAllocator::ReleaseCompleted(uint64_t completedFenceValue) {
+
+	while (!frameRanges_.empty() && frameRanges_.front().fenceValue <= completedFenceValue) {
+
+		transientUsed_ -= frameRanges_.front().size;
+
+		frameRanges_.pop_front();
+
+	}
+
+}
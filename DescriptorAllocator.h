@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <deque>
+
+//ディスクリプタのインデックスだけを管理するアロケータ(D3D12には依存しない)
+//前半は解放されるまで使い続ける常駐スロット、後半はフレームごとに使い捨てるリングになっている
+class DescriptorAllocator {
+
+public:
+
+	static const uint32_t kInvalidIndex = 0xffffffff;
+
+	void Initialize(uint32_t persistentCount, uint32_t transientCount);
+
+	//常駐スロットをフリーリストから確保する(足りなければkInvalidIndex)
+	uint32_t AllocatePersistent();
+
+	void FreePersistent(uint32_t index);
+
+	//このフレームで使う連続した領域をリングから確保する(足りなければkInvalidIndex)
+	uint32_t AllocateTransient(uint32_t count);
+
+	//このフレームで確保した領域にフェンスの値を結びつける
+	void FinishFrame(uint64_t fenceValue);
+
+	//GPUが完了したフレームの領域を回収する
+	void ReleaseCompleted(uint64_t completedFenceValue);
+
+	uint32_t GetPersistentCount() const { return persistentCount_; }
+
+	uint32_t GetTransientCount() const { return transientCount_; }
+
+	uint32_t GetPersistentUsed() const { return persistentCount_ - static_cast<uint32_t>(freeList_.size()); }
+
+	uint32_t GetTransientUsed() const { return transientUsed_; }
+
+private:
+
+	struct FrameRange {
+		uint64_t fenceValue;
+		uint32_t size;
+	};
+
+	uint32_t persistentCount_ = 0;
+
+	uint32_t transientCount_ = 0;
+
+	std::vector<uint32_t> freeList_;
+
+	//二重解放の検出用
+	std::vector<bool> isAllocated_;
+
+	uint32_t transientHead_ = 0;
+
+	uint32_t transientUsed_ = 0;
+
+	//まだフェンスが結びついていない現在のフレームの使用量(折り返しで捨てた分も含む)
+	uint32_t currentFrameSize_ = 0;
+
+	std::deque<FrameRange> frameRanges_;
+
+};
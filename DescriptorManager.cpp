@@ -0,0 +1,154 @@
+#include "DescriptorManager.h"
+#include <cassert>
+
+namespace {
+
+	ID3D12DescriptorHeap* CreateHeap(ID3D12Device* device, UINT numDescriptors, bool shaderVisible) {
+
+		ID3D12DescriptorHeap* descriptorHeap = nullptr;
+
+		D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc{};
+
+		descriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+
+		descriptorHeapDesc.NumDescriptors = numDescriptors;
+
+		descriptorHeapDesc.Flags = shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+		HRESULT hr = device->CreateDescriptorHeap(&descriptorHeapDesc, IID_PPV_ARGS(&descriptorHeap));
+
+		assert(SUCCEEDED(hr));
+
+		return descriptorHeap;
+
+	}
+
+}
+
+void DescriptorManager::Initialize(ID3D12Device* device, uint32_t persistentCount, uint32_t transientCount, uint32_t stagingCount) {
+
+	device_ = device;
+
+	heap_ = CreateHeap(device_, persistentCount + transientCount, true);
+
+	stagingHeap_ = CreateHeap(device_, stagingCount, false);
+
+	descriptorSize_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	allocator_.Initialize(persistentCount, transientCount);
+
+	stagingAllocator_.Initialize(stagingCount, 0);
+
+}
+
+void DescriptorManager::Finalize() {
+
+	if (stagingHeap_ != nullptr) {
+		stagingHeap_->Release();
+		stagingHeap_ = nullptr;
+	}
+
+	if (heap_ != nullptr) {
+		heap_->Release();
+		heap_ = nullptr;
+	}
+
+}
+
+uint32_t DescriptorManager::AllocatePersistent() {
+
+	uint32_t index = allocator_.AllocatePersistent();
+
+	assert(index != DescriptorAllocator::kInvalidIndex);
+
+	return index;
+
+}
+
+void DescriptorManager::FreePersistent(uint32_t index) {
+
+	allocator_.FreePersistent(index);
+
+}
+
+uint32_t DescriptorManager::AllocateStaging() {
+
+	uint32_t index = stagingAllocator_.AllocatePersistent();
+
+	assert(index != DescriptorAllocator::kInvalidIndex);
+
+	return index;
+
+}
+
+void DescriptorManager::FreeStaging(uint32_t index) {
+
+	stagingAllocator_.FreePersistent(index);
+
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorManager::GetStagingCPUHandle(uint32_t index) const {
+
+	D3D12_CPU_DESCRIPTOR_HANDLE handle = stagingHeap_->GetCPUDescriptorHandleForHeapStart();
+
+	handle.ptr += static_cast<SIZE_T>(descriptorSize_) * index;
+
+	return handle;
+
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorManager::GetCPUHandle(uint32_t index) const {
+
+	D3D12_CPU_DESCRIPTOR_HANDLE handle = heap_->GetCPUDescriptorHandleForHeapStart();
+
+	handle.ptr += static_cast<SIZE_T>(descriptorSize_) * index;
+
+	return handle;
+
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE DescriptorManager::GetGPUHandle(uint32_t index) const {
+
+	D3D12_GPU_DESCRIPTOR_HANDLE handle = heap_->GetGPUDescriptorHandleForHeapStart();
+
+	handle.ptr += static_cast<UINT64>(descriptorSize_) * index;
+
+	return handle;
+
+}
+
+uint32_t DescriptorManager::CopyToTransient(const uint32_t* stagingIndices, uint32_t count) {
+
+	uint32_t start = allocator_.AllocateTransient(count);
+
+	assert(start != DescriptorAllocator::kInvalidIndex);
+
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> sources(count);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		sources[i] = GetStagingCPUHandle(stagingIndices[i]);
+	}
+
+	//コピー先は1つの連続した範囲
+	D3D12_CPU_DESCRIPTOR_HANDLE destination = GetCPUHandle(start);
+
+	UINT destinationSize = count;
+
+	device_->CopyDescriptors(1, &destination, &destinationSize,
+		count, sources.data(), nullptr, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	return start;
+
+}
+
+void DescriptorManager::FinishFrame(uint64_t fenceValue) {
+
+	allocator_.FinishFrame(fenceValue);
+
+}
+
+void DescriptorManager::ReleaseCompleted(uint64_t completedFenceValue) {
+
+	allocator_.ReleaseCompleted(completedFenceValue);
+
+}
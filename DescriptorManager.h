@@ -0,0 +1,57 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include <vector>
+#include "DescriptorAllocator.h"
+
+//シェーダーから見えるCBV/SRV/UAVのヒープと、ビューを作るためのCPU専用のステージングヒープを管理する
+class DescriptorManager {
+
+public:
+
+	void Initialize(ID3D12Device* device, uint32_t persistentCount, uint32_t transientCount, uint32_t stagingCount);
+
+	void Finalize();
+
+	ID3D12DescriptorHeap* GetHeap() const { return heap_; }
+
+	//常駐スロット
+	uint32_t AllocatePersistent();
+
+	void FreePersistent(uint32_t index);
+
+	//ビューの作成先になるステージングスロット
+	uint32_t AllocateStaging();
+
+	void FreeStaging(uint32_t index);
+
+	D3D12_CPU_DESCRIPTOR_HANDLE GetStagingCPUHandle(uint32_t index) const;
+
+	D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(uint32_t index) const;
+
+	D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(uint32_t index) const;
+
+	//ステージングのディスクリプタをこのフレーム用の連続した領域へまとめてコピーし、先頭のインデックスを返す
+	uint32_t CopyToTransient(const uint32_t* stagingIndices, uint32_t count);
+
+	void FinishFrame(uint64_t fenceValue);
+
+	void ReleaseCompleted(uint64_t completedFenceValue);
+
+	const DescriptorAllocator& GetAllocator() const { return allocator_; }
+
+private:
+
+	ID3D12Device* device_ = nullptr;
+
+	ID3D12DescriptorHeap* heap_ = nullptr;
+
+	ID3D12DescriptorHeap* stagingHeap_ = nullptr;
+
+	uint32_t descriptorSize_ = 0;
+
+	DescriptorAllocator allocator_;
+
+	DescriptorAllocator stagingAllocator_;
+
+};
@@ -0,0 +1,164 @@
+#include "DrawQueue.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+	//1回の基数ソートで扱うbit数
+	const uint32_t kRadixBits = 8;
+
+	const uint32_t kRadixSize = 1 << kRadixBits;
+
+	//これより少なければ並列にしない
+	const size_t kMinParallelCount = 16384;
+
+}
+
+uint64_t MakeDrawSortKey(DrawPass pass, uint32_t pipelineIndex, uint32_t materialIndex, float viewDepth, float nearClip, float farClip) {
+
+	float normalizedDepth = (viewDepth - nearClip) / (farClip - nearClip);
+
+	normalizedDepth = (std::min)((std::max)(normalizedDepth, 0.0f), 1.0f);
+
+	uint64_t depth = static_cast<uint64_t>(normalizedDepth * 65535.0f);
+
+	if (pass == DrawPass::kTransparent) {
+		depth = 65535 - depth;
+	}
+
+	return (static_cast<uint64_t>(pass) & 0xf) << 60 |
+		(static_cast<uint64_t>(pipelineIndex) & 0xfff) << 48 |
+		(static_cast<uint64_t>(materialIndex) & 0xffff) << 32 |
+		depth << 16;
+
+}
+
+void RadixSort(uint64_t* keys, uint32_t* values, uint64_t* tempKeys, uint32_t* tempValues, size_t count, JobSystem* jobSystem) {
+
+	if (count <= 1) {
+		return;
+	}
+
+	uint32_t chunkCount = 1;
+
+	if (jobSystem != nullptr && count >= kMinParallelCount) {
+		chunkCount = jobSystem->GetChunkCount(count, kMinParallelCount / 4);
+	}
+
+	size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+	std::vector<uint32_t> histograms(static_cast<size_t>(chunkCount) * kRadixSize);
+
+	uint64_t* sourceKeys = keys;
+	uint32_t* sourceValues = values;
+	uint64_t* destinationKeys = tempKeys;
+	uint32_t* destinationValues = tempValues;
+
+	auto dispatch = [&](const auto& function) {
+		if (chunkCount == 1) {
+			function(0);
+		} else {
+			jobSystem->Dispatch(chunkCount, function);
+		}
+	};
+
+	for (uint32_t shift = 0; shift < 64; shift += kRadixBits) {
+
+		//塊ごとにこの桁のヒストグラムを作る
+		dispatch([&](uint32_t chunkIndex) {
+			uint32_t* histogram = &histograms[static_cast<size_t>(chunkIndex) * kRadixSize];
+			std::memset(histogram, 0, sizeof(uint32_t) * kRadixSize);
+			size_t begin = chunkIndex * chunkSize;
+			size_t end = (std::min)(begin + chunkSize, count);
+			for (size_t i = begin; i < end; ++i) {
+				histogram[(sourceKeys[i] >> shift) & (kRadixSize - 1)]++;
+			}
+		});
+
+		//全部同じ値の桁は並べ替える必要がない
+		bool isSkippable = false;
+
+		{
+			uint32_t digit = (sourceKeys[0] >> shift) & (kRadixSize - 1);
+			uint32_t total = 0;
+			for (uint32_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) {
+				total += histograms[static_cast<size_t>(chunkIndex) * kRadixSize + digit];
+			}
+			isSkippable = total == count;
+		}
+
+		if (isSkippable) {
+			continue;
+		}
+
+		//桁の値、塊の順に累積して書き込み先の位置にする(塊の順を保つので安定になる)
+		uint32_t offset = 0;
+
+		for (uint32_t digit = 0; digit < kRadixSize; ++digit) {
+			for (uint32_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) {
+				uint32_t& bucket = histograms[static_cast<size_t>(chunkIndex) * kRadixSize + digit];
+				uint32_t bucketCount = bucket;
+				bucket = offset;
+				offset += bucketCount;
+			}
+		}
+
+		dispatch([&](uint32_t chunkIndex) {
+			uint32_t* positions = &histograms[static_cast<size_t>(chunkIndex) * kRadixSize];
+			size_t begin = chunkIndex * chunkSize;
+			size_t end = (std::min)(begin + chunkSize, count);
+			for (size_t i = begin; i < end; ++i) {
+				uint32_t position = positions[(sourceKeys[i] >> shift) & (kRadixSize - 1)]++;
+				destinationKeys[position] = sourceKeys[i];
+				destinationValues[position] = sourceValues[i];
+			}
+		});
+
+		std::swap(sourceKeys, destinationKeys);
+
+		std::swap(sourceValues, destinationValues);
+
+	}
+
+	//最後の結果が一時領域にあれば元に戻す
+	if (sourceKeys != keys) {
+		std::memcpy(keys, sourceKeys, sizeof(uint64_t) * count);
+		std::memcpy(values, sourceValues, sizeof(uint32_t) * count);
+	}
+
+}
+
+void DrawQueue::Clear() {
+
+	packets_.clear();
+
+	keys_.clear();
+
+}
+
+void DrawQueue::Push(uint64_t sortKey, const DrawPacket& packet) {
+
+	packets_.push_back(packet);
+
+	keys_.push_back(sortKey);
+
+}
+
+void DrawQueue::Sort(JobSystem* jobSystem) {
+
+	size_t count = packets_.size();
+
+	order_.resize(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		order_[i] = static_cast<uint32_t>(i);
+	}
+
+	tempKeys_.resize(count);
+
+	tempOrder_.resize(count);
+
+	RadixSort(keys_.data(), order_.data(), tempKeys_.data(), tempOrder_.data(), count, jobSystem);
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class JobSystem;
+
+//描画パス(キーの最上位に入る)
+enum class DrawPass : uint32_t {
+	kOpaque = 0,
+	kTransparent = 1,
+};
+
+//1回の描画に必要な情報
+struct DrawPacket {
+
+	uint32_t objectIndex;
+	uint32_t materialIndex;
+	uint32_t pipelineIndex;
+	uint32_t color;
+	uint32_t indexCount;
+	uint32_t startIndex;
+	int32_t baseVertex;
+
+};
+
+//64bitのソートキーを作る
+//[63:60]パス [59:48]PSO [47:32]マテリアル [31:16]深度 [15:0]予備
+//不透明は手前から奥へ、半透明は奥から手前へ並ぶように深度を入れる
+uint64_t MakeDrawSortKey(DrawPass pass, uint32_t pipelineIndex, uint32_t materialIndex, float viewDepth, float nearClip, float farClip);
+
+//キーからパスを取り出す
+inline DrawPass GetDrawSortKeyPass(uint64_t sortKey) { return static_cast<DrawPass>(sortKey >> 60); }
+
+//キーの下位から8bitずつ並べ替える基数ソート(安定)
+//一時領域はcountぶん必要で、結果はkeys/valuesに入る
+void RadixSort(uint64_t* keys, uint32_t* values, uint64_t* tempKeys, uint32_t* tempValues, size_t count, JobSystem* jobSystem);
+
+//フレームごとに描画を積んで、キーの順に並べて取り出す
+class DrawQueue {
+
+public:
+
+	void Clear();
+
+	void Push(uint64_t sortKey, const DrawPacket& packet);
+
+	void Sort(JobSystem* jobSystem);
+
+	size_t GetCount() const { return packets_.size(); }
+
+	//並べ替えた後のi番目の描画
+	const DrawPacket& Get(size_t index) const { return packets_[order_[index]]; }
+
+	//並べ替えた後のi番目のキー
+	uint64_t GetSortKey(size_t index) const { return keys_[index]; }
+
+private:
+
+	std::vector<DrawPacket> packets_;
+
+	std::vector<uint64_t> keys_;
+
+	std::vector<uint32_t> order_;
+
+	std::vector<uint64_t> tempKeys_;
+
+	std::vector<uint32_t> tempOrder_;
+
+};
@@ -0,0 +1,329 @@
+#include "EntityWorld.h"
+#include <cassert>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+	std::mutex componentTypeMutex;
+
+	std::vector<ComponentTypeInfo>& GetComponentTypes() {
+		static std::vector<ComponentTypeInfo> componentTypes;
+		return componentTypes;
+	}
+
+	size_t AlignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+}
+
+uint32_t RegisterComponentType(size_t size, size_t alignment) {
+
+	std::lock_guard<std::mutex> lock(componentTypeMutex);
+
+	std::vector<ComponentTypeInfo>& componentTypes = GetComponentTypes();
+
+	assert(componentTypes.size() < kMaxComponentTypes);
+
+	//チャンクはnew[]で確保するので、それ以上の整列は扱わない
+	assert(alignment <= alignof(std::max_align_t));
+
+	componentTypes.push_back({ size, alignment });
+
+	return static_cast<uint32_t>(componentTypes.size() - 1);
+
+}
+
+ComponentTypeInfo GetComponentTypeInfo(uint32_t typeId) {
+
+	std::lock_guard<std::mutex> lock(componentTypeMutex);
+
+	return GetComponentTypes()[typeId];
+
+}
+
+EntityWorld::EntityWorld() {
+}
+
+EntityWorld::~EntityWorld() {
+}
+
+EntityWorld::Archetype* EntityWorld::GetOrCreateArchetype(uint64_t mask) {
+
+	auto found = archetypeMap_.find(mask);
+	if (found != archetypeMap_.end()) {
+		return found->second;
+	}
+
+	std::unique_ptr<Archetype> archetype = std::make_unique<Archetype>();
+
+	archetype->mask = mask;
+
+	size_t rowSize = sizeof(Entity);
+
+	for (uint32_t typeId = 0; typeId < kMaxComponentTypes; ++typeId) {
+
+		archetype->offsets[typeId] = SIZE_MAX;
+		archetype->sizes[typeId] = 0;
+
+		if (mask & (1ull << typeId)) {
+			archetype->typeIds.push_back(typeId);
+			archetype->sizes[typeId] = GetComponentTypeInfo(typeId).size;
+			rowSize += archetype->sizes[typeId];
+		}
+
+	}
+
+	//先頭にEntityの配列、その後にコンポーネントごとの配列を整列して並べる。入りきらなければ行数を減らす
+	uint32_t capacity = static_cast<uint32_t>(kChunkSize / rowSize);
+
+	for (;;) {
+
+		assert(capacity > 0);
+
+		size_t offset = sizeof(Entity) * capacity;
+
+		for (uint32_t typeId : archetype->typeIds) {
+
+			ComponentTypeInfo info = GetComponentTypeInfo(typeId);
+
+			offset = AlignUp(offset, info.alignment);
+
+			archetype->offsets[typeId] = offset;
+
+			offset += info.size * capacity;
+
+		}
+
+		if (offset <= kChunkSize) {
+			break;
+		}
+
+		--capacity;
+
+	}
+
+	archetype->capacity = capacity;
+
+	Archetype* result = archetype.get();
+
+	archetypes_.push_back(std::move(archetype));
+
+	archetypeMap_[mask] = result;
+
+	return result;
+
+}
+
+void EntityWorld::AllocateRow(Archetype& archetype, uint32_t& chunkIndex, uint32_t& row) {
+
+	if (archetype.chunks.empty() || archetype.chunks.back().count == archetype.capacity) {
+
+		Chunk chunk;
+		chunk.data.reset(new uint8_t[kChunkSize]);
+		chunk.count = 0;
+
+		archetype.chunks.push_back(std::move(chunk));
+
+	}
+
+	chunkIndex = static_cast<uint32_t>(archetype.chunks.size() - 1);
+
+	row = archetype.chunks.back().count++;
+
+}
+
+void EntityWorld::RemoveRow(Archetype& archetype, uint32_t chunkIndex, uint32_t row) {
+
+	uint32_t lastChunkIndex = static_cast<uint32_t>(archetype.chunks.size() - 1);
+
+	Chunk& lastChunk = archetype.chunks[lastChunkIndex];
+
+	uint32_t lastRow = lastChunk.count - 1;
+
+	//末尾の行を穴に移して、配列を詰めたままにする
+	if (chunkIndex != lastChunkIndex || row != lastRow) {
+
+		Chunk& chunk = archetype.chunks[chunkIndex];
+
+		Entity movedEntity = GetEntities(archetype, lastChunk)[lastRow];
+
+		GetEntities(archetype, chunk)[row] = movedEntity;
+
+		for (uint32_t typeId : archetype.typeIds) {
+
+			size_t size = archetype.sizes[typeId];
+
+			std::memcpy(static_cast<uint8_t*>(GetArray(archetype, chunk, typeId)) + size * row, static_cast<uint8_t*>(GetArray(archetype, lastChunk, typeId)) + size * lastRow, size);
+
+		}
+
+		records_[movedEntity.index].chunkIndex = chunkIndex;
+		records_[movedEntity.index].row = row;
+
+	}
+
+	--lastChunk.count;
+
+	if (lastChunk.count == 0) {
+		archetype.chunks.pop_back();
+	}
+
+}
+
+Entity EntityWorld::CreateEntity(uint64_t componentMask) {
+
+	uint32_t index;
+
+	if (!freeIndices_.empty()) {
+		index = freeIndices_.back();
+		freeIndices_.pop_back();
+	} else {
+		index = static_cast<uint32_t>(records_.size());
+		records_.push_back({ nullptr, 0, 0, 1 });
+	}
+
+	EntityRecord& record = records_[index];
+
+	Entity entity = { index, record.generation };
+
+	record.archetype = GetOrCreateArchetype(componentMask);
+
+	AllocateRow(*record.archetype, record.chunkIndex, record.row);
+
+	GetEntities(*record.archetype, record.archetype->chunks[record.chunkIndex])[record.row] = entity;
+
+	++aliveCount_;
+
+	return entity;
+
+}
+
+void EntityWorld::DestroyEntity(Entity entity) {
+
+	if (!IsAlive(entity)) {
+		return;
+	}
+
+	EntityRecord& record = records_[entity.index];
+
+	RemoveRow(*record.archetype, record.chunkIndex, record.row);
+
+	record.archetype = nullptr;
+
+	//世代を進めて、古いハンドルを無効にする
+	++record.generation;
+
+	freeIndices_.push_back(entity.index);
+
+	--aliveCount_;
+
+}
+
+bool EntityWorld::IsAlive(Entity entity) const {
+	return entity.index < records_.size() && records_[entity.index].generation == entity.generation && records_[entity.index].archetype != nullptr;
+}
+
+uint64_t EntityWorld::GetComponentMask(Entity entity) const {
+
+	if (!IsAlive(entity)) {
+		return 0;
+	}
+
+	return records_[entity.index].archetype->mask;
+
+}
+
+void EntityWorld::ChangeArchetype(Entity entity, uint64_t newMask) {
+
+	assert(IsAlive(entity));
+
+	EntityRecord& record = records_[entity.index];
+
+	Archetype* oldArchetype = record.archetype;
+
+	if (oldArchetype->mask == newMask) {
+		return;
+	}
+
+	Archetype* newArchetype = GetOrCreateArchetype(newMask);
+
+	uint32_t newChunkIndex;
+	uint32_t newRow;
+
+	AllocateRow(*newArchetype, newChunkIndex, newRow);
+
+	Chunk& oldChunk = oldArchetype->chunks[record.chunkIndex];
+	Chunk& newChunk = newArchetype->chunks[newChunkIndex];
+
+	GetEntities(*newArchetype, newChunk)[newRow] = entity;
+
+	//両方にあるコンポーネントだけ移す
+	for (uint32_t typeId : newArchetype->typeIds) {
+
+		if ((oldArchetype->mask & (1ull << typeId)) == 0) {
+			continue;
+		}
+
+		size_t size = newArchetype->sizes[typeId];
+
+		std::memcpy(static_cast<uint8_t*>(GetArray(*newArchetype, newChunk, typeId)) + size * newRow, static_cast<uint8_t*>(GetArray(*oldArchetype, oldChunk, typeId)) + size * record.row, size);
+
+	}
+
+	RemoveRow(*oldArchetype, record.chunkIndex, record.row);
+
+	record.archetype = newArchetype;
+	record.chunkIndex = newChunkIndex;
+	record.row = newRow;
+
+}
+
+void EntityWorld::SetComponentData(Entity entity, uint32_t typeId, const void* data) {
+
+	void* component = GetComponentData(entity, typeId);
+
+	assert(component != nullptr);
+
+	std::memcpy(component, data, records_[entity.index].archetype->sizes[typeId]);
+
+}
+
+void* EntityWorld::GetComponentData(Entity entity, uint32_t typeId) {
+
+	if (!IsAlive(entity)) {
+		return nullptr;
+	}
+
+	const EntityRecord& record = records_[entity.index];
+
+	if ((record.archetype->mask & (1ull << typeId)) == 0) {
+		return nullptr;
+	}
+
+	size_t size = record.archetype->sizes[typeId];
+
+	return static_cast<uint8_t*>(GetArray(*record.archetype, record.archetype->chunks[record.chunkIndex], typeId)) + size * record.row;
+
+}
+
+void EntityWorld::CollectChunks(uint64_t mask) {
+
+	chunkReferences_.clear();
+
+	for (const std::unique_ptr<Archetype>& archetype : archetypes_) {
+
+		if ((archetype->mask & mask) != mask) {
+			continue;
+		}
+
+		for (Chunk& chunk : archetype->chunks) {
+			if (chunk.count > 0) {
+				chunkReferences_.push_back({ archetype.get(), &chunk });
+			}
+		}
+
+	}
+
+}
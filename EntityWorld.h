@@ -0,0 +1,269 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include "JobSystem.h"
+
+//エンティティ(世代番号で破棄済みのものと区別する)
+struct Entity {
+
+	uint32_t index;
+	uint32_t generation;
+
+	bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const Entity& other) const { return !(*this == other); }
+
+};
+
+const Entity kInvalidEntity = { 0xffffffff, 0 };
+
+//コンポーネントの型の情報(型ごとに0から順に番号を振る。最大64種類)
+struct ComponentTypeInfo {
+
+	size_t size;
+	size_t alignment;
+
+};
+
+const uint32_t kMaxComponentTypes = 64;
+
+uint32_t RegisterComponentType(size_t size, size_t alignment);
+
+ComponentTypeInfo GetComponentTypeInfo(uint32_t typeId);
+
+template<typename T>
+uint32_t GetComponentTypeId() {
+
+	//チャンク間はmemcpyで移すので、コンポーネントはそのままコピーできる型に限る
+	static_assert(std::is_trivially_copyable<T>::value, "components must be trivially copyable");
+
+	static const uint32_t typeId = RegisterComponentType(sizeof(T), alignof(T));
+
+	return typeId;
+
+}
+
+template<typename... Ts>
+uint64_t MakeComponentMask() {
+	return (0ull | ... | (1ull << GetComponentTypeId<Ts>()));
+}
+
+//コンポーネントの組み合わせ(アーキタイプ)ごとに、固定サイズのチャンクへ成分ごとに詰めて持つ
+//クエリは条件に合うアーキタイプのチャンクを順に回るので、配列を先頭から読むだけになる
+class EntityWorld {
+
+public:
+
+	//1つのチャンクの大きさ
+	static const size_t kChunkSize = 16 * 1024;
+
+	EntityWorld();
+
+	~EntityWorld();
+
+	EntityWorld(const EntityWorld&) = delete;
+
+	EntityWorld& operator=(const EntityWorld&) = delete;
+
+	template<typename... Ts>
+	Entity CreateEntity(const Ts&... components) {
+
+		Entity entity = CreateEntity(MakeComponentMask<Ts...>());
+
+		(SetComponentData(entity, GetComponentTypeId<Ts>(), &components), ...);
+
+		return entity;
+
+	}
+
+	//コンポーネントを持たないエンティティも作れる(後からAddComponentする)
+	Entity CreateEntity(uint64_t componentMask);
+
+	void DestroyEntity(Entity entity);
+
+	bool IsAlive(Entity entity) const;
+
+	template<typename T>
+	void AddComponent(Entity entity, const T& component) {
+
+		uint32_t typeId = GetComponentTypeId<T>();
+
+		ChangeArchetype(entity, GetComponentMask(entity) | (1ull << typeId));
+
+		SetComponentData(entity, typeId, &component);
+
+	}
+
+	template<typename T>
+	void RemoveComponent(Entity entity) {
+		ChangeArchetype(entity, GetComponentMask(entity) & ~(1ull << GetComponentTypeId<T>()));
+	}
+
+	template<typename T>
+	bool HasComponent(Entity entity) const {
+		return (GetComponentMask(entity) & (1ull << GetComponentTypeId<T>())) != 0;
+	}
+
+	//持っていなければnullptr(構造が変わると指す先も変わる)
+	template<typename T>
+	T* GetComponent(Entity entity) {
+		return static_cast<T*>(GetComponentData(entity, GetComponentTypeId<T>()));
+	}
+
+	uint64_t GetComponentMask(Entity entity) const;
+
+	size_t GetEntityCount() const { return aliveCount_; }
+
+	size_t GetArchetypeCount() const { return archetypes_.size(); }
+
+	//条件に合うチャンクごとにfunction(entities, count, Ts* ...)を呼ぶ
+	template<typename... Ts, typename Function>
+	void ForEachChunk(const Function& function) {
+
+		uint64_t mask = MakeComponentMask<Ts...>();
+
+		for (const std::unique_ptr<Archetype>& archetype : archetypes_) {
+
+			if ((archetype->mask & mask) != mask) {
+				continue;
+			}
+
+			for (Chunk& chunk : archetype->chunks) {
+				if (chunk.count > 0) {
+					function(GetEntities(*archetype, chunk), static_cast<size_t>(chunk.count), static_cast<Ts*>(GetArray(*archetype, chunk, GetComponentTypeId<Ts>()))...);
+				}
+			}
+
+		}
+
+	}
+
+	//条件に合うエンティティごとにfunction(Ts& ...)を呼ぶ
+	template<typename... Ts, typename Function>
+	void ForEach(const Function& function) {
+
+		ForEachChunk<Ts...>([&](const Entity*, size_t count, Ts*... arrays) {
+			for (size_t i = 0; i < count; ++i) {
+				function(arrays[i]...);
+			}
+		});
+
+	}
+
+	//チャンクを単位にジョブシステムへ分けてfunction(Ts& ...)を呼ぶ(同じエンティティを別のスレッドが触ることはない)
+	//functionの中でエンティティの追加や削除、コンポーネントの付け外しはしないこと
+	template<typename... Ts, typename Function>
+	void ParallelForEach(JobSystem* jobSystem, const Function& function) {
+
+		uint64_t mask = MakeComponentMask<Ts...>();
+
+		CollectChunks(mask);
+
+		auto runArrays = [&](size_t count, Ts*... arrays) {
+			for (size_t i = 0; i < count; ++i) {
+				function(arrays[i]...);
+			}
+		};
+
+		auto runChunk = [&](size_t index) {
+			const ChunkReference& reference = chunkReferences_[index];
+			runArrays(static_cast<size_t>(reference.chunk->count), static_cast<Ts*>(GetArray(*reference.archetype, *reference.chunk, GetComponentTypeId<Ts>()))...);
+		};
+
+		if (jobSystem == nullptr) {
+			for (size_t i = 0; i < chunkReferences_.size(); ++i) {
+				runChunk(i);
+			}
+			return;
+		}
+
+		jobSystem->Dispatch(static_cast<uint32_t>(chunkReferences_.size()), [&](uint32_t chunkIndex) {
+			runChunk(chunkIndex);
+		});
+
+	}
+
+private:
+
+	struct Chunk {
+
+		std::unique_ptr<uint8_t[]> data;
+		uint32_t count;
+
+	};
+
+	struct Archetype {
+
+		uint64_t mask;
+
+		//チャンクの中での各コンポーネントの配列の位置(持っていない型はSIZE_MAX)
+		size_t offsets[kMaxComponentTypes];
+
+		//各コンポーネントの大きさ(型の情報を毎回引かないように持っておく)
+		size_t sizes[kMaxComponentTypes];
+
+		uint32_t capacity;
+
+		std::vector<uint32_t> typeIds;
+
+		std::vector<Chunk> chunks;
+
+	};
+
+	//エンティティがどこにいるか
+	struct EntityRecord {
+
+		Archetype* archetype;
+		uint32_t chunkIndex;
+		uint32_t row;
+		uint32_t generation;
+
+	};
+
+	struct ChunkReference {
+
+		Archetype* archetype;
+		Chunk* chunk;
+
+	};
+
+	Archetype* GetOrCreateArchetype(uint64_t mask);
+
+	//アーキタイプの末尾に1行確保する
+	void AllocateRow(Archetype& archetype, uint32_t& chunkIndex, uint32_t& row);
+
+	//行を消して、末尾の行で穴を埋める
+	void RemoveRow(Archetype& archetype, uint32_t chunkIndex, uint32_t row);
+
+	void ChangeArchetype(Entity entity, uint64_t newMask);
+
+	void SetComponentData(Entity entity, uint32_t typeId, const void* data);
+
+	void* GetComponentData(Entity entity, uint32_t typeId);
+
+	void CollectChunks(uint64_t mask);
+
+	static Entity* GetEntities(const Archetype&, const Chunk& chunk) {
+		return reinterpret_cast<Entity*>(chunk.data.get());
+	}
+
+	static void* GetArray(const Archetype& archetype, const Chunk& chunk, uint32_t typeId) {
+		return chunk.data.get() + archetype.offsets[typeId];
+	}
+
+	std::vector<std::unique_ptr<Archetype>> archetypes_;
+
+	std::unordered_map<uint64_t, Archetype*> archetypeMap_;
+
+	std::vector<EntityRecord> records_;
+
+	std::vector<uint32_t> freeIndices_;
+
+	size_t aliveCount_ = 0;
+
+	std::vector<ChunkReference> chunkReferences_;
+
+};
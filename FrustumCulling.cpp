@@ -0,0 +1,474 @@
+#include "FrustumCulling.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//FRUSTUM_CULLING_NO_SIMDを定義するとSIMDを使わない(テストで結果が同じことを確かめる)
+#if defined(__AVX__) && !defined(FRUSTUM_CULLING_NO_SIMD)
+#include <immintrin.h>
+#define FRUSTUM_CULLING_USE_AVX
+#elif (defined(_M_X64) || defined(__SSE2__)) && !defined(FRUSTUM_CULLING_NO_SIMD)
+#include <emmintrin.h>
+#define FRUSTUM_CULLING_USE_SSE2
+#endif
+
+namespace {
+
+	//1つの塊で判定する最小の数
+	const size_t kMinCullChunkSize = 4096;
+
+	Vector4 NormalizePlane(float a, float b, float c, float d) {
+
+		float length = std::sqrt(a * a + b * b + c * c);
+
+		float inverseLength = length > 0.0f ? 1.0f / length : 0.0f;
+
+		return { a * inverseLength, b * inverseLength, c * inverseLength, d * inverseLength };
+
+	}
+
+	bool IsSphereVisible(const Frustum& frustum, float x, float y, float z, float radius) {
+
+		//SIMDと同じ順に足す(どのビルドでも境界上の判定が一致する)
+		for (const Vector4& plane : frustum.planes) {
+			if ((plane.x * x + plane.y * y) + (plane.z * z + plane.w) < -radius) {
+				return false;
+			}
+		}
+
+		return true;
+
+	}
+
+	bool IsAABBVisible(const Frustum& frustum, float x, float y, float z, float extentX, float extentY, float extentZ) {
+
+		for (const Vector4& plane : frustum.planes) {
+			float distance = (plane.x * x + plane.y * y) + (plane.z * z + plane.w);
+			float radius = std::fabs(plane.x) * extentX + std::fabs(plane.y) * extentY + std::fabs(plane.z) * extentZ;
+			if (distance + radius < 0.0f) {
+				return false;
+			}
+		}
+
+		return true;
+
+	}
+
+#if defined(FRUSTUM_CULLING_USE_AVX) || defined(FRUSTUM_CULLING_USE_SSE2)
+
+	//マスクの立っているレーンのインデックスを分岐なしで詰める
+	size_t WriteVisibleIndices(uint32_t mask, uint32_t laneCount, uint32_t baseIndex, uint32_t* visibleIndices) {
+
+		size_t count = 0;
+
+		for (uint32_t lane = 0; lane < laneCount; ++lane) {
+			visibleIndices[count] = baseIndex + lane;
+			count += (mask >> lane) & 1;
+		}
+
+		return count;
+
+	}
+
+#endif
+
+	//塊ごとに判定して、結果を前に詰める
+	template<typename Bounds, typename Cull>
+	size_t ParallelCull(const Bounds& bounds, uint32_t* visibleIndices, JobSystem* jobSystem, const Cull& cull) {
+
+		size_t count = bounds.GetCount();
+
+		if (count == 0) {
+			return 0;
+		}
+
+		uint32_t chunkCount = 1;
+
+		if (jobSystem != nullptr) {
+			chunkCount = jobSystem->GetChunkCount(count, kMinCullChunkSize);
+		}
+
+		if (chunkCount <= 1) {
+			return cull(0, count, visibleIndices);
+		}
+
+		size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+		//各塊は自分の開始位置から書き、最後に順番に詰める
+		std::vector<size_t> chunkVisibleCounts(chunkCount, 0);
+
+		jobSystem->Dispatch(chunkCount, [&](uint32_t chunkIndex) {
+			size_t begin = chunkIndex * chunkSize;
+			size_t end = (std::min)(begin + chunkSize, count);
+			if (begin < end) {
+				chunkVisibleCounts[chunkIndex] = cull(begin, end, visibleIndices + begin);
+			}
+		});
+
+		size_t visibleCount = chunkVisibleCounts[0];
+
+		for (uint32_t chunkIndex = 1; chunkIndex < chunkCount; ++chunkIndex) {
+			size_t begin = chunkIndex * chunkSize;
+			std::memmove(visibleIndices + visibleCount, visibleIndices + begin, sizeof(uint32_t) * chunkVisibleCounts[chunkIndex]);
+			visibleCount += chunkVisibleCounts[chunkIndex];
+		}
+
+		return visibleCount;
+
+	}
+
+}
+
+Frustum MakeFrustum(const Matrix4x4& viewProjectionMatrix) {
+
+	//行ベクトル×行列なので、クリップ座標の各成分は行列の列との内積になる
+	const float(&m)[4][4] = viewProjectionMatrix.m;
+
+	Frustum frustum;
+
+	//左右(-w <= x <= w)
+	frustum.planes[0] = NormalizePlane(m[0][3] + m[0][0], m[1][3] + m[1][0], m[2][3] + m[2][0], m[3][3] + m[3][0]);
+	frustum.planes[1] = NormalizePlane(m[0][3] - m[0][0], m[1][3] - m[1][0], m[2][3] - m[2][0], m[3][3] - m[3][0]);
+
+	//上下(-w <= y <= w)
+	frustum.planes[2] = NormalizePlane(m[0][3] + m[0][1], m[1][3] + m[1][1], m[2][3] + m[2][1], m[3][3] + m[3][1]);
+	frustum.planes[3] = NormalizePlane(m[0][3] - m[0][1], m[1][3] - m[1][1], m[2][3] - m[2][1], m[3][3] - m[3][1]);
+
+	//reversed-Zなので近クリップ面がz <= w、遠クリップ面が0 <= z
+	frustum.planes[4] = NormalizePlane(m[0][3] - m[0][2], m[1][3] - m[1][2], m[2][3] - m[2][2], m[3][3] - m[3][2]);
+	frustum.planes[5] = NormalizePlane(m[0][2], m[1][2], m[2][2], m[3][2]);
+
+	return frustum;
+
+}
+
+BoundingSphere MakeBoundingSphere(const Vector4* positions, size_t count) {
+
+	if (count == 0) {
+		return { { 0.0f, 0.0f, 0.0f }, 0.0f };
+	}
+
+	Vector3 min = { positions[0].x, positions[0].y, positions[0].z };
+	Vector3 max = min;
+
+	for (size_t i = 1; i < count; ++i) {
+		min.x = (std::min)(min.x, positions[i].x);
+		min.y = (std::min)(min.y, positions[i].y);
+		min.z = (std::min)(min.z, positions[i].z);
+		max.x = (std::max)(max.x, positions[i].x);
+		max.y = (std::max)(max.y, positions[i].y);
+		max.z = (std::max)(max.z, positions[i].z);
+	}
+
+	BoundingSphere sphere{};
+
+	sphere.center = { (min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f };
+
+	float radiusSquared = 0.0f;
+
+	for (size_t i = 0; i < count; ++i) {
+		float x = positions[i].x - sphere.center.x;
+		float y = positions[i].y - sphere.center.y;
+		float z = positions[i].z - sphere.center.z;
+		radiusSquared = (std::max)(radiusSquared, x * x + y * y + z * z);
+	}
+
+	sphere.radius = std::sqrt(radiusSquared);
+
+	return sphere;
+
+}
+
+BoundingSphere TransformBoundingSphere(const BoundingSphere& sphere, const Matrix4x4& matrix) {
+
+	const float(&m)[4][4] = matrix.m;
+
+	BoundingSphere result{};
+
+	result.center.x = sphere.center.x * m[0][0] + sphere.center.y * m[1][0] + sphere.center.z * m[2][0] + m[3][0];
+	result.center.y = sphere.center.x * m[0][1] + sphere.center.y * m[1][1] + sphere.center.z * m[2][1] + m[3][1];
+	result.center.z = sphere.center.x * m[0][2] + sphere.center.y * m[1][2] + sphere.center.z * m[2][2] + m[3][2];
+
+	float scaleSquared = 0.0f;
+
+	for (int i = 0; i < 3; ++i) {
+		scaleSquared = (std::max)(scaleSquared, m[i][0] * m[i][0] + m[i][1] * m[i][1] + m[i][2] * m[i][2]);
+	}
+
+	result.radius = sphere.radius * std::sqrt(scaleSquared);
+
+	return result;
+
+}
+
+AABB TransformAABB(const AABB& aabb, const Matrix4x4& matrix) {
+
+	const float(&m)[4][4] = matrix.m;
+
+	float center[3] = { (aabb.min.x + aabb.max.x) * 0.5f, (aabb.min.y + aabb.max.y) * 0.5f, (aabb.min.z + aabb.max.z) * 0.5f };
+	float extent[3] = { (aabb.max.x - aabb.min.x) * 0.5f, (aabb.max.y - aabb.min.y) * 0.5f, (aabb.max.z - aabb.min.z) * 0.5f };
+
+	float resultCenter[3];
+	float resultExtent[3];
+
+	//中心は普通に変換し、大きさは行列の絶対値で広げる
+	for (int j = 0; j < 3; ++j) {
+		resultCenter[j] = center[0] * m[0][j] + center[1] * m[1][j] + center[2] * m[2][j] + m[3][j];
+		resultExtent[j] = extent[0] * std::fabs(m[0][j]) + extent[1] * std::fabs(m[1][j]) + extent[2] * std::fabs(m[2][j]);
+	}
+
+	AABB result{};
+
+	result.min = { resultCenter[0] - resultExtent[0], resultCenter[1] - resultExtent[1], resultCenter[2] - resultExtent[2] };
+	result.max = { resultCenter[0] + resultExtent[0], resultCenter[1] + resultExtent[1], resultCenter[2] + resultExtent[2] };
+
+	return result;
+
+}
+
+void BoundingSphereArray::Resize(size_t count) {
+
+	centerX_.resize(count);
+	centerY_.resize(count);
+	centerZ_.resize(count);
+	radius_.resize(count);
+
+}
+
+void BoundingSphereArray::Set(size_t index, const BoundingSphere& sphere) {
+
+	centerX_[index] = sphere.center.x;
+	centerY_[index] = sphere.center.y;
+	centerZ_[index] = sphere.center.z;
+	radius_[index] = sphere.radius;
+
+}
+
+void AABBArray::Resize(size_t count) {
+
+	centerX_.resize(count);
+	centerY_.resize(count);
+	centerZ_.resize(count);
+	extentX_.resize(count);
+	extentY_.resize(count);
+	extentZ_.resize(count);
+
+}
+
+void AABBArray::Set(size_t index, const AABB& aabb) {
+
+	centerX_[index] = (aabb.min.x + aabb.max.x) * 0.5f;
+	centerY_[index] = (aabb.min.y + aabb.max.y) * 0.5f;
+	centerZ_[index] = (aabb.min.z + aabb.max.z) * 0.5f;
+	extentX_[index] = (aabb.max.x - aabb.min.x) * 0.5f;
+	extentY_[index] = (aabb.max.y - aabb.min.y) * 0.5f;
+	extentZ_[index] = (aabb.max.z - aabb.min.z) * 0.5f;
+
+}
+
+size_t CullSpheres(const Frustum& frustum, const BoundingSphereArray& spheres, size_t begin, size_t end, uint32_t* visibleIndices) {
+
+	const float* centerX = spheres.GetCenterX();
+	const float* centerY = spheres.GetCenterY();
+	const float* centerZ = spheres.GetCenterZ();
+	const float* radius = spheres.GetRadius();
+
+	size_t visibleCount = 0;
+
+	size_t i = begin;
+
+#if defined(FRUSTUM_CULLING_USE_AVX)
+
+	//8つの球を6平面と同時に判定する
+	__m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+
+	for (int p = 0; p < 6; ++p) {
+		planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+	}
+
+	for (; i + 8 <= end; i += 8) {
+
+		__m256 x = _mm256_loadu_ps(centerX + i);
+		__m256 y = _mm256_loadu_ps(centerY + i);
+		__m256 z = _mm256_loadu_ps(centerZ + i);
+		__m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+
+		__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (int p = 0; p < 6; ++p) {
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)), _mm256_add_ps(_mm256_mul_ps(planeZ[p], z), planeW[p]));
+			visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+		}
+
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(visible));
+
+		visibleCount += WriteVisibleIndices(mask, 8, static_cast<uint32_t>(i), visibleIndices + visibleCount);
+
+	}
+
+#elif defined(FRUSTUM_CULLING_USE_SSE2)
+
+	//4つの球を6平面と同時に判定する
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+
+	for (int p = 0; p < 6; ++p) {
+		planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+	}
+
+	for (; i + 4 <= end; i += 4) {
+
+		__m128 x = _mm_loadu_ps(centerX + i);
+		__m128 y = _mm_loadu_ps(centerY + i);
+		__m128 z = _mm_loadu_ps(centerZ + i);
+		__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+		__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		for (int p = 0; p < 6; ++p) {
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)), _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+			visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(visible));
+
+		visibleCount += WriteVisibleIndices(mask, 4, static_cast<uint32_t>(i), visibleIndices + visibleCount);
+
+	}
+
+#endif
+
+	//SIMDの幅に満たない残り
+	for (; i < end; ++i) {
+		if (IsSphereVisible(frustum, centerX[i], centerY[i], centerZ[i], radius[i])) {
+			visibleIndices[visibleCount++] = static_cast<uint32_t>(i);
+		}
+	}
+
+	return visibleCount;
+
+}
+
+size_t CullAABBs(const Frustum& frustum, const AABBArray& aabbs, size_t begin, size_t end, uint32_t* visibleIndices) {
+
+	const float* centerX = aabbs.GetCenterX();
+	const float* centerY = aabbs.GetCenterY();
+	const float* centerZ = aabbs.GetCenterZ();
+	const float* extentX = aabbs.GetExtentX();
+	const float* extentY = aabbs.GetExtentY();
+	const float* extentZ = aabbs.GetExtentZ();
+
+	size_t visibleCount = 0;
+
+	size_t i = begin;
+
+#if defined(FRUSTUM_CULLING_USE_AVX)
+
+	//法線の絶対値と大きさの内積が、平面方向に投影した箱の半径になる
+	__m256 planeX[6], planeY[6], planeZ[6], planeW[6], absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+
+	for (int p = 0; p < 6; ++p) {
+		planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+		absPlaneX[p] = _mm256_set1_ps(std::fabs(frustum.planes[p].x));
+		absPlaneY[p] = _mm256_set1_ps(std::fabs(frustum.planes[p].y));
+		absPlaneZ[p] = _mm256_set1_ps(std::fabs(frustum.planes[p].z));
+	}
+
+	for (; i + 8 <= end; i += 8) {
+
+		__m256 x = _mm256_loadu_ps(centerX + i);
+		__m256 y = _mm256_loadu_ps(centerY + i);
+		__m256 z = _mm256_loadu_ps(centerZ + i);
+		__m256 ex = _mm256_loadu_ps(extentX + i);
+		__m256 ey = _mm256_loadu_ps(extentY + i);
+		__m256 ez = _mm256_loadu_ps(extentZ + i);
+
+		__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (int p = 0; p < 6; ++p) {
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)), _mm256_add_ps(_mm256_mul_ps(planeZ[p], z), planeW[p]));
+			__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absPlaneX[p], ex), _mm256_mul_ps(absPlaneY[p], ey)), _mm256_mul_ps(absPlaneZ[p], ez));
+			visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(visible));
+
+		visibleCount += WriteVisibleIndices(mask, 8, static_cast<uint32_t>(i), visibleIndices + visibleCount);
+
+	}
+
+#elif defined(FRUSTUM_CULLING_USE_SSE2)
+
+	//法線の絶対値と大きさの内積が、平面方向に投影した箱の半径になる
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6], absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+
+	for (int p = 0; p < 6; ++p) {
+		planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+		absPlaneX[p] = _mm_set1_ps(std::fabs(frustum.planes[p].x));
+		absPlaneY[p] = _mm_set1_ps(std::fabs(frustum.planes[p].y));
+		absPlaneZ[p] = _mm_set1_ps(std::fabs(frustum.planes[p].z));
+	}
+
+	for (; i + 4 <= end; i += 4) {
+
+		__m128 x = _mm_loadu_ps(centerX + i);
+		__m128 y = _mm_loadu_ps(centerY + i);
+		__m128 z = _mm_loadu_ps(centerZ + i);
+		__m128 ex = _mm_loadu_ps(extentX + i);
+		__m128 ey = _mm_loadu_ps(extentY + i);
+		__m128 ez = _mm_loadu_ps(extentZ + i);
+
+		__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		for (int p = 0; p < 6; ++p) {
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)), _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absPlaneX[p], ex), _mm_mul_ps(absPlaneY[p], ey)), _mm_mul_ps(absPlaneZ[p], ez));
+			visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+		}
+
+		uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(visible));
+
+		visibleCount += WriteVisibleIndices(mask, 4, static_cast<uint32_t>(i), visibleIndices + visibleCount);
+
+	}
+
+#endif
+
+	//SIMDの幅に満たない残り
+	for (; i < end; ++i) {
+		if (IsAABBVisible(frustum, centerX[i], centerY[i], centerZ[i], extentX[i], extentY[i], extentZ[i])) {
+			visibleIndices[visibleCount++] = static_cast<uint32_t>(i);
+		}
+	}
+
+	return visibleCount;
+
+}
+
+size_t FrustumCull(const Frustum& frustum, const BoundingSphereArray& spheres, uint32_t* visibleIndices, JobSystem* jobSystem) {
+
+	return ParallelCull(spheres, visibleIndices, jobSystem, [&](size_t begin, size_t end, uint32_t* output) {
+		return CullSpheres(frustum, spheres, begin, end, output);
+	});
+
+}
+
+size_t FrustumCull(const Frustum& frustum, const AABBArray& aabbs, uint32_t* visibleIndices, JobSystem* jobSystem) {
+
+	return ParallelCull(aabbs, visibleIndices, jobSystem, [&](size_t begin, size_t end, uint32_t* output) {
+		return CullAABBs(frustum, aabbs, begin, end, output);
+	});
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "MathTypes.h"
+
+class JobSystem;
+
+//バウンディングスフィア
+struct BoundingSphere {
+
+	Vector3 center;
+	float radius;
+
+};
+
+//軸平行バウンディングボックス
+struct AABB {
+
+	Vector3 min;
+	Vector3 max;
+
+};
+
+//視錐台の6平面(xyzが内向きの法線、wが距離。内側でdot(n,p)+w>=0)
+struct Frustum {
+
+	Vector4 planes[6];
+
+};
+
+//ビュープロジェクション行列から視錐台を取り出す(reversed-Z前提)
+Frustum MakeFrustum(const Matrix4x4& viewProjectionMatrix);
+
+//頂点から囲む球を作る(AABBの中心と最も遠い頂点)
+BoundingSphere MakeBoundingSphere(const Vector4* positions, size_t count);
+
+//ワールド行列で変換する(半径は最大の拡大率で広げる)
+BoundingSphere TransformBoundingSphere(const BoundingSphere& sphere, const Matrix4x4& matrix);
+
+//ワールド行列で変換したものを囲むAABB
+AABB TransformAABB(const AABB& aabb, const Matrix4x4& matrix);
+
+//SIMDで4つ/8つずつ読めるように成分ごとに並べた球の配列
+class BoundingSphereArray {
+
+public:
+
+	void Resize(size_t count);
+
+	void Set(size_t index, const BoundingSphere& sphere);
+
+	size_t GetCount() const { return centerX_.size(); }
+
+	const float* GetCenterX() const { return centerX_.data(); }
+	const float* GetCenterY() const { return centerY_.data(); }
+	const float* GetCenterZ() const { return centerZ_.data(); }
+	const float* GetRadius() const { return radius_.data(); }
+
+private:
+
+	std::vector<float> centerX_;
+	std::vector<float> centerY_;
+	std::vector<float> centerZ_;
+	std::vector<float> radius_;
+
+};
+
+//AABBを中心と半分の大きさで成分ごとに並べた配列
+class AABBArray {
+
+public:
+
+	void Resize(size_t count);
+
+	void Set(size_t index, const AABB& aabb);
+
+	size_t GetCount() const { return centerX_.size(); }
+
+	const float* GetCenterX() const { return centerX_.data(); }
+	const float* GetCenterY() const { return centerY_.data(); }
+	const float* GetCenterZ() const { return centerZ_.data(); }
+	const float* GetExtentX() const { return extentX_.data(); }
+	const float* GetExtentY() const { return extentY_.data(); }
+	const float* GetExtentZ() const { return extentZ_.data(); }
+
+private:
+
+	std::vector<float> centerX_;
+	std::vector<float> centerY_;
+	std::vector<float> centerZ_;
+	std::vector<float> extentX_;
+	std::vector<float> extentY_;
+	std::vector<float> extentZ_;
+
+};
+
+//[begin, end)の球を判定して、見えるもののインデックスを詰めてvisibleIndicesに書く
+//戻り値は書いた数(visibleIndicesはend-beginぶん必要)
+size_t CullSpheres(const Frustum& frustum, const BoundingSphereArray& spheres, size_t begin, size_t end, uint32_t* visibleIndices);
+
+size_t CullAABBs(const Frustum& frustum, const AABBArray& aabbs, size_t begin, size_t end, uint32_t* visibleIndices);
+
+//塊に分けて並列に判定し、インデックスの昇順に詰める(jobSystemがnullptrなら1スレッド)
+//visibleIndicesはGetCount()ぶん必要
+size_t FrustumCull(const Frustum& frustum, const BoundingSphereArray& spheres, uint32_t* visibleIndices, JobSystem* jobSystem);
+
+size_t FrustumCull(const Frustum& frustum, const AABBArray& aabbs, uint32_t* visibleIndices, JobSystem* jobSystem);
@@ -0,0 +1,117 @@
+#include "GraphicsCommandSink.h"
+#include <cstring>
+
+void D3D12GraphicsCommandSink::SetDescriptorHeaps(UINT numDescriptorHeaps, ID3D12DescriptorHeap* const* descriptorHeaps) {
+	commandList_->SetDescriptorHeaps(numDescriptorHeaps, descriptorHeaps);
+}
+
+void D3D12GraphicsCommandSink::RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* viewports) {
+	commandList_->RSSetViewports(numViewports, viewports);
+}
+
+void D3D12GraphicsCommandSink::RSSetScissorRects(UINT numRects, const D3D12_RECT* rects) {
+	commandList_->RSSetScissorRects(numRects, rects);
+}
+
+void D3D12GraphicsCommandSink::SetGraphicsRootSignature(ID3D12RootSignature* rootSignature) {
+	commandList_->SetGraphicsRootSignature(rootSignature);
+}
+
+void D3D12GraphicsCommandSink::SetPipelineState(ID3D12PipelineState* pipelineState) {
+	commandList_->SetPipelineState(pipelineState);
+}
+
+void D3D12GraphicsCommandSink::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology) {
+	commandList_->IASetPrimitiveTopology(primitiveTopology);
+}
+
+void D3D12GraphicsCommandSink::IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views) {
+	commandList_->IASetVertexBuffers(startSlot, numViews, views);
+}
+
+void D3D12GraphicsCommandSink::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) {
+	commandList_->IASetIndexBuffer(view);
+}
+
+void D3D12GraphicsCommandSink::SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) {
+	commandList_->SetGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
+}
+
+void D3D12GraphicsCommandSink::SetGraphicsRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) {
+	commandList_->SetGraphicsRootShaderResourceView(rootParameterIndex, bufferLocation);
+}
+
+void D3D12GraphicsCommandSink::SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor) {
+	commandList_->SetGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+}
+
+void D3D12GraphicsCommandSink::SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValuesToSet, const void* srcData, UINT destOffsetIn32BitValues) {
+	commandList_->SetGraphicsRoot32BitConstants(rootParameterIndex, num32BitValuesToSet, srcData, destOffsetIn32BitValues);
+}
+
+void RecordingGraphicsCommandSink::SetDescriptorHeaps(UINT numDescriptorHeaps, ID3D12DescriptorHeap* const* descriptorHeaps) {
+	Record(GraphicsCommandType::kSetDescriptorHeaps, 0, numDescriptorHeaps, 0, descriptorHeaps, sizeof(ID3D12DescriptorHeap*) * numDescriptorHeaps);
+}
+
+void RecordingGraphicsCommandSink::RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* viewports) {
+	Record(GraphicsCommandType::kRSSetViewports, 0, numViewports, 0, viewports, sizeof(D3D12_VIEWPORT) * numViewports);
+}
+
+void RecordingGraphicsCommandSink::RSSetScissorRects(UINT numRects, const D3D12_RECT* rects) {
+	Record(GraphicsCommandType::kRSSetScissorRects, 0, numRects, 0, rects, sizeof(D3D12_RECT) * numRects);
+}
+
+void RecordingGraphicsCommandSink::SetGraphicsRootSignature(ID3D12RootSignature* rootSignature) {
+	Record(GraphicsCommandType::kSetGraphicsRootSignature, 0, 0, reinterpret_cast<uintptr_t>(rootSignature));
+}
+
+void RecordingGraphicsCommandSink::SetPipelineState(ID3D12PipelineState* pipelineState) {
+	Record(GraphicsCommandType::kSetPipelineState, 0, 0, reinterpret_cast<uintptr_t>(pipelineState));
+}
+
+void RecordingGraphicsCommandSink::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology) {
+	Record(GraphicsCommandType::kIASetPrimitiveTopology, 0, 0, static_cast<uint64_t>(primitiveTopology));
+}
+
+void RecordingGraphicsCommandSink::IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views) {
+	Record(GraphicsCommandType::kIASetVertexBuffers, startSlot, numViews, 0, views, sizeof(D3D12_VERTEX_BUFFER_VIEW) * numViews);
+}
+
+void RecordingGraphicsCommandSink::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) {
+	Record(GraphicsCommandType::kIASetIndexBuffer, 0, 1, 0, view, sizeof(D3D12_INDEX_BUFFER_VIEW));
+}
+
+void RecordingGraphicsCommandSink::SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) {
+	Record(GraphicsCommandType::kSetGraphicsRootConstantBufferView, rootParameterIndex, 0, bufferLocation);
+}
+
+void RecordingGraphicsCommandSink::SetGraphicsRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) {
+	Record(GraphicsCommandType::kSetGraphicsRootShaderResourceView, rootParameterIndex, 0, bufferLocation);
+}
+
+void RecordingGraphicsCommandSink::SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor) {
+	Record(GraphicsCommandType::kSetGraphicsRootDescriptorTable, rootParameterIndex, 0, baseDescriptor.ptr);
+}
+
+void RecordingGraphicsCommandSink::SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValuesToSet, const void* srcData, UINT destOffsetIn32BitValues) {
+	Record(GraphicsCommandType::kSetGraphicsRoot32BitConstants, rootParameterIndex, num32BitValuesToSet, destOffsetIn32BitValues, srcData, sizeof(uint32_t) * num32BitValuesToSet);
+}
+
+void RecordingGraphicsCommandSink::Record(GraphicsCommandType type, uint32_t index, uint32_t count, uint64_t value, const void* data, size_t size) {
+
+	RecordedGraphicsCommand& command = commands_.emplace_back();
+
+	command.type = type;
+
+	command.index = index;
+
+	command.count = count;
+
+	command.value = value;
+
+	if (size != 0) {
+		command.data.resize(size);
+		std::memcpy(command.data.data(), data, size);
+	}
+
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include <vector>
+
+//状態を設定するコマンドの送り先
+//StateCachedCommandListは省いた残りの呼び出しだけをここに流す
+class GraphicsCommandSink {
+
+public:
+
+	virtual ~GraphicsCommandSink() = default;
+
+	virtual void SetDescriptorHeaps(UINT numDescriptorHeaps, ID3D12DescriptorHeap* const* descriptorHeaps) = 0;
+
+	virtual void RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* viewports) = 0;
+
+	virtual void RSSetScissorRects(UINT numRects, const D3D12_RECT* rects) = 0;
+
+	virtual void SetGraphicsRootSignature(ID3D12RootSignature* rootSignature) = 0;
+
+	virtual void SetPipelineState(ID3D12PipelineState* pipelineState) = 0;
+
+	virtual void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology) = 0;
+
+	virtual void IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views) = 0;
+
+	virtual void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) = 0;
+
+	virtual void SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) = 0;
+
+	virtual void SetGraphicsRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) = 0;
+
+	virtual void SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor) = 0;
+
+	virtual void SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValuesToSet, const void* srcData, UINT destOffsetIn32BitValues) = 0;
+
+};
+
+//ID3D12GraphicsCommandListにそのまま積む
+class D3D12GraphicsCommandSink : public GraphicsCommandSink {
+
+public:
+
+	void Initialize(ID3D12GraphicsCommandList* commandList) { commandList_ = commandList; }
+
+	ID3D12GraphicsCommandList* Get() const { return commandList_; }
+
+	void SetDescriptorHeaps(UINT numDescriptorHeaps, ID3D12DescriptorHeap* const* descriptorHeaps) override;
+
+	void RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* viewports) override;
+
+	void RSSetScissorRects(UINT numRects, const D3D12_RECT* rects) override;
+
+	void SetGraphicsRootSignature(ID3D12RootSignature* rootSignature) override;
+
+	void SetPipelineState(ID3D12PipelineState* pipelineState) override;
+
+	void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology) override;
+
+	void IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views) override;
+
+	void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) override;
+
+	void SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) override;
+
+	void SetGraphicsRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) override;
+
+	void SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor) override;
+
+	void SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValuesToSet, const void* srcData, UINT destOffsetIn32BitValues) override;
+
+private:
+
+	ID3D12GraphicsCommandList* commandList_ = nullptr;
+
+};
+
+enum class GraphicsCommandType : uint32_t {
+	kSetDescriptorHeaps,
+	kRSSetViewports,
+	kRSSetScissorRects,
+	kSetGraphicsRootSignature,
+	kSetPipelineState,
+	kIASetPrimitiveTopology,
+	kIASetVertexBuffers,
+	kIASetIndexBuffer,
+	kSetGraphicsRootConstantBufferView,
+	kSetGraphicsRootShaderResourceView,
+	kSetGraphicsRootDescriptorTable,
+	kSetGraphicsRoot32BitConstants,
+};
+
+//記録した1回の呼び出し
+struct RecordedGraphicsCommand {
+
+	GraphicsCommandType type;
+
+	//開始スロットかルート引数の位置(ないものは0)
+	uint32_t index;
+
+	//配列で渡した数、ルート定数の数(ないものは0)
+	uint32_t count;
+
+	//ポインタ、GPUアドレス、トポロジー、ルート定数の開始位置など1つの値で渡したもの
+	uint64_t value;
+
+	//配列やビューで渡したものの中身
+	std::vector<uint8_t> data;
+
+};
+
+//呼び出しを順に記録する(GPUなしで積んだコマンドを確かめる時に使う)
+class RecordingGraphicsCommandSink : public GraphicsCommandSink {
+
+public:
+
+	const std::vector<RecordedGraphicsCommand>& GetCommands() const { return commands_; }
+
+	void Clear() { commands_.clear(); }
+
+	void SetDescriptorHeaps(UINT numDescriptorHeaps, ID3D12DescriptorHeap* const* descriptorHeaps) override;
+
+	void RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* viewports) override;
+
+	void RSSetScissorRects(UINT numRects, const D3D12_RECT* rects) override;
+
+	void SetGraphicsRootSignature(ID3D12RootSignature* rootSignature) override;
+
+	void SetPipelineState(ID3D12PipelineState* pipelineState) override;
+
+	void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology) override;
+
+	void IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views) override;
+
+	void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) override;
+
+	void SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) override;
+
+	void SetGraphicsRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) override;
+
+	void SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor) override;
+
+	void SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValuesToSet, const void* srcData, UINT destOffsetIn32BitValues) override;
+
+private:
+
+	void Record(GraphicsCommandType type, uint32_t index, uint32_t count, uint64_t value, const void* data = nullptr, size_t size = 0);
+
+	std::vector<RecordedGraphicsCommand> commands_;
+
+};
@@ -0,0 +1,170 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+void JobSystem::Initialize(uint32_t workerCount) {
+
+	if (workerCount == 0) {
+		uint32_t hardwareCount = std::thread::hardware_concurrency();
+		workerCount = hardwareCount > 1 ? hardwareCount - 1 : 1;
+	}
+
+	isExit_ = false;
+
+	for (uint32_t i = 0; i < workerCount; ++i) {
+		workers_.emplace_back(&JobSystem::WorkerMain, this);
+	}
+
+}
+
+void JobSystem::Finalize() {
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		isExit_ = true;
+	}
+
+	condition_.notify_all();
+
+	for (std::thread& worker : workers_) {
+		worker.join();
+	}
+
+	workers_.clear();
+
+	jobs_.clear();
+
+}
+
+void JobSystem::Schedule(std::function<void()> job) {
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs_.push_back(std::move(job));
+	}
+
+	condition_.notify_one();
+
+}
+
+void JobSystem::Dispatch(uint32_t jobCount, const std::function<void(uint32_t jobIndex)>& function) {
+
+	if (jobCount == 0) {
+		return;
+	}
+
+	//ワーカーがいなければその場で実行する
+	if (workers_.empty() || jobCount == 1) {
+		for (uint32_t i = 0; i < jobCount; ++i) {
+			function(i);
+		}
+		return;
+	}
+
+	std::atomic<uint32_t> remaining = jobCount;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		//最初の1つは呼び出し側が実行する
+		for (uint32_t i = 1; i < jobCount; ++i) {
+			jobs_.push_back([&function, &remaining, i]() {
+				function(i);
+				remaining.fetch_sub(1, std::memory_order_release);
+			});
+		}
+	}
+
+	condition_.notify_all();
+
+	function(0);
+
+	remaining.fetch_sub(1, std::memory_order_release);
+
+	//待っている間も積まれている仕事を手伝う
+	while (remaining.load(std::memory_order_acquire) != 0) {
+		if (!RunPendingJob()) {
+			std::this_thread::yield();
+		}
+	}
+
+}
+
+void JobSystem::ParallelFor(size_t count, size_t minChunkSize, const std::function<void(size_t begin, size_t end)>& function) {
+
+	uint32_t chunkCount = GetChunkCount(count, minChunkSize);
+
+	if (chunkCount == 0) {
+		return;
+	}
+
+	size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+	Dispatch(chunkCount, [&](uint32_t chunkIndex) {
+		size_t begin = chunkIndex * chunkSize;
+		size_t end = (std::min)(begin + chunkSize, count);
+		if (begin < end) {
+			function(begin, end);
+		}
+	});
+
+}
+
+uint32_t JobSystem::GetChunkCount(size_t count, size_t minChunkSize) const {
+
+	if (count == 0) {
+		return 0;
+	}
+
+	size_t maxChunks = (count + (std::max)(minChunkSize, size_t(1)) - 1) / (std::max)(minChunkSize, size_t(1));
+
+	return static_cast<uint32_t>((std::min)(maxChunks, static_cast<size_t>(GetThreadCount())));
+
+}
+
+void JobSystem::WorkerMain() {
+
+	while (true) {
+
+		std::function<void()> job;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+
+			condition_.wait(lock, [this] { return isExit_ || !jobs_.empty(); });
+
+			if (isExit_ && jobs_.empty()) {
+				return;
+			}
+
+			job = std::move(jobs_.front());
+
+			jobs_.pop_front();
+		}
+
+		job();
+
+	}
+
+}
+
+bool JobSystem::RunPendingJob() {
+
+	std::function<void()> job;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (jobs_.empty()) {
+			return false;
+		}
+
+		job = std::move(jobs_.front());
+
+		jobs_.pop_front();
+	}
+
+	job();
+
+	return true;
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+//ワーカースレッドに仕事を分けるスレッドプール
+//Dispatch/ParallelForは呼び出したスレッドも仕事を手伝い、全部終わるまで戻らない
+class JobSystem {
+
+public:
+
+	//workerCountが0ならコア数-1にする
+	void Initialize(uint32_t workerCount = 0);
+
+	void Finalize();
+
+	//呼び出し側も含めて同時に動けるスレッドの数
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(workers_.size()) + 1; }
+
+	//終わりを待たない仕事を積む
+	void Schedule(std::function<void()> job);
+
+	//function(jobIndex)をjobCount回並列に呼ぶ
+	void Dispatch(uint32_t jobCount, const std::function<void(uint32_t jobIndex)>& function);
+
+	//[0, count)をminChunkSize以上の塊に分けてfunction(begin, end)を並列に呼ぶ
+	void ParallelFor(size_t count, size_t minChunkSize, const std::function<void(size_t begin, size_t end)>& function);
+
+	//塊の数(ParallelForの分け方と同じ)
+	uint32_t GetChunkCount(size_t count, size_t minChunkSize) const;
+
+private:
+
+	void WorkerMain();
+
+	//積まれている仕事を1つ実行する(なければfalse)
+	bool RunPendingJob();
+
+	std::vector<std::thread> workers_;
+
+	std::deque<std::function<void()>> jobs_;
+
+	std::mutex mutex_;
+
+	std::condition_variable condition_;
+
+	bool isExit_ = false;
+
+};
@@ -0,0 +1,269 @@
+#include "Lz4.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+
+	const size_t kMinMatch = 4;
+
+	//一致はブロックの末尾からこのバイト数より前で始める
+	const size_t kMatchStartLimit = 12;
+
+	//末尾のこのバイト数は必ずリテラルにする
+	const size_t kLastLiterals = 5;
+
+	const size_t kMaxOffset = 65535;
+
+	const uint32_t kHashBits = 16;
+
+	//一致が見つからない回数がこれだけ続くごとに進む幅を1つ広げる
+	const uint32_t kSkipTrigger = 6;
+
+	uint32_t Read32(const uint8_t* p) {
+		uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	uint32_t HashSequence(uint32_t sequence) {
+		return (sequence * 2654435761u) >> (32 - kHashBits);
+	}
+
+	//長さの15以上の分を255ずつのバイトで書く
+	bool WriteLength(uint8_t*& output, const uint8_t* outputEnd, size_t length) {
+
+		for (; length >= 255; length -= 255) {
+			if (output >= outputEnd) {
+				return false;
+			}
+			*output++ = 255;
+		}
+
+		if (output >= outputEnd) {
+			return false;
+		}
+
+		*output++ = static_cast<uint8_t>(length);
+
+		return true;
+
+	}
+
+	//リテラルと一致を1つの並びとして書く(matchLengthが0なら最後のリテラルだけの並び)
+	bool WriteSequence(uint8_t*& output, const uint8_t* outputEnd, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength) {
+
+		if (output >= outputEnd) {
+			return false;
+		}
+
+		uint8_t* token = output++;
+
+		*token = static_cast<uint8_t>((literalLength >= 15 ? 15 : literalLength) << 4);
+
+		if (literalLength >= 15 && !WriteLength(output, outputEnd, literalLength - 15)) {
+			return false;
+		}
+
+		if (static_cast<size_t>(outputEnd - output) < literalLength) {
+			return false;
+		}
+
+		if (literalLength != 0) {
+			std::memcpy(output, literals, literalLength);
+			output += literalLength;
+		}
+
+		if (matchLength == 0) {
+			return true;
+		}
+
+		if (outputEnd - output < 2) {
+			return false;
+		}
+
+		*output++ = static_cast<uint8_t>(offset);
+		*output++ = static_cast<uint8_t>(offset >> 8);
+
+		size_t matchCode = matchLength - kMinMatch;
+
+		*token |= static_cast<uint8_t>(matchCode >= 15 ? 15 : matchCode);
+
+		return matchCode < 15 || WriteLength(output, outputEnd, matchCode - 15);
+
+	}
+
+	//長さの15以上の分を読む
+	bool ReadLength(const uint8_t*& input, const uint8_t* inputEnd, size_t& length) {
+
+		uint8_t value;
+
+		do {
+			if (input >= inputEnd) {
+				return false;
+			}
+			value = *input++;
+			length += value;
+		} while (value == 255);
+
+		return true;
+
+	}
+
+}
+
+size_t GetLz4CompressBound(size_t sourceSize) {
+	return sourceSize + sourceSize / 255 + 16;
+}
+
+size_t CompressLz4(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t destinationCapacity) {
+
+	uint8_t* output = destination;
+
+	const uint8_t* outputEnd = destination + destinationCapacity;
+
+	size_t anchor = 0;
+
+	if (sourceSize > kMatchStartLimit) {
+
+		//位置を覚えておく表(スレッドごとに使い回す)
+		thread_local std::vector<uint32_t> hashTable;
+
+		hashTable.assign(size_t(1) << kHashBits, 0);
+
+		size_t matchStartLimit = sourceSize - kMatchStartLimit;
+
+		size_t matchEndLimit = sourceSize - kLastLiterals;
+
+		size_t position = 0;
+
+		uint32_t missCount = 0;
+
+		while (position <= matchStartLimit) {
+
+			uint32_t sequence = Read32(source + position);
+
+			uint32_t& slot = hashTable[HashSequence(sequence)];
+
+			size_t candidate = slot;
+
+			slot = static_cast<uint32_t>(position);
+
+			if (candidate >= position || position - candidate > kMaxOffset || Read32(source + candidate) != sequence) {
+				position += 1 + (missCount++ >> kSkipTrigger);
+				continue;
+			}
+
+			//前にも一致が伸ばせるならリテラルを減らす
+			while (position > anchor && candidate > 0 && source[position - 1] == source[candidate - 1]) {
+				--position;
+				--candidate;
+			}
+
+			size_t matchLength = kMinMatch;
+
+			while (position + matchLength < matchEndLimit && source[candidate + matchLength] == source[position + matchLength]) {
+				++matchLength;
+			}
+
+			if (!WriteSequence(output, outputEnd, source + anchor, position - anchor, position - candidate, matchLength)) {
+				return 0;
+			}
+
+			position += matchLength;
+
+			anchor = position;
+
+			missCount = 0;
+
+			//一致の終わりの手前も表に入れておく(続く一致を見つけやすくする)
+			if (position - 2 <= matchStartLimit) {
+				hashTable[HashSequence(Read32(source + position - 2))] = static_cast<uint32_t>(position - 2);
+			}
+
+		}
+
+	}
+
+	if (!WriteSequence(output, outputEnd, source + anchor, sourceSize - anchor, 0, 0)) {
+		return 0;
+	}
+
+	return static_cast<size_t>(output - destination);
+
+}
+
+bool DecompressLz4(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t destinationSize) {
+
+	const uint8_t* input = source;
+
+	const uint8_t* inputEnd = source + sourceSize;
+
+	size_t outputPosition = 0;
+
+	while (input < inputEnd) {
+
+		uint8_t token = *input++;
+
+		size_t literalLength = token >> 4;
+
+		if (literalLength == 15 && !ReadLength(input, inputEnd, literalLength)) {
+			return false;
+		}
+
+		if (static_cast<size_t>(inputEnd - input) < literalLength || destinationSize - outputPosition < literalLength) {
+			return false;
+		}
+
+		std::memcpy(destination + outputPosition, input, literalLength);
+
+		input += literalLength;
+
+		outputPosition += literalLength;
+
+		//最後の並びはリテラルだけ
+		if (input == inputEnd) {
+			break;
+		}
+
+		if (inputEnd - input < 2) {
+			return false;
+		}
+
+		size_t offset = static_cast<size_t>(input[0]) | (static_cast<size_t>(input[1]) << 8);
+
+		input += 2;
+
+		if (offset == 0 || offset > outputPosition) {
+			return false;
+		}
+
+		size_t matchLength = token & 15;
+
+		if (matchLength == 15 && !ReadLength(input, inputEnd, matchLength)) {
+			return false;
+		}
+
+		matchLength += kMinMatch;
+
+		if (destinationSize - outputPosition < matchLength) {
+			return false;
+		}
+
+		//距離が一致より短い時は重なるので、距離の分ずつ写す
+		while (matchLength > 0) {
+
+			size_t chunk = matchLength < offset ? matchLength : offset;
+
+			std::memcpy(destination + outputPosition, destination + outputPosition - offset, chunk);
+
+			outputPosition += chunk;
+
+			matchLength -= chunk;
+
+		}
+
+	}
+
+	return outputPosition == destinationSize;
+
+}
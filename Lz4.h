@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+//LZ4のブロック形式の圧縮と展開(フレームのヘッダーやチェックサムは付けない)
+//一致は4バイト以上、距離は65535バイトまでで、末尾の5バイトは必ずリテラルにする
+
+//sourceSizeバイトを圧縮した時の最大の大きさ
+size_t GetLz4CompressBound(size_t sourceSize);
+
+//圧縮したバイト数を返す(destinationCapacityに収まらなければ0)
+//ハッシュ表で一致を探す貪欲法で、見つからない間は進む幅を広げる
+size_t CompressLz4(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t destinationCapacity);
+
+//ちょうどdestinationSizeバイトに展開する(壊れたデータでも範囲の外は読み書きせず、falseを返す)
+bool DecompressLz4(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t destinationSize);
@@ -0,0 +1,144 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <string>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const char* path) {
+
+	Close();
+
+	//パスはUTF-8で受け取る
+	int length = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+	std::wstring widePath(length, L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, path, -1, &widePath[0], length);
+
+	HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle_ = file;
+	size_ = static_cast<size_t>(fileSize.QuadPart);
+	isOpen_ = true;
+
+	//大きさ0のファイルはマップできない
+	if (size_ == 0) {
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		Close();
+		return false;
+	}
+
+	mappingHandle_ = mapping;
+
+	data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (data_ == nullptr) {
+		Close();
+		return false;
+	}
+
+	return true;
+
+}
+
+void MappedFile::Close() {
+
+	if (data_ != nullptr) {
+		UnmapViewOfFile(data_);
+	}
+
+	if (mappingHandle_ != nullptr) {
+		CloseHandle(mappingHandle_);
+	}
+
+	if (fileHandle_ != nullptr) {
+		CloseHandle(fileHandle_);
+	}
+
+	data_ = nullptr;
+	mappingHandle_ = nullptr;
+	fileHandle_ = nullptr;
+	size_ = 0;
+	isOpen_ = false;
+
+}
+
+#else
+
+bool MappedFile::Open(const char* path) {
+
+	Close();
+
+	int file = open(path, O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+
+	struct stat status {};
+	if (fstat(file, &status) != 0) {
+		close(file);
+		return false;
+	}
+
+	size_ = static_cast<size_t>(status.st_size);
+	isOpen_ = true;
+
+	if (size_ > 0) {
+
+		void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+
+		if (data == MAP_FAILED) {
+			close(file);
+			Close();
+			return false;
+		}
+
+		//先頭から順に読むことが多いので先読みさせる
+		madvise(data, size_, MADV_SEQUENTIAL);
+
+		data_ = static_cast<const uint8_t*>(data);
+
+	}
+
+	//マップした後はファイルを閉じてもよい
+	close(file);
+
+	return true;
+
+}
+
+void MappedFile::Close() {
+
+	if (data_ != nullptr) {
+		munmap(const_cast<uint8_t*>(data_), size_);
+	}
+
+	data_ = nullptr;
+	size_ = 0;
+	isOpen_ = false;
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+//ファイルを読み取り専用でメモリにマップする(中身はOSがページ単位で必要な時に読む)
+class MappedFile {
+
+public:
+
+	MappedFile() = default;
+
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	//開けなければfalse(空のファイルは開けるがGetDataはnullptr)
+	bool Open(const char* path);
+
+	void Close();
+
+	bool IsOpen() const { return isOpen_; }
+
+	const uint8_t* GetData() const { return data_; }
+
+	size_t GetSize() const { return size_; }
+
+private:
+
+	const uint8_t* data_ = nullptr;
+
+	size_t size_ = 0;
+
+	bool isOpen_ = false;
+
+#if defined(_WIN32)
+	void* fileHandle_ = nullptr;
+	void* mappingHandle_ = nullptr;
+#endif
+
+};
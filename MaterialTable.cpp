@@ -0,0 +1,76 @@
+#include "MaterialTable.h"
+#include <cassert>
+#include <algorithm>
+
+void MaterialTable::Initialize(uint32_t capacity) {
+
+	capacity_ = capacity;
+
+	materials_.clear();
+
+	materials_.reserve(capacity_);
+
+	dirtyBegin_ = 0;
+
+	dirtyEnd_ = 0;
+
+}
+
+uint32_t MaterialTable::Add(const Material& material) {
+
+	assert(materials_.size() < capacity_);
+
+	uint32_t index = static_cast<uint32_t>(materials_.size());
+
+	materials_.push_back(material);
+
+	Set(index, material);
+
+	return index;
+
+}
+
+void MaterialTable::Set(uint32_t index, const Material& material) {
+
+	assert(index < materials_.size());
+
+	materials_[index] = material;
+
+	if (dirtyBegin_ == dirtyEnd_) {
+		dirtyBegin_ = index;
+		dirtyEnd_ = index + 1;
+	} else {
+		dirtyBegin_ = (std::min)(dirtyBegin_, index);
+		dirtyEnd_ = (std::max)(dirtyEnd_, index + 1);
+	}
+
+}
+
+MaterialRecord MaterialTable::Pack(const Material& material) {
+
+	MaterialRecord record{};
+
+	record.color[0] = material.color.x;
+	record.color[1] = material.color.y;
+	record.color[2] = material.color.z;
+	record.color[3] = material.color.w;
+
+	record.textureIndex = material.textureIndex;
+
+	record.flags = material.flags;
+
+	return record;
+
+}
+
+void MaterialTable::Upload(MaterialRecord* records) {
+
+	for (uint32_t i = dirtyBegin_; i < dirtyEnd_; ++i) {
+		records[i] = Pack(materials_[i]);
+	}
+
+	dirtyBegin_ = 0;
+
+	dirtyEnd_ = 0;
+
+}
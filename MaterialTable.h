@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "MathTypes.h"
+
+//テクスチャを使わない場合のインデックス
+const uint32_t kInvalidTextureIndex = 0xffffffff;
+
+//CPU側で扱うマテリアル
+struct Material {
+
+	Vector4 color;
+	uint32_t textureIndex;
+	uint32_t flags;
+
+};
+
+//StructuredBufferに並べるGPU側のレコード(HLSLのMaterialと同じ並び)
+struct MaterialRecord {
+
+	float color[4];
+	uint32_t textureIndex;
+	uint32_t flags;
+	uint32_t padding[2];
+
+};
+
+static_assert(sizeof(MaterialRecord) == 32, "MaterialRecordはHLSL側と同じ32byteにする");
+
+//全マテリアルを1つのStructuredBufferにまとめるためのテーブル
+//描画はマテリアルのインデックスだけを渡せばよいので、マテリアルごとにディスクリプタを切り替えなくて済む
+class MaterialTable {
+
+public:
+
+	void Initialize(uint32_t capacity);
+
+	//追加したマテリアルのインデックスを返す
+	uint32_t Add(const Material& material);
+
+	void Set(uint32_t index, const Material& material);
+
+	const Material& Get(uint32_t index) const { return materials_[index]; }
+
+	uint32_t GetCount() const { return static_cast<uint32_t>(materials_.size()); }
+
+	uint32_t GetCapacity() const { return capacity_; }
+
+	//GPUのレイアウトに詰め直す
+	static MaterialRecord Pack(const Material& material);
+
+	//変更のあった範囲だけをレコードの配列に書き込む(GPUのバッファを直接渡してよい)
+	void Upload(MaterialRecord* records);
+
+private:
+
+	uint32_t capacity_ = 0;
+
+	std::vector<Material> materials_;
+
+	//変更のあった範囲[dirtyBegin_, dirtyEnd_)
+	uint32_t dirtyBegin_ = 0;
+
+	uint32_t dirtyEnd_ = 0;
+
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+struct Vector2 {
+
+	float x;
+	float y;
+
+};
+
+struct Vector3 {
+
+	float x;
+	float y;
+	float z;
+
+};
+
+struct Vector4 {
+
+	float x;
+	float y;
+	float z;
+	float w;
+
+};
+
+struct Matrix4x4 {
+
+	float m[4][4];
+
+};
@@ -0,0 +1,2179 @@
+#include "MeshImporter.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+
+namespace {
+
+	//OBJを分ける時の塊の最小の大きさ
+	const size_t kMinObjChunkSize = 1024 * 1024;
+
+	//頂点やインデックスを並列に処理する時の塊の最小の大きさ
+	const size_t kMinVertexChunkSize = 16 * 1024;
+
+	//OBJの面で省略された要素
+	const int32_t kMissingIndex = (std::numeric_limits<int32_t>::min)();
+
+	//OBJの面の1つの角(relativeMaskの立っている要素は負のインデックスで、塊の先頭からの位置が入っている)
+	struct ObjCorner {
+
+		int32_t position;
+		int32_t texcoord;
+		int32_t normal;
+		uint32_t relativeMask;
+
+	};
+
+	//ジョブごとに解析したOBJの一部
+	struct ObjChunk {
+
+		const char* begin;
+		const char* end;
+
+		std::vector<Vector3> positions;
+		std::vector<Vector2> texcoords;
+		std::vector<Vector3> normals;
+
+		//三角形に分けた面の角(3つで1つの三角形)
+		std::vector<ObjCorner> corners;
+
+		//1つの面の角を一時的に置く
+		std::vector<ObjCorner> faceCorners;
+
+		//前の塊までの要素の数
+		size_t positionBase;
+		size_t texcoordBase;
+		size_t normalBase;
+
+		bool isFailed;
+
+	};
+
+	bool IsSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	bool IsDigit(char c) {
+		return c >= '0' && c <= '9';
+	}
+
+	const char* SkipSpaces(const char* p, const char* end) {
+		while (p < end && IsSpace(*p)) {
+			++p;
+		}
+		return p;
+	}
+
+	const char* ParseInt(const char* begin, const char* end, int32_t& value) {
+
+		const char* p = begin;
+
+		bool isNegative = false;
+
+		if (p < end && (*p == '-' || *p == '+')) {
+			isNegative = *p == '-';
+			++p;
+		}
+
+		if (p == end || !IsDigit(*p)) {
+			return begin;
+		}
+
+		int64_t result = 0;
+
+		while (p < end && IsDigit(*p)) {
+			result = (std::min)(result * 10 + (*p - '0'), int64_t(INT32_MAX));
+			++p;
+		}
+
+		value = static_cast<int32_t>(isNegative ? -result : result);
+
+		return p;
+
+	}
+
+	//面の1つの角(v, v/vt, v//vn, v/vt/vn)を読む
+	const char* ParseObjCorner(const char* p, const char* end, const ObjChunk& chunk, ObjCorner& corner, bool& isValid) {
+
+		int32_t values[3] = { kMissingIndex, kMissingIndex, kMissingIndex };
+
+		size_t localCounts[3] = { chunk.positions.size(), chunk.texcoords.size(), chunk.normals.size() };
+
+		corner.relativeMask = 0;
+
+		for (int i = 0; i < 3; ++i) {
+
+			if (i > 0) {
+				if (p == end || *p != '/') {
+					break;
+				}
+				++p;
+			}
+
+			int32_t value = 0;
+
+			const char* next = ParseInt(p, end, value);
+
+			if (next == p) {
+				//v//vnのvtのように省略されている(vは省略できない)
+				if (i == 0) {
+					isValid = false;
+				}
+				continue;
+			}
+
+			p = next;
+
+			if (value > 0) {
+				values[i] = value - 1;
+			} else if (value < 0) {
+				//負のインデックスはそこまでに出てきた数からの相対位置なので、塊の中での位置にしておく
+				values[i] = static_cast<int32_t>(localCounts[i]) + value;
+				corner.relativeMask |= 1u << i;
+			} else {
+				isValid = false;
+			}
+
+		}
+
+		corner.position = values[0];
+		corner.texcoord = values[1];
+		corner.normal = values[2];
+
+		return p;
+
+	}
+
+	void ParseObjLine(const char* p, const char* end, ObjChunk& chunk) {
+
+		p = SkipSpaces(p, end);
+
+		if (p == end) {
+			return;
+		}
+
+		if (p[0] == 'v') {
+
+			if (p + 1 < end && IsSpace(p[1])) {
+
+				Vector3 position{};
+				p = ParseFloat(SkipSpaces(p + 1, end), end, position.x);
+				p = ParseFloat(SkipSpaces(p, end), end, position.y);
+				p = ParseFloat(SkipSpaces(p, end), end, position.z);
+				chunk.positions.push_back(position);
+
+			} else if (p + 1 < end && p[1] == 't') {
+
+				Vector2 texcoord{};
+				p = ParseFloat(SkipSpaces(p + 2, end), end, texcoord.x);
+				p = ParseFloat(SkipSpaces(p, end), end, texcoord.y);
+				chunk.texcoords.push_back(texcoord);
+
+			} else if (p + 1 < end && p[1] == 'n') {
+
+				Vector3 normal{};
+				p = ParseFloat(SkipSpaces(p + 2, end), end, normal.x);
+				p = ParseFloat(SkipSpaces(p, end), end, normal.y);
+				p = ParseFloat(SkipSpaces(p, end), end, normal.z);
+				chunk.normals.push_back(normal);
+
+			}
+
+			return;
+
+		}
+
+		if (p[0] == 'f' && p + 1 < end && IsSpace(p[1])) {
+
+			chunk.faceCorners.clear();
+
+			p = SkipSpaces(p + 1, end);
+
+			//行末のコメント(f 1 2 3 # ...)は頂点として読まない
+			while (p < end && *p != '#') {
+
+				ObjCorner corner;
+
+				bool isValid = true;
+
+				const char* next = ParseObjCorner(p, end, chunk, corner, isValid);
+
+				if (!isValid || next == p) {
+					chunk.isFailed = true;
+					return;
+				}
+
+				chunk.faceCorners.push_back(corner);
+
+				p = SkipSpaces(next, end);
+
+			}
+
+			if (chunk.faceCorners.size() < 3) {
+				chunk.isFailed = true;
+				return;
+			}
+
+			//多角形は扇形に三角形へ分ける。zを反転するので向きも入れ替える
+			for (size_t i = 2; i < chunk.faceCorners.size(); ++i) {
+				chunk.corners.push_back(chunk.faceCorners[0]);
+				chunk.corners.push_back(chunk.faceCorners[i]);
+				chunk.corners.push_back(chunk.faceCorners[i - 1]);
+			}
+
+		}
+
+		//それ以外(コメント、o、g、s、usemtl、mtllibなど)は読み飛ばす
+
+	}
+
+	void ParseObjChunk(ObjChunk& chunk) {
+
+		const char* p = chunk.begin;
+
+		while (p < chunk.end) {
+
+			const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+
+			if (lineEnd == nullptr) {
+				lineEnd = chunk.end;
+			}
+
+			ParseObjLine(p, lineEnd, chunk);
+
+			if (chunk.isFailed) {
+				return;
+			}
+
+			p = lineEnd + 1;
+
+		}
+
+	}
+
+	//負のインデックスを全体の位置に直して、範囲を確かめる
+	bool ResolveObjCorners(ObjChunk& chunk, size_t positionCount, size_t texcoordCount, size_t normalCount) {
+
+		size_t bases[3] = { chunk.positionBase, chunk.texcoordBase, chunk.normalBase };
+
+		size_t counts[3] = { positionCount, texcoordCount, normalCount };
+
+		for (ObjCorner& corner : chunk.corners) {
+
+			int32_t* values[3] = { &corner.position, &corner.texcoord, &corner.normal };
+
+			for (int i = 0; i < 3; ++i) {
+
+				if (*values[i] == kMissingIndex) {
+					continue;
+				}
+
+				int64_t value = *values[i];
+
+				if (corner.relativeMask & (1u << i)) {
+					value += static_cast<int64_t>(bases[i]);
+				}
+
+				if (value < 0 || value >= static_cast<int64_t>(counts[i])) {
+					return false;
+				}
+
+				*values[i] = static_cast<int32_t>(value);
+
+			}
+
+			corner.relativeMask = 0;
+
+		}
+
+		return true;
+
+	}
+
+	uint32_t HashCorner(const ObjCorner& corner) {
+
+		uint32_t hash = static_cast<uint32_t>(corner.position) * 0x9e3779b1u;
+		hash ^= static_cast<uint32_t>(corner.texcoord) * 0x85ebca77u;
+		hash ^= static_cast<uint32_t>(corner.normal) * 0xc2b2ae3du;
+		hash ^= hash >> 15;
+
+		return hash;
+
+	}
+
+	bool IsSameCorner(const ObjCorner& a, const ObjCorner& b) {
+		return a.position == b.position && a.texcoord == b.texcoord && a.normal == b.normal;
+	}
+
+	size_t NextPowerOfTwo(size_t value) {
+
+		size_t result = 1;
+
+		while (result < value) {
+			result <<= 1;
+		}
+
+		return result;
+
+	}
+
+	//ジョブシステムがあればParallelFor、なければそのまま呼ぶ
+	void RunParallel(JobSystem* jobSystem, size_t count, size_t minChunkSize, const std::function<void(size_t begin, size_t end)>& function) {
+
+		if (jobSystem == nullptr) {
+			if (count > 0) {
+				function(0, count);
+			}
+			return;
+		}
+
+		jobSystem->ParallelFor(count, minChunkSize, function);
+
+	}
+
+	void ComputeBounds(MeshData& mesh, JobSystem* jobSystem) {
+
+		const float kMax = (std::numeric_limits<float>::max)();
+
+		mesh.bounds = { { kMax, kMax, kMax }, { -kMax, -kMax, -kMax } };
+
+		if (mesh.vertices.empty()) {
+			mesh.bounds = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+			return;
+		}
+
+		uint32_t chunkCount = jobSystem != nullptr ? jobSystem->GetChunkCount(mesh.vertices.size(), kMinVertexChunkSize) : 1;
+
+		std::vector<AABB> chunkBounds(chunkCount, mesh.bounds);
+
+		size_t chunkSize = (mesh.vertices.size() + chunkCount - 1) / chunkCount;
+
+		auto computeChunk = [&](uint32_t chunkIndex) {
+
+			size_t begin = chunkIndex * chunkSize;
+			size_t end = (std::min)(begin + chunkSize, mesh.vertices.size());
+
+			AABB& bounds = chunkBounds[chunkIndex];
+
+			for (size_t i = begin; i < end; ++i) {
+				const Vector4& position = mesh.vertices[i].position;
+				bounds.min.x = (std::min)(bounds.min.x, position.x);
+				bounds.min.y = (std::min)(bounds.min.y, position.y);
+				bounds.min.z = (std::min)(bounds.min.z, position.z);
+				bounds.max.x = (std::max)(bounds.max.x, position.x);
+				bounds.max.y = (std::max)(bounds.max.y, position.y);
+				bounds.max.z = (std::max)(bounds.max.z, position.z);
+			}
+
+		};
+
+		if (jobSystem != nullptr) {
+			jobSystem->Dispatch(chunkCount, computeChunk);
+		} else {
+			computeChunk(0);
+		}
+
+		for (const AABB& bounds : chunkBounds) {
+			mesh.bounds.min.x = (std::min)(mesh.bounds.min.x, bounds.min.x);
+			mesh.bounds.min.y = (std::min)(mesh.bounds.min.y, bounds.min.y);
+			mesh.bounds.min.z = (std::min)(mesh.bounds.min.z, bounds.min.z);
+			mesh.bounds.max.x = (std::max)(mesh.bounds.max.x, bounds.max.x);
+			mesh.bounds.max.y = (std::max)(mesh.bounds.max.y, bounds.max.y);
+			mesh.bounds.max.z = (std::max)(mesh.bounds.max.z, bounds.max.z);
+		}
+
+	}
+
+	Vector3 Normalize(const Vector3& v) {
+
+		float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+
+		if (length <= 0.0f) {
+			return { 0.0f, 0.0f, 0.0f };
+		}
+
+		return { v.x / length, v.y / length, v.z / length };
+
+	}
+
+	//法線がないメッシュは面積で重みを付けた面法線を足し合わせて作る(左手系で時計回りが表)
+	void ComputeVertexNormals(MeshData& mesh) {
+
+		for (MeshVertex& vertex : mesh.vertices) {
+			vertex.normal = { 0.0f, 0.0f, 0.0f };
+		}
+
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+
+			MeshVertex& v0 = mesh.vertices[mesh.indices[i]];
+			MeshVertex& v1 = mesh.vertices[mesh.indices[i + 1]];
+			MeshVertex& v2 = mesh.vertices[mesh.indices[i + 2]];
+
+			Vector3 e1 = { v1.position.x - v0.position.x, v1.position.y - v0.position.y, v1.position.z - v0.position.z };
+			Vector3 e2 = { v2.position.x - v0.position.x, v2.position.y - v0.position.y, v2.position.z - v0.position.z };
+
+			Vector3 normal = { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+
+			for (MeshVertex* vertex : { &v0, &v1, &v2 }) {
+				vertex->normal.x += normal.x;
+				vertex->normal.y += normal.y;
+				vertex->normal.z += normal.z;
+			}
+
+		}
+
+		for (MeshVertex& vertex : mesh.vertices) {
+			vertex.normal = Normalize(vertex.normal);
+		}
+
+	}
+
+	bool HasExtension(const std::string& path, const char* extension) {
+
+		size_t length = std::strlen(extension);
+
+		if (path.size() < length) {
+			return false;
+		}
+
+		for (size_t i = 0; i < length; ++i) {
+			char c = path[path.size() - length + i];
+			if (c >= 'A' && c <= 'Z') {
+				c = static_cast<char>(c - 'A' + 'a');
+			}
+			if (c != extension[i]) {
+				return false;
+			}
+		}
+
+		return true;
+
+	}
+
+	//glTFのJSONを読むための最小限のJSON
+	struct JsonValue {
+
+		enum class Type {
+			kNull,
+			kBool,
+			kNumber,
+			kString,
+			kArray,
+			kObject,
+		};
+
+		Type type = Type::kNull;
+
+		bool boolean = false;
+
+		double number = 0.0;
+
+		std::string string;
+
+		std::vector<JsonValue> array;
+
+		std::vector<std::pair<std::string, JsonValue>> members;
+
+		const JsonValue* Find(const char* key) const {
+			for (const std::pair<std::string, JsonValue>& member : members) {
+				if (member.first == key) {
+					return &member.second;
+				}
+			}
+			return nullptr;
+		}
+
+		double GetNumber(const char* key, double defaultValue) const {
+			const JsonValue* value = Find(key);
+			return value != nullptr && value->type == Type::kNumber ? value->number : defaultValue;
+		}
+
+		const std::string* GetString(const char* key) const {
+			const JsonValue* value = Find(key);
+			return value != nullptr && value->type == Type::kString ? &value->string : nullptr;
+		}
+
+		const std::vector<JsonValue>* GetArray(const char* key) const {
+			const JsonValue* value = Find(key);
+			return value != nullptr && value->type == Type::kArray ? &value->array : nullptr;
+		}
+
+	};
+
+	class JsonParser {
+
+	public:
+
+		JsonParser(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+		bool Parse(JsonValue& value) {
+
+			if (!ParseValue(value, 0)) {
+				return false;
+			}
+
+			SkipWhitespace();
+
+			return p_ == end_;
+
+		}
+
+	private:
+
+		//深すぎる入れ子は壊れたファイルとして扱う
+		static const int kMaxDepth = 128;
+
+		void SkipWhitespace() {
+			while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+				++p_;
+			}
+		}
+
+		bool Consume(const char* literal) {
+
+			size_t length = std::strlen(literal);
+
+			if (static_cast<size_t>(end_ - p_) < length || std::memcmp(p_, literal, length) != 0) {
+				return false;
+			}
+
+			p_ += length;
+
+			return true;
+
+		}
+
+		bool ParseValue(JsonValue& value, int depth) {
+
+			if (depth > kMaxDepth) {
+				return false;
+			}
+
+			SkipWhitespace();
+
+			if (p_ == end_) {
+				return false;
+			}
+
+			switch (*p_) {
+			case '{':
+				return ParseObject(value, depth);
+			case '[':
+				return ParseArray(value, depth);
+			case '"':
+				value.type = JsonValue::Type::kString;
+				return ParseString(value.string);
+			case 't':
+				value.type = JsonValue::Type::kBool;
+				value.boolean = true;
+				return Consume("true");
+			case 'f':
+				value.type = JsonValue::Type::kBool;
+				value.boolean = false;
+				return Consume("false");
+			case 'n':
+				value.type = JsonValue::Type::kNull;
+				return Consume("null");
+			default:
+				return ParseNumber(value);
+			}
+
+		}
+
+		bool ParseObject(JsonValue& value, int depth) {
+
+			value.type = JsonValue::Type::kObject;
+
+			++p_;
+
+			SkipWhitespace();
+
+			if (p_ < end_ && *p_ == '}') {
+				++p_;
+				return true;
+			}
+
+			while (true) {
+
+				SkipWhitespace();
+
+				std::pair<std::string, JsonValue> member;
+
+				if (p_ == end_ || *p_ != '"' || !ParseString(member.first)) {
+					return false;
+				}
+
+				SkipWhitespace();
+
+				if (p_ == end_ || *p_ != ':') {
+					return false;
+				}
+
+				++p_;
+
+				if (!ParseValue(member.second, depth + 1)) {
+					return false;
+				}
+
+				value.members.push_back(std::move(member));
+
+				SkipWhitespace();
+
+				if (p_ == end_) {
+					return false;
+				}
+
+				if (*p_ == ',') {
+					++p_;
+					continue;
+				}
+
+				if (*p_ == '}') {
+					++p_;
+					return true;
+				}
+
+				return false;
+
+			}
+
+		}
+
+		bool ParseArray(JsonValue& value, int depth) {
+
+			value.type = JsonValue::Type::kArray;
+
+			++p_;
+
+			SkipWhitespace();
+
+			if (p_ < end_ && *p_ == ']') {
+				++p_;
+				return true;
+			}
+
+			while (true) {
+
+				value.array.emplace_back();
+
+				if (!ParseValue(value.array.back(), depth + 1)) {
+					return false;
+				}
+
+				SkipWhitespace();
+
+				if (p_ == end_) {
+					return false;
+				}
+
+				if (*p_ == ',') {
+					++p_;
+					continue;
+				}
+
+				if (*p_ == ']') {
+					++p_;
+					return true;
+				}
+
+				return false;
+
+			}
+
+		}
+
+		static int HexValue(char c) {
+			if (c >= '0' && c <= '9') return c - '0';
+			if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+			if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+			return -1;
+		}
+
+		void AppendUtf8(std::string& string, uint32_t codePoint) {
+
+			if (codePoint < 0x80) {
+				string += static_cast<char>(codePoint);
+			} else if (codePoint < 0x800) {
+				string += static_cast<char>(0xc0 | (codePoint >> 6));
+				string += static_cast<char>(0x80 | (codePoint & 0x3f));
+			} else if (codePoint < 0x10000) {
+				string += static_cast<char>(0xe0 | (codePoint >> 12));
+				string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+				string += static_cast<char>(0x80 | (codePoint & 0x3f));
+			} else {
+				string += static_cast<char>(0xf0 | (codePoint >> 18));
+				string += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+				string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+				string += static_cast<char>(0x80 | (codePoint & 0x3f));
+			}
+
+		}
+
+		bool ParseHex4(uint32_t& value) {
+
+			if (end_ - p_ < 4) {
+				return false;
+			}
+
+			value = 0;
+
+			for (int i = 0; i < 4; ++i) {
+				int digit = HexValue(p_[i]);
+				if (digit < 0) {
+					return false;
+				}
+				value = value * 16 + static_cast<uint32_t>(digit);
+			}
+
+			p_ += 4;
+
+			return true;
+
+		}
+
+		bool ParseString(std::string& string) {
+
+			++p_;
+
+			while (p_ < end_ && *p_ != '"') {
+
+				if (*p_ != '\\') {
+					string += *p_++;
+					continue;
+				}
+
+				++p_;
+
+				if (p_ == end_) {
+					return false;
+				}
+
+				char escape = *p_++;
+
+				switch (escape) {
+				case '"': string += '"'; break;
+				case '\\': string += '\\'; break;
+				case '/': string += '/'; break;
+				case 'b': string += '\b'; break;
+				case 'f': string += '\f'; break;
+				case 'n': string += '\n'; break;
+				case 'r': string += '\r'; break;
+				case 't': string += '\t'; break;
+				case 'u': {
+					uint32_t codePoint = 0;
+					if (!ParseHex4(codePoint)) {
+						return false;
+					}
+					//サロゲートペア
+					if (codePoint >= 0xd800 && codePoint < 0xdc00 && end_ - p_ >= 6 && p_[0] == '\\' && p_[1] == 'u') {
+						p_ += 2;
+						uint32_t low = 0;
+						if (!ParseHex4(low) || low < 0xdc00 || low >= 0xe000) {
+							return false;
+						}
+						codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+					}
+					AppendUtf8(string, codePoint);
+					break;
+				}
+				default:
+					return false;
+				}
+
+			}
+
+			if (p_ == end_) {
+				return false;
+			}
+
+			++p_;
+
+			return true;
+
+		}
+
+		bool ParseNumber(JsonValue& value) {
+
+			value.type = JsonValue::Type::kNumber;
+
+			float number = 0.0f;
+
+			//インデックスや長さは整数なので、floatで足りない桁は整数として読む
+			const char* p = p_;
+
+			bool isInteger = true;
+
+			const char* digitsBegin = (p < end_ && *p == '-') ? p + 1 : p;
+
+			for (const char* q = digitsBegin; q < end_ && (IsDigit(*q) || *q == '.' || *q == 'e' || *q == 'E' || *q == '+' || *q == '-'); ++q) {
+				if (!IsDigit(*q)) {
+					isInteger = false;
+				}
+			}
+
+			if (isInteger) {
+
+				int64_t integer = 0;
+
+				const char* q = digitsBegin;
+
+				if (q == end_ || !IsDigit(*q)) {
+					return false;
+				}
+
+				while (q < end_ && IsDigit(*q)) {
+					integer = integer * 10 + (*q - '0');
+					if (integer > (int64_t(1) << 53)) {
+						return false;
+					}
+					++q;
+				}
+
+				value.number = static_cast<double>(p != digitsBegin ? -integer : integer);
+
+				p_ = q;
+
+				return true;
+
+			}
+
+			const char* next = ParseFloat(p_, end_, number);
+
+			if (next == p_) {
+				return false;
+			}
+
+			value.number = number;
+
+			p_ = next;
+
+			return true;
+
+		}
+
+		const char* p_;
+
+		const char* end_;
+
+	};
+
+	//glTFのバッファの中身(ファイルをマップしたものか、GLBのBINチャンクかdata URIを展開したもの)
+	struct GltfBuffer {
+
+		const uint8_t* data = nullptr;
+
+		size_t size = 0;
+
+		std::unique_ptr<MappedFile> file;
+
+		std::vector<uint8_t> decoded;
+
+	};
+
+	//アクセサの要素を読むための情報(範囲は作る時に確かめる)
+	struct GltfAccessor {
+
+		const uint8_t* data = nullptr;
+
+		size_t count = 0;
+
+		size_t stride = 0;
+
+		uint32_t componentType = 0;
+
+		uint32_t componentCount = 0;
+
+		bool isNormalized = false;
+
+	};
+
+	const uint32_t kGltfByte = 5120;
+	const uint32_t kGltfUnsignedByte = 5121;
+	const uint32_t kGltfShort = 5122;
+	const uint32_t kGltfUnsignedShort = 5123;
+	const uint32_t kGltfUnsignedInt = 5125;
+	const uint32_t kGltfFloat = 5126;
+
+	const uint32_t kGltfTriangles = 4;
+
+	//glTFのbyteStrideの上限
+	const size_t kMaxGltfByteStride = 252;
+
+	//JSONの数を個数や位置として読む。負の数、小数、NaN、maxValueより大きいものは読めない
+	//(doubleのままsize_tにすると未定義動作になるので、変換する前に確かめる)
+	bool ToGltfSize(const JsonValue& json, size_t maxValue, size_t& value) {
+
+		const double kMaxExactInteger = 9007199254740992.0;
+
+		double limit = (std::min)(static_cast<double>(maxValue), kMaxExactInteger);
+
+		if (json.type != JsonValue::Type::kNumber || !(json.number >= 0.0) || json.number > limit || std::floor(json.number) != json.number) {
+			return false;
+		}
+
+		value = static_cast<size_t>(json.number);
+
+		return true;
+
+	}
+
+	//keyがなければvalueはそのまま(省略できるものは先に既定値を入れておく)
+	bool GetGltfSize(const JsonValue& json, const char* key, size_t maxValue, size_t& value) {
+		const JsonValue* number = json.Find(key);
+		return number == nullptr || ToGltfSize(*number, maxValue, value);
+	}
+
+	//配列の要素の番号として読む(keyがなければfalse)
+	bool GetGltfIndex(const JsonValue& json, const char* key, size_t arraySize, size_t& value) {
+		const JsonValue* number = json.Find(key);
+		return number != nullptr && arraySize > 0 && ToGltfSize(*number, arraySize - 1, value);
+	}
+
+	size_t GetGltfComponentSize(uint32_t componentType) {
+		switch (componentType) {
+		case kGltfByte:
+		case kGltfUnsignedByte:
+			return 1;
+		case kGltfShort:
+		case kGltfUnsignedShort:
+			return 2;
+		case kGltfUnsignedInt:
+		case kGltfFloat:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	uint32_t GetGltfComponentCount(const std::string& type) {
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		return 0;
+	}
+
+	bool Base64Decode(const char* p, const char* end, std::vector<uint8_t>& out) {
+
+		uint32_t bits = 0;
+		int bitCount = 0;
+
+		for (; p < end; ++p) {
+
+			char c = *p;
+			int value;
+
+			if (c >= 'A' && c <= 'Z') value = c - 'A';
+			else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+			else if (c >= '0' && c <= '9') value = c - '0' + 52;
+			else if (c == '+') value = 62;
+			else if (c == '/') value = 63;
+			else if (c == '=') break;
+			else return false;
+
+			bits = (bits << 6) | static_cast<uint32_t>(value);
+			bitCount += 6;
+
+			if (bitCount >= 8) {
+				bitCount -= 8;
+				out.push_back(static_cast<uint8_t>(bits >> bitCount));
+			}
+
+		}
+
+		return true;
+
+	}
+
+	//URIの%XXを戻す
+	std::string DecodeUri(const std::string& uri) {
+
+		std::string result;
+
+		for (size_t i = 0; i < uri.size(); ++i) {
+
+			if (uri[i] == '%' && i + 2 < uri.size()) {
+				int high = uri[i + 1] >= 'a' ? uri[i + 1] - 'a' + 10 : (uri[i + 1] >= 'A' ? uri[i + 1] - 'A' + 10 : uri[i + 1] - '0');
+				int low = uri[i + 2] >= 'a' ? uri[i + 2] - 'a' + 10 : (uri[i + 2] >= 'A' ? uri[i + 2] - 'A' + 10 : uri[i + 2] - '0');
+				result += static_cast<char>(high * 16 + low);
+				i += 2;
+			} else {
+				result += uri[i];
+			}
+
+		}
+
+		return result;
+
+	}
+
+	float ReadGltfComponent(const uint8_t* p, uint32_t componentType, bool isNormalized) {
+
+		switch (componentType) {
+		case kGltfFloat: {
+			float value;
+			std::memcpy(&value, p, sizeof(value));
+			return value;
+		}
+		case kGltfUnsignedByte:
+			return isNormalized ? p[0] / 255.0f : float(p[0]);
+		case kGltfByte:
+			return isNormalized ? (std::max)(static_cast<int8_t>(p[0]) / 127.0f, -1.0f) : float(static_cast<int8_t>(p[0]));
+		case kGltfUnsignedShort: {
+			uint16_t value;
+			std::memcpy(&value, p, sizeof(value));
+			return isNormalized ? value / 65535.0f : float(value);
+		}
+		case kGltfShort: {
+			int16_t value;
+			std::memcpy(&value, p, sizeof(value));
+			return isNormalized ? (std::max)(value / 32767.0f, -1.0f) : float(value);
+		}
+		case kGltfUnsignedInt: {
+			uint32_t value;
+			std::memcpy(&value, p, sizeof(value));
+			return float(value);
+		}
+		default:
+			return 0.0f;
+		}
+
+	}
+
+	uint32_t ReadGltfIndex(const GltfAccessor& accessor, size_t index) {
+
+		const uint8_t* p = accessor.data + accessor.stride * index;
+
+		switch (accessor.componentType) {
+		case kGltfUnsignedByte:
+			return p[0];
+		case kGltfUnsignedShort: {
+			uint16_t value;
+			std::memcpy(&value, p, sizeof(value));
+			return value;
+		}
+		default: {
+			uint32_t value;
+			std::memcpy(&value, p, sizeof(value));
+			return value;
+		}
+		}
+
+	}
+
+	//各行列は行ベクトル(v * M)の形で持つ
+	Matrix4x4 MultiplyMatrix(const Matrix4x4& a, const Matrix4x4& b) {
+
+		Matrix4x4 result{};
+
+		for (int i = 0; i < 4; ++i) {
+			for (int j = 0; j < 4; ++j) {
+				result.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+			}
+		}
+
+		return result;
+
+	}
+
+	Matrix4x4 IdentityMatrix() {
+
+		Matrix4x4 result{};
+
+		result.m[0][0] = 1.0f;
+		result.m[1][1] = 1.0f;
+		result.m[2][2] = 1.0f;
+		result.m[3][3] = 1.0f;
+
+		return result;
+
+	}
+
+	//ノードのローカル行列(matrixか、translation/rotation/scale)
+	Matrix4x4 GetGltfNodeMatrix(const JsonValue& node) {
+
+		const std::vector<JsonValue>* matrix = node.GetArray("matrix");
+
+		if (matrix != nullptr && matrix->size() == 16) {
+
+			//glTFは列ベクトルの列優先なので、そのまま並べると行ベクトルの形になる
+			Matrix4x4 result{};
+
+			for (int i = 0; i < 16; ++i) {
+				result.m[i / 4][i % 4] = static_cast<float>((*matrix)[i].number);
+			}
+
+			return result;
+
+		}
+
+		float translation[3] = { 0.0f, 0.0f, 0.0f };
+		float rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		float scale[3] = { 1.0f, 1.0f, 1.0f };
+
+		if (const std::vector<JsonValue>* values = node.GetArray("translation"); values != nullptr && values->size() == 3) {
+			for (int i = 0; i < 3; ++i) translation[i] = static_cast<float>((*values)[i].number);
+		}
+		if (const std::vector<JsonValue>* values = node.GetArray("rotation"); values != nullptr && values->size() == 4) {
+			for (int i = 0; i < 4; ++i) rotation[i] = static_cast<float>((*values)[i].number);
+		}
+		if (const std::vector<JsonValue>* values = node.GetArray("scale"); values != nullptr && values->size() == 3) {
+			for (int i = 0; i < 3; ++i) scale[i] = static_cast<float>((*values)[i].number);
+		}
+
+		float x = rotation[0];
+		float y = rotation[1];
+		float z = rotation[2];
+		float w = rotation[3];
+
+		//スケール→回転→平行移動の順にかける
+		Matrix4x4 result{};
+
+		result.m[0][0] = (1.0f - 2.0f * (y * y + z * z)) * scale[0];
+		result.m[0][1] = (2.0f * (x * y + z * w)) * scale[0];
+		result.m[0][2] = (2.0f * (x * z - y * w)) * scale[0];
+
+		result.m[1][0] = (2.0f * (x * y - z * w)) * scale[1];
+		result.m[1][1] = (1.0f - 2.0f * (x * x + z * z)) * scale[1];
+		result.m[1][2] = (2.0f * (y * z + x * w)) * scale[1];
+
+		result.m[2][0] = (2.0f * (x * z + y * w)) * scale[2];
+		result.m[2][1] = (2.0f * (y * z - x * w)) * scale[2];
+		result.m[2][2] = (1.0f - 2.0f * (x * x + y * y)) * scale[2];
+
+		result.m[3][0] = translation[0];
+		result.m[3][1] = translation[1];
+		result.m[3][2] = translation[2];
+		result.m[3][3] = 1.0f;
+
+		return result;
+
+	}
+
+	//メッシュを置くノードとその行列
+	struct GltfInstance {
+
+		size_t meshIndex;
+
+		Matrix4x4 matrix;
+
+	};
+
+	void CollectGltfInstances(const std::vector<JsonValue>& nodes, size_t nodeIndex, const Matrix4x4& parentMatrix, int depth, std::vector<GltfInstance>& instances) {
+
+		//循環した壊れたファイルで止まらないように深さを制限する
+		if (nodeIndex >= nodes.size() || depth > 64) {
+			return;
+		}
+
+		const JsonValue& node = nodes[nodeIndex];
+
+		Matrix4x4 matrix = MultiplyMatrix(GetGltfNodeMatrix(node), parentMatrix);
+
+		//メッシュの番号の範囲はBuildMeshで確かめる。数でないものは置かない
+		size_t meshIndex = 0;
+
+		if (node.Find("mesh") != nullptr && GetGltfSize(node, "mesh", (std::numeric_limits<uint32_t>::max)(), meshIndex)) {
+			instances.push_back({ meshIndex, matrix });
+		}
+
+		if (const std::vector<JsonValue>* children = node.GetArray("children")) {
+			for (const JsonValue& child : *children) {
+				size_t childIndex = 0;
+				if (nodes.size() > 0 && ToGltfSize(child, nodes.size() - 1, childIndex)) {
+					CollectGltfInstances(nodes, childIndex, matrix, depth + 1, instances);
+				}
+			}
+		}
+
+	}
+
+	//1つのプリミティブを書き込む場所と読む場所
+	struct GltfPrimitiveJob {
+
+		GltfAccessor positions;
+		GltfAccessor normals;
+		GltfAccessor texcoords;
+		GltfAccessor indices;
+
+		bool hasNormals;
+		bool hasTexcoords;
+		bool hasIndices;
+
+		Matrix4x4 matrix;
+
+		//法線用の行列(左上3x3の逆転置)
+		float normalMatrix[3][3];
+
+		//鏡像になる行列なら三角形の向きがもう一度反転する
+		bool isMirrored;
+
+		size_t vertexOffset;
+		size_t indexOffset;
+		size_t indexCount;
+
+	};
+
+	class GltfLoader {
+
+	public:
+
+		bool Load(const std::string& path, MeshData& mesh, JobSystem* jobSystem) {
+
+			if (!file_.Open(path.c_str()) || file_.GetData() == nullptr) {
+				return false;
+			}
+
+			size_t separator = path.find_last_of("/\\");
+			directory_ = separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+
+			const char* jsonBegin = reinterpret_cast<const char*>(file_.GetData());
+			const char* jsonEnd = jsonBegin + file_.GetSize();
+
+			if (HasExtension(path, ".glb")) {
+				if (!ReadGlbChunks(jsonBegin, jsonEnd)) {
+					return false;
+				}
+			}
+
+			JsonValue root;
+
+			if (!JsonParser(jsonBegin, jsonEnd).Parse(root) || root.type != JsonValue::Type::kObject) {
+				return false;
+			}
+
+			return LoadBuffers(root) && BuildMesh(root, mesh, jobSystem);
+
+		}
+
+	private:
+
+		bool ReadGlbChunks(const char*& jsonBegin, const char*& jsonEnd) {
+
+			const uint8_t* data = file_.GetData();
+			size_t size = file_.GetSize();
+
+			uint32_t header[3];
+
+			if (size < sizeof(header)) {
+				return false;
+			}
+
+			std::memcpy(header, data, sizeof(header));
+
+			//"glTF"、バージョン2
+			if (header[0] != 0x46546c67 || header[1] != 2 || header[2] > size) {
+				return false;
+			}
+
+			size = header[2];
+
+			bool hasJson = false;
+
+			for (size_t offset = sizeof(header); offset + 8 <= size;) {
+
+				uint32_t chunkHeader[2];
+
+				std::memcpy(chunkHeader, data + offset, sizeof(chunkHeader));
+
+				offset += sizeof(chunkHeader);
+
+				if (chunkHeader[0] > size - offset) {
+					return false;
+				}
+
+				if (chunkHeader[1] == 0x4e4f534a && !hasJson) {
+					jsonBegin = reinterpret_cast<const char*>(data + offset);
+					jsonEnd = jsonBegin + chunkHeader[0];
+					hasJson = true;
+				} else if (chunkHeader[1] == 0x004e4942 && glbBinary_ == nullptr) {
+					glbBinary_ = data + offset;
+					glbBinarySize_ = chunkHeader[0];
+				}
+
+				offset += (chunkHeader[0] + 3) & ~size_t(3);
+
+			}
+
+			return hasJson;
+
+		}
+
+		bool LoadBuffers(const JsonValue& root) {
+
+			const std::vector<JsonValue>* buffers = root.GetArray("buffers");
+
+			if (buffers == nullptr) {
+				return true;
+			}
+
+			buffers_.resize(buffers->size());
+
+			for (size_t i = 0; i < buffers->size(); ++i) {
+
+				const JsonValue& bufferJson = (*buffers)[i];
+
+				GltfBuffer& buffer = buffers_[i];
+
+				const std::string* uri = bufferJson.GetString("uri");
+
+				if (uri == nullptr) {
+
+					//GLBの最初のバッファはBINチャンク
+					if (i != 0 || glbBinary_ == nullptr) {
+						return false;
+					}
+
+					buffer.data = glbBinary_;
+					buffer.size = glbBinarySize_;
+
+				} else if (uri->compare(0, 5, "data:") == 0) {
+
+					size_t comma = uri->find(',');
+
+					if (comma == std::string::npos || !Base64Decode(uri->data() + comma + 1, uri->data() + uri->size(), buffer.decoded)) {
+						return false;
+					}
+
+					buffer.data = buffer.decoded.data();
+					buffer.size = buffer.decoded.size();
+
+				} else {
+
+					buffer.file = std::make_unique<MappedFile>();
+
+					if (!buffer.file->Open((directory_ + DecodeUri(*uri)).c_str())) {
+						return false;
+					}
+
+					buffer.data = buffer.file->GetData();
+					buffer.size = buffer.file->GetSize();
+
+				}
+
+				//byteLengthは読めた大きさを超えてはいけない
+				size_t byteLength = 0;
+
+				if (!GetGltfSize(bufferJson, "byteLength", buffer.size, byteLength)) {
+					return false;
+				}
+
+			}
+
+			return true;
+
+		}
+
+		//ownerのkeyが指すアクセサを調べて、全要素が範囲内にあればtrue
+		bool GetAccessor(const JsonValue& root, const JsonValue& owner, const char* key, GltfAccessor& accessor) {
+
+			const std::vector<JsonValue>* accessors = root.GetArray("accessors");
+			const std::vector<JsonValue>* bufferViews = root.GetArray("bufferViews");
+
+			size_t accessorIndex = 0;
+
+			if (accessors == nullptr || bufferViews == nullptr || !GetGltfIndex(owner, key, accessors->size(), accessorIndex)) {
+				return false;
+			}
+
+			const JsonValue& accessorJson = (*accessors)[accessorIndex];
+
+			//疎なアクセサとバッファビューのないアクセサは扱わない
+			size_t bufferViewIndex = 0;
+
+			if (accessorJson.Find("sparse") != nullptr || !GetGltfIndex(accessorJson, "bufferView", bufferViews->size(), bufferViewIndex)) {
+				return false;
+			}
+
+			const JsonValue& bufferView = (*bufferViews)[bufferViewIndex];
+
+			size_t bufferIndex = 0;
+
+			if (!GetGltfIndex(bufferView, "buffer", buffers_.size(), bufferIndex)) {
+				return false;
+			}
+
+			const GltfBuffer& buffer = buffers_[bufferIndex];
+
+			const std::string* type = accessorJson.GetString("type");
+
+			size_t componentType = 0;
+
+			if (!GetGltfSize(accessorJson, "componentType", 0xffff, componentType)) {
+				return false;
+			}
+
+			accessor.componentType = static_cast<uint32_t>(componentType);
+			accessor.componentCount = type != nullptr ? GetGltfComponentCount(*type) : 0;
+			accessor.isNormalized = accessorJson.Find("normalized") != nullptr && accessorJson.Find("normalized")->boolean;
+
+			size_t componentSize = GetGltfComponentSize(accessor.componentType);
+
+			if (componentSize == 0 || accessor.componentCount == 0) {
+				return false;
+			}
+
+			size_t elementSize = componentSize * accessor.componentCount;
+
+			//位置と長さはバッファの中に収まる値だけを読む(要素は1バイト以上なので、個数もバッファの大きさを超えない)
+			size_t viewOffset = 0;
+			size_t viewLength = 0;
+			size_t accessorOffset = 0;
+
+			accessor.count = 0;
+			accessor.stride = 0;
+
+			if (!GetGltfSize(bufferView, "byteOffset", buffer.size, viewOffset) ||
+				!GetGltfSize(bufferView, "byteLength", buffer.size - viewOffset, viewLength) ||
+				!GetGltfSize(bufferView, "byteStride", kMaxGltfByteStride, accessor.stride) ||
+				!GetGltfSize(accessorJson, "byteOffset", viewLength, accessorOffset) ||
+				!GetGltfSize(accessorJson, "count", buffer.size, accessor.count)) {
+				return false;
+			}
+
+			if (accessor.stride == 0) {
+				accessor.stride = elementSize;
+			}
+
+			size_t available = viewLength - accessorOffset;
+
+			if (accessor.stride < elementSize) {
+				return false;
+			}
+
+			//(count - 1) * strideは桁あふれしうるので、割り算で範囲を確かめる
+			if (accessor.count > 0 && (available < elementSize || accessor.count - 1 > (available - elementSize) / accessor.stride)) {
+				return false;
+			}
+
+			accessor.data = buffer.data + viewOffset + accessorOffset;
+
+			return true;
+
+		}
+
+		bool BuildMesh(const JsonValue& root, MeshData& mesh, JobSystem* jobSystem) {
+
+			const std::vector<JsonValue>* meshes = root.GetArray("meshes");
+
+			if (meshes == nullptr) {
+				return false;
+			}
+
+			//シーンのノードを辿ってメッシュを置く。ノードがなければメッシュをそのまま並べる
+			std::vector<GltfInstance> instances;
+
+			const std::vector<JsonValue>* nodes = root.GetArray("nodes");
+			const std::vector<JsonValue>* scenes = root.GetArray("scenes");
+
+			if (nodes != nullptr) {
+
+				size_t sceneIndex = 0;
+
+				if (!GetGltfSize(root, "scene", (std::numeric_limits<uint32_t>::max)(), sceneIndex)) {
+					return false;
+				}
+
+				if (scenes != nullptr && sceneIndex < scenes->size() && (*scenes)[sceneIndex].GetArray("nodes") != nullptr) {
+
+					for (const JsonValue& nodeJson : *(*scenes)[sceneIndex].GetArray("nodes")) {
+
+						size_t nodeIndex = 0;
+
+						if (nodes->empty() || !ToGltfSize(nodeJson, nodes->size() - 1, nodeIndex)) {
+							return false;
+						}
+
+						CollectGltfInstances(*nodes, nodeIndex, IdentityMatrix(), 0, instances);
+
+					}
+
+				} else {
+
+					//シーンがなければ、どのノードの子でもないノードから辿る
+					std::vector<bool> isChild(nodes->size(), false);
+
+					for (const JsonValue& node : *nodes) {
+						if (const std::vector<JsonValue>* children = node.GetArray("children")) {
+							for (const JsonValue& child : *children) {
+								size_t childIndex = 0;
+								if (!nodes->empty() && ToGltfSize(child, nodes->size() - 1, childIndex)) {
+									isChild[childIndex] = true;
+								}
+							}
+						}
+					}
+
+					for (size_t i = 0; i < nodes->size(); ++i) {
+						if (!isChild[i]) {
+							CollectGltfInstances(*nodes, i, IdentityMatrix(), 0, instances);
+						}
+					}
+
+				}
+
+			} else {
+
+				for (size_t i = 0; i < meshes->size(); ++i) {
+					instances.push_back({ i, IdentityMatrix() });
+				}
+
+			}
+
+			std::vector<GltfPrimitiveJob> jobs;
+
+			size_t vertexCount = 0;
+			size_t indexCount = 0;
+
+			for (const GltfInstance& instance : instances) {
+
+				if (instance.meshIndex >= meshes->size()) {
+					return false;
+				}
+
+				const std::vector<JsonValue>* primitives = (*meshes)[instance.meshIndex].GetArray("primitives");
+
+				if (primitives == nullptr) {
+					continue;
+				}
+
+				for (const JsonValue& primitive : *primitives) {
+
+					//三角形リスト以外は読み飛ばす
+					size_t mode = kGltfTriangles;
+
+					if (!GetGltfSize(primitive, "mode", 0xffff, mode)) {
+						return false;
+					}
+
+					if (mode != kGltfTriangles) {
+						continue;
+					}
+
+					const JsonValue* attributes = primitive.Find("attributes");
+
+					if (attributes == nullptr) {
+						return false;
+					}
+
+					GltfPrimitiveJob job{};
+
+					if (!GetAccessor(root, *attributes, "POSITION", job.positions) || job.positions.componentCount != 3 || job.positions.componentType != kGltfFloat) {
+						return false;
+					}
+
+					job.hasNormals = attributes->Find("NORMAL") != nullptr;
+					job.hasTexcoords = attributes->Find("TEXCOORD_0") != nullptr;
+					job.hasIndices = primitive.Find("indices") != nullptr;
+
+					if (job.hasNormals && (!GetAccessor(root, *attributes, "NORMAL", job.normals) || job.normals.componentCount != 3 || job.normals.count != job.positions.count)) {
+						return false;
+					}
+
+					if (job.hasTexcoords && (!GetAccessor(root, *attributes, "TEXCOORD_0", job.texcoords) || job.texcoords.componentCount != 2 || job.texcoords.count != job.positions.count)) {
+						return false;
+					}
+
+					if (job.hasIndices) {
+
+						if (!GetAccessor(root, primitive, "indices", job.indices) || job.indices.componentCount != 1) {
+							return false;
+						}
+
+						if (job.indices.componentType != kGltfUnsignedByte && job.indices.componentType != kGltfUnsignedShort && job.indices.componentType != kGltfUnsignedInt) {
+							return false;
+						}
+
+					}
+
+					job.matrix = instance.matrix;
+
+					SetNormalMatrix(job);
+
+					job.vertexOffset = vertexCount;
+					job.indexOffset = indexCount;
+					job.indexCount = (job.hasIndices ? job.indices.count : job.positions.count) / 3 * 3;
+
+					vertexCount += job.positions.count;
+					indexCount += job.indexCount;
+
+					jobs.push_back(job);
+
+				}
+
+			}
+
+			if (vertexCount > 0xffffffffull || indexCount == 0) {
+				return false;
+			}
+
+			mesh.vertices.resize(vertexCount);
+			mesh.indices.resize(indexCount);
+
+			std::atomic<bool> hasInvalidIndex = false;
+
+			for (const GltfPrimitiveJob& job : jobs) {
+
+				//頂点を行列で変換し、zを反転して左手系にする
+				RunParallel(jobSystem, job.positions.count, kMinVertexChunkSize, [&](size_t begin, size_t end) {
+					for (size_t i = begin; i < end; ++i) {
+						WriteVertex(job, i, mesh.vertices[job.vertexOffset + i]);
+					}
+				});
+
+				//zの反転で向きが変わるので、鏡像の行列でなければ2番目と3番目を入れ替える
+				RunParallel(jobSystem, job.indexCount / 3, kMinVertexChunkSize, [&](size_t begin, size_t end) {
+
+					for (size_t triangle = begin; triangle < end; ++triangle) {
+
+						uint32_t corners[3];
+
+						for (size_t k = 0; k < 3; ++k) {
+
+							size_t i = triangle * 3 + k;
+
+							corners[k] = job.hasIndices ? ReadGltfIndex(job.indices, i) : static_cast<uint32_t>(i);
+
+							if (corners[k] >= job.positions.count) {
+								hasInvalidIndex = true;
+								corners[k] = 0;
+							}
+
+						}
+
+						uint32_t* out = &mesh.indices[job.indexOffset + triangle * 3];
+
+						out[0] = static_cast<uint32_t>(job.vertexOffset + corners[0]);
+						out[1] = static_cast<uint32_t>(job.vertexOffset + (job.isMirrored ? corners[1] : corners[2]));
+						out[2] = static_cast<uint32_t>(job.vertexOffset + (job.isMirrored ? corners[2] : corners[1]));
+
+					}
+
+				});
+
+			}
+
+			if (hasInvalidIndex) {
+				return false;
+			}
+
+			bool hasAllNormals = true;
+
+			for (const GltfPrimitiveJob& job : jobs) {
+				hasAllNormals = hasAllNormals && job.hasNormals;
+			}
+
+			if (!hasAllNormals) {
+				ComputeVertexNormals(mesh);
+			}
+
+			return true;
+
+		}
+
+		static void SetNormalMatrix(GltfPrimitiveJob& job) {
+
+			const Matrix4x4& m = job.matrix;
+
+			//余因子行列は逆転置行列の定数倍なので、正規化すれば法線の変換に使える
+			job.normalMatrix[0][0] = m.m[1][1] * m.m[2][2] - m.m[1][2] * m.m[2][1];
+			job.normalMatrix[0][1] = m.m[1][2] * m.m[2][0] - m.m[1][0] * m.m[2][2];
+			job.normalMatrix[0][2] = m.m[1][0] * m.m[2][1] - m.m[1][1] * m.m[2][0];
+			job.normalMatrix[1][0] = m.m[2][1] * m.m[0][2] - m.m[2][2] * m.m[0][1];
+			job.normalMatrix[1][1] = m.m[2][2] * m.m[0][0] - m.m[2][0] * m.m[0][2];
+			job.normalMatrix[1][2] = m.m[2][0] * m.m[0][1] - m.m[2][1] * m.m[0][0];
+			job.normalMatrix[2][0] = m.m[0][1] * m.m[1][2] - m.m[0][2] * m.m[1][1];
+			job.normalMatrix[2][1] = m.m[0][2] * m.m[1][0] - m.m[0][0] * m.m[1][2];
+			job.normalMatrix[2][2] = m.m[0][0] * m.m[1][1] - m.m[0][1] * m.m[1][0];
+
+			float determinant = m.m[0][0] * job.normalMatrix[0][0] + m.m[0][1] * job.normalMatrix[0][1] + m.m[0][2] * job.normalMatrix[0][2];
+
+			job.isMirrored = determinant < 0.0f;
+
+		}
+
+		static void WriteVertex(const GltfPrimitiveJob& job, size_t index, MeshVertex& vertex) {
+
+			float position[3];
+
+			const uint8_t* p = job.positions.data + job.positions.stride * index;
+
+			std::memcpy(position, p, sizeof(position));
+
+			const Matrix4x4& m = job.matrix;
+
+			vertex.position.x = position[0] * m.m[0][0] + position[1] * m.m[1][0] + position[2] * m.m[2][0] + m.m[3][0];
+			vertex.position.y = position[0] * m.m[0][1] + position[1] * m.m[1][1] + position[2] * m.m[2][1] + m.m[3][1];
+			vertex.position.z = -(position[0] * m.m[0][2] + position[1] * m.m[1][2] + position[2] * m.m[2][2] + m.m[3][2]);
+			vertex.position.w = 1.0f;
+
+			vertex.normal = { 0.0f, 0.0f, 0.0f };
+
+			if (job.hasNormals) {
+
+				const uint8_t* q = job.normals.data + job.normals.stride * index;
+
+				size_t componentSize = GetGltfComponentSize(job.normals.componentType);
+
+				float normal[3];
+
+				for (int i = 0; i < 3; ++i) {
+					normal[i] = ReadGltfComponent(q + componentSize * i, job.normals.componentType, job.normals.isNormalized);
+				}
+
+				const float (*n)[3] = job.normalMatrix;
+
+				Vector3 transformed = Normalize({
+					normal[0] * n[0][0] + normal[1] * n[1][0] + normal[2] * n[2][0],
+					normal[0] * n[0][1] + normal[1] * n[1][1] + normal[2] * n[2][1],
+					normal[0] * n[0][2] + normal[1] * n[1][2] + normal[2] * n[2][2] });
+
+				vertex.normal = { transformed.x, transformed.y, -transformed.z };
+
+			}
+
+			vertex.texcoord = { 0.0f, 0.0f };
+
+			//glTFのUVは左上が原点なのでそのまま使う
+			if (job.hasTexcoords) {
+
+				const uint8_t* q = job.texcoords.data + job.texcoords.stride * index;
+
+				size_t componentSize = GetGltfComponentSize(job.texcoords.componentType);
+
+				vertex.texcoord.x = ReadGltfComponent(q, job.texcoords.componentType, job.texcoords.isNormalized);
+				vertex.texcoord.y = ReadGltfComponent(q + componentSize, job.texcoords.componentType, job.texcoords.isNormalized);
+
+			}
+
+		}
+
+		MappedFile file_;
+
+		std::string directory_;
+
+		const uint8_t* glbBinary_ = nullptr;
+
+		size_t glbBinarySize_ = 0;
+
+		std::vector<GltfBuffer> buffers_;
+
+	};
+
+}
+
+const char* ParseFloat(const char* begin, const char* end, float& value) {
+
+	//10の累乗(doubleで正確に表せる範囲)
+	static const double kPowersOfTen[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+
+	const char* p = begin;
+
+	bool isNegative = false;
+
+	if (p < end && (*p == '-' || *p == '+')) {
+		isNegative = *p == '-';
+		++p;
+	}
+
+	//19桁までは整数のまま貯め、それ以降の桁は指数だけ数える
+	uint64_t mantissa = 0;
+	int digitCount = 0;
+	int exponent = 0;
+	bool hasDigits = false;
+
+	while (p < end && IsDigit(*p)) {
+		if (digitCount < 19) {
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+			if (mantissa != 0) {
+				++digitCount;
+			}
+		} else {
+			++exponent;
+		}
+		hasDigits = true;
+		++p;
+	}
+
+	if (p < end && *p == '.') {
+
+		++p;
+
+		while (p < end && IsDigit(*p)) {
+			if (digitCount < 19) {
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+				--exponent;
+				if (mantissa != 0) {
+					++digitCount;
+				}
+			}
+			hasDigits = true;
+			++p;
+		}
+
+	}
+
+	if (!hasDigits) {
+		return begin;
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E')) {
+
+		const char* q = p + 1;
+
+		bool isExponentNegative = false;
+
+		if (q < end && (*q == '-' || *q == '+')) {
+			isExponentNegative = *q == '-';
+			++q;
+		}
+
+		if (q < end && IsDigit(*q)) {
+
+			int exponentValue = 0;
+
+			while (q < end && IsDigit(*q)) {
+				exponentValue = (std::min)(exponentValue * 10 + (*q - '0'), 10000);
+				++q;
+			}
+
+			exponent += isExponentNegative ? -exponentValue : exponentValue;
+
+			p = q;
+
+		}
+
+	}
+
+	double result = static_cast<double>(mantissa);
+
+	if (mantissa != 0) {
+		if (exponent >= 0 && exponent <= 22) {
+			result *= kPowersOfTen[exponent];
+		} else if (exponent < 0 && exponent >= -22) {
+			result /= kPowersOfTen[-exponent];
+		} else {
+			result *= std::pow(10.0, exponent);
+		}
+	}
+
+	value = static_cast<float>(isNegative ? -result : result);
+
+	return p;
+
+}
+
+bool ParseObj(const char* text, size_t size, MeshData& mesh, JobSystem* jobSystem) {
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	//ファイルを改行の位置で塊に分ける。スレッド数より多めに分けて偏りをならす
+	uint32_t chunkCount = 1;
+
+	if (jobSystem != nullptr) {
+		chunkCount = static_cast<uint32_t>((std::min)(size / kMinObjChunkSize + 1, static_cast<size_t>(jobSystem->GetThreadCount()) * 4));
+	}
+
+	std::vector<ObjChunk> chunks(chunkCount);
+
+	const char* textEnd = text + size;
+
+	const char* chunkBegin = text;
+
+	for (uint32_t i = 0; i < chunkCount; ++i) {
+
+		const char* chunkEnd = i + 1 == chunkCount ? textEnd : text + size / chunkCount * (i + 1);
+
+		if (chunkEnd < chunkBegin) {
+			chunkEnd = chunkBegin;
+		}
+
+		if (chunkEnd < textEnd) {
+			const char* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', textEnd - chunkEnd));
+			chunkEnd = newline != nullptr ? newline + 1 : textEnd;
+		}
+
+		chunks[i].begin = chunkBegin;
+		chunks[i].end = chunkEnd;
+		chunks[i].isFailed = false;
+
+		chunkBegin = chunkEnd;
+
+	}
+
+	auto forEachChunk = [&](const std::function<void(ObjChunk&)>& function) {
+		if (jobSystem != nullptr) {
+			jobSystem->Dispatch(chunkCount, [&](uint32_t chunkIndex) { function(chunks[chunkIndex]); });
+		} else {
+			function(chunks[0]);
+		}
+	};
+
+	forEachChunk(ParseObjChunk);
+
+	//前の塊までの数を数えて、負のインデックスを全体の位置に直す
+	size_t positionCount = 0;
+	size_t texcoordCount = 0;
+	size_t normalCount = 0;
+	size_t cornerCount = 0;
+
+	for (ObjChunk& chunk : chunks) {
+
+		if (chunk.isFailed) {
+			return false;
+		}
+
+		chunk.positionBase = positionCount;
+		chunk.texcoordBase = texcoordCount;
+		chunk.normalBase = normalCount;
+
+		positionCount += chunk.positions.size();
+		texcoordCount += chunk.texcoords.size();
+		normalCount += chunk.normals.size();
+		cornerCount += chunk.corners.size();
+
+	}
+
+	if (cornerCount == 0 || positionCount > 0x7fffffff) {
+		return false;
+	}
+
+	std::vector<Vector3> positions(positionCount);
+	std::vector<Vector2> texcoords(texcoordCount);
+	std::vector<Vector3> normals(normalCount);
+
+	forEachChunk([&](ObjChunk& chunk) {
+
+		if (!ResolveObjCorners(chunk, positionCount, texcoordCount, normalCount)) {
+			chunk.isFailed = true;
+		}
+
+		std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase);
+		std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), texcoords.begin() + chunk.texcoordBase);
+		std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase);
+
+		//もう使わないので先に手放して、メモリの最大量を抑える
+		std::vector<Vector3>().swap(chunk.positions);
+		std::vector<Vector2>().swap(chunk.texcoords);
+		std::vector<Vector3>().swap(chunk.normals);
+
+	});
+
+	for (const ObjChunk& chunk : chunks) {
+		if (chunk.isFailed) {
+			return false;
+		}
+	}
+
+	//位置/UV/法線の組み合わせが同じ角を1つの頂点にまとめる
+	//頂点の番号は初めて出てきた順に振るので、ここは1つのスレッドで順に処理する
+	std::vector<ObjCorner> uniqueCorners;
+
+	uniqueCorners.reserve(positionCount + positionCount / 4);
+
+	size_t tableSize = NextPowerOfTwo((std::max)(positionCount * 2, size_t(1024)));
+
+	std::vector<uint32_t> table(tableSize, 0xffffffff);
+
+	mesh.indices.resize(cornerCount);
+
+	size_t indexCount = 0;
+
+	for (ObjChunk& chunk : chunks) {
+
+		for (const ObjCorner& corner : chunk.corners) {
+
+			//半分を超えたら広げて入れ直す
+			if (uniqueCorners.size() * 2 >= tableSize) {
+
+				tableSize *= 2;
+
+				table.assign(tableSize, 0xffffffff);
+
+				for (uint32_t i = 0; i < uniqueCorners.size(); ++i) {
+					size_t slot = HashCorner(uniqueCorners[i]) & (tableSize - 1);
+					while (table[slot] != 0xffffffff) {
+						slot = (slot + 1) & (tableSize - 1);
+					}
+					table[slot] = i;
+				}
+
+			}
+
+			size_t slot = HashCorner(corner) & (tableSize - 1);
+
+			while (table[slot] != 0xffffffff && !IsSameCorner(uniqueCorners[table[slot]], corner)) {
+				slot = (slot + 1) & (tableSize - 1);
+			}
+
+			if (table[slot] == 0xffffffff) {
+				table[slot] = static_cast<uint32_t>(uniqueCorners.size());
+				uniqueCorners.push_back(corner);
+			}
+
+			mesh.indices[indexCount++] = table[slot];
+
+		}
+
+		std::vector<ObjCorner>().swap(chunk.corners);
+
+	}
+
+	std::vector<uint32_t>().swap(table);
+
+	//頂点を組み立てる。zを反転して左手系にし、UVは上下を反転して左上を原点にする
+	mesh.vertices.resize(uniqueCorners.size());
+
+	RunParallel(jobSystem, uniqueCorners.size(), kMinVertexChunkSize, [&](size_t begin, size_t end) {
+
+		for (size_t i = begin; i < end; ++i) {
+
+			const ObjCorner& corner = uniqueCorners[i];
+
+			MeshVertex& vertex = mesh.vertices[i];
+
+			const Vector3& position = positions[corner.position];
+
+			vertex.position = { position.x, position.y, -position.z, 1.0f };
+
+			if (corner.normal != kMissingIndex) {
+				const Vector3& normal = normals[corner.normal];
+				vertex.normal = { normal.x, normal.y, -normal.z };
+			} else {
+				vertex.normal = { 0.0f, 0.0f, 0.0f };
+			}
+
+			if (corner.texcoord != kMissingIndex) {
+				const Vector2& texcoord = texcoords[corner.texcoord];
+				vertex.texcoord = { texcoord.x, 1.0f - texcoord.y };
+			} else {
+				vertex.texcoord = { 0.0f, 0.0f };
+			}
+
+		}
+
+	});
+
+	if (normalCount == 0) {
+		ComputeVertexNormals(mesh);
+	}
+
+	ComputeBounds(mesh, jobSystem);
+
+	return true;
+
+}
+
+bool ImportObj(const char* path, MeshData& mesh, JobSystem* jobSystem) {
+
+	MappedFile file;
+
+	if (!file.Open(path) || file.GetData() == nullptr) {
+		return false;
+	}
+
+	return ParseObj(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), mesh, jobSystem);
+
+}
+
+bool ImportGltf(const char* path, MeshData& mesh, JobSystem* jobSystem) {
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	GltfLoader loader;
+
+	if (!loader.Load(path, mesh, jobSystem)) {
+		mesh.vertices.clear();
+		mesh.indices.clear();
+		return false;
+	}
+
+	ComputeBounds(mesh, jobSystem);
+
+	return true;
+
+}
+
+bool ImportMesh(const char* path, MeshData& mesh, JobSystem* jobSystem) {
+
+	std::string pathString = path;
+
+	if (HasExtension(pathString, ".obj")) {
+		return ImportObj(path, mesh, jobSystem);
+	}
+
+	if (HasExtension(pathString, ".gltf") || HasExtension(pathString, ".glb")) {
+		return ImportGltf(path, mesh, jobSystem);
+	}
+
+	return false;
+
+}
+
+void DeduplicateVertices(MeshData& mesh) {
+
+	if (mesh.indices.empty()) {
+		mesh.indices.resize(mesh.vertices.size());
+		for (size_t i = 0; i < mesh.indices.size(); ++i) {
+			mesh.indices[i] = static_cast<uint32_t>(i);
+		}
+	}
+
+	//頂点のバイト列で比べる(パディングのない構造なので中身が同じなら同じ頂点)
+	static_assert(sizeof(MeshVertex) == sizeof(float) * 9, "MeshVertex must not have padding");
+
+	auto hashVertex = [](const MeshVertex& vertex) {
+		const uint32_t* words = reinterpret_cast<const uint32_t*>(&vertex);
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < sizeof(MeshVertex) / sizeof(uint32_t); ++i) {
+			hash = (hash ^ words[i]) * 16777619u;
+		}
+		return hash ^ (hash >> 16);
+	};
+
+	size_t tableSize = NextPowerOfTwo((std::max)(mesh.vertices.size() * 2, size_t(16)));
+
+	std::vector<uint32_t> table(tableSize, 0xffffffff);
+
+	std::vector<uint32_t> remap(mesh.vertices.size());
+
+	std::vector<MeshVertex> uniqueVertices;
+
+	uniqueVertices.reserve(mesh.vertices.size());
+
+	for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+
+		const MeshVertex& vertex = mesh.vertices[i];
+
+		size_t slot = hashVertex(vertex) & (tableSize - 1);
+
+		while (table[slot] != 0xffffffff && std::memcmp(&uniqueVertices[table[slot]], &vertex, sizeof(MeshVertex)) != 0) {
+			slot = (slot + 1) & (tableSize - 1);
+		}
+
+		if (table[slot] == 0xffffffff) {
+			table[slot] = static_cast<uint32_t>(uniqueVertices.size());
+			uniqueVertices.push_back(vertex);
+		}
+
+		remap[i] = table[slot];
+
+	}
+
+	for (uint32_t& index : mesh.indices) {
+		index = remap[index];
+	}
+
+	mesh.vertices = std::move(uniqueVertices);
+
+}
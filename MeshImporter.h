@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "MathTypes.h"
+#include "FrustumCulling.h"
+#include "JobSystem.h"
+
+//インポートした頂点(kFullVertexLayoutDescの並びと同じ。GPUにはVertexFormatで詰めてから置く)
+struct MeshVertex {
+
+	Vector4 position;
+	Vector3 normal;
+	Vector2 texcoord;
+
+};
+
+//LOD1段分のインデックスの範囲(頂点はすべての段で共有する)
+struct MeshLod {
+
+	uint32_t indexOffset;
+	uint32_t indexCount;
+
+	//元のメッシュからのずれ(メッシュの単位)
+	float error;
+
+	uint32_t reserved;
+
+};
+
+//LOD0の三角形を分けたクラスタ(メッシュシェーダーでもそのまま読める並び)
+//triangleOffsetはLOD0のインデックスの中の三角形の位置とも一致する(LOD0はメッシュレットの順に並べておく)
+struct Meshlet {
+
+	//meshletVerticesとmeshletTrianglesの中の範囲
+	uint32_t vertexOffset;
+	uint32_t vertexCount;
+	uint32_t triangleOffset;
+	uint32_t triangleCount;
+
+	//囲む球(メッシュの単位)
+	Vector3 center;
+	float radius;
+
+	//法線の円錐の軸と、裏向きの判定に使う開き角のsin(1なら判定しない)
+	Vector3 coneAxis;
+	float coneCutoff;
+
+};
+
+static_assert(sizeof(Meshlet) == 48, "Meshlet layout changed");
+
+//アップロードできる形に詰めた頂点とインデックス(三角形リスト)
+struct MeshData {
+
+	std::vector<MeshVertex> vertices;
+
+	std::vector<uint32_t> indices;
+
+	AABB bounds;
+
+	//細かい順に並べたLOD(空ならインデックス全体が1段)
+	std::vector<MeshLod> lods;
+
+	//LOD0のメッシュレット(空なら作っていない)
+	std::vector<Meshlet> meshlets;
+
+	//メッシュレットの頂点(頂点の配列の位置)
+	std::vector<uint32_t> meshletVertices;
+
+	//メッシュレットの三角形(メッシュレットの中の頂点の番号を8bitずつ3つ詰めたもの)
+	std::vector<uint32_t> meshletTriangles;
+
+};
+
+//メッシュの中身を指すだけのもの(MeshDataでも、マップしたファイルでも同じように渡せる)
+struct MeshView {
+
+	const MeshVertex* vertices;
+	size_t vertexCount;
+
+	const uint32_t* indices;
+	size_t indexCount;
+
+	AABB bounds;
+
+	const MeshLod* lods;
+	size_t lodCount;
+
+	const Meshlet* meshlets;
+	size_t meshletCount;
+
+	const uint32_t* meshletVertices;
+	size_t meshletVertexCount;
+
+	const uint32_t* meshletTriangles;
+	size_t meshletTriangleCount;
+
+};
+
+inline MeshView MakeMeshView(const MeshData& mesh) {
+	return { mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), mesh.bounds, mesh.lods.data(), mesh.lods.size(),
+		mesh.meshlets.data(), mesh.meshlets.size(), mesh.meshletVertices.data(), mesh.meshletVertices.size(), mesh.meshletTriangles.data(), mesh.meshletTriangles.size() };
+}
+
+//OBJ(.obj)とglTF(.gltf/.glb)を読む。ファイルはメモリにマップして、ジョブシステムで分けて解析する
+//どちらも右手系なので、zを反転して三角形の向きを入れ替え、左手系にして返す
+//jobSystemがnullptrなら呼び出したスレッドだけで処理する
+bool ImportMesh(const char* path, MeshData& mesh, JobSystem* jobSystem);
+
+bool ImportObj(const char* path, MeshData& mesh, JobSystem* jobSystem);
+
+bool ImportGltf(const char* path, MeshData& mesh, JobSystem* jobSystem);
+
+//OBJのテキストを解析する(ImportObjから呼ぶ。メモリ上のデータを直接読みたい時にも使う)
+bool ParseObj(const char* text, size_t size, MeshData& mesh, JobSystem* jobSystem);
+
+//同じ頂点をハッシュテーブルで1つにまとめ、インデックスを振り直す(インデックスのないメッシュにも使う)
+void DeduplicateVertices(MeshData& mesh);
+
+//数値の文字列を高速に読む(読んだ後の位置を返す。読めなければbeginを返す)
+const char* ParseFloat(const char* begin, const char* end, float& value);
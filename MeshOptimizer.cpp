@@ -0,0 +1,460 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+	//頂点から、それを使う三角形を引く表
+	struct TriangleAdjacency {
+
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> counts;
+		std::vector<uint32_t> triangles;
+
+	};
+
+	void BuildTriangleAdjacency(TriangleAdjacency& adjacency, const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+
+		adjacency.counts.assign(vertexCount, 0);
+		adjacency.offsets.resize(vertexCount);
+		adjacency.triangles.resize(indexCount);
+
+		for (size_t i = 0; i < indexCount; ++i) {
+			++adjacency.counts[indices[i]];
+		}
+
+		uint32_t offset = 0;
+
+		for (size_t i = 0; i < vertexCount; ++i) {
+			adjacency.offsets[i] = offset;
+			offset += adjacency.counts[i];
+		}
+
+		//offsetsを書き込み位置として使い、後で戻す
+		for (size_t i = 0; i < indexCount; ++i) {
+			adjacency.triangles[adjacency.offsets[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		for (size_t i = 0; i < vertexCount; ++i) {
+			adjacency.offsets[i] -= adjacency.counts[i];
+		}
+
+	}
+
+	//FIFOのキャッシュ(頂点ごとに入った時刻を持ち、cacheSize回より前なら追い出されたとみなす)
+	class FifoCacheSimulator {
+
+	public:
+
+		FifoCacheSimulator(size_t vertexCount, uint32_t cacheSize) : timestamps_(vertexCount, 0), time_(cacheSize + 1), cacheSize_(cacheSize) {}
+
+		//キャッシュになければ入れてtrue
+		bool Access(uint32_t vertex) {
+
+			if (time_ - timestamps_[vertex] > cacheSize_) {
+				timestamps_[vertex] = time_++;
+				return true;
+			}
+
+			return false;
+
+		}
+
+		//時刻を進めて全部追い出す
+		void Clear() {
+			time_ += cacheSize_ + 1;
+		}
+
+	private:
+
+		std::vector<uint32_t> timestamps_;
+
+		uint32_t time_;
+
+		uint32_t cacheSize_;
+
+	};
+
+	//Tipsifyで次に扇の中心にする頂点を選ぶ
+	int64_t GetNextVertex(const std::vector<uint32_t>& candidates, const std::vector<uint32_t>& liveCounts, const std::vector<uint32_t>& timestamps, uint32_t time, uint32_t cacheSize, std::vector<uint32_t>& deadEndStack, size_t& cursor, size_t vertexCount) {
+
+		int64_t bestVertex = -1;
+		int64_t bestPriority = -1;
+
+		for (uint32_t vertex : candidates) {
+
+			if (liveCounts[vertex] == 0) {
+				continue;
+			}
+
+			//残りの三角形を描いてもキャッシュに残っている頂点のうち、最も古いものを選ぶ
+			int64_t priority = 0;
+
+			if (time - timestamps[vertex] + 2 * liveCounts[vertex] <= cacheSize) {
+				priority = time - timestamps[vertex];
+			}
+
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				bestVertex = vertex;
+			}
+
+		}
+
+		if (bestVertex >= 0) {
+			return bestVertex;
+		}
+
+		//行き止まり。最近使った頂点から残りのあるものを探し、なければ番号順に探す
+		while (!deadEndStack.empty()) {
+			uint32_t vertex = deadEndStack.back();
+			deadEndStack.pop_back();
+			if (liveCounts[vertex] > 0) {
+				return vertex;
+			}
+		}
+
+		while (cursor < vertexCount) {
+			if (liveCounts[cursor] > 0) {
+				return static_cast<int64_t>(cursor);
+			}
+			++cursor;
+		}
+
+		return -1;
+
+	}
+
+}
+
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+
+	VertexCacheStatistics statistics{};
+
+	FifoCacheSimulator cache(vertexCount, cacheSize);
+
+	std::vector<bool> isUsed(vertexCount, false);
+
+	size_t usedVertexCount = 0;
+
+	for (size_t i = 0; i < indexCount; ++i) {
+
+		if (cache.Access(indices[i])) {
+			++statistics.vertexTransformCount;
+		}
+
+		if (!isUsed[indices[i]]) {
+			isUsed[indices[i]] = true;
+			++usedVertexCount;
+		}
+
+	}
+
+	size_t triangleCount = indexCount / 3;
+
+	statistics.acmr = triangleCount > 0 ? float(statistics.vertexTransformCount) / float(triangleCount) : 0.0f;
+	statistics.atvr = usedVertexCount > 0 ? float(statistics.vertexTransformCount) / float(usedVertexCount) : 0.0f;
+
+	return statistics;
+
+}
+
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+
+	size_t triangleCount = indexCount / 3;
+
+	if (triangleCount == 0) {
+		return;
+	}
+
+	//destinationとindicesが同じ時のために入力を写しておく
+	std::vector<uint32_t> source(indices, indices + triangleCount * 3);
+
+	TriangleAdjacency adjacency;
+
+	BuildTriangleAdjacency(adjacency, source.data(), source.size(), vertexCount);
+
+	std::vector<uint32_t> liveCounts = adjacency.counts;
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+
+	std::vector<bool> isEmitted(triangleCount, false);
+
+	std::vector<uint32_t> deadEndStack;
+
+	std::vector<uint32_t> candidates;
+
+	uint32_t time = cacheSize + 1;
+
+	size_t cursor = 0;
+
+	size_t outputIndex = 0;
+
+	int64_t fanVertex = GetNextVertex(candidates, liveCounts, timestamps, time, cacheSize, deadEndStack, cursor, vertexCount);
+
+	while (fanVertex >= 0) {
+
+		candidates.clear();
+
+		uint32_t fan = static_cast<uint32_t>(fanVertex);
+
+		//中心の頂点を使う三角形をすべて出す
+		for (uint32_t k = 0; k < adjacency.counts[fan]; ++k) {
+
+			uint32_t triangle = adjacency.triangles[adjacency.offsets[fan] + k];
+
+			if (isEmitted[triangle]) {
+				continue;
+			}
+
+			isEmitted[triangle] = true;
+
+			for (int corner = 0; corner < 3; ++corner) {
+
+				uint32_t vertex = source[triangle * 3 + corner];
+
+				destination[outputIndex++] = vertex;
+
+				deadEndStack.push_back(vertex);
+
+				candidates.push_back(vertex);
+
+				--liveCounts[vertex];
+
+				if (time - timestamps[vertex] > cacheSize) {
+					timestamps[vertex] = time++;
+				}
+
+			}
+
+		}
+
+		fanVertex = GetNextVertex(candidates, liveCounts, timestamps, time, cacheSize, deadEndStack, cursor, vertexCount);
+
+	}
+
+	//3で割り切れない端数はそのまま残す
+	for (size_t i = triangleCount * 3; i < indexCount; ++i) {
+		destination[i] = indices[i];
+	}
+
+}
+
+void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold, uint32_t cacheSize) {
+
+	size_t triangleCount = indexCount / 3;
+
+	if (triangleCount == 0) {
+		return;
+	}
+
+	std::vector<uint32_t> source(indices, indices + triangleCount * 3);
+
+	auto getPosition = [&](uint32_t vertex) {
+		return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + positionStride * vertex);
+	};
+
+	//3頂点ともキャッシュになかった所はキャッシュが途切れているので、必ずクラスタを分ける
+	std::vector<uint32_t> hardStarts;
+
+	{
+		FifoCacheSimulator cache(vertexCount, cacheSize);
+
+		for (size_t i = 0; i < triangleCount; ++i) {
+			int misses = cache.Access(source[i * 3]) + cache.Access(source[i * 3 + 1]) + cache.Access(source[i * 3 + 2]);
+			if (i == 0 || misses == 3) {
+				hardStarts.push_back(static_cast<uint32_t>(i));
+			}
+		}
+
+		hardStarts.push_back(static_cast<uint32_t>(triangleCount));
+	}
+
+	//その間でも、空のキャッシュから始めたACMRがそのクラスタ全体のthreshold倍以下になった所で分ける
+	//どのクラスタも空のキャッシュで測っているので、並べ替えてもACMRはおよそthreshold倍までしか悪くならない
+	std::vector<uint32_t> clusterStarts;
+
+	{
+		FifoCacheSimulator cache(vertexCount, cacheSize);
+
+		for (size_t h = 0; h + 1 < hardStarts.size(); ++h) {
+
+			uint32_t begin = hardStarts[h];
+			uint32_t end = hardStarts[h + 1];
+
+			cache.Clear();
+
+			size_t hardMisses = 0;
+
+			for (uint32_t i = begin; i < end; ++i) {
+				hardMisses += cache.Access(source[i * 3]) + cache.Access(source[i * 3 + 1]) + cache.Access(source[i * 3 + 2]);
+			}
+
+			float targetAcmr = float(hardMisses) / float(end - begin) * threshold;
+
+			cache.Clear();
+
+			clusterStarts.push_back(begin);
+
+			size_t clusterMisses = 0;
+
+			for (uint32_t i = begin; i < end; ++i) {
+
+				clusterMisses += cache.Access(source[i * 3]) + cache.Access(source[i * 3 + 1]) + cache.Access(source[i * 3 + 2]);
+
+				if (i + 1 < end && float(clusterMisses) / float(i + 1 - clusterStarts.back()) <= targetAcmr) {
+					clusterStarts.push_back(i + 1);
+					clusterMisses = 0;
+					cache.Clear();
+				}
+
+			}
+
+		}
+
+	}
+
+	size_t clusterCount = clusterStarts.size();
+
+	clusterStarts.push_back(static_cast<uint32_t>(triangleCount));
+
+	//メッシュの中心
+	double meshCenter[3] = { 0.0, 0.0, 0.0 };
+	double meshArea = 0.0;
+
+	struct Cluster {
+		float center[3];
+		float normal[3];
+		float area;
+		float sortKey;
+		uint32_t index;
+	};
+
+	std::vector<Cluster> clusters(clusterCount);
+
+	for (size_t c = 0; c < clusterCount; ++c) {
+
+		Cluster& cluster = clusters[c];
+
+		double center[3] = { 0.0, 0.0, 0.0 };
+		double normal[3] = { 0.0, 0.0, 0.0 };
+		double area = 0.0;
+
+		for (uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+
+			const float* p0 = getPosition(source[t * 3]);
+			const float* p1 = getPosition(source[t * 3 + 1]);
+			const float* p2 = getPosition(source[t * 3 + 2]);
+
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+			//左手系で時計回りが表なので、この外積が外向きになる
+			float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+
+			double triangleArea = 0.5 * std::sqrt(double(n[0]) * n[0] + double(n[1]) * n[1] + double(n[2]) * n[2]);
+
+			for (int k = 0; k < 3; ++k) {
+				center[k] += (p0[k] + p1[k] + p2[k]) / 3.0 * triangleArea;
+				normal[k] += n[k];
+			}
+
+			area += triangleArea;
+
+		}
+
+		double normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+		for (int k = 0; k < 3; ++k) {
+			cluster.center[k] = area > 0.0 ? float(center[k] / area) : getPosition(source[clusterStarts[c] * 3])[k];
+			cluster.normal[k] = normalLength > 0.0 ? float(normal[k] / normalLength) : 0.0f;
+			meshCenter[k] += center[k];
+		}
+
+		cluster.area = float(area);
+		cluster.index = static_cast<uint32_t>(c);
+
+		meshArea += area;
+
+	}
+
+	for (int k = 0; k < 3; ++k) {
+		meshCenter[k] = meshArea > 0.0 ? meshCenter[k] / meshArea : 0.0;
+	}
+
+	//中心から見て外を向いているクラスタほど前に描かれる面になりやすい
+	for (Cluster& cluster : clusters) {
+		cluster.sortKey = 0.0f;
+		for (int k = 0; k < 3; ++k) {
+			cluster.sortKey += (cluster.center[k] - float(meshCenter[k])) * cluster.normal[k];
+		}
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+		return a.sortKey > b.sortKey;
+	});
+
+	size_t outputIndex = 0;
+
+	for (const Cluster& cluster : clusters) {
+		size_t begin = clusterStarts[cluster.index] * 3;
+		size_t end = clusterStarts[cluster.index + 1] * 3;
+		std::memcpy(destination + outputIndex, source.data() + begin, (end - begin) * sizeof(uint32_t));
+		outputIndex += end - begin;
+	}
+
+	for (size_t i = triangleCount * 3; i < indexCount; ++i) {
+		destination[i] = indices[i];
+	}
+
+}
+
+size_t OptimizeVertexFetch(void* destination, uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t vertexSize) {
+
+	std::vector<uint32_t> remap(vertexCount, 0xffffffff);
+
+	uint32_t nextVertex = 0;
+
+	uint8_t* out = static_cast<uint8_t*>(destination);
+
+	const uint8_t* in = static_cast<const uint8_t*>(vertices);
+
+	for (size_t i = 0; i < indexCount; ++i) {
+
+		uint32_t vertex = indices[i];
+
+		if (remap[vertex] == 0xffffffff) {
+			remap[vertex] = nextVertex;
+			std::memcpy(out + vertexSize * nextVertex, in + vertexSize * vertex, vertexSize);
+			++nextVertex;
+		}
+
+		indices[i] = remap[vertex];
+
+	}
+
+	return nextVertex;
+
+}
+
+void OptimizeMesh(MeshData& mesh) {
+
+	if (mesh.indices.empty()) {
+		return;
+	}
+
+	OptimizeVertexCache(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+	OptimizeOverdraw(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(), &mesh.vertices[0].position.x, mesh.vertices.size(), sizeof(MeshVertex));
+
+	std::vector<MeshVertex> vertices(mesh.vertices.size());
+
+	size_t vertexCount = OptimizeVertexFetch(vertices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size(), sizeof(MeshVertex));
+
+	vertices.resize(vertexCount);
+
+	mesh.vertices = std::move(vertices);
+
+}
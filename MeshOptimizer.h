@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "MeshImporter.h"
+
+//頂点キャッシュの効率
+struct VertexCacheStatistics {
+
+	//三角形あたりの頂点シェーダーの実行数(0.5～3.0。小さいほどよい)
+	float acmr;
+
+	//頂点あたりの頂点シェーダーの実行数(1.0が最良)
+	float atvr;
+
+	size_t vertexTransformCount;
+
+};
+
+//頂点キャッシュの大きさ(FIFOとして真似る)
+const uint32_t kDefaultVertexCacheSize = 16;
+
+//FIFOの頂点キャッシュを真似てACMR/ATVRを求める
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = kDefaultVertexCacheSize);
+
+//Tipsifyで三角形を並べ替え、変換した頂点がキャッシュに残っているうちに使われるようにする(destinationとindicesは同じでもよい)
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = kDefaultVertexCacheSize);
+
+//キャッシュ最適化した並びをクラスタに分け、外を向いているクラスタから描くように並べ替える(視点によらないオーバードローの削減)
+//thresholdはクラスタを細かく分けてよいACMRの悪化の割合(1.05なら5%まで)。positionsはpositionStrideバイトおきのfloat3
+void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold = 1.05f, uint32_t cacheSize = kDefaultVertexCacheSize);
+
+//インデックスで初めて使われる順に頂点を並べ直し、使われていない頂点を捨てる。インデックスも書き換える
+//destinationはverticesと別の領域で、vertexCount * vertexSizeバイト必要。新しい頂点の数を返す
+size_t OptimizeVertexFetch(void* destination, uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t vertexSize);
+
+//キャッシュ、オーバードロー、頂点の読み込みの順に最適化する
+void OptimizeMesh(MeshData& mesh);
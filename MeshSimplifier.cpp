@@ -0,0 +1,961 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+	//開いた縁を保つための面の重み(三角形の面より強くする)
+	const float kBorderWeight = 10.0f;
+
+	//ほとんど減らなくなったらLODを作るのをやめる割合
+	const float kMinLodReduction = 0.85f;
+
+	//頂点の動かし方
+	enum class VertexKind : uint8_t {
+
+		//周りが閉じていて、どの隣へも寄せられる
+		kManifold,
+
+		//開いた縁の上にあり、縁に沿ってだけ寄せられる
+		kBorder,
+
+		//UVや法線の継ぎ目の上にあり(同じ位置に2つの頂点がある)、継ぎ目に沿って両方を寄せる
+		kSeam,
+
+		//動かさない
+		kLocked,
+
+	};
+
+	//位置の二次誤差(対称行列a、ベクトルb、定数c)と足した面積
+	struct Quadric {
+
+		float a00, a11, a22, a01, a02, a12;
+		float b0, b1, b2;
+		float c;
+		float weight;
+
+	};
+
+	//法線3つとUV2つ
+	const int kAttributeCount = 5;
+
+	//属性の二次誤差。三角形の上で属性を位置の一次式(g・p + d)で表し、寄せた先の値とのずれを測る
+	//(g・p + d)^2の項は位置の二次誤差に入れるので、ここには交差項の係数と面積だけを持つ
+	struct AttributeQuadric {
+
+		float gx[kAttributeCount];
+		float gy[kAttributeCount];
+		float gz[kAttributeCount];
+		float gd[kAttributeCount];
+		float weight;
+
+	};
+
+	//候補の辺(vをtへ寄せる。継ぎ目ならvOtherもtOtherへ寄せる)
+	struct Collapse {
+
+		uint32_t v;
+		uint32_t t;
+		uint32_t vOther;
+		uint32_t tOther;
+		float cost;
+
+	};
+
+	//位置でまとめた番号から、その位置を使う三角形を引く表
+	struct TriangleAdjacency {
+
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> counts;
+		std::vector<uint32_t> triangles;
+
+	};
+
+	Vector3 Subtract(const Vector3& a, const Vector3& b) {
+		return { a.x - b.x, a.y - b.y, a.z - b.z };
+	}
+
+	Vector3 Cross(const Vector3& a, const Vector3& b) {
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	float Dot(const Vector3& a, const Vector3& b) {
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	//面(n・p + d = 0)からの距離の2乗を重みwで足す
+	void AddPlane(Quadric& quadric, const Vector3& n, float d, float w) {
+
+		quadric.a00 += w * n.x * n.x;
+		quadric.a11 += w * n.y * n.y;
+		quadric.a22 += w * n.z * n.z;
+		quadric.a01 += w * n.x * n.y;
+		quadric.a02 += w * n.x * n.z;
+		quadric.a12 += w * n.y * n.z;
+
+		quadric.b0 += w * n.x * d;
+		quadric.b1 += w * n.y * d;
+		quadric.b2 += w * n.z * d;
+
+		quadric.c += w * d * d;
+
+		quadric.weight += w;
+
+	}
+
+	void AddQuadric(Quadric& quadric, const Quadric& other) {
+
+		quadric.a00 += other.a00;
+		quadric.a11 += other.a11;
+		quadric.a22 += other.a22;
+		quadric.a01 += other.a01;
+		quadric.a02 += other.a02;
+		quadric.a12 += other.a12;
+
+		quadric.b0 += other.b0;
+		quadric.b1 += other.b1;
+		quadric.b2 += other.b2;
+
+		quadric.c += other.c;
+
+		quadric.weight += other.weight;
+
+	}
+
+	float EvaluateQuadric(const Quadric& q, const Vector3& p) {
+		return
+			q.a00 * p.x * p.x + q.a11 * p.y * p.y + q.a22 * p.z * p.z +
+			2.0f * (q.a01 * p.x * p.y + q.a02 * p.x * p.z + q.a12 * p.y * p.z) +
+			2.0f * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) + q.c;
+	}
+
+	void AddAttributeQuadric(AttributeQuadric& quadric, const AttributeQuadric& other) {
+
+		for (int i = 0; i < kAttributeCount; ++i) {
+			quadric.gx[i] += other.gx[i];
+			quadric.gy[i] += other.gy[i];
+			quadric.gz[i] += other.gz[i];
+			quadric.gd[i] += other.gd[i];
+		}
+
+		quadric.weight += other.weight;
+
+	}
+
+	//位置pで属性attributesを持つとした時の、位置の二次誤差に足す分
+	float EvaluateAttributeQuadric(const AttributeQuadric& q, const Vector3& p, const float* attributes) {
+
+		float result = 0.0f;
+
+		for (int i = 0; i < kAttributeCount; ++i) {
+			float value = attributes[i];
+			result += value * (q.weight * value - 2.0f * (q.gx[i] * p.x + q.gy[i] * p.y + q.gz[i] * p.z + q.gd[i]));
+		}
+
+		return result;
+
+	}
+
+	//三角形の上の属性の傾きを求めて、3つの頂点の二次誤差に面積wで足す
+	void AddAttributeTriangle(Quadric* quadrics, AttributeQuadric* attributeQuadrics, const uint32_t* triangle, const Vector3* positions, const float* attributes, float w) {
+
+		const Vector3& p0 = positions[triangle[0]];
+
+		Vector3 e1 = Subtract(positions[triangle[1]], p0);
+		Vector3 e2 = Subtract(positions[triangle[2]], p0);
+
+		float d11 = Dot(e1, e1);
+		float d12 = Dot(e1, e2);
+		float d22 = Dot(e2, e2);
+
+		float determinant = d11 * d22 - d12 * d12;
+
+		if (!(determinant > 0.0f)) {
+			return;
+		}
+
+		float inverseDeterminant = 1.0f / determinant;
+
+		const float* a0 = attributes + triangle[0] * kAttributeCount;
+		const float* a1 = attributes + triangle[1] * kAttributeCount;
+		const float* a2 = attributes + triangle[2] * kAttributeCount;
+
+		Quadric gradientQuadric = {};
+
+		AttributeQuadric attributeQuadric = {};
+
+		attributeQuadric.weight = w;
+
+		for (int i = 0; i < kAttributeCount; ++i) {
+
+			//面の中の傾きg = u*e1 + v*e2で、g・e1 = a1 - a0、g・e2 = a2 - a0となるもの
+			float da1 = a1[i] - a0[i];
+			float da2 = a2[i] - a0[i];
+
+			float u = (d22 * da1 - d12 * da2) * inverseDeterminant;
+			float v = (d11 * da2 - d12 * da1) * inverseDeterminant;
+
+			Vector3 g = { e1.x * u + e2.x * v, e1.y * u + e2.y * v, e1.z * u + e2.z * v };
+
+			float d = a0[i] - Dot(g, p0);
+
+			gradientQuadric.a00 += w * g.x * g.x;
+			gradientQuadric.a11 += w * g.y * g.y;
+			gradientQuadric.a22 += w * g.z * g.z;
+			gradientQuadric.a01 += w * g.x * g.y;
+			gradientQuadric.a02 += w * g.x * g.z;
+			gradientQuadric.a12 += w * g.y * g.z;
+
+			gradientQuadric.b0 += w * g.x * d;
+			gradientQuadric.b1 += w * g.y * d;
+			gradientQuadric.b2 += w * g.z * d;
+
+			gradientQuadric.c += w * d * d;
+
+			attributeQuadric.gx[i] = w * g.x;
+			attributeQuadric.gy[i] = w * g.y;
+			attributeQuadric.gz[i] = w * g.z;
+			attributeQuadric.gd[i] = w * d;
+
+		}
+
+		for (int k = 0; k < 3; ++k) {
+			AddQuadric(quadrics[triangle[k]], gradientQuadric);
+			AddAttributeQuadric(attributeQuadrics[triangle[k]], attributeQuadric);
+		}
+
+	}
+
+	//位置が同じ頂点をまとめる(継ぎ目では同じ位置に複数の頂点がある)
+	//groups[v]は同じ位置の中で一番小さい番号、wedges[v]は同じ位置の次の頂点(輪になっている)
+	void BuildPositionGroups(const MeshVertex* vertices, size_t vertexCount, std::vector<uint32_t>& groups, std::vector<uint32_t>& wedges) {
+
+		std::vector<uint32_t> order(vertexCount);
+
+		std::iota(order.begin(), order.end(), 0u);
+
+		auto less = [&](uint32_t a, uint32_t b) {
+			int compare = std::memcmp(&vertices[a].position, &vertices[b].position, sizeof(float) * 3);
+			return compare != 0 ? compare < 0 : a < b;
+		};
+
+		std::sort(order.begin(), order.end(), less);
+
+		groups.resize(vertexCount);
+		wedges.resize(vertexCount);
+
+		size_t begin = 0;
+
+		while (begin < vertexCount) {
+
+			size_t end = begin + 1;
+
+			while (end < vertexCount && std::memcmp(&vertices[order[begin]].position, &vertices[order[end]].position, sizeof(float) * 3) == 0) {
+				++end;
+			}
+
+			for (size_t i = begin; i < end; ++i) {
+				groups[order[i]] = order[begin];
+				wedges[order[i]] = order[i + 1 < end ? i + 1 : begin];
+			}
+
+			begin = end;
+
+		}
+
+	}
+
+	void BuildTriangleAdjacency(TriangleAdjacency& adjacency, const uint32_t* indices, size_t indexCount, const uint32_t* groups, size_t vertexCount) {
+
+		adjacency.counts.assign(vertexCount, 0);
+		adjacency.offsets.resize(vertexCount);
+		adjacency.triangles.resize(indexCount);
+
+		for (size_t i = 0; i < indexCount; ++i) {
+			++adjacency.counts[groups[indices[i]]];
+		}
+
+		uint32_t offset = 0;
+
+		for (size_t i = 0; i < vertexCount; ++i) {
+			adjacency.offsets[i] = offset;
+			offset += adjacency.counts[i];
+		}
+
+		for (size_t i = 0; i < indexCount; ++i) {
+			adjacency.triangles[adjacency.offsets[groups[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		for (size_t i = 0; i < vertexCount; ++i) {
+			adjacency.offsets[i] -= adjacency.counts[i];
+		}
+
+	}
+
+	//位置でまとめた頂点を処理するための情報
+	class SimplifyContext {
+
+	public:
+
+		SimplifyContext(const uint32_t* groups, const TriangleAdjacency& adjacency) : groups_(groups), adjacency_(adjacency) {}
+
+		void SetIndices(const uint32_t* indices) { indices_ = indices; }
+
+		//function(triangleの先頭のインデックス)を、位置groupを使う三角形ごとに呼ぶ
+		template<typename Function>
+		void ForEachTriangle(uint32_t group, const Function& function) const {
+
+			const uint32_t* triangles = &adjacency_.triangles[adjacency_.offsets[group]];
+
+			for (uint32_t i = 0; i < adjacency_.counts[group]; ++i) {
+				function(indices_ + triangles[i] * 3);
+			}
+
+		}
+
+		bool HasGroup(const uint32_t* triangle, uint32_t group) const {
+			return groups_[triangle[0]] == group || groups_[triangle[1]] == group || groups_[triangle[2]] == group;
+		}
+
+		//位置で見た辺(a,b)を持つ三角形の数
+		uint32_t CountPositionEdge(uint32_t a, uint32_t b) const {
+
+			uint32_t groupB = groups_[b];
+			uint32_t count = 0;
+
+			ForEachTriangle(groups_[a], [&](const uint32_t* triangle) {
+				count += HasGroup(triangle, groupB) ? 1 : 0;
+			});
+
+			return count;
+
+		}
+
+		//頂点の番号で見た辺(a,b)を持つ三角形の数
+		uint32_t CountAttributeEdge(uint32_t a, uint32_t b) const {
+
+			uint32_t count = 0;
+
+			ForEachTriangle(groups_[a], [&](const uint32_t* triangle) {
+				bool hasA = triangle[0] == a || triangle[1] == a || triangle[2] == a;
+				bool hasB = triangle[0] == b || triangle[1] == b || triangle[2] == b;
+				count += hasA && hasB ? 1 : 0;
+			});
+
+			return count;
+
+		}
+
+		//継ぎ目の反対側の頂点vOtherと辺でつながっている、tと同じ位置の頂点
+		uint32_t FindSeamTarget(uint32_t vOther, uint32_t t) const {
+
+			uint32_t groupT = groups_[t];
+			uint32_t result = UINT32_MAX;
+
+			ForEachTriangle(groups_[vOther], [&](const uint32_t* triangle) {
+				if (triangle[0] != vOther && triangle[1] != vOther && triangle[2] != vOther) {
+					return;
+				}
+				for (int k = 0; k < 3; ++k) {
+					if (groups_[triangle[k]] == groupT) {
+						result = triangle[k];
+					}
+				}
+			});
+
+			return result;
+
+		}
+
+		//vをtの位置へ動かすと裏返る三角形があるか
+		bool HasTriangleFlip(uint32_t v, uint32_t t, const Vector3* positions) const {
+
+			uint32_t groupV = groups_[v];
+			uint32_t groupT = groups_[t];
+
+			bool isFlipped = false;
+
+			ForEachTriangle(groupV, [&](const uint32_t* triangle) {
+
+				//tを含む三角形は潰れて消える
+				if (isFlipped || HasGroup(triangle, groupT)) {
+					return;
+				}
+
+				Vector3 p[3] = { positions[triangle[0]], positions[triangle[1]], positions[triangle[2]] };
+
+				Vector3 before = Cross(Subtract(p[1], p[0]), Subtract(p[2], p[0]));
+
+				for (int k = 0; k < 3; ++k) {
+					if (groups_[triangle[k]] == groupV) {
+						p[k] = positions[t];
+					}
+				}
+
+				Vector3 after = Cross(Subtract(p[1], p[0]), Subtract(p[2], p[0]));
+
+				//もともと潰れている三角形は比べない
+				if (Dot(before, before) > 0.0f && Dot(before, after) <= 0.0f) {
+					isFlipped = true;
+				}
+
+			});
+
+			return isFlipped;
+
+		}
+
+		//vとtの両方の隣にある頂点が、辺(v,t)を挟む三角形の頂点だけか(そうでなければ寄せると面が重なる)
+		bool IsLinkValid(uint32_t v, uint32_t t, std::vector<uint32_t>& neighbors) const {
+
+			uint32_t groupV = groups_[v];
+			uint32_t groupT = groups_[t];
+
+			neighbors.clear();
+
+			ForEachTriangle(groupV, [&](const uint32_t* triangle) {
+
+				bool isShared = HasGroup(triangle, groupT);
+
+				for (int k = 0; k < 3; ++k) {
+					uint32_t group = groups_[triangle[k]];
+					//辺を挟む三角形の向かいの頂点は、共有してよいので印を付けて除く
+					if (group != groupV && group != groupT) {
+						neighbors.push_back(isShared ? (group | 0x80000000u) : group);
+					}
+				}
+
+			});
+
+			bool isValid = true;
+
+			ForEachTriangle(groupT, [&](const uint32_t* triangle) {
+
+				if (!isValid || HasGroup(triangle, groupV)) {
+					return;
+				}
+
+				for (int k = 0; k < 3; ++k) {
+
+					uint32_t group = groups_[triangle[k]];
+
+					if (group == groupT) {
+						continue;
+					}
+
+					bool isNeighbor = std::find(neighbors.begin(), neighbors.end(), group) != neighbors.end();
+					bool isOpposite = std::find(neighbors.begin(), neighbors.end(), group | 0x80000000u) != neighbors.end();
+
+					if (isNeighbor && !isOpposite) {
+						isValid = false;
+					}
+
+				}
+
+			});
+
+			return isValid;
+
+		}
+
+	private:
+
+		const uint32_t* groups_;
+		const TriangleAdjacency& adjacency_;
+		const uint32_t* indices_ = nullptr;
+
+	};
+
+	//位置で見て潰れた三角形を除く
+	size_t RemoveDegenerateTriangles(uint32_t* indices, size_t indexCount, const uint32_t* groups) {
+
+		size_t writeCount = 0;
+
+		for (size_t i = 0; i < indexCount; i += 3) {
+
+			uint32_t a = indices[i];
+			uint32_t b = indices[i + 1];
+			uint32_t c = indices[i + 2];
+
+			if (groups[a] == groups[b] || groups[b] == groups[c] || groups[c] == groups[a]) {
+				continue;
+			}
+
+			indices[writeCount++] = a;
+			indices[writeCount++] = b;
+			indices[writeCount++] = c;
+
+		}
+
+		return writeCount;
+
+	}
+
+}
+
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const MeshVertex* vertices, size_t vertexCount,
+	size_t targetIndexCount, float targetError, const MeshSimplifySettings& settings, float* resultError) {
+
+	std::vector<uint32_t> result(indices, indices + indexCount);
+
+	if (resultError != nullptr) {
+		*resultError = 0.0f;
+	}
+
+	if (indexCount == 0 || vertexCount == 0) {
+		return 0;
+	}
+
+	//位置はメッシュの大きさを1にして測る(誤差の重みが大きさによらないように)
+	Vector3 min = { vertices[0].position.x, vertices[0].position.y, vertices[0].position.z };
+	Vector3 max = min;
+
+	for (size_t i = 1; i < vertexCount; ++i) {
+		min.x = (std::min)(min.x, vertices[i].position.x);
+		min.y = (std::min)(min.y, vertices[i].position.y);
+		min.z = (std::min)(min.z, vertices[i].position.z);
+		max.x = (std::max)(max.x, vertices[i].position.x);
+		max.y = (std::max)(max.y, vertices[i].position.y);
+		max.z = (std::max)(max.z, vertices[i].position.z);
+	}
+
+	float extent = (std::max)({ max.x - min.x, max.y - min.y, max.z - min.z });
+
+	float scale = extent > 0.0f ? 1.0f / extent : 0.0f;
+
+	std::vector<Vector3> positions(vertexCount);
+
+	for (size_t i = 0; i < vertexCount; ++i) {
+		positions[i] = { (vertices[i].position.x - min.x) * scale, (vertices[i].position.y - min.y) * scale, (vertices[i].position.z - min.z) * scale };
+	}
+
+	std::vector<uint32_t> groups;
+	std::vector<uint32_t> wedges;
+
+	BuildPositionGroups(vertices, vertexCount, groups, wedges);
+
+	result.resize(RemoveDegenerateTriangles(result.data(), result.size(), groups.data()));
+
+	TriangleAdjacency adjacency;
+
+	SimplifyContext context(groups.data(), adjacency);
+
+	BuildTriangleAdjacency(adjacency, result.data(), result.size(), groups.data(), vertexCount);
+
+	context.SetIndices(result.data());
+
+	//開いた辺を数えて頂点を分類し、三角形の面と縁の面から二次誤差を作る
+	std::vector<uint32_t> openPositionEdges(vertexCount, 0);
+	std::vector<uint32_t> openAttributeEdges(vertexCount, 0);
+	std::vector<uint8_t> isComplex(vertexCount, 0);
+
+	std::vector<Quadric> quadrics(vertexCount, Quadric{});
+
+	std::vector<AttributeQuadric> attributeQuadrics(vertexCount, AttributeQuadric{});
+
+	//重みを掛けた法線とUV
+	std::vector<float> attributes(vertexCount * kAttributeCount);
+
+	for (size_t i = 0; i < vertexCount; ++i) {
+
+		float* attribute = &attributes[i * kAttributeCount];
+
+		attribute[0] = vertices[i].normal.x * settings.normalWeight;
+		attribute[1] = vertices[i].normal.y * settings.normalWeight;
+		attribute[2] = vertices[i].normal.z * settings.normalWeight;
+		attribute[3] = vertices[i].texcoord.x * settings.texcoordWeight;
+		attribute[4] = vertices[i].texcoord.y * settings.texcoordWeight;
+
+	}
+
+	for (size_t i = 0; i < result.size(); i += 3) {
+
+		const uint32_t* triangle = &result[i];
+
+		Vector3 normal = Cross(Subtract(positions[triangle[1]], positions[triangle[0]]), Subtract(positions[triangle[2]], positions[triangle[0]]));
+
+		float length = std::sqrt(Dot(normal, normal));
+
+		if (length > 0.0f) {
+
+			normal = { normal.x / length, normal.y / length, normal.z / length };
+
+			float d = -Dot(normal, positions[triangle[0]]);
+
+			for (int k = 0; k < 3; ++k) {
+				AddPlane(quadrics[triangle[k]], normal, d, length * 0.5f);
+			}
+
+			AddAttributeTriangle(quadrics.data(), attributeQuadrics.data(), triangle, positions.data(), attributes.data(), length * 0.5f);
+
+		}
+
+		for (int k = 0; k < 3; ++k) {
+
+			uint32_t a = triangle[k];
+			uint32_t b = triangle[(k + 1) % 3];
+
+			uint32_t positionCount = context.CountPositionEdge(a, b);
+
+			if (positionCount > 2) {
+				isComplex[groups[a]] = 1;
+				isComplex[groups[b]] = 1;
+			}
+
+			if (context.CountAttributeEdge(a, b) == 1) {
+				++openAttributeEdges[a];
+				++openAttributeEdges[b];
+			}
+
+			if (positionCount == 1) {
+
+				++openPositionEdges[groups[a]];
+				++openPositionEdges[groups[b]];
+
+				//縁を含み、三角形に垂直な面で縁の形を保つ
+				if (length > 0.0f) {
+
+					Vector3 edge = Subtract(positions[b], positions[a]);
+
+					Vector3 edgeNormal = Cross(edge, normal);
+
+					float edgeNormalLength = std::sqrt(Dot(edgeNormal, edgeNormal));
+
+					if (edgeNormalLength > 0.0f) {
+
+						edgeNormal = { edgeNormal.x / edgeNormalLength, edgeNormal.y / edgeNormalLength, edgeNormal.z / edgeNormalLength };
+
+						float d = -Dot(edgeNormal, positions[a]);
+
+						float w = Dot(edge, edge) * kBorderWeight;
+
+						AddPlane(quadrics[a], edgeNormal, d, w);
+						AddPlane(quadrics[b], edgeNormal, d, w);
+
+					}
+
+				}
+
+			}
+
+		}
+
+	}
+
+	std::vector<VertexKind> kinds(vertexCount, VertexKind::kLocked);
+
+	for (uint32_t v = 0; v < vertexCount; ++v) {
+
+		uint32_t group = groups[v];
+
+		if (isComplex[group]) {
+			continue;
+		}
+
+		if (wedges[v] == v) {
+
+			//位置が1つだけで、継ぎ目の端でもないもの
+			if (openAttributeEdges[v] != openPositionEdges[group]) {
+				continue;
+			}
+
+			if (openPositionEdges[group] == 0) {
+				kinds[v] = VertexKind::kManifold;
+			} else if (openPositionEdges[group] == 2 && (settings.flags & kMeshSimplifyLockBorder) == 0) {
+				kinds[v] = VertexKind::kBorder;
+			}
+
+		} else if (wedges[wedges[v]] == v) {
+
+			//継ぎ目が1本通り抜けているだけのもの
+			if (openPositionEdges[group] == 0 && openAttributeEdges[v] == 2 && openAttributeEdges[wedges[v]] == 2) {
+				kinds[v] = VertexKind::kSeam;
+			}
+
+		}
+
+	}
+
+	//寄せた時の誤差(面からの距離の2乗と属性のずれを、面積で平均したもの)
+	auto getCost = [&](uint32_t v, uint32_t t, uint32_t vOther, uint32_t tOther) {
+
+		float error = EvaluateQuadric(quadrics[v], positions[t]) + EvaluateAttributeQuadric(attributeQuadrics[v], positions[t], &attributes[t * kAttributeCount]);
+		float weight = quadrics[v].weight;
+
+		if (vOther != UINT32_MAX) {
+			error += EvaluateQuadric(quadrics[vOther], positions[tOther]) + EvaluateAttributeQuadric(attributeQuadrics[vOther], positions[tOther], &attributes[tOther * kAttributeCount]);
+			weight += quadrics[vOther].weight;
+		}
+
+		//丸め誤差で負にならないようにする
+		return weight > 0.0f ? (std::max)(error, 0.0f) / weight : 0.0f;
+
+	};
+
+	std::vector<Collapse> candidates;
+
+	auto addCandidate = [&](uint32_t v, uint32_t t) {
+
+		VertexKind kind = kinds[v];
+
+		uint32_t vOther = UINT32_MAX;
+		uint32_t tOther = UINT32_MAX;
+
+		if (kind == VertexKind::kLocked) {
+			return;
+		}
+
+		//縁は縁に沿ってだけ寄せる
+		if (kind == VertexKind::kBorder && context.CountPositionEdge(v, t) != 1) {
+			return;
+		}
+
+		//継ぎ目は継ぎ目に沿って、反対側も同じ位置へ寄せる
+		if (kind == VertexKind::kSeam) {
+
+			if (context.CountAttributeEdge(v, t) != 1 || context.CountPositionEdge(v, t) != 2) {
+				return;
+			}
+
+			vOther = wedges[v];
+			tOther = context.FindSeamTarget(vOther, t);
+
+			if (tOther == UINT32_MAX) {
+				return;
+			}
+
+		}
+
+		candidates.push_back({ v, t, vOther, tOther, getCost(v, t, vOther, tOther) });
+
+	};
+
+	size_t targetTriangleCount = targetIndexCount / 3;
+
+	float errorLimit = targetError * scale;
+
+	float costLimit = errorLimit * errorLimit;
+
+	float maxCost = 0.0f;
+
+	std::vector<uint32_t> collapses(vertexCount);
+	std::vector<uint8_t> isTouched(vertexCount);
+
+	std::vector<uint32_t> neighbors;
+
+	size_t triangleCount = result.size() / 3;
+
+	//候補を誤差の順に並べ、まだ触っていない所だけ寄せるのを1回として繰り返す
+	while (triangleCount > targetTriangleCount) {
+
+		candidates.clear();
+
+		for (size_t i = 0; i < result.size(); i += 3) {
+
+			for (int k = 0; k < 3; ++k) {
+
+				uint32_t a = result[i + k];
+				uint32_t b = result[i + (k + 1) % 3];
+
+				//閉じた辺は隣の三角形が逆向きを足すので、ここでは片方だけ足す
+				addCandidate(a, b);
+
+				if (kinds[b] == VertexKind::kBorder || kinds[b] == VertexKind::kSeam) {
+					addCandidate(b, a);
+				}
+
+			}
+
+		}
+
+		if (candidates.empty()) {
+			break;
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) {
+			return a.cost != b.cost ? a.cost < b.cost : (a.v != b.v ? a.v < b.v : a.t < b.t);
+		});
+
+		std::iota(collapses.begin(), collapses.end(), 0u);
+
+		std::fill(isTouched.begin(), isTouched.end(), uint8_t(0));
+
+		size_t collapseCount = 0;
+
+		for (const Collapse& collapse : candidates) {
+
+			if (collapse.cost > costLimit || triangleCount <= targetTriangleCount) {
+				break;
+			}
+
+			uint32_t groupV = groups[collapse.v];
+			uint32_t groupT = groups[collapse.t];
+
+			if (isTouched[groupV] || isTouched[groupT]) {
+				continue;
+			}
+
+			if (context.HasTriangleFlip(collapse.v, collapse.t, positions.data()) || !context.IsLinkValid(collapse.v, collapse.t, neighbors)) {
+				continue;
+			}
+
+			size_t removedCount = 0;
+
+			context.ForEachTriangle(groupV, [&](const uint32_t* triangle) {
+
+				removedCount += context.HasGroup(triangle, groupT) ? 1 : 0;
+
+				//周りの三角形は今回はもう触らない(候補の誤差が古くなるため)
+				isTouched[groups[triangle[0]]] = 1;
+				isTouched[groups[triangle[1]]] = 1;
+				isTouched[groups[triangle[2]]] = 1;
+
+			});
+
+			collapses[collapse.v] = collapse.t;
+
+			AddQuadric(quadrics[collapse.t], quadrics[collapse.v]);
+			AddAttributeQuadric(attributeQuadrics[collapse.t], attributeQuadrics[collapse.v]);
+
+			if (collapse.vOther != UINT32_MAX) {
+				collapses[collapse.vOther] = collapse.tOther;
+				AddQuadric(quadrics[collapse.tOther], quadrics[collapse.vOther]);
+				AddAttributeQuadric(attributeQuadrics[collapse.tOther], attributeQuadrics[collapse.vOther]);
+			}
+
+			triangleCount -= (std::min)(removedCount, triangleCount);
+
+			maxCost = (std::max)(maxCost, collapse.cost);
+
+			++collapseCount;
+
+		}
+
+		if (collapseCount == 0) {
+			break;
+		}
+
+		for (uint32_t& index : result) {
+			index = collapses[index];
+		}
+
+		result.resize(RemoveDegenerateTriangles(result.data(), result.size(), groups.data()));
+
+		triangleCount = result.size() / 3;
+
+		BuildTriangleAdjacency(adjacency, result.data(), result.size(), groups.data(), vertexCount);
+
+		context.SetIndices(result.data());
+
+	}
+
+	std::copy(result.begin(), result.end(), destination);
+
+	if (resultError != nullptr) {
+		*resultError = std::sqrt(maxCost) * extent;
+	}
+
+	return result.size();
+
+}
+
+void GenerateMeshLods(MeshData& mesh, const MeshLodSettings& settings) {
+
+	mesh.lods.clear();
+
+	if (mesh.indices.empty()) {
+		return;
+	}
+
+	mesh.lods.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f, 0 });
+
+	const AABB& bounds = mesh.bounds;
+
+	float extent = (std::max)({ bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y, bounds.max.z - bounds.min.z });
+
+	float maxError = settings.maxRelativeError * extent;
+
+	std::vector<uint32_t> source = mesh.indices;
+	std::vector<uint32_t> simplified(source.size());
+
+	float accumulatedError = 0.0f;
+
+	for (uint32_t lod = 1; lod < settings.maxLodCount; ++lod) {
+
+		size_t targetIndexCount = static_cast<size_t>(source.size() / 3 * settings.reductionRatio) * 3;
+
+		//前の段から簡略化するので、誤差は足し合わせたものを上限とする
+		float errorBudget = maxError - accumulatedError;
+
+		if (targetIndexCount == 0 || errorBudget <= 0.0f) {
+			break;
+		}
+
+		float error = 0.0f;
+
+		size_t indexCount = SimplifyMesh(simplified.data(), source.data(), source.size(), mesh.vertices.data(), mesh.vertices.size(), targetIndexCount, errorBudget, settings.simplify, &error);
+
+		if (indexCount == 0 || indexCount > source.size() * kMinLodReduction) {
+			break;
+		}
+
+		accumulatedError += error;
+
+		OptimizeVertexCache(simplified.data(), simplified.data(), indexCount, mesh.vertices.size());
+
+		mesh.lods.push_back({ static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(indexCount), accumulatedError, 0 });
+
+		mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.begin() + indexCount);
+
+		source.assign(simplified.begin(), simplified.begin() + indexCount);
+
+	}
+
+}
+
+LodSelection MakeLodSelection(const Matrix4x4& projectionMatrix, float viewportHeight, float maxPixelError) {
+	return { projectionMatrix.m[1][1] * viewportHeight * 0.5f, maxPixelError };
+}
+
+float ComputeProjectedSize(float radius, float viewDepth, const LodSelection& selection) {
+
+	//カメラが球の中にあれば画面を覆う
+	if (viewDepth <= radius) {
+		return std::numeric_limits<float>::infinity();
+	}
+
+	return 2.0f * radius * selection.pixelsPerUnit / viewDepth;
+
+}
+
+uint32_t SelectMeshLod(const MeshLod* lods, size_t lodCount, float worldScale, float radius, float viewDepth, const LodSelection& selection) {
+
+	float distance = viewDepth - radius * worldScale;
+
+	if (lodCount <= 1 || distance <= 0.0f) {
+		return 0;
+	}
+
+	uint32_t result = 0;
+
+	for (uint32_t lod = 1; lod < lodCount; ++lod) {
+
+		float pixelError = lods[lod].error * worldScale * selection.pixelsPerUnit / distance;
+
+		if (pixelError > selection.maxPixelError) {
+			break;
+		}
+
+		result = lod;
+
+	}
+
+	return result;
+
+}
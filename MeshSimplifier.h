@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "MathTypes.h"
+#include "MeshImporter.h"
+
+//簡略化の選択
+enum MeshSimplifyFlags : uint32_t {
+	kMeshSimplifyNone = 0,
+	//開いた縁の頂点を動かさない(縁を共有する隣のメッシュとの間に隙間を作らない)
+	kMeshSimplifyLockBorder = 1 << 0,
+};
+
+struct MeshSimplifySettings {
+
+	//法線とUVのずれを位置のずれと比べる時の重み(位置はメッシュの大きさを1として測る)
+	float normalWeight = 0.5f;
+	float texcoordWeight = 1.0f;
+
+	uint32_t flags = kMeshSimplifyLockBorder;
+
+};
+
+//二次誤差(QEM)の小さい辺から順に、片方の頂点をもう片方へ寄せて三角形を減らす
+//頂点は元の配列のものをそのまま使い、新しい頂点は作らない。UVや法線の継ぎ目は両側をそろえて動かす
+//三角形の数がtargetIndexCount/3以下になるか、誤差がtargetError(メッシュの単位)を超えるところで止める
+//destinationはindexCount分必要で、indicesと同じでもよい。新しいインデックスの数を返し、resultErrorには実際の誤差を入れる
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const MeshVertex* vertices, size_t vertexCount,
+	size_t targetIndexCount, float targetError, const MeshSimplifySettings& settings = {}, float* resultError = nullptr);
+
+struct MeshLodSettings {
+
+	//LOD0を含めた最大の段数
+	uint32_t maxLodCount = 5;
+
+	//1段ごとに残す三角形の割合
+	float reductionRatio = 0.5f;
+
+	//許す誤差(メッシュの大きさに対する割合)
+	float maxRelativeError = 0.05f;
+
+	MeshSimplifySettings simplify;
+
+};
+
+//mesh.indicesをLOD0として、1つ前の段を簡略化した粗い段のインデックスを後ろに足し、mesh.lodsを作る
+//足した段はそれぞれ頂点キャッシュの順に並べ替える(頂点の並びはLOD0のまま)
+void GenerateMeshLods(MeshData& mesh, const MeshLodSettings& settings = {});
+
+//画面の大きさでLODを選ぶための、カメラの投影から決まる値
+struct LodSelection {
+
+	//ビュー空間で奥行き1の位置にある長さ1が何ピクセルになるか
+	float pixelsPerUnit;
+
+	//許す誤差(ピクセル)
+	float maxPixelError;
+
+};
+
+//射影行列の縦の拡大率と画面の高さから作る
+LodSelection MakeLodSelection(const Matrix4x4& projectionMatrix, float viewportHeight, float maxPixelError);
+
+//半径radiusの球の画面上の直径(ピクセル)
+float ComputeProjectedSize(float radius, float viewDepth, const LodSelection& selection);
+
+//誤差を画面に映した大きさがmaxPixelError以下になる一番粗い段を選ぶ
+//worldScaleはワールド行列の最大の拡大率、radiusはメッシュの単位での半径(近い側の奥行きで測る)
+uint32_t SelectMeshLod(const MeshLod* lods, size_t lodCount, float worldScale, float radius, float viewDepth, const LodSelection& selection);
@@ -0,0 +1,616 @@
+#include "Meshlet.h"
+#include "OcclusionCulling.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+	//1つの塊で判定する最小の数
+	const size_t kMinMeshletCullChunkSize = 512;
+
+	//今のメッシュレットに入っていない頂点の印
+	const uint8_t kNotInMeshlet = 0xff;
+
+	const uint32_t kInvalidTriangle = 0xffffffff;
+
+	//隣が見つからない時、これだけ三角形が入っていればメッシュレットを閉じる(少なければ離れた三角形で埋める)
+	const uint32_t kMinTrianglesBeforeClose = kMaxMeshletTriangles / 4;
+
+	//頂点から、まだメッシュレットに入れていない三角形を引く表(入れた三角形は入れ替えで取り除く)
+	struct LiveTriangleAdjacency {
+
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> counts;
+		std::vector<uint32_t> triangles;
+
+	};
+
+	void BuildLiveTriangleAdjacency(LiveTriangleAdjacency& adjacency, const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+
+		adjacency.counts.assign(vertexCount, 0);
+		adjacency.offsets.resize(vertexCount);
+		adjacency.triangles.resize(indexCount);
+
+		for (size_t i = 0; i < indexCount; ++i) {
+			++adjacency.counts[indices[i]];
+		}
+
+		uint32_t offset = 0;
+
+		for (size_t i = 0; i < vertexCount; ++i) {
+			adjacency.offsets[i] = offset;
+			offset += adjacency.counts[i];
+		}
+
+		//offsetsを書き込み位置として使い、後で戻す
+		for (size_t i = 0; i < indexCount; ++i) {
+			adjacency.triangles[adjacency.offsets[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		for (size_t i = 0; i < vertexCount; ++i) {
+			adjacency.offsets[i] -= adjacency.counts[i];
+		}
+
+	}
+
+	void RemoveLiveTriangle(LiveTriangleAdjacency& adjacency, uint32_t vertex, uint32_t triangle) {
+
+		uint32_t* triangles = adjacency.triangles.data() + adjacency.offsets[vertex];
+
+		uint32_t& count = adjacency.counts[vertex];
+
+		for (uint32_t i = 0; i < count; ++i) {
+			if (triangles[i] == triangle) {
+				triangles[i] = triangles[--count];
+				return;
+			}
+		}
+
+	}
+
+	Vector3 Normalize(const Vector3& v) {
+
+		float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+
+		if (length <= 0.0f) {
+			return { 0.0f, 0.0f, 0.0f };
+		}
+
+		float inverseLength = 1.0f / length;
+
+		return { v.x * inverseLength, v.y * inverseLength, v.z * inverseLength };
+
+	}
+
+	float Dot(const Vector3& a, const Vector3& b) {
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	//作っている途中のメッシュレット
+	class MeshletBuilder {
+
+	public:
+
+		MeshletBuilder(MeshData& mesh, uint32_t* indices, size_t indexCount, const MeshletSettings& settings)
+			: mesh_(mesh), indices_(indices), triangleCount_(indexCount / 3), settings_(settings),
+			meshletSlots_(mesh.vertices.size(), kNotInMeshlet), isEmitted_(indexCount / 3, 0) {
+
+			BuildLiveTriangleAdjacency(adjacency_, indices, indexCount, mesh.vertices.size());
+
+			//三角形の表の向き(左手系の時計回りなのでcross(p1-p0,p2-p0)が表)
+			triangleNormals_.resize(triangleCount_);
+
+			for (size_t i = 0; i < triangleCount_; ++i) {
+
+				const Vector4& p0 = mesh.vertices[indices[i * 3 + 0]].position;
+				const Vector4& p1 = mesh.vertices[indices[i * 3 + 1]].position;
+				const Vector4& p2 = mesh.vertices[indices[i * 3 + 2]].position;
+
+				Vector3 e1 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+				Vector3 e2 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+
+				triangleNormals_[i] = Normalize({ e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x });
+
+			}
+
+			triangleOrder_.reserve(triangleCount_);
+
+		}
+
+		void Build() {
+
+			size_t scanPosition = 0;
+
+			//直前に閉じたメッシュレットの頂点の範囲(次の種を近くから選ぶ)
+			uint32_t previousVertexOffset = 0;
+			uint32_t previousVertexCount = 0;
+
+			while (triangleOrder_.size() < triangleCount_) {
+
+				uint32_t triangle = kInvalidTriangle;
+
+				if (localTriangleCount_ == 0) {
+
+					triangle = FindSeed(previousVertexOffset, previousVertexCount);
+
+				} else {
+
+					triangle = FindNeighbor();
+
+					if (triangle == kInvalidTriangle && localTriangleCount_ >= kMinTrianglesBeforeClose) {
+
+						previousVertexOffset = vertexOffset_;
+						previousVertexCount = localVertexCount_;
+
+						Finish();
+
+						continue;
+
+					}
+
+				}
+
+				//つながった候補がなければ入力の順で次の三角形を使う(キャッシュ最適化済みなら近くにある)
+				if (triangle == kInvalidTriangle) {
+
+					while (isEmitted_[scanPosition]) {
+						++scanPosition;
+					}
+
+					triangle = static_cast<uint32_t>(scanPosition);
+
+					if (localVertexCount_ + CountNewVertices(triangle) > kMaxMeshletVertices) {
+
+						previousVertexOffset = vertexOffset_;
+						previousVertexCount = localVertexCount_;
+
+						Finish();
+
+						continue;
+
+					}
+
+				}
+
+				Emit(triangle);
+
+				if (localTriangleCount_ == kMaxMeshletTriangles) {
+
+					previousVertexOffset = vertexOffset_;
+					previousVertexCount = localVertexCount_;
+
+					Finish();
+
+				}
+
+			}
+
+			if (localTriangleCount_ != 0) {
+				Finish();
+			}
+
+			//LOD0のインデックスをメッシュレットの順に並べ替える
+			std::vector<uint32_t> reordered(triangleCount_ * 3);
+
+			for (size_t i = 0; i < triangleCount_; ++i) {
+				std::memcpy(&reordered[i * 3], indices_ + triangleOrder_[i] * 3, sizeof(uint32_t) * 3);
+			}
+
+			std::memcpy(indices_, reordered.data(), sizeof(uint32_t) * reordered.size());
+
+		}
+
+	private:
+
+		uint32_t CountNewVertices(uint32_t triangle) const {
+
+			const uint32_t* vertices = indices_ + triangle * 3;
+
+			return (meshletSlots_[vertices[0]] == kNotInMeshlet) + (meshletSlots_[vertices[1]] == kNotInMeshlet) + (meshletSlots_[vertices[2]] == kNotInMeshlet);
+
+		}
+
+		//直前のメッシュレットに接する三角形のうち、まだ使われていない隣の少ないもの(残りの領域の縁)から始める
+		uint32_t FindSeed(uint32_t previousVertexOffset, uint32_t previousVertexCount) const {
+
+			uint32_t best = kInvalidTriangle;
+
+			uint32_t bestLiveCount = (std::numeric_limits<uint32_t>::max)();
+
+			for (uint32_t i = 0; i < previousVertexCount; ++i) {
+
+				uint32_t vertex = mesh_.meshletVertices[previousVertexOffset + i];
+
+				const uint32_t* triangles = adjacency_.triangles.data() + adjacency_.offsets[vertex];
+
+				for (uint32_t j = 0; j < adjacency_.counts[vertex]; ++j) {
+
+					const uint32_t* vertices = indices_ + triangles[j] * 3;
+
+					uint32_t liveCount = adjacency_.counts[vertices[0]] + adjacency_.counts[vertices[1]] + adjacency_.counts[vertices[2]];
+
+					if (liveCount < bestLiveCount) {
+						best = triangles[j];
+						bestLiveCount = liveCount;
+					}
+
+				}
+
+			}
+
+			return best;
+
+		}
+
+		//メッシュレットの頂点を使う三角形から、増える頂点が少なく法線が円錐の軸に近いものを選ぶ
+		uint32_t FindNeighbor() const {
+
+			Vector3 axis = Normalize(normalSum_);
+
+			uint32_t best = kInvalidTriangle;
+
+			float bestScore = (std::numeric_limits<float>::max)();
+
+			for (uint32_t i = 0; i < localVertexCount_; ++i) {
+
+				uint32_t vertex = mesh_.meshletVertices[vertexOffset_ + i];
+
+				const uint32_t* triangles = adjacency_.triangles.data() + adjacency_.offsets[vertex];
+
+				for (uint32_t j = 0; j < adjacency_.counts[vertex]; ++j) {
+
+					uint32_t triangle = triangles[j];
+
+					uint32_t newVertexCount = CountNewVertices(triangle);
+
+					//頂点が増えないものはすぐ入れる
+					if (newVertexCount == 0) {
+						return triangle;
+					}
+
+					if (localVertexCount_ + newVertexCount > kMaxMeshletVertices) {
+						continue;
+					}
+
+					float score = static_cast<float>(newVertexCount) + settings_.coneWeight * (1.0f - Dot(triangleNormals_[triangle], axis));
+
+					if (score < bestScore) {
+						best = triangle;
+						bestScore = score;
+					}
+
+				}
+
+			}
+
+			return best;
+
+		}
+
+		void Emit(uint32_t triangle) {
+
+			const uint32_t* vertices = indices_ + triangle * 3;
+
+			uint32_t packed = 0;
+
+			for (int k = 0; k < 3; ++k) {
+
+				uint32_t vertex = vertices[k];
+
+				if (meshletSlots_[vertex] == kNotInMeshlet) {
+					meshletSlots_[vertex] = static_cast<uint8_t>(localVertexCount_++);
+					mesh_.meshletVertices.push_back(vertex);
+				}
+
+				packed |= uint32_t(meshletSlots_[vertex]) << (k * 8);
+
+				RemoveLiveTriangle(adjacency_, vertex, triangle);
+
+			}
+
+			mesh_.meshletTriangles.push_back(packed);
+
+			const Vector3& normal = triangleNormals_[triangle];
+
+			normalSum_ = { normalSum_.x + normal.x, normalSum_.y + normal.y, normalSum_.z + normal.z };
+
+			isEmitted_[triangle] = 1;
+
+			triangleOrder_.push_back(triangle);
+
+			++localTriangleCount_;
+
+		}
+
+		//囲む球と法線の円錐を求めて閉じる
+		void Finish() {
+
+			Meshlet meshlet{};
+
+			meshlet.vertexOffset = vertexOffset_;
+			meshlet.vertexCount = localVertexCount_;
+			meshlet.triangleOffset = static_cast<uint32_t>(triangleOrder_.size()) - localTriangleCount_;
+			meshlet.triangleCount = localTriangleCount_;
+
+			Vector4 positions[kMaxMeshletVertices];
+
+			for (uint32_t i = 0; i < localVertexCount_; ++i) {
+				positions[i] = mesh_.vertices[mesh_.meshletVertices[vertexOffset_ + i]].position;
+			}
+
+			BoundingSphere sphere = MakeBoundingSphere(positions, localVertexCount_);
+
+			meshlet.center = sphere.center;
+			meshlet.radius = sphere.radius;
+
+			//軸から一番離れた法線との角度をαとして、sinαを入れる(90度以上開いていれば判定しない)
+			Vector3 axis = Normalize(normalSum_);
+
+			float minDot = 1.0f;
+
+			for (uint32_t i = meshlet.triangleOffset; i < meshlet.triangleOffset + meshlet.triangleCount; ++i) {
+
+				const Vector3& normal = triangleNormals_[triangleOrder_[i]];
+
+				//面積のない三角形は描かれないので数えない
+				if (normal.x != 0.0f || normal.y != 0.0f || normal.z != 0.0f) {
+					minDot = (std::min)(minDot, Dot(normal, axis));
+				}
+
+			}
+
+			bool hasAxis = axis.x != 0.0f || axis.y != 0.0f || axis.z != 0.0f;
+
+			meshlet.coneAxis = axis;
+			meshlet.coneCutoff = hasAxis && minDot > 0.0f ? std::sqrt((std::max)(1.0f - minDot * minDot, 0.0f)) : 1.0f;
+
+			mesh_.meshlets.push_back(meshlet);
+
+			for (uint32_t i = 0; i < localVertexCount_; ++i) {
+				meshletSlots_[mesh_.meshletVertices[vertexOffset_ + i]] = kNotInMeshlet;
+			}
+
+			vertexOffset_ = static_cast<uint32_t>(mesh_.meshletVertices.size());
+			localVertexCount_ = 0;
+			localTriangleCount_ = 0;
+			normalSum_ = { 0.0f, 0.0f, 0.0f };
+
+		}
+
+		MeshData& mesh_;
+
+		uint32_t* indices_;
+
+		size_t triangleCount_;
+
+		MeshletSettings settings_;
+
+		LiveTriangleAdjacency adjacency_;
+
+		std::vector<Vector3> triangleNormals_;
+
+		//頂点ごとの今のメッシュレットの中の番号
+		std::vector<uint8_t> meshletSlots_;
+
+		std::vector<uint8_t> isEmitted_;
+
+		//入れた順の三角形(元の番号)
+		std::vector<uint32_t> triangleOrder_;
+
+		uint32_t vertexOffset_ = 0;
+
+		uint32_t localVertexCount_ = 0;
+
+		uint32_t localTriangleCount_ = 0;
+
+		Vector3 normalSum_ = { 0.0f, 0.0f, 0.0f };
+
+	};
+
+	enum class MeshletCullResult {
+		kVisible,
+		kFrustum,
+		kBackface,
+		kOcclusion,
+	};
+
+	MeshletCullResult CullMeshlet(const Meshlet& meshlet, const MeshletCullParameters& parameters) {
+
+		const Vector3& center = meshlet.center;
+
+		float radius = meshlet.radius;
+
+		if (parameters.flags & kMeshletCullFrustum) {
+			for (const Vector4& plane : parameters.frustum.planes) {
+				if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+					return MeshletCullResult::kFrustum;
+				}
+			}
+		}
+
+		//球の中のどの点へ向かう視線も、円錐の中のどの法線とも90度以内なら全部裏向き
+		//軸と視線の角度が(90度-α)以内になる条件を、球の大きさのぶん保守的にしたもの
+		if ((parameters.flags & kMeshletCullBackface) && meshlet.coneCutoff < 1.0f) {
+
+			Vector3 direction = { center.x - parameters.cameraPosition.x, center.y - parameters.cameraPosition.y, center.z - parameters.cameraPosition.z };
+
+			float distance = std::sqrt(Dot(direction, direction));
+
+			if (Dot(direction, meshlet.coneAxis) >= meshlet.coneCutoff * distance + radius * (1.0f + meshlet.coneCutoff)) {
+				return MeshletCullResult::kBackface;
+			}
+
+		}
+
+		if ((parameters.flags & kMeshletCullOcclusion) && parameters.occlusionBuffer != nullptr) {
+			if (!parameters.occlusionBuffer->IsVisible(center, { radius, radius, radius }, parameters.worldViewProjectionMatrix)) {
+				return MeshletCullResult::kOcclusion;
+			}
+		}
+
+		return MeshletCullResult::kVisible;
+
+	}
+
+}
+
+void BuildMeshlets(MeshData& mesh, const MeshletSettings& settings) {
+
+	mesh.meshlets.clear();
+	mesh.meshletVertices.clear();
+	mesh.meshletTriangles.clear();
+
+	uint32_t indexOffset = mesh.lods.empty() ? 0 : mesh.lods[0].indexOffset;
+
+	size_t indexCount = mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].indexCount;
+
+	if (indexCount < 3) {
+		return;
+	}
+
+	//頂点が満杯近くになるまで閉じないので、1つに少なくとも(kMaxMeshletVertices-2)/3枚は入る
+	mesh.meshlets.reserve(indexCount / 3 / ((kMaxMeshletVertices - 2) / 3) + 1);
+	mesh.meshletVertices.reserve(indexCount / 3);
+	mesh.meshletTriangles.reserve(indexCount / 3);
+
+	MeshletBuilder builder(mesh, mesh.indices.data() + indexOffset, indexCount, settings);
+
+	builder.Build();
+
+}
+
+MeshletCullParameters MakeMeshletCullParameters(const Matrix4x4& worldViewProjectionMatrix, const Vector3& localCameraPosition, const OcclusionBuffer* occlusionBuffer, uint32_t flags) {
+
+	MeshletCullParameters parameters{};
+
+	//ワールドビュープロジェクションから取り出すとローカル空間の平面になる
+	parameters.frustum = MakeFrustum(worldViewProjectionMatrix);
+	parameters.worldViewProjectionMatrix = worldViewProjectionMatrix;
+	parameters.cameraPosition = localCameraPosition;
+	parameters.occlusionBuffer = occlusionBuffer;
+	parameters.flags = flags;
+
+	return parameters;
+
+}
+
+size_t CullMeshlets(const Meshlet* meshlets, size_t meshletCount, const MeshletCullParameters& parameters, uint32_t* visibleIndices, JobSystem* jobSystem, MeshletCullStatistics* statistics) {
+
+	auto cull = [&](size_t begin, size_t end, uint32_t* output, MeshletCullStatistics& chunkStatistics) {
+		size_t visibleCount = 0;
+		for (size_t i = begin; i < end; ++i) {
+			switch (CullMeshlet(meshlets[i], parameters)) {
+			case MeshletCullResult::kVisible:
+				output[visibleCount++] = static_cast<uint32_t>(i);
+				break;
+			case MeshletCullResult::kFrustum:
+				++chunkStatistics.frustumCulledCount;
+				break;
+			case MeshletCullResult::kBackface:
+				++chunkStatistics.backfaceCulledCount;
+				break;
+			case MeshletCullResult::kOcclusion:
+				++chunkStatistics.occlusionCulledCount;
+				break;
+			}
+		}
+		return visibleCount;
+	};
+
+	MeshletCullStatistics totalStatistics{};
+
+	if (statistics != nullptr) {
+		*statistics = totalStatistics;
+	}
+
+	if (meshletCount == 0) {
+		return 0;
+	}
+
+	uint32_t chunkCount = 1;
+
+	if (jobSystem != nullptr) {
+		chunkCount = jobSystem->GetChunkCount(meshletCount, kMinMeshletCullChunkSize);
+	}
+
+	if (chunkCount <= 1) {
+
+		size_t visibleCount = cull(0, meshletCount, visibleIndices, totalStatistics);
+
+		if (statistics != nullptr) {
+			*statistics = totalStatistics;
+		}
+
+		return visibleCount;
+
+	}
+
+	size_t chunkSize = (meshletCount + chunkCount - 1) / chunkCount;
+
+	//各塊は自分の開始位置から書き、最後に順番に詰める
+	std::vector<size_t> chunkVisibleCounts(chunkCount, 0);
+
+	std::vector<MeshletCullStatistics> chunkStatistics(chunkCount, MeshletCullStatistics{});
+
+	jobSystem->Dispatch(chunkCount, [&](uint32_t chunkIndex) {
+		size_t begin = chunkIndex * chunkSize;
+		size_t end = (std::min)(begin + chunkSize, meshletCount);
+		if (begin < end) {
+			chunkVisibleCounts[chunkIndex] = cull(begin, end, visibleIndices + begin, chunkStatistics[chunkIndex]);
+		}
+	});
+
+	size_t visibleCount = 0;
+
+	for (uint32_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) {
+
+		size_t begin = chunkIndex * chunkSize;
+
+		if (chunkIndex != 0) {
+			std::memmove(visibleIndices + visibleCount, visibleIndices + begin, sizeof(uint32_t) * chunkVisibleCounts[chunkIndex]);
+		}
+
+		visibleCount += chunkVisibleCounts[chunkIndex];
+
+		totalStatistics.frustumCulledCount += chunkStatistics[chunkIndex].frustumCulledCount;
+		totalStatistics.backfaceCulledCount += chunkStatistics[chunkIndex].backfaceCulledCount;
+		totalStatistics.occlusionCulledCount += chunkStatistics[chunkIndex].occlusionCulledCount;
+
+	}
+
+	if (statistics != nullptr) {
+		*statistics = totalStatistics;
+	}
+
+	return visibleCount;
+
+}
+
+size_t MakeMeshletDrawRanges(const Meshlet* meshlets, const uint32_t* visibleIndices, size_t visibleCount, uint32_t indexOffset, MeshletDrawRange* ranges) {
+
+	size_t rangeCount = 0;
+
+	for (size_t i = 0; i < visibleCount; ++i) {
+
+		const Meshlet& meshlet = meshlets[visibleIndices[i]];
+
+		uint32_t startIndex = indexOffset + meshlet.triangleOffset * 3;
+
+		uint32_t indexCount = meshlet.triangleCount * 3;
+
+		//前の範囲の続きならつなげる
+		if (rangeCount != 0 && ranges[rangeCount - 1].startIndex + ranges[rangeCount - 1].indexCount == startIndex) {
+			ranges[rangeCount - 1].indexCount += indexCount;
+		} else {
+			ranges[rangeCount++] = { startIndex, indexCount };
+		}
+
+	}
+
+	return rangeCount;
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "MathTypes.h"
+#include "FrustumCulling.h"
+#include "MeshImporter.h"
+
+class JobSystem;
+class OcclusionBuffer;
+
+//1つのメッシュレットに入れる頂点と三角形の最大数(メッシュシェーダーの出力の上限に合わせる)
+const uint32_t kMaxMeshletVertices = 64;
+const uint32_t kMaxMeshletTriangles = 124;
+
+struct MeshletSettings {
+
+	//隣の三角形を選ぶ時に、増える頂点の数と比べて法線の向きのそろい具合をどれだけ重く見るか
+	//大きいほど円錐が細くなって裏向きで捨てやすくなるが、頂点の重複が増える
+	float coneWeight = 0.5f;
+
+};
+
+//LOD0の三角形を、頂点を共有する隣の三角形から順に集めてメッシュレットに分ける
+//mesh.meshletsなどを作り、LOD0のインデックスをメッシュレットの順に並べ替える(どの段の範囲も変わらない)
+void BuildMeshlets(MeshData& mesh, const MeshletSettings& settings = {});
+
+//メッシュレットの判定の選択
+enum MeshletCullFlags : uint32_t {
+	kMeshletCullNone = 0,
+	//視錐台の外の球を捨てる
+	kMeshletCullFrustum = 1 << 0,
+	//すべての三角形がカメラに裏を向けているものを法線の円錐で捨てる
+	kMeshletCullBackface = 1 << 1,
+	//CPUの階層Zに隠れているものを捨てる
+	kMeshletCullOcclusion = 1 << 2,
+	kMeshletCullAll = kMeshletCullFrustum | kMeshletCullBackface | kMeshletCullOcclusion,
+};
+
+//メッシュのローカル空間で判定するための値(オブジェクトごとに作る)
+struct MeshletCullParameters {
+
+	//ワールドビュープロジェクション行列から取り出した視錐台
+	Frustum frustum;
+
+	Matrix4x4 worldViewProjectionMatrix;
+
+	//ローカル空間でのカメラの位置
+	Vector3 cameraPosition;
+
+	//nullptrなら遮蔽の判定をしない(描き終えて階層Zを作ったもの)
+	const OcclusionBuffer* occlusionBuffer;
+
+	uint32_t flags;
+
+};
+
+MeshletCullParameters MakeMeshletCullParameters(const Matrix4x4& worldViewProjectionMatrix, const Vector3& localCameraPosition, const OcclusionBuffer* occlusionBuffer, uint32_t flags = kMeshletCullAll);
+
+//判定ごとに捨てた数(前の判定で捨てたものは後の判定に数えない)
+struct MeshletCullStatistics {
+
+	size_t frustumCulledCount;
+	size_t backfaceCulledCount;
+	size_t occlusionCulledCount;
+
+};
+
+//メッシュレットを判定して、見えるものの番号を昇順に詰める。戻り値は書いた数(visibleIndicesはmeshletCountぶん必要)
+//塊に分けて並列に判定する(jobSystemがnullptrなら1スレッド)
+size_t CullMeshlets(const Meshlet* meshlets, size_t meshletCount, const MeshletCullParameters& parameters, uint32_t* visibleIndices, JobSystem* jobSystem, MeshletCullStatistics* statistics = nullptr);
+
+//インデックスバッファの中の描く範囲
+struct MeshletDrawRange {
+
+	uint32_t startIndex;
+	uint32_t indexCount;
+
+};
+
+//見えるメッシュレットを、LOD0のインデックスの中で続いているものどうしまとめて描く範囲にする
+//rangesはvisibleCountぶん必要で、書いた数を返す。indexOffsetはLOD0の先頭
+size_t MakeMeshletDrawRanges(const Meshlet* meshlets, const uint32_t* visibleIndices, size_t visibleCount, uint32_t indexOffset, MeshletDrawRange* ranges);
@@ -0,0 +1,401 @@
+#include "MipGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+//MIPGENERATOR_NO_SIMDを定義するとSIMDを使わない(テストで両方の結果を確かめる)
+#if (defined(_M_X64) || defined(__SSE2__)) && !defined(MIPGENERATOR_NO_SIMD)
+#include <emmintrin.h>
+#define MIPGENERATOR_USE_SSE2
+#endif
+
+namespace {
+
+	//1つの塊で処理する最小の行数
+	const size_t kMinRowChunkSize = 16;
+
+	//線形からsRGBへの表の大きさ(0付近の傾きが急なので細かくしておく)
+	const uint32_t kLinearToSrgbTableSize = 16384;
+
+	const float kPi = 3.14159265358979f;
+
+	struct SrgbTables {
+
+		float toLinear[256];
+
+		uint8_t fromLinear[kLinearToSrgbTableSize];
+
+		SrgbTables() {
+
+			for (uint32_t i = 0; i < 256; ++i) {
+				float c = static_cast<float>(i) / 255.0f;
+				toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+
+			for (uint32_t i = 0; i < kLinearToSrgbTableSize; ++i) {
+				float l = static_cast<float>(i) / static_cast<float>(kLinearToSrgbTableSize - 1);
+				float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+				fromLinear[i] = static_cast<uint8_t>((std::min)(c * 255.0f + 0.5f, 255.0f));
+			}
+
+		}
+
+	};
+
+	const SrgbTables& GetSrgbTables() {
+		static const SrgbTables tables;
+		return tables;
+	}
+
+	//RGBAをfloatで並べた画像
+	struct FloatImage {
+
+		uint32_t width = 0;
+		uint32_t height = 0;
+
+		std::vector<float> pixels;
+
+		float* GetRow(uint32_t y) { return pixels.data() + size_t(y) * width * 4; }
+
+		const float* GetRow(uint32_t y) const { return pixels.data() + size_t(y) * width * 4; }
+
+	};
+
+	//縮小後の1画素ごとの元の画素(端は切り詰めた位置)と重み
+	struct FilterTaps {
+
+		uint32_t tapCount = 0;
+
+		std::vector<uint32_t> sources;
+
+		std::vector<float> weights;
+
+	};
+
+	//0次の第1種変形ベッセル関数(級数で求める)
+	double BesselI0(double x) {
+
+		double sum = 1.0;
+		double term = 1.0;
+		double halfX = x * 0.5;
+
+		for (int k = 1; k < 32; ++k) {
+			term *= (halfX / k) * (halfX / k);
+			sum += term;
+			if (term < sum * 1e-12) {
+				break;
+			}
+		}
+
+		return sum;
+
+	}
+
+	//xは縮小後の画素の単位
+	float EvaluateKernel(float x, const MipSettings& settings) {
+
+		if (settings.filter == MipFilter::kBox) {
+			float distance = std::fabs(x);
+			return distance < 0.5f ? 1.0f : (distance == 0.5f ? 0.5f : 0.0f);
+		}
+
+		float ratio = x / settings.kaiserWidth;
+
+		if (ratio <= -1.0f || ratio >= 1.0f) {
+			return 0.0f;
+		}
+
+		float sinc = x == 0.0f ? 1.0f : std::sin(kPi * x) / (kPi * x);
+
+		float window = static_cast<float>(BesselI0(settings.kaiserAlpha * std::sqrt(1.0 - double(ratio) * ratio)) / BesselI0(settings.kaiserAlpha));
+
+		return sinc * window;
+
+	}
+
+	void BuildFilterTaps(FilterTaps& taps, uint32_t sourceSize, uint32_t destinationSize, const MipSettings& settings) {
+
+		float scale = static_cast<float>(sourceSize) / static_cast<float>(destinationSize);
+
+		float support = (settings.filter == MipFilter::kBox ? 0.5f : settings.kaiserWidth) * scale;
+
+		taps.tapCount = static_cast<uint32_t>(std::ceil(support * 2.0f)) + 1;
+		taps.sources.assign(size_t(destinationSize) * taps.tapCount, 0);
+		taps.weights.assign(size_t(destinationSize) * taps.tapCount, 0.0f);
+
+		for (uint32_t i = 0; i < destinationSize; ++i) {
+
+			float center = (static_cast<float>(i) + 0.5f) * scale;
+
+			int32_t first = static_cast<int32_t>(std::floor(center - support));
+
+			float weightSum = 0.0f;
+
+			for (uint32_t k = 0; k < taps.tapCount; ++k) {
+
+				int32_t source = first + static_cast<int32_t>(k);
+
+				float weight = EvaluateKernel((static_cast<float>(source) + 0.5f - center) / scale, settings);
+
+				taps.sources[size_t(i) * taps.tapCount + k] = static_cast<uint32_t>((std::clamp)(source, 0, static_cast<int32_t>(sourceSize) - 1));
+				taps.weights[size_t(i) * taps.tapCount + k] = weight;
+
+				weightSum += weight;
+
+			}
+
+			float inverseSum = weightSum != 0.0f ? 1.0f / weightSum : 0.0f;
+
+			for (uint32_t k = 0; k < taps.tapCount; ++k) {
+				taps.weights[size_t(i) * taps.tapCount + k] *= inverseSum;
+			}
+
+		}
+
+	}
+
+	template <typename Function>
+	void ForEachRowChunk(uint32_t rowCount, JobSystem* jobSystem, const Function& function) {
+		if (jobSystem != nullptr) {
+			jobSystem->ParallelFor(rowCount, kMinRowChunkSize, [&](size_t begin, size_t end) {
+				function(static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+			});
+		} else {
+			function(0, rowCount);
+		}
+	}
+
+	//横に縮める(1行の中で画素ごとに重み付きの和を取る)
+	void ResampleHorizontal(const FloatImage& source, FloatImage& destination, const FilterTaps& taps, JobSystem* jobSystem) {
+
+		ForEachRowChunk(source.height, jobSystem, [&](uint32_t begin, uint32_t end) {
+
+			for (uint32_t y = begin; y < end; ++y) {
+
+				const float* sourceRow = source.GetRow(y);
+
+				float* destinationRow = destination.GetRow(y);
+
+				for (uint32_t x = 0; x < destination.width; ++x) {
+
+					const uint32_t* sources = &taps.sources[size_t(x) * taps.tapCount];
+					const float* weights = &taps.weights[size_t(x) * taps.tapCount];
+
+#if defined(MIPGENERATOR_USE_SSE2)
+					__m128 sum = _mm_setzero_ps();
+
+					for (uint32_t k = 0; k < taps.tapCount; ++k) {
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(sourceRow + size_t(sources[k]) * 4)));
+					}
+
+					_mm_storeu_ps(destinationRow + size_t(x) * 4, sum);
+#else
+					float sum[4] = {};
+
+					for (uint32_t k = 0; k < taps.tapCount; ++k) {
+						const float* pixel = sourceRow + size_t(sources[k]) * 4;
+						for (int c = 0; c < 4; ++c) {
+							sum[c] += weights[k] * pixel[c];
+						}
+					}
+
+					std::memcpy(destinationRow + size_t(x) * 4, sum, sizeof(sum));
+#endif
+
+				}
+
+			}
+
+		});
+
+	}
+
+	//縦に縮める(行どうしの重み付きの和を、行全体についてまとめて取る)
+	void ResampleVertical(const FloatImage& source, FloatImage& destination, const FilterTaps& taps, JobSystem* jobSystem) {
+
+		size_t rowFloatCount = size_t(destination.width) * 4;
+
+		ForEachRowChunk(destination.height, jobSystem, [&](uint32_t begin, uint32_t end) {
+
+			for (uint32_t y = begin; y < end; ++y) {
+
+				const uint32_t* sources = &taps.sources[size_t(y) * taps.tapCount];
+				const float* weights = &taps.weights[size_t(y) * taps.tapCount];
+
+				float* destinationRow = destination.GetRow(y);
+
+				std::memset(destinationRow, 0, sizeof(float) * rowFloatCount);
+
+				for (uint32_t k = 0; k < taps.tapCount; ++k) {
+
+					if (weights[k] == 0.0f) {
+						continue;
+					}
+
+					const float* sourceRow = source.GetRow(sources[k]);
+
+					size_t i = 0;
+
+#if defined(MIPGENERATOR_USE_SSE2)
+					__m128 weight = _mm_set1_ps(weights[k]);
+
+					for (; i + 4 <= rowFloatCount; i += 4) {
+						_mm_storeu_ps(destinationRow + i, _mm_add_ps(_mm_loadu_ps(destinationRow + i), _mm_mul_ps(weight, _mm_loadu_ps(sourceRow + i))));
+					}
+#endif
+
+					for (; i < rowFloatCount; ++i) {
+						destinationRow[i] += weights[k] * sourceRow[i];
+					}
+
+				}
+
+			}
+
+		});
+
+	}
+
+	void ConvertToFloat(const uint8_t* pixels, uint32_t width, uint32_t height, bool isSrgb, FloatImage& image, JobSystem* jobSystem) {
+
+		const SrgbTables& tables = GetSrgbTables();
+
+		image.width = width;
+		image.height = height;
+		image.pixels.resize(size_t(width) * height * 4);
+
+		ForEachRowChunk(height, jobSystem, [&](uint32_t begin, uint32_t end) {
+			for (size_t i = size_t(begin) * width * 4; i < size_t(end) * width * 4; i += 4) {
+				for (int c = 0; c < 3; ++c) {
+					image.pixels[i + c] = isSrgb ? tables.toLinear[pixels[i + c]] : static_cast<float>(pixels[i + c]) * (1.0f / 255.0f);
+				}
+				image.pixels[i + 3] = static_cast<float>(pixels[i + 3]) * (1.0f / 255.0f);
+			}
+		});
+
+	}
+
+	//0～1に切り詰めて8bitにする(RGBはsRGBなら表を引く)
+	void ConvertToUnorm8(const FloatImage& image, bool isSrgb, uint8_t* pixels, JobSystem* jobSystem) {
+
+		const SrgbTables& tables = GetSrgbTables();
+
+		ForEachRowChunk(image.height, jobSystem, [&](uint32_t begin, uint32_t end) {
+
+			for (size_t i = size_t(begin) * image.width * 4; i < size_t(end) * image.width * 4; i += 4) {
+
+				const float* pixel = image.pixels.data() + i;
+
+				//RGBは表の位置、アルファは8bitの値に直して丸める
+				alignas(16) int32_t values[4];
+
+#if defined(MIPGENERATOR_USE_SSE2)
+				__m128 scale = isSrgb ? _mm_setr_ps(kLinearToSrgbTableSize - 1.0f, kLinearToSrgbTableSize - 1.0f, kLinearToSrgbTableSize - 1.0f, 255.0f) : _mm_set1_ps(255.0f);
+
+				__m128 clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pixel), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+
+				_mm_store_si128(reinterpret_cast<__m128i*>(values), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, scale), _mm_set1_ps(0.5f))));
+#else
+				for (int c = 0; c < 4; ++c) {
+					float scale = (isSrgb && c < 3) ? kLinearToSrgbTableSize - 1.0f : 255.0f;
+					values[c] = static_cast<int32_t>((std::min)((std::max)(pixel[c], 0.0f), 1.0f) * scale + 0.5f);
+				}
+#endif
+
+				for (int c = 0; c < 3; ++c) {
+					pixels[i + c] = isSrgb ? tables.fromLinear[values[c]] : static_cast<uint8_t>(values[c]);
+				}
+
+				pixels[i + 3] = static_cast<uint8_t>(values[3]);
+
+			}
+
+		});
+
+	}
+
+}
+
+float SrgbToLinear(uint8_t value) {
+	return GetSrgbTables().toLinear[value];
+}
+
+uint8_t LinearToSrgb(float value) {
+	float clamped = (std::min)((std::max)(value, 0.0f), 1.0f);
+	return GetSrgbTables().fromLinear[static_cast<uint32_t>(clamped * (kLinearToSrgbTableSize - 1) + 0.5f)];
+}
+
+bool GenerateMips(TextureData& texture, const MipSettings& settings, JobSystem* jobSystem) {
+
+	if (texture.format != TextureFormat::kRGBA8 && texture.format != TextureFormat::kRGBA8Srgb) {
+		return false;
+	}
+
+	bool isSrgb = IsSrgbFormat(texture.format);
+
+	//0段目を残して全段の置き場所を作り直す
+	std::vector<uint8_t> topLevel(texture.pixels.begin(), texture.pixels.begin() + texture.mips[0].size);
+
+	InitializeTexture(texture, texture.format, texture.width, texture.height);
+
+	std::memcpy(texture.pixels.data(), topLevel.data(), topLevel.size());
+
+	FloatImage source;
+
+	ConvertToFloat(topLevel.data(), texture.width, texture.height, isSrgb, source, jobSystem);
+
+	FloatImage horizontal;
+
+	FloatImage destination;
+
+	FilterTaps taps;
+
+	for (size_t mip = 1; mip < texture.mips.size(); ++mip) {
+
+		const TextureMip& level = texture.mips[mip];
+
+		//横、縦の順に縮める(大きさが変わらない向きはそのまま使う)
+		const FloatImage* current = &source;
+
+		if (level.width != source.width) {
+
+			horizontal.width = level.width;
+			horizontal.height = source.height;
+			horizontal.pixels.resize(size_t(horizontal.width) * horizontal.height * 4);
+
+			BuildFilterTaps(taps, source.width, level.width, settings);
+
+			ResampleHorizontal(source, horizontal, taps, jobSystem);
+
+			current = &horizontal;
+
+		}
+
+		if (level.height != current->height) {
+
+			destination.width = level.width;
+			destination.height = level.height;
+			destination.pixels.resize(size_t(destination.width) * destination.height * 4);
+
+			BuildFilterTaps(taps, current->height, level.height, settings);
+
+			ResampleVertical(*current, destination, taps, jobSystem);
+
+		} else {
+
+			destination.width = current->width;
+			destination.height = current->height;
+			destination.pixels = current->pixels;
+
+		}
+
+		ConvertToUnorm8(destination, isSrgb, texture.pixels.data() + level.offset, jobSystem);
+
+		std::swap(source, destination);
+
+	}
+
+	return true;
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include "Texture.h"
+#include "JobSystem.h"
+
+//縮小に使うフィルタ
+enum class MipFilter : uint32_t {
+
+	//2x2の平均(速いが、細かい模様はぼけずに折り返しが出やすい)
+	kBox,
+
+	//Kaiser窓をかけたsinc(折り返しが少なくくっきりする。負の値になる部分は0～1に切り詰める)
+	kKaiser,
+
+};
+
+struct MipSettings {
+
+	MipFilter filter = MipFilter::kKaiser;
+
+	//sincを切る位置(縮小後の画素数)と窓の鋭さ
+	float kaiserWidth = 3.0f;
+	float kaiserAlpha = 4.0f;
+
+};
+
+//0段目から1x1までの全段を作り直す(RGBA8の形式だけ。ほかの形式ならfalse)
+//sRGBの形式は線形に戻してから平均し、アルファはそのまま平均する。前の段は8bitに丸めずに次の段の元にする
+//行ごとにjobSystemで分け、画素の4チャンネルはSIMDでまとめて計算する(jobSystemがnullptrなら1スレッド)
+bool GenerateMips(TextureData& texture, const MipSettings& settings = {}, JobSystem* jobSystem = nullptr);
+
+//sRGBの8bitと線形の値の変換(表を引く)
+float SrgbToLinear(uint8_t value);
+
+uint8_t LinearToSrgb(float value);
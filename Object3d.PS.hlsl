@@ -1,3 +1,5 @@
+#include "Object3d.hlsli"
+
 struct PixelShaderOutput {
 
 	float32_t4 color : SV_TARGET0;
@@ -7,10 +9,29 @@ struct PixelShaderOutput {
 struct Material {
 
 	float32_t4 color;
+	uint32_t textureIndex;
+	uint32_t flags;
+	float32_t2 padding;
 
 };
 
-ConstantBuffer<Material> gMaterial:register(b0);
+//全マテリアルのテーブル
+StructuredBuffer<Material> gMaterials:register(t1);
+
+//ヒープ全体のテクスチャ(マテリアルのtextureIndexで参照する)
+Texture2D<float32_t4> gTextures[]:register(t0, space1);
+
+SamplerState gSampler:register(s0);
+
+//テクスチャを持たないマテリアルのtextureIndex
+static const uint32_t kInvalidTextureIndex = 0xffffffff;
+
+//RGBA8でパックされた色を展開する
+float32_t4 UnpackColor(uint32_t color) {
+
+	return float32_t4(color & 0xff, (color >> 8) & 0xff, (color >> 16) & 0xff, (color >> 24) & 0xff) / 255.0f;
+
+}
 
 struct PixelshaderOutput {
 
@@ -19,11 +40,17 @@ struct PixelshaderOutput {
 };
 
 
-PixelShaderOutput main() {
+PixelShaderOutput main(VertexShaderOutput input) {
 
 	PixelShaderOutput output;
 
-	output.color = gMaterial.color;
+	Material material = gMaterials[gDrawConstants.materialIndex];
+
+	output.color = material.color * UnpackColor(gDrawConstants.color);
+
+	if (material.textureIndex != kInvalidTextureIndex) {
+		output.color *= gTextures[material.textureIndex].Sample(gSampler, input.texcoord);
+	}
 
 	return output;
 
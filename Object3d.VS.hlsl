@@ -1,20 +1,19 @@
+#include "Object3d.hlsli"
+
 struct TransformationMatrix {
 
 	float32_t4x4 WVP;
 
 };
 
-ConstantBuffer<TransformationMatrix> gTransformationMatrix:register(b0);
-
-struct VertexShaderOutput {
-
-	float32_t4 position : SV_POSITION;
-
-};
+StructuredBuffer<TransformationMatrix> gTransformationMatrices:register(t0);
 
+//量子化した頂点(位置は0～1で、戻す変換はWVPに含まれている。法線は八面体に展開した2成分)
 struct VertexShaderInput {
 
 	float32_t4 position : POSITION0;
+	float32_t2 normal : NORMAL0;
+	float32_t2 texcoord : TEXCOORD0;
 
 };
 
@@ -22,7 +21,11 @@ VertexShaderOutput main(VertexShaderInput input) {
 
 	VertexShaderOutput output;
 
-	output.position = mul(input.position, gTransformationMatrix.WVP);
+	output.position = mul(input.position, gTransformationMatrices[gDrawConstants.objectIndex].WVP);
+
+	output.normal = DecodeOctahedralNormal(input.normal);
+
+	output.texcoord = input.texcoord;
 
 	return output;
 
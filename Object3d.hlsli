@@ -0,0 +1,33 @@
+//ルート定数で渡される描画ごとのデータ
+struct DrawConstants {
+
+	uint32_t objectIndex;
+	uint32_t materialIndex;
+	uint32_t color;
+
+};
+
+ConstantBuffer<DrawConstants> gDrawConstants:register(b1);
+
+//VSからPSへ渡すデータ
+struct VertexShaderOutput {
+
+	float32_t4 position : SV_POSITION;
+	float32_t3 normal : NORMAL0;
+	float32_t2 texcoord : TEXCOORD0;
+
+};
+
+//八面体に展開した法線を戻す(VertexFormat.cppのDecodeOctahedralと同じ)
+float32_t3 DecodeOctahedralNormal(float32_t2 encoded) {
+
+	float32_t3 normal = float32_t3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+
+	float32_t t = max(-normal.z, 0.0f);
+
+	//正の成分からはtを引き、負の成分には足す
+	normal.xy -= t * (step(0.0f, normal.xy) * 2.0f - 1.0f);
+
+	return normalize(normal);
+
+}
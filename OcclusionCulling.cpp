@@ -0,0 +1,474 @@
+#include "OcclusionCulling.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//OCCLUSION_NO_SIMDを定義するとSIMDを使わない(テストで両方の結果を確かめる)
+#if (defined(_M_X64) || defined(__SSE2__)) && !defined(OCCLUSION_NO_SIMD)
+#include <emmintrin.h>
+#define OCCLUSION_USE_SSE2
+#endif
+
+namespace {
+
+	//1つの塊で判定する最小の数
+	const size_t kMinOcclusionChunkSize = 256;
+
+	//辺関数を外へ広げる量(画素単位)
+	const float kEdgeTolerance = 1.0f / 256.0f;
+
+	//近クリップ面で切ったあとの頂点の最大数
+	const uint32_t kMaxClippedVertices = 4;
+
+	struct ClipVertex {
+
+		float x;
+		float y;
+		float z;
+		float w;
+
+	};
+
+	ClipVertex TransformToClip(const Vector4& position, const Matrix4x4& matrix) {
+
+		const float(&m)[4][4] = matrix.m;
+
+		ClipVertex result;
+
+		result.x = position.x * m[0][0] + position.y * m[1][0] + position.z * m[2][0] + position.w * m[3][0];
+		result.y = position.x * m[0][1] + position.y * m[1][1] + position.z * m[2][1] + position.w * m[3][1];
+		result.z = position.x * m[0][2] + position.y * m[1][2] + position.z * m[2][2] + position.w * m[3][2];
+		result.w = position.x * m[0][3] + position.y * m[1][3] + position.z * m[2][3] + position.w * m[3][3];
+
+		return result;
+
+	}
+
+	//reversed-Zの近クリップ面(z <= w)までの距離
+	float NearPlaneDistance(const ClipVertex& vertex) {
+		return vertex.w - vertex.z;
+	}
+
+	//三角形を近クリップ面で切る(戻り値は頂点数)
+	uint32_t ClipTriangleNear(const ClipVertex* input, ClipVertex* output) {
+
+		uint32_t count = 0;
+
+		for (uint32_t i = 0; i < 3; ++i) {
+
+			const ClipVertex& current = input[i];
+			const ClipVertex& next = input[(i + 1) % 3];
+
+			float currentDistance = NearPlaneDistance(current);
+			float nextDistance = NearPlaneDistance(next);
+
+			if (currentDistance >= 0.0f) {
+				output[count++] = current;
+			}
+
+			//辺が面をまたぐなら交点を足す
+			if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+				float t = currentDistance / (currentDistance - nextDistance);
+				output[count++] = {
+					current.x + (next.x - current.x) * t,
+					current.y + (next.y - current.y) * t,
+					current.z + (next.z - current.z) * t,
+					current.w + (next.w - current.w) * t,
+				};
+			}
+
+		}
+
+		return count;
+
+	}
+
+}
+
+void OcclusionBuffer::Initialize(uint32_t width, uint32_t height) {
+
+	width_ = (width + 3) & ~3u;
+
+	height_ = (std::max)(height, 1u);
+
+	levels_.clear();
+
+	uint32_t levelWidth = width_;
+	uint32_t levelHeight = height_;
+
+	while (true) {
+
+		levels_.push_back({ levelWidth, levelHeight, std::vector<float>(static_cast<size_t>(levelWidth) * levelHeight, 0.0f) });
+
+		if (levelWidth == 1 && levelHeight == 1) {
+			break;
+		}
+
+		levelWidth = (std::max)((levelWidth + 1) / 2, 1u);
+		levelHeight = (std::max)((levelHeight + 1) / 2, 1u);
+
+	}
+
+}
+
+void OcclusionBuffer::Clear() {
+
+	std::fill(levels_[0].depth.begin(), levels_[0].depth.end(), 0.0f);
+
+}
+
+void OcclusionBuffer::RenderOccluder(const Vector4* positions, const uint32_t* indices, size_t indexCount, const Matrix4x4& worldViewProjectionMatrix) {
+
+	float halfWidth = static_cast<float>(width_) * 0.5f;
+	float halfHeight = static_cast<float>(height_) * 0.5f;
+
+	for (size_t i = 0; i + 2 < indexCount; i += 3) {
+
+		ClipVertex triangle[3] = {
+			TransformToClip(positions[indices[i + 0]], worldViewProjectionMatrix),
+			TransformToClip(positions[indices[i + 1]], worldViewProjectionMatrix),
+			TransformToClip(positions[indices[i + 2]], worldViewProjectionMatrix),
+		};
+
+		ClipVertex clipped[kMaxClippedVertices];
+
+		uint32_t clippedCount = ClipTriangleNear(triangle, clipped);
+
+		if (clippedCount < 3) {
+			continue;
+		}
+
+		//スクリーン座標へ(yは下向き)
+		float screen[kMaxClippedVertices][3];
+
+		for (uint32_t j = 0; j < clippedCount; ++j) {
+			float inverseW = 1.0f / clipped[j].w;
+			screen[j][0] = (clipped[j].x * inverseW + 1.0f) * halfWidth;
+			screen[j][1] = (1.0f - clipped[j].y * inverseW) * halfHeight;
+			screen[j][2] = clipped[j].z * inverseW;
+		}
+
+		for (uint32_t j = 1; j + 1 < clippedCount; ++j) {
+			RasterizeTriangle(screen[0], screen[j], screen[j + 1]);
+		}
+
+	}
+
+}
+
+void OcclusionBuffer::RasterizeTriangle(const float* v0, const float* v1, const float* v2) {
+
+	float area = (v1[0] - v0[0]) * (v2[1] - v0[1]) - (v2[0] - v0[0]) * (v1[1] - v0[1]);
+
+	if (std::fabs(area) < 1e-8f) {
+		return;
+	}
+
+	//裏向きでも描くので、向きをそろえる
+	if (area < 0.0f) {
+		std::swap(v1, v2);
+		area = -area;
+	}
+
+	float minX = (std::min)({ v0[0], v1[0], v2[0] });
+	float maxX = (std::max)({ v0[0], v1[0], v2[0] });
+	float minY = (std::min)({ v0[1], v1[1], v2[1] });
+	float maxY = (std::max)({ v0[1], v1[1], v2[1] });
+
+	if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(width_) || minY >= static_cast<float>(height_)) {
+		return;
+	}
+
+	//4画素単位で処理するので開始位置は4にそろえる
+	int32_t beginX = static_cast<int32_t>((std::max)(minX, 0.0f)) & ~3;
+	int32_t endX = static_cast<int32_t>((std::min)(maxX, static_cast<float>(width_ - 1)));
+	int32_t beginY = static_cast<int32_t>((std::max)(minY, 0.0f));
+	int32_t endY = static_cast<int32_t>((std::min)(maxY, static_cast<float>(height_ - 1)));
+
+	//辺関数 e = a*x + b*y + c (内側で0以上)
+	const float* vertices[3] = { v0, v1, v2 };
+
+	float edgeA[3];
+	float edgeB[3];
+	float edgeC[3];
+
+	for (int i = 0; i < 3; ++i) {
+		const float* a = vertices[i];
+		const float* b = vertices[(i + 1) % 3];
+		edgeA[i] = a[1] - b[1];
+		edgeB[i] = b[0] - a[0];
+		edgeC[i] = -(edgeA[i] * a[0] + edgeB[i] * a[1]);
+	}
+
+	//深度の平面 z = a*x + b*y + c (各辺関数が向かいの頂点の重みになる)
+	float inverseArea = 1.0f / area;
+
+	float depthA = (edgeA[1] * v0[2] + edgeA[2] * v1[2] + edgeA[0] * v2[2]) * inverseArea;
+	float depthB = (edgeB[1] * v0[2] + edgeB[2] * v1[2] + edgeB[0] * v2[2]) * inverseArea;
+	float depthC = (edgeC[1] * v0[2] + edgeC[2] * v1[2] + edgeC[0] * v2[2]) * inverseArea;
+
+	//画素の中で一番奥の深度になるように半画素ぶんの傾きだけ奥へずらす
+	float depthBias = 0.5f * (std::fabs(depthA) + std::fabs(depthB));
+
+	float minDepth = (std::min)({ v0[2], v1[2], v2[2] });
+
+	//共有する辺で誤差によって隙間ができないように、辺を少しだけ外へ広げる
+	for (int i = 0; i < 3; ++i) {
+		edgeC[i] += (std::fabs(edgeA[i]) + std::fabs(edgeB[i])) * kEdgeTolerance;
+	}
+
+	float* depth = levels_[0].depth.data();
+
+#if defined(OCCLUSION_USE_SSE2)
+
+	__m128 laneOffset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+	__m128 zero = _mm_setzero_ps();
+
+	__m128 minDepth4 = _mm_set1_ps(minDepth);
+
+	//4画素進むごとの増分
+	__m128 edgeStep[3];
+
+	for (int i = 0; i < 3; ++i) {
+		edgeStep[i] = _mm_set1_ps(edgeA[i] * 4.0f);
+	}
+
+	__m128 depthStep = _mm_set1_ps(depthA * 4.0f);
+
+	__m128 startX = _mm_add_ps(_mm_set1_ps(static_cast<float>(beginX)), laneOffset);
+
+	for (int32_t y = beginY; y <= endY; ++y) {
+
+		float pixelY = static_cast<float>(y) + 0.5f;
+
+		float* row = depth + static_cast<size_t>(y) * width_;
+
+		//行の先頭の値を求めて、あとは足していく
+		__m128 edge[3];
+
+		for (int i = 0; i < 3; ++i) {
+			edge[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[i]), startX), _mm_set1_ps(edgeB[i] * pixelY + edgeC[i]));
+		}
+
+		__m128 pixelDepth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthA), startX), _mm_set1_ps(depthB * pixelY + depthC - depthBias));
+
+		for (int32_t x = beginX; x <= endX; x += 4) {
+
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge[0], zero), _mm_cmpge_ps(edge[1], zero)), _mm_cmpge_ps(edge[2], zero));
+
+			if (_mm_movemask_ps(inside) != 0) {
+
+				__m128 current = _mm_loadu_ps(row + x);
+
+				//手前の方を残す
+				__m128 result = _mm_max_ps(current, _mm_max_ps(pixelDepth, minDepth4));
+
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, result), _mm_andnot_ps(inside, current)));
+
+			}
+
+			edge[0] = _mm_add_ps(edge[0], edgeStep[0]);
+			edge[1] = _mm_add_ps(edge[1], edgeStep[1]);
+			edge[2] = _mm_add_ps(edge[2], edgeStep[2]);
+
+			pixelDepth = _mm_add_ps(pixelDepth, depthStep);
+
+		}
+
+	}
+
+#else
+
+	for (int32_t y = beginY; y <= endY; ++y) {
+
+		float pixelY = static_cast<float>(y) + 0.5f;
+
+		float* row = depth + static_cast<size_t>(y) * width_;
+
+		for (int32_t x = beginX; x <= endX; ++x) {
+
+			float pixelX = static_cast<float>(x) + 0.5f;
+
+			bool isInside = true;
+
+			for (int i = 0; i < 3; ++i) {
+				isInside = isInside && edgeA[i] * pixelX + edgeB[i] * pixelY + edgeC[i] >= 0.0f;
+			}
+
+			if (!isInside) {
+				continue;
+			}
+
+			float pixelDepth = (std::max)(depthA * pixelX + depthB * pixelY + depthC - depthBias, minDepth);
+
+			row[x] = (std::max)(row[x], pixelDepth);
+
+		}
+
+	}
+
+#endif
+
+}
+
+void OcclusionBuffer::BuildHierarchy() {
+
+	for (size_t level = 1; level < levels_.size(); ++level) {
+
+		const Level& source = levels_[level - 1];
+
+		Level& destination = levels_[level];
+
+		for (uint32_t y = 0; y < destination.height; ++y) {
+
+			uint32_t sourceY0 = y * 2;
+			uint32_t sourceY1 = (std::min)(sourceY0 + 1, source.height - 1);
+
+			for (uint32_t x = 0; x < destination.width; ++x) {
+
+				uint32_t sourceX0 = x * 2;
+				uint32_t sourceX1 = (std::min)(sourceX0 + 1, source.width - 1);
+
+				//reversed-Zなので小さい方が奥
+				float depth = (std::min)(
+					(std::min)(source.depth[sourceY0 * source.width + sourceX0], source.depth[sourceY0 * source.width + sourceX1]),
+					(std::min)(source.depth[sourceY1 * source.width + sourceX0], source.depth[sourceY1 * source.width + sourceX1]));
+
+				destination.depth[static_cast<size_t>(y) * destination.width + x] = depth;
+
+			}
+
+		}
+
+	}
+
+}
+
+bool OcclusionBuffer::IsVisible(const Vector3& aabbCenter, const Vector3& aabbExtent, const Matrix4x4& viewProjectionMatrix) const {
+
+	float minX = static_cast<float>(width_);
+	float maxX = 0.0f;
+	float minY = static_cast<float>(height_);
+	float maxY = 0.0f;
+	float maxDepth = 0.0f;
+
+	for (int corner = 0; corner < 8; ++corner) {
+
+		Vector4 position = {
+			aabbCenter.x + ((corner & 1) ? aabbExtent.x : -aabbExtent.x),
+			aabbCenter.y + ((corner & 2) ? aabbExtent.y : -aabbExtent.y),
+			aabbCenter.z + ((corner & 4) ? aabbExtent.z : -aabbExtent.z),
+			1.0f,
+		};
+
+		ClipVertex clip = TransformToClip(position, viewProjectionMatrix);
+
+		//近クリップ面をまたぐ箱はカメラに触れているので見えるものとする
+		if (NearPlaneDistance(clip) <= 0.0f) {
+			return true;
+		}
+
+		float inverseW = 1.0f / clip.w;
+
+		float x = (clip.x * inverseW + 1.0f) * 0.5f * static_cast<float>(width_);
+		float y = (1.0f - clip.y * inverseW) * 0.5f * static_cast<float>(height_);
+
+		minX = (std::min)(minX, x);
+		maxX = (std::max)(maxX, x);
+		minY = (std::min)(minY, y);
+		maxY = (std::max)(maxY, y);
+		maxDepth = (std::max)(maxDepth, clip.z * inverseW);
+
+	}
+
+	if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(width_) || minY >= static_cast<float>(height_)) {
+		return false;
+	}
+
+	uint32_t beginX = static_cast<uint32_t>((std::max)(minX, 0.0f));
+	uint32_t endX = static_cast<uint32_t>((std::min)(maxX, static_cast<float>(width_ - 1)));
+	uint32_t beginY = static_cast<uint32_t>((std::max)(minY, 0.0f));
+	uint32_t endY = static_cast<uint32_t>((std::min)(maxY, static_cast<float>(height_ - 1)));
+
+	//矩形が4x4の画素に収まる段を選ぶ(2x2だと粗すぎて隠れているものまで見えることが多い)
+	uint32_t level = 0;
+
+	while (level + 1 < levels_.size() && ((endX >> level) - (beginX >> level) > 3 || (endY >> level) - (beginY >> level) > 3)) {
+		++level;
+	}
+
+	const Level& hierarchy = levels_[level];
+
+	uint32_t x0 = (std::min)(beginX >> level, hierarchy.width - 1);
+	uint32_t x1 = (std::min)(endX >> level, hierarchy.width - 1);
+	uint32_t y0 = (std::min)(beginY >> level, hierarchy.height - 1);
+	uint32_t y1 = (std::min)(endY >> level, hierarchy.height - 1);
+
+	float occluderDepth = 1.0f;
+
+	for (uint32_t y = y0; y <= y1; ++y) {
+		for (uint32_t x = x0; x <= x1; ++x) {
+			occluderDepth = (std::min)(occluderDepth, hierarchy.depth[static_cast<size_t>(y) * hierarchy.width + x]);
+		}
+	}
+
+	//箱の一番手前が遮蔽物の一番奥より手前なら見える
+	return maxDepth >= occluderDepth;
+
+}
+
+size_t OcclusionBuffer::Cull(const AABBArray& aabbs, const uint32_t* candidateIndices, size_t candidateCount, const Matrix4x4& viewProjectionMatrix, uint32_t* visibleIndices, JobSystem* jobSystem) const {
+
+	auto cull = [&](size_t begin, size_t end, uint32_t* output) {
+		size_t visibleCount = 0;
+		for (size_t i = begin; i < end; ++i) {
+			uint32_t index = candidateIndices[i];
+			Vector3 center = { aabbs.GetCenterX()[index], aabbs.GetCenterY()[index], aabbs.GetCenterZ()[index] };
+			Vector3 extent = { aabbs.GetExtentX()[index], aabbs.GetExtentY()[index], aabbs.GetExtentZ()[index] };
+			if (IsVisible(center, extent, viewProjectionMatrix)) {
+				output[visibleCount++] = index;
+			}
+		}
+		return visibleCount;
+	};
+
+	if (candidateCount == 0) {
+		return 0;
+	}
+
+	uint32_t chunkCount = 1;
+
+	if (jobSystem != nullptr) {
+		chunkCount = jobSystem->GetChunkCount(candidateCount, kMinOcclusionChunkSize);
+	}
+
+	if (chunkCount <= 1) {
+		return cull(0, candidateCount, visibleIndices);
+	}
+
+	size_t chunkSize = (candidateCount + chunkCount - 1) / chunkCount;
+
+	//各塊は自分の開始位置から書き、最後に順番に詰める
+	std::vector<size_t> chunkVisibleCounts(chunkCount, 0);
+
+	jobSystem->Dispatch(chunkCount, [&](uint32_t chunkIndex) {
+		size_t begin = chunkIndex * chunkSize;
+		size_t end = (std::min)(begin + chunkSize, candidateCount);
+		if (begin < end) {
+			chunkVisibleCounts[chunkIndex] = cull(begin, end, visibleIndices + begin);
+		}
+	});
+
+	size_t visibleCount = chunkVisibleCounts[0];
+
+	for (uint32_t chunkIndex = 1; chunkIndex < chunkCount; ++chunkIndex) {
+		size_t begin = chunkIndex * chunkSize;
+		std::memmove(visibleIndices + visibleCount, visibleIndices + begin, sizeof(uint32_t) * chunkVisibleCounts[chunkIndex]);
+		visibleCount += chunkVisibleCounts[chunkIndex];
+	}
+
+	return visibleCount;
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "MathTypes.h"
+#include "FrustumCulling.h"
+
+class JobSystem;
+
+//CPUで遮蔽物を低解像度の深度バッファに描き、階層Zで遮蔽判定する
+//深度はreversed-Z(手前ほど大きい、0が一番奥)
+class OcclusionBuffer {
+
+public:
+
+	//幅は4の倍数に切り上げる
+	void Initialize(uint32_t width, uint32_t height);
+
+	//一番奥(0)でクリアする
+	void Clear();
+
+	//ローカル座標の三角形リストを遮蔽物として描く(表裏は区別しない)
+	void RenderOccluder(const Vector4* positions, const uint32_t* indices, size_t indexCount, const Matrix4x4& worldViewProjectionMatrix);
+
+	//遮蔽物を描き終えたら階層Zを作る(各段は2x2の最も奥の深度)
+	void BuildHierarchy();
+
+	//ワールド空間のAABBが遮蔽物に隠れていなければtrue(判断できない時もtrue)
+	bool IsVisible(const Vector3& aabbCenter, const Vector3& aabbExtent, const Matrix4x4& viewProjectionMatrix) const;
+
+	//candidateIndicesのうち隠れていないものをvisibleIndicesに詰める(順番は保つ)
+	//visibleIndicesはcandidateCountぶん必要で、candidateIndicesと同じでもよい
+	size_t Cull(const AABBArray& aabbs, const uint32_t* candidateIndices, size_t candidateCount, const Matrix4x4& viewProjectionMatrix, uint32_t* visibleIndices, JobSystem* jobSystem) const;
+
+	uint32_t GetWidth() const { return width_; }
+
+	uint32_t GetHeight() const { return height_; }
+
+	uint32_t GetLevelCount() const { return static_cast<uint32_t>(levels_.size()); }
+
+	//階層Zのlevel段目の深度
+	const float* GetDepth(uint32_t level) const { return levels_[level].depth.data(); }
+
+private:
+
+	struct Level {
+
+		uint32_t width;
+		uint32_t height;
+		std::vector<float> depth;
+
+	};
+
+	//スクリーン座標の三角形を1枚描く
+	void RasterizeTriangle(const float* v0, const float* v1, const float* v2);
+
+	uint32_t width_ = 0;
+
+	uint32_t height_ = 0;
+
+	std::vector<Level> levels_;
+
+};
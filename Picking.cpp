@@ -0,0 +1,362 @@
+#include "Picking.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//PICKING_NO_SIMDを定義するとSIMDを使わない(テストで両方の結果を確かめる)
+#if (defined(_M_X64) || defined(__SSE2__)) && !defined(PICKING_NO_SIMD)
+#include <emmintrin.h>
+#define PICKING_USE_SSE2
+#endif
+
+namespace {
+
+	//これより行列式が小さい三角形はレイと平行とみなす
+	const float kParallelEpsilon = 1e-12f;
+
+	Vector3 TransformPoint(const Vector3& point, const Matrix4x4& matrix) {
+
+		const float(&m)[4][4] = matrix.m;
+
+		float x = point.x * m[0][0] + point.y * m[1][0] + point.z * m[2][0] + m[3][0];
+		float y = point.x * m[0][1] + point.y * m[1][1] + point.z * m[2][1] + m[3][1];
+		float z = point.x * m[0][2] + point.y * m[1][2] + point.z * m[2][2] + m[3][2];
+		float w = point.x * m[0][3] + point.y * m[1][3] + point.z * m[2][3] + m[3][3];
+
+		return { x / w, y / w, z / w };
+
+	}
+
+	Vector3 TransformDirection(const Vector3& direction, const Matrix4x4& matrix) {
+
+		const float(&m)[4][4] = matrix.m;
+
+		return {
+			direction.x * m[0][0] + direction.y * m[1][0] + direction.z * m[2][0],
+			direction.x * m[0][1] + direction.y * m[1][1] + direction.z * m[2][1],
+			direction.x * m[0][2] + direction.y * m[1][2] + direction.z * m[2][2],
+		};
+
+	}
+
+	//10bitの値を3bitおきに広げる(モートン符号用)
+	uint32_t ExpandBits(uint32_t value) {
+
+		value = (value * 0x00010001u) & 0xFF0000FFu;
+		value = (value * 0x00000101u) & 0x0F00F00Fu;
+		value = (value * 0x00000011u) & 0xC30C30C3u;
+		value = (value * 0x00000005u) & 0x49249249u;
+
+		return value;
+
+	}
+
+}
+
+Ray MakePickingRay(float screenX, float screenY, float screenWidth, float screenHeight, const Matrix4x4& inverseViewProjectionMatrix) {
+
+	float ndcX = screenX / screenWidth * 2.0f - 1.0f;
+	float ndcY = 1.0f - screenY / screenHeight * 2.0f;
+
+	Vector3 nearPoint = TransformPoint({ ndcX, ndcY, 1.0f }, inverseViewProjectionMatrix);
+	Vector3 farPoint = TransformPoint({ ndcX, ndcY, 0.0f }, inverseViewProjectionMatrix);
+
+	//距離1で遠クリップ面に届くレイになる
+	return { nearPoint, { farPoint.x - nearPoint.x, farPoint.y - nearPoint.y, farPoint.z - nearPoint.z } };
+
+}
+
+Ray TransformRay(const Ray& ray, const Matrix4x4& matrix) {
+
+	const float(&m)[4][4] = matrix.m;
+
+	Vector3 origin = {
+		ray.origin.x * m[0][0] + ray.origin.y * m[1][0] + ray.origin.z * m[2][0] + m[3][0],
+		ray.origin.x * m[0][1] + ray.origin.y * m[1][1] + ray.origin.z * m[2][1] + m[3][1],
+		ray.origin.x * m[0][2] + ray.origin.y * m[1][2] + ray.origin.z * m[2][2] + m[3][2],
+	};
+
+	return { origin, TransformDirection(ray.direction, matrix) };
+
+}
+
+bool IntersectRayTrianglePacket(const Ray& ray, const TrianglePacket& packet, float maxDistance, float& distance, uint32_t& lane) {
+
+	//Moller-Trumboreの方法を4つの三角形で同時に行う
+#if defined(PICKING_USE_SSE2)
+
+	__m128 directionX = _mm_set1_ps(ray.direction.x);
+	__m128 directionY = _mm_set1_ps(ray.direction.y);
+	__m128 directionZ = _mm_set1_ps(ray.direction.z);
+
+	__m128 edge1X = _mm_loadu_ps(packet.edge1x);
+	__m128 edge1Y = _mm_loadu_ps(packet.edge1y);
+	__m128 edge1Z = _mm_loadu_ps(packet.edge1z);
+	__m128 edge2X = _mm_loadu_ps(packet.edge2x);
+	__m128 edge2Y = _mm_loadu_ps(packet.edge2y);
+	__m128 edge2Z = _mm_loadu_ps(packet.edge2z);
+
+	//p = d x e2
+	__m128 pX = _mm_sub_ps(_mm_mul_ps(directionY, edge2Z), _mm_mul_ps(directionZ, edge2Y));
+	__m128 pY = _mm_sub_ps(_mm_mul_ps(directionZ, edge2X), _mm_mul_ps(directionX, edge2Z));
+	__m128 pZ = _mm_sub_ps(_mm_mul_ps(directionX, edge2Y), _mm_mul_ps(directionY, edge2X));
+
+	__m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge1X, pX), _mm_mul_ps(edge1Y, pY)), _mm_mul_ps(edge1Z, pZ));
+
+	//|det| > epsilon
+	__m128 absoluteDeterminant = _mm_andnot_ps(_mm_set1_ps(-0.0f), determinant);
+
+	__m128 mask = _mm_cmpgt_ps(absoluteDeterminant, _mm_set1_ps(kParallelEpsilon));
+
+	__m128 inverseDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+
+	//t = o - v0
+	__m128 tX = _mm_sub_ps(_mm_set1_ps(ray.origin.x), _mm_loadu_ps(packet.v0x));
+	__m128 tY = _mm_sub_ps(_mm_set1_ps(ray.origin.y), _mm_loadu_ps(packet.v0y));
+	__m128 tZ = _mm_sub_ps(_mm_set1_ps(ray.origin.z), _mm_loadu_ps(packet.v0z));
+
+	__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tX, pX), _mm_mul_ps(tY, pY)), _mm_mul_ps(tZ, pZ)), inverseDeterminant);
+
+	//q = t x e1
+	__m128 qX = _mm_sub_ps(_mm_mul_ps(tY, edge1Z), _mm_mul_ps(tZ, edge1Y));
+	__m128 qY = _mm_sub_ps(_mm_mul_ps(tZ, edge1X), _mm_mul_ps(tX, edge1Z));
+	__m128 qZ = _mm_sub_ps(_mm_mul_ps(tX, edge1Y), _mm_mul_ps(tY, edge1X));
+
+	__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(directionX, qX), _mm_mul_ps(directionY, qY)), _mm_mul_ps(directionZ, qZ)), inverseDeterminant);
+
+	__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(edge2X, qX), _mm_mul_ps(edge2Y, qY)), _mm_mul_ps(edge2Z, qZ)), inverseDeterminant);
+
+	__m128 zero = _mm_setzero_ps();
+
+	mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+	mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+	mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+	mask = _mm_and_ps(mask, _mm_cmpge_ps(t, zero));
+	mask = _mm_and_ps(mask, _mm_cmplt_ps(t, _mm_set1_ps(maxDistance)));
+
+	int hitMask = _mm_movemask_ps(mask);
+
+	if (hitMask == 0) {
+		return false;
+	}
+
+	alignas(16) float distances[4];
+
+	_mm_store_ps(distances, t);
+
+	bool isHit = false;
+
+	for (uint32_t i = 0; i < 4; ++i) {
+		if ((hitMask & (1 << i)) && distances[i] < maxDistance) {
+			maxDistance = distances[i];
+			distance = distances[i];
+			lane = i;
+			isHit = true;
+		}
+	}
+
+	return isHit;
+
+#else
+
+	bool isHit = false;
+
+	for (uint32_t i = 0; i < 4; ++i) {
+
+		float pX = ray.direction.y * packet.edge2z[i] - ray.direction.z * packet.edge2y[i];
+		float pY = ray.direction.z * packet.edge2x[i] - ray.direction.x * packet.edge2z[i];
+		float pZ = ray.direction.x * packet.edge2y[i] - ray.direction.y * packet.edge2x[i];
+
+		float determinant = packet.edge1x[i] * pX + packet.edge1y[i] * pY + packet.edge1z[i] * pZ;
+
+		if (std::fabs(determinant) <= kParallelEpsilon) {
+			continue;
+		}
+
+		float inverseDeterminant = 1.0f / determinant;
+
+		float tX = ray.origin.x - packet.v0x[i];
+		float tY = ray.origin.y - packet.v0y[i];
+		float tZ = ray.origin.z - packet.v0z[i];
+
+		float u = (tX * pX + tY * pY + tZ * pZ) * inverseDeterminant;
+
+		float qX = tY * packet.edge1z[i] - tZ * packet.edge1y[i];
+		float qY = tZ * packet.edge1x[i] - tX * packet.edge1z[i];
+		float qZ = tX * packet.edge1y[i] - tY * packet.edge1x[i];
+
+		float v = (ray.direction.x * qX + ray.direction.y * qY + ray.direction.z * qZ) * inverseDeterminant;
+
+		float t = (packet.edge2x[i] * qX + packet.edge2y[i] * qY + packet.edge2z[i] * qZ) * inverseDeterminant;
+
+		if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < maxDistance) {
+			maxDistance = t;
+			distance = t;
+			lane = i;
+			isHit = true;
+		}
+
+	}
+
+	return isHit;
+
+#endif
+
+}
+
+void PickingMesh::Build(const Vector4* positions, const uint32_t* indices, size_t indexCount) {
+
+	triangleCount_ = indexCount / 3;
+
+	packets_.clear();
+
+	if (triangleCount_ == 0) {
+		bvh_.Build(nullptr, 0);
+		return;
+	}
+
+	//重心のモートン符号で並べて、空間的に近い三角形を同じまとまりに入れる
+	std::vector<Vector3> centroids(triangleCount_);
+
+	Vector3 centroidMin = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+	Vector3 centroidMax = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+
+	for (size_t i = 0; i < triangleCount_; ++i) {
+
+		const Vector4& p0 = positions[indices[i * 3 + 0]];
+		const Vector4& p1 = positions[indices[i * 3 + 1]];
+		const Vector4& p2 = positions[indices[i * 3 + 2]];
+
+		centroids[i] = { (p0.x + p1.x + p2.x) / 3.0f, (p0.y + p1.y + p2.y) / 3.0f, (p0.z + p1.z + p2.z) / 3.0f };
+
+		centroidMin.x = (std::min)(centroidMin.x, centroids[i].x);
+		centroidMin.y = (std::min)(centroidMin.y, centroids[i].y);
+		centroidMin.z = (std::min)(centroidMin.z, centroids[i].z);
+		centroidMax.x = (std::max)(centroidMax.x, centroids[i].x);
+		centroidMax.y = (std::max)(centroidMax.y, centroids[i].y);
+		centroidMax.z = (std::max)(centroidMax.z, centroids[i].z);
+
+	}
+
+	auto quantize = [](float value, float min, float max) {
+		float extent = max - min;
+		float normalized = extent > 0.0f ? (value - min) / extent : 0.0f;
+		return (std::min)(static_cast<uint32_t>(normalized * 1023.0f), 1023u);
+	};
+
+	std::vector<uint64_t> sortKeys(triangleCount_);
+
+	for (size_t i = 0; i < triangleCount_; ++i) {
+
+		uint32_t code = ExpandBits(quantize(centroids[i].x, centroidMin.x, centroidMax.x)) << 2 |
+			ExpandBits(quantize(centroids[i].y, centroidMin.y, centroidMax.y)) << 1 |
+			ExpandBits(quantize(centroids[i].z, centroidMin.z, centroidMax.z));
+
+		sortKeys[i] = static_cast<uint64_t>(code) << 32 | i;
+
+	}
+
+	std::sort(sortKeys.begin(), sortKeys.end());
+
+	//4つずつ詰める(足りない分は面積0の三角形で埋めるので当たらない)
+	size_t packetCount = (triangleCount_ + 3) / 4;
+
+	packets_.resize(packetCount);
+
+	std::vector<AABB> packetBounds(packetCount);
+
+	for (size_t packetIndex = 0; packetIndex < packetCount; ++packetIndex) {
+
+		TrianglePacket& packet = packets_[packetIndex];
+
+		packet = {};
+
+		AABB& bounds = packetBounds[packetIndex];
+
+		bounds.min = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+		bounds.max = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+
+		for (uint32_t lane = 0; lane < 4; ++lane) {
+
+			size_t sortedIndex = packetIndex * 4 + lane;
+
+			if (sortedIndex >= triangleCount_) {
+				packet.triangleIndices[lane] = Bvh::kInvalidIndex;
+				continue;
+			}
+
+			uint32_t triangleIndex = static_cast<uint32_t>(sortKeys[sortedIndex] & 0xffffffff);
+
+			const Vector4* vertices[3] = {
+				&positions[indices[triangleIndex * 3 + 0]],
+				&positions[indices[triangleIndex * 3 + 1]],
+				&positions[indices[triangleIndex * 3 + 2]],
+			};
+
+			packet.v0x[lane] = vertices[0]->x;
+			packet.v0y[lane] = vertices[0]->y;
+			packet.v0z[lane] = vertices[0]->z;
+			packet.edge1x[lane] = vertices[1]->x - vertices[0]->x;
+			packet.edge1y[lane] = vertices[1]->y - vertices[0]->y;
+			packet.edge1z[lane] = vertices[1]->z - vertices[0]->z;
+			packet.edge2x[lane] = vertices[2]->x - vertices[0]->x;
+			packet.edge2y[lane] = vertices[2]->y - vertices[0]->y;
+			packet.edge2z[lane] = vertices[2]->z - vertices[0]->z;
+			packet.triangleIndices[lane] = triangleIndex;
+
+			for (const Vector4* vertex : vertices) {
+				bounds.min.x = (std::min)(bounds.min.x, vertex->x);
+				bounds.min.y = (std::min)(bounds.min.y, vertex->y);
+				bounds.min.z = (std::min)(bounds.min.z, vertex->z);
+				bounds.max.x = (std::max)(bounds.max.x, vertex->x);
+				bounds.max.y = (std::max)(bounds.max.y, vertex->y);
+				bounds.max.z = (std::max)(bounds.max.z, vertex->z);
+			}
+
+		}
+
+	}
+
+	bvh_.Build(packetBounds.data(), packetBounds.size());
+
+}
+
+bool PickingMesh::Intersect(const Ray& ray, float maxDistance, float& distance, uint32_t* triangleIndex) const {
+
+	float closestDistance = maxDistance;
+
+	uint32_t closestTriangle = Bvh::kInvalidIndex;
+
+	uint32_t hitPacket = bvh_.Raycast(ray, maxDistance, [&](uint32_t packetIndex, float& hitDistance) {
+
+		float packetDistance = 0.0f;
+
+		uint32_t lane = 0;
+
+		if (!IntersectRayTrianglePacket(ray, packets_[packetIndex], closestDistance, packetDistance, lane)) {
+			return false;
+		}
+
+		closestDistance = packetDistance;
+
+		closestTriangle = packets_[packetIndex].triangleIndices[lane];
+
+		hitDistance = packetDistance;
+
+		return true;
+
+	}, nullptr);
+
+	if (hitPacket == Bvh::kInvalidIndex) {
+		return false;
+	}
+
+	distance = closestDistance;
+
+	if (triangleIndex != nullptr) {
+		*triangleIndex = closestTriangle;
+	}
+
+	return true;
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "MathTypes.h"
+#include "Bvh.h"
+
+//スクリーン座標からワールド空間のレイを作る(reversed-Zなので深度1が近クリップ面、0が遠クリップ面)
+Ray MakePickingRay(float screenX, float screenY, float screenWidth, float screenHeight, const Matrix4x4& inverseViewProjectionMatrix);
+
+//レイを行列で変換する(directionは長さを保たないので、距離のパラメータは変換前と同じになる)
+Ray TransformRay(const Ray& ray, const Matrix4x4& matrix);
+
+//三角形4つを成分ごとに並べたもの(SIMDで4つ同時に判定する)
+struct TrianglePacket {
+
+	float v0x[4];
+	float v0y[4];
+	float v0z[4];
+	float edge1x[4];
+	float edge1y[4];
+	float edge1z[4];
+	float edge2x[4];
+	float edge2y[4];
+	float edge2z[4];
+
+	uint32_t triangleIndices[4];
+
+};
+
+//4つの三角形とレイの交差(両面)。maxDistanceより近い最も近いものがあれば距離とレーンを書いてtrue
+bool IntersectRayTrianglePacket(const Ray& ray, const TrianglePacket& packet, float maxDistance, float& distance, uint32_t& lane);
+
+//ピッキング用のメッシュ(三角形を空間的に近い4つずつにまとめ、そのまとまりのBVHを持つ)
+class PickingMesh {
+
+public:
+
+	void Build(const Vector4* positions, const uint32_t* indices, size_t indexCount);
+
+	//ローカル空間のレイと最も近い三角形の交差
+	bool Intersect(const Ray& ray, float maxDistance, float& distance, uint32_t* triangleIndex) const;
+
+	size_t GetTriangleCount() const { return triangleCount_; }
+
+private:
+
+	std::vector<TrianglePacket> packets_;
+
+	Bvh bvh_;
+
+	size_t triangleCount_ = 0;
+
+};
@@ -0,0 +1,206 @@
+#include "PipelineStateCache.h"
+#include <Windows.h>
+#include <cassert>
+#include <format>
+#include <fstream>
+
+void PipelineStateCache::Initialize(ID3D12Device* device, const std::wstring& filePath) {
+
+	device_ = device;
+
+	filePath_ = filePath;
+
+	ID3D12Device1* device1 = nullptr;
+
+	//PipelineLibraryが使えない環境では実行中の重複排除だけ行う
+	if (FAILED(device_->QueryInterface(IID_PPV_ARGS(&device1)))) {
+		OutputDebugStringA("PipelineLibrary is not supported\n");
+		return;
+	}
+
+	std::ifstream file(filePath_, std::ios::binary | std::ios::ate);
+
+	if (file.is_open()) {
+		libraryData_.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(libraryData_.data(), libraryData_.size());
+	}
+
+	HRESULT hr = E_FAIL;
+
+	if (!libraryData_.empty()) {
+
+		hr = device1->CreatePipelineLibrary(libraryData_.data(), libraryData_.size(), IID_PPV_ARGS(&pipelineLibrary_));
+
+		//ドライバの更新などで読み込めなかった場合は作り直す
+		if (FAILED(hr)) {
+			OutputDebugStringA(std::format("PipelineLibrary is invalid, hr:{:#x}\n", static_cast<uint32_t>(hr)).c_str());
+			libraryData_.clear();
+		}
+
+	}
+
+	if (pipelineLibrary_ == nullptr) {
+
+		hr = device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&pipelineLibrary_));
+
+		//作れなければライブラリなしで実行中の重複排除だけ行う
+		if (FAILED(hr)) {
+			OutputDebugStringA(std::format("Failed to create PipelineLibrary, hr:{:#x}\n", static_cast<uint32_t>(hr)).c_str());
+			pipelineLibrary_ = nullptr;
+		}
+
+	}
+
+	device1->Release();
+
+}
+
+void PipelineStateCache::RegisterRootSignature(ID3D12RootSignature* rootSignature, ID3DBlob* signatureBlob) {
+
+	rootSignatureHashes_[rootSignature] = HashBytes(signatureBlob->GetBufferPointer(), signatureBlob->GetBufferSize());
+
+}
+
+uint64_t PipelineStateCache::GetRootSignatureHash(ID3D12RootSignature* rootSignature) const {
+
+	auto it = rootSignatureHashes_.find(rootSignature);
+
+	//登録されていないルートシグネチャは使えない
+	assert(it != rootSignatureHashes_.end());
+
+	return it->second;
+
+}
+
+uint64_t PipelineStateCache::ComputeHash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) const {
+
+	return HashGraphicsPipelineStateDesc(desc, GetRootSignatureHash(desc.pRootSignature));
+
+}
+
+ID3D12PipelineState* PipelineStateCache::GetGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) {
+
+	uint64_t hash = ComputeHash(desc);
+
+	if (ID3D12PipelineState* pipelineState = FindGraphicsPipelineState(hash)) {
+		return pipelineState;
+	}
+
+	return CompileGraphicsPipelineState(hash, desc);
+
+}
+
+ID3D12PipelineState* PipelineStateCache::CompileGraphicsPipelineState(uint64_t hash, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) {
+
+	std::wstring name = MakePipelineStateName(hash);
+
+	ID3D12PipelineState* pipelineState = nullptr;
+
+	HRESULT hr = E_FAIL;
+
+	//作成自体は重いのでロックの外で行う
+	if (pipelineLibrary_ != nullptr) {
+		hr = pipelineLibrary_->LoadGraphicsPipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipelineState));
+	}
+
+	bool isLoaded = SUCCEEDED(hr);
+
+	if (!isLoaded) {
+
+		hr = device_->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+
+		//失敗したものはキャッシュに入れない(次に要求された時にまた作る)
+		if (FAILED(hr)) {
+			OutputDebugStringA(std::format("Failed to create PipelineState, hr:{:#x}\n", static_cast<uint32_t>(hr)).c_str());
+			return nullptr;
+		}
+
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	//別スレッドが先に同じPSOを登録していたらそちらを使う
+	auto it = pipelineStates_.find(hash);
+
+	if (it != pipelineStates_.end()) {
+		pipelineState->Release();
+		return it->second;
+	}
+
+	pipelineStates_[hash] = pipelineState;
+
+	if (!isLoaded && pipelineLibrary_ != nullptr) {
+
+		//既に同じ名前で保存されている場合は失敗するが問題ない
+		if (SUCCEEDED(pipelineLibrary_->StorePipeline(name.c_str(), pipelineState))) {
+			isDirty_ = true;
+		}
+
+	}
+
+	return pipelineState;
+
+}
+
+ID3D12PipelineState* PipelineStateCache::FindGraphicsPipelineState(uint64_t hash) const {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto it = pipelineStates_.find(hash);
+
+	return it != pipelineStates_.end() ? it->second : nullptr;
+
+}
+
+void PipelineStateCache::Save() {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if (pipelineLibrary_ == nullptr || !isDirty_) {
+		return;
+	}
+
+	std::vector<char> data(pipelineLibrary_->GetSerializedSize());
+
+	HRESULT hr = pipelineLibrary_->Serialize(data.data(), data.size());
+
+	//書きかけのものでファイルを壊さないようにする(isDirty_は残して次に書き直す)
+	if (FAILED(hr)) {
+		OutputDebugStringA(std::format("Failed to serialize PipelineLibrary, hr:{:#x}\n", static_cast<uint32_t>(hr)).c_str());
+		return;
+	}
+
+	std::ofstream file(filePath_, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open()) {
+		OutputDebugStringA("Failed to write PipelineLibrary\n");
+		return;
+	}
+
+	file.write(data.data(), data.size());
+
+	isDirty_ = false;
+
+}
+
+void PipelineStateCache::Finalize() {
+
+	Save();
+
+	for (auto& [hash, pipelineState] : pipelineStates_) {
+		pipelineState->Release();
+	}
+
+	pipelineStates_.clear();
+
+	if (pipelineLibrary_ != nullptr) {
+		pipelineLibrary_->Release();
+		pipelineLibrary_ = nullptr;
+	}
+
+	libraryData_.clear();
+
+	rootSignatureHashes_.clear();
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include "PipelineStateDesc.h"
+
+//PSOを状態の組み合わせで引けるようにするキャッシュ
+//ID3D12PipelineLibraryを使ってコンパイル済みのPSOをファイルに保存する
+class PipelineStateCache {
+
+public:
+
+	void Initialize(ID3D12Device* device, const std::wstring& filePath);
+
+	//ルートシグネチャのシリアライズ結果を登録する(ポインタは実行ごとに変わるため)
+	void RegisterRootSignature(ID3D12RootSignature* rootSignature, ID3DBlob* signatureBlob);
+
+	uint64_t GetRootSignatureHash(ID3D12RootSignature* rootSignature) const;
+
+	uint64_t ComputeHash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) const;
+
+	//同じ組み合わせのPSOがあればそれを返し、なければライブラリから読み込むか新しく作る(作れなければnullptr)
+	ID3D12PipelineState* GetGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+	//ライブラリから読み込むか新しく作ってキャッシュに登録する(別スレッドから呼んでもよい、作れなければnullptr)
+	ID3D12PipelineState* CompileGraphicsPipelineState(uint64_t hash, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+	//既に作成済みのPSOだけを探す
+	ID3D12PipelineState* FindGraphicsPipelineState(uint64_t hash) const;
+
+	ID3D12PipelineLibrary* GetPipelineLibrary() const { return pipelineLibrary_; }
+
+	//ライブラリに変更があればファイルに書き出す
+	void Save();
+
+	void Finalize();
+
+private:
+
+	ID3D12Device* device_ = nullptr;
+
+	ID3D12PipelineLibrary* pipelineLibrary_ = nullptr;
+
+	std::wstring filePath_;
+
+	//ライブラリが参照するので破棄まで保持しておく
+	std::vector<char> libraryData_;
+
+	bool isDirty_ = false;
+
+	mutable std::mutex mutex_;
+
+	std::unordered_map<ID3D12RootSignature*, uint64_t> rootSignatureHashes_;
+
+	std::unordered_map<uint64_t, ID3D12PipelineState*> pipelineStates_;
+
+};
@@ -0,0 +1,206 @@
+#include "PipelineStateDesc.h"
+#include <cassert>
+#include <cstring>
+#include <cwchar>
+#include <iterator>
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+	uint64_t hash = seed;
+
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+
+}
+
+namespace {
+
+	template<typename T>
+	uint64_t HashValue(uint64_t hash, const T& value) {
+
+		return HashBytes(&value, sizeof(T), hash);
+
+	}
+
+	uint64_t HashShader(uint64_t hash, const D3D12_SHADER_BYTECODE& shader) {
+
+		hash = HashValue(hash, shader.BytecodeLength);
+
+		if (shader.pShaderBytecode != nullptr) {
+			hash = HashBytes(shader.pShaderBytecode, shader.BytecodeLength, hash);
+		}
+
+		return hash;
+
+	}
+
+	uint64_t HashStencilOp(uint64_t hash, const D3D12_DEPTH_STENCILOP_DESC& op) {
+
+		hash = HashValue(hash, op.StencilFailOp);
+		hash = HashValue(hash, op.StencilDepthFailOp);
+		hash = HashValue(hash, op.StencilPassOp);
+		hash = HashValue(hash, op.StencilFunc);
+
+		return hash;
+
+	}
+
+	uint64_t HashRenderTargetBlend(uint64_t hash, const D3D12_RENDER_TARGET_BLEND_DESC& blend) {
+
+		hash = HashValue(hash, blend.BlendEnable);
+		hash = HashValue(hash, blend.LogicOpEnable);
+		hash = HashValue(hash, blend.SrcBlend);
+		hash = HashValue(hash, blend.DestBlend);
+		hash = HashValue(hash, blend.BlendOp);
+		hash = HashValue(hash, blend.SrcBlendAlpha);
+		hash = HashValue(hash, blend.DestBlendAlpha);
+		hash = HashValue(hash, blend.BlendOpAlpha);
+		hash = HashValue(hash, blend.LogicOp);
+		hash = HashValue(hash, blend.RenderTargetWriteMask);
+
+		return hash;
+
+	}
+
+}
+
+uint64_t HashGraphicsPipelineStateDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash) {
+
+	uint64_t hash = HashValue(14695981039346656037ull, rootSignatureHash);
+
+	//シェーダーは中身で比較する
+	hash = HashShader(hash, desc.VS);
+	hash = HashShader(hash, desc.PS);
+	hash = HashShader(hash, desc.DS);
+	hash = HashShader(hash, desc.HS);
+	hash = HashShader(hash, desc.GS);
+
+	hash = HashValue(hash, desc.StreamOutput.NumEntries);
+	for (UINT i = 0; i < desc.StreamOutput.NumEntries; ++i) {
+		const D3D12_SO_DECLARATION_ENTRY& entry = desc.StreamOutput.pSODeclaration[i];
+		hash = HashValue(hash, entry.Stream);
+		if (entry.SemanticName != nullptr) {
+			hash = HashBytes(entry.SemanticName, std::strlen(entry.SemanticName), hash);
+		}
+		hash = HashValue(hash, entry.SemanticIndex);
+		hash = HashValue(hash, entry.StartComponent);
+		hash = HashValue(hash, entry.ComponentCount);
+		hash = HashValue(hash, entry.OutputSlot);
+	}
+	hash = HashValue(hash, desc.StreamOutput.NumStrides);
+	for (UINT i = 0; i < desc.StreamOutput.NumStrides; ++i) {
+		hash = HashValue(hash, desc.StreamOutput.pBufferStrides[i]);
+	}
+	hash = HashValue(hash, desc.StreamOutput.RasterizedStream);
+
+	//BlendはRenderTargetWriteMask(UINT8)の後にパディングがあるのでメンバごとに計算する
+	hash = HashValue(hash, desc.BlendState.AlphaToCoverageEnable);
+	hash = HashValue(hash, desc.BlendState.IndependentBlendEnable);
+	for (const D3D12_RENDER_TARGET_BLEND_DESC& renderTarget : desc.BlendState.RenderTarget) {
+		hash = HashRenderTargetBlend(hash, renderTarget);
+	}
+	hash = HashValue(hash, desc.SampleMask);
+
+	//Rasterizerもメンバごとに計算して並びに依存しないようにする
+	hash = HashValue(hash, desc.RasterizerState.FillMode);
+	hash = HashValue(hash, desc.RasterizerState.CullMode);
+	hash = HashValue(hash, desc.RasterizerState.FrontCounterClockwise);
+	hash = HashValue(hash, desc.RasterizerState.DepthBias);
+	hash = HashValue(hash, desc.RasterizerState.DepthBiasClamp);
+	hash = HashValue(hash, desc.RasterizerState.SlopeScaledDepthBias);
+	hash = HashValue(hash, desc.RasterizerState.DepthClipEnable);
+	hash = HashValue(hash, desc.RasterizerState.MultisampleEnable);
+	hash = HashValue(hash, desc.RasterizerState.AntialiasedLineEnable);
+	hash = HashValue(hash, desc.RasterizerState.ForcedSampleCount);
+	hash = HashValue(hash, desc.RasterizerState.ConservativeRaster);
+
+	//DepthStencilはUINT8の後にパディングがあるのでメンバごとに計算する
+	hash = HashValue(hash, desc.DepthStencilState.DepthEnable);
+	hash = HashValue(hash, desc.DepthStencilState.DepthWriteMask);
+	hash = HashValue(hash, desc.DepthStencilState.DepthFunc);
+	hash = HashValue(hash, desc.DepthStencilState.StencilEnable);
+	hash = HashValue(hash, desc.DepthStencilState.StencilReadMask);
+	hash = HashValue(hash, desc.DepthStencilState.StencilWriteMask);
+	hash = HashStencilOp(hash, desc.DepthStencilState.FrontFace);
+	hash = HashStencilOp(hash, desc.DepthStencilState.BackFace);
+
+	hash = HashValue(hash, desc.InputLayout.NumElements);
+	for (UINT i = 0; i < desc.InputLayout.NumElements; ++i) {
+		const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+		hash = HashBytes(element.SemanticName, std::strlen(element.SemanticName), hash);
+		hash = HashValue(hash, element.SemanticIndex);
+		hash = HashValue(hash, element.Format);
+		hash = HashValue(hash, element.InputSlot);
+		hash = HashValue(hash, element.AlignedByteOffset);
+		hash = HashValue(hash, element.InputSlotClass);
+		hash = HashValue(hash, element.InstanceDataStepRate);
+	}
+
+	hash = HashValue(hash, desc.IBStripCutValue);
+	hash = HashValue(hash, desc.PrimitiveTopologyType);
+	hash = HashValue(hash, desc.NumRenderTargets);
+	for (UINT i = 0; i < desc.NumRenderTargets; ++i) {
+		hash = HashValue(hash, desc.RTVFormats[i]);
+	}
+	hash = HashValue(hash, desc.DSVFormat);
+	hash = HashValue(hash, desc.SampleDesc.Count);
+	hash = HashValue(hash, desc.SampleDesc.Quality);
+	hash = HashValue(hash, desc.NodeMask);
+	hash = HashValue(hash, desc.Flags);
+
+	return hash;
+
+}
+
+std::wstring MakePipelineStateName(uint64_t hash) {
+
+	wchar_t name[32];
+
+	std::swprintf(name, std::size(name), L"PSO_%016llx", static_cast<unsigned long long>(hash));
+
+	return name;
+
+}
+
+GraphicsPipelineStateDescCopy::GraphicsPipelineStateDescCopy(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) : desc_(desc) {
+
+	//StreamOutputは使っていないのでコピーしない
+	assert(desc.StreamOutput.NumEntries == 0);
+
+	D3D12_SHADER_BYTECODE* shaders[5] = { &desc_.VS, &desc_.PS, &desc_.DS, &desc_.HS, &desc_.GS };
+
+	for (size_t i = 0; i < std::size(shaders); ++i) {
+
+		if (shaders[i]->pShaderBytecode == nullptr) {
+			continue;
+		}
+
+		const uint8_t* bytecode = static_cast<const uint8_t*>(shaders[i]->pShaderBytecode);
+
+		shaders_[i].assign(bytecode, bytecode + shaders[i]->BytecodeLength);
+
+		shaders[i]->pShaderBytecode = shaders_[i].data();
+
+	}
+
+	inputElements_.assign(desc.InputLayout.pInputElementDescs, desc.InputLayout.pInputElementDescs + desc.InputLayout.NumElements);
+
+	//文字列の中身を指すので、先に確保して並べ直しが起きないようにする
+	semanticNames_.reserve(inputElements_.size());
+
+	for (D3D12_INPUT_ELEMENT_DESC& element : inputElements_) {
+		semanticNames_.emplace_back(element.SemanticName);
+		element.SemanticName = semanticNames_.back().c_str();
+	}
+
+	desc_.InputLayout.pInputElementDescs = inputElements_.data();
+
+	desc_.CachedPSO = {};
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//PSOのDescを扱う処理のうちデバイスを使わないもの(ハッシュ、ライブラリに保存する名前、Descの複製)
+//d3d12.hの型しか使わないのでWindows以外でもビルドしてテストできる
+
+//FNV-1aによるハッシュ計算
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+//PSOのDescからハッシュを計算する(ルートシグネチャは登録済みのハッシュを使う)
+//構造体のパディングは含めず、シェーダーと入力レイアウトは指している中身で計算する
+uint64_t HashGraphicsPipelineStateDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash);
+
+//ID3D12PipelineLibraryに保存する時の名前
+std::wstring MakePipelineStateName(uint64_t hash);
+
+//Descが指すシェーダーや入力レイアウトを自分で持つコピー(依頼側の寿命から切り離す)
+//中を指すポインタを持つのでコピーも移動もしない
+class GraphicsPipelineStateDescCopy {
+
+public:
+
+	explicit GraphicsPipelineStateDescCopy(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+	GraphicsPipelineStateDescCopy(const GraphicsPipelineStateDescCopy&) = delete;
+
+	GraphicsPipelineStateDescCopy& operator=(const GraphicsPipelineStateDescCopy&) = delete;
+
+	const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Get() const { return desc_; }
+
+private:
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC desc_;
+
+	std::vector<uint8_t> shaders_[5];
+
+	std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements_;
+
+	std::vector<std::string> semanticNames_;
+
+};
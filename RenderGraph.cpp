@@ -0,0 +1,476 @@
+#include "RenderGraph.h"
+#include <cassert>
+#include <algorithm>
+
+namespace {
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+
+		return alignment == 0 ? value : (value + alignment - 1) / alignment * alignment;
+
+	}
+
+}
+
+uint32_t RenderGraph::ImportResource(const std::string& name, uint32_t initialState, uint32_t finalState) {
+
+	Resource resource;
+
+	resource.name = name;
+
+	resource.isImported = true;
+
+	resource.initialState = initialState;
+
+	resource.finalState = finalState;
+
+	resources_.push_back(resource);
+
+	return static_cast<uint32_t>(resources_.size() - 1);
+
+}
+
+uint32_t RenderGraph::CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc) {
+
+	Resource resource;
+
+	resource.name = name;
+
+	resource.desc = desc;
+
+	resources_.push_back(resource);
+
+	return static_cast<uint32_t>(resources_.size() - 1);
+
+}
+
+uint32_t RenderGraph::AddPass(const std::string& name, std::function<void()> execute) {
+
+	Pass pass;
+
+	pass.name = name;
+
+	pass.execute = std::move(execute);
+
+	passes_.push_back(std::move(pass));
+
+	return static_cast<uint32_t>(passes_.size() - 1);
+
+}
+
+void RenderGraph::Read(uint32_t pass, uint32_t resource, uint32_t state) {
+
+	assert((state & kResourceStateWriteMask) == 0);
+
+	passes_[pass].accesses.push_back({ resource, state, false });
+
+}
+
+void RenderGraph::Write(uint32_t pass, uint32_t resource, uint32_t state) {
+
+	passes_[pass].accesses.push_back({ resource, state, true });
+
+	resources_[resource].writers.push_back(pass);
+
+}
+
+void RenderGraph::SetSideEffect(uint32_t pass) {
+
+	passes_[pass].hasSideEffect = true;
+
+}
+
+void RenderGraph::Compile() {
+
+	CullPasses();
+
+	livePasses_.clear();
+
+	for (uint32_t i = 0; i < passes_.size(); ++i) {
+		if (!passes_[i].isCulled) {
+			livePasses_.push_back(i);
+		}
+	}
+
+	//生きているパスの中での最初と最後の使用を求める
+	for (Resource& resource : resources_) {
+		resource.firstUse = kInvalidResource;
+		resource.lastUse = kInvalidResource;
+	}
+
+	for (uint32_t i = 0; i < livePasses_.size(); ++i) {
+		for (const Access& access : passes_[livePasses_[i]].accesses) {
+			Resource& resource = resources_[access.resource];
+			if (resource.firstUse == kInvalidResource) {
+				resource.firstUse = i;
+			}
+			resource.lastUse = i;
+		}
+	}
+
+	AllocateTransientResources();
+
+	BuildBarriers();
+
+}
+
+void RenderGraph::CullPasses() {
+
+	//書き込みの数をパスの参照数、読み込みの数をリソースの参照数にする
+	for (Pass& pass : passes_) {
+		pass.refCount = 0;
+		pass.isCulled = false;
+		for (const Access& access : pass.accesses) {
+			if (access.isWrite) {
+				pass.refCount++;
+			}
+		}
+	}
+
+	for (Resource& resource : resources_) {
+		resource.refCount = 0;
+	}
+
+	for (const Pass& pass : passes_) {
+		for (const Access& access : pass.accesses) {
+			if (!access.isWrite) {
+				resources_[access.resource].refCount++;
+			}
+		}
+	}
+
+	//外部のリソースはグラフの後でも使われるので、書き込むパスは残す
+	for (Resource& resource : resources_) {
+		if (resource.isImported) {
+			resource.refCount++;
+		}
+	}
+
+	std::vector<uint32_t> unreferenced;
+
+	for (uint32_t i = 0; i < resources_.size(); ++i) {
+		if (resources_[i].refCount == 0) {
+			unreferenced.push_back(i);
+		}
+	}
+
+	while (!unreferenced.empty()) {
+
+		uint32_t resourceIndex = unreferenced.back();
+
+		unreferenced.pop_back();
+
+		for (uint32_t passIndex : resources_[resourceIndex].writers) {
+
+			Pass& pass = passes_[passIndex];
+
+			if (pass.isCulled || pass.refCount == 0) {
+				continue;
+			}
+
+			pass.refCount--;
+
+			if (pass.refCount != 0 || pass.hasSideEffect) {
+				continue;
+			}
+
+			//誰にも使われない出力しか持たないパスは削除し、そのパスが読んでいたリソースの参照を減らす
+			pass.isCulled = true;
+
+			for (const Access& access : pass.accesses) {
+				if (!access.isWrite && --resources_[access.resource].refCount == 0) {
+					unreferenced.push_back(access.resource);
+				}
+			}
+
+		}
+
+	}
+
+}
+
+void RenderGraph::AllocateTransientResources() {
+
+	std::vector<uint32_t> transients;
+
+	for (uint32_t i = 0; i < resources_.size(); ++i) {
+		Resource& resource = resources_[i];
+		resource.isAliased = false;
+		resource.aliasBefore = kInvalidResource;
+		if (!resource.isImported && resource.firstUse != kInvalidResource) {
+			transients.push_back(i);
+		}
+	}
+
+	//使い始めの早い順、同じなら大きい順に配置する
+	std::stable_sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b) {
+		if (resources_[a].firstUse != resources_[b].firstUse) {
+			return resources_[a].firstUse < resources_[b].firstUse;
+		}
+		return resources_[a].desc.size > resources_[b].desc.size;
+	});
+
+	std::vector<uint32_t> placed;
+
+	transientHeapSize_ = 0;
+
+	for (uint32_t index : transients) {
+
+		Resource& resource = resources_[index];
+
+		//寿命が重なっているリソースをオフセット順に並べ、その隙間に入れる
+		std::vector<uint32_t> overlapping;
+
+		for (uint32_t other : placed) {
+			if (resources_[other].firstUse <= resource.lastUse && resource.firstUse <= resources_[other].lastUse) {
+				overlapping.push_back(other);
+			}
+		}
+
+		std::sort(overlapping.begin(), overlapping.end(), [this](uint32_t a, uint32_t b) {
+			return resources_[a].heapOffset < resources_[b].heapOffset;
+		});
+
+		uint64_t offset = 0;
+
+		for (uint32_t other : overlapping) {
+
+			uint64_t aligned = AlignUp(offset, resource.desc.alignment);
+
+			if (aligned + resource.desc.size <= resources_[other].heapOffset) {
+				break;
+			}
+
+			offset = (std::max)(offset, resources_[other].heapOffset + resources_[other].desc.size);
+
+		}
+
+		resource.heapOffset = AlignUp(offset, resource.desc.alignment);
+
+		transientHeapSize_ = (std::max)(transientHeapSize_, resource.heapOffset + resource.desc.size);
+
+		//メモリが重なる既存のリソースがあればエイリアシングバリアが必要になる
+		uint32_t lastUse = 0;
+
+		for (uint32_t other : placed) {
+
+			const Resource& otherResource = resources_[other];
+
+			bool isMemoryOverlapped = otherResource.heapOffset < resource.heapOffset + resource.desc.size &&
+				resource.heapOffset < otherResource.heapOffset + otherResource.desc.size;
+
+			if (!isMemoryOverlapped) {
+				continue;
+			}
+
+			resource.isAliased = true;
+
+			resources_[other].isAliased = true;
+
+			if (otherResource.lastUse < resource.firstUse && (resource.aliasBefore == kInvalidResource || otherResource.lastUse >= lastUse)) {
+				resource.aliasBefore = other;
+				lastUse = otherResource.lastUse;
+			}
+
+		}
+
+		placed.push_back(index);
+
+	}
+
+}
+
+void RenderGraph::BuildBarriers() {
+
+	for (Pass& pass : passes_) {
+		pass.barriersBefore.clear();
+		pass.barriersAfter.clear();
+	}
+
+	finalBarriers_.clear();
+
+	barrierCount_ = 0;
+
+	for (uint32_t resourceIndex = 0; resourceIndex < resources_.size(); ++resourceIndex) {
+
+		Resource& resource = resources_[resourceIndex];
+
+		if (resource.firstUse == kInvalidResource) {
+			continue;
+		}
+
+		//パスごとの使い方を集める(同じパスで複数回使う場合は状態を合わせる)
+		std::vector<Use> uses;
+
+		for (uint32_t i = resource.firstUse; i <= resource.lastUse; ++i) {
+
+			for (const Access& access : passes_[livePasses_[i]].accesses) {
+
+				if (access.resource != resourceIndex) {
+					continue;
+				}
+
+				if (!uses.empty() && uses.back().livePass == i) {
+					uses.back().state |= access.state;
+					uses.back().isWrite |= access.isWrite;
+				} else {
+					uses.push_back({ i, access.state, access.isWrite });
+				}
+
+			}
+
+		}
+
+		//続けて読み込むだけのパスは1つの状態にまとめて遷移を減らす
+		for (size_t i = 0; i < uses.size();) {
+
+			if (uses[i].isWrite) {
+				++i;
+				continue;
+			}
+
+			size_t end = i;
+
+			uint32_t state = 0;
+
+			while (end < uses.size() && !uses[end].isWrite) {
+				state |= uses[end].state;
+				++end;
+			}
+
+			for (size_t j = i; j < end; ++j) {
+				uses[j].state = state;
+			}
+
+			i = end;
+
+		}
+
+		//一時リソースは前のフレームの最後の状態から始まる
+		if (!resource.isImported) {
+			resource.initialState = uses.back().state;
+		}
+
+		uint32_t currentState = resource.initialState;
+
+		for (size_t i = 0; i < uses.size(); ++i) {
+
+			Pass& pass = passes_[livePasses_[uses[i].livePass]];
+
+			if (i == 0 && resource.isAliased) {
+				pass.barriersBefore.push_back({ RenderGraphBarrierType::kAliasing, RenderGraphBarrierFlag::kNone, resourceIndex, resource.aliasBefore, 0, 0 });
+				barrierCount_++;
+			}
+
+			if (currentState == uses[i].state) {
+				continue;
+			}
+
+			RenderGraphBarrier barrier{ RenderGraphBarrierType::kTransition, RenderGraphBarrierFlag::kNone, resourceIndex, kInvalidResource, currentState, uses[i].state };
+
+			//前の使用との間にパスがあれば分割バリアにして、間のパスの実行中に遷移させる
+			if (i != 0 && uses[i].livePass - uses[i - 1].livePass > 1) {
+
+				barrier.flag = RenderGraphBarrierFlag::kBeginOnly;
+
+				passes_[livePasses_[uses[i - 1].livePass]].barriersAfter.push_back(barrier);
+
+				barrier.flag = RenderGraphBarrierFlag::kEndOnly;
+
+			}
+
+			pass.barriersBefore.push_back(barrier);
+
+			barrierCount_++;
+
+			currentState = uses[i].state;
+
+		}
+
+		if (resource.isImported && currentState != resource.finalState) {
+			finalBarriers_.push_back({ RenderGraphBarrierType::kTransition, RenderGraphBarrierFlag::kNone, resourceIndex, kInvalidResource, currentState, resource.finalState });
+			barrierCount_++;
+		}
+
+	}
+
+	//実行時に送るまとまりの数を数えておく
+	barrierBatchCount_ = 0;
+
+	const std::vector<RenderGraphBarrier>* previousAfter = nullptr;
+
+	for (uint32_t passIndex : livePasses_) {
+		if ((previousAfter != nullptr && !previousAfter->empty()) || !passes_[passIndex].barriersBefore.empty()) {
+			barrierBatchCount_++;
+		}
+		previousAfter = &passes_[passIndex].barriersAfter;
+	}
+
+	if ((previousAfter != nullptr && !previousAfter->empty()) || !finalBarriers_.empty()) {
+		barrierBatchCount_++;
+	}
+
+}
+
+void RenderGraph::Execute(const std::function<void(const RenderGraphBarrier*, size_t)>& submitBarriers) const {
+
+	std::vector<RenderGraphBarrier> batch;
+
+	const std::vector<RenderGraphBarrier>* previousAfter = nullptr;
+
+	for (uint32_t passIndex : livePasses_) {
+
+		const Pass& pass = passes_[passIndex];
+
+		//前のパスの後のバリアとこのパスの前のバリアを1回で送る
+		batch.clear();
+
+		if (previousAfter != nullptr) {
+			batch.insert(batch.end(), previousAfter->begin(), previousAfter->end());
+		}
+
+		batch.insert(batch.end(), pass.barriersBefore.begin(), pass.barriersBefore.end());
+
+		if (!batch.empty()) {
+			submitBarriers(batch.data(), batch.size());
+		}
+
+		if (pass.execute) {
+			pass.execute();
+		}
+
+		previousAfter = &pass.barriersAfter;
+
+	}
+
+	batch.clear();
+
+	if (previousAfter != nullptr) {
+		batch.insert(batch.end(), previousAfter->begin(), previousAfter->end());
+	}
+
+	batch.insert(batch.end(), finalBarriers_.begin(), finalBarriers_.end());
+
+	if (!batch.empty()) {
+		submitBarriers(batch.data(), batch.size());
+	}
+
+}
+
+void RenderGraph::Clear() {
+
+	passes_.clear();
+
+	resources_.clear();
+
+	livePasses_.clear();
+
+	finalBarriers_.clear();
+
+	transientHeapSize_ = 0;
+
+	barrierCount_ = 0;
+
+	barrierBatchCount_ = 0;
+
+}
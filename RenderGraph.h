@@ -0,0 +1,177 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+
+//リソースの状態(値はD3D12_RESOURCE_STATESと同じにしてそのまま渡せるようにしている)
+enum ResourceState : uint32_t {
+
+	kResourceStateCommon = 0,
+	kResourceStatePresent = 0,
+	kResourceStateVertexAndConstantBuffer = 0x1,
+	kResourceStateIndexBuffer = 0x2,
+	kResourceStateRenderTarget = 0x4,
+	kResourceStateUnorderedAccess = 0x8,
+	kResourceStateDepthWrite = 0x10,
+	kResourceStateDepthRead = 0x20,
+	kResourceStateNonPixelShaderResource = 0x40,
+	kResourceStatePixelShaderResource = 0x80,
+	kResourceStateCopyDest = 0x400,
+	kResourceStateCopySource = 0x800,
+
+};
+
+//書き込みを伴う状態(他の状態とまとめられない)
+const uint32_t kResourceStateWriteMask = kResourceStateRenderTarget | kResourceStateUnorderedAccess | kResourceStateDepthWrite | kResourceStateCopyDest;
+
+enum class RenderGraphBarrierType {
+	kTransition,
+	kAliasing,
+};
+
+//分割バリア(D3D12_RESOURCE_BARRIER_FLAGSと同じ意味)
+enum class RenderGraphBarrierFlag {
+	kNone,
+	kBeginOnly,
+	kEndOnly,
+};
+
+struct RenderGraphBarrier {
+
+	RenderGraphBarrierType type;
+	RenderGraphBarrierFlag flag;
+	uint32_t resource;
+	//エイリアシングで直前にメモリを使っていたリソース(不明ならkInvalidResource)
+	uint32_t aliasBefore;
+	uint32_t stateBefore;
+	uint32_t stateAfter;
+
+};
+
+//一時テクスチャの情報(サイズとアラインメントはGetResourceAllocationInfoの結果を入れる)
+struct RenderGraphTextureDesc {
+
+	uint32_t width;
+	uint32_t height;
+	uint32_t format;
+	uint64_t size;
+	uint64_t alignment;
+
+};
+
+//パスが読み書きするリソースを宣言しておくと、不要なパスの削除、バリアのまとめ、一時リソースのメモリ共有を自動で行う
+//コンパイルはCPUだけで完結するのでD3D12には依存しない
+class RenderGraph {
+
+public:
+
+	static const uint32_t kInvalidResource = 0xffffffff;
+
+	//外部で作ったリソース(バックバッファなど)を登録する。finalStateはグラフの最後に戻す状態
+	uint32_t ImportResource(const std::string& name, uint32_t initialState, uint32_t finalState);
+
+	//グラフの中だけで使う一時テクスチャを登録する
+	uint32_t CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc);
+
+	uint32_t AddPass(const std::string& name, std::function<void()> execute);
+
+	void Read(uint32_t pass, uint32_t resource, uint32_t state);
+
+	void Write(uint32_t pass, uint32_t resource, uint32_t state);
+
+	//出力がなくても削除しないパスにする
+	void SetSideEffect(uint32_t pass);
+
+	void Compile();
+
+	//submitBarriersにはまとめたバリアが1回ずつ渡される
+	void Execute(const std::function<void(const RenderGraphBarrier*, size_t)>& submitBarriers) const;
+
+	void Clear();
+
+	bool IsPassCulled(uint32_t pass) const { return passes_[pass].isCulled; }
+
+	uint32_t GetResourceCount() const { return static_cast<uint32_t>(resources_.size()); }
+
+	bool IsTransient(uint32_t resource) const { return !resources_[resource].isImported; }
+
+	//一時リソースの作成時の状態(前のフレームの最後の状態と同じにしておく)
+	uint32_t GetInitialState(uint32_t resource) const { return resources_[resource].initialState; }
+
+	const RenderGraphTextureDesc& GetTextureDesc(uint32_t resource) const { return resources_[resource].desc; }
+
+	uint64_t GetHeapOffset(uint32_t resource) const { return resources_[resource].heapOffset; }
+
+	//一時リソースをすべて置くのに必要なヒープの大きさ
+	uint64_t GetTransientHeapSize() const { return transientHeapSize_; }
+
+	uint32_t GetBarrierCount() const { return barrierCount_; }
+
+	uint32_t GetBarrierBatchCount() const { return barrierBatchCount_; }
+
+private:
+
+	struct Access {
+		uint32_t resource;
+		uint32_t state;
+		bool isWrite;
+	};
+
+	struct Pass {
+		std::string name;
+		std::function<void()> execute;
+		std::vector<Access> accesses;
+		bool hasSideEffect = false;
+		bool isCulled = false;
+		uint32_t refCount = 0;
+		std::vector<RenderGraphBarrier> barriersBefore;
+		std::vector<RenderGraphBarrier> barriersAfter;
+	};
+
+	struct Resource {
+		std::string name;
+		bool isImported = false;
+		uint32_t initialState = kResourceStateCommon;
+		uint32_t finalState = kResourceStateCommon;
+		RenderGraphTextureDesc desc{};
+		std::vector<uint32_t> writers;
+		uint32_t refCount = 0;
+		//生きているパスの並びでの最初と最後の使用
+		uint32_t firstUse = kInvalidResource;
+		uint32_t lastUse = kInvalidResource;
+		uint64_t heapOffset = 0;
+		//他のリソースとメモリを共有しているか
+		bool isAliased = false;
+		uint32_t aliasBefore = kInvalidResource;
+	};
+
+	//パスごとのそのリソースの使い方
+	struct Use {
+		uint32_t livePass;
+		uint32_t state;
+		bool isWrite;
+	};
+
+	void CullPasses();
+
+	void AllocateTransientResources();
+
+	void BuildBarriers();
+
+	std::vector<Pass> passes_;
+
+	std::vector<Resource> resources_;
+
+	//削除されなかったパスを実行順に並べたもの
+	std::vector<uint32_t> livePasses_;
+
+	std::vector<RenderGraphBarrier> finalBarriers_;
+
+	uint64_t transientHeapSize_ = 0;
+
+	uint32_t barrierCount_ = 0;
+
+	uint32_t barrierBatchCount_ = 0;
+
+};
@@ -0,0 +1,328 @@
+#include "ResourceStateTracker.h"
+#include <cassert>
+#include <algorithm>
+
+void ResourceStateTable::Register(ID3D12Resource* resource, D3D12_RESOURCE_STATES state) {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	states_[resource] = state;
+
+}
+
+void ResourceStateTable::Unregister(ID3D12Resource* resource) {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	states_.erase(resource);
+
+}
+
+D3D12_RESOURCE_STATES ResourceStateTable::Get(ID3D12Resource* resource) const {
+
+	auto it = states_.find(resource);
+
+	//登録されていないリソースの状態はわからない
+	assert(it != states_.end());
+
+	return it->second;
+
+}
+
+void ResourceStateTable::Set(ID3D12Resource* resource, D3D12_RESOURCE_STATES state) {
+
+	states_[resource] = state;
+
+}
+
+void ResourceStateTracker::Initialize(ID3D12GraphicsCommandList* commandList) {
+
+	commandList_ = commandList;
+
+	Reset();
+
+}
+
+void ResourceStateTracker::TransitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES state, D3D12_RESOURCE_BARRIER_FLAGS flags) {
+
+	requestedCount_++;
+
+	auto it = states_.find(resource);
+
+	//このリストで初めて使うリソースは実行直前に遷移させる
+	//遷移前の状態がわからないので、分割バリアの開始は積まずに終了の時に最初の使用として扱う
+	if (it == states_.end()) {
+
+		if (flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY) {
+			droppedCount_++;
+			return;
+		}
+
+		states_[resource] = state;
+
+		pendingInitialStates_.push_back({ resource, state });
+
+		return;
+
+	}
+
+	D3D12_RESOURCE_STATES before = it->second;
+
+	//分割バリアの開始は状態を変えずにそのまま積む
+	if (flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY) {
+
+		if (before == state) {
+			droppedCount_++;
+			return;
+		}
+
+		splitBarrierResources_.insert(resource);
+
+		D3D12_RESOURCE_BARRIER barrier{};
+
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+
+		barrier.Flags = flags;
+
+		barrier.Transition.pResource = resource;
+
+		barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+		barrier.Transition.StateBefore = before;
+
+		barrier.Transition.StateAfter = state;
+
+		pendingBarriers_.push_back(barrier);
+
+		return;
+
+	}
+
+	//開始を積んでいない終了は普通の遷移にする
+	if (flags == D3D12_RESOURCE_BARRIER_FLAG_END_ONLY && splitBarrierResources_.erase(resource) == 0) {
+		flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	}
+
+	if (before == state) {
+		droppedCount_++;
+		return;
+	}
+
+	it->second = state;
+
+	//まだ積んでいない遷移があればそれの遷移後を書き換えてまとめる
+	auto pending = pendingTransitionIndices_.find(resource);
+
+	if (flags == D3D12_RESOURCE_BARRIER_FLAG_NONE && pending != pendingTransitionIndices_.end()) {
+
+		D3D12_RESOURCE_BARRIER& barrier = pendingBarriers_[pending->second];
+
+		barrier.Transition.StateAfter = state;
+
+		//元の状態に戻るだけなら遷移自体が不要
+		if (barrier.Transition.StateBefore == state) {
+			barrier.Transition.pResource = nullptr;
+			pendingTransitionIndices_.erase(pending);
+		}
+
+		droppedCount_++;
+
+		return;
+
+	}
+
+	D3D12_RESOURCE_BARRIER barrier{};
+
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+
+	barrier.Flags = flags;
+
+	barrier.Transition.pResource = resource;
+
+	barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+	barrier.Transition.StateBefore = before;
+
+	barrier.Transition.StateAfter = state;
+
+	if (flags == D3D12_RESOURCE_BARRIER_FLAG_NONE) {
+		pendingTransitionIndices_[resource] = pendingBarriers_.size();
+	}
+
+	pendingBarriers_.push_back(barrier);
+
+}
+
+void ResourceStateTracker::TransitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateBefore, D3D12_RESOURCE_STATES stateAfter, D3D12_RESOURCE_BARRIER_FLAGS flags) {
+
+	//このリストで初めて使うなら、実行直前にstateBeforeにしておいてそこから追いかける
+	if (states_.find(resource) == states_.end()) {
+
+		states_[resource] = stateBefore;
+
+		pendingInitialStates_.push_back({ resource, stateBefore });
+
+	}
+
+	TransitionResource(resource, stateAfter, flags);
+
+}
+
+void ResourceStateTracker::AliasingBarrier(ID3D12Resource* before, ID3D12Resource* after) {
+
+	D3D12_RESOURCE_BARRIER barrier{};
+
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+
+	barrier.Aliasing.pResourceBefore = before;
+
+	barrier.Aliasing.pResourceAfter = after;
+
+	pendingBarriers_.push_back(barrier);
+
+	//エイリアシングをまたいで遷移をまとめないようにする
+	pendingTransitionIndices_.clear();
+
+}
+
+void ResourceStateTracker::UAVBarrier(ID3D12Resource* resource) {
+
+	D3D12_RESOURCE_BARRIER barrier{};
+
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+
+	barrier.UAV.pResource = resource;
+
+	pendingBarriers_.push_back(barrier);
+
+	pendingTransitionIndices_.clear();
+
+}
+
+void ResourceStateTracker::FlushBarriers() {
+
+	//まとめた結果不要になった遷移を取り除く
+	pendingBarriers_.erase(std::remove_if(pendingBarriers_.begin(), pendingBarriers_.end(), [](const D3D12_RESOURCE_BARRIER& barrier) {
+		return barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && barrier.Transition.pResource == nullptr;
+	}), pendingBarriers_.end());
+
+	if (!pendingBarriers_.empty()) {
+
+		commandList_->ResourceBarrier(static_cast<UINT>(pendingBarriers_.size()), pendingBarriers_.data());
+
+		flushCount_++;
+
+	}
+
+	pendingBarriers_.clear();
+
+	pendingTransitionIndices_.clear();
+
+}
+
+void ResourceStateTracker::DrawInstanced(UINT vertexCountPerInstance, UINT instanceCount, UINT startVertexLocation, UINT startInstanceLocation) {
+
+	FlushBarriers();
+
+	commandList_->DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
+
+}
+
+void ResourceStateTracker::DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation, INT baseVertexLocation, UINT startInstanceLocation) {
+
+	FlushBarriers();
+
+	commandList_->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+
+}
+
+void ResourceStateTracker::CopyResource(ID3D12Resource* destination, ID3D12Resource* source) {
+
+	FlushBarriers();
+
+	commandList_->CopyResource(destination, source);
+
+}
+
+void ResourceStateTracker::CopyBufferRegion(ID3D12Resource* destination, UINT64 destinationOffset, ID3D12Resource* source, UINT64 sourceOffset, UINT64 numBytes) {
+
+	FlushBarriers();
+
+	commandList_->CopyBufferRegion(destination, destinationOffset, source, sourceOffset, numBytes);
+
+}
+
+void ResourceStateTracker::CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION& destination, UINT x, UINT y, UINT z, const D3D12_TEXTURE_COPY_LOCATION& source, const D3D12_BOX* sourceBox) {
+
+	FlushBarriers();
+
+	commandList_->CopyTextureRegion(&destination, x, y, z, &source, sourceBox);
+
+}
+
+uint32_t ResourceStateTracker::ResolvePendingBarriers(ResourceStateTable& table, ID3D12GraphicsCommandList* barrierCommandList) {
+
+	//積み忘れがないようにする
+	assert(pendingBarriers_.empty());
+
+	std::lock_guard<std::mutex> lock(table.GetMutex());
+
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+
+	for (const PendingInitialState& pending : pendingInitialStates_) {
+
+		D3D12_RESOURCE_STATES before = table.Get(pending.resource);
+
+		if (before == pending.state) {
+			droppedCount_++;
+			continue;
+		}
+
+		D3D12_RESOURCE_BARRIER barrier{};
+
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+
+		barrier.Transition.pResource = pending.resource;
+
+		barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+		barrier.Transition.StateBefore = before;
+
+		barrier.Transition.StateAfter = pending.state;
+
+		barriers.push_back(barrier);
+
+	}
+
+	if (!barriers.empty()) {
+		barrierCommandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+	}
+
+	//このリストの実行後の状態を表に反映する
+	for (const auto& [resource, state] : states_) {
+		table.Set(resource, state);
+	}
+
+	return static_cast<uint32_t>(barriers.size());
+
+}
+
+void ResourceStateTracker::Reset() {
+
+	states_.clear();
+
+	pendingInitialStates_.clear();
+
+	pendingBarriers_.clear();
+
+	pendingTransitionIndices_.clear();
+
+	splitBarrierResources_.clear();
+
+	requestedCount_ = 0;
+
+	droppedCount_ = 0;
+
+	flushCount_ = 0;
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+//コマンドリストをまたいだリソースの状態(実行したコマンドリストの最後の状態)を持つ表
+class ResourceStateTable {
+
+public:
+
+	void Register(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+
+	void Unregister(ID3D12Resource* resource);
+
+	//ロックはResolvePendingBarriersの中で取る
+	D3D12_RESOURCE_STATES Get(ID3D12Resource* resource) const;
+
+	void Set(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+
+	std::mutex& GetMutex() { return mutex_; }
+
+private:
+
+	std::unordered_map<ID3D12Resource*, D3D12_RESOURCE_STATES> states_;
+
+	std::mutex mutex_;
+
+};
+
+//コマンドリストごとにリソースの状態を追いかけ、バリアをまとめて積む
+//記録中に初めて使ったリソースの遷移前の状態は、実行直前にResourceStateTableと突き合わせて決める
+class ResourceStateTracker {
+
+public:
+
+	void Initialize(ID3D12GraphicsCommandList* commandList);
+
+	//リソースをstateで使うことを宣言する(同じ状態なら何もしない)
+	//このリストで初めて使うリソースは遷移前の状態がわからないので、分割バリアを渡しても最初の使用として扱う
+	//開始を積んでいない分割バリアの終了は普通の遷移にする
+	void TransitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES state, D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE);
+
+	//遷移前の状態がわかっている時(レンダーグラフのバリア)に使う
+	//このリストで初めて使うリソースはstateBeforeから始めたものとして追いかけるので、分割バリアの開始から使い始めてもよい
+	void TransitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateBefore, D3D12_RESOURCE_STATES stateAfter, D3D12_RESOURCE_BARRIER_FLAGS flags);
+
+	void AliasingBarrier(ID3D12Resource* before, ID3D12Resource* after);
+
+	void UAVBarrier(ID3D12Resource* resource);
+
+	//溜まっているバリアを1回のResourceBarrierで積む
+	void FlushBarriers();
+
+	//描画とコピーの前には必ずバリアを積む
+	void DrawInstanced(UINT vertexCountPerInstance, UINT instanceCount, UINT startVertexLocation, UINT startInstanceLocation);
+
+	void DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation, INT baseVertexLocation, UINT startInstanceLocation);
+
+	void CopyResource(ID3D12Resource* destination, ID3D12Resource* source);
+
+	void CopyBufferRegion(ID3D12Resource* destination, UINT64 destinationOffset, ID3D12Resource* source, UINT64 sourceOffset, UINT64 numBytes);
+
+	void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION& destination, UINT x, UINT y, UINT z, const D3D12_TEXTURE_COPY_LOCATION& source, const D3D12_BOX* sourceBox = nullptr);
+
+	//実行直前に呼ぶ。最初の状態への遷移をbarrierCommandListに積み、表を最後の状態に更新する
+	uint32_t ResolvePendingBarriers(ResourceStateTable& table, ID3D12GraphicsCommandList* barrierCommandList);
+
+	//次の記録のために状態を捨てる
+	void Reset();
+
+	uint32_t GetRequestedCount() const { return requestedCount_; }
+
+	uint32_t GetDroppedCount() const { return droppedCount_; }
+
+	uint32_t GetFlushCount() const { return flushCount_; }
+
+private:
+
+	struct PendingInitialState {
+		ID3D12Resource* resource;
+		D3D12_RESOURCE_STATES state;
+	};
+
+	ID3D12GraphicsCommandList* commandList_ = nullptr;
+
+	//このコマンドリストの中での現在の状態
+	std::unordered_map<ID3D12Resource*, D3D12_RESOURCE_STATES> states_;
+
+	//記録中に遷移前の状態がわからなかったもの
+	std::vector<PendingInitialState> pendingInitialStates_;
+
+	std::vector<D3D12_RESOURCE_BARRIER> pendingBarriers_;
+
+	//まだ積んでいない遷移のpendingBarriers_の中の位置(まとめるために使う)
+	std::unordered_map<ID3D12Resource*, size_t> pendingTransitionIndices_;
+
+	//開始だけを積んだ分割バリアのリソース
+	std::unordered_set<ID3D12Resource*> splitBarrierResources_;
+
+	uint32_t requestedCount_ = 0;
+
+	uint32_t droppedCount_ = 0;
+
+	uint32_t flushCount_ = 0;
+
+};
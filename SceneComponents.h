@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include "MathTypes.h"
+#include "FrustumCulling.h"
+
+//シーンのエンティティに付けるコンポーネント(EntityWorldでチャンクに詰めるのでPODにする)
+
+struct Transform {
+
+	Vector3 scale;
+	Vector3 rotate;
+	Vector3 translate;
+
+};
+
+//Transformから毎フレーム求めるワールド行列
+struct WorldTransform {
+
+	Matrix4x4 matrix;
+
+};
+
+struct MaterialComponent {
+
+	uint32_t materialIndex;
+
+};
+
+//描画するもの。objectIndexはGPUの行列の配列とカリング用のAABBの配列の位置
+struct RenderComponent {
+
+	uint32_t objectIndex;
+	uint32_t color;
+
+	//LODの表の中の範囲(段ごとにインデックスバッファの範囲を持つ)
+	uint32_t firstLod;
+	uint32_t lodCount;
+	int32_t baseVertex;
+
+	//LOD0のメッシュレットの表の中の範囲(0個ならメッシュレットの判定をしない)
+	uint32_t firstMeshlet;
+	uint32_t meshletCount;
+
+	//CPUの遮蔽判定で遮蔽物として描くか
+	uint32_t isOccluder;
+
+	AABB localBounds;
+
+};
+
+struct Camera {
+
+	float fovY;
+	float nearClip;
+	float farClip;
+
+};
@@ -0,0 +1,65 @@
+#include "StagingRing.h"
+#include <cassert>
+
+void StagingRing::Initialize(uint64_t size) {
+
+	size_ = size;
+	head_ = 0;
+	used_ = 0;
+	currentFrameSize_ = 0;
+
+	frameRanges_.clear();
+
+}
+
+uint64_t StagingRing::Allocate(uint64_t size, uint64_t alignment) {
+
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+	if (size == 0 || size > size_) {
+		return kInvalidOffset;
+	}
+
+	//揃えるために飛ばす分
+	uint64_t start = (head_ + alignment - 1) & ~(alignment - 1);
+
+	//末尾に収まらない場合は先頭まで飛ばす(連続した領域が必要なため)
+	if (start + size > size_) {
+		start = 0;
+	}
+
+	uint64_t wasted = start >= head_ ? start - head_ : size_ - head_;
+
+	if (size_ - used_ < wasted + size) {
+		return kInvalidOffset;
+	}
+
+	head_ = (start + size) % size_;
+
+	used_ += wasted + size;
+
+	currentFrameSize_ += wasted + size;
+
+	return start;
+
+}
+
+void StagingRing::FinishFrame(uint64_t fenceValue) {
+
+	frameRanges_.push_back({ fenceValue, currentFrameSize_ });
+
+	currentFrameSize_ = 0;
+
+}
+
+void StagingRing::ReleaseCompleted(uint64_t completedFenceValue) {
+
+	while (!frameRanges_.empty() && frameRanges_.front().fenceValue <= completedFenceValue) {
+
+		used_ -= frameRanges_.front().size;
+
+		frameRanges_.pop_front();
+
+	}
+
+}
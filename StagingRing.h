@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+
+//アップロード用バッファのバイト単位の位置だけを管理するリング(D3D12には依存しない)
+//フレームごとに確保した分をフェンスの値と結びつけ、GPUが使い終わったら回収する
+class StagingRing {
+
+public:
+
+	static const uint64_t kInvalidOffset = 0xffffffffffffffffull;
+
+	void Initialize(uint64_t size);
+
+	//alignment(2のべき乗)に揃えた連続した領域を確保する(足りなければkInvalidOffset)
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+
+	//このフレームで確保した領域にフェンスの値を結びつける
+	void FinishFrame(uint64_t fenceValue);
+
+	//GPUが完了したフレームの領域を回収する
+	void ReleaseCompleted(uint64_t completedFenceValue);
+
+	uint64_t GetSize() const { return size_; }
+
+	uint64_t GetUsed() const { return used_; }
+
+private:
+
+	struct FrameRange {
+		uint64_t fenceValue;
+		uint64_t size;
+	};
+
+	uint64_t size_ = 0;
+
+	uint64_t head_ = 0;
+
+	uint64_t used_ = 0;
+
+	//まだフェンスが結びついていない現在のフレームの使用量(揃えや折り返しで捨てた分も含む)
+	uint64_t currentFrameSize_ = 0;
+
+	std::deque<FrameRange> frameRanges_;
+
+};
@@ -0,0 +1,302 @@
+#include "StateCachedCommandList.h"
+#include <cassert>
+#include <cstring>
+#include <iterator>
+
+void StateCachedCommandList::Initialize(GraphicsCommandSink* sink) {
+
+	sink_ = sink;
+
+	Invalidate();
+
+	ResetStatistics();
+
+}
+
+void StateCachedCommandList::Invalidate() {
+
+	numDescriptorHeaps_ = 0;
+
+	numViewports_ = 0;
+
+	numScissorRects_ = 0;
+
+	rootSignature_ = nullptr;
+
+	pipelineState_ = nullptr;
+
+	primitiveTopology_ = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+	for (uint32_t i = 0; i < kMaxVertexBuffers; ++i) {
+		isVertexBufferValid_[i] = false;
+	}
+
+	isIndexBufferValid_ = false;
+
+	InvalidateRootArguments();
+
+}
+
+void StateCachedCommandList::SetDescriptorHeaps(UINT numDescriptorHeaps, ID3D12DescriptorHeap* const* descriptorHeaps) {
+
+	assert(numDescriptorHeaps <= std::size(descriptorHeaps_));
+
+	if (numDescriptorHeaps == numDescriptorHeaps_ &&
+		std::memcmp(descriptorHeaps, descriptorHeaps_, sizeof(ID3D12DescriptorHeap*) * numDescriptorHeaps) == 0) {
+		skippedCount_++;
+		return;
+	}
+
+	std::memcpy(descriptorHeaps_, descriptorHeaps, sizeof(ID3D12DescriptorHeap*) * numDescriptorHeaps);
+
+	numDescriptorHeaps_ = numDescriptorHeaps;
+
+	sink_->SetDescriptorHeaps(numDescriptorHeaps, descriptorHeaps);
+
+	issuedCount_++;
+
+	//ヒープが変わると設定済みのディスクリプタテーブルは使えなくなる
+	for (RootArgument& argument : rootArguments_) {
+		if (argument.type == RootArgumentType::kDescriptorTable) {
+			argument.type = RootArgumentType::kNone;
+		}
+	}
+
+}
+
+void StateCachedCommandList::RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* viewports) {
+
+	assert(numViewports <= kMaxViewports);
+
+	if (numViewports == numViewports_ && std::memcmp(viewports, viewports_, sizeof(D3D12_VIEWPORT) * numViewports) == 0) {
+		skippedCount_++;
+		return;
+	}
+
+	std::memcpy(viewports_, viewports, sizeof(D3D12_VIEWPORT) * numViewports);
+
+	numViewports_ = numViewports;
+
+	sink_->RSSetViewports(numViewports, viewports);
+
+	issuedCount_++;
+
+}
+
+void StateCachedCommandList::RSSetScissorRects(UINT numRects, const D3D12_RECT* rects) {
+
+	assert(numRects <= kMaxViewports);
+
+	if (numRects == numScissorRects_ && std::memcmp(rects, scissorRects_, sizeof(D3D12_RECT) * numRects) == 0) {
+		skippedCount_++;
+		return;
+	}
+
+	std::memcpy(scissorRects_, rects, sizeof(D3D12_RECT) * numRects);
+
+	numScissorRects_ = numRects;
+
+	sink_->RSSetScissorRects(numRects, rects);
+
+	issuedCount_++;
+
+}
+
+void StateCachedCommandList::SetGraphicsRootSignature(ID3D12RootSignature* rootSignature) {
+
+	if (rootSignature == rootSignature_) {
+		skippedCount_++;
+		return;
+	}
+
+	rootSignature_ = rootSignature;
+
+	sink_->SetGraphicsRootSignature(rootSignature);
+
+	issuedCount_++;
+
+	//ルートシグネチャが変わるとルート引数はすべて未設定に戻る
+	InvalidateRootArguments();
+
+}
+
+void StateCachedCommandList::SetPipelineState(ID3D12PipelineState* pipelineState) {
+
+	if (pipelineState == pipelineState_) {
+		skippedCount_++;
+		return;
+	}
+
+	pipelineState_ = pipelineState;
+
+	sink_->SetPipelineState(pipelineState);
+
+	issuedCount_++;
+
+}
+
+void StateCachedCommandList::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology) {
+
+	if (primitiveTopology == primitiveTopology_) {
+		skippedCount_++;
+		return;
+	}
+
+	primitiveTopology_ = primitiveTopology;
+
+	sink_->IASetPrimitiveTopology(primitiveTopology);
+
+	issuedCount_++;
+
+}
+
+void StateCachedCommandList::IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views) {
+
+	assert(startSlot + numViews <= kMaxVertexBuffers);
+
+	bool isSame = true;
+
+	for (UINT i = 0; i < numViews; ++i) {
+		UINT slot = startSlot + i;
+		if (!isVertexBufferValid_[slot] || std::memcmp(&vertexBufferViews_[slot], &views[i], sizeof(D3D12_VERTEX_BUFFER_VIEW)) != 0) {
+			isSame = false;
+			break;
+		}
+	}
+
+	if (isSame) {
+		skippedCount_++;
+		return;
+	}
+
+	for (UINT i = 0; i < numViews; ++i) {
+		vertexBufferViews_[startSlot + i] = views[i];
+		isVertexBufferValid_[startSlot + i] = true;
+	}
+
+	sink_->IASetVertexBuffers(startSlot, numViews, views);
+
+	issuedCount_++;
+
+}
+
+void StateCachedCommandList::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) {
+
+	if (isIndexBufferValid_ && std::memcmp(&indexBufferView_, view, sizeof(D3D12_INDEX_BUFFER_VIEW)) == 0) {
+		skippedCount_++;
+		return;
+	}
+
+	indexBufferView_ = *view;
+
+	isIndexBufferValid_ = true;
+
+	sink_->IASetIndexBuffer(view);
+
+	issuedCount_++;
+
+}
+
+void StateCachedCommandList::SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) {
+
+	if (UpdateRootArgument(rootParameterIndex, RootArgumentType::kConstantBufferView, bufferLocation)) {
+		sink_->SetGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
+	}
+
+}
+
+void StateCachedCommandList::SetGraphicsRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) {
+
+	if (UpdateRootArgument(rootParameterIndex, RootArgumentType::kShaderResourceView, bufferLocation)) {
+		sink_->SetGraphicsRootShaderResourceView(rootParameterIndex, bufferLocation);
+	}
+
+}
+
+void StateCachedCommandList::SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor) {
+
+	if (UpdateRootArgument(rootParameterIndex, RootArgumentType::kDescriptorTable, baseDescriptor.ptr)) {
+		sink_->SetGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+	}
+
+}
+
+void StateCachedCommandList::SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValuesToSet, const void* srcData, UINT destOffsetIn32BitValues) {
+
+	assert(rootParameterIndex < kMaxRootParameters);
+
+	assert(destOffsetIn32BitValues + num32BitValuesToSet <= kMaxRootParameters);
+
+	RootArgument& argument = rootArguments_[rootParameterIndex];
+
+	if (argument.type != RootArgumentType::kConstants) {
+		argument.type = RootArgumentType::kConstants;
+		argument.constantMask = 0;
+	}
+
+	const uint32_t* values = static_cast<const uint32_t*>(srcData);
+
+	bool isSame = true;
+
+	for (UINT i = 0; i < num32BitValuesToSet; ++i) {
+
+		UINT index = destOffsetIn32BitValues + i;
+
+		if (!(argument.constantMask & (1ull << index)) || argument.constants[index] != values[i]) {
+			isSame = false;
+		}
+
+		argument.constants[index] = values[i];
+
+		argument.constantMask |= 1ull << index;
+
+	}
+
+	if (isSame) {
+		skippedCount_++;
+		return;
+	}
+
+	sink_->SetGraphicsRoot32BitConstants(rootParameterIndex, num32BitValuesToSet, srcData, destOffsetIn32BitValues);
+
+	issuedCount_++;
+
+}
+
+void StateCachedCommandList::ResetStatistics() {
+
+	issuedCount_ = 0;
+
+	skippedCount_ = 0;
+
+}
+
+bool StateCachedCommandList::UpdateRootArgument(UINT rootParameterIndex, RootArgumentType type, uint64_t value) {
+
+	assert(rootParameterIndex < kMaxRootParameters);
+
+	RootArgument& argument = rootArguments_[rootParameterIndex];
+
+	if (argument.type == type && argument.value == value) {
+		skippedCount_++;
+		return false;
+	}
+
+	argument.type = type;
+
+	argument.value = value;
+
+	issuedCount_++;
+
+	return true;
+
+}
+
+void StateCachedCommandList::InvalidateRootArguments() {
+
+	for (RootArgument& argument : rootArguments_) {
+		argument.type = RootArgumentType::kNone;
+		argument.constantMask = 0;
+	}
+
+}
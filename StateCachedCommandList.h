@@ -0,0 +1,114 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include "GraphicsCommandSink.h"
+
+//コマンドリストに積んだ状態を覚えておき、同じ引数の呼び出しを省く
+//省いた残りはGraphicsCommandSinkに流す(普段はD3D12GraphicsCommandSinkでコマンドリストに積む)
+//ImGuiなど外から直接コマンドリストを触った後はInvalidateを呼ぶこと
+class StateCachedCommandList {
+
+public:
+
+	void Initialize(GraphicsCommandSink* sink);
+
+	GraphicsCommandSink* GetSink() const { return sink_; }
+
+	//覚えている状態をすべて捨てる(コマンドリストのReset後にも呼ぶ)
+	void Invalidate();
+
+	void SetDescriptorHeaps(UINT numDescriptorHeaps, ID3D12DescriptorHeap* const* descriptorHeaps);
+
+	void RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* viewports);
+
+	void RSSetScissorRects(UINT numRects, const D3D12_RECT* rects);
+
+	void SetGraphicsRootSignature(ID3D12RootSignature* rootSignature);
+
+	void SetPipelineState(ID3D12PipelineState* pipelineState);
+
+	void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology);
+
+	void IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views);
+
+	void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view);
+
+	void SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation);
+
+	void SetGraphicsRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation);
+
+	void SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor);
+
+	void SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValuesToSet, const void* srcData, UINT destOffsetIn32BitValues);
+
+	uint32_t GetIssuedCount() const { return issuedCount_; }
+
+	uint32_t GetSkippedCount() const { return skippedCount_; }
+
+	void ResetStatistics();
+
+private:
+
+	//ルートシグネチャの大きさの上限(DWORD単位)
+	static const uint32_t kMaxRootParameters = 64;
+
+	static const uint32_t kMaxViewports = D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+
+	static const uint32_t kMaxVertexBuffers = D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+
+	enum class RootArgumentType {
+		kNone,
+		kConstantBufferView,
+		kShaderResourceView,
+		kDescriptorTable,
+		kConstants,
+	};
+
+	struct RootArgument {
+		RootArgumentType type;
+		uint64_t value;
+		//ルート定数は値ごとに設定済みかを持つ
+		uint64_t constantMask;
+		uint32_t constants[kMaxRootParameters];
+	};
+
+	//同じなら省き、違えば覚えてtrueを返す
+	bool UpdateRootArgument(UINT rootParameterIndex, RootArgumentType type, uint64_t value);
+
+	void InvalidateRootArguments();
+
+	GraphicsCommandSink* sink_ = nullptr;
+
+	ID3D12DescriptorHeap* descriptorHeaps_[2] = {};
+
+	UINT numDescriptorHeaps_ = 0;
+
+	D3D12_VIEWPORT viewports_[kMaxViewports] = {};
+
+	UINT numViewports_ = 0;
+
+	D3D12_RECT scissorRects_[kMaxViewports] = {};
+
+	UINT numScissorRects_ = 0;
+
+	ID3D12RootSignature* rootSignature_ = nullptr;
+
+	ID3D12PipelineState* pipelineState_ = nullptr;
+
+	D3D12_PRIMITIVE_TOPOLOGY primitiveTopology_ = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+	D3D12_VERTEX_BUFFER_VIEW vertexBufferViews_[kMaxVertexBuffers] = {};
+
+	bool isVertexBufferValid_[kMaxVertexBuffers] = {};
+
+	D3D12_INDEX_BUFFER_VIEW indexBufferView_ = {};
+
+	bool isIndexBufferValid_ = false;
+
+	RootArgument rootArguments_[kMaxRootParameters] = {};
+
+	uint32_t issuedCount_ = 0;
+
+	uint32_t skippedCount_ = 0;
+
+};
@@ -0,0 +1,191 @@
+#include "Texture.h"
+#include <algorithm>
+
+bool IsBlockCompressed(TextureFormat format) {
+	return GetBlockDimension(format) == 4;
+}
+
+bool IsSrgbFormat(TextureFormat format) {
+	switch (format) {
+	case TextureFormat::kRGBA8Srgb:
+	case TextureFormat::kBC1Srgb:
+	case TextureFormat::kBC3Srgb:
+	case TextureFormat::kBC7Srgb:
+		return true;
+	default:
+		return false;
+	}
+}
+
+uint32_t GetBytesPerBlock(TextureFormat format) {
+	switch (format) {
+	case TextureFormat::kRGBA8:
+	case TextureFormat::kRGBA8Srgb:
+		return 4;
+	case TextureFormat::kBC1:
+	case TextureFormat::kBC1Srgb:
+		return 8;
+	case TextureFormat::kBC3:
+	case TextureFormat::kBC3Srgb:
+	case TextureFormat::kBC5:
+	case TextureFormat::kBC7:
+	case TextureFormat::kBC7Srgb:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+uint32_t GetBlockDimension(TextureFormat format) {
+	switch (format) {
+	case TextureFormat::kBC1:
+	case TextureFormat::kBC1Srgb:
+	case TextureFormat::kBC3:
+	case TextureFormat::kBC3Srgb:
+	case TextureFormat::kBC5:
+	case TextureFormat::kBC7:
+	case TextureFormat::kBC7Srgb:
+		return 4;
+	default:
+		return 1;
+	}
+}
+
+TextureFormat MakeSrgbFormat(TextureFormat format, bool isSrgb) {
+	switch (format) {
+	case TextureFormat::kRGBA8:
+	case TextureFormat::kRGBA8Srgb:
+		return isSrgb ? TextureFormat::kRGBA8Srgb : TextureFormat::kRGBA8;
+	case TextureFormat::kBC1:
+	case TextureFormat::kBC1Srgb:
+		return isSrgb ? TextureFormat::kBC1Srgb : TextureFormat::kBC1;
+	case TextureFormat::kBC3:
+	case TextureFormat::kBC3Srgb:
+		return isSrgb ? TextureFormat::kBC3Srgb : TextureFormat::kBC3;
+	case TextureFormat::kBC7:
+	case TextureFormat::kBC7Srgb:
+		return isSrgb ? TextureFormat::kBC7Srgb : TextureFormat::kBC7;
+	default:
+		return format;
+	}
+}
+
+uint32_t ComputeMipCount(uint32_t width, uint32_t height) {
+
+	uint32_t mipCount = 1;
+
+	while (width > 1 || height > 1) {
+		width = (std::max)(width >> 1, 1u);
+		height = (std::max)(height >> 1, 1u);
+		++mipCount;
+	}
+
+	return mipCount;
+
+}
+
+size_t ComputeTextureSize(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount) {
+
+	uint32_t blockDimension = GetBlockDimension(format);
+
+	size_t size = 0;
+
+	for (uint32_t mip = 0; mip < mipCount; ++mip) {
+
+		uint32_t mipWidth = (std::max)(width >> mip, 1u);
+		uint32_t mipHeight = (std::max)(height >> mip, 1u);
+
+		size += size_t((mipWidth + blockDimension - 1) / blockDimension) * ((mipHeight + blockDimension - 1) / blockDimension) * GetBytesPerBlock(format);
+
+	}
+
+	return size;
+
+}
+
+void InitializeTexture(TextureData& texture, TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount) {
+
+	if (mipCount == 0) {
+		mipCount = ComputeMipCount(width, height);
+	}
+
+	texture.format = format;
+	texture.width = width;
+	texture.height = height;
+	texture.mips.resize(mipCount);
+
+	uint32_t blockDimension = GetBlockDimension(format);
+
+	size_t offset = 0;
+
+	for (uint32_t mip = 0; mip < mipCount; ++mip) {
+
+		TextureMip& level = texture.mips[mip];
+
+		level.width = (std::max)(width >> mip, 1u);
+		level.height = (std::max)(height >> mip, 1u);
+		level.offset = offset;
+		level.rowPitch = (level.width + blockDimension - 1) / blockDimension * GetBytesPerBlock(format);
+		level.rowCount = (level.height + blockDimension - 1) / blockDimension;
+		level.size = size_t(level.rowPitch) * level.rowCount;
+
+		offset += level.size;
+
+	}
+
+	texture.pixels.assign(offset, 0);
+
+}
+
+void MakeCheckerTexture(TextureData& texture, uint32_t size, uint32_t cellCount) {
+
+	InitializeTexture(texture, TextureFormat::kRGBA8Srgb, size, size, 1);
+
+	uint32_t cellSize = (std::max)(size / cellCount, 1u);
+
+	for (uint32_t y = 0; y < size; ++y) {
+		for (uint32_t x = 0; x < size; ++x) {
+
+			uint8_t* pixel = &texture.pixels[(size_t(y) * size + x) * 4];
+
+			bool isLight = ((x / cellSize) + (y / cellSize)) % 2 == 0;
+
+			//向きがわかるように、明るいマスはUVで色を付ける
+			pixel[0] = isLight ? static_cast<uint8_t>(128 + x * 127 / size) : 40;
+			pixel[1] = isLight ? static_cast<uint8_t>(128 + y * 127 / size) : 40;
+			pixel[2] = isLight ? 200 : 48;
+			pixel[3] = 255;
+
+		}
+	}
+
+}
+
+#if defined(_WIN32)
+
+DXGI_FORMAT ToDxgiFormat(TextureFormat format) {
+	switch (format) {
+	case TextureFormat::kRGBA8:
+		return DXGI_FORMAT_R8G8B8A8_UNORM;
+	case TextureFormat::kRGBA8Srgb:
+		return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	case TextureFormat::kBC1:
+		return DXGI_FORMAT_BC1_UNORM;
+	case TextureFormat::kBC1Srgb:
+		return DXGI_FORMAT_BC1_UNORM_SRGB;
+	case TextureFormat::kBC3:
+		return DXGI_FORMAT_BC3_UNORM;
+	case TextureFormat::kBC3Srgb:
+		return DXGI_FORMAT_BC3_UNORM_SRGB;
+	case TextureFormat::kBC5:
+		return DXGI_FORMAT_BC5_UNORM;
+	case TextureFormat::kBC7:
+		return DXGI_FORMAT_BC7_UNORM;
+	case TextureFormat::kBC7Srgb:
+		return DXGI_FORMAT_BC7_UNORM_SRGB;
+	default:
+		return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+#endif
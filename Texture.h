@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#if defined(_WIN32)
+#include <dxgiformat.h>
+#endif
+
+//CPU側で扱うテクスチャの形式(GPUにはそのまま置ける形式だけを持つ)
+enum class TextureFormat : uint32_t {
+
+	kUnknown,
+
+	kRGBA8,
+	kRGBA8Srgb,
+
+	//RGB 4bit/画素(アルファは持たない)
+	kBC1,
+	kBC1Srgb,
+
+	//BC1のRGBと8bit/画素のアルファ
+	kBC3,
+	kBC3Srgb,
+
+	//2チャンネル(法線マップのxy)
+	kBC5,
+
+	//RGBA 8bit/画素(高品質)
+	kBC7,
+	kBC7Srgb,
+
+};
+
+//4x4のブロックで圧縮する形式か
+bool IsBlockCompressed(TextureFormat format);
+
+bool IsSrgbFormat(TextureFormat format);
+
+//ブロック(圧縮しない形式は1画素)あたりのバイト数
+uint32_t GetBytesPerBlock(TextureFormat format);
+
+//ブロックの一辺の画素数(4か1)
+uint32_t GetBlockDimension(TextureFormat format);
+
+//sRGBかどうかだけを差し替えた形式(対応するものがなければそのまま)
+TextureFormat MakeSrgbFormat(TextureFormat format, bool isSrgb);
+
+//1つのmipの置き場所(pixelsの中で行を詰めて並べる)
+struct TextureMip {
+
+	uint32_t width;
+	uint32_t height;
+
+	size_t offset;
+
+	//1行(圧縮形式ならブロック1列)のバイト数と行の数
+	uint32_t rowPitch;
+	uint32_t rowCount;
+
+	size_t size;
+
+};
+
+//mip全段の画素を1つの配列に持つ2Dテクスチャ
+struct TextureData {
+
+	TextureFormat format = TextureFormat::kUnknown;
+
+	uint32_t width = 0;
+	uint32_t height = 0;
+
+	//0段目が一番大きい
+	std::vector<TextureMip> mips;
+
+	std::vector<uint8_t> pixels;
+
+};
+
+//1x1まで縮めた時の段数
+uint32_t ComputeMipCount(uint32_t width, uint32_t height);
+
+//形式と大きさからmipの置き場所を決めて画素の領域を確保する(mipCountが0なら1x1まで)
+void InitializeTexture(TextureData& texture, TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount = 0);
+
+//mip全段のバイト数
+size_t ComputeTextureSize(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount);
+
+//テクスチャがない時に使う市松模様(RGBA8のsRGB、mipは0段目だけ)
+void MakeCheckerTexture(TextureData& texture, uint32_t size, uint32_t cellCount);
+
+#if defined(_WIN32)
+
+DXGI_FORMAT ToDxgiFormat(TextureFormat format);
+
+#endif
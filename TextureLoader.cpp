@@ -0,0 +1,524 @@
+#include "TextureLoader.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+	const uint32_t kDdsMagic = 0x20534444; //"DDS "
+
+	constexpr uint32_t MakeFourCC(char a, char b, char c, char d) {
+		return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+	}
+
+	struct DdsPixelFormat {
+		uint32_t size;
+		uint32_t flags;
+		uint32_t fourCC;
+		uint32_t rgbBitCount;
+		uint32_t rBitMask;
+		uint32_t gBitMask;
+		uint32_t bBitMask;
+		uint32_t aBitMask;
+	};
+
+	struct DdsHeader {
+		uint32_t size;
+		uint32_t flags;
+		uint32_t height;
+		uint32_t width;
+		uint32_t pitchOrLinearSize;
+		uint32_t depth;
+		uint32_t mipMapCount;
+		uint32_t reserved1[11];
+		DdsPixelFormat pixelFormat;
+		uint32_t caps;
+		uint32_t caps2;
+		uint32_t caps3;
+		uint32_t caps4;
+		uint32_t reserved2;
+	};
+
+	struct DdsHeaderDx10 {
+		uint32_t dxgiFormat;
+		uint32_t resourceDimension;
+		uint32_t miscFlag;
+		uint32_t arraySize;
+		uint32_t miscFlags2;
+	};
+
+	static_assert(sizeof(DdsHeader) == 124, "DdsHeader layout changed");
+	static_assert(sizeof(DdsHeaderDx10) == 20, "DdsHeaderDx10 layout changed");
+	static_assert(sizeof(uint32_t) + sizeof(DdsHeader) + sizeof(DdsHeaderDx10) == kMaxDdsHeaderSize, "kMaxDdsHeaderSize does not match the DDS headers");
+
+	const uint32_t kDdsFlagCaps = 0x1;
+	const uint32_t kDdsFlagHeight = 0x2;
+	const uint32_t kDdsFlagWidth = 0x4;
+	const uint32_t kDdsFlagPitch = 0x8;
+	const uint32_t kDdsFlagPixelFormat = 0x1000;
+	const uint32_t kDdsFlagMipMapCount = 0x20000;
+	const uint32_t kDdsFlagLinearSize = 0x80000;
+	const uint32_t kDdsFlagDepth = 0x800000;
+
+	const uint32_t kDdsPixelFormatAlphaPixels = 0x1;
+	const uint32_t kDdsPixelFormatFourCC = 0x4;
+	const uint32_t kDdsPixelFormatRgb = 0x40;
+
+	const uint32_t kDdsCapsComplex = 0x8;
+	const uint32_t kDdsCapsTexture = 0x1000;
+	const uint32_t kDdsCapsMipMap = 0x400000;
+
+	const uint32_t kDdsCaps2Cubemap = 0x200;
+	const uint32_t kDdsCaps2Volume = 0x200000;
+
+	const uint32_t kDdsDimensionTexture2D = 3;
+
+	const uint32_t kDdsMiscTextureCube = 0x4;
+
+	//DXGI_FORMATの値(Windowsのヘッダーなしで読めるように持っておく)
+	enum DxgiFormatValue : uint32_t {
+		kDxgiR8G8B8A8Unorm = 28,
+		kDxgiR8G8B8A8UnormSrgb = 29,
+		kDxgiBC1Unorm = 71,
+		kDxgiBC1UnormSrgb = 72,
+		kDxgiBC3Unorm = 77,
+		kDxgiBC3UnormSrgb = 78,
+		kDxgiBC5Unorm = 83,
+		kDxgiB8G8R8A8Unorm = 87,
+		kDxgiB8G8R8A8UnormSrgb = 91,
+		kDxgiBC7Unorm = 98,
+		kDxgiBC7UnormSrgb = 99,
+	};
+
+	//VkFormatの値
+	enum VkFormatValue : uint32_t {
+		kVkR8G8B8A8Unorm = 37,
+		kVkR8G8B8A8Srgb = 43,
+		kVkBC1RgbUnorm = 131,
+		kVkBC1RgbSrgb = 132,
+		kVkBC1RgbaUnorm = 133,
+		kVkBC1RgbaSrgb = 134,
+		kVkBC3Unorm = 137,
+		kVkBC3Srgb = 138,
+		kVkBC5Unorm = 141,
+		kVkBC7Unorm = 145,
+		kVkBC7Srgb = 146,
+	};
+
+	const uint8_t kKtx2Identifier[12] = { 0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a };
+
+	struct Ktx2Header {
+		uint32_t vkFormat;
+		uint32_t typeSize;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t layerCount;
+		uint32_t faceCount;
+		uint32_t levelCount;
+		uint32_t supercompressionScheme;
+		uint32_t dfdByteOffset;
+		uint32_t dfdByteLength;
+		uint32_t kvdByteOffset;
+		uint32_t kvdByteLength;
+		//ファイルの中では8バイト境界にあるが、構造体では揃わないので32bitずつ持つ(使わない)
+		uint32_t sgdByteOffset[2];
+		uint32_t sgdByteLength[2];
+	};
+
+	struct Ktx2Level {
+		uint64_t byteOffset;
+		uint64_t byteLength;
+		uint64_t uncompressedByteLength;
+	};
+
+	static_assert(sizeof(Ktx2Header) == 68, "Ktx2Header layout changed");
+
+	//GPUが扱える大きさを超えるものは読まない
+	const uint32_t kMaxTextureDimension = 16384;
+
+	TextureFormat FromDxgiFormat(uint32_t dxgiFormat, bool& isBgra) {
+
+		isBgra = false;
+
+		switch (dxgiFormat) {
+		case kDxgiR8G8B8A8Unorm: return TextureFormat::kRGBA8;
+		case kDxgiR8G8B8A8UnormSrgb: return TextureFormat::kRGBA8Srgb;
+		case kDxgiB8G8R8A8Unorm: isBgra = true; return TextureFormat::kRGBA8;
+		case kDxgiB8G8R8A8UnormSrgb: isBgra = true; return TextureFormat::kRGBA8Srgb;
+		case kDxgiBC1Unorm: return TextureFormat::kBC1;
+		case kDxgiBC1UnormSrgb: return TextureFormat::kBC1Srgb;
+		case kDxgiBC3Unorm: return TextureFormat::kBC3;
+		case kDxgiBC3UnormSrgb: return TextureFormat::kBC3Srgb;
+		case kDxgiBC5Unorm: return TextureFormat::kBC5;
+		case kDxgiBC7Unorm: return TextureFormat::kBC7;
+		case kDxgiBC7UnormSrgb: return TextureFormat::kBC7Srgb;
+		default: return TextureFormat::kUnknown;
+		}
+
+	}
+
+	uint32_t ToDxgiFormatValue(TextureFormat format) {
+		switch (format) {
+		case TextureFormat::kRGBA8: return kDxgiR8G8B8A8Unorm;
+		case TextureFormat::kRGBA8Srgb: return kDxgiR8G8B8A8UnormSrgb;
+		case TextureFormat::kBC1: return kDxgiBC1Unorm;
+		case TextureFormat::kBC1Srgb: return kDxgiBC1UnormSrgb;
+		case TextureFormat::kBC3: return kDxgiBC3Unorm;
+		case TextureFormat::kBC3Srgb: return kDxgiBC3UnormSrgb;
+		case TextureFormat::kBC5: return kDxgiBC5Unorm;
+		case TextureFormat::kBC7: return kDxgiBC7Unorm;
+		case TextureFormat::kBC7Srgb: return kDxgiBC7UnormSrgb;
+		default: return 0;
+		}
+	}
+
+	TextureFormat FromVkFormat(uint32_t vkFormat) {
+		switch (vkFormat) {
+		case kVkR8G8B8A8Unorm: return TextureFormat::kRGBA8;
+		case kVkR8G8B8A8Srgb: return TextureFormat::kRGBA8Srgb;
+		case kVkBC1RgbUnorm:
+		case kVkBC1RgbaUnorm: return TextureFormat::kBC1;
+		case kVkBC1RgbSrgb:
+		case kVkBC1RgbaSrgb: return TextureFormat::kBC1Srgb;
+		case kVkBC3Unorm: return TextureFormat::kBC3;
+		case kVkBC3Srgb: return TextureFormat::kBC3Srgb;
+		case kVkBC5Unorm: return TextureFormat::kBC5;
+		case kVkBC7Unorm: return TextureFormat::kBC7;
+		case kVkBC7Srgb: return TextureFormat::kBC7Srgb;
+		default: return TextureFormat::kUnknown;
+		}
+	}
+
+	//古いDDSのピクセル形式から決める
+	TextureFormat FromDdsPixelFormat(const DdsPixelFormat& pixelFormat, bool& isBgra) {
+
+		isBgra = false;
+
+		if (pixelFormat.flags & kDdsPixelFormatFourCC) {
+			switch (pixelFormat.fourCC) {
+			case MakeFourCC('D', 'X', 'T', '1'): return TextureFormat::kBC1;
+			case MakeFourCC('D', 'X', 'T', '5'): return TextureFormat::kBC3;
+			case MakeFourCC('A', 'T', 'I', '2'):
+			case MakeFourCC('B', 'C', '5', 'U'): return TextureFormat::kBC5;
+			default: return TextureFormat::kUnknown;
+			}
+		}
+
+		if ((pixelFormat.flags & kDdsPixelFormatRgb) && pixelFormat.rgbBitCount == 32) {
+
+			if (pixelFormat.rBitMask == 0x000000ff && pixelFormat.gBitMask == 0x0000ff00 && pixelFormat.bBitMask == 0x00ff0000) {
+				return TextureFormat::kRGBA8;
+			}
+
+			if (pixelFormat.rBitMask == 0x00ff0000 && pixelFormat.gBitMask == 0x0000ff00 && pixelFormat.bBitMask == 0x000000ff) {
+				isBgra = true;
+				return TextureFormat::kRGBA8;
+			}
+
+		}
+
+		return TextureFormat::kUnknown;
+
+	}
+
+	//アルファを持たない古いRGBは不透明にする
+	void SwizzleBgraToRgba(TextureData& texture, bool hasAlpha) {
+		for (size_t i = 0; i + 3 < texture.pixels.size(); i += 4) {
+			std::swap(texture.pixels[i], texture.pixels[i + 2]);
+			if (!hasAlpha) {
+				texture.pixels[i + 3] = 0xff;
+			}
+		}
+	}
+
+	bool HasExtension(const char* path, const char* extension) {
+
+		size_t pathLength = std::strlen(path);
+		size_t extensionLength = std::strlen(extension);
+
+		if (pathLength < extensionLength) {
+			return false;
+		}
+
+		for (size_t i = 0; i < extensionLength; ++i) {
+			char c = path[pathLength - extensionLength + i];
+			if (c >= 'A' && c <= 'Z') {
+				c = static_cast<char>(c - 'A' + 'a');
+			}
+			if (c != extension[i]) {
+				return false;
+			}
+		}
+
+		return true;
+
+	}
+
+	//DDSのヘッダーを解析して形式と段を決め、画素の領域を確保する(画素は写さない)
+	//dataにはヘッダーまで、fileSizeはファイル全体の大きさ
+	bool ParseDdsHeader(const uint8_t* data, size_t size, uint64_t fileSize, TextureData& texture, size_t& pixelOffset, bool& isBgra, bool& hasAlpha) {
+
+		if (size < sizeof(uint32_t) + sizeof(DdsHeader)) {
+			return false;
+		}
+
+		uint32_t magic = 0;
+
+		std::memcpy(&magic, data, sizeof(magic));
+
+		DdsHeader header;
+
+		std::memcpy(&header, data + sizeof(uint32_t), sizeof(header));
+
+		if (magic != kDdsMagic || header.size != sizeof(DdsHeader) || header.pixelFormat.size != sizeof(DdsPixelFormat)) {
+			return false;
+		}
+
+		if ((header.caps2 & (kDdsCaps2Cubemap | kDdsCaps2Volume)) || ((header.flags & kDdsFlagDepth) && header.depth > 1)) {
+			return false;
+		}
+
+		size_t dataOffset = sizeof(uint32_t) + sizeof(DdsHeader);
+
+		TextureFormat format = TextureFormat::kUnknown;
+
+		isBgra = false;
+
+		if ((header.pixelFormat.flags & kDdsPixelFormatFourCC) && header.pixelFormat.fourCC == MakeFourCC('D', 'X', '1', '0')) {
+
+			if (size < dataOffset + sizeof(DdsHeaderDx10)) {
+				return false;
+			}
+
+			DdsHeaderDx10 headerDx10;
+
+			std::memcpy(&headerDx10, data + dataOffset, sizeof(headerDx10));
+
+			dataOffset += sizeof(DdsHeaderDx10);
+
+			if (headerDx10.resourceDimension != kDdsDimensionTexture2D || headerDx10.arraySize > 1 || (headerDx10.miscFlag & kDdsMiscTextureCube)) {
+				return false;
+			}
+
+			format = FromDxgiFormat(headerDx10.dxgiFormat, isBgra);
+
+		} else {
+
+			format = FromDdsPixelFormat(header.pixelFormat, isBgra);
+
+		}
+
+		if (format == TextureFormat::kUnknown || header.width == 0 || header.height == 0 || header.width > kMaxTextureDimension || header.height > kMaxTextureDimension) {
+			return false;
+		}
+
+		uint32_t mipCount = (header.flags & kDdsFlagMipMapCount) && header.mipMapCount != 0 ? header.mipMapCount : 1;
+
+		if (mipCount > ComputeMipCount(header.width, header.height)) {
+			return false;
+		}
+
+		if (fileSize < dataOffset || fileSize - dataOffset < ComputeTextureSize(format, header.width, header.height, mipCount)) {
+			return false;
+		}
+
+		//DDSはmipを大きい順に詰めて並べるので、TextureDataと同じ並び
+		InitializeTexture(texture, format, header.width, header.height, mipCount);
+
+		pixelOffset = dataOffset;
+
+		hasAlpha = (header.pixelFormat.flags & kDdsPixelFormatAlphaPixels) || (header.pixelFormat.flags & kDdsPixelFormatFourCC);
+
+		return true;
+
+	}
+
+}
+
+bool LoadTexture(const char* path, TextureData& texture) {
+
+	MappedFile file;
+
+	if (!file.Open(path) || file.GetData() == nullptr) {
+		return false;
+	}
+
+	if (HasExtension(path, ".ktx2")) {
+		return ParseKtx2(file.GetData(), file.GetSize(), texture);
+	}
+
+	if (HasExtension(path, ".dds")) {
+		return ParseDds(file.GetData(), file.GetSize(), texture);
+	}
+
+	return false;
+
+}
+
+bool ParseDds(const uint8_t* data, size_t size, TextureData& texture) {
+
+	size_t pixelOffset = 0;
+
+	bool isBgra = false;
+
+	bool hasAlpha = false;
+
+	if (!ParseDdsHeader(data, size, size, texture, pixelOffset, isBgra, hasAlpha)) {
+		return false;
+	}
+
+	std::memcpy(texture.pixels.data(), data + pixelOffset, texture.pixels.size());
+
+	if (isBgra) {
+		SwizzleBgraToRgba(texture, hasAlpha);
+	}
+
+	return true;
+
+}
+
+bool ParseDdsLayout(const uint8_t* data, size_t size, uint64_t fileSize, TextureData& texture, size_t& pixelOffset) {
+
+	bool isBgra = false;
+
+	bool hasAlpha = false;
+
+	//BGRAはファイルの並びのまま写せない
+	return ParseDdsHeader(data, size, fileSize, texture, pixelOffset, isBgra, hasAlpha) && !isBgra;
+
+}
+
+bool ParseKtx2(const uint8_t* data, size_t size, TextureData& texture) {
+
+	if (size < sizeof(kKtx2Identifier) + sizeof(Ktx2Header) || std::memcmp(data, kKtx2Identifier, sizeof(kKtx2Identifier)) != 0) {
+		return false;
+	}
+
+	Ktx2Header header;
+
+	std::memcpy(&header, data + sizeof(kKtx2Identifier), sizeof(header));
+
+	//2Dの1枚だけを読む(超圧縮されたものはBasisやZstdの展開が必要なので読まない)
+	if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 || header.supercompressionScheme != 0) {
+		return false;
+	}
+
+	TextureFormat format = FromVkFormat(header.vkFormat);
+
+	if (format == TextureFormat::kUnknown || header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelWidth > kMaxTextureDimension || header.pixelHeight > kMaxTextureDimension) {
+		return false;
+	}
+
+	//0は「読み込む側で作る」の意味なので1段として読む
+	uint32_t mipCount = (std::max)(header.levelCount, 1u);
+
+	if (mipCount > ComputeMipCount(header.pixelWidth, header.pixelHeight)) {
+		return false;
+	}
+
+	size_t levelIndexOffset = sizeof(kKtx2Identifier) + sizeof(Ktx2Header);
+
+	if (size < levelIndexOffset + sizeof(Ktx2Level) * mipCount) {
+		return false;
+	}
+
+	InitializeTexture(texture, format, header.pixelWidth, header.pixelHeight, mipCount);
+
+	for (uint32_t mip = 0; mip < mipCount; ++mip) {
+
+		Ktx2Level level;
+
+		std::memcpy(&level, data + levelIndexOffset + sizeof(Ktx2Level) * mip, sizeof(level));
+
+		const TextureMip& destination = texture.mips[mip];
+
+		if (level.byteLength != destination.size || level.byteOffset > size || level.byteLength > size - level.byteOffset) {
+			return false;
+		}
+
+		std::memcpy(texture.pixels.data() + destination.offset, data + level.byteOffset, destination.size);
+
+	}
+
+	return true;
+
+}
+
+std::vector<uint8_t> WriteDdsToMemory(const TextureData& texture) {
+
+	std::vector<uint8_t> data;
+
+	uint32_t dxgiFormat = ToDxgiFormatValue(texture.format);
+
+	if (dxgiFormat == 0 || texture.mips.empty()) {
+		return data;
+	}
+
+	uint32_t mipCount = static_cast<uint32_t>(texture.mips.size());
+
+	DdsHeader header{};
+
+	header.size = sizeof(DdsHeader);
+	header.flags = kDdsFlagCaps | kDdsFlagHeight | kDdsFlagWidth | kDdsFlagPixelFormat | kDdsFlagMipMapCount;
+	header.height = texture.height;
+	header.width = texture.width;
+	header.mipMapCount = mipCount;
+	header.pixelFormat.size = sizeof(DdsPixelFormat);
+	header.pixelFormat.flags = kDdsPixelFormatFourCC;
+	header.pixelFormat.fourCC = MakeFourCC('D', 'X', '1', '0');
+	header.caps = kDdsCapsTexture | (mipCount > 1 ? kDdsCapsComplex | kDdsCapsMipMap : 0);
+
+	if (IsBlockCompressed(texture.format)) {
+		header.flags |= kDdsFlagLinearSize;
+		header.pitchOrLinearSize = static_cast<uint32_t>(texture.mips[0].size);
+	} else {
+		header.flags |= kDdsFlagPitch;
+		header.pitchOrLinearSize = texture.mips[0].rowPitch;
+	}
+
+	DdsHeaderDx10 headerDx10{};
+
+	headerDx10.dxgiFormat = dxgiFormat;
+	headerDx10.resourceDimension = kDdsDimensionTexture2D;
+	headerDx10.arraySize = 1;
+
+	data.resize(sizeof(uint32_t) + sizeof(DdsHeader) + sizeof(DdsHeaderDx10) + texture.pixels.size());
+
+	uint8_t* destination = data.data();
+
+	std::memcpy(destination, &kDdsMagic, sizeof(uint32_t));
+	destination += sizeof(uint32_t);
+
+	std::memcpy(destination, &header, sizeof(header));
+	destination += sizeof(header);
+
+	std::memcpy(destination, &headerDx10, sizeof(headerDx10));
+	destination += sizeof(headerDx10);
+
+	std::memcpy(destination, texture.pixels.data(), texture.pixels.size());
+
+	return data;
+
+}
+
+bool WriteDds(const char* path, const TextureData& texture) {
+
+	std::vector<uint8_t> data = WriteDdsToMemory(texture);
+
+	if (data.empty()) {
+		return false;
+	}
+
+	FILE* file = std::fopen(path, "wb");
+
+	if (file == nullptr) {
+		return false;
+	}
+
+	bool isWritten = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+
+	return std::fclose(file) == 0 && isWritten;
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "Texture.h"
+
+//DDS(.dds)とKTX2(.ktx2)の2Dテクスチャを読む。キューブマップ、配列、体積テクスチャ、KTX2の超圧縮は読まない
+//ファイルはマップして、mipごとにTextureDataの並びへコピーする
+
+//拡張子で形式を選んで読む
+bool LoadTexture(const char* path, TextureData& texture);
+
+//メモリ上のファイルを解析する(古いDDSのBGRAはRGBAに並べ替える。sRGBかどうかの情報がなければsRGBでない形式にする)
+bool ParseDds(const uint8_t* data, size_t size, TextureData& texture);
+
+//DDSのヘッダー(マジックとDX10の拡張ヘッダーを含む)の最大のバイト数
+const size_t kMaxDdsHeaderSize = 148;
+
+//DDSのヘッダーだけを解析してtextureの形式と段を決め、画素の領域を確保する(画素は読まない)
+//dataはファイルの先頭からsizeバイト(ヘッダーを含む)、fileSizeはファイル全体の大きさ
+//pixelOffsetにはファイルの中の0段目の位置を返す(以降の段はTextureMip::offsetの位置)。BGRAのように並べ替えが要るものはfalse
+bool ParseDdsLayout(const uint8_t* data, size_t size, uint64_t fileSize, TextureData& texture, size_t& pixelOffset);
+
+bool ParseKtx2(const uint8_t* data, size_t size, TextureData& texture);
+
+//DX10の拡張ヘッダー付きのDDSとして書き出す(焼き込んだテクスチャの保存に使う)
+std::vector<uint8_t> WriteDdsToMemory(const TextureData& texture);
+
+bool WriteDds(const char* path, const TextureData& texture);
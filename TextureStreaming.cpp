@@ -0,0 +1,306 @@
+#include "TextureStreaming.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+	//古い段ほど、同じなら大きい段ほど先に追い出す(std::push_heapは最大のものを先頭にする)
+	struct EvictionOrder {
+
+		template <typename Candidate>
+		bool operator()(const Candidate& a, const Candidate& b) const {
+			if (a.usedFrame != b.usedFrame) {
+				return a.usedFrame > b.usedFrame;
+			}
+			return a.size < b.size;
+		}
+
+	};
+
+}
+
+void TextureStreamer::Initialize(const TextureStreamingSettings& settings) {
+
+	settings_ = settings;
+
+	textures_.clear();
+	mipSizes_.clear();
+	mipUsedFrames_.clear();
+	usedTextureIndices_.clear();
+	requests_.clear();
+	evictions_.clear();
+
+	frame_ = 0;
+
+	statistics_ = {};
+
+}
+
+uint32_t TextureStreamer::RegisterTexture(uint32_t width, uint32_t height, const uint64_t* mipSizes, uint32_t mipCount) {
+
+	assert(mipCount > 0);
+
+	StreamedTexture texture{};
+
+	texture.mipCount = mipCount;
+	texture.pendingMip = kNoMip;
+	texture.desiredMip = kNoMip;
+	texture.firstMipRecord = static_cast<uint32_t>(mipSizes_.size());
+
+	//小さい段は最初から常駐させる(最後の段は必ず常駐させる)
+	texture.tailMip = mipCount - 1;
+
+	for (uint32_t mip = 0; mip < mipCount; ++mip) {
+		if ((std::max)(width >> mip, 1u) <= settings_.tailMipDimension && (std::max)(height >> mip, 1u) <= settings_.tailMipDimension) {
+			texture.tailMip = mip;
+			break;
+		}
+	}
+
+	texture.residentMip = texture.tailMip;
+
+	mipSizes_.insert(mipSizes_.end(), mipSizes, mipSizes + mipCount);
+
+	mipUsedFrames_.insert(mipUsedFrames_.end(), mipCount, 0);
+
+	for (uint32_t mip = texture.tailMip; mip < mipCount; ++mip) {
+		statistics_.residentSize += mipSizes[mip];
+	}
+
+	textures_.push_back(texture);
+
+	return static_cast<uint32_t>(textures_.size() - 1);
+
+}
+
+void TextureStreamer::BeginFrame() {
+
+	++frame_;
+
+	for (uint32_t textureIndex : usedTextureIndices_) {
+		textures_[textureIndex].desiredMip = kNoMip;
+		textures_[textureIndex].screenCoverage = 0.0f;
+	}
+
+	usedTextureIndices_.clear();
+
+}
+
+void TextureStreamer::ReportUsage(uint32_t textureIndex, float desiredMip, float screenCoverage) {
+
+	StreamedTexture& texture = textures_[textureIndex];
+
+	uint32_t mip = desiredMip <= 0.0f ? 0 : (std::min)(static_cast<uint32_t>(desiredMip), texture.mipCount - 1);
+
+	if (texture.desiredMip == kNoMip) {
+		usedTextureIndices_.push_back(textureIndex);
+	}
+
+	texture.desiredMip = (std::min)(texture.desiredMip, mip);
+
+	texture.screenCoverage += screenCoverage;
+
+	//必要な段より粗い段も(フィルタで)使われる
+	for (uint32_t i = mip; i < texture.mipCount; ++i) {
+		mipUsedFrames_[texture.firstMipRecord + i] = frame_;
+	}
+
+}
+
+void TextureStreamer::Update() {
+
+	requests_.clear();
+
+	evictions_.clear();
+
+	evictionHeap_.clear();
+
+	isEvictionHeapBuilt_ = false;
+
+	statistics_.requestedCount = 0;
+	statistics_.evictedCount = 0;
+	statistics_.deniedCount = 0;
+
+	requestCandidates_.clear();
+
+	for (uint32_t textureIndex : usedTextureIndices_) {
+
+		const StreamedTexture& texture = textures_[textureIndex];
+
+		if (texture.pendingMip == kNoMip && texture.desiredMip < texture.residentMip) {
+			requestCandidates_.push_back(textureIndex);
+		}
+
+	}
+
+	//足りない段の数が多いもの、画面で大きいものを先にする
+	std::sort(requestCandidates_.begin(), requestCandidates_.end(), [&](uint32_t a, uint32_t b) {
+
+		const StreamedTexture& textureA = textures_[a];
+		const StreamedTexture& textureB = textures_[b];
+
+		uint32_t deficitA = textureA.residentMip - textureA.desiredMip;
+		uint32_t deficitB = textureB.residentMip - textureB.desiredMip;
+
+		if (deficitA != deficitB) {
+			return deficitA > deficitB;
+		}
+
+		if (textureA.screenCoverage != textureB.screenCoverage) {
+			return textureA.screenCoverage > textureB.screenCoverage;
+		}
+
+		return a < b;
+
+	});
+
+	uint64_t requestedSize = 0;
+
+	for (uint32_t textureIndex : requestCandidates_) {
+
+		if (requests_.size() >= settings_.maxRequestsPerFrame) {
+			break;
+		}
+
+		StreamedTexture& texture = textures_[textureIndex];
+
+		uint32_t mip = texture.residentMip - 1;
+
+		uint64_t size = mipSizes_[texture.firstMipRecord + mip];
+
+		//1フレームのバイト数の上限を超える段でも、そのフレームの最初の要求なら出す
+		if (!requests_.empty() && requestedSize + size > settings_.maxRequestBytesPerFrame) {
+			continue;
+		}
+
+		if (!MakeRoom(size)) {
+			statistics_.deniedCount++;
+			continue;
+		}
+
+		texture.pendingMip = mip;
+
+		statistics_.pendingSize += size;
+
+		requestedSize += size;
+
+		requests_.push_back({ textureIndex, mip });
+
+		statistics_.requestedCount++;
+
+	}
+
+}
+
+void TextureStreamer::CompleteRequest(uint32_t textureIndex, uint32_t mip) {
+
+	StreamedTexture& texture = textures_[textureIndex];
+
+	assert(texture.pendingMip == mip && mip + 1 == texture.residentMip);
+
+	uint64_t size = mipSizes_[texture.firstMipRecord + mip];
+
+	statistics_.pendingSize -= size;
+
+	statistics_.residentSize += size;
+
+	texture.residentMip = mip;
+
+	texture.pendingMip = kNoMip;
+
+}
+
+void TextureStreamer::CancelRequest(uint32_t textureIndex, uint32_t mip) {
+
+	StreamedTexture& texture = textures_[textureIndex];
+
+	assert(texture.pendingMip == mip);
+
+	statistics_.pendingSize -= mipSizes_[texture.firstMipRecord + mip];
+
+	texture.pendingMip = kNoMip;
+
+}
+
+bool TextureStreamer::MakeRoom(uint64_t size) {
+
+	if (size > settings_.budget) {
+		return false;
+	}
+
+	while (statistics_.residentSize + statistics_.pendingSize + size > settings_.budget) {
+
+		//予算を超えた時だけ候補を集める
+		if (!isEvictionHeapBuilt_) {
+
+			for (uint32_t textureIndex = 0; textureIndex < textures_.size(); ++textureIndex) {
+				PushEvictionCandidate(textureIndex);
+			}
+
+			std::make_heap(evictionHeap_.begin(), evictionHeap_.end(), EvictionOrder());
+
+			isEvictionHeapBuilt_ = true;
+
+		}
+
+		if (evictionHeap_.empty()) {
+			return false;
+		}
+
+		std::pop_heap(evictionHeap_.begin(), evictionHeap_.end(), EvictionOrder());
+
+		EvictionCandidate candidate = evictionHeap_.back();
+
+		evictionHeap_.pop_back();
+
+		StreamedTexture& texture = textures_[candidate.textureIndex];
+
+		assert(texture.residentMip == candidate.mip && texture.pendingMip == kNoMip);
+
+		statistics_.residentSize -= candidate.size;
+
+		evictions_.push_back({ candidate.textureIndex, candidate.mip });
+
+		statistics_.evictedCount++;
+
+		texture.residentMip++;
+
+		PushEvictionCandidate(candidate.textureIndex);
+
+	}
+
+	return true;
+
+}
+
+void TextureStreamer::PushEvictionCandidate(uint32_t textureIndex) {
+
+	const StreamedTexture& texture = textures_[textureIndex];
+
+	//最初から常駐している段、読み込み中のテクスチャ、このフレームで使う段は追い出さない
+	if (texture.residentMip >= texture.tailMip || texture.pendingMip != kNoMip) {
+		return;
+	}
+
+	uint64_t usedFrame = mipUsedFrames_[texture.firstMipRecord + texture.residentMip];
+
+	if (usedFrame == frame_) {
+		return;
+	}
+
+	evictionHeap_.push_back({ usedFrame, mipSizes_[texture.firstMipRecord + texture.residentMip], textureIndex, texture.residentMip });
+
+	if (isEvictionHeapBuilt_) {
+		std::push_heap(evictionHeap_.begin(), evictionHeap_.end(), EvictionOrder());
+	}
+
+}
+
+float ComputeDesiredMip(uint32_t width, uint32_t height, float projectedSize) {
+
+	float texelCount = static_cast<float>((std::max)(width, height));
+
+	return (std::max)(std::log2(texelCount / (std::max)(projectedSize, 1.0f)), 0.0f);
+
+}
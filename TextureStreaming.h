@@ -0,0 +1,162 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+//mip段単位のテクスチャのストリーミングの判断だけを行う(読み込みやGPUへのコピーは呼び出し側が行う)
+//各テクスチャは[residentMip, mipCount)の段が常駐している。細かい段は1段ずつ要求し、追い出しも一番細かい段から行う
+//予算を超える時は、最後に使われたフレームが一番古い段から追い出す(このフレームで使う段は追い出さない)
+
+struct TextureStreamingSettings {
+
+	//常駐と読み込み中の段の合計の上限(バイト)
+	uint64_t budget = 64ull * 1024 * 1024;
+
+	//幅と高さがこれ以下の段は登録した時から常駐させ、追い出さない
+	uint32_t tailMipDimension = 64;
+
+	//1フレームで出す要求の数とバイト数の上限
+	uint32_t maxRequestsPerFrame = 8;
+
+	uint64_t maxRequestBytesPerFrame = 8ull * 1024 * 1024;
+
+};
+
+//textureIndexのmip段を読み込む要求(常駐している一番細かい段の1つ上)
+struct MipRequest {
+
+	uint32_t textureIndex;
+	uint32_t mip;
+
+};
+
+//textureIndexのmip段を追い出した(これからはmip + 1段目以降だけを使う)
+struct MipEviction {
+
+	uint32_t textureIndex;
+	uint32_t mip;
+
+};
+
+struct TextureStreamingStatistics {
+
+	uint64_t residentSize = 0;
+
+	uint64_t pendingSize = 0;
+
+	//直前のUpdateで出した要求、追い出した段、予算が足りずに見送った要求の数
+	uint32_t requestedCount = 0;
+
+	uint32_t evictedCount = 0;
+
+	uint32_t deniedCount = 0;
+
+};
+
+class TextureStreamer {
+
+public:
+
+	static const uint32_t kNoMip = 0xffffffff;
+
+	void Initialize(const TextureStreamingSettings& settings);
+
+	//mipSizes[mip]は段ごとのバイト数。小さい段は常駐させ、テクスチャの番号を返す
+	uint32_t RegisterTexture(uint32_t width, uint32_t height, const uint64_t* mipSizes, uint32_t mipCount);
+
+	//フレームの初めに呼ぶ
+	void BeginFrame();
+
+	//このフレームで必要な段(小数は切り捨てて細かい方にする)と、画面で占める面積(ピクセル)を伝える
+	//同じフレームで何度呼んでもよく、一番細かい段と面積の合計を使う
+	void ReportUsage(uint32_t textureIndex, float desiredMip, float screenCoverage);
+
+	//要求と追い出しを決める(必要な段との差が大きいもの、画面で大きいものを先に要求する)
+	void Update();
+
+	const std::vector<MipRequest>& GetRequests() const { return requests_; }
+
+	const std::vector<MipEviction>& GetEvictions() const { return evictions_; }
+
+	//要求した段の読み込みが終わったら呼ぶ
+	void CompleteRequest(uint32_t textureIndex, uint32_t mip);
+
+	//要求した段を読めなかった時に呼ぶ(まだ必要なら次のUpdateで要求し直す)
+	void CancelRequest(uint32_t textureIndex, uint32_t mip);
+
+	uint32_t GetResidentMip(uint32_t textureIndex) const { return textures_[textureIndex].residentMip; }
+
+	uint32_t GetPendingMip(uint32_t textureIndex) const { return textures_[textureIndex].pendingMip; }
+
+	//最初から常駐している段の先頭
+	uint32_t GetTailMip(uint32_t textureIndex) const { return textures_[textureIndex].tailMip; }
+
+	size_t GetTextureCount() const { return textures_.size(); }
+
+	const TextureStreamingStatistics& GetStatistics() const { return statistics_; }
+
+private:
+
+	struct StreamedTexture {
+
+		uint32_t mipCount;
+		uint32_t tailMip;
+		uint32_t residentMip;
+		uint32_t pendingMip;
+
+		//このフレームで必要な段と画面で占める面積
+		uint32_t desiredMip;
+		float screenCoverage;
+
+		//mipSizes_とmipUsedFrames_の中の位置
+		uint32_t firstMipRecord;
+
+	};
+
+	//追い出しの候補(テクスチャの一番細かい常駐の段)
+	struct EvictionCandidate {
+
+		uint64_t usedFrame;
+		uint64_t size;
+		uint32_t textureIndex;
+		uint32_t mip;
+
+	};
+
+	//このフレームで使っていない段を古い順に追い出して、size以上の空きを作る(作れなければfalse)
+	bool MakeRoom(uint64_t size);
+
+	//テクスチャの一番細かい常駐の段が追い出せるなら候補に加える
+	void PushEvictionCandidate(uint32_t textureIndex);
+
+	TextureStreamingSettings settings_;
+
+	std::vector<StreamedTexture> textures_;
+
+	//全テクスチャの段ごとのバイト数と最後に使われたフレーム(0なら使われたことがない)
+	std::vector<uint64_t> mipSizes_;
+
+	std::vector<uint64_t> mipUsedFrames_;
+
+	//このフレームで使われたテクスチャ
+	std::vector<uint32_t> usedTextureIndices_;
+
+	//要求を出す候補(並べ替えに使う)
+	std::vector<uint32_t> requestCandidates_;
+
+	std::vector<EvictionCandidate> evictionHeap_;
+
+	bool isEvictionHeapBuilt_ = false;
+
+	std::vector<MipRequest> requests_;
+
+	std::vector<MipEviction> evictions_;
+
+	uint64_t frame_ = 0;
+
+	TextureStreamingStatistics statistics_;
+
+};
+
+//UVの0～1が画面でprojectedSizeピクセルの大きさに映る時に必要な段(1テクセルが1ピクセル以下になる一番粗い段)
+float ComputeDesiredMip(uint32_t width, uint32_t height, float projectedSize);
@@ -0,0 +1,176 @@
+#include "TextureUploader.h"
+#include "ResourceStateTracker.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+void TextureUploader::Initialize(ID3D12Device* device, uint64_t stagingSize) {
+
+	device_ = device;
+
+	D3D12_HEAP_PROPERTIES uploadHeapProperties{};
+
+	uploadHeapProperties.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+	D3D12_RESOURCE_DESC bufferDesc{};
+
+	bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+
+	bufferDesc.Width = stagingSize;
+
+	bufferDesc.Height = 1;
+
+	bufferDesc.DepthOrArraySize = 1;
+
+	bufferDesc.MipLevels = 1;
+
+	bufferDesc.SampleDesc.Count = 1;
+
+	bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+	HRESULT hr = device_->CreateCommittedResource(&uploadHeapProperties, D3D12_HEAP_FLAG_NONE,
+
+		&bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+
+		IID_PPV_ARGS(&uploadBuffer_));
+
+	assert(SUCCEEDED(hr));
+
+	//アップロード用のヒープは書き込み専用なので、開いたままにする
+	hr = uploadBuffer_->Map(0, nullptr, reinterpret_cast<void**>(&mappedData_));
+
+	assert(SUCCEEDED(hr));
+
+	ring_.Initialize(stagingSize);
+
+}
+
+void TextureUploader::Finalize() {
+
+	if (uploadBuffer_ != nullptr) {
+		uploadBuffer_->Unmap(0, nullptr);
+		uploadBuffer_->Release();
+		uploadBuffer_ = nullptr;
+		mappedData_ = nullptr;
+	}
+
+}
+
+ID3D12Resource* TextureUploader::CreateTexture(const TextureData& texture, ResourceStateTable& table) {
+
+	D3D12_HEAP_PROPERTIES defaultHeapProperties{};
+
+	defaultHeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+	D3D12_RESOURCE_DESC textureDesc{};
+
+	textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+
+	textureDesc.Width = texture.width;
+
+	textureDesc.Height = texture.height;
+
+	textureDesc.DepthOrArraySize = 1;
+
+	textureDesc.MipLevels = static_cast<UINT16>(texture.mips.size());
+
+	textureDesc.Format = ToDxgiFormat(texture.format);
+
+	textureDesc.SampleDesc.Count = 1;
+
+	ID3D12Resource* resource = nullptr;
+
+	HRESULT hr = device_->CreateCommittedResource(&defaultHeapProperties, D3D12_HEAP_FLAG_NONE,
+
+		&textureDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+
+		IID_PPV_ARGS(&resource));
+
+	assert(SUCCEEDED(hr));
+
+	table.Register(resource, D3D12_RESOURCE_STATE_COPY_DEST);
+
+	return resource;
+
+}
+
+bool TextureUploader::Upload(ResourceStateTracker& tracker, ID3D12Resource* resource, const TextureData& texture, uint32_t firstMip, uint32_t mipCount) {
+
+	mipCount = (std::min)(mipCount, static_cast<uint32_t>(texture.mips.size()) - firstMip);
+
+	//段ごとの配置を求め、全段を1つの連続した領域にまとめて確保する
+	D3D12_RESOURCE_DESC textureDesc = resource->GetDesc();
+
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(mipCount);
+
+	std::vector<UINT> rowCounts(mipCount);
+
+	std::vector<UINT64> rowSizes(mipCount);
+
+	UINT64 totalSize = 0;
+
+	device_->GetCopyableFootprints(&textureDesc, firstMip, mipCount, 0, footprints.data(), rowCounts.data(), rowSizes.data(), &totalSize);
+
+	uint64_t offset = ring_.Allocate(totalSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+	if (offset == StagingRing::kInvalidOffset) {
+		return false;
+	}
+
+	tracker.TransitionResource(resource, D3D12_RESOURCE_STATE_COPY_DEST);
+
+	for (uint32_t i = 0; i < mipCount; ++i) {
+
+		const TextureMip& level = texture.mips[firstMip + i];
+
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint = footprints[i];
+
+		footprint.Offset += offset;
+
+		//行の間隔はGPUの揃え(256バイト)に合わせて詰め直す
+		uint8_t* destination = mappedData_ + footprint.Offset;
+
+		const uint8_t* source = texture.pixels.data() + level.offset;
+
+		for (UINT row = 0; row < rowCounts[i]; ++row) {
+			std::memcpy(destination + size_t(row) * footprint.Footprint.RowPitch, source + size_t(row) * level.rowPitch, level.rowPitch);
+		}
+
+		D3D12_TEXTURE_COPY_LOCATION destinationLocation{};
+
+		destinationLocation.pResource = resource;
+
+		destinationLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+
+		destinationLocation.SubresourceIndex = firstMip + i;
+
+		D3D12_TEXTURE_COPY_LOCATION sourceLocation{};
+
+		sourceLocation.pResource = uploadBuffer_;
+
+		sourceLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+
+		sourceLocation.PlacedFootprint = footprint;
+
+		tracker.CopyTextureRegion(destinationLocation, 0, 0, 0, sourceLocation);
+
+	}
+
+	tracker.TransitionResource(resource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+	return true;
+
+}
+
+void TextureUploader::FinishFrame(uint64_t fenceValue) {
+
+	ring_.FinishFrame(fenceValue);
+
+}
+
+void TextureUploader::ReleaseCompleted(uint64_t completedFenceValue) {
+
+	ring_.ReleaseCompleted(completedFenceValue);
+
+}
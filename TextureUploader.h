@@ -0,0 +1,43 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include "Texture.h"
+#include "StagingRing.h"
+
+class ResourceStateTable;
+class ResourceStateTracker;
+
+//テクスチャをDEFAULTヒープに作り、常駐のアップロード用バッファをリングとして使ってコピーを積む
+//リングの領域はフレームのフェンスと結びつけ、GPUが使い終わったら回収する
+class TextureUploader {
+
+public:
+
+	void Initialize(ID3D12Device* device, uint64_t stagingSize);
+
+	void Finalize();
+
+	//全段を持つテクスチャをCOPY_DESTで作り、状態の表に登録する(ブロック圧縮なら0段目の幅と高さは4の倍数にする)
+	ID3D12Resource* CreateTexture(const TextureData& texture, ResourceStateTable& table);
+
+	//firstMipからmipCount段をリングに書いてコピーを積み、ピクセルシェーダーから読める状態にする
+	//リングに収まらなければ何も積まずにfalse(次のフレームでやり直す)
+	bool Upload(ResourceStateTracker& tracker, ID3D12Resource* resource, const TextureData& texture, uint32_t firstMip = 0, uint32_t mipCount = 0xffffffff);
+
+	void FinishFrame(uint64_t fenceValue);
+
+	void ReleaseCompleted(uint64_t completedFenceValue);
+
+	const StagingRing& GetRing() const { return ring_; }
+
+private:
+
+	ID3D12Device* device_ = nullptr;
+
+	ID3D12Resource* uploadBuffer_ = nullptr;
+
+	uint8_t* mappedData_ = nullptr;
+
+	StagingRing ring_;
+
+};
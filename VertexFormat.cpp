@@ -0,0 +1,880 @@
+#include "VertexFormat.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+//VERTEX_FORMAT_NO_SIMDを定義するとSIMDを使わない(テストで結果が同じことを確かめる)
+#if (defined(_M_X64) || defined(__SSE2__)) && !defined(VERTEX_FORMAT_NO_SIMD)
+#include <emmintrin.h>
+#define VERTEX_FORMAT_USE_SSE2
+#endif
+
+//F16Cの変換命令はAVX2のCPUなら必ずある
+#if defined(VERTEX_FORMAT_USE_SSE2) && (defined(__F16C__) || defined(__AVX2__))
+#include <immintrin.h>
+#define VERTEX_FORMAT_USE_F16C
+#endif
+
+namespace {
+
+	//1つの塊で詰める最小の頂点数
+	const size_t kMinVertexChunkSize = 16384;
+
+	uint32_t FloatBits(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	float BitsFloat(uint32_t bits) {
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	uint32_t GetFormatSize(VertexElementFormat format) {
+
+		switch (format) {
+		case VertexElementFormat::kFloat32x2:
+			return 8;
+		case VertexElementFormat::kFloat32x3:
+			return 12;
+		case VertexElementFormat::kFloat32x4:
+			return 16;
+		case VertexElementFormat::kFloat16x2:
+			return 4;
+		case VertexElementFormat::kUnorm16x4:
+			return 8;
+		case VertexElementFormat::kSnorm16x2:
+			return 4;
+		}
+
+		return 0;
+
+	}
+
+	//0～65535に丸める(NaNは0)
+	uint16_t QuantizeUnorm16(float value) {
+
+		if (!(value > 0.0f)) {
+			return 0;
+		}
+
+		return static_cast<uint16_t>((std::min)(value, 65535.0f) + 0.5f);
+
+	}
+
+	//八面体への展開。単位ベクトルを|x|+|y|+|z|=1に移し、下半分を上に折り返す
+	void EncodeOctahedral(const Vector3& normal, int16_t encoded[2]) {
+
+		float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+
+		if (!(length > 0.0f)) {
+			encoded[0] = 0;
+			encoded[1] = 0;
+			return;
+		}
+
+		float inverseLength = 1.0f / length;
+
+		float x = normal.x * inverseLength;
+		float y = normal.y * inverseLength;
+
+		if (normal.z < 0.0f) {
+			float foldedX = (1.0f - std::fabs(y)) * std::copysign(1.0f, x);
+			float foldedY = (1.0f - std::fabs(x)) * std::copysign(1.0f, y);
+			x = foldedX;
+			y = foldedY;
+		}
+
+		encoded[0] = static_cast<int16_t>(std::lrint(x * 32767.0f));
+		encoded[1] = static_cast<int16_t>(std::lrint(y * 32767.0f));
+
+	}
+
+	Vector3 DecodeOctahedral(const int16_t encoded[2]) {
+
+		const float kInverseMax = 1.0f / 32767.0f;
+
+		float x = (std::max)(encoded[0] * kInverseMax, -1.0f);
+		float y = (std::max)(encoded[1] * kInverseMax, -1.0f);
+		float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+		//下半分は折り返しを戻す
+		float t = (std::max)(-z, 0.0f);
+
+		x += x >= 0.0f ? -t : t;
+		y += y >= 0.0f ? -t : t;
+
+		float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+
+		return { x * inverseLength, y * inverseLength, z * inverseLength };
+
+	}
+
+#if defined(VERTEX_FORMAT_USE_SSE2)
+
+	//4つのfloatをhalfにして、2組分の8つを16ビットに詰める
+	__m128i ConvertFloatToHalf(__m128 a, __m128 b) {
+
+#if defined(VERTEX_FORMAT_USE_F16C)
+
+		return _mm_unpacklo_epi64(_mm_cvtps_ph(a, _MM_FROUND_TO_NEAREST_INT), _mm_cvtps_ph(b, _MM_FROUND_TO_NEAREST_INT));
+
+#else
+
+		//FloatToHalfと同じ手順を4つずつ行う
+		auto convert = [](__m128 value) {
+
+			const __m128i signMask = _mm_set1_epi32(static_cast<int>(0x80000000u));
+			const __m128i halfMax = _mm_set1_epi32(0x47800000);
+			const __m128i minNormal = _mm_set1_epi32(0x38800000);
+			const __m128i denormalMagic = _mm_set1_epi32(0x3f000000);
+			const __m128i normalBias = _mm_set1_epi32(static_cast<int>(0xfffu - (112u << 23)));
+
+			__m128i bits = _mm_castps_si128(value);
+			__m128i sign = _mm_and_si128(bits, signMask);
+			__m128i absolute = _mm_xor_si128(bits, sign);
+
+			__m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(_mm_castsi128_ps(absolute), _mm_castsi128_ps(absolute)));
+			__m128i isRegular = _mm_cmpgt_epi32(halfMax, absolute);
+			__m128i isDenormal = _mm_cmpgt_epi32(minNormal, absolute);
+
+			__m128i infinityOrNaN = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+
+			__m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(absolute), _mm_castsi128_ps(denormalMagic))), denormalMagic);
+
+			//仮数の最下位ビットが奇数なら切り上げ側へ寄せる
+			__m128i odd = _mm_srai_epi32(_mm_slli_epi32(absolute, 18), 31);
+			__m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absolute, normalBias), odd), 13);
+
+			__m128i finite = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+			__m128i result = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, infinityOrNaN));
+
+			result = _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+
+			//符号付きで飽和させずに詰めるため、下位16ビットを符号拡張しておく
+			return _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+
+		};
+
+		return _mm_packs_epi32(convert(a), convert(b));
+
+#endif
+
+	}
+
+	//下位の4つのhalfをfloatにする
+	__m128 ConvertHalfToFloat(__m128i halves) {
+
+#if defined(VERTEX_FORMAT_USE_F16C)
+
+		return _mm_cvtph_ps(halves);
+
+#else
+
+		const __m128i exponentMask = _mm_set1_epi32(0x7c00 << 13);
+
+		__m128i bits = _mm_unpacklo_epi16(halves, _mm_setzero_si128());
+
+		__m128i result = _mm_slli_epi32(_mm_and_si128(bits, _mm_set1_epi32(0x7fff)), 13);
+
+		__m128i exponent = _mm_and_si128(result, exponentMask);
+
+		result = _mm_add_epi32(result, _mm_set1_epi32(112 << 23));
+
+		//無限大とNaNは指数を全部立てる
+		__m128i isInfinityOrNaN = _mm_cmpeq_epi32(exponent, exponentMask);
+
+		result = _mm_add_epi32(result, _mm_and_si128(isInfinityOrNaN, _mm_set1_epi32(112 << 23)));
+
+		//非正規化数は浮動小数点の引き算で正規化する
+		__m128i isDenormal = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+
+		__m128i denormal = _mm_castps_si128(_mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(result, _mm_set1_epi32(1 << 23))), _mm_castsi128_ps(_mm_set1_epi32(113 << 23))));
+
+		result = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, result));
+
+		result = _mm_or_si128(result, _mm_slli_epi32(_mm_and_si128(bits, _mm_set1_epi32(0x8000)), 16));
+
+		return _mm_castsi128_ps(result);
+
+#endif
+
+	}
+
+	void Store32(uint8_t* destination, __m128i value) {
+		uint32_t bits = static_cast<uint32_t>(_mm_cvtsi128_si32(value));
+		std::memcpy(destination, &bits, sizeof(bits));
+	}
+
+	uint32_t Load32(const uint8_t* source) {
+		uint32_t bits;
+		std::memcpy(&bits, source, sizeof(bits));
+		return bits;
+	}
+
+#endif
+
+	//各要素を詰める処理(destinationはその要素の位置を指し、strideバイトおきに書く)
+
+	void EncodePositionsUnorm16(uint8_t* destination, size_t stride, const MeshVertex* vertices, size_t count, const Vector3& offset, const Vector3& factor) {
+
+		size_t i = 0;
+
+#if defined(VERTEX_FORMAT_USE_SSE2)
+
+		const __m128 offsetVector = _mm_setr_ps(offset.x, offset.y, offset.z, 0.0f);
+		const __m128 factorVector = _mm_setr_ps(factor.x, factor.y, factor.z, 0.0f);
+		const __m128 maxVector = _mm_set1_ps(65535.0f);
+
+		//xyzは四捨五入、wは常に65535(1.0)
+		const __m128 roundVector = _mm_setr_ps(0.5f, 0.5f, 0.5f, 65535.0f);
+
+		//符号付きの飽和で詰めるため、32768ずらしてから戻す
+		const __m128i bias = _mm_set1_epi32(32768);
+		const __m128i flip = _mm_set1_epi16(static_cast<short>(0x8000));
+
+		auto quantize = [&](const Vector4& position) {
+			__m128 value = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&position.x), offsetVector), factorVector);
+			value = _mm_add_ps(_mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), maxVector), roundVector);
+			return _mm_sub_epi32(_mm_cvttps_epi32(value), bias);
+		};
+
+		for (; i + 2 <= count; i += 2) {
+
+			__m128i packed = _mm_xor_si128(_mm_packs_epi32(quantize(vertices[i].position), quantize(vertices[i + 1].position)), flip);
+
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(destination + stride * i), packed);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(destination + stride * (i + 1)), _mm_srli_si128(packed, 8));
+
+		}
+
+#endif
+
+		for (; i < count; ++i) {
+
+			const Vector4& position = vertices[i].position;
+
+			uint16_t quantized[4] = {
+				QuantizeUnorm16((position.x - offset.x) * factor.x),
+				QuantizeUnorm16((position.y - offset.y) * factor.y),
+				QuantizeUnorm16((position.z - offset.z) * factor.z),
+				65535,
+			};
+
+			std::memcpy(destination + stride * i, quantized, sizeof(quantized));
+
+		}
+
+	}
+
+	void DecodePositionsUnorm16(MeshVertex* vertices, const uint8_t* source, size_t stride, size_t count, const VertexQuantization& quantization) {
+
+		const float kInverseMax = 1.0f / 65535.0f;
+
+		size_t i = 0;
+
+#if defined(VERTEX_FORMAT_USE_SSE2)
+
+		//wは量子化していないので1にする
+		const __m128 scaleVector = _mm_setr_ps(quantization.scale.x * kInverseMax, quantization.scale.y * kInverseMax, quantization.scale.z * kInverseMax, 0.0f);
+		const __m128 offsetVector = _mm_setr_ps(quantization.offset.x, quantization.offset.y, quantization.offset.z, 1.0f);
+
+		for (; i < count; ++i) {
+
+			__m128i quantized = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + stride * i)), _mm_setzero_si128());
+
+			_mm_storeu_ps(&vertices[i].position.x, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(quantized), scaleVector), offsetVector));
+
+		}
+
+#endif
+
+		for (; i < count; ++i) {
+
+			uint16_t quantized[4];
+
+			std::memcpy(quantized, source + stride * i, sizeof(quantized));
+
+			vertices[i].position = {
+				quantized[0] * (quantization.scale.x * kInverseMax) + quantization.offset.x,
+				quantized[1] * (quantization.scale.y * kInverseMax) + quantization.offset.y,
+				quantized[2] * (quantization.scale.z * kInverseMax) + quantization.offset.z,
+				1.0f,
+			};
+
+		}
+
+	}
+
+	void EncodeNormalsOctahedral16(uint8_t* destination, size_t stride, const MeshVertex* vertices, size_t count) {
+
+		size_t i = 0;
+
+#if defined(VERTEX_FORMAT_USE_SSE2)
+
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+
+		//4頂点ずつ成分ごとに並べ替えて計算する
+		for (; i + 4 <= count; i += 4) {
+
+			const MeshVertex* v = vertices + i;
+
+			__m128 x = _mm_setr_ps(v[0].normal.x, v[1].normal.x, v[2].normal.x, v[3].normal.x);
+			__m128 y = _mm_setr_ps(v[0].normal.y, v[1].normal.y, v[2].normal.y, v[3].normal.y);
+			__m128 z = _mm_setr_ps(v[0].normal.z, v[1].normal.z, v[2].normal.z, v[3].normal.z);
+
+			__m128 length = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(signMask, x), _mm_andnot_ps(signMask, y)), _mm_andnot_ps(signMask, z));
+
+			//長さが0やNaNなら(0,0)にする
+			__m128 isValid = _mm_cmpgt_ps(length, zero);
+
+			__m128 inverseLength = _mm_div_ps(one, length);
+
+			x = _mm_and_ps(_mm_mul_ps(x, inverseLength), isValid);
+			y = _mm_and_ps(_mm_mul_ps(y, inverseLength), isValid);
+
+			__m128 isLower = _mm_and_ps(_mm_cmplt_ps(z, zero), isValid);
+
+			__m128 signX = _mm_or_ps(_mm_and_ps(x, signMask), one);
+			__m128 signY = _mm_or_ps(_mm_and_ps(y, signMask), one);
+
+			__m128 foldedX = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, y)), signX);
+			__m128 foldedY = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, x)), signY);
+
+			x = _mm_or_ps(_mm_and_ps(isLower, foldedX), _mm_andnot_ps(isLower, x));
+			y = _mm_or_ps(_mm_and_ps(isLower, foldedY), _mm_andnot_ps(isLower, y));
+
+			const __m128 scale = _mm_set1_ps(32767.0f);
+
+			__m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(x, scale)), _mm_cvtps_epi32(_mm_mul_ps(y, scale)));
+
+			//x0..x3,y0..y3をx0,y0,x1,y1...に並べ直す
+			__m128i interleaved = _mm_unpacklo_epi16(packed, _mm_srli_si128(packed, 8));
+
+			Store32(destination + stride * i, interleaved);
+			Store32(destination + stride * (i + 1), _mm_srli_si128(interleaved, 4));
+			Store32(destination + stride * (i + 2), _mm_srli_si128(interleaved, 8));
+			Store32(destination + stride * (i + 3), _mm_srli_si128(interleaved, 12));
+
+		}
+
+#endif
+
+		for (; i < count; ++i) {
+
+			int16_t encoded[2];
+
+			EncodeOctahedral(vertices[i].normal, encoded);
+
+			std::memcpy(destination + stride * i, encoded, sizeof(encoded));
+
+		}
+
+	}
+
+	void DecodeNormalsOctahedral16(MeshVertex* vertices, const uint8_t* source, size_t stride, size_t count) {
+
+		size_t i = 0;
+
+#if defined(VERTEX_FORMAT_USE_SSE2)
+
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 minusOne = _mm_set1_ps(-1.0f);
+		const __m128 inverseMax = _mm_set1_ps(1.0f / 32767.0f);
+
+		for (; i + 4 <= count; i += 4) {
+
+			__m128i packed = _mm_setr_epi32(
+				static_cast<int>(Load32(source + stride * i)),
+				static_cast<int>(Load32(source + stride * (i + 1))),
+				static_cast<int>(Load32(source + stride * (i + 2))),
+				static_cast<int>(Load32(source + stride * (i + 3))));
+
+			__m128 x = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(packed, 16), 16)), inverseMax), minusOne);
+			__m128 y = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(packed, 16)), inverseMax), minusOne);
+			__m128 z = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, x)), _mm_andnot_ps(signMask, y));
+
+			//正の成分からはtを引き、負の成分には足す
+			__m128 t = _mm_max_ps(_mm_sub_ps(zero, z), zero);
+
+			x = _mm_sub_ps(x, _mm_xor_ps(t, _mm_and_ps(x, signMask)));
+			y = _mm_sub_ps(y, _mm_xor_ps(t, _mm_and_ps(y, signMask)));
+
+			__m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z))));
+
+			float xs[4];
+			float ys[4];
+			float zs[4];
+
+			_mm_storeu_ps(xs, _mm_mul_ps(x, inverseLength));
+			_mm_storeu_ps(ys, _mm_mul_ps(y, inverseLength));
+			_mm_storeu_ps(zs, _mm_mul_ps(z, inverseLength));
+
+			for (size_t lane = 0; lane < 4; ++lane) {
+				vertices[i + lane].normal = { xs[lane], ys[lane], zs[lane] };
+			}
+
+		}
+
+#endif
+
+		for (; i < count; ++i) {
+
+			int16_t encoded[2];
+
+			std::memcpy(encoded, source + stride * i, sizeof(encoded));
+
+			vertices[i].normal = DecodeOctahedral(encoded);
+
+		}
+
+	}
+
+	void EncodeTexcoordsFloat16(uint8_t* destination, size_t stride, const MeshVertex* vertices, size_t count) {
+
+		size_t i = 0;
+
+#if defined(VERTEX_FORMAT_USE_SSE2)
+
+		for (; i + 4 <= count; i += 4) {
+
+			const MeshVertex* v = vertices + i;
+
+			__m128 uv01 = _mm_setr_ps(v[0].texcoord.x, v[0].texcoord.y, v[1].texcoord.x, v[1].texcoord.y);
+			__m128 uv23 = _mm_setr_ps(v[2].texcoord.x, v[2].texcoord.y, v[3].texcoord.x, v[3].texcoord.y);
+
+			__m128i halves = ConvertFloatToHalf(uv01, uv23);
+
+			Store32(destination + stride * i, halves);
+			Store32(destination + stride * (i + 1), _mm_srli_si128(halves, 4));
+			Store32(destination + stride * (i + 2), _mm_srli_si128(halves, 8));
+			Store32(destination + stride * (i + 3), _mm_srli_si128(halves, 12));
+
+		}
+
+#endif
+
+		for (; i < count; ++i) {
+
+			uint16_t halves[2] = { FloatToHalf(vertices[i].texcoord.x), FloatToHalf(vertices[i].texcoord.y) };
+
+			std::memcpy(destination + stride * i, halves, sizeof(halves));
+
+		}
+
+	}
+
+	void DecodeTexcoordsFloat16(MeshVertex* vertices, const uint8_t* source, size_t stride, size_t count) {
+
+		size_t i = 0;
+
+#if defined(VERTEX_FORMAT_USE_SSE2)
+
+		for (; i + 4 <= count; i += 4) {
+
+			__m128i halves = _mm_setr_epi32(
+				static_cast<int>(Load32(source + stride * i)),
+				static_cast<int>(Load32(source + stride * (i + 1))),
+				static_cast<int>(Load32(source + stride * (i + 2))),
+				static_cast<int>(Load32(source + stride * (i + 3))));
+
+			float uv[8];
+
+			_mm_storeu_ps(uv, ConvertHalfToFloat(halves));
+			_mm_storeu_ps(uv + 4, ConvertHalfToFloat(_mm_srli_si128(halves, 8)));
+
+			for (size_t lane = 0; lane < 4; ++lane) {
+				vertices[i + lane].texcoord = { uv[lane * 2], uv[lane * 2 + 1] };
+			}
+
+		}
+
+#endif
+
+		for (; i < count; ++i) {
+
+			uint16_t halves[2];
+
+			std::memcpy(halves, source + stride * i, sizeof(halves));
+
+			vertices[i].texcoord = { HalfToFloat(halves[0]), HalfToFloat(halves[1]) };
+
+		}
+
+	}
+
+	//全頂点を塊に分けてfunction(begin, end)を呼ぶ
+	template<typename Function>
+	void ForEachVertexRange(size_t vertexCount, JobSystem* jobSystem, const Function& function) {
+
+		if (jobSystem == nullptr || vertexCount <= kMinVertexChunkSize) {
+			function(size_t(0), vertexCount);
+			return;
+		}
+
+		jobSystem->ParallelFor(vertexCount, kMinVertexChunkSize, function);
+
+	}
+
+}
+
+VertexLayout::VertexLayout() : VertexLayout(kFullVertexLayoutDesc) {
+}
+
+VertexLayout::VertexLayout(const VertexLayoutDesc& desc) : desc_(desc) {
+
+	switch (desc.position) {
+	case PositionEncoding::kFloat32:
+		positionOffset_ = AddElement("POSITION", VertexElementFormat::kFloat32x4);
+		break;
+	case PositionEncoding::kUnorm16:
+		positionOffset_ = AddElement("POSITION", VertexElementFormat::kUnorm16x4);
+		break;
+	}
+
+	switch (desc.normal) {
+	case NormalEncoding::kNone:
+		break;
+	case NormalEncoding::kFloat32:
+		normalOffset_ = AddElement("NORMAL", VertexElementFormat::kFloat32x3);
+		break;
+	case NormalEncoding::kOctahedral16:
+		normalOffset_ = AddElement("NORMAL", VertexElementFormat::kSnorm16x2);
+		break;
+	}
+
+	switch (desc.texcoord) {
+	case TexcoordEncoding::kNone:
+		break;
+	case TexcoordEncoding::kFloat32:
+		texcoordOffset_ = AddElement("TEXCOORD", VertexElementFormat::kFloat32x2);
+		break;
+	case TexcoordEncoding::kFloat16:
+		texcoordOffset_ = AddElement("TEXCOORD", VertexElementFormat::kFloat16x2);
+		break;
+	}
+
+}
+
+uint32_t VertexLayout::AddElement(const char* semanticName, VertexElementFormat format) {
+
+	assert(elementCount_ < kMaxVertexElements);
+
+	uint32_t offset = stride_;
+
+	elements_[elementCount_++] = { semanticName, 0, format, offset };
+
+	//入力レイアウトの要素は4バイト境界に置く
+	stride_ = (offset + GetFormatSize(format) + 3) & ~3u;
+
+	return offset;
+
+}
+
+VertexQuantization ComputeVertexQuantization(const MeshVertex* vertices, size_t vertexCount) {
+
+	if (vertexCount == 0) {
+		return { { 0.0f,0.0f,0.0f }, { 0.0f,0.0f,0.0f } };
+	}
+
+	Vector3 min = { vertices[0].position.x, vertices[0].position.y, vertices[0].position.z };
+	Vector3 max = min;
+
+	for (size_t i = 1; i < vertexCount; ++i) {
+
+		const Vector4& position = vertices[i].position;
+
+		min.x = (std::min)(min.x, position.x);
+		min.y = (std::min)(min.y, position.y);
+		min.z = (std::min)(min.z, position.z);
+
+		max.x = (std::max)(max.x, position.x);
+		max.y = (std::max)(max.y, position.y);
+		max.z = (std::max)(max.z, position.z);
+
+	}
+
+	//軸ごとに範囲いっぱいを使う(平らな軸はscaleが0になり、offsetだけで戻る)
+	return { min, { max.x - min.x, max.y - min.y, max.z - min.z } };
+
+}
+
+Matrix4x4 MakeDequantizeMatrix(const VertexQuantization& quantization) {
+
+	Matrix4x4 result = {};
+
+	result.m[0][0] = quantization.scale.x;
+	result.m[1][1] = quantization.scale.y;
+	result.m[2][2] = quantization.scale.z;
+
+	result.m[3][0] = quantization.offset.x;
+	result.m[3][1] = quantization.offset.y;
+	result.m[3][2] = quantization.offset.z;
+	result.m[3][3] = 1.0f;
+
+	return result;
+
+}
+
+void EncodeVertices(void* destination, const MeshVertex* vertices, size_t vertexCount, const VertexLayout& layout, const VertexQuantization& quantization, JobSystem* jobSystem) {
+
+	uint8_t* bytes = static_cast<uint8_t*>(destination);
+
+	size_t stride = layout.GetStride();
+
+	const VertexLayoutDesc& desc = layout.GetDesc();
+
+	//0～65535に写す係数(幅が0の軸は常に0にする)
+	Vector3 factor = {
+		quantization.scale.x > 0.0f ? 65535.0f / quantization.scale.x : 0.0f,
+		quantization.scale.y > 0.0f ? 65535.0f / quantization.scale.y : 0.0f,
+		quantization.scale.z > 0.0f ? 65535.0f / quantization.scale.z : 0.0f,
+	};
+
+	ForEachVertexRange(vertexCount, jobSystem, [&](size_t begin, size_t end) {
+
+		const MeshVertex* source = vertices + begin;
+
+		size_t count = end - begin;
+
+		uint8_t* position = bytes + stride * begin + layout.GetPositionOffset();
+
+		if (desc.position == PositionEncoding::kUnorm16) {
+			EncodePositionsUnorm16(position, stride, source, count, quantization.offset, factor);
+		} else {
+			for (size_t i = 0; i < count; ++i) {
+				std::memcpy(position + stride * i, &source[i].position, sizeof(Vector4));
+			}
+		}
+
+		if (desc.normal != NormalEncoding::kNone) {
+
+			uint8_t* normal = bytes + stride * begin + layout.GetNormalOffset();
+
+			if (desc.normal == NormalEncoding::kOctahedral16) {
+				EncodeNormalsOctahedral16(normal, stride, source, count);
+			} else {
+				for (size_t i = 0; i < count; ++i) {
+					std::memcpy(normal + stride * i, &source[i].normal, sizeof(Vector3));
+				}
+			}
+
+		}
+
+		if (desc.texcoord != TexcoordEncoding::kNone) {
+
+			uint8_t* texcoord = bytes + stride * begin + layout.GetTexcoordOffset();
+
+			if (desc.texcoord == TexcoordEncoding::kFloat16) {
+				EncodeTexcoordsFloat16(texcoord, stride, source, count);
+			} else {
+				for (size_t i = 0; i < count; ++i) {
+					std::memcpy(texcoord + stride * i, &source[i].texcoord, sizeof(Vector2));
+				}
+			}
+
+		}
+
+	});
+
+}
+
+void DecodeVertices(MeshVertex* destination, const void* source, size_t vertexCount, const VertexLayout& layout, const VertexQuantization& quantization, JobSystem* jobSystem) {
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(source);
+
+	size_t stride = layout.GetStride();
+
+	const VertexLayoutDesc& desc = layout.GetDesc();
+
+	ForEachVertexRange(vertexCount, jobSystem, [&](size_t begin, size_t end) {
+
+		MeshVertex* vertices = destination + begin;
+
+		size_t count = end - begin;
+
+		const uint8_t* position = bytes + stride * begin + layout.GetPositionOffset();
+
+		if (desc.position == PositionEncoding::kUnorm16) {
+			DecodePositionsUnorm16(vertices, position, stride, count, quantization);
+		} else {
+			for (size_t i = 0; i < count; ++i) {
+				std::memcpy(&vertices[i].position, position + stride * i, sizeof(Vector4));
+			}
+		}
+
+		if (desc.normal == NormalEncoding::kNone) {
+			for (size_t i = 0; i < count; ++i) {
+				vertices[i].normal = { 0.0f,0.0f,0.0f };
+			}
+		} else {
+
+			const uint8_t* normal = bytes + stride * begin + layout.GetNormalOffset();
+
+			if (desc.normal == NormalEncoding::kOctahedral16) {
+				DecodeNormalsOctahedral16(vertices, normal, stride, count);
+			} else {
+				for (size_t i = 0; i < count; ++i) {
+					std::memcpy(&vertices[i].normal, normal + stride * i, sizeof(Vector3));
+				}
+			}
+
+		}
+
+		if (desc.texcoord == TexcoordEncoding::kNone) {
+			for (size_t i = 0; i < count; ++i) {
+				vertices[i].texcoord = { 0.0f,0.0f };
+			}
+		} else {
+
+			const uint8_t* texcoord = bytes + stride * begin + layout.GetTexcoordOffset();
+
+			if (desc.texcoord == TexcoordEncoding::kFloat16) {
+				DecodeTexcoordsFloat16(vertices, texcoord, stride, count);
+			} else {
+				for (size_t i = 0; i < count; ++i) {
+					std::memcpy(&vertices[i].texcoord, texcoord + stride * i, sizeof(Vector2));
+				}
+			}
+
+		}
+
+	});
+
+}
+
+VertexEncodingError MeasureVertexEncodingError(const MeshVertex* vertices, const void* encoded, size_t vertexCount, const VertexLayout& layout, const VertexQuantization& quantization) {
+
+	VertexEncodingError error = {};
+
+	if (vertexCount == 0) {
+		return error;
+	}
+
+	std::vector<MeshVertex> decoded(vertexCount);
+
+	DecodeVertices(decoded.data(), encoded, vertexCount, layout, quantization);
+
+	const float kRadianToDegree = 180.0f / 3.14159265358979f;
+
+	double positionErrorSum = 0.0;
+	double normalErrorSum = 0.0;
+
+	size_t normalCount = 0;
+
+	for (size_t i = 0; i < vertexCount; ++i) {
+
+		const MeshVertex& original = vertices[i];
+		const MeshVertex& result = decoded[i];
+
+		float dx = result.position.x - original.position.x;
+		float dy = result.position.y - original.position.y;
+		float dz = result.position.z - original.position.z;
+
+		float positionError = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+		error.maxPositionError = (std::max)(error.maxPositionError, positionError);
+
+		positionErrorSum += static_cast<double>(positionError) * positionError;
+
+		//長さのない法線は比べない
+		float length = std::sqrt(original.normal.x * original.normal.x + original.normal.y * original.normal.y + original.normal.z * original.normal.z);
+
+		if (layout.GetDesc().normal != NormalEncoding::kNone && length > 0.0f) {
+
+			float cosine = (original.normal.x * result.normal.x + original.normal.y * result.normal.y + original.normal.z * result.normal.z) / length;
+
+			float resultLength = std::sqrt(result.normal.x * result.normal.x + result.normal.y * result.normal.y + result.normal.z * result.normal.z);
+
+			if (resultLength > 0.0f) {
+				cosine /= resultLength;
+			}
+
+			float angle = std::acos(std::clamp(cosine, -1.0f, 1.0f)) * kRadianToDegree;
+
+			error.maxNormalError = (std::max)(error.maxNormalError, angle);
+
+			normalErrorSum += angle;
+
+			++normalCount;
+
+		}
+
+		if (layout.GetDesc().texcoord != TexcoordEncoding::kNone) {
+			error.maxTexcoordError = (std::max)(error.maxTexcoordError, std::fabs(result.texcoord.x - original.texcoord.x));
+			error.maxTexcoordError = (std::max)(error.maxTexcoordError, std::fabs(result.texcoord.y - original.texcoord.y));
+		}
+
+	}
+
+	error.rmsPositionError = static_cast<float>(std::sqrt(positionErrorSum / vertexCount));
+
+	if (normalCount > 0) {
+		error.averageNormalError = static_cast<float>(normalErrorSum / normalCount);
+	}
+
+	return error;
+
+}
+
+uint16_t FloatToHalf(float value) {
+
+	uint32_t bits = FloatBits(value);
+
+	uint32_t sign = bits & 0x80000000u;
+
+	bits ^= sign;
+
+	uint32_t result;
+
+	if (bits >= 0x47800000u) {
+
+		//halfで表せない大きさは無限大、NaNはNaN
+		result = bits > 0x7f800000u ? 0x7e00u : 0x7c00u;
+
+	} else if (bits < 0x38800000u) {
+
+		//非正規化数になる範囲は浮動小数点の足し算で丸める
+		result = FloatBits(BitsFloat(bits) + BitsFloat(0x3f000000u)) - 0x3f000000u;
+
+	} else {
+
+		uint32_t odd = (bits >> 13) & 1;
+
+		bits += 0xfffu - (112u << 23);
+		bits += odd;
+
+		result = bits >> 13;
+
+	}
+
+	return static_cast<uint16_t>(result | (sign >> 16));
+
+}
+
+float HalfToFloat(uint16_t value) {
+
+	const uint32_t kExponentMask = 0x7c00u << 13;
+
+	uint32_t bits = (value & 0x7fffu) << 13;
+
+	uint32_t exponent = bits & kExponentMask;
+
+	bits += 112u << 23;
+
+	if (exponent == kExponentMask) {
+		bits += 112u << 23;
+	} else if (exponent == 0) {
+		bits = FloatBits(BitsFloat(bits + (1u << 23)) - BitsFloat(113u << 23));
+	}
+
+	return BitsFloat(bits | ((value & 0x8000u) << 16));
+
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "MathTypes.h"
+#include "MeshImporter.h"
+#include "JobSystem.h"
+
+//位置の持ち方
+enum class PositionEncoding : uint32_t {
+
+	//float4そのまま(16バイト)
+	kFloat32,
+
+	//メッシュのAABBで0～1に正規化した16ビットのUNORM(8バイト。wは常に1)
+	kUnorm16,
+
+};
+
+//法線の持ち方
+enum class NormalEncoding : uint32_t {
+
+	kNone,
+
+	//float3そのまま(12バイト)
+	kFloat32,
+
+	//八面体に展開した2成分の16ビットSNORM(4バイト)
+	kOctahedral16,
+
+};
+
+//UVの持ち方
+enum class TexcoordEncoding : uint32_t {
+
+	kNone,
+
+	//float2そのまま(8バイト)
+	kFloat32,
+
+	//half2(4バイト)
+	kFloat16,
+
+};
+
+//頂点の各要素をどう持つか
+struct VertexLayoutDesc {
+
+	PositionEncoding position;
+	NormalEncoding normal;
+	TexcoordEncoding texcoord;
+
+};
+
+//MeshVertexと同じ並び(36バイト)
+const VertexLayoutDesc kFullVertexLayoutDesc = { PositionEncoding::kFloat32, NormalEncoding::kFloat32, TexcoordEncoding::kFloat32 };
+
+//量子化した並び(16バイト)
+const VertexLayoutDesc kCompactVertexLayoutDesc = { PositionEncoding::kUnorm16, NormalEncoding::kOctahedral16, TexcoordEncoding::kFloat16 };
+
+//入力レイアウトの要素の形式(DXGI_FORMATに対応する)
+enum class VertexElementFormat : uint32_t {
+
+	kFloat32x2,
+	kFloat32x3,
+	kFloat32x4,
+	kFloat16x2,
+	kUnorm16x4,
+	kSnorm16x2,
+
+};
+
+struct VertexElement {
+
+	const char* semanticName;
+	uint32_t semanticIndex;
+	VertexElementFormat format;
+	uint32_t offset;
+
+};
+
+const uint32_t kMaxVertexElements = 8;
+
+//VertexLayoutDescから各要素の位置と頂点の大きさを決める(要素は4バイト境界に置く)
+class VertexLayout {
+
+public:
+
+	VertexLayout();
+
+	explicit VertexLayout(const VertexLayoutDesc& desc);
+
+	const VertexLayoutDesc& GetDesc() const { return desc_; }
+
+	uint32_t GetStride() const { return stride_; }
+
+	uint32_t GetElementCount() const { return elementCount_; }
+
+	const VertexElement& GetElement(uint32_t index) const { return elements_[index]; }
+
+	//要素がなければUINT32_MAX
+	uint32_t GetPositionOffset() const { return positionOffset_; }
+
+	uint32_t GetNormalOffset() const { return normalOffset_; }
+
+	uint32_t GetTexcoordOffset() const { return texcoordOffset_; }
+
+private:
+
+	uint32_t AddElement(const char* semanticName, VertexElementFormat format);
+
+	VertexLayoutDesc desc_;
+
+	VertexElement elements_[kMaxVertexElements];
+
+	uint32_t elementCount_ = 0;
+
+	uint32_t stride_ = 0;
+
+	uint32_t positionOffset_ = UINT32_MAX;
+	uint32_t normalOffset_ = UINT32_MAX;
+	uint32_t texcoordOffset_ = UINT32_MAX;
+
+};
+
+//量子化した位置を戻す変換(position = quantized * scale + offset。quantizedは0～1)
+struct VertexQuantization {
+
+	Vector3 offset;
+	Vector3 scale;
+
+};
+
+//頂点を囲む範囲から量子化の変換を求める(メッシュごとに1つ)
+VertexQuantization ComputeVertexQuantization(const MeshVertex* vertices, size_t vertexCount);
+
+//量子化を戻す行列(ワールド行列の前に掛ければ、シェーダーで戻さずに済む)
+Matrix4x4 MakeDequantizeMatrix(const VertexQuantization& quantization);
+
+//MeshVertexをlayoutの形に詰める(destinationはGetStride()*vertexCountバイト)
+void EncodeVertices(void* destination, const MeshVertex* vertices, size_t vertexCount, const VertexLayout& layout, const VertexQuantization& quantization, JobSystem* jobSystem = nullptr);
+
+//layoutの形からMeshVertexに戻す(持っていない要素は0になる)
+void DecodeVertices(MeshVertex* destination, const void* source, size_t vertexCount, const VertexLayout& layout, const VertexQuantization& quantization, JobSystem* jobSystem = nullptr);
+
+//詰めたことによる誤差
+struct VertexEncodingError {
+
+	//位置のずれ(メッシュの単位)
+	float maxPositionError;
+	float rmsPositionError;
+
+	//法線の角度のずれ(度)
+	float maxNormalError;
+	float averageNormalError;
+
+	//UVの各成分のずれ
+	float maxTexcoordError;
+
+};
+
+//詰めた頂点を戻して元の頂点と比べる
+VertexEncodingError MeasureVertexEncodingError(const MeshVertex* vertices, const void* encoded, size_t vertexCount, const VertexLayout& layout, const VertexQuantization& quantization);
+
+//floatとhalfの変換(最近接偶数への丸め。範囲外は無限大、NaNはNaNのまま)
+uint16_t FloatToHalf(float value);
+
+float HalfToFloat(uint16_t value);
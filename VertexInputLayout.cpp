@@ -0,0 +1,48 @@
+#include "VertexInputLayout.h"
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> MakeInputElementDescs(const VertexLayout& layout) {
+
+	std::vector<D3D12_INPUT_ELEMENT_DESC> descs(layout.GetElementCount());
+
+	for (uint32_t i = 0; i < layout.GetElementCount(); ++i) {
+
+		const VertexElement& element = layout.GetElement(i);
+
+		D3D12_INPUT_ELEMENT_DESC& desc = descs[i];
+
+		desc = {};
+
+		desc.SemanticName = element.semanticName;
+
+		desc.SemanticIndex = element.semanticIndex;
+
+		desc.AlignedByteOffset = element.offset;
+
+		desc.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+
+		switch (element.format) {
+		case VertexElementFormat::kFloat32x2:
+			desc.Format = DXGI_FORMAT_R32G32_FLOAT;
+			break;
+		case VertexElementFormat::kFloat32x3:
+			desc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
+			break;
+		case VertexElementFormat::kFloat32x4:
+			desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+			break;
+		case VertexElementFormat::kFloat16x2:
+			desc.Format = DXGI_FORMAT_R16G16_FLOAT;
+			break;
+		case VertexElementFormat::kUnorm16x4:
+			desc.Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+			break;
+		case VertexElementFormat::kSnorm16x2:
+			desc.Format = DXGI_FORMAT_R16G16_SNORM;
+			break;
+		}
+
+	}
+
+	return descs;
+
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <d3d12.h>
+#include <vector>
+#include "VertexFormat.h"
+
+//VertexLayoutからD3D12の入力レイアウトを作る(D3D12に依存する部分だけをVertexFormatから分けている)
+
+//layoutに合わせた入力レイアウトの要素を作る
+std::vector<D3D12_INPUT_ELEMENT_DESC> MakeInputElementDescs(const VertexLayout& layout);
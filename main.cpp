@@ -2,6 +2,9 @@
 #include <cstdint>
 #include <string>
 #include <format>
+#include <vector>
+#include <cstring>
+#include <cmath>
 #include <d3d12.h>
 #include <dxgi1_6.h>
 #include <cassert>
@@ -10,6 +13,37 @@
 #include "externals/imgui/imgui.h"
 #include "externals/imgui/imgui_impl_dx12.h"
 #include "externals/imgui/imgui_impl_win32.h"
+#include "PipelineStateCache.h"
+#include "AsyncPipelineCompiler.h"
+#include "DescriptorManager.h"
+#include "MathTypes.h"
+#include "MaterialTable.h"
+#include "RenderGraph.h"
+#include "ResourceStateTracker.h"
+#include "StateCachedCommandList.h"
+#include "JobSystem.h"
+#include "DrawQueue.h"
+#include "FrustumCulling.h"
+#include "OcclusionCulling.h"
+#include "Bvh.h"
+#include "Picking.h"
+#include "EntityWorld.h"
+#include "SceneComponents.h"
+#include "MeshImporter.h"
+#include "BinaryMesh.h"
+#include "MeshOptimizer.h"
+#include "VertexFormat.h"
+#include "VertexInputLayout.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
+#include "Texture.h"
+#include "TextureLoader.h"
+#include "MipGenerator.h"
+#include "BlockCompression.h"
+#include "TextureUploader.h"
+#include "TextureStreaming.h"
+#include "AssetArchive.h"
+#include "AsyncLoader.h"
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -18,51 +52,12 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg
 #pragma comment(lib,"dxguid.lib")
 #pragma comment(lib,"dxcompiler.lib")
 
-struct Vector3 {
+//ルート定数で渡す描画ごとのデータ
+struct DrawConstants {
 
-	float x;
-	float y;
-	float z;
-
-};
-
-struct Vector4 {
-
-	float x;
-	float y;
-	float z;
-	float w;
-
-};
-
-struct Matrix4x4 {
-
-	float m[4][4];
-
-};
-
-struct Transform {
-
-	Vector3 scale;
-	Vector3 rotate;
-	Vector3 translate;
-
-};
-
-//Transform変数の作成
-Transform transform{
-
-	{1.0f,1.0f,1.0f},
-	{0.0f,0.0f,0.0f},
-	{0.0f,0.0f,0.0f}
-
-};
-
-Transform cameraTransform{
-
-	{1.0f,1.0f,1.0f},
-	{0.0f,0.0f,0.0f},
-	{0.0f,0.0f,-5.0f}
+	uint32_t objectIndex;
+	uint32_t materialIndex;
+	uint32_t color;
 
 };
 
@@ -250,6 +245,49 @@ ID3D12Resource* CreateBufferResource(ID3D12Device* device, size_t size) {
 
 }
 
+//テクスチャのSRVを作る(minLodより細かい段は読まない)
+void CreateTextureShaderResourceView(ID3D12Device* device, ID3D12Resource* resource, const TextureData& texture, float minLod, D3D12_CPU_DESCRIPTOR_HANDLE handle) {
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+
+	srvDesc.Format = ToDxgiFormat(texture.format);
+
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+
+	srvDesc.Texture2D.MipLevels = static_cast<UINT>(texture.mips.size());
+
+	srvDesc.Texture2D.ResourceMinLODClamp = minLod;
+
+	device->CreateShaderResourceView(resource, &srvDesc, handle);
+
+}
+
+//アーカイブからアセットの中身を取り出す(なければnullptr)
+//そのまま置いたものはマップした中身を返し、圧縮したものはbufferに展開して返す
+const uint8_t* LoadAsset(const AssetArchive& archive, const char* name, std::vector<uint8_t>& buffer, size_t& size, JobSystem* jobSystem) {
+
+	uint32_t index = archive.Find(name);
+
+	if (index == AssetArchive::kInvalidIndex) {
+		return nullptr;
+	}
+
+	size = static_cast<size_t>(archive.GetSize(index));
+
+	if (!archive.IsCompressed(index)) {
+		return archive.GetMappedData(index);
+	}
+
+	if (!archive.ReadAll(index, buffer, jobSystem)) {
+		return nullptr;
+	}
+
+	return buffer.data();
+
+}
+
 ID3D12DescriptorHeap* CreateDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE heapType, UINT numDescriptors, bool shaderVisible) {
 
 	ID3D12DescriptorHeap* DescriptorHeap = nullptr;
@@ -271,6 +309,51 @@ ID3D12DescriptorHeap* CreateDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTO
 
 }
 
+//深度バッファの作成(reversed-Zなので0でクリアする)
+ID3D12Resource* CreateDepthStencilTextureResource(ID3D12Device* device, int32_t width, int32_t height) {
+
+	D3D12_RESOURCE_DESC resourceDesc{};
+
+	resourceDesc.Width = width;
+
+	resourceDesc.Height = height;
+
+	resourceDesc.MipLevels = 1;
+
+	resourceDesc.DepthOrArraySize = 1;
+
+	resourceDesc.Format = DXGI_FORMAT_D32_FLOAT;
+
+	resourceDesc.SampleDesc.Count = 1;
+
+	resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+
+	resourceDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+
+	D3D12_HEAP_PROPERTIES heapProperties{};
+
+	heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+	D3D12_CLEAR_VALUE depthClearValue{};
+
+	depthClearValue.DepthStencil.Depth = 0.0f;
+
+	depthClearValue.Format = DXGI_FORMAT_D32_FLOAT;
+
+	ID3D12Resource* resource = nullptr;
+
+	HRESULT hr = device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE,
+
+		&resourceDesc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &depthClearValue,
+
+		IID_PPV_ARGS(&resource));
+
+	assert(SUCCEEDED(hr));
+
+	return resource;
+
+}
+
 //単位行列の作成
 Matrix4x4 MakeIdentity4x4() {
 	Matrix4x4 result;
@@ -548,7 +631,8 @@ Matrix4x4 Inverse(const Matrix4x4& m) {
 	return result;
 }
 
-//透視投影行列
+//透視投影行列(reversed-Z: 近クリップ面が深度1、遠クリップ面が深度0になる)
+//浮動小数の深度バッファと組み合わせると遠くの精度が大きく上がる
 Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip) {
 
 	float f = 1.0f / std::tan(fovY / 2.0f);
@@ -566,18 +650,51 @@ Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip
 
 	perspectiveMatrix.m[2][0] = 0;
 	perspectiveMatrix.m[2][1] = 0;
-	perspectiveMatrix.m[2][2] = farClip / (farClip - nearClip);
+	perspectiveMatrix.m[2][2] = nearClip / (nearClip - farClip);
 	perspectiveMatrix.m[2][3] = 1;
 
 	perspectiveMatrix.m[3][0] = 0;
 	perspectiveMatrix.m[3][1] = 0;
-	perspectiveMatrix.m[3][2] = (-nearClip * farClip) / (farClip - nearClip);
+	perspectiveMatrix.m[3][2] = (nearClip * farClip) / (farClip - nearClip);
 	perspectiveMatrix.m[3][3] = 0;
 
 	return perspectiveMatrix;
 
 }
 
+//レンダーグラフのバリアをトラッカーに渡して1回で積む
+void SubmitRenderGraphBarriers(ResourceStateTracker& resourceStateTracker, ID3D12Resource* const* resources, const RenderGraphBarrier* barriers, size_t count) {
+
+	for (size_t i = 0; i < count; ++i) {
+
+		if (barriers[i].type == RenderGraphBarrierType::kAliasing) {
+
+			ID3D12Resource* before = barriers[i].aliasBefore != RenderGraph::kInvalidResource ? resources[barriers[i].aliasBefore] : nullptr;
+
+			resourceStateTracker.AliasingBarrier(before, resources[barriers[i].resource]);
+
+			continue;
+
+		}
+
+		D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+
+		if (barriers[i].flag == RenderGraphBarrierFlag::kBeginOnly) {
+			flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+		} else if (barriers[i].flag == RenderGraphBarrierFlag::kEndOnly) {
+			flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+		}
+
+		//遷移前の状態も渡し、このリストで初めて使うリソース(分割バリアの開始から使うものも)をそこから追いかけさせる
+		resourceStateTracker.TransitionResource(resources[barriers[i].resource], static_cast<D3D12_RESOURCE_STATES>(barriers[i].stateBefore),
+			static_cast<D3D12_RESOURCE_STATES>(barriers[i].stateAfter), flags);
+
+	}
+
+	resourceStateTracker.FlushBarriers();
+
+}
+
 int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 #pragma region Windowの生成
@@ -773,6 +890,37 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	assert(SUCCEEDED(hr));
 
+	//記録の最初に必要な状態への遷移を、実行直前に積むためのコマンドリスト
+	ID3D12CommandAllocator* barrierCommandAllocator = nullptr;
+
+	hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&barrierCommandAllocator));
+
+	assert(SUCCEEDED(hr));
+
+	ID3D12GraphicsCommandList* barrierCommandList = nullptr;
+
+	hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, barrierCommandAllocator, nullptr,
+		IID_PPV_ARGS(&barrierCommandList));
+
+	assert(SUCCEEDED(hr));
+
+	hr = barrierCommandList->Close();
+
+	assert(SUCCEEDED(hr));
+
+	ResourceStateTracker resourceStateTracker;
+
+	resourceStateTracker.Initialize(commandList);
+
+	//同じ状態の設定を省くためのラッパー
+	D3D12GraphicsCommandSink commandSink;
+
+	commandSink.Initialize(commandList);
+
+	StateCachedCommandList stateCachedCommandList;
+
+	stateCachedCommandList.Initialize(&commandSink);
+
 #pragma endregion
 
 #pragma region SwapChainの生成
@@ -803,7 +951,12 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	ID3D12DescriptorHeap* rtvDescriptorHeap = CreateDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 2, false);
 
-	ID3D12DescriptorHeap* srvDescriptorHeap = CreateDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 128, true);
+	//SRVのヒープは常駐スロットとフレームごとのリングに分けて管理する
+	DescriptorManager descriptorManager;
+
+	descriptorManager.Initialize(device, 1024, 1024, 1024);
+
+	ID3D12DescriptorHeap* srvDescriptorHeap = descriptorManager.GetHeap();
 
 	ID3D12Resource* swapChainResources[2] = { nullptr };
 
@@ -833,6 +986,30 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	device->CreateRenderTargetView(swapChainResources[1], &rtvDesc, rtvHandles[1]);
 
+	//深度バッファとDSV
+	ID3D12Resource* depthStencilResource = CreateDepthStencilTextureResource(device, kClientWidth, kClientHeight);
+
+	ID3D12DescriptorHeap* dsvDescriptorHeap = CreateDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1, false);
+
+	D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc{};
+
+	dsvDesc.Format = DXGI_FORMAT_D32_FLOAT;
+
+	dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+
+	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = dsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+
+	device->CreateDepthStencilView(depthStencilResource, &dsvDesc, dsvHandle);
+
+	//コマンドリストをまたいだリソースの状態
+	ResourceStateTable resourceStateTable;
+
+	resourceStateTable.Register(swapChainResources[0], D3D12_RESOURCE_STATE_PRESENT);
+
+	resourceStateTable.Register(swapChainResources[1], D3D12_RESOURCE_STATE_PRESENT);
+
+	resourceStateTable.Register(depthStencilResource, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
 	ID3D12Fence* fence = nullptr;
 
 	uint64_t fenceValue = 0;
@@ -863,37 +1040,110 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	assert(SUCCEEDED(hr));
 
-	D3D12_ROOT_SIGNATURE_DESC descriptionRootSignature{};
+	//ルートシグネチャ1.1が使えるか確認する
+	D3D12_FEATURE_DATA_ROOT_SIGNATURE rootSignatureFeature{};
+
+	rootSignatureFeature.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
+
+	hr = device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &rootSignatureFeature, sizeof(rootSignatureFeature));
+
+	assert(SUCCEEDED(hr) && rootSignatureFeature.HighestVersion == D3D_ROOT_SIGNATURE_VERSION_1_1);
 
-	descriptionRootSignature.Flags =
+	D3D12_VERSIONED_ROOT_SIGNATURE_DESC descriptionRootSignature{};
+
+	descriptionRootSignature.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
+
+	descriptionRootSignature.Desc_1_1.Flags =
 
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
-	D3D12_ROOT_PARAMETER rootParameters[2] = {};
+	D3D12_ROOT_PARAMETER1 rootParameters[4] = {};
 
-	rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+	//全マテリアルのテーブル(StructuredBuffer、実行中は書き換えないのでSTATICにしてドライバに最適化させる)
+	rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
 
 	rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
 
-	rootParameters[0].Descriptor.ShaderRegister = 0;
+	rootParameters[0].Descriptor.ShaderRegister = 1;
 
-	rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+	rootParameters[0].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE;
+
+	//オブジェクトごとの行列の配列(StructuredBuffer)
+	rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
 
 	rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
 
 	rootParameters[1].Descriptor.ShaderRegister = 0;
 
-	descriptionRootSignature.pParameters = rootParameters;
+	rootParameters[1].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE;
+
+	//描画ごとのインデックスはルート定数で渡す
+	rootParameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+
+	rootParameters[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+	rootParameters[2].Constants.ShaderRegister = 1;
+
+	rootParameters[2].Constants.Num32BitValues = sizeof(DrawConstants) / sizeof(uint32_t);
+
+	//ヒープ全体を1つのテーブルとして見せ、テクスチャはマテリアルが持つインデックスで参照する
+	D3D12_DESCRIPTOR_RANGE1 bindlessRange[1] = {};
+
+	bindlessRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+
+	bindlessRange[0].NumDescriptors = UINT_MAX;
+
+	bindlessRange[0].BaseShaderRegister = 0;
+
+	bindlessRange[0].RegisterSpace = 1;
 
-	descriptionRootSignature.NumParameters = _countof(rootParameters);
+	//未使用のスロットがあってもよいようにVOLATILEにする
+	bindlessRange[0].Flags = D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE;
+
+	bindlessRange[0].OffsetInDescriptorsFromTableStart = 0;
+
+	rootParameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+
+	rootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+	rootParameters[3].DescriptorTable.pDescriptorRanges = bindlessRange;
+
+	rootParameters[3].DescriptorTable.NumDescriptorRanges = _countof(bindlessRange);
+
+	descriptionRootSignature.Desc_1_1.pParameters = rootParameters;
+
+	descriptionRootSignature.Desc_1_1.NumParameters = _countof(rootParameters);
+
+	//テクスチャは異方性フィルタで繰り返して読む
+	D3D12_STATIC_SAMPLER_DESC staticSamplers[1] = {};
+
+	staticSamplers[0].Filter = D3D12_FILTER_ANISOTROPIC;
+
+	staticSamplers[0].AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+
+	staticSamplers[0].AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+
+	staticSamplers[0].AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+
+	staticSamplers[0].MaxAnisotropy = 8;
+
+	staticSamplers[0].ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+
+	staticSamplers[0].MaxLOD = D3D12_FLOAT32_MAX;
+
+	staticSamplers[0].ShaderRegister = 0;
+
+	staticSamplers[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+	descriptionRootSignature.Desc_1_1.pStaticSamplers = staticSamplers;
+
+	descriptionRootSignature.Desc_1_1.NumStaticSamplers = _countof(staticSamplers);
 
 	ID3DBlob* signatureBlob = nullptr;
 
 	ID3DBlob* errorBlob = nullptr;
 
-	hr = D3D12SerializeRootSignature(&descriptionRootSignature,
-
-		D3D_ROOT_SIGNATURE_VERSION_1, &signatureBlob, &errorBlob);
+	hr = D3D12SerializeVersionedRootSignature(&descriptionRootSignature, &signatureBlob, &errorBlob);
 
 	if (FAILED(hr)) {
 
@@ -913,21 +1163,23 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	assert(SUCCEEDED(hr));
 
-	D3D12_INPUT_ELEMENT_DESC inputElementDescs[1] = {};
+	//PSOキャッシュの生成(前回の実行で作ったPSOを読み込む)
+	PipelineStateCache pipelineStateCache;
 
-	inputElementDescs[0].SemanticName = "POSITION";
+	pipelineStateCache.Initialize(device, L"pipeline.cache");
 
-	inputElementDescs[0].SemanticIndex = 0;
+	pipelineStateCache.RegisterRootSignature(rootSignature, signatureBlob);
 
-	inputElementDescs[0].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	//GPUに置く頂点は量子化した16バイトの形にする(Object3d.VS.hlslの入力と合わせること)
+	VertexLayout vertexLayout(kCompactVertexLayoutDesc);
 
-	inputElementDescs[0].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+	std::vector<D3D12_INPUT_ELEMENT_DESC> inputElementDescs = MakeInputElementDescs(vertexLayout);
 
 	D3D12_INPUT_LAYOUT_DESC inputLayOutDesc{};
 
-	inputLayOutDesc.pInputElementDescs = inputElementDescs;
+	inputLayOutDesc.pInputElementDescs = inputElementDescs.data();
 
-	inputLayOutDesc.NumElements = _countof(inputElementDescs);
+	inputLayOutDesc.NumElements = static_cast<UINT>(inputElementDescs.size());
 
 	D3D12_BLEND_DESC blendDesc{};
 
@@ -971,6 +1223,19 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	graphicsPipeLineStateDesc.RasterizerState = rasterizerDesc;
 
+	//reversed-Zなので手前ほど深度が大きい
+	D3D12_DEPTH_STENCIL_DESC depthStencilDesc{};
+
+	depthStencilDesc.DepthEnable = true;
+
+	depthStencilDesc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+
+	depthStencilDesc.DepthFunc = D3D12_COMPARISON_FUNC_GREATER_EQUAL;
+
+	graphicsPipeLineStateDesc.DepthStencilState = depthStencilDesc;
+
+	graphicsPipeLineStateDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+
 	graphicsPipeLineStateDesc.NumRenderTargets = 1;
 
 	graphicsPipeLineStateDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
@@ -983,263 +1248,1139 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	graphicsPipeLineStateDesc.SampleMask = D3D12_DEFAULT_SAMPLE_MASK;
 
-	ID3D12PipelineState* graphicsPipelineState = nullptr;
+	ID3D12PipelineState* graphicsPipelineState = pipelineStateCache.GetGraphicsPipelineState(graphicsPipeLineStateDesc);
 
-	hr = device->CreateGraphicsPipelineState(&graphicsPipeLineStateDesc,
+	assert(graphicsPipelineState != nullptr);
 
-		IID_PPV_ARGS(&graphicsPipelineState));
+	//深度プリパス用のPSO(PSなし、深度だけ書く)
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC depthPrepassPipelineStateDesc = graphicsPipeLineStateDesc;
 
-	assert(SUCCEEDED(hr));
+	depthPrepassPipelineStateDesc.PS = {};
 
-	ID3D12Resource* vertexResource = CreateBufferResource(device, sizeof(Vector4) * 3);
+	depthPrepassPipelineStateDesc.NumRenderTargets = 0;
 
-	D3D12_VERTEX_BUFFER_VIEW vertexBufferView{};
+	depthPrepassPipelineStateDesc.RTVFormats[0] = DXGI_FORMAT_UNKNOWN;
 
-	vertexBufferView.BufferLocation = vertexResource->GetGPUVirtualAddress();
+	ID3D12PipelineState* depthPrepassPipelineState = pipelineStateCache.GetGraphicsPipelineState(depthPrepassPipelineStateDesc);
 
-	vertexBufferView.SizeInBytes = sizeof(Vector4) * 3;
+	assert(depthPrepassPipelineState != nullptr);
 
-	vertexBufferView.StrideInBytes = sizeof(Vector4);
+	//プリパスの後の本描画は深度が一致した画素だけシェーディングする
+	//同じVSで同じ頂点を変換するので、プリパスと深度は完全に一致する
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC depthEqualPipelineStateDesc = graphicsPipeLineStateDesc;
 
-	Vector4* vertexData = nullptr;
+	depthEqualPipelineStateDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
 
-	vertexResource->Map(0, nullptr, reinterpret_cast<void**>(&vertexData));
+	depthEqualPipelineStateDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_EQUAL;
 
-	vertexData[0] = { -0.5f,-0.5f,0.0f,1.0f };
+	ID3D12PipelineState* depthEqualPipelineState = pipelineStateCache.GetGraphicsPipelineState(depthEqualPipelineStateDesc);
 
-	vertexData[1] = { 0.0f,0.5f,0.0f,1.0f };
+	assert(depthEqualPipelineState != nullptr);
 
-	vertexData[2] = { 0.5f,-0.5f,0.0f,1.0f };
+	bool isDepthPrepassEnabled = true;
 
-	ID3D12Resource* materialResource = CreateBufferResource(device, sizeof(Vector4) * 3);
+	//バリエーションのPSOはワーカースレッドで作成し、完成するまでは通常のPSOで描画する
+	AsyncPipelineCompiler asyncPipelineCompiler;
 
-	Vector4* materialData = nullptr;
+	asyncPipelineCompiler.Initialize(&pipelineStateCache, 1);
 
-	materialResource->Map(0, nullptr, reinterpret_cast<void**>(&materialData));
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC wireframePipelineStateDesc = graphicsPipeLineStateDesc;
 
-	*materialData = Vector4(1.0f, 0.0f, 0.0f, 1.0f);
+	wireframePipelineStateDesc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
 
-	ID3D12Resource* wvpResource = CreateBufferResource(device, sizeof(Matrix4x4));
+	wireframePipelineStateDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
 
-	Matrix4x4* wvpData = nullptr;
+	uint64_t wireframePipelineHash = 0;
 
-	wvpResource->Map(0, nullptr, reinterpret_cast<void**>(&wvpData));
+	bool isWireframe = false;
 
-	*wvpData = MakeIdentity4x4();
+	//LODを粗くしてよい画面上の誤差(ピクセル)
+	float lodPixelError = 1.0f;
 
-	D3D12_VIEWPORT viewport{};
+	bool isMeshletCullingEnabled = true;
 
-	viewport.Width = kClientWidth;
+	//並列処理用のワーカースレッド(メッシュの読み込みでも使う)
+	JobSystem jobSystem;
 
-	viewport.Height = kClientHeight;
+	jobSystem.Initialize();
 
-	viewport.TopLeftX = 0;
+	//ファイルの非同期の読み込み(完了のコールバックはフレームの初めに呼ぶ)
+	AsyncLoader asyncLoader;
 
-	viewport.TopLeftY = 0;
+	asyncLoader.Initialize({}, &jobSystem);
 
-	viewport.MinDepth = 0.0f;
+	//焼き込み済みのアセットをまとめたアーカイブ(あればバラバラのファイルより先に使う)
+	const char* kAssetArchivePath = "resources/assets.pak";
 
-	viewport.MaxDepth = 1.0f;
+	AssetArchive assetArchive;
 
-	D3D12_RECT scissorRect{};
+	bool isAssetArchiveOpen = assetArchive.Open(kAssetArchivePath);
 
-	scissorRect.left = 0;
+	//焼き込み済みのメッシュがあればマップしてそのまま使う
+	//なければOBJを読み込んで次回のために焼き込み、それも読めなければ三角形を使う
+	BinaryMesh binaryMesh;
 
-	scissorRect.right = kClientWidth;
+	MeshData meshData;
 
-	scissorRect.top = 0;
+	MeshView meshView{};
 
-	IMGUI_CHECKVERSION();
+	//アーカイブで圧縮されていた時の展開先(binaryMeshが使い終わるまで残す)
+	std::vector<uint8_t> meshAssetBuffer;
 
-	ImGui::CreateContext();
+	size_t meshAssetSize = 0;
 
-	ImGui::StyleColorsDark();
+	const uint8_t* meshAsset = isAssetArchiveOpen ? LoadAsset(assetArchive, "model.mesh", meshAssetBuffer, meshAssetSize, &jobSystem) : nullptr;
 
-	ImGui_ImplWin32_Init(hwnd);
+	//ピッキングと遮蔽物のラスタライズはCPUでインデックスから頂点を引くので、読み込む時に1度だけ範囲を確かめておく
+	if ((meshAsset != nullptr && binaryMesh.OpenMemory(meshAsset, meshAssetSize, kBinaryMeshVerifyIndices)) || binaryMesh.Open("resources/model.mesh", kBinaryMeshVerifyIndices)) {
 
-	ImGui_ImplDX12_Init(device,
+		meshView = binaryMesh.GetView();
 
-		swapChainDesc.BufferCount,
+	} else if (ImportMesh("resources/model.obj", meshData, &jobSystem)) {
 
-		rtvDesc.Format,
+		//焼き込む前に三角形と頂点の順を最適化しておく
+		VertexCacheStatistics cacheBefore = AnalyzeVertexCache(meshData.indices.data(), meshData.indices.size(), meshData.vertices.size());
 
-		srvDescriptorHeap,
+		OptimizeMesh(meshData);
 
-		srvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
+		VertexCacheStatistics cacheAfter = AnalyzeVertexCache(meshData.indices.data(), meshData.indices.size(), meshData.vertices.size());
 
-		srvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+		Log(std::format("Optimize mesh, ACMR:{:.3f}->{:.3f}, ATVR:{:.3f}->{:.3f}\n", cacheBefore.acmr, cacheAfter.acmr, cacheBefore.atvr, cacheAfter.atvr));
 
-	MSG msg{};
+		//粗い段を作ってインデックスの後ろに足す
+		GenerateMeshLods(meshData);
 
-	while (msg.message != WM_QUIT) {
+		for (size_t i = 0; i < meshData.lods.size(); ++i) {
+			Log(std::format("Mesh LOD{}, triangles:{}, error:{:.5f}\n", i, meshData.lods[i].indexCount / 3, meshData.lods[i].error));
+		}
 
-		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+		//LOD0をメッシュレットに分ける(LOD0のインデックスはメッシュレットの順になる)
+		BuildMeshlets(meshData);
 
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
+		Log(std::format("Meshlets:{}, vertices:{}\n", meshData.meshlets.size(), meshData.meshletVertices.size()));
 
-		} else {
+		WriteBinaryMesh("resources/model.mesh", meshData);
 
-			ImGui_ImplDX12_NewFrame();
+		meshView = MakeMeshView(meshData);
 
-			ImGui_ImplWin32_NewFrame();
+	} else {
 
-			ImGui::NewFrame();
+		meshData.vertices = {
+			{ { -0.5f,-0.5f,0.0f,1.0f }, { 0.0f,0.0f,-1.0f }, { 0.0f,1.0f } },
+			{ { 0.0f,0.5f,0.0f,1.0f }, { 0.0f,0.0f,-1.0f }, { 0.5f,0.0f } },
+			{ { 0.5f,-0.5f,0.0f,1.0f }, { 0.0f,0.0f,-1.0f }, { 1.0f,1.0f } },
+		};
 
-			//各種行列の計算
-			Matrix4x4 worldMatrix = MakeAffinMatrix(transform.scale, transform.rotate, transform.translate);
+		meshData.indices = { 0, 1, 2 };
 
-			Matrix4x4 cameraMatrix = MakeAffinMatrix(cameraTransform.scale, cameraTransform.rotate, cameraTransform.translate);
+		meshData.bounds = { { -0.5f,-0.5f,0.0f }, { 0.5f,0.5f,0.0f } };
 
-			Matrix4x4 viewMatrix = Inverse(cameraMatrix);
+		meshView = MakeMeshView(meshData);
 
-			Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(0.45f, float(kClientWidth) / float(kClientHeight), 0.1f, 100.0f);
+	}
 
-			Matrix4x4 worldViewProjectionMatrix = Multiply(worldMatrix, Multiply(viewMatrix, projectionMatrix));
+	//頂点は入力レイアウトの形に詰めて、インデックスはそのままアップロードする
+	UINT meshVertexCount = static_cast<UINT>(meshView.vertexCount);
 
-			
-			ImGui::Begin("Window");
+	UINT meshIndexCount = static_cast<UINT>(meshView.indexCount);
 
-			ImGui::DragFloat3("color", &materialData->x, 0.01f);
-			ImGui::DragFloat3("translate", &transform.translate.x, 0.01f);
-			ImGui::DragFloat3("scale", &transform.scale.x, 0.01f);
-			ImGui::DragFloat3("rotate", &transform.rotate.x, 0.01f);
+	ID3D12Resource* vertexResource = CreateBufferResource(device, vertexLayout.GetStride() * meshVertexCount);
 
-			ImGui::End();
+	D3D12_VERTEX_BUFFER_VIEW vertexBufferView{};
 
-			
+	vertexBufferView.BufferLocation = vertexResource->GetGPUVirtualAddress();
 
-			*wvpData = worldViewProjectionMatrix;
+	vertexBufferView.SizeInBytes = vertexLayout.GetStride() * meshVertexCount;
 
-			scissorRect.bottom = kClientHeight;
+	vertexBufferView.StrideInBytes = vertexLayout.GetStride();
 
-			ImGui::Render();
+	void* vertexData = nullptr;
 
-			UINT backBufferIndex = swapChain->GetCurrentBackBufferIndex();
+	vertexResource->Map(0, nullptr, &vertexData);
 
-			D3D12_RESOURCE_BARRIER barrier{};
+	//位置はメッシュの範囲で量子化し、戻す変換はWVPに前から掛ける
+	VertexQuantization meshQuantization = ComputeVertexQuantization(meshView.vertices, meshView.vertexCount);
 
-			barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+	Matrix4x4 meshDequantizeMatrix = MakeDequantizeMatrix(meshQuantization);
 
-			barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	//誤差を測るために手元で詰めてからコピーする(アップロードヒープからは読まない)
+	std::vector<uint8_t> encodedVertices(vertexLayout.GetStride() * meshView.vertexCount);
 
-			barrier.Transition.pResource = swapChainResources[backBufferIndex];
+	EncodeVertices(encodedVertices.data(), meshView.vertices, meshView.vertexCount, vertexLayout, meshQuantization, &jobSystem);
 
-			barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
+	std::memcpy(vertexData, encodedVertices.data(), encodedVertices.size());
 
-			barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
+	VertexEncodingError encodingError = MeasureVertexEncodingError(meshView.vertices, encodedVertices.data(), meshView.vertexCount, vertexLayout, meshQuantization);
 
-			commandList->ResourceBarrier(1, &barrier);
+	Log(std::format("Encode vertices, stride:{}->{}, position error:{:.6f}, normal error:{:.4f}deg, texcoord error:{:.6f}\n",
+		sizeof(MeshVertex), vertexLayout.GetStride(), encodingError.maxPositionError, encodingError.maxNormalError, encodingError.maxTexcoordError));
 
-			commandList->OMSetRenderTargets(1, &rtvHandles[backBufferIndex], false, nullptr);
+	ID3D12Resource* indexResource = CreateBufferResource(device, sizeof(uint32_t) * meshIndexCount);
 
-			float clearColor[] = { 0.1f,0.25f,0.5f,1.0f };
+	D3D12_INDEX_BUFFER_VIEW indexBufferView{};
 
-			commandList->ClearRenderTargetView(rtvHandles[backBufferIndex], clearColor, 0, nullptr);
+	indexBufferView.BufferLocation = indexResource->GetGPUVirtualAddress();
 
-			ID3D12DescriptorHeap* descriptorHeaps[] = { srvDescriptorHeap };
+	indexBufferView.SizeInBytes = sizeof(uint32_t) * meshIndexCount;
 
-			commandList->SetDescriptorHeaps(1, descriptorHeaps);
+	indexBufferView.Format = DXGI_FORMAT_R32_UINT;
 
-			commandList->RSSetViewports(1, &viewport);
+	uint32_t* indexData = nullptr;
 
-			commandList->RSSetScissorRects(1, &scissorRect);
+	indexResource->Map(0, nullptr, reinterpret_cast<void**>(&indexData));
 
-			commandList->SetGraphicsRootSignature(rootSignature);
+	std::memcpy(indexData, meshView.indices, sizeof(uint32_t) * meshIndexCount);
 
-			commandList->SetPipelineState(graphicsPipelineState);
-			
-			commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
+	//カリング用のローカル空間のAABB
+	AABB localAABB = meshView.bounds;
 
-			commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	//遮蔽物のラスタライズとピッキング用に頂点を手元に残す(アップロードヒープからは読まない)
+	std::vector<Vector4> meshVertices(meshView.vertexCount);
 
-			commandList->SetGraphicsRootConstantBufferView(0, materialResource->GetGPUVirtualAddress());
+	for (size_t i = 0; i < meshView.vertexCount; ++i) {
+		meshVertices[i] = meshView.vertices[i].position;
+	}
 
-			commandList->SetGraphicsRootConstantBufferView(1, wvpResource->GetGPUVirtualAddress());
+	//LODの表(焼き込みにLODがなければ全体を1段とする)
+	std::vector<MeshLod> meshLods(meshView.lods, meshView.lods + meshView.lodCount);
 
-			commandList->DrawInstanced(3, 1, 0, 0);
+	if (meshLods.empty()) {
+		meshLods.push_back({ 0, meshIndexCount, 0.0f, 0 });
+	}
 
-			ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), commandList);
+	//LOD0のメッシュレット(近くでLOD0を描く時にクラスタ単位で捨てる)
+	std::vector<Meshlet> meshlets(meshView.meshlets, meshView.meshlets + meshView.meshletCount);
 
-			barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
+	std::vector<uint32_t> visibleMeshletIndices(meshlets.size());
 
-			barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
+	std::vector<MeshletDrawRange> meshletDrawRanges(meshlets.size());
 
-			commandList->ResourceBarrier(1, &barrier);
+	//ピッキングと遮蔽物はLOD0で行う
+	std::vector<uint32_t> meshIndices(meshView.indices + meshLods[0].indexOffset, meshView.indices + meshLods[0].indexOffset + meshLods[0].indexCount);
 
-			hr = commandList->Close();
+	PickingMesh pickingMesh;
 
-			assert(SUCCEEDED(hr));
+	pickingMesh.Build(meshVertices.data(), meshIndices.data(), meshIndices.size());
 
-			ID3D12CommandList* commandLists[] = { commandList };
+	//マウスで選んだオブジェクト(選んだエンティティをImGuiで編集する)
+	uint32_t pickedObjectIndex = Bvh::kInvalidIndex;
 
-			commandQueue->ExecuteCommandLists(1, commandLists);
+	float pickedDistance = 0.0f;
 
-			swapChain->Present(1, 0);
+	//焼き込み済みのテクスチャ(BC7)があればそのまま使う
+	//なければ元の画像を読み込み、mipを作ってBC7に圧縮して焼き込む。それも読めなければ市松模様を使う
+	TextureData textureData;
 
-			fenceValue++;
+	//アーカイブのBC7テクスチャはヘッダーだけを読み、細かい段はストリーミングで要求された時に非同期に読む
+	uint32_t textureAssetIndex = isAssetArchiveOpen ? assetArchive.Find("texture_bc7.dds") : AssetArchive::kInvalidIndex;
 
-			commandQueue->Signal(fence, fenceValue);
+	//アーカイブのテクスチャの中の0段目の位置
+	size_t textureAssetPixelOffset = 0;
 
-			if (fence->GetCompletedValue() < fenceValue) {
+	bool isTextureStreamedFromArchive = false;
 
-				fence->SetEventOnCompletion(fenceValue, fenceEvent);
+	if (textureAssetIndex != AssetArchive::kInvalidIndex) {
 
-				WaitForSingleObject(fenceEvent, INFINITE);
+		uint8_t ddsHeader[kMaxDdsHeaderSize];
 
-			}
+		uint64_t textureAssetSize = assetArchive.GetSize(textureAssetIndex);
 
-			hr = commandAllocator->Reset();
+		size_t ddsHeaderSize = static_cast<size_t>((std::min)(textureAssetSize, uint64_t(kMaxDdsHeaderSize)));
 
-			assert(SUCCEEDED(hr));
+		isTextureStreamedFromArchive = assetArchive.Read(textureAssetIndex, 0, ddsHeaderSize, ddsHeader) &&
+			ParseDdsLayout(ddsHeader, ddsHeaderSize, textureAssetSize, textureData, textureAssetPixelOffset) && IsBlockCompressed(textureData.format);
 
-			hr = commandList->Reset(commandAllocator, nullptr);
+	}
 
-			assert(SUCCEEDED(hr));
+	if (!isTextureStreamedFromArchive && !LoadTexture("resources/texture_bc7.dds", textureData)) {
 
-			//transform.rotate.y += 0.1f;
+		bool isTextureLoaded = LoadTexture("resources/texture.dds", textureData) || LoadTexture("resources/texture.ktx2", textureData);
+
+		if (!isTextureLoaded) {
+			MakeCheckerTexture(textureData, 256, 8);
+		}
+
+		if (!IsBlockCompressed(textureData.format)) {
+
+			//色のテクスチャとして扱う
+			textureData.format = MakeSrgbFormat(textureData.format, true);
 
-			*wvpData = worldMatrix;
+			GenerateMips(textureData, {}, &jobSystem);
+
+			//ブロック圧縮は0段目の幅と高さが4の倍数でないと作れないので、そうでなければRGBA8のまま使う
+			if (textureData.width % 4 == 0 && textureData.height % 4 == 0) {
+
+				TextureData compressedTexture;
+
+				CompressTexture(textureData, TextureFormat::kBC7, compressedTexture, &jobSystem);
+
+				TextureData decompressedTexture;
+
+				DecompressTexture(compressedTexture, decompressedTexture);
+
+				Log(std::format("Compress texture, {}x{}, mips:{}, PSNR:{:.2f}dB\n", textureData.width, textureData.height, textureData.mips.size(), ComputePsnr(textureData, decompressedTexture)));
+
+				textureData = std::move(compressedTexture);
+
+				if (isTextureLoaded) {
+					WriteDds("resources/texture_bc7.dds", textureData);
+				}
+
+			}
 
 		}
-	
-}
 
-ImGui_ImplDX12_Shutdown();
+	}
 
-ImGui_ImplWin32_Shutdown();
+	//焼き込んだファイルがそろったら1つのアーカイブにまとめる(次回からはファイルを開く数と読む回数が減る)
+	if (!isAssetArchiveOpen) {
 
-ImGui::DestroyContext();
+		MappedFile bakedMeshFile;
 
-	CloseHandle(fenceEvent);
+		MappedFile bakedTextureFile;
 
-	fence->Release();
+		if (bakedMeshFile.Open("resources/model.mesh") && bakedTextureFile.Open("resources/texture_bc7.dds")) {
 
-	rtvDescriptorHeap->Release();
+			AssetArchiveWriter assetArchiveWriter;
 
-	srvDescriptorHeap->Release();
+			assetArchiveWriter.AddEntry("model.mesh", bakedMeshFile.GetData(), bakedMeshFile.GetSize());
 
-	swapChainResources[0]->Release();
+			assetArchiveWriter.AddEntry("texture_bc7.dds", bakedTextureFile.GetData(), bakedTextureFile.GetSize());
 
-	swapChainResources[1]->Release();
+			assetArchiveWriter.Write(kAssetArchivePath, &jobSystem);
 
-	swapChain->Release();
+		}
 
-	commandList->Release();
+	}
 
-	commandAllocator->Release();
+	//テクスチャのコピーはアップロード用のリングを通して積む
+	TextureUploader textureUploader;
 
-	commandQueue->Release();
+	textureUploader.Initialize(device, 32 * 1024 * 1024);
 
-	device->Release();
+	ID3D12Resource* textureResource = textureUploader.CreateTexture(textureData, resourceStateTable);
 
-	useAdapter->Release();
+	//最初は小さい段だけを常駐させ、画面での大きさに応じて細かい段を読み込む
+	TextureStreamer textureStreamer;
 
-	dxgiFactory->Release();
+	textureStreamer.Initialize({});
 
-	vertexResource->Release();
+	std::vector<uint64_t> textureMipSizes;
+
+	for (const TextureMip& mip : textureData.mips) {
+		textureMipSizes.push_back(mip.size);
+	}
+
+	uint32_t streamedTextureIndex = textureStreamer.RegisterTexture(textureData.width, textureData.height, textureMipSizes.data(), static_cast<uint32_t>(textureMipSizes.size()));
+
+	//アーカイブから読む時は、最初から常駐させる小さい段だけをここで読む(小さい段は後ろに続けて並んでいる)
+	if (isTextureStreamedFromArchive) {
+
+		size_t tailOffset = textureData.mips[textureStreamer.GetTailMip(streamedTextureIndex)].offset;
+
+		if (!assetArchive.Read(textureAssetIndex, textureAssetPixelOffset + tailOffset, textureData.pixels.size() - tailOffset, textureData.pixels.data() + tailOffset)) {
+			Log("Failed to read texture tail mips from the asset archive\n");
+		}
+
+	}
+
+	//ストリーミングで読む段が変わるのでビューはステージングに作り、フレームごとにリングへ写して使う
+	uint32_t textureStagingIndex = descriptorManager.AllocateStaging();
+
+	CreateTextureShaderResourceView(device, textureResource, textureData, static_cast<float>(textureStreamer.GetResidentMip(streamedTextureIndex)), descriptorManager.GetStagingCPUHandle(textureStagingIndex));
+
+	bool isTextureUploaded = false;
+
+	//リングに収まらずにまだ積んでいない要求と、このフレームでコピーを積んだ要求
+	std::vector<MipRequest> queuedMipRequests;
+
+	std::vector<MipRequest> uploadingMipRequests;
+
+	//マテリアルの最大数
+	const uint32_t kMaxMaterials = 256;
+
+	MaterialTable materialTable;
+
+	materialTable.Initialize(kMaxMaterials);
+
+	//テクスチャはアップロードを積んでからマテリアルに設定する
+	uint32_t materialIndex = materialTable.Add({ { 1.0f, 1.0f, 1.0f, 1.0f }, kInvalidTextureIndex, 0 });
+
+	ID3D12Resource* materialResource = CreateBufferResource(device, sizeof(MaterialRecord) * kMaxMaterials);
+
+	MaterialRecord* materialData = nullptr;
+
+	materialResource->Map(0, nullptr, reinterpret_cast<void**>(&materialData));
+
+	materialTable.Upload(materialData);
+
+	//オブジェクトの最大数
+	const uint32_t kMaxObjects = 256;
+
+	ID3D12Resource* wvpResource = CreateBufferResource(device, sizeof(Matrix4x4) * kMaxObjects);
+
+	Matrix4x4* wvpData = nullptr;
+
+	wvpResource->Map(0, nullptr, reinterpret_cast<void**>(&wvpData));
+
+	for (uint32_t i = 0; i < kMaxObjects; ++i) {
+		wvpData[i] = MakeIdentity4x4();
+	}
+
+	//描画はキーで並べ替えてから積む
+	DrawQueue drawQueue;
+
+	//シーンのデータはエンティティとコンポーネントで持つ
+	EntityWorld entityWorld;
+
+	Entity cameraEntity = entityWorld.CreateEntity(
+		Transform{ { 1.0f,1.0f,1.0f }, { 0.0f,0.0f,0.0f }, { 0.0f,0.0f,-5.0f } },
+		Camera{ 0.45f, 0.1f, 100.0f });
+
+	//objectIndexからエンティティを引く
+	std::vector<Entity> objectEntities;
+
+	objectEntities.push_back(entityWorld.CreateEntity(
+		Transform{ { 1.0f,1.0f,1.0f }, { 0.0f,0.0f,0.0f }, { 0.0f,0.0f,0.0f } },
+		WorldTransform{ MakeIdentity4x4() },
+		MaterialComponent{ materialIndex },
+		RenderComponent{ 0, 0xffffffff, 0, static_cast<uint32_t>(meshLods.size()), 0, 0, static_cast<uint32_t>(meshlets.size()), 1, localAABB }));
+
+	assert(objectEntities.size() <= kMaxObjects);
+
+	Entity selectedEntity = objectEntities[0];
+
+	//オブジェクトごとのワールド空間のAABB
+	AABBArray objectAABBs;
+
+	objectAABBs.Resize(objectEntities.size());
+
+	//視錐台カリングと後のピッキングはシーンのBVHで行う(動いたらRefitする)
+	Bvh sceneBvh;
+
+	{
+		std::vector<AABB> worldAABBs(objectEntities.size());
+
+		entityWorld.ForEach<Transform, RenderComponent>([&](const Transform& transform, const RenderComponent& render) {
+			worldAABBs[render.objectIndex] = TransformAABB(render.localBounds, MakeAffinMatrix(transform.scale, transform.rotate, transform.translate));
+			objectAABBs.Set(render.objectIndex, worldAABBs[render.objectIndex]);
+		});
+
+		sceneBvh.Build(worldAABBs.data(), worldAABBs.size());
+	}
+
+	std::vector<uint32_t> visibleObjectIndices(objectAABBs.GetCount());
+
+	size_t visibleObjectCount = 0;
+
+	//前のフレームで描いた三角形の数
+	size_t drawnTriangleCount = 0;
+
+	//前のフレームのメッシュレットの判定の結果
+	size_t testedMeshletCount = 0;
+
+	size_t visibleMeshletCount = 0;
+
+	MeshletCullStatistics meshletCullStatistics{};
+
+	//遮蔽判定用の低解像度の深度バッファ
+
+	OcclusionBuffer occlusionBuffer;
+
+	occlusionBuffer.Initialize(kClientWidth / 4, kClientHeight / 4);
+
+	size_t frustumVisibleObjectCount = 0;
+
+	D3D12_VIEWPORT viewport{};
+
+	viewport.Width = kClientWidth;
+
+	viewport.Height = kClientHeight;
+
+	viewport.TopLeftX = 0;
+
+	viewport.TopLeftY = 0;
+
+	viewport.MinDepth = 0.0f;
+
+	viewport.MaxDepth = 1.0f;
+
+	D3D12_RECT scissorRect{};
+
+	scissorRect.left = 0;
+
+	scissorRect.right = kClientWidth;
+
+	scissorRect.top = 0;
+
+	IMGUI_CHECKVERSION();
+
+	ImGui::CreateContext();
+
+	ImGui::StyleColorsDark();
+
+	ImGui_ImplWin32_Init(hwnd);
+
+	//ImGuiのフォントテクスチャ用のスロットを確保する
+	uint32_t imguiDescriptorIndex = descriptorManager.AllocatePersistent();
+
+	ImGui_ImplDX12_Init(device,
+
+		swapChainDesc.BufferCount,
+
+		rtvDesc.Format,
+
+		srvDescriptorHeap,
+
+		descriptorManager.GetCPUHandle(imguiDescriptorIndex),
+
+		descriptorManager.GetGPUHandle(imguiDescriptorIndex));
+
+	UINT backBufferIndex = 0;
+
+	//前のフレームで積んだ状態設定の数と省いた数
+	uint32_t stateCommandCount = 0;
+
+	uint32_t skippedStateCommandCount = 0;
+
+	//レンダーグラフの構築(パスの構成は変わらないので最初に一度だけコンパイルする)
+	RenderGraph renderGraph;
+
+	uint32_t backBufferResource = renderGraph.ImportResource("BackBuffer", kResourceStatePresent, kResourceStatePresent);
+
+	uint32_t depthStencilGraphResource = renderGraph.ImportResource("DepthStencil", kResourceStateDepthWrite, kResourceStateDepthWrite);
+
+	std::vector<ID3D12Resource*> renderGraphResources(renderGraph.GetResourceCount(), nullptr);
+
+	renderGraphResources[depthStencilGraphResource] = depthStencilResource;
+
+	//深度のクリアと、有効なら不透明物の深度だけを先に書く
+	uint32_t depthPrepass = renderGraph.AddPass("DepthPrepass", [&]() {
+
+		commandList->OMSetRenderTargets(0, nullptr, false, &dsvHandle);
+
+		commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 0.0f, 0, 0, nullptr);
+
+		if (!isDepthPrepassEnabled) {
+			return;
+		}
+
+		ID3D12DescriptorHeap* descriptorHeaps[] = { srvDescriptorHeap };
+
+		stateCachedCommandList.SetDescriptorHeaps(1, descriptorHeaps);
+
+		stateCachedCommandList.RSSetViewports(1, &viewport);
+
+		stateCachedCommandList.RSSetScissorRects(1, &scissorRect);
+
+		stateCachedCommandList.SetGraphicsRootSignature(rootSignature);
+
+		stateCachedCommandList.SetPipelineState(depthPrepassPipelineState);
+
+		stateCachedCommandList.IASetVertexBuffers(0, 1, &vertexBufferView);
+
+		stateCachedCommandList.IASetIndexBuffer(&indexBufferView);
+
+		stateCachedCommandList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+		stateCachedCommandList.SetGraphicsRootShaderResourceView(1, wvpResource->GetGPUVirtualAddress());
+
+		for (size_t i = 0; i < drawQueue.GetCount(); ++i) {
+
+			//半透明は深度を書かない
+			if (GetDrawSortKeyPass(drawQueue.GetSortKey(i)) != DrawPass::kOpaque) {
+				continue;
+			}
+
+			const DrawPacket& packet = drawQueue.Get(i);
+
+			DrawConstants drawConstants{ packet.objectIndex, packet.materialIndex, packet.color };
+
+			stateCachedCommandList.SetGraphicsRoot32BitConstants(2, sizeof(DrawConstants) / sizeof(uint32_t), &drawConstants, 0);
+
+			resourceStateTracker.DrawIndexedInstanced(packet.indexCount, 1, packet.startIndex, packet.baseVertex, 0);
+
+		}
+
+	});
+
+	renderGraph.Write(depthPrepass, depthStencilGraphResource, kResourceStateDepthWrite);
+
+	uint32_t object3dPass = renderGraph.AddPass("Object3d", [&]() {
+
+		commandList->OMSetRenderTargets(1, &rtvHandles[backBufferIndex], false, &dsvHandle);
+
+		float clearColor[] = { 0.1f,0.25f,0.5f,1.0f };
+
+		commandList->ClearRenderTargetView(rtvHandles[backBufferIndex], clearColor, 0, nullptr);
+
+		ID3D12DescriptorHeap* descriptorHeaps[] = { srvDescriptorHeap };
+
+		stateCachedCommandList.SetDescriptorHeaps(1, descriptorHeaps);
+
+		stateCachedCommandList.RSSetViewports(1, &viewport);
+
+		stateCachedCommandList.RSSetScissorRects(1, &scissorRect);
+
+		stateCachedCommandList.SetGraphicsRootSignature(rootSignature);
+
+		//DrawPacketのpipelineIndexが指すPSO
+		ID3D12PipelineState* pipelineStates[] = { isDepthPrepassEnabled ? depthEqualPipelineState : graphicsPipelineState };
+
+		if (isWireframe && wireframePipelineHash != 0) {
+			pipelineStates[0] = asyncPipelineCompiler.GetPipelineState(wireframePipelineHash, graphicsPipelineState);
+		}
+
+		stateCachedCommandList.IASetVertexBuffers(0, 1, &vertexBufferView);
+
+		stateCachedCommandList.IASetIndexBuffer(&indexBufferView);
+
+		stateCachedCommandList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+		stateCachedCommandList.SetGraphicsRootShaderResourceView(0, materialResource->GetGPUVirtualAddress());
+
+		stateCachedCommandList.SetGraphicsRootShaderResourceView(1, wvpResource->GetGPUVirtualAddress());
+
+		stateCachedCommandList.SetGraphicsRootDescriptorTable(3, srvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+
+		//並べ替えた順に積むので、同じPSOが続く間は設定が省かれる
+		for (size_t i = 0; i < drawQueue.GetCount(); ++i) {
+
+			const DrawPacket& packet = drawQueue.Get(i);
+
+			stateCachedCommandList.SetPipelineState(pipelineStates[packet.pipelineIndex]);
+
+			//描画ごとに変わるのはルート定数だけ
+			DrawConstants drawConstants{ packet.objectIndex, packet.materialIndex, packet.color };
+
+			stateCachedCommandList.SetGraphicsRoot32BitConstants(2, sizeof(DrawConstants) / sizeof(uint32_t), &drawConstants, 0);
+
+			resourceStateTracker.DrawIndexedInstanced(packet.indexCount, 1, packet.startIndex, packet.baseVertex, 0);
+
+		}
+
+	});
+
+	renderGraph.Write(object3dPass, backBufferResource, kResourceStateRenderTarget);
+
+	renderGraph.Write(object3dPass, depthStencilGraphResource, kResourceStateDepthWrite);
+
+	uint32_t imguiPass = renderGraph.AddPass("ImGui", [&]() {
+
+		//ImGuiのPSOは深度を持たないのでDSVを外す
+		commandList->OMSetRenderTargets(1, &rtvHandles[backBufferIndex], false, nullptr);
+
+		ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), commandList);
+
+		//ImGuiが直接設定した状態は追いかけられないので忘れる
+		stateCachedCommandList.Invalidate();
+
+	});
+
+	renderGraph.Write(imguiPass, backBufferResource, kResourceStateRenderTarget);
+
+	renderGraph.Compile();
+
+	MSG msg{};
+
+	while (msg.message != WM_QUIT) {
+
+		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+
+			TranslateMessage(&msg);
+			DispatchMessage(&msg);
+
+		} else {
+
+			//前のフレームまでに読み終わったもののコールバックを呼ぶ(時間の上限を超えた分は次のフレームに回す)
+			asyncLoader.DispatchCompletions();
+
+			ImGui_ImplDX12_NewFrame();
+
+			ImGui_ImplWin32_NewFrame();
+
+			ImGui::NewFrame();
+
+			//各種行列の計算
+			const Transform& cameraTransform = *entityWorld.GetComponent<Transform>(cameraEntity);
+
+			const Camera& camera = *entityWorld.GetComponent<Camera>(cameraEntity);
+
+			Matrix4x4 cameraMatrix = MakeAffinMatrix(cameraTransform.scale, cameraTransform.rotate, cameraTransform.translate);
+
+			Matrix4x4 viewMatrix = Inverse(cameraMatrix);
+
+			Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(camera.fovY, float(kClientWidth) / float(kClientHeight), camera.nearClip, camera.farClip);
+
+			Matrix4x4 viewProjectionMatrix = Multiply(viewMatrix, projectionMatrix);
+
+			//ピッキングで使う逆行列はフレームに一度だけ求める
+			Matrix4x4 inverseViewProjectionMatrix = Inverse(viewProjectionMatrix);
+
+			
+			ImGui::Begin("Window");
+
+			//選んだエンティティのマテリアルとTransformを編集する
+			uint32_t selectedMaterialIndex = entityWorld.GetComponent<MaterialComponent>(selectedEntity)->materialIndex;
+
+			Material material = materialTable.Get(selectedMaterialIndex);
+
+			if (ImGui::DragFloat3("color", &material.color.x, 0.01f)) {
+				materialTable.Set(selectedMaterialIndex, material);
+			}
+
+			Transform& selectedTransform = *entityWorld.GetComponent<Transform>(selectedEntity);
+
+			ImGui::DragFloat3("translate", &selectedTransform.translate.x, 0.01f);
+			ImGui::DragFloat3("scale", &selectedTransform.scale.x, 0.01f);
+			ImGui::DragFloat3("rotate", &selectedTransform.rotate.x, 0.01f);
+
+			//初めて選ばれた時にPSOの作成を依頼する
+			if (ImGui::Checkbox("wireframe", &isWireframe) && isWireframe && wireframePipelineHash == 0) {
+				wireframePipelineHash = asyncPipelineCompiler.Request(wireframePipelineStateDesc);
+			}
+
+			ImGui::Checkbox("depth prepass", &isDepthPrepassEnabled);
+
+			ImGui::DragFloat("LOD pixel error", &lodPixelError, 0.05f, 0.0f, 64.0f);
+
+			ImGui::Checkbox("meshlet culling", &isMeshletCullingEnabled);
+
+			PipelineCompileStatistics compileStatistics = asyncPipelineCompiler.GetStatistics();
+
+			ImGui::Text("PSO queue:%u (max:%u)", compileStatistics.queueDepth, compileStatistics.maxQueueDepth);
+
+			ImGui::Text("PSO compiled:%u failed:%u last:%.2fms max:%.2fms", compileStatistics.compiledCount, compileStatistics.failedCount, compileStatistics.lastMilliseconds, compileStatistics.maxMilliseconds);
+
+			ImGui::Text("State commands:%u skipped:%u", stateCommandCount, skippedStateCommandCount);
+
+			if (pickedObjectIndex != Bvh::kInvalidIndex) {
+				ImGui::Text("Picked object:%u (distance:%.3f)", pickedObjectIndex, pickedDistance);
+			} else {
+				ImGui::Text("Picked object:none");
+			}
+
+			ImGui::Text("Visible objects:%zu/%zu (frustum:%zu)", visibleObjectCount, objectAABBs.GetCount(), frustumVisibleObjectCount);
+
+			ImGui::Text("Triangles:%zu (LOD levels:%zu)", drawnTriangleCount, meshLods.size());
+
+			ImGui::Text("Meshlets:%zu/%zu (frustum:%zu backface:%zu occlusion:%zu)", visibleMeshletCount, testedMeshletCount,
+				meshletCullStatistics.frustumCulledCount, meshletCullStatistics.backfaceCulledCount, meshletCullStatistics.occlusionCulledCount);
+
+			ImGui::Text("Entities:%zu archetypes:%zu", entityWorld.GetEntityCount(), entityWorld.GetArchetypeCount());
+
+			ImGui::Text("Texture resident mip:%u/%zu (%.2fMB, pending:%.2fMB)", textureStreamer.GetResidentMip(streamedTextureIndex), textureData.mips.size(),
+				textureStreamer.GetStatistics().residentSize / (1024.0 * 1024.0), textureStreamer.GetStatistics().pendingSize / (1024.0 * 1024.0));
+
+			AsyncLoadStatistics loadStatistics = asyncLoader.GetStatistics();
+
+			uint64_t finishedLoadCount = loadStatistics.completedCount + loadStatistics.failedCount + loadStatistics.canceledCount;
+
+			ImGui::Text("Async load queued:%u in flight:%u done:%llu failed:%llu, read:%.1fMB/s, latency avg:%.2fms max:%.2fms",
+				loadStatistics.queuedCount, loadStatistics.inFlightCount, loadStatistics.completedCount, loadStatistics.failedCount,
+				loadStatistics.readMilliseconds > 0.0f ? loadStatistics.readSize / (1024.0 * 1024.0) / (loadStatistics.readMilliseconds / 1000.0) : 0.0,
+				finishedLoadCount > 0 ? loadStatistics.totalLatencyMilliseconds / finishedLoadCount : 0.0f, loadStatistics.maxLatencyMilliseconds);
+
+			ImGui::End();
+
+			
+
+			//ワールド行列はチャンクごとに並列に求める
+			entityWorld.ParallelForEach<Transform, WorldTransform>(&jobSystem, [](const Transform& transform, WorldTransform& worldTransform) {
+				worldTransform.matrix = MakeAffinMatrix(transform.scale, transform.rotate, transform.translate);
+			});
+
+			//大きな遮蔽物をCPUで描いて階層Zを作る
+			occlusionBuffer.Clear();
+
+			//GPUの行列と、動いたオブジェクトのAABBをBVHに反映する
+			entityWorld.ForEach<WorldTransform, RenderComponent>([&](const WorldTransform& worldTransform, const RenderComponent& render) {
+
+				Matrix4x4 worldViewProjectionMatrix = Multiply(worldTransform.matrix, viewProjectionMatrix);
+
+				wvpData[render.objectIndex] = Multiply(meshDequantizeMatrix, worldViewProjectionMatrix);
+
+				AABB worldAABB = TransformAABB(render.localBounds, worldTransform.matrix);
+
+				objectAABBs.Set(render.objectIndex, worldAABB);
+
+				sceneBvh.Update(render.objectIndex, worldAABB);
+
+				if (render.isOccluder) {
+					occlusionBuffer.RenderOccluder(meshVertices.data(), meshIndices.data(), meshIndices.size(), worldViewProjectionMatrix);
+				}
+
+			});
+
+			sceneBvh.RefitOrRebuild();
+
+			occlusionBuffer.BuildHierarchy();
+
+			//視錐台の外にあるオブジェクトは積まない
+			Frustum frustum = MakeFrustum(viewProjectionMatrix);
+
+			frustumVisibleObjectCount = sceneBvh.QueryFrustum(frustum, visibleObjectIndices.data());
+
+			//視錐台に残ったものを遮蔽判定する
+			visibleObjectCount = occlusionBuffer.Cull(objectAABBs, visibleObjectIndices.data(), frustumVisibleObjectCount, viewProjectionMatrix, visibleObjectIndices.data(), &jobSystem);
+
+			//ImGuiの上でなければ、クリックした位置のレイでBVHを辿って三角形まで判定する
+			if (ImGui::IsMouseClicked(0) && !ImGui::GetIO().WantCaptureMouse) {
+
+				ImVec2 mousePosition = ImGui::GetIO().MousePos;
+
+				Ray ray = MakePickingRay(mousePosition.x, mousePosition.y, float(kClientWidth), float(kClientHeight), inverseViewProjectionMatrix);
+
+				//メッシュは今は1つなので、どのオブジェクトも同じメッシュをそれぞれの行列で判定する
+				pickedObjectIndex = sceneBvh.Raycast(ray, 1.0f, [&](uint32_t objectIndex, float& distance) {
+					Matrix4x4 inverseWorldMatrix = Inverse(entityWorld.GetComponent<WorldTransform>(objectEntities[objectIndex])->matrix);
+					return pickingMesh.Intersect(TransformRay(ray, inverseWorldMatrix), 1.0f, distance, nullptr);
+				}, &pickedDistance);
+
+				if (pickedObjectIndex != Bvh::kInvalidIndex) {
+					selectedEntity = objectEntities[pickedObjectIndex];
+				}
+
+			}
+
+			drawQueue.Clear();
+
+			drawnTriangleCount = 0;
+
+			testedMeshletCount = 0;
+
+			visibleMeshletCount = 0;
+
+			meshletCullStatistics = {};
+
+			textureStreamer.BeginFrame();
+
+			LodSelection lodSelection = MakeLodSelection(projectionMatrix, float(kClientHeight), lodPixelError);
+
+			for (size_t i = 0; i < visibleObjectCount; ++i) {
+
+				Entity entity = objectEntities[visibleObjectIndices[i]];
+
+				const Matrix4x4& worldMatrix = entityWorld.GetComponent<WorldTransform>(entity)->matrix;
+
+				const RenderComponent& render = *entityWorld.GetComponent<RenderComponent>(entity);
+
+				uint32_t objectMaterialIndex = entityWorld.GetComponent<MaterialComponent>(entity)->materialIndex;
+
+				//オブジェクトのビュー空間での奥行きを求めてソートキーに入れる
+				float viewDepth = worldMatrix.m[3][0] * viewMatrix.m[0][2] + worldMatrix.m[3][1] * viewMatrix.m[1][2] + worldMatrix.m[3][2] * viewMatrix.m[2][2] + viewMatrix.m[3][2];
+
+				//誤差を画面に映した大きさでLODを選ぶ(AABBを囲む球で測る)
+				const AABB& localBounds = render.localBounds;
+
+				Vector3 localCenter = { (localBounds.min.x + localBounds.max.x) * 0.5f, (localBounds.min.y + localBounds.max.y) * 0.5f, (localBounds.min.z + localBounds.max.z) * 0.5f };
+
+				Vector3 localExtent = { (localBounds.max.x - localBounds.min.x) * 0.5f, (localBounds.max.y - localBounds.min.y) * 0.5f, (localBounds.max.z - localBounds.min.z) * 0.5f };
+
+				BoundingSphere localSphere{ localCenter, std::sqrt(localExtent.x * localExtent.x + localExtent.y * localExtent.y + localExtent.z * localExtent.z) };
+
+				BoundingSphere worldSphere = TransformBoundingSphere(localSphere, worldMatrix);
+
+				float sphereDepth = worldSphere.center.x * viewMatrix.m[0][2] + worldSphere.center.y * viewMatrix.m[1][2] + worldSphere.center.z * viewMatrix.m[2][2] + viewMatrix.m[3][2];
+
+				float worldScale = localSphere.radius > 0.0f ? worldSphere.radius / localSphere.radius : 1.0f;
+
+				uint32_t lod = SelectMeshLod(&meshLods[render.firstLod], render.lodCount, worldScale, localSphere.radius, sphereDepth, lodSelection);
+
+				//UVの0～1がオブジェクト全体に広がっているとみなして、画面での大きさから必要な段を伝える
+				if (objectMaterialIndex == materialIndex) {
+
+					float projectedSize = ComputeProjectedSize(worldSphere.radius, sphereDepth, lodSelection);
+
+					textureStreamer.ReportUsage(streamedTextureIndex, ComputeDesiredMip(textureData.width, textureData.height, projectedSize), projectedSize * projectedSize);
+
+				}
+
+				const MeshLod& meshLod = meshLods[render.firstLod + lod];
+
+				uint64_t sortKey = MakeDrawSortKey(DrawPass::kOpaque, 0, objectMaterialIndex, viewDepth, camera.nearClip, camera.farClip);
+
+				//LOD0を描く時はメッシュレットを視錐台、裏向き、遮蔽で判定して、残ったものを続いている範囲ごとに描く
+				if (lod == 0 && render.meshletCount != 0 && isMeshletCullingEnabled) {
+
+					const Meshlet* objectMeshlets = &meshlets[render.firstMeshlet];
+
+					//カメラの位置をメッシュのローカル空間に移す
+					Matrix4x4 cameraLocalMatrix = Multiply(cameraMatrix, Inverse(worldMatrix));
+
+					Vector3 localCameraPosition = { cameraLocalMatrix.m[3][0], cameraLocalMatrix.m[3][1], cameraLocalMatrix.m[3][2] };
+
+					MeshletCullParameters meshletCullParameters = MakeMeshletCullParameters(Multiply(worldMatrix, viewProjectionMatrix), localCameraPosition, &occlusionBuffer);
+
+					MeshletCullStatistics objectStatistics{};
+
+					size_t objectVisibleMeshletCount = CullMeshlets(objectMeshlets, render.meshletCount, meshletCullParameters, visibleMeshletIndices.data(), &jobSystem, &objectStatistics);
+
+					size_t rangeCount = MakeMeshletDrawRanges(objectMeshlets, visibleMeshletIndices.data(), objectVisibleMeshletCount, meshLod.indexOffset, meshletDrawRanges.data());
+
+					for (size_t rangeIndex = 0; rangeIndex < rangeCount; ++rangeIndex) {
+
+						const MeshletDrawRange& range = meshletDrawRanges[rangeIndex];
+
+						drawnTriangleCount += range.indexCount / 3;
+
+						drawQueue.Push(sortKey, { render.objectIndex, objectMaterialIndex, 0, render.color, range.indexCount, range.startIndex, render.baseVertex });
+
+					}
+
+					testedMeshletCount += render.meshletCount;
+					visibleMeshletCount += objectVisibleMeshletCount;
+					meshletCullStatistics.frustumCulledCount += objectStatistics.frustumCulledCount;
+					meshletCullStatistics.backfaceCulledCount += objectStatistics.backfaceCulledCount;
+					meshletCullStatistics.occlusionCulledCount += objectStatistics.occlusionCulledCount;
+
+					continue;
+
+				}
+
+				drawnTriangleCount += meshLod.indexCount / 3;
+
+				drawQueue.Push(sortKey, { render.objectIndex, objectMaterialIndex, 0, render.color, meshLod.indexCount, meshLod.indexOffset, render.baseVertex });
+
+			}
+
+			drawQueue.Sort(&jobSystem);
+
+			//常駐させる小さい段のコピーを積む(リングに収まらなければ次のフレームでやり直す)
+			if (!isTextureUploaded && textureUploader.Upload(resourceStateTracker, textureResource, textureData, textureStreamer.GetTailMip(streamedTextureIndex))) {
+
+				isTextureUploaded = true;
+
+			}
+
+			//必要になった細かい段を要求し、予算を超えたら長く使っていない段を追い出す
+			textureStreamer.Update();
+
+			if (isTextureStreamedFromArchive) {
+
+				//アーカイブから段を非同期に読み、読み終わったらコピーの列に積む
+				for (const MipRequest& request : textureStreamer.GetRequests()) {
+
+					const TextureMip& mip = textureData.mips[request.mip];
+
+					//小さい段(一番ぼやけている時に足りない段)を先に読む
+					AsyncLoadPriority priority = request.mip + 2 >= textureStreamer.GetTailMip(request.textureIndex) ? AsyncLoadPriority::kHigh : AsyncLoadPriority::kNormal;
+
+					uint64_t loadId = asyncLoader.RequestAsset(&assetArchive, kAssetArchivePath, textureAssetIndex, textureAssetPixelOffset + mip.offset, mip.size, priority, [&, request](AsyncLoadResult& result) {
+
+						//読めなければ要求を取り下げる(まだ必要なら次のフレームで要求し直す)
+						if (result.status != AsyncLoadStatus::kCompleted) {
+							textureStreamer.CancelRequest(request.textureIndex, request.mip);
+							return;
+						}
+
+						std::memcpy(textureData.pixels.data() + textureData.mips[request.mip].offset, result.data.data(), result.data.size());
+
+						queuedMipRequests.push_back(request);
+
+					});
+
+					if (loadId == AsyncLoader::kInvalidId) {
+						textureStreamer.CancelRequest(request.textureIndex, request.mip);
+					}
+
+				}
+
+			} else {
+
+				queuedMipRequests.insert(queuedMipRequests.end(), textureStreamer.GetRequests().begin(), textureStreamer.GetRequests().end());
+
+			}
+
+			//追い出した段は読まないようにする(書き換えるのはGPUが読まないステージングのビュー)
+			if (!textureStreamer.GetEvictions().empty()) {
+				CreateTextureShaderResourceView(device, textureResource, textureData, static_cast<float>(textureStreamer.GetResidentMip(streamedTextureIndex)), descriptorManager.GetStagingCPUHandle(textureStagingIndex));
+			}
+
+			//このフレームのビューをリングに写してマテリアルから指す(前のフレームが読んでいる範囲は書き換えない)
+			if (isTextureUploaded) {
+
+				Material material = materialTable.Get(materialIndex);
+
+				material.textureIndex = descriptorManager.CopyToTransient(&textureStagingIndex, 1);
+
+				materialTable.Set(materialIndex, material);
+
+			}
+
+			//要求された段はリングに収まる分だけコピーを積み、残りは次のフレームに回す
+			size_t uploadedRequestCount = 0;
+
+			while (isTextureUploaded && uploadedRequestCount < queuedMipRequests.size() &&
+				textureUploader.Upload(resourceStateTracker, textureResource, textureData, queuedMipRequests[uploadedRequestCount].mip, 1)) {
+				++uploadedRequestCount;
+			}
+
+			uploadingMipRequests.assign(queuedMipRequests.begin(), queuedMipRequests.begin() + uploadedRequestCount);
+
+			queuedMipRequests.erase(queuedMipRequests.begin(), queuedMipRequests.begin() + uploadedRequestCount);
+
+			//変更のあったマテリアルだけGPUのテーブルに書き込む
+			materialTable.Upload(materialData);
+
+			scissorRect.bottom = kClientHeight;
+
+			ImGui::Render();
+
+			backBufferIndex = swapChain->GetCurrentBackBufferIndex();
+
+			renderGraphResources[backBufferResource] = swapChainResources[backBufferIndex];
+
+			//バリアはレンダーグラフがまとめて積む
+			renderGraph.Execute([&](const RenderGraphBarrier* barriers, size_t count) {
+				SubmitRenderGraphBarriers(resourceStateTracker, renderGraphResources.data(), barriers, count);
+			});
+
+			hr = commandList->Close();
+
+			assert(SUCCEEDED(hr));
+
+			//記録中に状態がわからなかったリソースの遷移を、表と突き合わせて先に実行する
+			hr = barrierCommandList->Reset(barrierCommandAllocator, nullptr);
+
+			assert(SUCCEEDED(hr));
+
+			resourceStateTracker.ResolvePendingBarriers(resourceStateTable, barrierCommandList);
+
+			hr = barrierCommandList->Close();
+
+			assert(SUCCEEDED(hr));
+
+			ID3D12CommandList* commandLists[] = { barrierCommandList, commandList };
+
+			commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+
+			resourceStateTracker.Reset();
+
+			swapChain->Present(1, 0);
+
+			fenceValue++;
+
+			commandQueue->Signal(fence, fenceValue);
+
+			descriptorManager.FinishFrame(fenceValue);
+
+			textureUploader.FinishFrame(fenceValue);
+
+			if (fence->GetCompletedValue() < fenceValue) {
+
+				fence->SetEventOnCompletion(fenceValue, fenceEvent);
+
+				WaitForSingleObject(fenceEvent, INFINITE);
+
+			}
+
+			//GPUが使い終わったフレームのディスクリプタを回収する
+			descriptorManager.ReleaseCompleted(fence->GetCompletedValue());
+
+			textureUploader.ReleaseCompleted(fence->GetCompletedValue());
+
+			//コピーが終わった段を常駐にして、読む段を広げる
+			if (!uploadingMipRequests.empty()) {
+
+				for (const MipRequest& request : uploadingMipRequests) {
+					textureStreamer.CompleteRequest(request.textureIndex, request.mip);
+				}
+
+				uploadingMipRequests.clear();
+
+				CreateTextureShaderResourceView(device, textureResource, textureData, static_cast<float>(textureStreamer.GetResidentMip(streamedTextureIndex)), descriptorManager.GetStagingCPUHandle(textureStagingIndex));
+
+			}
+
+			hr = commandAllocator->Reset();
+
+			assert(SUCCEEDED(hr));
+
+			hr = barrierCommandAllocator->Reset();
+
+			assert(SUCCEEDED(hr));
+
+			hr = commandList->Reset(commandAllocator, nullptr);
+
+			assert(SUCCEEDED(hr));
+
+			//リセットで状態は消えるので覚えている状態も捨てる
+			stateCachedCommandList.Invalidate();
+
+			stateCommandCount = stateCachedCommandList.GetIssuedCount();
+
+			skippedStateCommandCount = stateCachedCommandList.GetSkippedCount();
+
+			stateCachedCommandList.ResetStatistics();
+
+			//transform.rotate.y += 0.1f;
+
+		}
+	
+}
+
+ImGui_ImplDX12_Shutdown();
+
+ImGui_ImplWin32_Shutdown();
+
+ImGui::DestroyContext();
+
+	CloseHandle(fenceEvent);
+
+	fence->Release();
+
+	rtvDescriptorHeap->Release();
+
+	dsvDescriptorHeap->Release();
+
+	depthStencilResource->Release();
+
+	descriptorManager.FreePersistent(imguiDescriptorIndex);
+
+	descriptorManager.FreeStaging(textureStagingIndex);
+
+	descriptorManager.Finalize();
+
+	swapChainResources[0]->Release();
+
+	swapChainResources[1]->Release();
+
+	swapChain->Release();
+
+	commandList->Release();
+
+	commandAllocator->Release();
+
+	barrierCommandList->Release();
+
+	barrierCommandAllocator->Release();
+
+	commandQueue->Release();
+
+	device->Release();
+
+	useAdapter->Release();
+
+	dxgiFactory->Release();
+
+	vertexResource->Release();
+
+	indexResource->Release();
+
+	textureResource->Release();
+
+	textureUploader.Finalize();
+
+	asyncPipelineCompiler.Finalize();
+
+	//展開にJobSystemを使うので先に止める
+	asyncLoader.Finalize();
+
+	jobSystem.Finalize();
 
-	graphicsPipelineState->Release();
+	//キャッシュが持っているPSOの解放とファイルへの保存
+	pipelineStateCache.Finalize();
 
 	signatureBlob->Release();
 
@@ -0,0 +1,229 @@
+#include "Benchmark.h"
+#include "AssetArchive.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+//アセットの入れ物の書き出し、Open、Read、ReadAllの速さを測る(本来の大きさは展開して約128MB)
+//圧縮するアセット(OBJに似たテキスト)とそのまま置くアセット(乱数)を分けて、1スレッドとJobSystemの両方で測る
+//MB/sはどれも展開した大きさで数える(Openだけは入れ物のファイルの大きさ)
+
+namespace {
+
+	//OBJの頂点の行に似たテキスト(LZ4で7割くらいになる)
+	std::vector<uint8_t> MakeTextAsset(std::mt19937& random, size_t size) {
+
+		std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+
+		std::vector<uint8_t> data;
+		data.reserve(size + 64);
+
+		while (data.size() < size) {
+
+			char line[64];
+
+			int length = std::snprintf(line, sizeof(line), "v %.4f %.4f %.4f\n", value(random), value(random), value(random));
+
+			data.insert(data.end(), line, line + length);
+
+		}
+
+		data.resize(size);
+
+		return data;
+
+	}
+
+	std::vector<uint8_t> MakeRandomAsset(std::mt19937& random, size_t size) {
+
+		std::vector<uint8_t> data(size);
+
+		for (uint8_t& byte : data) {
+			byte = static_cast<uint8_t>(random() >> 24);
+		}
+
+		return data;
+
+	}
+
+	struct AssetSet {
+
+		const char* name;
+
+		AssetCompression compression;
+
+		std::vector<std::vector<uint8_t>> assets;
+
+		size_t totalSize = 0;
+
+	};
+
+	double ToMegabytesPerSecond(size_t bytes, double milliseconds) {
+		return bytes / (1024.0 * 1024.0) / milliseconds * 1000.0;
+	}
+
+}
+
+int main(int argc, char** argv) {
+
+	bool isQuick = IsQuickBenchmark(argc, argv);
+
+	//4MBを16個ずつ
+	size_t assetSize = isQuick ? 256 * 1024 : 4 * 1024 * 1024;
+
+	int assetCount = isQuick ? 4 : 16;
+
+	int repeatCount = isQuick ? 1 : 3;
+
+	//Readは64KBずつ、どのアセットの中も同じ数だけ読む
+	const size_t kReadSize = 64 * 1024;
+
+	int readCount = isQuick ? 64 : 2048;
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	std::mt19937 random(1234);
+
+	AssetSet sets[] = {
+		{ "compressed", AssetCompression::kLz4, {} },
+		{ "stored", AssetCompression::kNone, {} },
+	};
+
+	for (int i = 0; i < assetCount; ++i) {
+		sets[0].assets.push_back(MakeTextAsset(random, assetSize));
+		sets[1].assets.push_back(MakeRandomAsset(random, assetSize));
+	}
+
+	std::printf("%d assets of %.1f MB per set, %u threads\n", assetCount, assetSize / (1024.0 * 1024.0), jobSystem.GetThreadCount());
+	std::printf("  %-10s %-8s %10s %10s %10s %10s %10s %10s\n", "MB/s", "", "pak MB", "pack", "open", "read", "read all", "ratio");
+
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "AssetArchiveBenchmark.pak";
+
+	int result = 0;
+
+	for (AssetSet& set : sets) {
+
+		AssetArchiveWriter writer;
+
+		for (int i = 0; i < assetCount; ++i) {
+			writer.AddEntry("assets/" + std::string(set.name) + "_" + std::to_string(i) + ".bin", set.assets[i].data(), set.assets[i].size(), set.compression);
+			set.totalSize += set.assets[i].size();
+		}
+
+		for (JobSystem* jobs : { static_cast<JobSystem*>(nullptr), &jobSystem }) {
+
+			std::vector<uint8_t> packed;
+
+			double packMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+				packed = writer.WriteToMemory(jobs);
+			});
+
+			if (packed.empty() || !writer.Write(path.string().c_str(), jobs)) {
+				std::printf("  %s: failed to pack\n", set.name);
+				result = 1;
+				continue;
+			}
+
+			bool isOpened = true;
+
+			double openMilliseconds = MeasureBestMilliseconds(repeatCount * 10, [&]() {
+				AssetArchive archive;
+				isOpened = isOpened && archive.Open(path.string().c_str());
+				KeepValue(archive.GetEntryCount());
+			});
+
+			AssetArchive archive;
+
+			if (!isOpened || !archive.Open(path.string().c_str())) {
+				std::printf("  %s: failed to open\n", set.name);
+				result = 1;
+				continue;
+			}
+
+			std::vector<uint32_t> indices;
+
+			for (int i = 0; i < assetCount; ++i) {
+				indices.push_back(archive.Find("assets/" + std::string(set.name) + "_" + std::to_string(i) + ".bin"));
+			}
+
+			//ブロックの境目をまたぐ位置から読む。jobSystemがあれば読みを並べて走らせる
+			//読んだ中身を元と比べるのは測り終えてから1度だけ行う
+			std::atomic<int> mismatchCount = 0;
+
+			bool isVerifying = false;
+
+			auto readRange = [&](size_t begin, size_t end) {
+
+				std::vector<uint8_t> buffer(kReadSize);
+
+				for (size_t i = begin; i < end; ++i) {
+
+					uint32_t asset = static_cast<uint32_t>(i % assetCount);
+
+					uint64_t offset = (i * 40503 * 1024) % (assetSize - kReadSize);
+
+					bool isRead = archive.Read(indices[asset], offset, kReadSize, buffer.data());
+
+					if (!isRead || (isVerifying && !std::equal(buffer.begin(), buffer.end(), set.assets[asset].begin() + offset))) {
+						mismatchCount++;
+					}
+
+				}
+
+			};
+
+			double readMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+				if (jobs != nullptr) {
+					jobs->ParallelFor(readCount, 16, readRange);
+				} else {
+					readRange(0, readCount);
+				}
+			});
+
+			isVerifying = true;
+
+			readRange(0, readCount);
+
+			std::vector<std::vector<uint8_t>> destinations(assetCount, std::vector<uint8_t>(assetSize));
+
+			double readAllMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+				for (int i = 0; i < assetCount; ++i) {
+					if (!archive.ReadAll(indices[i], destinations[i].data(), jobs)) {
+						mismatchCount++;
+					}
+				}
+			});
+
+			if (destinations != set.assets) {
+				mismatchCount++;
+			}
+
+			if (mismatchCount > 0) {
+				std::printf("  %s: %d reads failed or differ from the source\n", set.name, mismatchCount.load());
+				result = 1;
+			}
+
+			size_t archiveSize = static_cast<size_t>(std::filesystem::file_size(path));
+
+			std::printf("  %-10s %-8s %10.1f %10.1f %10.0f %10.1f %10.1f %9.1f%%\n", set.name, jobs != nullptr ? "jobs" : "single", archiveSize / (1024.0 * 1024.0),
+				ToMegabytesPerSecond(set.totalSize, packMilliseconds), ToMegabytesPerSecond(archiveSize, openMilliseconds),
+				ToMegabytesPerSecond(size_t(readCount) * kReadSize, readMilliseconds), ToMegabytesPerSecond(set.totalSize, readAllMilliseconds),
+				100.0 * archiveSize / set.totalSize);
+
+		}
+
+	}
+
+	jobSystem.Finalize();
+
+	std::filesystem::remove(path);
+
+	return result;
+
+}
@@ -0,0 +1,320 @@
+#include "TestFramework.h"
+#include "AssetArchive.h"
+#include "JobSystem.h"
+#include "Lz4.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+	//圧縮して展開し直し、元に戻ることと大きさを間違えると失敗することを確かめる
+	void CheckLz4RoundTrip(const std::vector<uint8_t>& source) {
+
+		std::vector<uint8_t> compressed(GetLz4CompressBound(source.size()));
+
+		size_t compressedSize = CompressLz4(source.data(), source.size(), compressed.data(), compressed.size());
+
+		CHECK(compressedSize != 0);
+
+		std::vector<uint8_t> decompressed(source.size() + 1);
+
+		CHECK(DecompressLz4(compressed.data(), compressedSize, decompressed.data(), source.size()));
+		CHECK(std::equal(source.begin(), source.end(), decompressed.begin()));
+
+		if (!source.empty()) {
+			CHECK(!DecompressLz4(compressed.data(), compressedSize, decompressed.data(), source.size() - 1));
+		}
+
+		CHECK(!DecompressLz4(compressed.data(), compressedSize, decompressed.data(), source.size() + 1));
+
+	}
+
+	std::string MakeAssetName(int index) {
+		return "Dir" + std::to_string(index % 10) + "\\Asset_" + std::to_string(index) + ".BIN";
+	}
+
+	//圧縮できるもの、できないもの、空のもの、複数ブロックにまたがるものを混ぜる
+	std::vector<std::vector<uint8_t>> MakeAssets(std::mt19937& random, int count) {
+
+		std::vector<std::vector<uint8_t>> assets(count);
+
+		for (int i = 0; i < count; ++i) {
+
+			size_t size = i % 25 == 0 ? 0 : random() % (i % 7 == 0 ? 400000 : 20000);
+
+			bool isRandom = i % 3 == 0;
+
+			assets[i].resize(size);
+
+			for (size_t k = 0; k < size; ++k) {
+				assets[i][k] = isRandom ? static_cast<uint8_t>(random()) : static_cast<uint8_t>((k * 7 / (1 + i % 5)) ^ (k >> 9));
+			}
+
+		}
+
+		return assets;
+
+	}
+
+	std::vector<uint8_t> WriteArchive(const std::vector<std::vector<uint8_t>>& assets, JobSystem* jobSystem) {
+
+		AssetArchiveWriter writer;
+
+		for (size_t i = 0; i < assets.size(); ++i) {
+			writer.AddEntry(MakeAssetName(static_cast<int>(i)), assets[i].data(), assets[i].size(), i % 11 == 0 ? AssetCompression::kNone : AssetCompression::kLz4);
+		}
+
+		return writer.WriteToMemory(jobSystem);
+
+	}
+
+	AssetArchiveEntry* GetEntries(std::vector<uint8_t>& archive) {
+
+		AssetArchiveHeader header;
+
+		std::memcpy(&header, archive.data(), sizeof(header));
+
+		return reinterpret_cast<AssetArchiveEntry*>(archive.data() + header.entryOffset);
+
+	}
+
+}
+
+TEST_CASE(Lz4RoundTripsAllSizesAndPatterns) {
+
+	std::mt19937 random(3);
+
+	for (size_t size = 0; size < 300; ++size) {
+
+		std::vector<uint8_t> source(size);
+
+		for (uint8_t& value : source) {
+			value = static_cast<uint8_t>(random() % 3);
+		}
+		CheckLz4RoundTrip(source);
+
+		for (uint8_t& value : source) {
+			value = static_cast<uint8_t>(random());
+		}
+		CheckLz4RoundTrip(source);
+
+		std::fill(source.begin(), source.end(), uint8_t(7));
+		CheckLz4RoundTrip(source);
+
+	}
+
+	for (int t = 0; t < 60; ++t) {
+
+		std::vector<uint8_t> source(random() % 200000);
+
+		for (size_t i = 0; i < source.size(); ++i) {
+			switch (t % 3) {
+			case 0: source[i] = static_cast<uint8_t>(random()); break;
+			case 1: source[i] = static_cast<uint8_t>(i / (1 + t)); break;
+			default: source[i] = static_cast<uint8_t>("abcdefgh"[random() % 8]); break;
+			}
+		}
+
+		CheckLz4RoundTrip(source);
+
+	}
+
+}
+
+TEST_CASE(Lz4FailsCleanlyOnSmallCapacityAndCorruption) {
+
+	std::mt19937 random(5);
+
+	std::vector<uint8_t> source(70000);
+
+	for (size_t i = 0; i < source.size(); ++i) {
+		source[i] = static_cast<uint8_t>((i % 97) ^ (i / 1000));
+	}
+
+	std::vector<uint8_t> small(5000);
+
+	std::vector<uint8_t> noise(10000);
+	for (uint8_t& value : noise) {
+		value = static_cast<uint8_t>(random());
+	}
+	CHECK(CompressLz4(noise.data(), noise.size(), small.data(), small.size()) == 0);
+
+	std::vector<uint8_t> compressed(GetLz4CompressBound(source.size()));
+	compressed.resize(CompressLz4(source.data(), source.size(), compressed.data(), compressed.size()));
+	REQUIRE(!compressed.empty());
+
+	//壊したものは失敗するか、出力の範囲の中で展開を終えるだけで落ちないこと
+	std::vector<uint8_t> destination(source.size());
+
+	for (int t = 0; t < 5000; ++t) {
+
+		std::vector<uint8_t> corrupted = compressed;
+
+		for (int k = 1 + random() % 4; k > 0; --k) {
+			corrupted[random() % corrupted.size()] = static_cast<uint8_t>(random());
+		}
+
+		size_t length = t % 3 == 0 ? random() % corrupted.size() : corrupted.size();
+
+		DecompressLz4(corrupted.data(), length, destination.data(), destination.size());
+
+	}
+
+}
+
+TEST_CASE(ArchiveRoundTrip) {
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	std::mt19937 random(7);
+
+	std::vector<std::vector<uint8_t>> assets = MakeAssets(random, 120);
+
+	std::vector<uint8_t> memory = WriteArchive(assets, &jobSystem);
+
+	AssetArchive archive;
+	REQUIRE(archive.OpenMemory(memory.data(), memory.size()));
+	CHECK(archive.GetEntryCount() == assets.size());
+
+	for (size_t i = 0; i < assets.size(); ++i) {
+
+		//名前は大文字小文字と区切りの向きを区別しない
+		std::string name = MakeAssetName(static_cast<int>(i));
+		std::string query = name;
+		std::transform(query.begin(), query.end(), query.begin(), [](char c) { return c == '\\' ? '/' : static_cast<char>(std::tolower(c)); });
+
+		uint32_t index = archive.Find(query);
+		REQUIRE(index != AssetArchive::kInvalidIndex);
+		CHECK(archive.Find(name) == index);
+
+		std::vector<uint8_t> data;
+		CHECK(archive.ReadAll(index, data, &jobSystem));
+		CHECK(data == assets[i]);
+
+		if (!archive.IsCompressed(index) && !assets[i].empty()) {
+			CHECK(std::memcmp(archive.GetMappedData(index), assets[i].data(), assets[i].size()) == 0);
+			CHECK((archive.GetMappedData(index) - memory.data()) % kAssetArchiveAlignment == 0);
+		}
+
+		for (int r = 0; r < 5 && !assets[i].empty(); ++r) {
+
+			uint64_t offset = random() % assets[i].size();
+			uint64_t size = random() % (assets[i].size() - offset + 1);
+
+			std::vector<uint8_t> part(size);
+			CHECK(archive.Read(index, offset, size, part.data()));
+			CHECK(std::equal(part.begin(), part.end(), assets[i].begin() + offset));
+
+		}
+
+		CHECK(!archive.Read(index, assets[i].size(), 1, nullptr));
+
+	}
+
+	CHECK(archive.Find("missing") == AssetArchive::kInvalidIndex);
+
+	jobSystem.Finalize();
+
+}
+
+TEST_CASE(ArchiveRejectsDuplicateNames) {
+
+	uint8_t data = 0;
+
+	AssetArchiveWriter writer;
+	writer.AddEntry("A", &data, 1);
+	writer.AddEntry("a", &data, 1);
+
+	CHECK(writer.WriteToMemory().empty());
+
+}
+
+TEST_CASE(ArchiveRejectsTruncation) {
+
+	std::mt19937 random(11);
+
+	std::vector<std::vector<uint8_t>> assets = MakeAssets(random, 30);
+
+	std::vector<uint8_t> memory = WriteArchive(assets, nullptr);
+
+	for (size_t cut : { size_t(0), size_t(10), size_t(64), memory.size() / 2, memory.size() - 1 }) {
+		AssetArchive archive;
+		CHECK(!archive.OpenMemory(memory.data(), cut));
+	}
+
+}
+
+TEST_CASE(ArchiveSurvivesTableCorruption) {
+
+	std::mt19937 random(13);
+
+	std::vector<std::vector<uint8_t>> assets = MakeAssets(random, 60);
+
+	std::vector<uint8_t> memory = WriteArchive(assets, nullptr);
+
+	//表は最後に並ぶので後ろの方を壊す。開けてしまっても読むのは安全なこと
+	for (int t = 0; t < 2000; ++t) {
+
+		std::vector<uint8_t> corrupted = memory;
+
+		size_t position = corrupted.size() - 1 - random() % (std::min)(corrupted.size(), size_t(20000));
+		corrupted[position] ^= static_cast<uint8_t>(1 + random() % 255);
+
+		AssetArchive archive;
+
+		if (archive.OpenMemory(corrupted.data(), corrupted.size())) {
+			for (uint32_t i = 0; i < archive.GetEntryCount(); ++i) {
+				std::vector<uint8_t> data;
+				archive.ReadAll(i, data);
+			}
+		}
+
+	}
+
+}
+
+TEST_CASE(ArchiveRejectsOverflowingEntrySize) {
+
+	std::vector<uint8_t> asset(100000, 1);
+
+	AssetArchiveWriter writer;
+	writer.AddEntry("big", asset.data(), asset.size());
+
+	std::vector<uint8_t> memory = writer.WriteToMemory();
+
+	AssetArchive archive;
+	REQUIRE(archive.OpenMemory(memory.data(), memory.size()));
+	REQUIRE(archive.IsCompressed(0));
+	archive.Close();
+
+	AssetArchiveHeader header;
+	std::memcpy(&header, memory.data(), sizeof(header));
+
+	//切り上げの足し算があふれてブロックの数が0になる大きさ
+	for (uint64_t size : { ~uint64_t(0), ~uint64_t(0) - kAssetArchiveBlockSize + 2, uint64_t(UINT32_MAX) * kAssetArchiveBlockSize + 1 }) {
+
+		std::vector<uint8_t> corrupted = memory;
+
+		AssetArchiveEntry* entry = GetEntries(corrupted);
+		entry->size = size;
+		entry->blockCount = 0;
+		entry->firstBlock = header.blockCount;
+
+		CHECK(!archive.OpenMemory(corrupted.data(), corrupted.size()));
+
+	}
+
+	//中身があるのにブロックがない
+	std::vector<uint8_t> corrupted = memory;
+
+	AssetArchiveEntry* entry = GetEntries(corrupted);
+	entry->blockCount = 0;
+	entry->firstBlock = header.blockCount;
+
+	CHECK(!archive.OpenMemory(corrupted.data(), corrupted.size()));
+
+}
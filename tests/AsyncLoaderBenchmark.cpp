@@ -0,0 +1,301 @@
+#include "Benchmark.h"
+#include "AsyncLoader.h"
+#include "AssetArchive.h"
+#include "JobSystem.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+//非同期の読み込みの速さと、要求からコールバックまでの時間を測る(本来の大きさは256KBのファイルを512個)
+//io_uring、スレッドでの読み込み、1つずつfreadする場合を比べ、アーカイブの圧縮したアセットの展開も測る
+//ファイルは書いた直後でページキャッシュに載っているので、ディスクの速さではなく読み込みの仕組みの重さを見る
+
+namespace {
+
+	std::vector<uint8_t> ReadWholeFile(const std::string& path) {
+
+		std::vector<uint8_t> data;
+
+		FILE* file = std::fopen(path.c_str(), "rb");
+
+		if (file == nullptr) {
+			return data;
+		}
+
+		std::fseek(file, 0, SEEK_END);
+		data.resize(static_cast<size_t>(std::ftell(file)));
+		std::fseek(file, 0, SEEK_SET);
+
+		if (std::fread(data.data(), 1, data.size(), file) != data.size()) {
+			data.clear();
+		}
+
+		std::fclose(file);
+
+		return data;
+
+	}
+
+	//OBJの頂点の行に似たテキスト(圧縮できる)
+	std::vector<uint8_t> MakeTextBytes(std::mt19937& random, size_t size) {
+
+		std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+
+		std::vector<uint8_t> data;
+
+		while (data.size() < size) {
+
+			char line[64];
+
+			int length = std::snprintf(line, sizeof(line), "v %.4f %.4f %.4f\n", value(random), value(random), value(random));
+
+			data.insert(data.end(), line, line + length);
+
+		}
+
+		data.resize(size);
+
+		return data;
+
+	}
+
+	struct LoadResult {
+
+		double milliseconds;
+
+		AsyncLoadStatistics statistics;
+
+		//後から積んだ優先度の高い要求の待ち時間
+		float highPriorityLatency;
+
+		//要求した順に並べた読んだ中身(最後が優先度の高い要求)
+		std::vector<std::vector<uint8_t>> outputs;
+
+	};
+
+	//全部を優先度の低い要求として積み、最後に1つだけ優先度の高い要求を積む
+	template<typename Request>
+	LoadResult RunLoader(const AsyncLoaderSettings& settings, JobSystem* jobSystem, size_t requestCount, Request request) {
+
+		AsyncLoader loader;
+		loader.Initialize(settings, jobSystem);
+
+		LoadResult result{};
+		result.outputs.resize(requestCount + 1);
+
+		//中身は移すだけにして、元と比べるのは測り終えてから行う
+		size_t doneCount = 0;
+
+		BenchmarkTimer timer;
+
+		for (size_t i = 0; i < requestCount; ++i) {
+			request(loader, i, AsyncLoadPriority::kLow, [&result, &doneCount, i](AsyncLoadResult& loadResult) {
+				result.outputs[i] = std::move(loadResult.data);
+				doneCount++;
+			});
+		}
+
+		auto highPriorityStart = std::chrono::steady_clock::now();
+
+		request(loader, 0, AsyncLoadPriority::kHigh, [&](AsyncLoadResult& loadResult) {
+			result.highPriorityLatency = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - highPriorityStart).count();
+			result.outputs[requestCount] = std::move(loadResult.data);
+			doneCount++;
+		});
+
+		while (doneCount < requestCount + 1) {
+			loader.DispatchCompletions();
+			std::this_thread::yield();
+		}
+
+		result.milliseconds = timer.GetMilliseconds();
+
+		result.statistics = loader.GetStatistics();
+
+		loader.Finalize();
+
+		return result;
+
+	}
+
+	//失敗した要求(中身が空)も元と違うものとして数える
+	size_t CountMismatches(const LoadResult& result, const std::vector<std::vector<uint8_t>>& sources) {
+
+		size_t mismatchCount = 0;
+
+		for (size_t i = 0; i < sources.size(); ++i) {
+			if (result.outputs[i] != sources[i]) {
+				mismatchCount++;
+			}
+		}
+
+		if (result.outputs.back() != sources.front()) {
+			mismatchCount++;
+		}
+
+		return mismatchCount;
+
+	}
+
+	void PrintResult(const char* name, size_t bytes, const LoadResult& result, size_t requestCount) {
+		std::printf("  %-24s %10.1f %10.1f %12.3f %12.3f %12.3f %8llu\n", name, result.milliseconds, bytes / (1024.0 * 1024.0) / result.milliseconds * 1000.0,
+			result.statistics.totalLatencyMilliseconds / (requestCount + 1), result.statistics.maxLatencyMilliseconds, result.highPriorityLatency,
+			static_cast<unsigned long long>(result.statistics.batchCount));
+	}
+
+}
+
+int main(int argc, char** argv) {
+
+	bool isQuick = IsQuickBenchmark(argc, argv);
+
+	size_t fileSize = isQuick ? 64 * 1024 : 256 * 1024;
+
+	size_t fileCount = isQuick ? 32 : 512;
+
+	std::mt19937 random(1234);
+
+	std::vector<std::string> paths;
+
+	std::vector<std::vector<uint8_t>> files;
+
+	for (size_t i = 0; i < fileCount; ++i) {
+
+		paths.push_back((std::filesystem::temp_directory_path() / ("AsyncLoaderBenchmark_" + std::to_string(i) + ".bin")).string());
+
+		std::vector<uint8_t>& data = files.emplace_back(fileSize);
+
+		for (uint8_t& byte : data) {
+			byte = static_cast<uint8_t>(random() >> 24);
+		}
+
+		FILE* file = std::fopen(paths.back().c_str(), "wb");
+
+		if (file == nullptr || std::fwrite(data.data(), 1, data.size(), file) != data.size()) {
+			std::printf("failed to write %s\n", paths.back().c_str());
+			return 1;
+		}
+
+		std::fclose(file);
+
+	}
+
+	//圧縮したアセットを同じ数だけ入れたアーカイブ
+	std::string archivePath = (std::filesystem::temp_directory_path() / "AsyncLoaderBenchmark.pak").string();
+
+	std::vector<std::vector<uint8_t>> assets;
+
+	AssetArchiveWriter writer;
+
+	for (size_t i = 0; i < fileCount; ++i) {
+		assets.push_back(MakeTextBytes(random, fileSize));
+	}
+
+	for (size_t i = 0; i < fileCount; ++i) {
+		writer.AddEntry("asset" + std::to_string(i), assets[i].data(), assets[i].size());
+	}
+
+	AssetArchive archive;
+
+	if (!writer.Write(archivePath.c_str()) || !archive.Open(archivePath.c_str())) {
+		std::printf("failed to write %s\n", archivePath.c_str());
+		return 1;
+	}
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	size_t totalSize = fileSize * fileCount;
+
+	std::printf("%zu files of %zu KB (%.1f MB), %u threads\n", fileCount, fileSize / 1024, totalSize / (1024.0 * 1024.0), jobSystem.GetThreadCount());
+	std::printf("  %-24s %10s %10s %12s %12s %12s %8s\n", "", "ms", "MB/s", "avg lat ms", "max lat ms", "high lat ms", "batches");
+
+	int result = 0;
+
+	//比べる元: 1つずつfreadする
+	{
+		BenchmarkTimer timer;
+
+		size_t readSize = 0;
+
+		for (const std::string& path : paths) {
+			readSize += ReadWholeFile(path).size();
+		}
+
+		double milliseconds = timer.GetMilliseconds();
+
+		std::printf("  %-24s %10.1f %10.1f\n", "fread, one by one", milliseconds, totalSize / (1024.0 * 1024.0) / milliseconds * 1000.0);
+
+		if (readSize != totalSize) {
+			result = 1;
+		}
+	}
+
+	auto requestFile = [&](AsyncLoader& loader, size_t index, AsyncLoadPriority priority, AsyncLoadCallback callback) {
+		loader.RequestFile(paths[index].c_str(), priority, std::move(callback));
+	};
+
+	auto requestAsset = [&](AsyncLoader& loader, size_t index, AsyncLoadPriority priority, AsyncLoadCallback callback) {
+		uint32_t assetIndex = archive.Find("asset" + std::to_string(index));
+		loader.RequestAsset(&archive, archivePath.c_str(), assetIndex, 0, archive.GetSize(assetIndex), priority, std::move(callback));
+	};
+
+	struct Mode {
+		const char* name;
+		bool useIoUring;
+		uint32_t ioThreadCount;
+	};
+
+	const Mode modes[] = {
+		{ "io_uring", true, 1 },
+		{ "1 thread", false, 1 },
+		{ "4 threads", false, 4 },
+	};
+
+	for (const Mode& mode : modes) {
+
+		AsyncLoaderSettings settings;
+		settings.useIoUring = mode.useIoUring;
+		settings.ioThreadCount = mode.ioThreadCount;
+		settings.completionBudgetMilliseconds = 0.0f;
+
+		LoadResult fileResult = RunLoader(settings, nullptr, fileCount, requestFile);
+
+		std::string name = std::string("files, ") + mode.name;
+
+		if (mode.useIoUring && !fileResult.statistics.isIoUringEnabled) {
+			name += " (fell back)";
+		}
+
+		PrintResult(name.c_str(), totalSize, fileResult, fileCount);
+
+		LoadResult archiveAssets = RunLoader(settings, &jobSystem, fileCount, requestAsset);
+
+		PrintResult((std::string("lz4 assets, ") + mode.name).c_str(), totalSize, archiveAssets, fileCount);
+
+		size_t mismatchCount = CountMismatches(fileResult, files) + CountMismatches(archiveAssets, assets);
+
+		if (mismatchCount > 0) {
+			std::printf("  %s: %zu requests failed or differ from the source\n", mode.name, mismatchCount);
+			result = 1;
+		}
+
+	}
+
+	jobSystem.Finalize();
+
+	archive.Close();
+
+	for (const std::string& path : paths) {
+		std::filesystem::remove(path);
+	}
+
+	std::filesystem::remove(archivePath);
+
+	return result;
+
+}
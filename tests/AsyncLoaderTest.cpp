@@ -0,0 +1,497 @@
+#include "TestFramework.h"
+#include "AsyncLoader.h"
+#include "AssetArchive.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+	std::string GetTempPath(const std::string& name) {
+		return (std::filesystem::temp_directory_path() / ("AsyncLoaderTest_" + name)).string();
+	}
+
+	bool WriteFile(const std::string& path, const std::vector<uint8_t>& data) {
+
+		FILE* file = std::fopen(path.c_str(), "wb");
+
+		if (file == nullptr) {
+			return false;
+		}
+
+		bool isWritten = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+
+		return std::fclose(file) == 0 && isWritten;
+
+	}
+
+	std::vector<uint8_t> MakeRandomBytes(std::mt19937& random, size_t size) {
+
+		std::vector<uint8_t> data(size);
+
+		for (uint8_t& byte : data) {
+			byte = static_cast<uint8_t>(random() >> 24);
+		}
+
+		return data;
+
+	}
+
+	//圧縮できる中身
+	std::vector<uint8_t> MakePatternBytes(size_t size, uint32_t seed) {
+
+		std::vector<uint8_t> data(size);
+
+		for (size_t i = 0; i < size; ++i) {
+			data[i] = static_cast<uint8_t>((i * 7 / (1 + seed % 5)) ^ (i >> 9) ^ seed);
+		}
+
+		return data;
+
+	}
+
+	//conditionが成り立つまでコールバックを呼び続ける(止まった時にテストが終わらなくならないように上限を置く)
+	template<typename Condition>
+	bool DispatchUntil(AsyncLoader& loader, Condition condition) {
+
+		auto start = std::chrono::steady_clock::now();
+
+		while (!condition()) {
+
+			if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10)) {
+				return false;
+			}
+
+			loader.DispatchCompletions();
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		}
+
+		return true;
+
+	}
+
+	template<typename Condition>
+	bool WaitForStatistics(const AsyncLoader& loader, Condition condition) {
+
+		auto start = std::chrono::steady_clock::now();
+
+		while (!condition(loader.GetStatistics())) {
+
+			if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10)) {
+				return false;
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		}
+
+		return true;
+
+	}
+
+	AsyncLoaderSettings MakeSettings(bool useIoUring) {
+
+		AsyncLoaderSettings settings;
+		settings.useIoUring = useIoUring;
+		settings.completionBudgetMilliseconds = 0.0f;
+
+		return settings;
+
+	}
+
+}
+
+TEST_CASE(RequestsCompleteInPriorityOrder) {
+
+	std::mt19937 random(1);
+
+	std::string path = GetTempPath("priority.bin");
+
+	REQUIRE(WriteFile(path, MakeRandomBytes(random, 1000)));
+
+	//Initializeの前に積んでおくと、読み込み用のスレッドは列を全部見てから取り出し始める
+	//1スレッドで1つずつ取り出すので、完了の順は優先度の順(同じ優先度なら積んだ順)になる
+	AsyncLoader loader;
+
+	std::vector<uint64_t> order;
+
+	const AsyncLoadPriority priorities[] = {
+		AsyncLoadPriority::kLow, AsyncLoadPriority::kNormal, AsyncLoadPriority::kHigh,
+		AsyncLoadPriority::kLow, AsyncLoadPriority::kHigh, AsyncLoadPriority::kNormal,
+	};
+
+	std::vector<uint64_t> ids;
+
+	for (AsyncLoadPriority priority : priorities) {
+		ids.push_back(loader.RequestFile(path.c_str(), priority, [&](AsyncLoadResult& result) {
+			CHECK(result.status == AsyncLoadStatus::kCompleted);
+			CHECK(result.data.size() == 1000);
+			order.push_back(result.id);
+		}));
+	}
+
+	CHECK(loader.GetStatistics().queuedCount == 6);
+
+	AsyncLoaderSettings settings = MakeSettings(false);
+	settings.ioThreadCount = 1;
+	settings.maxBatchSize = 1;
+
+	loader.Initialize(settings, nullptr);
+
+	REQUIRE(DispatchUntil(loader, [&] { return order.size() == ids.size(); }));
+
+	std::vector<uint64_t> expected = { ids[2], ids[4], ids[1], ids[5], ids[0], ids[3] };
+
+	CHECK(order == expected);
+
+	AsyncLoadStatistics statistics = loader.GetStatistics();
+
+	CHECK(statistics.completedCount == 6);
+	CHECK(statistics.readSize == 6000);
+	CHECK(statistics.queuedCount == 0 && statistics.inFlightCount == 0 && statistics.readyCount == 0);
+
+	loader.Finalize();
+
+	std::filesystem::remove(path);
+
+}
+
+TEST_CASE(CancelWhileQueuedAndAfterDispatch) {
+
+	std::mt19937 random(2);
+
+	std::string path = GetTempPath("cancel.bin");
+
+	REQUIRE(WriteFile(path, MakeRandomBytes(random, 100)));
+
+	AsyncLoader loader;
+
+	std::vector<AsyncLoadStatus> statuses;
+
+	//コールバックの中から自分を取り消しても、もう渡した結果は変わらない
+	bool isCanceledInCallback = true;
+
+	AsyncLoadCallback callback = [&](AsyncLoadResult& result) {
+		statuses.push_back(result.status);
+		isCanceledInCallback = loader.Cancel(result.id);
+	};
+
+	uint64_t queued = loader.RequestFile(path.c_str(), AsyncLoadPriority::kNormal, callback);
+	uint64_t kept = loader.RequestFile(path.c_str(), AsyncLoadPriority::kNormal, callback);
+
+	//列で待っているものはすぐ外れ、読み込み用のスレッドがなくても次のDispatchCompletionsで返る
+	CHECK(loader.Cancel(queued));
+	CHECK(loader.GetStatistics().queuedCount == 1);
+	CHECK(loader.GetStatistics().readyCount == 1);
+
+	loader.DispatchCompletions();
+
+	REQUIRE(statuses.size() == 1);
+	CHECK(statuses[0] == AsyncLoadStatus::kCanceled);
+	CHECK(!isCanceledInCallback);
+
+	//コールバックを呼んだ後と、知らないid
+	CHECK(!loader.Cancel(queued));
+	CHECK(!loader.Cancel(AsyncLoader::kInvalidId));
+
+	loader.Initialize(MakeSettings(false), nullptr);
+
+	REQUIRE(DispatchUntil(loader, [&] { return statuses.size() == 2; }));
+
+	CHECK(statuses[1] == AsyncLoadStatus::kCompleted);
+	CHECK(!isCanceledInCallback);
+	CHECK(!loader.Cancel(kept));
+
+	loader.Finalize();
+
+	std::filesystem::remove(path);
+
+}
+
+TEST_CASE(CancelWhileInFlightAndReady) {
+
+	//圧縮したアセットの展開をJobSystemの1つだけのワーカーに回し、先に積んだ仕事で止めておく
+	std::string path = GetTempPath("cancel.pak");
+
+	std::vector<uint8_t> asset = MakePatternBytes(300000, 3);
+
+	AssetArchiveWriter writer;
+	writer.AddEntry("asset", asset.data(), asset.size());
+
+	REQUIRE(writer.Write(path.c_str()));
+
+	AssetArchive archive;
+	REQUIRE(archive.Open(path.c_str()));
+	REQUIRE(archive.IsCompressed(0));
+
+	JobSystem jobSystem;
+	jobSystem.Initialize(1);
+
+	AsyncLoader loader;
+	loader.Initialize(MakeSettings(true), &jobSystem);
+
+	std::atomic<bool> isBlocked = true;
+
+	jobSystem.Schedule([&] {
+		while (isBlocked) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	std::vector<AsyncLoadResult> results;
+
+	AsyncLoadCallback callback = [&](AsyncLoadResult& result) { results.push_back(std::move(result)); };
+
+	uint64_t inFlight = loader.RequestAsset(&archive, path.c_str(), 0, 0, asset.size(), AsyncLoadPriority::kNormal, callback);
+
+	REQUIRE(inFlight != AsyncLoader::kInvalidId);
+
+	//読み終わって展開を待っている
+	REQUIRE(WaitForStatistics(loader, [](const AsyncLoadStatistics& statistics) { return statistics.batchCount == 1 && statistics.inFlightCount == 1; }));
+
+	CHECK(loader.Cancel(inFlight));
+
+	//取り消さずに展開まで終わったもの
+	uint64_t ready = loader.RequestAsset(&archive, path.c_str(), 0, 1000, 70000, AsyncLoadPriority::kNormal, callback);
+
+	REQUIRE(WaitForStatistics(loader, [](const AsyncLoadStatistics& statistics) { return statistics.batchCount == 2 && statistics.inFlightCount == 2; }));
+
+	isBlocked = false;
+
+	REQUIRE(WaitForStatistics(loader, [](const AsyncLoadStatistics& statistics) { return statistics.readyCount == 2; }));
+
+	CHECK(loader.Cancel(ready));
+
+	loader.DispatchCompletions();
+
+	REQUIRE(results.size() == 2);
+	CHECK(results[0].id == inFlight);
+	CHECK(results[0].status == AsyncLoadStatus::kCanceled);
+	CHECK(results[0].data.empty());
+	CHECK(results[1].id == ready);
+	CHECK(results[1].status == AsyncLoadStatus::kCanceled);
+	CHECK(results[1].data.empty());
+
+	CHECK(loader.GetStatistics().canceledCount == 2);
+
+	//取り消さなければ展開したものが返る
+	uint64_t completed = loader.RequestAsset(&archive, path.c_str(), 0, 1000, 70000, AsyncLoadPriority::kNormal, callback);
+
+	REQUIRE(DispatchUntil(loader, [&] { return results.size() == 3; }));
+
+	CHECK(results[2].id == completed);
+	CHECK(results[2].status == AsyncLoadStatus::kCompleted);
+	CHECK(results[2].data.size() == 70000);
+	CHECK(std::equal(results[2].data.begin(), results[2].data.end(), asset.begin() + 1000));
+
+	loader.Finalize();
+	jobSystem.Finalize();
+
+	archive.Close();
+
+	std::filesystem::remove(path);
+
+}
+
+TEST_CASE(FailedOpensAndOutOfRangeReads) {
+
+	std::string path = GetTempPath("range.pak");
+
+	std::vector<uint8_t> asset = MakePatternBytes(200000, 4);
+
+	AssetArchiveWriter writer;
+	writer.AddEntry("compressed", asset.data(), asset.size());
+	writer.AddEntry("stored", asset.data(), asset.size(), AssetCompression::kNone);
+
+	std::vector<uint8_t> memory = writer.WriteToMemory();
+
+	REQUIRE(WriteFile(path, memory));
+
+	AssetArchive archive;
+	REQUIRE(archive.OpenMemory(memory.data(), memory.size()));
+
+	uint32_t compressed = archive.Find("compressed");
+	uint32_t stored = archive.Find("stored");
+
+	for (bool useIoUring : { true, false }) {
+
+		AsyncLoader loader;
+		loader.Initialize(MakeSettings(useIoUring), nullptr);
+
+		//アセットの範囲を外れた要求は積まない
+		CHECK(loader.RequestAsset(&archive, path.c_str(), stored, asset.size(), 1, AsyncLoadPriority::kNormal, nullptr) == AsyncLoader::kInvalidId);
+		CHECK(loader.RequestAsset(&archive, path.c_str(), compressed, 1, asset.size(), AsyncLoadPriority::kNormal, nullptr) == AsyncLoader::kInvalidId);
+
+		std::vector<AsyncLoadResult> results;
+
+		AsyncLoadCallback callback = [&](AsyncLoadResult& result) { results.push_back(std::move(result)); };
+
+		loader.RequestFile(GetTempPath("missing.bin").c_str(), AsyncLoadPriority::kNormal, callback);
+		loader.RequestAsset(&archive, GetTempPath("missing.pak").c_str(), stored, 0, 10, AsyncLoadPriority::kNormal, callback);
+
+		REQUIRE(DispatchUntil(loader, [&] { return results.size() == 2; }));
+
+		for (const AsyncLoadResult& result : results) {
+			CHECK(result.status == AsyncLoadStatus::kFailed);
+			CHECK(result.data.empty());
+		}
+
+		//ディスクのファイルが目次より短い(そのまま置いたアセットの途中で切れていて、ファイルの終わりを越えて読む)
+		uint64_t storedOffset = 0;
+		uint64_t storedSize = 0;
+
+		REQUIRE(archive.GetStoredRange(stored, 0, asset.size(), storedOffset, storedSize));
+
+		std::filesystem::resize_file(path, storedOffset + storedSize / 2);
+
+		results.clear();
+
+		loader.RequestAsset(&archive, path.c_str(), stored, 0, asset.size(), AsyncLoadPriority::kNormal, callback);
+
+		//切れた位置より前は読める
+		loader.RequestAsset(&archive, path.c_str(), stored, 0, storedSize / 4, AsyncLoadPriority::kNormal, callback);
+
+		REQUIRE(DispatchUntil(loader, [&] { return results.size() == 2; }));
+
+		std::sort(results.begin(), results.end(), [](const AsyncLoadResult& a, const AsyncLoadResult& b) { return a.id < b.id; });
+
+		CHECK(results[0].status == AsyncLoadStatus::kFailed);
+		CHECK(results[0].data.empty());
+		CHECK(results[1].status == AsyncLoadStatus::kCompleted);
+		CHECK(results[1].data.size() == storedSize / 4);
+		CHECK(std::equal(results[1].data.begin(), results[1].data.end(), asset.begin()));
+
+		CHECK(loader.GetStatistics().failedCount == 3);
+
+		loader.Finalize();
+
+		REQUIRE(WriteFile(path, memory));
+
+	}
+
+	std::filesystem::remove(path);
+
+}
+
+TEST_CASE(IoUringAndThreadsReadSameBytes) {
+
+	std::mt19937 random(5);
+
+	//空、1バイト、ページの境目の前後、複数のまとめにまたがる数
+	const size_t sizes[] = { 0, 1, 4095, 4096, 4097, 65536 * 3 + 5, 1 << 20 };
+
+	std::vector<std::string> paths;
+	std::vector<std::vector<uint8_t>> contents;
+
+	for (int i = 0; i < 70; ++i) {
+		paths.push_back(GetTempPath("file" + std::to_string(i) + ".bin"));
+		contents.push_back(MakeRandomBytes(random, sizes[i % std::size(sizes)]));
+		REQUIRE(WriteFile(paths.back(), contents.back()));
+	}
+
+	//アーカイブの一部だけを読む要求も混ぜる
+	std::string archivePath = GetTempPath("same.pak");
+
+	std::vector<uint8_t> pattern = MakePatternBytes(500000, 6);
+	std::vector<uint8_t> noise = MakeRandomBytes(random, 300000);
+
+	AssetArchiveWriter writer;
+	writer.AddEntry("pattern", pattern.data(), pattern.size());
+	writer.AddEntry("noise", noise.data(), noise.size(), AssetCompression::kNone);
+
+	REQUIRE(writer.Write(archivePath.c_str()));
+
+	AssetArchive archive;
+	REQUIRE(archive.Open(archivePath.c_str()));
+
+	JobSystem jobSystem;
+	jobSystem.Initialize(2);
+
+	std::vector<std::vector<uint8_t>> resultsByMode[2];
+
+	bool isIoUringUsed[2] = {};
+
+	for (int mode = 0; mode < 2; ++mode) {
+
+		AsyncLoaderSettings settings = MakeSettings(mode == 0);
+		settings.maxBatchSize = 32;
+
+		AsyncLoader loader;
+		loader.Initialize(settings, &jobSystem);
+
+		std::vector<std::vector<uint8_t>>& results = resultsByMode[mode];
+
+		results.resize(paths.size() + 2);
+
+		std::atomic<size_t> doneCount = 0;
+
+		bool isAllCompleted = true;
+
+		for (size_t i = 0; i < paths.size(); ++i) {
+			loader.RequestFile(paths[i].c_str(), static_cast<AsyncLoadPriority>(i % 3), [&, i](AsyncLoadResult& result) {
+				isAllCompleted = isAllCompleted && result.status == AsyncLoadStatus::kCompleted;
+				results[i] = std::move(result.data);
+				doneCount++;
+			});
+		}
+
+		size_t patternIndex = paths.size();
+
+		loader.RequestAsset(&archive, archivePath.c_str(), archive.Find("pattern"), 70000, 200001, AsyncLoadPriority::kHigh, [&](AsyncLoadResult& result) {
+			isAllCompleted = isAllCompleted && result.status == AsyncLoadStatus::kCompleted;
+			results[patternIndex] = std::move(result.data);
+			doneCount++;
+		});
+
+		loader.RequestAsset(&archive, archivePath.c_str(), archive.Find("noise"), 123, 4567, AsyncLoadPriority::kLow, [&](AsyncLoadResult& result) {
+			isAllCompleted = isAllCompleted && result.status == AsyncLoadStatus::kCompleted;
+			results[patternIndex + 1] = std::move(result.data);
+			doneCount++;
+		});
+
+		REQUIRE(DispatchUntil(loader, [&] { return doneCount == results.size(); }));
+
+		CHECK(isAllCompleted);
+
+		isIoUringUsed[mode] = loader.GetStatistics().isIoUringEnabled;
+
+		loader.Finalize();
+
+		for (size_t i = 0; i < paths.size(); ++i) {
+			CHECK(results[i] == contents[i]);
+		}
+
+		CHECK(std::equal(results[patternIndex].begin(), results[patternIndex].end(), pattern.begin() + 70000) && results[patternIndex].size() == 200001);
+		CHECK(std::equal(results[patternIndex + 1].begin(), results[patternIndex + 1].end(), noise.begin() + 123) && results[patternIndex + 1].size() == 4567);
+
+	}
+
+	//io_uringが使えない環境(古いカーネルやseccomp)では両方ともスレッドで読む
+	if (!isIoUringUsed[0]) {
+		std::printf("  io_uring is not available, both runs used the thread fallback\n");
+	}
+
+	CHECK(!isIoUringUsed[1]);
+	CHECK(resultsByMode[0] == resultsByMode[1]);
+
+	jobSystem.Finalize();
+
+	archive.Close();
+
+	for (const std::string& path : paths) {
+		std::filesystem::remove(path);
+	}
+
+	std::filesystem::remove(archivePath);
+
+}
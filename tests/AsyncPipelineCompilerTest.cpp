@@ -0,0 +1,142 @@
+#include "TestFramework.h"
+#include "AsyncPipelineCompiler.h"
+#include "PipelineStateCache.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+//PipelineStateCacheはD3D12のデバイスが要るので、テストではここで偽のものを定義する
+//ピクセルシェーダーのないDescは作成に失敗したことにして、作成を何回呼んだかを数える
+
+namespace {
+
+	const uint8_t kVertexShader[] = { 1, 2, 3, 4 };
+	const uint8_t kPixelShader[] = { 5, 6, 7, 8 };
+
+	std::atomic<uint32_t> compileCallCount{ 0 };
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC MakeDesc(bool hasPixelShader) {
+
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+		std::memset(&desc, 0, sizeof(desc));
+
+		desc.VS = { kVertexShader, sizeof(kVertexShader) };
+
+		if (hasPixelShader) {
+			desc.PS = { kPixelShader, sizeof(kPixelShader) };
+		}
+
+		desc.NumRenderTargets = 1;
+		desc.SampleDesc = { 1, 0 };
+
+		return desc;
+
+	}
+
+	//依頼したものが全て終わるまで待つ
+	bool WaitUntilIdle(const AsyncPipelineCompiler& compiler, uint64_t hash) {
+
+		for (int i = 0; i < 2000; ++i) {
+			if (!compiler.IsPending(hash)) {
+				return true;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		return false;
+
+	}
+
+}
+
+uint64_t PipelineStateCache::ComputeHash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) const {
+	return HashGraphicsPipelineStateDesc(desc, 0);
+}
+
+ID3D12PipelineState* PipelineStateCache::CompileGraphicsPipelineState(uint64_t hash, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) {
+
+	compileCallCount++;
+
+	if (desc.PS.BytecodeLength == 0) {
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	ID3D12PipelineState*& pipelineState = pipelineStates_[hash];
+
+	if (pipelineState == nullptr) {
+		pipelineState = new ID3D12PipelineState();
+	}
+
+	return pipelineState;
+
+}
+
+ID3D12PipelineState* PipelineStateCache::FindGraphicsPipelineState(uint64_t hash) const {
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto it = pipelineStates_.find(hash);
+
+	return it != pipelineStates_.end() ? it->second : nullptr;
+
+}
+
+void PipelineStateCache::Finalize() {
+
+	for (auto& [hash, pipelineState] : pipelineStates_) {
+		delete pipelineState;
+	}
+
+	pipelineStates_.clear();
+
+}
+
+TEST_CASE(FailedCompileIsNotRequeued) {
+
+	PipelineStateCache cache;
+
+	AsyncPipelineCompiler compiler;
+	compiler.Initialize(&cache, 2);
+
+	ID3D12PipelineState fallback;
+
+	compileCallCount = 0;
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC good = MakeDesc(true);
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC bad = MakeDesc(false);
+
+	uint64_t goodHash = compiler.Request(good);
+	uint64_t badHash = compiler.Request(bad);
+
+	REQUIRE(WaitUntilIdle(compiler, goodHash));
+	REQUIRE(WaitUntilIdle(compiler, badHash));
+
+	CHECK(compiler.GetPipelineState(goodHash, &fallback) != &fallback);
+	CHECK(!compiler.IsFailed(goodHash));
+
+	//失敗したものはフォールバックのまま
+	CHECK(compiler.IsFailed(badHash));
+	CHECK(compiler.GetPipelineState(badHash, &fallback) == &fallback);
+
+	//毎フレーム依頼しても作り直さない
+	for (int frame = 0; frame < 100; ++frame) {
+		CHECK(compiler.Request(bad) == badHash);
+		CHECK(!compiler.IsPending(badHash));
+		CHECK(compiler.Request(good) == goodHash);
+	}
+
+	PipelineCompileStatistics statistics = compiler.GetStatistics();
+
+	CHECK(compileCallCount == 2);
+	CHECK(statistics.compiledCount == 1);
+	CHECK(statistics.failedCount == 1);
+	CHECK(statistics.queueDepth == 0);
+
+	compiler.Finalize();
+
+	cache.Finalize();
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+//ベンチマークの共通部分
+//--quickを渡すと小さな大きさで動かす(ctestで壊れていないことだけ確かめる)
+
+inline bool IsQuickBenchmark(int argc, char** argv) {
+
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--quick") == 0) {
+			return true;
+		}
+	}
+
+	return false;
+
+}
+
+class BenchmarkTimer {
+
+public:
+
+	BenchmarkTimer() : start_(std::chrono::steady_clock::now()) {}
+
+	double GetMilliseconds() const {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+	}
+
+private:
+
+	std::chrono::steady_clock::time_point start_;
+
+};
+
+//functionをrepeatCount回動かして一番速かった時間(ミリ秒)を返す
+template<typename Function>
+double MeasureBestMilliseconds(int repeatCount, Function&& function) {
+
+	double best = 0.0;
+
+	for (int i = 0; i < repeatCount; ++i) {
+
+		BenchmarkTimer timer;
+
+		function();
+
+		double milliseconds = timer.GetMilliseconds();
+
+		if (i == 0 || milliseconds < best) {
+			best = milliseconds;
+		}
+
+	}
+
+	return best;
+
+}
+
+//プロセスが起動してから使った物理メモリの最大(MB)。測れない環境では負の数を返す
+inline double GetPeakMemoryMegabytes() {
+#if defined(_WIN32)
+	return -1.0;
+#else
+	rusage usage{};
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return -1.0;
+	}
+
+	//Linuxのru_maxrssはKB単位
+	return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+//結果を使ったことにして最適化で消されないようにする
+template<typename T>
+inline void KeepValue(const T& value) {
+#if defined(__GNUC__)
+	asm volatile("" : : "g"(&value) : "memory");
+#else
+	static const void* volatile sink;
+	sink = &value;
+#endif
+}
@@ -0,0 +1,223 @@
+#include "Benchmark.h"
+#include "BinaryMesh.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+
+//焼き込んだメッシュ(.mesh)を開く速さを、元のOBJを読む速さと比べる(本来の大きさはOBJで約100MB)
+//Openはヘッダーと表だけを見るので、中身を全部読んだ時間(頂点とインデックスを1度ずつ触る)も並べる
+//ファイルはどちらも書いた直後でページキャッシュに載っている
+
+namespace {
+
+	void AppendFloat(std::string& text, float value) {
+
+		char buffer[32];
+
+		int length = std::snprintf(buffer, sizeof(buffer), " %.6f", value);
+
+		text.append(buffer, length);
+
+	}
+
+	//位置、UV、法線と四角形の面を書いたOBJ。書いたバイト数を返す(失敗したら0)
+	size_t WriteObjFile(const char* path, int gridSize) {
+
+		FILE* file = std::fopen(path, "wb");
+
+		if (file == nullptr) {
+			return 0;
+		}
+
+		std::mt19937 random(1234);
+
+		std::uniform_real_distribution<float> noise(-0.01f, 0.01f);
+
+		std::string text;
+
+		size_t size = 0;
+
+		bool isSucceeded = true;
+
+		auto flush = [&]() {
+			isSucceeded = isSucceeded && std::fwrite(text.data(), 1, text.size(), file) == text.size();
+			size += text.size();
+			text.clear();
+		};
+
+		int rowCount = gridSize + 1;
+
+		for (int z = 0; z < rowCount; ++z) {
+
+			for (int x = 0; x < rowCount; ++x) {
+
+				text += "v";
+				AppendFloat(text, x * 0.01f + noise(random));
+				AppendFloat(text, noise(random));
+				AppendFloat(text, z * 0.01f + noise(random));
+				text += "\nvt";
+				AppendFloat(text, float(x) / gridSize);
+				AppendFloat(text, float(z) / gridSize);
+				text += "\nvn";
+				AppendFloat(text, noise(random));
+				AppendFloat(text, 1.0f);
+				AppendFloat(text, noise(random));
+				text += "\n";
+
+			}
+
+			flush();
+
+		}
+
+		for (int z = 0; z < gridSize; ++z) {
+
+			for (int x = 0; x < gridSize; ++x) {
+
+				int index = z * rowCount + x + 1;
+
+				int corners[4] = { index, index + 1, index + rowCount + 1, index + rowCount };
+
+				text += "f";
+
+				for (int corner : corners) {
+					std::string value = std::to_string(corner);
+					text += " " + value + "/" + value + "/" + value;
+				}
+
+				text += "\n";
+
+			}
+
+			flush();
+
+		}
+
+		std::fclose(file);
+
+		return isSucceeded ? size : 0;
+
+	}
+
+	//頂点とインデックスを全部読む(マップしたページを触らせる)
+	uint64_t TouchMesh(const MeshView& view) {
+
+		uint64_t sum = 0;
+
+		for (size_t i = 0; i < view.vertexCount; ++i) {
+			uint32_t bits;
+			std::memcpy(&bits, &view.vertices[i].position.x, sizeof(bits));
+			sum += bits;
+		}
+
+		for (size_t i = 0; i < view.indexCount; ++i) {
+			sum += view.indices[i];
+		}
+
+		return sum;
+
+	}
+
+}
+
+int main(int argc, char** argv) {
+
+	bool isQuick = IsQuickBenchmark(argc, argv);
+
+	//800なら約101MB
+	int gridSize = isQuick ? 120 : 800;
+
+	int repeatCount = isQuick ? 1 : 5;
+
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+
+	std::string objPath = (directory / "BinaryMeshBenchmark.obj").string();
+	std::string meshPath = (directory / "BinaryMeshBenchmark.mesh").string();
+
+	size_t objSize = WriteObjFile(objPath.c_str(), gridSize);
+
+	if (objSize == 0) {
+		std::printf("failed to write %s\n", objPath.c_str());
+		return 1;
+	}
+
+	int result = 0;
+
+	MeshData imported;
+
+	bool isImported = true;
+
+	double importMilliseconds = MeasureBestMilliseconds(isQuick ? 1 : 3, [&]() {
+		imported = MeshData();
+		isImported = ImportObj(objPath.c_str(), imported, nullptr);
+	});
+
+	BenchmarkTimer bakeTimer;
+
+	bool isBaked = isImported && WriteBinaryMesh(meshPath.c_str(), imported);
+
+	double bakeMilliseconds = bakeTimer.GetMilliseconds();
+
+	if (!isBaked) {
+		std::printf("failed to import or bake the mesh\n");
+		std::filesystem::remove(objPath);
+		return 1;
+	}
+
+	size_t meshSize = static_cast<size_t>(std::filesystem::file_size(meshPath));
+
+	uint64_t expectedSum = TouchMesh(MakeMeshView(imported));
+
+	std::printf("obj %.1f MB -> mesh %.1f MB, %zu vertices, %zu triangles\n", objSize / (1024.0 * 1024.0), meshSize / (1024.0 * 1024.0), imported.vertices.size(), imported.indices.size() / 3);
+	std::printf("  %-28s %10.2f ms\n", "ImportObj (single thread)", importMilliseconds);
+	std::printf("  %-28s %10.2f ms\n", "WriteBinaryMesh", bakeMilliseconds);
+	std::printf("  %-28s %10s %14s %10s\n", "BinaryMesh::Open", "open ms", "open+read ms", "vs obj");
+
+	struct Verify {
+		const char* name;
+		uint32_t flags;
+	};
+
+	const Verify verifies[] = {
+		{ "no verification", kBinaryMeshVerifyNone },
+		{ "checksum", kBinaryMeshVerifyChecksum },
+		{ "indices", kBinaryMeshVerifyIndices },
+		{ "checksum + indices", kBinaryMeshVerifyChecksum | kBinaryMeshVerifyIndices },
+	};
+
+	for (const Verify& verify : verifies) {
+
+		bool isOpened = true;
+
+		double openMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			BinaryMesh mesh;
+			isOpened = isOpened && mesh.Open(meshPath.c_str(), verify.flags);
+			KeepValue(mesh.GetVertices());
+		});
+
+		uint64_t sum = 0;
+
+		double readMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			BinaryMesh mesh;
+			isOpened = isOpened && mesh.Open(meshPath.c_str(), verify.flags);
+			sum = TouchMesh(mesh.GetView());
+		});
+
+		if (!isOpened || sum != expectedSum) {
+			std::printf("  %-28s failed to open or differs from the imported mesh\n", verify.name);
+			result = 1;
+			continue;
+		}
+
+		std::printf("  %-28s %10.2f %14.2f %9.0fx\n", verify.name, openMilliseconds, readMilliseconds, importMilliseconds / readMilliseconds);
+
+	}
+
+	std::filesystem::remove(objPath);
+	std::filesystem::remove(meshPath);
+
+	return result;
+
+}
@@ -0,0 +1,251 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "BinaryMesh.h"
+#include "Meshlet.h"
+#include "MeshSimplifier.h"
+#include "OcclusionCulling.h"
+#include "Picking.h"
+#include <cstring>
+#include <random>
+
+namespace {
+
+	std::vector<uint8_t> WriteMesh(const MeshData& mesh) {
+
+		BinaryMeshWriter writer;
+
+		writer.AddSection(BinaryMeshSectionType::kVertices, sizeof(MeshVertex), mesh.vertices.data(), mesh.vertices.size());
+		writer.AddSection(BinaryMeshSectionType::kIndices, sizeof(uint32_t), mesh.indices.data(), mesh.indices.size());
+		writer.AddSection(BinaryMeshSectionType::kLods, sizeof(MeshLod), mesh.lods.data(), mesh.lods.size());
+		writer.AddSection(BinaryMeshSectionType::kMeshlets, sizeof(Meshlet), mesh.meshlets.data(), mesh.meshlets.size());
+		writer.AddSection(BinaryMeshSectionType::kMeshletVertices, sizeof(uint32_t), mesh.meshletVertices.data(), mesh.meshletVertices.size());
+		writer.AddSection(BinaryMeshSectionType::kMeshletTriangles, sizeof(uint32_t), mesh.meshletTriangles.data(), mesh.meshletTriangles.size());
+
+		return writer.WriteToMemory(mesh.bounds);
+
+	}
+
+	//main.cppと同じようにLODとメッシュレットまで作る
+	MeshData MakeBakedMesh() {
+
+		MeshData mesh = MakeSphereMesh(24);
+
+		GenerateMeshLods(mesh);
+
+		BuildMeshlets(mesh);
+
+		return mesh;
+
+	}
+
+	//セクションの中身の位置
+	uint8_t* FindSection(std::vector<uint8_t>& file, BinaryMeshSectionType type) {
+
+		BinaryMeshHeader header;
+		std::memcpy(&header, file.data(), sizeof(header));
+
+		for (uint32_t i = 0; i < header.sectionCount; ++i) {
+
+			BinaryMeshSection section;
+			std::memcpy(&section, file.data() + sizeof(header) + sizeof(section) * i, sizeof(section));
+
+			if (section.type == static_cast<uint32_t>(type)) {
+				return file.data() + section.offset;
+			}
+
+		}
+
+		return nullptr;
+
+	}
+
+	//開けたメッシュをCPUで使うもの(main.cppのピッキングと遮蔽物)に通す
+	void UseOnCpu(const BinaryMesh& binaryMesh) {
+
+		MeshView view = binaryMesh.GetView();
+
+		std::vector<Vector4> positions(view.vertexCount);
+
+		for (size_t i = 0; i < view.vertexCount; ++i) {
+			positions[i] = view.vertices[i].position;
+		}
+
+		uint32_t lod0Offset = view.lodCount != 0 ? view.lods[0].indexOffset : 0;
+		size_t lod0Count = view.lodCount != 0 ? view.lods[0].indexCount : view.indexCount;
+
+		PickingMesh pickingMesh;
+		pickingMesh.Build(positions.data(), view.indices + lod0Offset, lod0Count);
+
+		float distance = 0.0f;
+		pickingMesh.Intersect({ { 0.0f, 0.0f, -5.0f }, { 0.0f, 0.0f, 1.0f } }, 100.0f, distance, nullptr);
+
+		OcclusionBuffer occlusionBuffer;
+		occlusionBuffer.Initialize(64, 32);
+		occlusionBuffer.Clear();
+
+		Matrix4x4 viewProjectionMatrix = MultiplyMatrix(MakeTestLookAtMatrix({ 0.0f, 0.0f, -4.0f }, { 0.0f, 0.0f, 0.0f }), MakeTestPerspectiveMatrix(0.8f, 2.0f, 0.1f, 100.0f));
+		occlusionBuffer.RenderOccluder(positions.data(), view.indices + lod0Offset, lod0Count, viewProjectionMatrix);
+
+	}
+
+	//kBinaryMeshVerifyIndicesで開けたものはCPUで範囲外を引かないこと
+	bool IsSafeForCpu(const BinaryMesh& binaryMesh) {
+
+		MeshView view = binaryMesh.GetView();
+
+		for (size_t i = 0; i < view.indexCount; ++i) {
+			if (view.indices[i] >= view.vertexCount) {
+				return false;
+			}
+		}
+
+		for (size_t i = 0; i < view.lodCount; ++i) {
+			if (uint64_t(view.lods[i].indexOffset) + view.lods[i].indexCount > view.indexCount) {
+				return false;
+			}
+		}
+
+		for (size_t i = 0; i < view.meshletCount; ++i) {
+
+			const Meshlet& meshlet = view.meshlets[i];
+
+			if (uint64_t(meshlet.vertexOffset) + meshlet.vertexCount > view.meshletVertexCount ||
+				uint64_t(meshlet.triangleOffset) + meshlet.triangleCount > view.meshletTriangleCount) {
+				return false;
+			}
+
+			for (uint32_t j = 0; j < meshlet.vertexCount; ++j) {
+				if (view.meshletVertices[meshlet.vertexOffset + j] >= view.vertexCount) {
+					return false;
+				}
+			}
+
+			for (uint32_t j = 0; j < meshlet.triangleCount; ++j) {
+				uint32_t triangle = view.meshletTriangles[meshlet.triangleOffset + j];
+				for (uint32_t corner = 0; corner < 3; ++corner) {
+					if (((triangle >> (corner * 8)) & 0xff) >= meshlet.vertexCount) {
+						return false;
+					}
+				}
+			}
+
+		}
+
+		return true;
+
+	}
+
+}
+
+TEST_CASE(BakedMeshRoundTrip) {
+
+	MeshData mesh = MakeBakedMesh();
+
+	std::vector<uint8_t> file = WriteMesh(mesh);
+
+	BinaryMesh binaryMesh;
+	REQUIRE(binaryMesh.OpenMemory(file.data(), file.size(), kBinaryMeshVerifyChecksum | kBinaryMeshVerifyIndices));
+
+	MeshView view = binaryMesh.GetView();
+
+	CHECK(view.vertexCount == mesh.vertices.size());
+	CHECK(view.indexCount == mesh.indices.size());
+	CHECK(std::memcmp(view.indices, mesh.indices.data(), sizeof(uint32_t) * mesh.indices.size()) == 0);
+	CHECK(view.lodCount == mesh.lods.size());
+	CHECK(view.meshletCount == mesh.meshlets.size());
+	CHECK(view.meshletVertexCount == mesh.meshletVertices.size());
+	CHECK(view.meshletTriangleCount == mesh.meshletTriangles.size());
+	CHECK(IsSafeForCpu(binaryMesh));
+
+	UseOnCpu(binaryMesh);
+
+}
+
+TEST_CASE(VerifyIndicesRejectsOutOfRangeIndex) {
+
+	MeshData mesh = MakeBakedMesh();
+
+	std::vector<uint8_t> file = WriteMesh(mesh);
+
+	uint32_t* indices = reinterpret_cast<uint32_t*>(FindSection(file, BinaryMeshSectionType::kIndices));
+	REQUIRE(indices != nullptr);
+	indices[7] = static_cast<uint32_t>(mesh.vertices.size());
+
+	//表だけを確かめるOpenでは見つからない
+	BinaryMesh binaryMesh;
+	CHECK(binaryMesh.OpenMemory(file.data(), file.size()));
+	CHECK(!binaryMesh.OpenMemory(file.data(), file.size(), kBinaryMeshVerifyIndices));
+
+}
+
+TEST_CASE(VerifyIndicesRejectsBadMeshletData) {
+
+	MeshData mesh = MakeBakedMesh();
+
+	std::vector<uint8_t> original = WriteMesh(mesh);
+
+	std::vector<uint8_t> file = original;
+	uint32_t* meshletVertices = reinterpret_cast<uint32_t*>(FindSection(file, BinaryMeshSectionType::kMeshletVertices));
+	REQUIRE(meshletVertices != nullptr);
+	meshletVertices[0] = 0xffffffff;
+
+	BinaryMesh binaryMesh;
+	CHECK(!binaryMesh.OpenMemory(file.data(), file.size(), kBinaryMeshVerifyIndices));
+
+	//メッシュレットの中の頂点の番号が頂点の数を超える
+	file = original;
+	uint32_t* meshletTriangles = reinterpret_cast<uint32_t*>(FindSection(file, BinaryMeshSectionType::kMeshletTriangles));
+	REQUIRE(meshletTriangles != nullptr);
+	meshletTriangles[0] = 0x00ffffff;
+
+	CHECK(!binaryMesh.OpenMemory(file.data(), file.size(), kBinaryMeshVerifyIndices));
+
+}
+
+TEST_CASE(FuzzedFilesAreRejectedOrSafe) {
+
+	MeshData mesh = MakeBakedMesh();
+
+	std::vector<uint8_t> original = WriteMesh(mesh);
+
+	std::mt19937 random(42);
+
+	int acceptedCount = 0;
+
+	for (int t = 0; t < 3000; ++t) {
+
+		std::vector<uint8_t> file = original;
+
+		//半分は表のあたり、半分はファイル全体を壊す
+		size_t range = t % 2 == 0 ? (std::min)(file.size(), size_t(2048)) : file.size();
+
+		for (int k = 1 + random() % 8; k > 0; --k) {
+			file[random() % range] = static_cast<uint8_t>(random());
+		}
+
+		//インデックスと同じ大きさの値を入れて境界を狙う
+		if (t % 5 == 0) {
+			uint32_t* indices = reinterpret_cast<uint32_t*>(FindSection(original, BinaryMeshSectionType::kIndices));
+			size_t offset = reinterpret_cast<uint8_t*>(indices) - original.data();
+			uint32_t value = static_cast<uint32_t>(mesh.vertices.size() + random() % 3 - 1);
+			std::memcpy(file.data() + offset + sizeof(uint32_t) * (random() % mesh.indices.size()), &value, sizeof(value));
+		}
+
+		BinaryMesh binaryMesh;
+
+		if (!binaryMesh.OpenMemory(file.data(), file.size(), kBinaryMeshVerifyIndices)) {
+			continue;
+		}
+
+		acceptedCount++;
+
+		REQUIRE(IsSafeForCpu(binaryMesh));
+
+		UseOnCpu(binaryMesh);
+
+	}
+
+	//頂点の中身だけを壊したものなどは開ける
+	CHECK(acceptedCount > 0);
+
+}
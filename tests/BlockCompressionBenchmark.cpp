@@ -0,0 +1,159 @@
+#include "Benchmark.h"
+#include "BlockCompression.h"
+#include "MipGenerator.h"
+#include "JobSystem.h"
+#include <cmath>
+#include <cstdio>
+
+//テクスチャの焼き込み(mipの生成とブロック圧縮)の速さと画質を測る(本来の大きさは2048x2048のsRGB)
+//圧縮は形式ごとに1スレッドとjobSystemの両方で測り、同じバイト列になることとPSNRが下がっていないことを確かめる
+
+namespace {
+
+	//なめらかな変化と細かい模様が混ざった、写真に近い画像
+	void FillTestImage(TextureData& texture) {
+
+		for (uint32_t y = 0; y < texture.height; ++y) {
+			for (uint32_t x = 0; x < texture.width; ++x) {
+
+				uint8_t* pixel = &texture.pixels[(size_t(y) * texture.width + x) * 4];
+
+				float u = static_cast<float>(x) / texture.width;
+				float v = static_cast<float>(y) / texture.height;
+
+				pixel[0] = static_cast<uint8_t>(127.5f + 127.5f * std::sin(u * 20.0f + std::sin(v * 7.0f) * 3.0f));
+				pixel[1] = static_cast<uint8_t>(255.0f * v * v);
+				pixel[2] = static_cast<uint8_t>(((x * 1024 / texture.width / 37 + y * 1024 / texture.height / 53) % 3) * 100);
+				pixel[3] = static_cast<uint8_t>(200.0f + 55.0f * std::cos(u * v * 30.0f));
+
+			}
+		}
+
+	}
+
+	size_t CountPixels(const TextureData& texture) {
+
+		size_t count = 0;
+
+		for (const TextureMip& mip : texture.mips) {
+			count += size_t(mip.width) * mip.height;
+		}
+
+		return count;
+
+	}
+
+}
+
+int main(int argc, char** argv) {
+
+	bool isQuick = IsQuickBenchmark(argc, argv);
+
+	uint32_t size = isQuick ? 256 : 2048;
+
+	int repeatCount = isQuick ? 1 : 3;
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	TextureData source;
+	InitializeTexture(source, TextureFormat::kRGBA8Srgb, size, size, 1);
+
+	FillTestImage(source);
+
+	std::printf("%ux%u sRGB, %u threads\n", size, size, jobSystem.GetThreadCount());
+
+	int result = 0;
+
+	//mipの生成(0段目の画素数あたりの速さ)
+	std::printf("  %-14s %10s %10s %12s\n", "mips", "single ms", "jobs ms", "Mpix/s jobs");
+
+	TextureData mipped;
+
+	for (MipFilter filter : { MipFilter::kBox, MipFilter::kKaiser }) {
+
+		MipSettings settings;
+		settings.filter = filter;
+
+		TextureData single;
+		TextureData parallel;
+
+		double singleMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			single = source;
+			GenerateMips(single, settings);
+		});
+
+		double parallelMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			parallel = source;
+			GenerateMips(parallel, settings, &jobSystem);
+		});
+
+		std::printf("  %-14s %10.1f %10.1f %12.1f\n", filter == MipFilter::kBox ? "box" : "kaiser", singleMilliseconds, parallelMilliseconds, double(size) * size / parallelMilliseconds / 1000.0);
+
+		if (single.pixels != parallel.pixels) {
+			std::printf("  mips differ between jobs and a single thread\n");
+			result = 1;
+		}
+
+		mipped = std::move(parallel);
+
+	}
+
+	//全段のブロック圧縮(最後に作ったKaiserのmipを使う)
+	struct Format {
+		const char* name;
+		TextureFormat format;
+		uint32_t channelCount;
+		double minPsnr;
+	};
+
+	//PSNRの下限は--quickの小さい画像(模様が細かいので低く出る)でも通る値
+	const Format formats[] = {
+		{ "BC1", TextureFormat::kBC1, 3, 28.0 },
+		{ "BC3", TextureFormat::kBC3, 4, 29.0 },
+		{ "BC5", TextureFormat::kBC5, 2, 40.0 },
+		{ "BC7", TextureFormat::kBC7, 4, 29.0 },
+	};
+
+	size_t pixelCount = CountPixels(mipped);
+
+	std::printf("  %-14s %10s %10s %12s %10s %10s\n", "compress", "single ms", "jobs ms", "Mpix/s jobs", "PSNR dB", "bytes");
+
+	for (const Format& format : formats) {
+
+		TextureData single;
+		TextureData parallel;
+
+		double singleMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			CompressTexture(mipped, format.format, single);
+		});
+
+		double parallelMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			CompressTexture(mipped, format.format, parallel, &jobSystem);
+		});
+
+		TextureData decoded;
+
+		DecompressTexture(parallel, decoded);
+
+		double psnr = ComputePsnr(mipped, decoded, format.channelCount);
+
+		std::printf("  %-14s %10.1f %10.1f %12.2f %10.2f %10zu\n", format.name, singleMilliseconds, parallelMilliseconds, pixelCount / parallelMilliseconds / 1000.0, psnr, parallel.pixels.size());
+
+		if (single.pixels != parallel.pixels) {
+			std::printf("  %s differs between jobs and a single thread\n", format.name);
+			result = 1;
+		}
+
+		if (psnr < format.minPsnr) {
+			std::printf("  %s PSNR %.2f dB is below %.1f dB\n", format.name, psnr, format.minPsnr);
+			result = 1;
+		}
+
+	}
+
+	jobSystem.Finalize();
+
+	return result;
+
+}
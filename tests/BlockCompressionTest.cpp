@@ -0,0 +1,151 @@
+#include "TestFramework.h"
+#include "BlockCompression.h"
+#include "MipGenerator.h"
+#include "JobSystem.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+	//なめらかな変化と細かい模様が混ざった画像
+	void FillTestImage(TextureData& texture) {
+
+		for (uint32_t y = 0; y < texture.height; ++y) {
+			for (uint32_t x = 0; x < texture.width; ++x) {
+
+				uint8_t* pixel = &texture.pixels[(size_t(y) * texture.width + x) * 4];
+
+				float u = static_cast<float>(x) / texture.width;
+				float v = static_cast<float>(y) / texture.height;
+
+				pixel[0] = static_cast<uint8_t>(127.5f + 127.5f * std::sin(u * 20.0f + std::sin(v * 7.0f) * 3.0f));
+				pixel[1] = static_cast<uint8_t>(255.0f * v * v);
+				pixel[2] = static_cast<uint8_t>(((x / 37 + y / 53) % 3) * 100);
+				pixel[3] = static_cast<uint8_t>(200.0f + 55.0f * std::cos(u * v * 30.0f));
+
+			}
+		}
+
+	}
+
+	void FillBlock(uint8_t* blockPixels, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+		for (int i = 0; i < 16; ++i) {
+			blockPixels[i * 4] = r;
+			blockPixels[i * 4 + 1] = g;
+			blockPixels[i * 4 + 2] = b;
+			blockPixels[i * 4 + 3] = a;
+		}
+	}
+
+}
+
+TEST_CASE(SolidBlocksRoundTrip) {
+
+	uint8_t blockPixels[64];
+	uint8_t decoded[64];
+	uint8_t block[16];
+
+	//BC4はどの値もそのまま戻る。BC7のmode 6はpビットを4チャンネルで共有するので1だけずれることがある
+	for (uint32_t value = 0; value < 256; value += 5) {
+
+		uint8_t v = static_cast<uint8_t>(value);
+
+		FillBlock(blockPixels, v, static_cast<uint8_t>(255 - v), static_cast<uint8_t>(v / 2), static_cast<uint8_t>(v ^ 0x5a));
+
+		EncodeBC7Block(blockPixels, block);
+		DecodeBlock(TextureFormat::kBC7, block, decoded);
+
+		for (int i = 0; i < 64; ++i) {
+			CHECK(std::abs(decoded[i] - blockPixels[i]) <= 1);
+		}
+
+		EncodeBC5Block(blockPixels, block);
+		DecodeBlock(TextureFormat::kBC5, block, decoded);
+
+		for (int i = 0; i < 16; ++i) {
+			CHECK(decoded[i * 4] == blockPixels[i * 4] && decoded[i * 4 + 1] == blockPixels[i * 4 + 1]);
+		}
+
+		EncodeBC3Block(blockPixels, block);
+		DecodeBlock(TextureFormat::kBC3, block, decoded);
+
+		CHECK(decoded[3] == blockPixels[3]);
+
+	}
+
+	//BC1は565で表せる色ならそのまま戻る
+	FillBlock(blockPixels, 255, 0, 132, 255);
+
+	uint8_t bc1[8];
+
+	EncodeBC1Block(blockPixels, bc1);
+	DecodeBlock(TextureFormat::kBC1, bc1, decoded);
+
+	CHECK(std::memcmp(decoded, blockPixels, 64) == 0);
+
+}
+
+TEST_CASE(CompressedTextureKeepsQuality) {
+
+	JobSystem jobSystem;
+	jobSystem.Initialize(3);
+
+	//4で割り切れない大きさ(端のブロックは端の画素を繰り返す)。小さい画像なので模様が細かく、PSNRは大きい画像より低い
+	TextureData source;
+	InitializeTexture(source, TextureFormat::kRGBA8Srgb, 130, 70, 1);
+
+	FillTestImage(source);
+
+	REQUIRE(GenerateMips(source, {}, &jobSystem));
+
+	struct Expectation {
+		TextureFormat format;
+		uint32_t channelCount;
+		double minPsnr;
+	};
+
+	const Expectation expectations[] = {
+		{ TextureFormat::kBC1, 3, 26.0 },
+		{ TextureFormat::kBC3, 4, 27.0 },
+		{ TextureFormat::kBC5, 2, 35.0 },
+		{ TextureFormat::kBC7, 4, 27.0 },
+	};
+
+	for (const Expectation& expectation : expectations) {
+
+		TextureData single;
+		TextureData parallel;
+
+		REQUIRE(CompressTexture(source, expectation.format, single));
+		REQUIRE(CompressTexture(source, expectation.format, parallel, &jobSystem));
+
+		//sRGBかどうかは元に合わせる(BC5にはsRGBがない)
+		CHECK(single.format == MakeSrgbFormat(expectation.format, true));
+		CHECK(single.mips.size() == source.mips.size());
+		CHECK(single.pixels == parallel.pixels);
+
+		TextureData decoded;
+
+		REQUIRE(DecompressTexture(single, decoded));
+
+		CHECK(decoded.width == source.width);
+		CHECK(decoded.height == source.height);
+		CHECK(decoded.pixels.size() == source.pixels.size());
+
+		CHECK(ComputePsnr(source, decoded, expectation.channelCount) >= expectation.minPsnr);
+
+	}
+
+	//圧縮しない形式へは圧縮しない
+	TextureData destination;
+
+	CHECK(!CompressTexture(source, TextureFormat::kRGBA8, destination));
+	CHECK(!DecompressTexture(source, destination));
+
+	CHECK(std::isinf(ComputePsnr(source, source)));
+
+	jobSystem.Finalize();
+
+}
@@ -0,0 +1,289 @@
+#include "Benchmark.h"
+#include "TestMeshes.h"
+#include "Bvh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//BVHの構築、Refit、問い合わせの速さを測る(本来の大きさは10万個と100万個)
+//問い合わせは全てのオブジェクトを1つずつ調べる場合と比べ、結果を一致させる
+
+namespace {
+
+	//Bvh.cppと同じ判定
+	bool IntersectRayAABB(const Ray& ray, const Vector3& inverseDirection, const AABB& aabb, float maxDistance, float& distance) {
+
+		float tx0 = (aabb.min.x - ray.origin.x) * inverseDirection.x;
+		float tx1 = (aabb.max.x - ray.origin.x) * inverseDirection.x;
+		float ty0 = (aabb.min.y - ray.origin.y) * inverseDirection.y;
+		float ty1 = (aabb.max.y - ray.origin.y) * inverseDirection.y;
+		float tz0 = (aabb.min.z - ray.origin.z) * inverseDirection.z;
+		float tz1 = (aabb.max.z - ray.origin.z) * inverseDirection.z;
+
+		float tNear = (std::max)({ (std::min)(tx0, tx1), (std::min)(ty0, ty1), (std::min)(tz0, tz1), 0.0f });
+		float tFar = (std::min)({ (std::max)(tx0, tx1), (std::max)(ty0, ty1), (std::max)(tz0, tz1), maxDistance });
+
+		distance = tNear;
+
+		return tNear <= tFar;
+
+	}
+
+	//当たった中で一番近い距離(当たらなければmaxDistance)
+	float RaycastLinear(const std::vector<AABB>& bounds, const Ray& ray, float maxDistance) {
+
+		Vector3 inverseDirection = { 1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z };
+
+		float closestDistance = maxDistance;
+
+		for (const AABB& aabb : bounds) {
+			float distance = 0.0f;
+			if (IntersectRayAABB(ray, inverseDirection, aabb, closestDistance, distance) && distance < closestDistance) {
+				closestDistance = distance;
+			}
+		}
+
+		return closestDistance;
+
+	}
+
+	size_t QuerySphereLinear(const std::vector<AABB>& bounds, const Vector3& center, float radius) {
+
+		size_t count = 0;
+
+		for (const AABB& aabb : bounds) {
+			float x = (std::max)({ aabb.min.x - center.x, 0.0f, center.x - aabb.max.x });
+			float y = (std::max)({ aabb.min.y - center.y, 0.0f, center.y - aabb.max.y });
+			float z = (std::max)({ aabb.min.z - center.z, 0.0f, center.z - aabb.max.z });
+			if (x * x + y * y + z * z <= radius * radius) {
+				count++;
+			}
+		}
+
+		return count;
+
+	}
+
+	void Move(AABB& aabb, const Vector3& offset) {
+		aabb.min = { aabb.min.x + offset.x, aabb.min.y + offset.y, aabb.min.z + offset.z };
+		aabb.max = { aabb.max.x + offset.x, aabb.max.y + offset.y, aabb.max.z + offset.z };
+	}
+
+	//1辺1000mの空間にばらまいた大きさ0.1〜2mのオブジェクト
+	std::vector<AABB> MakeRandomBounds(size_t count, uint32_t seed) {
+
+		std::mt19937 random(seed);
+
+		std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+
+		std::uniform_real_distribution<float> size(0.1f, 2.0f);
+
+		std::vector<AABB> bounds(count);
+
+		for (AABB& aabb : bounds) {
+			Vector3 center = { position(random), position(random), position(random) };
+			Vector3 extent = { size(random), size(random), size(random) };
+			aabb = { { center.x - extent.x, center.y - extent.y, center.z - extent.z }, { center.x + extent.x, center.y + extent.y, center.z + extent.z } };
+		}
+
+		return bounds;
+
+	}
+
+	void PrintResult(const char* name, double milliseconds, double linearMilliseconds) {
+		std::printf("  %-22s %9.3f ms  linear %9.3f ms  x%.0f\n", name, milliseconds, linearMilliseconds, linearMilliseconds / milliseconds);
+	}
+
+}
+
+int main(int argc, char** argv) {
+
+	bool isQuick = IsQuickBenchmark(argc, argv);
+
+	std::vector<size_t> counts = isQuick ? std::vector<size_t>{ 20000 } : std::vector<size_t>{ 100000, 1000000 };
+
+	int repeatCount = isQuick ? 1 : 3;
+
+	//問い合わせは1回では短すぎるので数をまとめて測る
+	const int kRayCount = isQuick ? 100 : 1000;
+
+	const int kSphereCount = isQuick ? 10 : 100;
+
+	//1つずつ調べる方は遅いので少ない数で測る
+	const int kLinearQueryCount = isQuick ? 2 : 10;
+
+	Frustum frustum = MakeFrustum(MultiplyMatrix(MakeTestLookAtMatrix({ 0.0f, 0.0f, -500.0f }, { 0.0f, 0.0f, 0.0f }), MakeTestPerspectiveMatrix(0.8f, 16.0f / 9.0f, 0.1f, 300.0f)));
+
+	int result = 0;
+
+	for (size_t count : counts) {
+
+		std::vector<AABB> bounds = MakeRandomBounds(count, 38);
+
+		Bvh bvh;
+
+		double buildMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			bvh.Build(bounds.data(), bounds.size());
+		});
+
+		std::printf("%zu objects: %zu nodes, cost %.1f\n", count, bvh.GetNodeCount(), bvh.GetBuildCost());
+		std::printf("  %-22s %9.3f ms\n", "build", buildMilliseconds);
+
+		//毎フレーム全てが少しずつ動く(Refitだけで済む)。行って戻るので離れていかない
+		std::mt19937 random(39);
+
+		std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+
+		std::vector<Vector3> offsets(count);
+
+		for (Vector3& offset : offsets) {
+			offset = { step(random), step(random), step(random) };
+		}
+
+		float direction = 1.0f;
+
+		double refitMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			for (uint32_t i = 0; i < count; ++i) {
+				Move(bounds[i], { offsets[i].x * direction, offsets[i].y * direction, offsets[i].z * direction });
+				bvh.Update(i, bounds[i]);
+			}
+			bvh.Refit();
+			direction = -direction;
+		});
+
+		std::printf("  %-22s %9.3f ms (update + refit, cost %.1f)\n", "refit", refitMilliseconds, bvh.ComputeCost());
+
+		//1割が遠くへ動いて質が落ちたら作り直す
+		std::uniform_real_distribution<float> jump(-500.0f, 500.0f);
+
+		for (uint32_t i = 0; i < count; i += 10) {
+			Move(bounds[i], { jump(random), jump(random), jump(random) });
+			bvh.Update(i, bounds[i]);
+		}
+
+		BenchmarkTimer rebuildTimer;
+
+		bool isRebuilt = bvh.RefitOrRebuild();
+
+		std::printf("  %-22s %9.3f ms (%s, cost %.1f)\n", "refit or rebuild", rebuildTimer.GetMilliseconds(), isRebuilt ? "rebuilt" : "refit", bvh.ComputeCost());
+
+		//視錐台:全てを1つずつ判定するFrustumCull(SIMD)と比べる
+		AABBArray aabbArray;
+		aabbArray.Resize(count);
+
+		for (size_t i = 0; i < count; ++i) {
+			aabbArray.Set(i, bounds[i]);
+		}
+
+		std::vector<uint32_t> visibleIndices(count);
+		std::vector<uint32_t> expected(count);
+
+		size_t visibleCount = 0;
+		size_t expectedCount = 0;
+
+		double frustumMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			visibleCount = bvh.QueryFrustum(frustum, visibleIndices.data());
+		});
+
+		double frustumLinearMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			expectedCount = FrustumCull(frustum, aabbArray, expected.data(), nullptr);
+		});
+
+		std::sort(visibleIndices.begin(), visibleIndices.begin() + visibleCount);
+
+		if (visibleCount != expectedCount || !std::equal(expected.begin(), expected.begin() + expectedCount, visibleIndices.begin())) {
+			std::printf("  frustum: result differs from FrustumCull\n");
+			result = 1;
+		}
+
+		PrintResult("frustum", frustumMilliseconds, frustumLinearMilliseconds);
+
+		//レイ:空間の外から中の点へ向かい、その点の先まで調べる
+		std::uniform_real_distribution<float> position(-450.0f, 450.0f);
+
+		std::vector<Ray> rays(kRayCount);
+
+		for (Ray& ray : rays) {
+			Vector3 origin = { -600.0f, position(random), position(random) };
+			Vector3 target = { position(random), position(random), position(random) };
+			ray = { origin, { target.x - origin.x, target.y - origin.y, target.z - origin.z } };
+		}
+
+		const float kMaxDistance = 2.0f;
+
+		std::vector<float> hitDistances(kRayCount);
+
+		double rayMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			for (int i = 0; i < kRayCount; ++i) {
+				float distance = kMaxDistance;
+				if (bvh.Raycast(rays[i], kMaxDistance, nullptr, &distance) == Bvh::kInvalidIndex) {
+					distance = kMaxDistance;
+				}
+				hitDistances[i] = distance;
+			}
+		});
+
+		size_t hitCount = 0;
+
+		BenchmarkTimer rayLinearTimer;
+
+		for (int i = 0; i < kLinearQueryCount; ++i) {
+			if (RaycastLinear(bounds, rays[i], kMaxDistance) != hitDistances[i]) {
+				std::printf("  raycast %d: distance differs from the linear search\n", i);
+				result = 1;
+			}
+		}
+
+		double rayLinearMilliseconds = rayLinearTimer.GetMilliseconds() / kLinearQueryCount;
+
+		for (float distance : hitDistances) {
+			if (distance < kMaxDistance) {
+				hitCount++;
+			}
+		}
+
+		char name[64];
+
+		std::snprintf(name, sizeof(name), "raycast (%zu/%d hit)", hitCount, kRayCount);
+
+		PrintResult(name, rayMilliseconds / kRayCount, rayLinearMilliseconds);
+
+		//球:半径20m
+		std::vector<Vector3> centers(kSphereCount);
+
+		for (Vector3& center : centers) {
+			center = { position(random), position(random), position(random) };
+		}
+
+		std::vector<size_t> overlapCounts(kSphereCount);
+
+		std::vector<uint32_t> overlaps;
+
+		double sphereMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			for (int i = 0; i < kSphereCount; ++i) {
+				overlaps.clear();
+				bvh.QuerySphere(centers[i], 20.0f, overlaps);
+				overlapCounts[i] = overlaps.size();
+			}
+		});
+
+		BenchmarkTimer sphereLinearTimer;
+
+		for (int i = 0; i < kLinearQueryCount; ++i) {
+			if (QuerySphereLinear(bounds, centers[i], 20.0f) != overlapCounts[i]) {
+				std::printf("  sphere %d: count differs from the linear search\n", i);
+				result = 1;
+			}
+		}
+
+		double sphereLinearMilliseconds = sphereLinearTimer.GetMilliseconds() / kLinearQueryCount;
+
+		PrintResult("sphere", sphereMilliseconds / kSphereCount, sphereLinearMilliseconds);
+
+	}
+
+	return result;
+
+}
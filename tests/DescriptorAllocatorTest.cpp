@@ -0,0 +1,180 @@
+#include "TestFramework.h"
+#include "DescriptorAllocator.h"
+#include <deque>
+#include <random>
+#include <vector>
+
+TEST_CASE(PersistentSlotsComeFromFreeList) {
+
+	DescriptorAllocator allocator;
+	allocator.Initialize(4, 8);
+
+	//小さいインデックスから使われる
+	CHECK(allocator.AllocatePersistent() == 0);
+	CHECK(allocator.AllocatePersistent() == 1);
+	CHECK(allocator.AllocatePersistent() == 2);
+	CHECK(allocator.GetPersistentUsed() == 3);
+
+	//解放したものから使い直す
+	allocator.FreePersistent(1);
+	CHECK(allocator.GetPersistentUsed() == 2);
+	CHECK(allocator.AllocatePersistent() == 1);
+
+	CHECK(allocator.AllocatePersistent() == 3);
+	CHECK(allocator.AllocatePersistent() == DescriptorAllocator::kInvalidIndex);
+	CHECK(allocator.GetPersistentUsed() == 4);
+
+	//常駐スロットはリングに影響しない
+	CHECK(allocator.GetTransientUsed() == 0);
+
+}
+
+TEST_CASE(TransientRangesFollowPersistentSlots) {
+
+	DescriptorAllocator allocator;
+	allocator.Initialize(4, 8);
+
+	CHECK(allocator.AllocateTransient(3) == 4);
+	CHECK(allocator.AllocateTransient(2) == 7);
+	CHECK(allocator.GetTransientUsed() == 5);
+
+	CHECK(allocator.AllocateTransient(0) == DescriptorAllocator::kInvalidIndex);
+	CHECK(allocator.AllocateTransient(9) == DescriptorAllocator::kInvalidIndex);
+
+}
+
+TEST_CASE(TransientRangesAreReclaimedByFence) {
+
+	DescriptorAllocator allocator;
+	allocator.Initialize(4, 8);
+
+	CHECK(allocator.AllocateTransient(5) == 4);
+	allocator.FinishFrame(1);
+
+	//末尾に収まらないので折り返すが、先頭はまだフレーム1が使っている
+	CHECK(allocator.AllocateTransient(2) == 9);
+	allocator.FinishFrame(2);
+
+	CHECK(allocator.AllocateTransient(2) == DescriptorAllocator::kInvalidIndex);
+
+	//完了していないフレームは回収しない
+	allocator.ReleaseCompleted(0);
+	CHECK(allocator.GetTransientUsed() == 7);
+
+	allocator.ReleaseCompleted(1);
+	CHECK(allocator.GetTransientUsed() == 2);
+
+	//末尾の1つは飛ばして先頭から取る(飛ばした分もこのフレームの使用量に入る)
+	CHECK(allocator.AllocateTransient(2) == 4);
+	CHECK(allocator.GetTransientUsed() == 5);
+	allocator.FinishFrame(3);
+
+	allocator.ReleaseCompleted(3);
+	CHECK(allocator.GetTransientUsed() == 0);
+
+}
+
+TEST_CASE(EmptyFrameIsReclaimed) {
+
+	DescriptorAllocator allocator;
+	allocator.Initialize(0, 4);
+
+	allocator.FinishFrame(1);
+	CHECK(allocator.AllocateTransient(4) == 0);
+	allocator.FinishFrame(2);
+
+	allocator.ReleaseCompleted(1);
+	CHECK(allocator.GetTransientUsed() == 4);
+
+	allocator.ReleaseCompleted(2);
+	CHECK(allocator.GetTransientUsed() == 0);
+	CHECK(allocator.AllocateTransient(4) == 0);
+
+}
+
+TEST_CASE(TransientRangesNeverOverlapInFlightFrames) {
+
+	const uint32_t kPersistentCount = 16;
+	const uint32_t kTransientCount = 64;
+
+	DescriptorAllocator allocator;
+	allocator.Initialize(kPersistentCount, kTransientCount);
+
+	std::mt19937 random(7);
+
+	//GPUがまだ読んでいる範囲(フェンスの値ごと)と、各スロットの持ち主
+	struct Range {
+		uint64_t fenceValue;
+		uint32_t start;
+		uint32_t count;
+	};
+
+	std::deque<Range> inFlight;
+
+	std::vector<uint64_t> owners(kTransientCount, 0);
+
+	uint64_t completedFenceValue = 0;
+
+	for (uint64_t frame = 1; frame <= 2000; ++frame) {
+
+		uint32_t allocationCount = random() % 4;
+
+		for (uint32_t i = 0; i < allocationCount; ++i) {
+
+			uint32_t count = 1 + random() % 12;
+
+			uint32_t start = allocator.AllocateTransient(count);
+
+			if (start == DescriptorAllocator::kInvalidIndex) {
+				continue;
+			}
+
+			REQUIRE(start >= kPersistentCount);
+			REQUIRE(start - kPersistentCount + count <= kTransientCount);
+
+			for (uint32_t k = 0; k < count; ++k) {
+
+				uint64_t& owner = owners[start - kPersistentCount + k];
+
+				//まだ完了していないフレームのスロットを渡してはいけない
+				CHECK(owner <= completedFenceValue);
+
+				owner = frame;
+
+			}
+
+			inFlight.push_back({ frame, start, count });
+
+		}
+
+		allocator.FinishFrame(frame);
+
+		//GPUは0から3フレーム遅れて進む
+		uint64_t lag = random() % 4;
+
+		if (frame > lag && frame - lag > completedFenceValue) {
+			completedFenceValue = frame - lag;
+		}
+
+		allocator.ReleaseCompleted(completedFenceValue);
+
+		while (!inFlight.empty() && inFlight.front().fenceValue <= completedFenceValue) {
+			inFlight.pop_front();
+		}
+
+		uint32_t inFlightCount = 0;
+
+		for (const Range& range : inFlight) {
+			inFlightCount += range.count;
+		}
+
+		//折り返しで飛ばした分があるので、使用量は実際に渡した数以上になる
+		CHECK(allocator.GetTransientUsed() >= inFlightCount);
+		CHECK(allocator.GetTransientUsed() <= kTransientCount);
+
+	}
+
+	allocator.ReleaseCompleted(~0ull);
+	CHECK(allocator.GetTransientUsed() == 0);
+
+}
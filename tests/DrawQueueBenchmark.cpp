@@ -0,0 +1,205 @@
+#include "Benchmark.h"
+#include "DrawQueue.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//描画キーの並べ替えの速さを測る(本来の大きさは100万個)
+//RadixSortを1スレッドとJobSystemで動かし、std::sortとstd::stable_sortと比べる。結果はstd::stable_sortと一致させる
+
+namespace {
+
+	struct KeySet {
+		const char* name;
+		std::vector<uint64_t> keys;
+	};
+
+	//パス、PSO、マテリアル、深度の数を実際の場面に近づけたキー(下位16bitの予備は0なので、その2桁は飛ばされる)
+	std::vector<uint64_t> MakeDrawKeys(size_t count, uint32_t seed) {
+
+		std::mt19937 random(seed);
+
+		std::uniform_real_distribution<float> depth(0.1f, 1000.0f);
+
+		std::vector<uint64_t> keys(count);
+
+		for (uint64_t& key : keys) {
+
+			DrawPass pass = random() % 8 == 0 ? DrawPass::kTransparent : DrawPass::kOpaque;
+
+			key = MakeDrawSortKey(pass, random() % 32, random() % 2000, depth(random), 0.1f, 1000.0f);
+
+		}
+
+		return keys;
+
+	}
+
+	std::vector<uint64_t> MakeRandomKeys(size_t count, uint32_t seed) {
+
+		std::mt19937_64 random(seed);
+
+		std::vector<uint64_t> keys(count);
+
+		for (uint64_t& key : keys) {
+			key = random();
+		}
+
+		return keys;
+
+	}
+
+	//キーが昇順で、同じキーの中では元の順を保っているか
+	bool IsStableSorted(const std::vector<uint64_t>& source, const std::vector<uint64_t>& keys, const std::vector<uint32_t>& values, const std::vector<uint64_t>& expected) {
+
+		if (keys != expected) {
+			return false;
+		}
+
+		for (size_t i = 0; i < keys.size(); ++i) {
+
+			if (source[values[i]] != keys[i]) {
+				return false;
+			}
+
+			if (i > 0 && keys[i] == keys[i - 1] && values[i] < values[i - 1]) {
+				return false;
+			}
+
+		}
+
+		return true;
+
+	}
+
+}
+
+int main(int argc, char** argv) {
+
+	bool isQuick = IsQuickBenchmark(argc, argv);
+
+	size_t count = isQuick ? 50000 : 1000000;
+
+	int repeatCount = isQuick ? 1 : 5;
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	std::printf("%zu keys, %u threads\n", count, jobSystem.GetThreadCount());
+
+	KeySet keySets[] = {
+		{ "draw keys", MakeDrawKeys(count, 34) },
+		{ "random keys", MakeRandomKeys(count, 34) },
+	};
+
+	int result = 0;
+
+	for (const KeySet& keySet : keySets) {
+
+		const std::vector<uint64_t>& source = keySet.keys;
+
+		std::vector<uint64_t> expected = source;
+
+		std::stable_sort(expected.begin(), expected.end());
+
+		std::printf("%s\n", keySet.name);
+
+		std::vector<uint64_t> keys(count);
+		std::vector<uint32_t> values(count);
+		std::vector<uint64_t> tempKeys(count);
+		std::vector<uint32_t> tempValues(count);
+
+		const char* radixNames[] = { "radix 1 thread", "radix jobs" };
+
+		JobSystem* jobSystems[] = { nullptr, &jobSystem };
+
+		for (int i = 0; i < 2; ++i) {
+
+			double best = 0.0;
+
+			for (int repeat = 0; repeat < repeatCount; ++repeat) {
+
+				keys = source;
+
+				for (size_t k = 0; k < count; ++k) {
+					values[k] = static_cast<uint32_t>(k);
+				}
+
+				BenchmarkTimer timer;
+
+				RadixSort(keys.data(), values.data(), tempKeys.data(), tempValues.data(), count, jobSystems[i]);
+
+				double milliseconds = timer.GetMilliseconds();
+
+				if (repeat == 0 || milliseconds < best) {
+					best = milliseconds;
+				}
+
+			}
+
+			if (!IsStableSorted(source, keys, values, expected)) {
+				std::printf("  %s: result differs from std::stable_sort\n", radixNames[i]);
+				result = 1;
+				continue;
+			}
+
+			std::printf("  %-16s %8.2f ms %8.1f Mkeys/s\n", radixNames[i], best, count / best / 1000.0);
+
+		}
+
+		//比較のためのstd::sort(キーと番号の組)とstd::stable_sort
+		std::vector<std::pair<uint64_t, uint32_t>> pairs(count);
+
+		double sortMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			for (size_t k = 0; k < count; ++k) {
+				pairs[k] = { source[k], static_cast<uint32_t>(k) };
+			}
+			std::sort(pairs.begin(), pairs.end());
+			KeepValue(pairs);
+		});
+
+		double stableMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			keys = source;
+			std::stable_sort(keys.begin(), keys.end());
+			KeepValue(keys);
+		});
+
+		std::printf("  %-16s %8.2f ms\n", "std::sort", sortMilliseconds);
+		std::printf("  %-16s %8.2f ms\n", "std::stable_sort", stableMilliseconds);
+
+	}
+
+	//フレームで使う形(積んでから並べ替えて順に取り出す)
+	DrawQueue queue;
+
+	const std::vector<uint64_t>& drawKeys = keySets[0].keys;
+
+	double queueMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+
+		queue.Clear();
+
+		for (size_t k = 0; k < count; ++k) {
+			queue.Push(drawKeys[k], { static_cast<uint32_t>(k), 0, 0, 0, 3, 0, 0 });
+		}
+
+		queue.Sort(&jobSystem);
+
+	});
+
+	for (size_t k = 1; k < queue.GetCount(); ++k) {
+		if (queue.GetSortKey(k - 1) > queue.GetSortKey(k) || drawKeys[queue.Get(k).objectIndex] != queue.GetSortKey(k)) {
+			std::printf("draw queue: wrong order at %zu\n", k);
+			result = 1;
+			break;
+		}
+	}
+
+	std::printf("draw queue push + sort %8.2f ms\n", queueMilliseconds);
+
+	jobSystem.Finalize();
+
+	return result;
+
+}
@@ -0,0 +1,244 @@
+#include "Benchmark.h"
+#include "EntityWorld.h"
+#include "JobSystem.h"
+#include <cstdio>
+#include <vector>
+
+//EntityWorldと、全ての成分を1つの構造体に持つ配列(AoS)を比べる(本来の大きさは100万個)
+//半分が速度を持つ場面で、位置の更新、コンポーネントの付け外し、破棄の速さを測る。最後に両方の中身を一致させる
+
+namespace {
+
+	struct Position {
+		float x, y, z;
+	};
+
+	struct Velocity {
+		float x, y, z;
+	};
+
+	struct Health {
+		float value;
+	};
+
+	//描画や物理の情報など、位置の更新では読まない成分
+	struct RenderData {
+		float worldMatrix[16];
+		uint32_t meshIndex;
+		uint32_t materialIndex;
+		float boundsRadius;
+		uint32_t flags;
+	};
+
+	//AoSのオブジェクト(持っていない成分はフラグで表す)
+	struct GameObject {
+		uint32_t id;
+		Position position;
+		Velocity velocity;
+		Health health;
+		RenderData renderData;
+		bool hasVelocity;
+		bool hasHealth;
+	};
+
+	const float kDeltaTime = 1.0f / 60.0f;
+
+	void Integrate(Position& position, const Velocity& velocity) {
+		position.x += velocity.x * kDeltaTime;
+		position.y += velocity.y * kDeltaTime;
+		position.z += velocity.z * kDeltaTime;
+	}
+
+	Velocity MakeVelocity(size_t i) {
+		return { float(i % 7), float(i % 5), -float(i % 3) };
+	}
+
+	void PrintResult(const char* name, double ecsMilliseconds, double aosMilliseconds) {
+		std::printf("  %-26s ecs %8.2f ms  aos %8.2f ms\n", name, ecsMilliseconds, aosMilliseconds);
+	}
+
+}
+
+int main(int argc, char** argv) {
+
+	bool isQuick = IsQuickBenchmark(argc, argv);
+
+	size_t count = isQuick ? 50000 : 1000000;
+
+	int repeatCount = isQuick ? 1 : 5;
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	std::printf("%zu entities (half with velocity), %u threads\n", count, jobSystem.GetThreadCount());
+
+	EntityWorld world;
+
+	std::vector<Entity> entities(count);
+
+	std::vector<GameObject> objects(count);
+
+	BenchmarkTimer ecsCreateTimer;
+
+	for (size_t i = 0; i < count; ++i) {
+		Position position = { float(i), 0.0f, 0.0f };
+		if (i % 2 == 1) {
+			entities[i] = world.CreateEntity(position, MakeVelocity(i), RenderData{});
+		} else {
+			entities[i] = world.CreateEntity(position, RenderData{});
+		}
+	}
+
+	double ecsCreateMilliseconds = ecsCreateTimer.GetMilliseconds();
+
+	BenchmarkTimer aosCreateTimer;
+
+	for (size_t i = 0; i < count; ++i) {
+		objects[i] = {};
+		objects[i].id = static_cast<uint32_t>(i);
+		objects[i].position = { float(i), 0.0f, 0.0f };
+		objects[i].velocity = MakeVelocity(i);
+		objects[i].hasVelocity = i % 2 == 1;
+	}
+
+	double aosCreateMilliseconds = aosCreateTimer.GetMilliseconds();
+
+	PrintResult("create", ecsCreateMilliseconds, aosCreateMilliseconds);
+
+	//位置の更新(ECSは速度を持つチャンクだけを先頭から読み、AoSは全てを読んでフラグで飛ばす)
+	double ecsMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+		world.ForEach<Position, Velocity>(Integrate);
+	});
+
+	double parallelMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+		world.ParallelForEach<Position, Velocity>(&jobSystem, Integrate);
+	});
+
+	double aosMilliseconds = MeasureBestMilliseconds(repeatCount * 2, [&]() {
+		for (GameObject& object : objects) {
+			if (object.hasVelocity) {
+				Integrate(object.position, object.velocity);
+			}
+		}
+	});
+
+	PrintResult("integrate", ecsMilliseconds, aosMilliseconds);
+	std::printf("  %-26s ecs %8.2f ms\n", "integrate (jobs)", parallelMilliseconds);
+
+	//構造の変更:1割にHealthを付け、そのうち半分から外す
+	BenchmarkTimer addTimer;
+
+	for (size_t i = 0; i < count; i += 10) {
+		world.AddComponent(entities[i], Health{ float(i) });
+	}
+
+	double ecsAddMilliseconds = addTimer.GetMilliseconds();
+
+	BenchmarkTimer removeTimer;
+
+	for (size_t i = 0; i < count; i += 20) {
+		world.RemoveComponent<Health>(entities[i]);
+	}
+
+	double ecsRemoveMilliseconds = removeTimer.GetMilliseconds();
+
+	BenchmarkTimer aosChangeTimer;
+
+	for (size_t i = 0; i < count; i += 10) {
+		objects[i].health = { float(i) };
+		objects[i].hasHealth = true;
+	}
+
+	for (size_t i = 0; i < count; i += 20) {
+		objects[i].hasHealth = false;
+	}
+
+	double aosChangeMilliseconds = aosChangeTimer.GetMilliseconds();
+
+	char name[64];
+
+	std::snprintf(name, sizeof(name), "add + remove (%zu)", (count + 9) / 10 + (count + 19) / 20);
+	PrintResult(name, ecsAddMilliseconds + ecsRemoveMilliseconds, aosChangeMilliseconds);
+
+	//3つに1つを破棄する(AoSは末尾で穴を埋める)
+	BenchmarkTimer ecsDestroyTimer;
+
+	for (size_t i = 0; i < count; i += 3) {
+		world.DestroyEntity(entities[i]);
+	}
+
+	double ecsDestroyMilliseconds = ecsDestroyTimer.GetMilliseconds();
+
+	BenchmarkTimer aosDestroyTimer;
+
+	for (size_t i = objects.size(); i-- > 0;) {
+		if (objects[i].id % 3 == 0) {
+			objects[i] = objects.back();
+			objects.pop_back();
+		}
+	}
+
+	double aosDestroyMilliseconds = aosDestroyTimer.GetMilliseconds();
+
+	std::snprintf(name, sizeof(name), "destroy (%zu)", (count + 2) / 3);
+	PrintResult(name, ecsDestroyMilliseconds, aosDestroyMilliseconds);
+
+	//構造が変わった後の更新(チャンクが詰められたままか)
+	ecsMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+		world.ForEach<Position, Velocity>(Integrate);
+	});
+
+	aosMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+		for (GameObject& object : objects) {
+			if (object.hasVelocity) {
+				Integrate(object.position, object.velocity);
+			}
+		}
+	});
+
+	PrintResult("integrate after changes", ecsMilliseconds, aosMilliseconds);
+
+	std::printf("  %zu archetypes\n", world.GetArchetypeCount());
+
+	//同じ回数だけ更新したので、生きているものは全て同じ値になる
+	int result = 0;
+
+	size_t mismatchCount = 0;
+
+	if (world.GetEntityCount() != objects.size()) {
+		mismatchCount++;
+	}
+
+	for (const GameObject& object : objects) {
+
+		Entity entity = entities[object.id];
+
+		const Position* position = world.GetComponent<Position>(entity);
+
+		const Health* health = world.GetComponent<Health>(entity);
+
+		if (!world.IsAlive(entity) || position == nullptr ||
+			position->x != object.position.x || position->y != object.position.y || position->z != object.position.z ||
+			world.HasComponent<Velocity>(entity) != object.hasVelocity ||
+			(health != nullptr) != object.hasHealth || (health != nullptr && health->value != object.health.value)) {
+			mismatchCount++;
+		}
+
+	}
+
+	for (size_t i = 0; i < count; i += 3) {
+		if (world.IsAlive(entities[i])) {
+			mismatchCount++;
+		}
+	}
+
+	if (mismatchCount > 0) {
+		std::printf("%zu entities differ from the AoS reference\n", mismatchCount);
+		result = 1;
+	}
+
+	jobSystem.Finalize();
+
+	return result;
+
+}
@@ -0,0 +1,189 @@
+#include "Benchmark.h"
+#include "TestMeshes.h"
+#include "FrustumCulling.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//視錐台カリングの速さを測る(本来の大きさは100万個)
+//球とAABBを、1つずつ判定するスカラーのループ、SIMDの1スレッド、JobSystemで比べる。見えたものは全て一致させる
+
+namespace {
+
+	//FrustumCulling.cppと同じ順に足す
+	float GetPlaneDistance(const Vector4& plane, float x, float y, float z) {
+		return (plane.x * x + plane.y * y) + (plane.z * z + plane.w);
+	}
+
+	size_t CullSpheresScalar(const Frustum& frustum, const std::vector<BoundingSphere>& spheres, uint32_t* visibleIndices) {
+
+		size_t visibleCount = 0;
+
+		for (size_t i = 0; i < spheres.size(); ++i) {
+
+			const BoundingSphere& sphere = spheres[i];
+
+			bool isVisible = true;
+
+			for (const Vector4& plane : frustum.planes) {
+				if (GetPlaneDistance(plane, sphere.center.x, sphere.center.y, sphere.center.z) < -sphere.radius) {
+					isVisible = false;
+					break;
+				}
+			}
+
+			if (isVisible) {
+				visibleIndices[visibleCount++] = static_cast<uint32_t>(i);
+			}
+
+		}
+
+		return visibleCount;
+
+	}
+
+	size_t CullAABBsScalar(const Frustum& frustum, const std::vector<AABB>& aabbs, uint32_t* visibleIndices) {
+
+		size_t visibleCount = 0;
+
+		for (size_t i = 0; i < aabbs.size(); ++i) {
+
+			const AABB& aabb = aabbs[i];
+
+			float x = (aabb.min.x + aabb.max.x) * 0.5f;
+			float y = (aabb.min.y + aabb.max.y) * 0.5f;
+			float z = (aabb.min.z + aabb.max.z) * 0.5f;
+			float extentX = (aabb.max.x - aabb.min.x) * 0.5f;
+			float extentY = (aabb.max.y - aabb.min.y) * 0.5f;
+			float extentZ = (aabb.max.z - aabb.min.z) * 0.5f;
+
+			bool isVisible = true;
+
+			for (const Vector4& plane : frustum.planes) {
+				float radius = std::fabs(plane.x) * extentX + std::fabs(plane.y) * extentY + std::fabs(plane.z) * extentZ;
+				if (GetPlaneDistance(plane, x, y, z) + radius < 0.0f) {
+					isVisible = false;
+					break;
+				}
+			}
+
+			if (isVisible) {
+				visibleIndices[visibleCount++] = static_cast<uint32_t>(i);
+			}
+
+		}
+
+		return visibleCount;
+
+	}
+
+	void PrintResult(const char* name, double milliseconds, size_t count, size_t visibleCount) {
+		std::printf("  %-14s %8.2f ms %8.1f Mbounds/s  visible %zu\n", name, milliseconds, count / milliseconds / 1000.0, visibleCount);
+	}
+
+}
+
+int main(int argc, char** argv) {
+
+	bool isQuick = IsQuickBenchmark(argc, argv);
+
+	size_t count = isQuick ? 50000 : 1000000;
+
+	int repeatCount = isQuick ? 1 : 10;
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	//原点から+Zを見るカメラで、視錐台の周りにばらまく(6%ほどが見える)
+	Matrix4x4 view = MakeTestLookAtMatrix({ 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f });
+
+	Frustum frustum = MakeFrustum(MultiplyMatrix(view, MakeTestPerspectiveMatrix(0.8f, 16.0f / 9.0f, 0.1f, 200.0f)));
+
+	std::mt19937 random(36);
+
+	std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+
+	std::uniform_real_distribution<float> size(0.1f, 3.0f);
+
+	std::vector<BoundingSphere> spheres(count);
+
+	std::vector<AABB> aabbs(count);
+
+	BoundingSphereArray sphereArray;
+	sphereArray.Resize(count);
+
+	AABBArray aabbArray;
+	aabbArray.Resize(count);
+
+	for (size_t i = 0; i < count; ++i) {
+
+		Vector3 center = { position(random), position(random), position(random) };
+
+		Vector3 extent = { size(random), size(random), size(random) };
+
+		spheres[i] = { center, std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z) };
+
+		aabbs[i] = { { center.x - extent.x, center.y - extent.y, center.z - extent.z }, { center.x + extent.x, center.y + extent.y, center.z + extent.z } };
+
+		sphereArray.Set(i, spheres[i]);
+
+		aabbArray.Set(i, aabbs[i]);
+
+	}
+
+	std::printf("%zu bounds, %u threads\n", count, jobSystem.GetThreadCount());
+
+	std::vector<uint32_t> expected(count);
+
+	std::vector<uint32_t> visibleIndices(count);
+
+	int result = 0;
+
+	for (int kind = 0; kind < 2; ++kind) {
+
+		std::printf("%s\n", kind == 0 ? "spheres" : "aabbs");
+
+		size_t expectedCount = 0;
+
+		double scalarMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			expectedCount = kind == 0 ? CullSpheresScalar(frustum, spheres, expected.data()) : CullAABBsScalar(frustum, aabbs, expected.data());
+		});
+
+		PrintResult("scalar", scalarMilliseconds, count, expectedCount);
+
+		const char* names[] = { "simd 1 thread", "simd jobs" };
+
+		JobSystem* jobSystems[] = { nullptr, &jobSystem };
+
+		for (int i = 0; i < 2; ++i) {
+
+			size_t visibleCount = 0;
+
+			double milliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+				if (kind == 0) {
+					visibleCount = FrustumCull(frustum, sphereArray, visibleIndices.data(), jobSystems[i]);
+				} else {
+					visibleCount = FrustumCull(frustum, aabbArray, visibleIndices.data(), jobSystems[i]);
+				}
+			});
+
+			if (visibleCount != expectedCount || !std::equal(expected.begin(), expected.begin() + expectedCount, visibleIndices.begin())) {
+				std::printf("  %s: result differs from the scalar loop\n", names[i]);
+				result = 1;
+				continue;
+			}
+
+			PrintResult(names[i], milliseconds, count, visibleCount);
+
+		}
+
+	}
+
+	jobSystem.Finalize();
+
+	return result;
+
+}
@@ -0,0 +1,352 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "FrustumCulling.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+//同じテストをAVX、SSE2、SIMDなし(FRUSTUM_CULLING_NO_SIMD)でビルドしたFrustumCulling.cppに対して動かす
+//どの組み合わせでも、ここに書いたスカラーの判定と同じものが見えることを確かめる
+
+namespace {
+
+	//原点から+Zを見るカメラ
+	Frustum MakeTestFrustum() {
+
+		Matrix4x4 view = MakeTestLookAtMatrix({ 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f });
+
+		Matrix4x4 projection = MakeTestPerspectiveMatrix(0.8f, 16.0f / 9.0f, 0.1f, 100.0f);
+
+		return MakeFrustum(MultiplyMatrix(view, projection));
+
+	}
+
+	//FrustumCulling.cppのSIMDと同じ順に足す
+	float ReferencePlaneDistance(const Vector4& plane, float x, float y, float z) {
+		return (plane.x * x + plane.y * y) + (plane.z * z + plane.w);
+	}
+
+	bool ReferenceIsSphereVisible(const Frustum& frustum, const BoundingSphere& sphere) {
+
+		for (const Vector4& plane : frustum.planes) {
+			if (!(ReferencePlaneDistance(plane, sphere.center.x, sphere.center.y, sphere.center.z) >= -sphere.radius)) {
+				return false;
+			}
+		}
+
+		return true;
+
+	}
+
+	bool ReferenceIsAABBVisible(const Frustum& frustum, const AABB& aabb) {
+
+		float x = (aabb.min.x + aabb.max.x) * 0.5f;
+		float y = (aabb.min.y + aabb.max.y) * 0.5f;
+		float z = (aabb.min.z + aabb.max.z) * 0.5f;
+		float extentX = (aabb.max.x - aabb.min.x) * 0.5f;
+		float extentY = (aabb.max.y - aabb.min.y) * 0.5f;
+		float extentZ = (aabb.max.z - aabb.min.z) * 0.5f;
+
+		for (const Vector4& plane : frustum.planes) {
+			float radius = std::fabs(plane.x) * extentX + std::fabs(plane.y) * extentY + std::fabs(plane.z) * extentZ;
+			if (!(ReferencePlaneDistance(plane, x, y, z) + radius >= 0.0f)) {
+				return false;
+			}
+		}
+
+		return true;
+
+	}
+
+	//視錐台の周りにばらまき、3つに1つは平面のすぐ近くに置いて境界の判定を確かめる
+	std::vector<BoundingSphere> MakeRandomSpheres(const Frustum& frustum, size_t count, uint32_t seed) {
+
+		std::mt19937 random(seed);
+
+		std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+
+		std::uniform_real_distribution<float> size(0.0f, 4.0f);
+
+		std::vector<BoundingSphere> spheres(count);
+
+		for (BoundingSphere& sphere : spheres) {
+
+			sphere.center = { position(random), position(random), position(random) };
+
+			sphere.radius = size(random);
+
+			if (random() % 3 == 0) {
+
+				//平面からの距離がちょうど-radius付近になるように平面の法線方向に動かす
+				const Vector4& plane = frustum.planes[random() % 6];
+
+				float distance = ReferencePlaneDistance(plane, sphere.center.x, sphere.center.y, sphere.center.z);
+
+				float offset = -sphere.radius - distance;
+
+				sphere.center.x += plane.x * offset;
+				sphere.center.y += plane.y * offset;
+				sphere.center.z += plane.z * offset;
+
+				if (random() % 4 == 0) {
+					sphere.radius = 0.0f;
+				}
+
+			}
+
+		}
+
+		return spheres;
+
+	}
+
+	//marginだけ広げる(中心と大きさに直す時の丸めで球より小さくならないように)
+	AABB MakeSphereBox(const BoundingSphere& sphere, float margin = 0.0f) {
+
+		float radius = sphere.radius + margin;
+
+		return {
+			{ sphere.center.x - radius, sphere.center.y - radius, sphere.center.z - radius },
+			{ sphere.center.x + radius, sphere.center.y + radius, sphere.center.z + radius },
+		};
+
+	}
+
+	//箱は球を囲むものから各軸の大きさを変える
+	std::vector<AABB> MakeRandomAABBs(const Frustum& frustum, size_t count, uint32_t seed) {
+
+		std::vector<BoundingSphere> spheres = MakeRandomSpheres(frustum, count, seed);
+
+		std::mt19937 random(seed + 1);
+
+		std::uniform_real_distribution<float> scale(0.0f, 1.0f);
+
+		std::vector<AABB> aabbs(count);
+
+		for (size_t i = 0; i < count; ++i) {
+
+			AABB aabb = MakeSphereBox(spheres[i]);
+
+			aabb.max.y = aabb.min.y + (aabb.max.y - aabb.min.y) * scale(random);
+
+			aabbs[i] = aabb;
+
+		}
+
+		return aabbs;
+
+	}
+
+	//[begin, end)のうちreferenceで見えるもの
+	template<typename Bounds, typename IsVisible>
+	std::vector<uint32_t> MakeReferenceIndices(const std::vector<Bounds>& bounds, size_t begin, size_t end, const IsVisible& isVisible) {
+
+		std::vector<uint32_t> indices;
+
+		for (size_t i = begin; i < end; ++i) {
+			if (isVisible(bounds[i])) {
+				indices.push_back(static_cast<uint32_t>(i));
+			}
+		}
+
+		return indices;
+
+	}
+
+	//SIMDの幅で割り切れない始まりと終わりも試す
+	const size_t kTestCount = 10007;
+
+	const size_t kRanges[][2] = {
+		{ 0, kTestCount },
+		{ 3, kTestCount - 5 },
+		{ 1, 2 },
+		{ 7, 7 },
+		{ 8, 24 },
+		{ 13, 19 },
+	};
+
+}
+
+TEST_CASE(FrustumPlanesFollowCamera) {
+
+	Frustum frustum = MakeTestFrustum();
+
+	auto isVisible = [&](float x, float y, float z, float radius) {
+		return ReferenceIsSphereVisible(frustum, { { x, y, z }, radius });
+	};
+
+	CHECK(isVisible(0.0f, 0.0f, 10.0f, 0.0f));
+	CHECK(!isVisible(0.0f, 0.0f, -10.0f, 1.0f));
+
+	//近クリップ面と遠クリップ面
+	CHECK(!isVisible(0.0f, 0.0f, 0.05f, 0.0f));
+	CHECK(isVisible(0.0f, 0.0f, 0.05f, 0.1f));
+	CHECK(!isVisible(0.0f, 0.0f, 101.0f, 0.5f));
+	CHECK(isVisible(0.0f, 0.0f, 101.0f, 2.0f));
+
+	//横は縦より広い(16:9)
+	CHECK(isVisible(12.0f, 0.0f, 20.0f, 0.0f));
+	CHECK(!isVisible(0.0f, 12.0f, 20.0f, 0.0f));
+
+	//平面の法線は正規化されている
+	for (const Vector4& plane : frustum.planes) {
+		CHECK(std::fabs(std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z) - 1.0f) < 1e-5f);
+	}
+
+}
+
+TEST_CASE(CullSpheresMatchesScalarReference) {
+
+	Frustum frustum = MakeTestFrustum();
+
+	std::vector<BoundingSphere> spheres = MakeRandomSpheres(frustum, kTestCount, 36);
+
+	BoundingSphereArray array;
+	array.Resize(spheres.size());
+
+	for (size_t i = 0; i < spheres.size(); ++i) {
+		array.Set(i, spheres[i]);
+	}
+
+	std::vector<uint32_t> visibleIndices(spheres.size());
+
+	for (const auto& range : kRanges) {
+
+		std::vector<uint32_t> expected = MakeReferenceIndices(spheres, range[0], range[1], [&](const BoundingSphere& sphere) {
+			return ReferenceIsSphereVisible(frustum, sphere);
+		});
+
+		size_t visibleCount = CullSpheres(frustum, array, range[0], range[1], visibleIndices.data());
+
+		CHECK(std::vector<uint32_t>(visibleIndices.begin(), visibleIndices.begin() + visibleCount) == expected);
+
+	}
+
+	//見えるものと見えないものが両方ある
+	size_t visibleCount = CullSpheres(frustum, array, 0, spheres.size(), visibleIndices.data());
+
+	CHECK(visibleCount > 0);
+	CHECK(visibleCount < spheres.size());
+
+}
+
+TEST_CASE(CullAABBsMatchesScalarReference) {
+
+	Frustum frustum = MakeTestFrustum();
+
+	std::vector<AABB> aabbs = MakeRandomAABBs(frustum, kTestCount, 37);
+
+	AABBArray array;
+	array.Resize(aabbs.size());
+
+	for (size_t i = 0; i < aabbs.size(); ++i) {
+		array.Set(i, aabbs[i]);
+	}
+
+	std::vector<uint32_t> visibleIndices(aabbs.size());
+
+	for (const auto& range : kRanges) {
+
+		std::vector<uint32_t> expected = MakeReferenceIndices(aabbs, range[0], range[1], [&](const AABB& aabb) {
+			return ReferenceIsAABBVisible(frustum, aabb);
+		});
+
+		size_t visibleCount = CullAABBs(frustum, array, range[0], range[1], visibleIndices.data());
+
+		CHECK(std::vector<uint32_t>(visibleIndices.begin(), visibleIndices.begin() + visibleCount) == expected);
+
+	}
+
+}
+
+TEST_CASE(BoxAroundVisibleSphereIsVisible) {
+
+	Frustum frustum = MakeTestFrustum();
+
+	std::vector<BoundingSphere> spheres = MakeRandomSpheres(frustum, kTestCount, 38);
+
+	BoundingSphereArray sphereArray;
+	sphereArray.Resize(spheres.size());
+
+	AABBArray aabbArray;
+	aabbArray.Resize(spheres.size());
+
+	for (size_t i = 0; i < spheres.size(); ++i) {
+		sphereArray.Set(i, spheres[i]);
+		aabbArray.Set(i, MakeSphereBox(spheres[i], 1e-3f));
+	}
+
+	std::vector<uint32_t> visibleSpheres(spheres.size());
+	std::vector<uint32_t> visibleBoxes(spheres.size());
+
+	size_t sphereCount = CullSpheres(frustum, sphereArray, 0, spheres.size(), visibleSpheres.data());
+	size_t boxCount = CullAABBs(frustum, aabbArray, 0, spheres.size(), visibleBoxes.data());
+
+	//球を囲む箱の方が大きいので、球が見えれば箱も見える
+	std::vector<bool> isBoxVisible(spheres.size(), false);
+
+	for (size_t i = 0; i < boxCount; ++i) {
+		isBoxVisible[visibleBoxes[i]] = true;
+	}
+
+	size_t missingCount = 0;
+
+	for (size_t i = 0; i < sphereCount; ++i) {
+		if (!isBoxVisible[visibleSpheres[i]]) {
+			missingCount++;
+		}
+	}
+
+	CHECK(missingCount == 0);
+	CHECK(boxCount >= sphereCount);
+
+}
+
+TEST_CASE(ParallelCullMatchesSingleThread) {
+
+	Frustum frustum = MakeTestFrustum();
+
+	const size_t kCount = 100003;
+
+	std::vector<BoundingSphere> spheres = MakeRandomSpheres(frustum, kCount, 39);
+
+	BoundingSphereArray sphereArray;
+	sphereArray.Resize(kCount);
+
+	AABBArray aabbArray;
+	aabbArray.Resize(kCount);
+
+	for (size_t i = 0; i < kCount; ++i) {
+		sphereArray.Set(i, spheres[i]);
+		aabbArray.Set(i, MakeSphereBox(spheres[i]));
+	}
+
+	JobSystem jobSystem;
+	jobSystem.Initialize(3);
+
+	std::vector<uint32_t> single(kCount);
+	std::vector<uint32_t> parallel(kCount);
+
+	//塊ごとの結果を詰めてもインデックスの昇順になる
+	size_t singleCount = FrustumCull(frustum, sphereArray, single.data(), nullptr);
+	size_t parallelCount = FrustumCull(frustum, sphereArray, parallel.data(), &jobSystem);
+
+	REQUIRE(singleCount == parallelCount);
+	CHECK(std::equal(single.begin(), single.begin() + singleCount, parallel.begin()));
+
+	singleCount = FrustumCull(frustum, aabbArray, single.data(), nullptr);
+	parallelCount = FrustumCull(frustum, aabbArray, parallel.data(), &jobSystem);
+
+	REQUIRE(singleCount == parallelCount);
+	CHECK(std::equal(single.begin(), single.begin() + singleCount, parallel.begin()));
+
+	jobSystem.Finalize();
+
+	//空の配列
+	BoundingSphereArray empty;
+
+	CHECK(FrustumCull(frustum, empty, single.data(), nullptr) == 0);
+
+}
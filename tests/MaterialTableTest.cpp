@@ -0,0 +1,206 @@
+#include "TestFramework.h"
+#include "MaterialTable.h"
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+	Material MakeMaterial(float value, uint32_t textureIndex, uint32_t flags) {
+		return { { value, value + 0.25f, value + 0.5f, 1.0f }, textureIndex, flags };
+	}
+
+	//Uploadが書いていないレコードを見分けるための値
+	MaterialRecord MakeSentinelRecord() {
+
+		MaterialRecord record;
+
+		std::memset(&record, 0xcd, sizeof(record));
+
+		return record;
+
+	}
+
+	bool IsSentinel(const MaterialRecord& record) {
+
+		MaterialRecord sentinel = MakeSentinelRecord();
+
+		return std::memcmp(&record, &sentinel, sizeof(record)) == 0;
+
+	}
+
+	bool IsSameRecord(const MaterialRecord& a, const MaterialRecord& b) {
+		return std::memcmp(&a, &b, sizeof(a)) == 0;
+	}
+
+}
+
+TEST_CASE(MaterialRecordMatchesShaderLayout) {
+
+	//Object3d.PS.hlslのMaterial(float4 color, uint textureIndex, uint flags, float2 padding)と同じ並び
+	CHECK(sizeof(MaterialRecord) == 32);
+	CHECK(offsetof(MaterialRecord, color) == 0);
+	CHECK(offsetof(MaterialRecord, textureIndex) == 16);
+	CHECK(offsetof(MaterialRecord, flags) == 20);
+	CHECK(offsetof(MaterialRecord, padding) == 24);
+
+}
+
+TEST_CASE(PackCopiesFieldsAndClearsPadding) {
+
+	Material material = MakeMaterial(0.5f, 7, 3);
+
+	MaterialRecord record = MaterialTable::Pack(material);
+
+	CHECK(record.color[0] == 0.5f);
+	CHECK(record.color[1] == 0.75f);
+	CHECK(record.color[2] == 1.0f);
+	CHECK(record.color[3] == 1.0f);
+	CHECK(record.textureIndex == 7);
+	CHECK(record.flags == 3);
+	CHECK(record.padding[0] == 0);
+	CHECK(record.padding[1] == 0);
+
+	CHECK(MaterialTable::Pack(MakeMaterial(0.0f, kInvalidTextureIndex, 0)).textureIndex == kInvalidTextureIndex);
+
+}
+
+TEST_CASE(AddReturnsSequentialIndices) {
+
+	MaterialTable table;
+	table.Initialize(4);
+
+	CHECK(table.GetCapacity() == 4);
+	CHECK(table.GetCount() == 0);
+
+	CHECK(table.Add(MakeMaterial(0.0f, 0, 0)) == 0);
+	CHECK(table.Add(MakeMaterial(1.0f, 1, 0)) == 1);
+	CHECK(table.GetCount() == 2);
+	CHECK(table.Get(1).textureIndex == 1);
+
+	table.Set(0, MakeMaterial(2.0f, 5, 1));
+
+	CHECK(table.Get(0).color.x == 2.0f);
+	CHECK(table.Get(0).textureIndex == 5);
+
+	//Initializeで空になる
+	table.Initialize(2);
+
+	CHECK(table.GetCount() == 0);
+	CHECK(table.Add(MakeMaterial(0.0f, 0, 0)) == 0);
+
+}
+
+TEST_CASE(UploadWritesOnlyDirtyRange) {
+
+	const uint32_t kCapacity = 16;
+
+	MaterialTable table;
+	table.Initialize(kCapacity);
+
+	for (uint32_t i = 0; i < 10; ++i) {
+		table.Add(MakeMaterial(float(i), i, 0));
+	}
+
+	std::vector<MaterialRecord> records(kCapacity, MakeSentinelRecord());
+
+	//追加したものは全て書かれ、使っていない後ろは触らない
+	table.Upload(records.data());
+
+	for (uint32_t i = 0; i < kCapacity; ++i) {
+		if (i < 10) {
+			CHECK(IsSameRecord(records[i], MaterialTable::Pack(table.Get(i))));
+		} else {
+			CHECK(IsSentinel(records[i]));
+		}
+	}
+
+	//変更がなければ何も書かない
+	std::fill(records.begin(), records.end(), MakeSentinelRecord());
+
+	table.Upload(records.data());
+
+	for (const MaterialRecord& record : records) {
+		CHECK(IsSentinel(record));
+	}
+
+	//離れた2つを変えると、その間を含む範囲だけを書く
+	table.Set(6, MakeMaterial(60.0f, 60, 1));
+	table.Set(3, MakeMaterial(30.0f, 30, 1));
+
+	table.Upload(records.data());
+
+	for (uint32_t i = 0; i < kCapacity; ++i) {
+		if (3 <= i && i <= 6) {
+			CHECK(IsSameRecord(records[i], MaterialTable::Pack(table.Get(i))));
+		} else {
+			CHECK(IsSentinel(records[i]));
+		}
+	}
+
+	CHECK(records[3].textureIndex == 30);
+	CHECK(records[6].textureIndex == 60);
+
+	//範囲はUploadで空に戻る
+	std::fill(records.begin(), records.end(), MakeSentinelRecord());
+
+	table.Set(9, MakeMaterial(90.0f, 90, 0));
+
+	table.Upload(records.data());
+
+	for (uint32_t i = 0; i < kCapacity; ++i) {
+		CHECK(IsSentinel(records[i]) == (i != 9));
+	}
+
+	//0番だけを変えても空の範囲と区別できる
+	std::fill(records.begin(), records.end(), MakeSentinelRecord());
+
+	table.Set(0, MakeMaterial(-1.0f, 0, 0));
+
+	table.Upload(records.data());
+
+	CHECK(records[0].color[0] == -1.0f);
+	CHECK(IsSentinel(records[1]));
+
+}
+
+TEST_CASE(UploadKeepsGpuCopyInSync) {
+
+	const uint32_t kCapacity = 64;
+
+	MaterialTable table;
+	table.Initialize(kCapacity);
+
+	std::vector<MaterialRecord> records(kCapacity, MakeSentinelRecord());
+
+	uint32_t seed = 1;
+
+	//フレームごとに追加と変更を混ぜ、毎回Uploadしたバッファが全てのマテリアルと一致する
+	for (uint32_t frame = 0; frame < 200; ++frame) {
+
+		seed = seed * 1664525u + 1013904223u;
+
+		if (table.GetCount() < kCapacity && (seed >> 28) < 4) {
+			table.Add(MakeMaterial(float(frame), frame, 0));
+		}
+
+		uint32_t changeCount = (seed >> 8) % 3;
+
+		for (uint32_t i = 0; i < changeCount && table.GetCount() > 0; ++i) {
+			seed = seed * 1664525u + 1013904223u;
+			table.Set((seed >> 8) % table.GetCount(), MakeMaterial(float(frame) + 0.5f, seed, frame));
+		}
+
+		table.Upload(records.data());
+
+		for (uint32_t i = 0; i < kCapacity; ++i) {
+			if (i < table.GetCount()) {
+				CHECK(IsSameRecord(records[i], MaterialTable::Pack(table.Get(i))));
+			} else {
+				CHECK(IsSentinel(records[i]));
+			}
+		}
+
+	}
+
+}
@@ -0,0 +1,272 @@
+#include "Benchmark.h"
+#include "MeshImporter.h"
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+//OBJとGLBの読み込みの速さと使ったメモリを測る(本来の大きさはどちらも100MB以上)
+//格子状のメッシュをファイルへ少しずつ書き(書く側でメモリを使わないように)、1スレッドとJobSystemの両方で読む
+//メモリはプロセスの最大なので、読み込みごとに増えた分がその読み込みで使った量の目安になる
+
+namespace {
+
+	void AppendFloat(std::string& text, float value) {
+
+		char buffer[32];
+
+		int length = std::snprintf(buffer, sizeof(buffer), " %.6f", value);
+
+		text.append(buffer, length);
+
+	}
+
+	//位置、UV、法線と四角形の面を書いたOBJ。書いたバイト数を返す(失敗したら0)
+	size_t WriteObjFile(const char* path, int gridSize) {
+
+		FILE* file = std::fopen(path, "wb");
+
+		if (file == nullptr) {
+			return 0;
+		}
+
+		std::mt19937 random(1234);
+
+		std::uniform_real_distribution<float> noise(-0.01f, 0.01f);
+
+		std::string text = "# benchmark grid\no grid\n";
+
+		size_t size = 0;
+
+		bool isSucceeded = true;
+
+		auto flush = [&]() {
+			isSucceeded = isSucceeded && std::fwrite(text.data(), 1, text.size(), file) == text.size();
+			size += text.size();
+			text.clear();
+		};
+
+		int rowCount = gridSize + 1;
+
+		for (int z = 0; z < rowCount; ++z) {
+
+			for (int x = 0; x < rowCount; ++x) {
+
+				text += "v";
+				AppendFloat(text, x * 0.01f + noise(random));
+				AppendFloat(text, noise(random));
+				AppendFloat(text, z * 0.01f + noise(random));
+				text += "\nvt";
+				AppendFloat(text, float(x) / gridSize);
+				AppendFloat(text, float(z) / gridSize);
+				text += "\nvn";
+				AppendFloat(text, noise(random));
+				AppendFloat(text, 1.0f);
+				AppendFloat(text, noise(random));
+				text += "\n";
+
+			}
+
+			flush();
+
+		}
+
+		for (int z = 0; z < gridSize; ++z) {
+
+			for (int x = 0; x < gridSize; ++x) {
+
+				int index = z * rowCount + x + 1;
+
+				int corners[4] = { index, index + 1, index + rowCount + 1, index + rowCount };
+
+				text += "f";
+
+				for (int corner : corners) {
+					std::string value = std::to_string(corner);
+					text += " " + value + "/" + value + "/" + value;
+				}
+
+				text += "\n";
+
+			}
+
+			flush();
+
+		}
+
+		std::fclose(file);
+
+		return isSucceeded ? size : 0;
+
+	}
+
+	//同じ格子を、位置と法線とUVを交互に並べた頂点(32バイト)と32bitのインデックスで書いたGLB
+	size_t WriteGlbFile(const char* path, int gridSize) {
+
+		FILE* file = std::fopen(path, "wb");
+
+		if (file == nullptr) {
+			return 0;
+		}
+
+		int rowCount = gridSize + 1;
+
+		size_t vertexCount = size_t(rowCount) * rowCount;
+		size_t indexCount = size_t(gridSize) * gridSize * 6;
+
+		size_t vertexBytes = vertexCount * 32;
+		size_t indexBytes = indexCount * 4;
+		size_t binarySize = vertexBytes + indexBytes;
+
+		char json[1024];
+
+		int jsonLength = std::snprintf(json, sizeof(json),
+			R"({"asset":{"version":"2.0"},"meshes":[{"primitives":[{"attributes":{"POSITION":0,"NORMAL":1,"TEXCOORD_0":2},"indices":3}]}],)"
+			R"("accessors":[{"bufferView":0,"componentType":5126,"count":%zu,"type":"VEC3"},{"bufferView":0,"byteOffset":12,"componentType":5126,"count":%zu,"type":"VEC3"},)"
+			R"({"bufferView":0,"byteOffset":24,"componentType":5126,"count":%zu,"type":"VEC2"},{"bufferView":1,"componentType":5125,"count":%zu,"type":"SCALAR"}],)"
+			R"("bufferViews":[{"buffer":0,"byteLength":%zu,"byteStride":32},{"buffer":0,"byteOffset":%zu,"byteLength":%zu}],"buffers":[{"byteLength":%zu}]})",
+			vertexCount, vertexCount, vertexCount, indexCount, vertexBytes, vertexBytes, indexBytes, binarySize);
+
+		std::string jsonChunk(json, jsonLength);
+
+		while (jsonChunk.size() % 4 != 0) {
+			jsonChunk += ' ';
+		}
+
+		uint32_t header[5] = { 0x46546c67, 2, static_cast<uint32_t>(12 + 8 + jsonChunk.size() + 8 + binarySize), static_cast<uint32_t>(jsonChunk.size()), 0x4e4f534a };
+		uint32_t binaryHeader[2] = { static_cast<uint32_t>(binarySize), 0x004e4942 };
+
+		bool isSucceeded =
+			std::fwrite(header, sizeof(header), 1, file) == 1 &&
+			std::fwrite(jsonChunk.data(), 1, jsonChunk.size(), file) == jsonChunk.size() &&
+			std::fwrite(binaryHeader, sizeof(binaryHeader), 1, file) == 1;
+
+		std::mt19937 random(1234);
+
+		std::uniform_real_distribution<float> noise(-0.01f, 0.01f);
+
+		std::vector<float> row;
+
+		for (int z = 0; z < rowCount && isSucceeded; ++z) {
+
+			row.clear();
+
+			for (int x = 0; x < rowCount; ++x) {
+				float vertex[8] = { x * 0.01f + noise(random), noise(random), z * 0.01f + noise(random), noise(random), 1.0f, noise(random), float(x) / gridSize, float(z) / gridSize };
+				row.insert(row.end(), vertex, vertex + 8);
+			}
+
+			isSucceeded = std::fwrite(row.data(), sizeof(float), row.size(), file) == row.size();
+
+		}
+
+		std::vector<uint32_t> indices;
+
+		for (int z = 0; z < gridSize && isSucceeded; ++z) {
+
+			indices.clear();
+
+			for (int x = 0; x < gridSize; ++x) {
+
+				uint32_t index = z * rowCount + x;
+
+				uint32_t quad[6] = { index, index + 1, index + rowCount + 1, index, index + rowCount + 1, index + rowCount };
+
+				indices.insert(indices.end(), quad, quad + 6);
+
+			}
+
+			isSucceeded = std::fwrite(indices.data(), sizeof(uint32_t), indices.size(), file) == indices.size();
+
+		}
+
+		std::fclose(file);
+
+		return isSucceeded ? 12 + 8 + jsonChunk.size() + 8 + binarySize : 0;
+
+	}
+
+}
+
+int main(int argc, char** argv) {
+
+	bool isQuick = IsQuickBenchmark(argc, argv);
+
+	//OBJは800で約101MB、GLBは1400で約110MB
+	int objGridSize = isQuick ? 120 : 800;
+	int glbGridSize = isQuick ? 200 : 1400;
+
+	struct Format {
+		const char* name;
+		std::filesystem::path path;
+		int gridSize;
+		size_t size;
+	};
+
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+
+	Format formats[] = {
+		{ "obj", directory / "MeshImporterBenchmark.obj", objGridSize, 0 },
+		{ "glb", directory / "MeshImporterBenchmark.glb", glbGridSize, 0 },
+	};
+
+	formats[0].size = WriteObjFile(formats[0].path.string().c_str(), objGridSize);
+	formats[1].size = WriteGlbFile(formats[1].path.string().c_str(), glbGridSize);
+
+	for (const Format& format : formats) {
+		if (format.size == 0) {
+			std::printf("failed to write %s\n", format.path.string().c_str());
+			return 1;
+		}
+	}
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	std::printf("%u threads, peak memory before importing %.1f MB\n", jobSystem.GetThreadCount(), GetPeakMemoryMegabytes());
+	std::printf("  %-4s %-14s %8s %10s %10s %12s %10s %10s\n", "", "", "MB", "ms", "MB/s", "peak MB", "vertices", "triangles");
+
+	int result = 0;
+
+	const char* names[] = { "single thread", "job system" };
+
+	JobSystem* jobSystems[] = { nullptr, &jobSystem };
+
+	for (const Format& format : formats) {
+
+		double megabytes = format.size / (1024.0 * 1024.0);
+
+		for (int i = 0; i < 2; ++i) {
+
+			MeshData mesh;
+
+			bool isSucceeded = true;
+
+			double milliseconds = MeasureBestMilliseconds(isQuick ? 1 : 3, [&]() {
+				mesh = MeshData();
+				isSucceeded = ImportMesh(format.path.string().c_str(), mesh, jobSystems[i]);
+			});
+
+			if (!isSucceeded || mesh.indices.size() != size_t(format.gridSize) * format.gridSize * 6) {
+				std::printf("  %-4s %-14s import failed\n", format.name, names[i]);
+				result = 1;
+				continue;
+			}
+
+			std::printf("  %-4s %-14s %8.1f %10.1f %10.1f %12.1f %10zu %10zu\n", format.name, names[i], megabytes, milliseconds, megabytes / milliseconds * 1000.0,
+				GetPeakMemoryMegabytes(), mesh.vertices.size(), mesh.indices.size() / 3);
+
+		}
+
+	}
+
+	jobSystem.Finalize();
+
+	for (const Format& format : formats) {
+		std::filesystem::remove(format.path);
+	}
+
+	return result;
+
+}
@@ -0,0 +1,513 @@
+#include "TestFramework.h"
+#include "MeshImporter.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+	bool ParseObjText(const std::string& text, MeshData& mesh, JobSystem* jobSystem = nullptr) {
+		return ParseObj(text.data(), text.size(), mesh, jobSystem);
+	}
+
+	//n×nの格子を四角形の面で書いたOBJ(面の行にはコメントを付ける)
+	std::string MakeGridObj(int n) {
+
+		std::string text = "# grid\no grid\n";
+
+		for (int z = 0; z <= n; ++z) {
+			for (int x = 0; x <= n; ++x) {
+				text += "v " + std::to_string(x) + " 0 " + std::to_string(z) + "\n";
+			}
+		}
+
+		for (int z = 0; z < n; ++z) {
+			for (int x = 0; x < n; ++x) {
+
+				int i = z * (n + 1) + x + 1;
+
+				text += "f " + std::to_string(i) + " " + std::to_string(i + 1) + " " + std::to_string(i + n + 2) + " " + std::to_string(i + n + 1) + " # quad\n";
+
+			}
+		}
+
+		return text;
+
+	}
+
+	void AppendFloats(std::vector<uint8_t>& bytes, std::initializer_list<float> values) {
+		for (float value : values) {
+			const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+			bytes.insert(bytes.end(), p, p + sizeof(value));
+		}
+	}
+
+	void AppendUint16s(std::vector<uint8_t>& bytes, std::initializer_list<uint16_t> values) {
+		for (uint16_t value : values) {
+			const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+			bytes.insert(bytes.end(), p, p + sizeof(value));
+		}
+	}
+
+	std::string EncodeBase64(const std::vector<uint8_t>& bytes) {
+
+		const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+		std::string text;
+
+		for (size_t i = 0; i < bytes.size(); i += 3) {
+
+			uint32_t value = uint32_t(bytes[i]) << 16;
+
+			if (i + 1 < bytes.size()) value |= uint32_t(bytes[i + 1]) << 8;
+			if (i + 2 < bytes.size()) value |= bytes[i + 2];
+
+			text += table[(value >> 18) & 63];
+			text += table[(value >> 12) & 63];
+			text += i + 1 < bytes.size() ? table[(value >> 6) & 63] : '=';
+			text += i + 2 < bytes.size() ? table[value & 63] : '=';
+
+		}
+
+		return text;
+
+	}
+
+	//JSONとBINのチャンクを並べたGLB(チャンクは4バイト境界に揃える)
+	std::vector<uint8_t> MakeGlb(std::string json, std::vector<uint8_t> binary) {
+
+		while (json.size() % 4 != 0) json += ' ';
+		while (binary.size() % 4 != 0) binary.push_back(0);
+
+		std::vector<uint8_t> bytes;
+
+		auto appendUint32 = [&](uint32_t value) {
+			const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+			bytes.insert(bytes.end(), p, p + sizeof(value));
+		};
+
+		appendUint32(0x46546c67);
+		appendUint32(2);
+		appendUint32(static_cast<uint32_t>(12 + 8 + json.size() + 8 + binary.size()));
+
+		appendUint32(static_cast<uint32_t>(json.size()));
+		appendUint32(0x4e4f534a);
+		bytes.insert(bytes.end(), json.begin(), json.end());
+
+		appendUint32(static_cast<uint32_t>(binary.size()));
+		appendUint32(0x004e4942);
+		bytes.insert(bytes.end(), binary.begin(), binary.end());
+
+		return bytes;
+
+	}
+
+	//一時フォルダに書いてImportGltfで読む
+	bool ImportGltfBytes(const char* name, const void* data, size_t size, MeshData& mesh, JobSystem* jobSystem = nullptr) {
+
+		std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+
+		FILE* file = std::fopen(path.string().c_str(), "wb");
+
+		if (file == nullptr) {
+			return false;
+		}
+
+		std::fwrite(data, 1, size, file);
+		std::fclose(file);
+
+		bool isSucceeded = ImportGltf(path.string().c_str(), mesh, jobSystem);
+
+		std::filesystem::remove(path);
+
+		return isSucceeded;
+
+	}
+
+	bool ImportGltfText(const std::string& json, MeshData& mesh) {
+		return ImportGltfBytes("MeshImporterTest.gltf", json.data(), json.size(), mesh);
+	}
+
+	bool ImportGlb(const std::vector<uint8_t>& bytes, MeshData& mesh, JobSystem* jobSystem = nullptr) {
+		return ImportGltfBytes("MeshImporterTest.glb", bytes.data(), bytes.size(), mesh, jobSystem);
+	}
+
+	//位置と法線を交互に並べた三角形2つ(byteStrideは24)と、16bitのインデックス
+	std::vector<uint8_t> MakeInterleavedQuadBinary() {
+
+		std::vector<uint8_t> bytes;
+
+		AppendFloats(bytes, { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f });
+		AppendFloats(bytes, { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f });
+		AppendFloats(bytes, { 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f });
+		AppendFloats(bytes, { 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f });
+
+		AppendUint16s(bytes, { 0, 1, 2, 0, 2, 3 });
+
+		return bytes;
+
+	}
+
+	//accessorsとbufferViewsを差し替えられるglTF(バッファはMakeInterleavedQuadBinaryの108バイト)
+	std::string MakeQuadJson(const std::string& accessors, const std::string& bufferViews, const std::string& nodes = R"([{ "mesh": 0 }])") {
+		return R"({ "asset": { "version": "2.0" }, "scene": 0, "scenes": [{ "nodes": [0] }], "nodes": )" + nodes +
+			R"(, "meshes": [{ "primitives": [{ "attributes": { "POSITION": 0, "NORMAL": 1 }, "indices": 2 }] }], "accessors": )" + accessors +
+			R"(, "bufferViews": )" + bufferViews + R"(, "buffers": [{ "byteLength": 108 }] })";
+	}
+
+	const char* kQuadAccessors = R"([
+		{ "bufferView": 0, "componentType": 5126, "count": 4, "type": "VEC3" },
+		{ "bufferView": 0, "byteOffset": 12, "componentType": 5126, "count": 4, "type": "VEC3" },
+		{ "bufferView": 1, "componentType": 5123, "count": 6, "type": "SCALAR" }])";
+
+	const char* kQuadBufferViews = R"([
+		{ "buffer": 0, "byteLength": 96, "byteStride": 24 },
+		{ "buffer": 0, "byteOffset": 96, "byteLength": 12 }])";
+
+}
+
+TEST_CASE(ParseFloatMatchesStrtof) {
+
+	const char* numbers[] = { "1.5", "-0.25", "3e2", "1.0E-3", ".5", "-7", "123456.789", "0.000001234" };
+
+	for (const char* number : numbers) {
+
+		float value = 0.0f;
+
+		const char* end = ParseFloat(number, number + std::strlen(number), value);
+
+		float expected = std::strtof(number, nullptr);
+
+		CHECK(end == number + std::strlen(number));
+		CHECK(std::fabs(value - expected) <= std::fabs(expected) * 1e-6f);
+
+	}
+
+	const char* text = "abc";
+
+	float value = 0.0f;
+
+	CHECK(ParseFloat(text, text + 3, value) == text);
+
+}
+
+TEST_CASE(ParseObjQuadWithAttributes) {
+
+	std::string text =
+		"# comment\r\n"
+		"o quad\r\n"
+		"v 0 0 0\r\nv 1 0 0\r\nv 1 1 0\r\nv 0 1 0\r\n"
+		"vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+		"vn 0 0 1\n"
+		"f 1/1/1 2/2/1 3/3/1 4/4/1\n"
+		"f -4//-1 -2//-1 -1//-1\n";
+
+	MeshData mesh;
+	REQUIRE(ParseObjText(text, mesh));
+
+	CHECK(mesh.indices.size() == 9);
+	CHECK(mesh.vertices.size() == 7);
+
+	//zを反転して向きを入れ替えるので、1つ目の三角形は(1, 3, 2)になる
+	CHECK(mesh.vertices[mesh.indices[1]].position.x == 1.0f);
+	CHECK(mesh.vertices[mesh.indices[1]].position.y == 1.0f);
+	CHECK(mesh.vertices[0].normal.z == -1.0f);
+	CHECK(mesh.vertices[0].texcoord.y == 1.0f);
+	CHECK(mesh.bounds.max.x == 1.0f);
+	CHECK(mesh.bounds.max.y == 1.0f);
+
+}
+
+TEST_CASE(ParseObjIgnoresTrailingComments) {
+
+	std::string text =
+		"v 0 0 0 # origin\n"
+		"v 1 0 0\n"
+		"v 0 1 0\n"
+		"v 1 1 0\n"
+		"f 1 2 3 # c\n"
+		"f 2 4 3#no space\n"
+		"f 1 2 3 4 #\n";
+
+	MeshData mesh;
+	REQUIRE(ParseObjText(text, mesh));
+
+	CHECK(mesh.indices.size() == 12);
+	CHECK(mesh.vertices.size() == 4);
+
+	//コメントだけで頂点が足りない面は今までどおり失敗にする
+	MeshData shortFace;
+	CHECK(!ParseObjText("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 # 3\n", shortFace));
+
+}
+
+TEST_CASE(ParseObjRejectsBrokenFaces) {
+
+	const char* texts[] = {
+		"v 0 0 0\nf 1 2 3\n",
+		"v 0 0 0\nf 1 1\n",
+		"f 0 1 2\n",
+		"v 1 2 3\nf a b c\n",
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3 x\n",
+		"",
+	};
+
+	for (const char* text : texts) {
+		MeshData mesh;
+		CHECK(!ParseObjText(text, mesh));
+	}
+
+}
+
+TEST_CASE(ParseObjWithJobSystemMatchesSingleThread) {
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	//チャンクに分かれる大きさにして、コメント付きの面が境目をまたいでも同じ結果になることを確かめる
+	std::string text = MakeGridObj(300);
+
+	MeshData single;
+	MeshData parallel;
+
+	CHECK(ParseObjText(text, single));
+	CHECK(ParseObjText(text, parallel, &jobSystem));
+
+	CHECK(single.indices.size() == 300u * 300u * 6u);
+	CHECK(single.indices == parallel.indices);
+	CHECK(single.vertices.size() == parallel.vertices.size());
+	CHECK(std::memcmp(single.vertices.data(), parallel.vertices.data(), sizeof(MeshVertex) * single.vertices.size()) == 0);
+
+	jobSystem.Finalize();
+
+}
+
+TEST_CASE(ImportGltfWithDataUri) {
+
+	std::vector<uint8_t> binary;
+
+	AppendFloats(binary, { 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f });
+	AppendUint16s(binary, { 0, 1, 2 });
+
+	std::string json = R"({ "asset": { "version": "2.0" },
+		"meshes": [{ "primitives": [{ "attributes": { "POSITION": 0 }, "indices": 1 }] }],
+		"accessors": [
+			{ "bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3" },
+			{ "bufferView": 0, "byteOffset": 36, "componentType": 5123, "count": 3, "type": "SCALAR" }],
+		"bufferViews": [{ "buffer": 0, "byteLength": 42 }],
+		"buffers": [{ "byteLength": 42, "uri": "data:application/octet-stream;base64,)" + EncodeBase64(binary) + R"(" }] })";
+
+	MeshData mesh;
+	REQUIRE(ImportGltfText(json, mesh));
+
+	CHECK(mesh.vertices.size() == 3);
+	CHECK(mesh.indices.size() == 3);
+
+	//zを反転して向きを入れ替えるので(0, 2, 1)になる
+	CHECK(mesh.indices[0] == 0 && mesh.indices[1] == 2 && mesh.indices[2] == 1);
+	CHECK(mesh.vertices[1].position.x == 1.0f);
+	CHECK(mesh.vertices[1].position.z == -1.0f);
+
+	//法線がなければ面から作る(右手系の+zを向いた三角形は左手系の-zを向く)
+	CHECK(std::fabs(mesh.vertices[0].normal.z + 1.0f) < 1e-5f);
+
+	//壊れたbase64は読めない
+	std::string broken = json;
+	broken.replace(broken.find("base64,") + 7, 4, "!!!!");
+
+	CHECK(!ImportGltfText(broken, mesh));
+	CHECK(mesh.vertices.empty());
+
+}
+
+TEST_CASE(ImportGlbWithNodeTransformsAndInterleavedAccessors) {
+
+	//親は(10, 0, 0)へ平行移動、子は2倍に拡大してメッシュを置く
+	std::string nodes = R"([
+		{ "translation": [10, 0, 0], "children": [1] },
+		{ "scale": [2, 2, 2], "mesh": 0 }])";
+
+	MeshData mesh;
+	REQUIRE(ImportGlb(MakeGlb(MakeQuadJson(kQuadAccessors, kQuadBufferViews, nodes), MakeInterleavedQuadBinary()), mesh));
+
+	CHECK(mesh.vertices.size() == 4);
+	CHECK(mesh.indices.size() == 6);
+
+	CHECK(mesh.vertices[2].position.x == 12.0f);
+	CHECK(mesh.vertices[2].position.y == 2.0f);
+	CHECK(mesh.vertices[2].position.z == 0.0f);
+	CHECK(mesh.vertices[2].normal.z == -1.0f);
+	CHECK(mesh.indices[1] == 2 && mesh.indices[2] == 1);
+
+	CHECK(mesh.bounds.min.x == 10.0f);
+	CHECK(mesh.bounds.max.x == 12.0f);
+
+	//xだけ鏡像にすると、zの反転と打ち消し合って向きは入れ替えない
+	std::string mirrored = R"([{ "scale": [-1, 1, 1], "mesh": 0 }])";
+
+	REQUIRE(ImportGlb(MakeGlb(MakeQuadJson(kQuadAccessors, kQuadBufferViews, mirrored), MakeInterleavedQuadBinary()), mesh));
+
+	CHECK(mesh.vertices[1].position.x == -1.0f);
+	CHECK(mesh.indices[1] == 1 && mesh.indices[2] == 2);
+
+	//行列(列優先)で書いた平行移動も同じように効く。ジョブシステムでも同じ結果になる
+	std::string matrix = R"([{ "matrix": [1,0,0,0, 0,1,0,0, 0,0,1,0, 0,5,3,1], "mesh": 0 }])";
+
+	JobSystem jobSystem;
+	jobSystem.Initialize(2);
+
+	REQUIRE(ImportGlb(MakeGlb(MakeQuadJson(kQuadAccessors, kQuadBufferViews, matrix), MakeInterleavedQuadBinary()), mesh, &jobSystem));
+
+	CHECK(mesh.vertices[0].position.y == 5.0f);
+	CHECK(mesh.vertices[0].position.z == -3.0f);
+
+	jobSystem.Finalize();
+
+}
+
+TEST_CASE(ImportGlbRejectsBadAccessors) {
+
+	std::vector<uint8_t> binary = MakeInterleavedQuadBinary();
+
+	//POSITIONのアクセサだけを差し替える
+	auto withPosition = [](const std::string& position) {
+		return "[" + position + R"(,
+			{ "bufferView": 0, "byteOffset": 12, "componentType": 5126, "count": 4, "type": "VEC3" },
+			{ "bufferView": 1, "componentType": 5123, "count": 6, "type": "SCALAR" }])";
+	};
+
+	const std::string accessors[] = {
+		//疎なアクセサは扱わない
+		withPosition(R"({ "bufferView": 0, "componentType": 5126, "count": 4, "type": "VEC3", "sparse": { "count": 1 } })"),
+		//負の数、小数、とても大きな数
+		withPosition(R"({ "bufferView": 0, "componentType": 5126, "count": -1, "type": "VEC3" })"),
+		withPosition(R"({ "bufferView": 0, "componentType": 5126, "count": 2.5, "type": "VEC3" })"),
+		withPosition(R"({ "bufferView": 0, "componentType": 5126, "count": 1e300, "type": "VEC3" })"),
+		withPosition(R"({ "bufferView": 0, "byteOffset": -12, "componentType": 5126, "count": 4, "type": "VEC3" })"),
+		withPosition(R"({ "bufferView": 0, "componentType": -5126, "count": 4, "type": "VEC3" })"),
+		//1つ多い(最後の要素がビューからはみ出す)
+		withPosition(R"({ "bufferView": 0, "componentType": 5126, "count": 5, "type": "VEC3" })"),
+		withPosition(R"({ "bufferView": 0, "byteOffset": 96, "componentType": 5126, "count": 1, "type": "VEC3" })"),
+		//番号が範囲外か数でない
+		withPosition(R"({ "bufferView": 2, "componentType": 5126, "count": 4, "type": "VEC3" })"),
+		withPosition(R"({ "bufferView": 0.5, "componentType": 5126, "count": 4, "type": "VEC3" })"),
+		withPosition(R"({ "bufferView": "0", "componentType": 5126, "count": 4, "type": "VEC3" })"),
+	};
+
+	for (const std::string& accessor : accessors) {
+		MeshData mesh;
+		CHECK(!ImportGlb(MakeGlb(MakeQuadJson(accessor, kQuadBufferViews), binary), mesh));
+	}
+
+	//2^63個の16bitインデックスは(count - 1) * stride + 2が64bitで桁あふれして0になり、掛け算で確かめると通ってしまう
+	//(2^53を超える整数はJSONの解析で弾くので、指数で書く)
+	std::string wrappedIndices = R"([
+		{ "bufferView": 0, "componentType": 5126, "count": 4, "type": "VEC3" },
+		{ "bufferView": 0, "byteOffset": 12, "componentType": 5126, "count": 4, "type": "VEC3" },
+		{ "bufferView": 1, "componentType": 5123, "count": 9.223372036854775808e18, "type": "SCALAR" }])";
+
+	MeshData wrapped;
+	CHECK(!ImportGlb(MakeGlb(MakeQuadJson(wrappedIndices, kQuadBufferViews), binary), wrapped));
+
+	const std::string bufferViews[] = {
+		R"([{ "buffer": 0, "byteLength": 96, "byteStride": 8 }, { "buffer": 0, "byteOffset": 96, "byteLength": 12 }])",
+		R"([{ "buffer": 0, "byteLength": 96, "byteStride": 256 }, { "buffer": 0, "byteOffset": 96, "byteLength": 12 }])",
+		R"([{ "buffer": 0, "byteLength": 96, "byteStride": 24 }, { "buffer": 0, "byteOffset": 97, "byteLength": 12 }])",
+		R"([{ "buffer": 0, "byteLength": 96, "byteStride": 24 }, { "buffer": 0, "byteOffset": -4, "byteLength": 12 }])",
+		R"([{ "buffer": 0, "byteLength": 96, "byteStride": 24 }, { "buffer": 0, "byteOffset": 96, "byteLength": 1e20 }])",
+		R"([{ "buffer": 1, "byteLength": 96, "byteStride": 24 }, { "buffer": 0, "byteOffset": 96, "byteLength": 12 }])",
+	};
+
+	for (const std::string& bufferView : bufferViews) {
+		MeshData mesh;
+		CHECK(!ImportGlb(MakeGlb(MakeQuadJson(kQuadAccessors, bufferView), binary), mesh));
+	}
+
+	//ノードとシーンの番号も確かめる
+	const std::string nodes[] = {
+		R"([{ "mesh": 1 }])",
+		R"([{ "mesh": 0, "children": [-1] }, { "mesh": 0 }])",
+	};
+
+	MeshData mesh;
+
+	CHECK(!ImportGlb(MakeGlb(MakeQuadJson(kQuadAccessors, kQuadBufferViews, nodes[0]), binary), mesh));
+
+	//範囲外の子は辿らない
+	REQUIRE(ImportGlb(MakeGlb(MakeQuadJson(kQuadAccessors, kQuadBufferViews, nodes[1]), binary), mesh));
+	CHECK(mesh.vertices.size() == 4);
+
+	std::string badScene = MakeQuadJson(kQuadAccessors, kQuadBufferViews);
+	badScene.replace(badScene.find("\"scene\": 0"), 10, "\"scene\": -1");
+
+	CHECK(!ImportGlb(MakeGlb(badScene, binary), mesh));
+
+	//バッファのbyteLengthがBINチャンクより大きい
+	std::string longBuffer = MakeQuadJson(kQuadAccessors, kQuadBufferViews);
+	longBuffer.replace(longBuffer.find("108"), 3, "112");
+
+	CHECK(!ImportGlb(MakeGlb(longBuffer, binary), mesh));
+
+}
+
+TEST_CASE(ImportGlbRejectsTruncatedAndMalformedFiles) {
+
+	std::vector<uint8_t> glb = MakeGlb(MakeQuadJson(kQuadAccessors, kQuadBufferViews), MakeInterleavedQuadBinary());
+
+	MeshData mesh;
+	REQUIRE(ImportGlb(glb, mesh));
+
+	//どこで切れても読めない(ヘッダの長さより短い)
+	for (size_t size = 0; size < glb.size(); size += (size < 40 ? 1 : 13)) {
+		std::vector<uint8_t> truncated(glb.begin(), glb.begin() + size);
+		CHECK(!ImportGlb(truncated, mesh));
+	}
+
+	//ヘッダの長さも合わせて切った場合は、BINチャンクがないかバッファが足りない
+	for (size_t size : { size_t(20), glb.size() - 8, glb.size() - 20 }) {
+		std::vector<uint8_t> truncated(glb.begin(), glb.begin() + size);
+		uint32_t length = static_cast<uint32_t>(size);
+		std::memcpy(&truncated[8], &length, sizeof(length));
+		CHECK(!ImportGlb(truncated, mesh));
+	}
+
+	//違う識別子と版
+	std::vector<uint8_t> badMagic = glb;
+	badMagic[0] = 'x';
+	CHECK(!ImportGlb(badMagic, mesh));
+
+	std::vector<uint8_t> badVersion = glb;
+	badVersion[4] = 1;
+	CHECK(!ImportGlb(badVersion, mesh));
+
+	//チャンクの長さがファイルを超える
+	std::vector<uint8_t> badChunk = glb;
+	uint32_t chunkLength = 0x7fffffff;
+	std::memcpy(&badChunk[12], &chunkLength, sizeof(chunkLength));
+	CHECK(!ImportGlb(badChunk, mesh));
+
+	//壊れたJSON
+	const char* texts[] = {
+		"",
+		"{",
+		"[]",
+		R"({ "meshes": [{ "primitives": [ })",
+		R"({ "asset": { "version": "2.0" }, "meshes": [{ "primitives": [{ "attributes": { "POSITION": 0 } }] }] })",
+		R"({ "asset": { "version": "2.0" }, "buffers": [{ "byteLength": 4, "uri": "missing.bin" }] })",
+	};
+
+	for (const char* text : texts) {
+		CHECK(!ImportGltfText(text, mesh));
+	}
+
+	std::string json = MakeQuadJson(kQuadAccessors, kQuadBufferViews);
+
+	for (size_t size = 0; size < json.size(); size += 7) {
+		CHECK(!ImportGlb(MakeGlb(json.substr(0, size), MakeInterleavedQuadBinary()), mesh));
+	}
+
+}
@@ -0,0 +1,270 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+	using TrianglePositions = std::array<float, 9>;
+
+	//頂点を並べ替えても比べられるように、位置で三角形の集合を作る(巡回は保つので向きが変われば一致しない)
+	std::vector<TrianglePositions> MakePositionTriangleSet(const MeshData& mesh) {
+
+		std::vector<TrianglePositions> triangles;
+
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+
+			auto key = [&](size_t corner) {
+				const Vector4& position = mesh.vertices[mesh.indices[i + corner]].position;
+				return std::array<float, 3>{ position.x, position.y, position.z };
+			};
+
+			size_t first = 0;
+
+			for (size_t corner = 1; corner < 3; ++corner) {
+				if (key(corner) < key(first)) {
+					first = corner;
+				}
+			}
+
+			TrianglePositions triangle;
+
+			for (size_t k = 0; k < 3; ++k) {
+				std::array<float, 3> position = key((first + k) % 3);
+				std::copy(position.begin(), position.end(), triangle.begin() + k * 3);
+			}
+
+			triangles.push_back(triangle);
+
+		}
+
+		std::sort(triangles.begin(), triangles.end());
+
+		return triangles;
+
+	}
+
+	//波打った格子の三角形を混ぜる
+	MeshData MakeShuffledGridMesh(uint32_t size, uint32_t seed) {
+
+		MeshData mesh = MakeGridMesh(size);
+
+		for (MeshVertex& vertex : mesh.vertices) {
+			vertex.position.y = std::sin(vertex.position.x * 0.7f) * std::cos(vertex.position.z * 0.4f);
+		}
+
+		size_t triangleCount = mesh.indices.size() / 3;
+
+		std::vector<uint32_t> order(triangleCount);
+
+		for (size_t i = 0; i < triangleCount; ++i) {
+			order[i] = static_cast<uint32_t>(i);
+		}
+
+		std::mt19937 random(seed);
+
+		std::shuffle(order.begin(), order.end(), random);
+
+		std::vector<uint32_t> indices(mesh.indices.size());
+
+		for (size_t i = 0; i < triangleCount; ++i) {
+			for (size_t k = 0; k < 3; ++k) {
+				indices[i * 3 + k] = mesh.indices[order[i] * 3 + k];
+			}
+		}
+
+		mesh.indices = indices;
+
+		return mesh;
+
+	}
+
+}
+
+TEST_CASE(AnalyzeVertexCacheCountsMisses) {
+
+	//2つの三角形で4頂点なので、どちらも初めて使う頂点だけが変換される
+	uint32_t indices[] = { 0, 1, 2, 2, 1, 3 };
+
+	VertexCacheStatistics statistics = AnalyzeVertexCache(indices, 6, 4);
+
+	CHECK(statistics.vertexTransformCount == 4);
+	CHECK(statistics.acmr == 2.0f);
+	CHECK(statistics.atvr == 1.0f);
+
+	//キャッシュが3なら0は追い出されて変換し直すが、16なら残っている
+	uint32_t far[] = { 0, 1, 2, 3, 4, 5, 0, 4, 5 };
+
+	CHECK(AnalyzeVertexCache(far, 9, 6, 3).vertexTransformCount == 7);
+	CHECK(AnalyzeVertexCache(far, 9, 6, 16).vertexTransformCount == 6);
+
+}
+
+TEST_CASE(OptimizeVertexCacheKeepsTrianglesAndWinding) {
+
+	MeshData mesh = MakeShuffledGridMesh(40, 1);
+
+	auto before = MakeTriangleSet(mesh.indices.data(), mesh.indices.size());
+
+	VertexCacheStatistics shuffled = AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+	OptimizeVertexCache(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+	CHECK(MakeTriangleSet(mesh.indices.data(), mesh.indices.size()) == before);
+
+	VertexCacheStatistics optimized = AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+	//混ぜた並びはほぼ毎回外れるが、最適化すれば三角形あたり1頂点程度になる
+	CHECK(optimized.acmr < shuffled.acmr * 0.5f);
+	CHECK(optimized.acmr < 1.0f);
+
+}
+
+TEST_CASE(OptimizeVertexCacheToSeparateDestination) {
+
+	MeshData mesh = MakeShuffledGridMesh(12, 2);
+
+	std::vector<uint32_t> destination(mesh.indices.size());
+
+	std::vector<uint32_t> source = mesh.indices;
+
+	OptimizeVertexCache(destination.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+	CHECK(mesh.indices == source);
+	CHECK(MakeTriangleSet(destination.data(), destination.size()) == MakeTriangleSet(source.data(), source.size()));
+
+}
+
+TEST_CASE(OptimizeOverdrawKeepsTrianglesAndWinding) {
+
+	MeshData mesh = MakeSphereMesh(24);
+
+	OptimizeVertexCache(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+	auto before = MakeTriangleSet(mesh.indices.data(), mesh.indices.size());
+
+	float cacheAcmr = AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size()).acmr;
+
+	float threshold = 1.05f;
+
+	OptimizeOverdraw(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(), &mesh.vertices[0].position.x, mesh.vertices.size(), sizeof(MeshVertex), threshold);
+
+	CHECK(MakeTriangleSet(mesh.indices.data(), mesh.indices.size()) == before);
+
+	//クラスタに分けて悪化するACMRはthresholdまで
+	float overdrawAcmr = AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size()).acmr;
+
+	CHECK(overdrawAcmr <= cacheAcmr * threshold + 1e-4f);
+
+}
+
+TEST_CASE(OptimizeVertexFetchOrdersByFirstUse) {
+
+	MeshData mesh = MakeShuffledGridMesh(30, 3);
+
+	//使われない頂点を足しておく
+	mesh.vertices.push_back({ { 100.0f, 100.0f, 100.0f, 1.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f } });
+
+	auto before = MakePositionTriangleSet(mesh);
+
+	std::vector<MeshVertex> vertices(mesh.vertices.size());
+
+	size_t vertexCount = OptimizeVertexFetch(vertices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size(), sizeof(MeshVertex));
+
+	CHECK(vertexCount == mesh.vertices.size() - 1);
+
+	vertices.resize(vertexCount);
+
+	mesh.vertices = vertices;
+
+	CHECK(MakePositionTriangleSet(mesh) == before);
+
+	//インデックスは初めて使われる順に0から増える
+	uint32_t next = 0;
+
+	for (uint32_t index : mesh.indices) {
+		CHECK(index <= next);
+		if (index == next) {
+			++next;
+		}
+	}
+
+	CHECK(next == vertexCount);
+
+}
+
+TEST_CASE(OptimizeMeshKeepsTrianglesAndWinding) {
+
+	MeshData mesh = MakeSphereMesh(32);
+
+	std::mt19937 random(4);
+
+	//頂点の順も三角形の順も混ぜる
+	std::vector<uint32_t> remap(mesh.vertices.size());
+
+	for (size_t i = 0; i < remap.size(); ++i) {
+		remap[i] = static_cast<uint32_t>(i);
+	}
+
+	std::shuffle(remap.begin(), remap.end(), random);
+
+	std::vector<MeshVertex> vertices(mesh.vertices.size());
+
+	for (size_t i = 0; i < remap.size(); ++i) {
+		vertices[remap[i]] = mesh.vertices[i];
+	}
+
+	mesh.vertices = vertices;
+
+	for (uint32_t& index : mesh.indices) {
+		index = remap[index];
+	}
+
+	auto before = MakePositionTriangleSet(mesh);
+
+	size_t indexCount = mesh.indices.size();
+
+	VertexCacheStatistics shuffled = AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+	OptimizeMesh(mesh);
+
+	CHECK(mesh.indices.size() == indexCount);
+	CHECK(MakePositionTriangleSet(mesh) == before);
+
+	VertexCacheStatistics optimized = AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+	CHECK(optimized.acmr <= shuffled.acmr);
+
+	for (uint32_t index : mesh.indices) {
+		CHECK(index < mesh.vertices.size());
+	}
+
+}
+
+TEST_CASE(OptimizerHandlesTinyInputs) {
+
+	OptimizeVertexCache(nullptr, nullptr, 0, 0);
+
+	uint32_t triangle[] = { 0, 1, 2 };
+
+	OptimizeVertexCache(triangle, triangle, 3, 3);
+
+	CHECK(MakeTriangleSet(triangle, 3) == MakeTriangleSet(std::array<uint32_t, 3>{ 0, 1, 2 }.data(), 3));
+
+	//使われているのが後ろの頂点だけでも0から振り直す
+	uint32_t indices[] = { 5, 6, 7 };
+
+	MeshVertex vertices[8] = {};
+
+	MeshVertex destination[8];
+
+	CHECK(OptimizeVertexFetch(destination, indices, 3, vertices, 8, sizeof(MeshVertex)) == 3);
+	CHECK(indices[0] == 0);
+	CHECK(indices[1] == 1);
+	CHECK(indices[2] == 2);
+
+}
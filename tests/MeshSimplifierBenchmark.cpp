@@ -0,0 +1,150 @@
+#include "Benchmark.h"
+#include "TestMeshes.h"
+#include "MeshSimplifier.h"
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <vector>
+
+//メッシュの簡略化の速さと誤差を測る(本来の大きさは100万三角形の球と50万三角形の格子)
+//球は穴が開かないこと、縁を固定した格子は縁が全て残ることも確かめる
+
+namespace {
+
+	//三角形の重心が単位球の内側へ入る量の最大(球の頂点だけを使うので形の崩れになる)
+	float MeasureSphereDeviation(const MeshData& sphere, const uint32_t* indices, size_t indexCount) {
+
+		float maxDeviation = 0.0f;
+
+		for (size_t i = 0; i < indexCount; i += 3) {
+
+			const Vector4& p0 = sphere.vertices[indices[i]].position;
+			const Vector4& p1 = sphere.vertices[indices[i + 1]].position;
+			const Vector4& p2 = sphere.vertices[indices[i + 2]].position;
+
+			float x = (p0.x + p1.x + p2.x) / 3.0f;
+			float y = (p0.y + p1.y + p2.y) / 3.0f;
+			float z = (p0.z + p1.z + p2.z) / 3.0f;
+
+			maxDeviation = (std::max)(maxDeviation, 1.0f - std::sqrt(x * x + y * y + z * z));
+
+		}
+
+		return maxDeviation;
+
+	}
+
+	MeshData MakeWavyGridMesh(uint32_t size) {
+
+		MeshData mesh = MakeGridMesh(size);
+
+		for (auto& vertex : mesh.vertices) {
+			vertex.position.y = std::sin(vertex.position.x * 0.05f) * std::cos(vertex.position.z * 0.04f) * 4.0f;
+		}
+
+		mesh.bounds.min.y = -4.0f;
+		mesh.bounds.max.y = 4.0f;
+
+		return mesh;
+
+	}
+
+}
+
+int main(int argc, char** argv) {
+
+	bool isQuick = IsQuickBenchmark(argc, argv);
+
+	//1024x512の球は約100万三角形
+	uint32_t sphereSegments = isQuick ? 128 : 1024;
+
+	uint32_t gridSize = isQuick ? 40 : 500;
+
+	MeshData sphere = MakeClosedSphereMesh(sphereSegments, sphereSegments / 2);
+
+	MeshData grid = MakeWavyGridMesh(gridSize);
+
+	int result = 0;
+
+	std::printf("sphere %zu triangles\n", sphere.indices.size() / 3);
+	std::printf("  %-8s %10s %10s %12s %10s %10s\n", "ratio", "triangles", "ms", "Mtri/s", "error", "deviation");
+
+	std::vector<uint32_t> indices(sphere.indices.size());
+
+	for (float ratio : { 0.5f, 0.1f, 0.02f }) {
+
+		size_t targetIndexCount = static_cast<size_t>(sphere.indices.size() / 3 * ratio) * 3;
+
+		float error = 0.0f;
+
+		BenchmarkTimer timer;
+
+		size_t indexCount = SimplifyMesh(indices.data(), sphere.indices.data(), sphere.indices.size(), sphere.vertices.data(), sphere.vertices.size(), targetIndexCount, 1.0f, {}, &error);
+
+		double milliseconds = timer.GetMilliseconds();
+
+		float deviation = MeasureSphereDeviation(sphere, indices.data(), indexCount);
+
+		std::printf("  %-8.2f %10zu %10.1f %12.2f %10.5f %10.5f\n", ratio, indexCount / 3, milliseconds, sphere.indices.size() / 3 / milliseconds / 1000.0, error, deviation);
+
+		MeshEdgeCounts counts = CountMeshEdges(sphere.vertices, indices.data(), indexCount);
+
+		//目標まで減らせない時は形を保てるところで止まるが、穴は開けない
+		if (indexCount == 0 || counts.openEdgeCount > 0 || counts.nonManifoldEdgeCount > 0) {
+			std::printf("  ratio %.2f: not closed (%zu open, %zu non-manifold edges)\n", ratio, counts.openEdgeCount, counts.nonManifoldEdgeCount);
+			result = 1;
+		}
+
+	}
+
+	//LODの段を全て作る
+	MeshData lodSphere = sphere;
+
+	BenchmarkTimer lodTimer;
+
+	GenerateMeshLods(lodSphere);
+
+	std::printf("  lod chain %.1f ms:", lodTimer.GetMilliseconds());
+
+	for (const MeshLod& lod : lodSphere.lods) {
+		std::printf(" %u(%.4f)", lod.indexCount / 3, lod.error);
+	}
+
+	std::printf("\n");
+
+	//縁を固定した格子を1割まで減らす
+	std::printf("grid %zu triangles, locked border\n", grid.indices.size() / 3);
+
+	std::vector<uint32_t> gridIndices(grid.indices.size());
+
+	size_t gridTargetIndexCount = grid.indices.size() / 3 / 10 * 3;
+
+	float gridError = 0.0f;
+
+	BenchmarkTimer gridTimer;
+
+	size_t gridIndexCount = SimplifyMesh(gridIndices.data(), grid.indices.data(), grid.indices.size(), grid.vertices.data(), grid.vertices.size(), gridTargetIndexCount, 100.0f, {}, &gridError);
+
+	double gridMilliseconds = gridTimer.GetMilliseconds();
+
+	std::set<uint32_t> usedVertices(gridIndices.begin(), gridIndices.begin() + gridIndexCount);
+
+	size_t borderVertexCount = 0;
+
+	for (uint32_t vertex : usedVertices) {
+		const Vector4& position = grid.vertices[vertex].position;
+		if (position.x == 0.0f || position.z == 0.0f || position.x == float(gridSize) || position.z == float(gridSize)) {
+			borderVertexCount++;
+		}
+	}
+
+	std::printf("  %-8.2f %10zu %10.1f %12.2f %10.5f  border %zu/%u\n", 0.1f, gridIndexCount / 3, gridMilliseconds, grid.indices.size() / 3 / gridMilliseconds / 1000.0, gridError, borderVertexCount, gridSize * 4);
+
+	if (borderVertexCount != gridSize * 4) {
+		std::printf("  locked border vertices were removed\n");
+		result = 1;
+	}
+
+	return result;
+
+}
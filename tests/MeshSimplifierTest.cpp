@@ -0,0 +1,253 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "MeshSimplifier.h"
+#include <cmath>
+#include <set>
+#include <vector>
+
+namespace {
+
+	//起伏のある格子(縁が開いている)
+	MeshData MakeWavyGridMesh(uint32_t size) {
+
+		MeshData mesh = MakeGridMesh(size);
+
+		for (auto& vertex : mesh.vertices) {
+			vertex.position.y = std::sin(vertex.position.x * 0.3f) * std::cos(vertex.position.z * 0.25f);
+		}
+
+		mesh.bounds.min.y = -1.0f;
+		mesh.bounds.max.y = 1.0f;
+
+		return mesh;
+
+	}
+
+	bool IsBorderVertex(const MeshVertex& vertex, uint32_t size) {
+		float x = vertex.position.x;
+		float z = vertex.position.z;
+		return x == 0.0f || z == 0.0f || x == float(size) || z == float(size);
+	}
+
+	std::vector<uint32_t> Simplify(const MeshData& mesh, size_t targetIndexCount, float targetError, const MeshSimplifySettings& settings, float* resultError) {
+
+		std::vector<uint32_t> indices(mesh.indices.size());
+
+		size_t indexCount = SimplifyMesh(indices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size(), targetIndexCount, targetError, settings, resultError);
+
+		indices.resize(indexCount);
+
+		return indices;
+
+	}
+
+	Vector3 GetPosition(const MeshData& mesh, uint32_t index) {
+		const Vector4& position = mesh.vertices[index].position;
+		return { position.x, position.y, position.z };
+	}
+
+}
+
+TEST_CASE(SimplifiedSphereStaysClosedAndNearSurface) {
+
+	MeshData sphere = MakeClosedSphereMesh(128, 64);
+
+	MeshEdgeCounts original = CountMeshEdges(sphere.vertices, sphere.indices.data(), sphere.indices.size());
+
+	REQUIRE(original.openEdgeCount == 0);
+	REQUIRE(original.nonManifoldEdgeCount == 0);
+
+	size_t targetIndexCount = sphere.indices.size() / 3 / 10 * 3;
+
+	float error = 0.0f;
+
+	std::vector<uint32_t> indices = Simplify(sphere, targetIndexCount, 1.0f, {}, &error);
+
+	CHECK(!indices.empty());
+	CHECK(indices.size() <= targetIndexCount);
+	CHECK(indices.size() % 3 == 0);
+
+	//穴も、3枚以上の三角形が集まる辺もできない
+	MeshEdgeCounts simplified = CountMeshEdges(sphere.vertices, indices.data(), indices.size());
+
+	CHECK(simplified.openEdgeCount == 0);
+	CHECK(simplified.nonManifoldEdgeCount == 0);
+
+	//誤差は法線とUVのずれも含む。頂点は球の上のものを使うので、形の崩れは三角形の重心が内側へ入る量で測る
+	CHECK(error > 0.0f);
+	CHECK(error < 0.1f);
+
+	float maxDeviation = 0.0f;
+
+	size_t inwardCount = 0;
+
+	for (size_t i = 0; i < indices.size(); i += 3) {
+
+		Vector3 p0 = GetPosition(sphere, indices[i]);
+		Vector3 p1 = GetPosition(sphere, indices[i + 1]);
+		Vector3 p2 = GetPosition(sphere, indices[i + 2]);
+
+		Vector3 centroid = { (p0.x + p1.x + p2.x) / 3.0f, (p0.y + p1.y + p2.y) / 3.0f, (p0.z + p1.z + p2.z) / 3.0f };
+
+		maxDeviation = (std::max)(maxDeviation, 1.0f - std::sqrt(centroid.x * centroid.x + centroid.y * centroid.y + centroid.z * centroid.z));
+
+		//裏返った三角形がないか(外から見て時計回りなので、e1 x e2は外を向く)
+		Vector3 edge1 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+		Vector3 edge2 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+		Vector3 normal = { edge1.y * edge2.z - edge1.z * edge2.y, edge1.z * edge2.x - edge1.x * edge2.z, edge1.x * edge2.y - edge1.y * edge2.x };
+
+		if (normal.x * centroid.x + normal.y * centroid.y + normal.z * centroid.z < 0.0f) {
+			inwardCount++;
+		}
+
+	}
+
+	CHECK(maxDeviation < 0.03f);
+	CHECK(inwardCount == 0);
+
+}
+
+TEST_CASE(LockedBorderKeepsBorderEdges) {
+
+	const uint32_t kSize = 40;
+
+	MeshData grid = MakeWavyGridMesh(kSize);
+
+	size_t targetIndexCount = grid.indices.size() / 3 / 20 * 3;
+
+	MeshEdgeCounts original = CountMeshEdges(grid.vertices, grid.indices.data(), grid.indices.size());
+
+	CHECK(original.openEdgeCount == kSize * 4);
+
+	for (uint32_t flags : { uint32_t(kMeshSimplifyLockBorder), uint32_t(kMeshSimplifyNone) }) {
+
+		MeshSimplifySettings settings;
+		settings.flags = flags;
+
+		std::vector<uint32_t> indices = Simplify(grid, targetIndexCount, 100.0f, settings, nullptr);
+
+		CHECK(!indices.empty());
+
+		std::set<uint32_t> usedVertices(indices.begin(), indices.end());
+
+		size_t borderVertexCount = 0;
+
+		for (uint32_t vertex : usedVertices) {
+			if (IsBorderVertex(grid.vertices[vertex], kSize)) {
+				borderVertexCount++;
+			}
+		}
+
+		MeshEdgeCounts simplified = CountMeshEdges(grid.vertices, indices.data(), indices.size());
+
+		CHECK(simplified.nonManifoldEdgeCount == 0);
+
+		if (flags & kMeshSimplifyLockBorder) {
+
+			//縁の頂点と辺は全て残るので、隣のメッシュとの間に隙間ができない
+			CHECK(borderVertexCount == kSize * 4);
+			CHECK(simplified.openEdgeCount == kSize * 4);
+
+			//内側は減っている
+			CHECK(indices.size() < grid.indices.size() / 4);
+
+		} else {
+
+			//固定しなければ縁も減らせる(目標まで減らすには縁を動かす必要がある)
+			CHECK(borderVertexCount < kSize * 4);
+			CHECK(indices.size() <= targetIndexCount);
+
+		}
+
+	}
+
+}
+
+TEST_CASE(SimplifyStopsAtTargetError) {
+
+	MeshData sphere = MakeClosedSphereMesh(48, 24);
+
+	//誤差を許さなければ減らない
+	float error = 1.0f;
+
+	std::vector<uint32_t> indices = Simplify(sphere, 0, 0.0f, {}, &error);
+
+	CHECK(indices.size() == sphere.indices.size());
+	CHECK(error == 0.0f);
+
+	//許す誤差を大きくするほど三角形が少なく、誤差は許した値を超えない
+	size_t previousCount = indices.size();
+
+	for (float targetError : { 0.01f, 0.02f, 0.05f }) {
+
+		indices = Simplify(sphere, 0, targetError, {}, &error);
+
+		CHECK(indices.size() < previousCount);
+		CHECK(error <= targetError);
+
+		previousCount = indices.size();
+
+	}
+
+	//destinationは元のインデックスと同じでもよい
+	std::vector<uint32_t> inPlace = sphere.indices;
+
+	size_t inPlaceCount = SimplifyMesh(inPlace.data(), inPlace.data(), inPlace.size(), sphere.vertices.data(), sphere.vertices.size(), 0, 0.05f, {}, nullptr);
+
+	CHECK(std::vector<uint32_t>(inPlace.begin(), inPlace.begin() + inPlaceCount) == indices);
+
+}
+
+TEST_CASE(LodChainCoarsensAndSelectsByDistance) {
+
+	MeshData sphere = MakeClosedSphereMesh(64, 32);
+
+	size_t originalIndexCount = sphere.indices.size();
+
+	GenerateMeshLods(sphere);
+
+	REQUIRE(sphere.lods.size() >= 3);
+
+	CHECK(sphere.lods[0].indexOffset == 0);
+	CHECK(sphere.lods[0].indexCount == originalIndexCount);
+	CHECK(sphere.lods[0].error == 0.0f);
+
+	for (size_t lod = 1; lod < sphere.lods.size(); ++lod) {
+
+		const MeshLod& previous = sphere.lods[lod - 1];
+		const MeshLod& current = sphere.lods[lod];
+
+		//段は後ろに続けて足され、粗くなるほど三角形が少なく誤差が大きい
+		CHECK(current.indexOffset == previous.indexOffset + previous.indexCount);
+		CHECK(current.indexCount < previous.indexCount);
+		CHECK(current.error >= previous.error);
+
+		MeshEdgeCounts counts = CountMeshEdges(sphere.vertices, sphere.indices.data() + current.indexOffset, current.indexCount);
+
+		CHECK(counts.openEdgeCount == 0);
+
+	}
+
+	CHECK(sphere.lods.back().indexOffset + sphere.lods.back().indexCount == sphere.indices.size());
+
+	//遠いほど粗い段を選ぶ
+	Matrix4x4 projection = MakeTestPerspectiveMatrix(0.45f, 16.0f / 9.0f, 0.1f, 1000.0f);
+
+	LodSelection selection = MakeLodSelection(projection, 720.0f, 1.0f);
+
+	CHECK(SelectMeshLod(sphere.lods.data(), sphere.lods.size(), 1.0f, 1.0f, 0.5f, selection) == 0);
+
+	uint32_t previousLod = 0;
+
+	for (float viewDepth : { 2.0f, 10.0f, 50.0f, 200.0f, 1000.0f }) {
+		uint32_t lod = SelectMeshLod(sphere.lods.data(), sphere.lods.size(), 1.0f, 1.0f, viewDepth, selection);
+		CHECK(lod >= previousLod);
+		previousLod = lod;
+	}
+
+	CHECK(previousLod == sphere.lods.size() - 1);
+
+	//大きく置けば近い段になる
+	CHECK(SelectMeshLod(sphere.lods.data(), sphere.lods.size(), 10.0f, 1.0f, 200.0f, selection) < SelectMeshLod(sphere.lods.data(), sphere.lods.size(), 1.0f, 1.0f, 200.0f, selection));
+
+}
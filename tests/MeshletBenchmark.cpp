@@ -0,0 +1,260 @@
+#include "Benchmark.h"
+#include "TestMeshes.h"
+#include "Meshlet.h"
+#include "OcclusionCulling.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+//メッシュレットの構築とCPUでのカリングの速さを測る(本来の大きさは約100万三角形の球を並べた場面)
+//並列のカリングが1スレッドと一致すること、円錐の判定が表を向いた三角形を捨てないことも確かめる
+
+namespace {
+
+	//球を格子状に並べた1つのメッシュ(手前の球が奥の球を隠す)
+	MeshData MakeSphereField(uint32_t segments, uint32_t countPerSide) {
+
+		MeshData sphere = MakeClosedSphereMesh(segments, segments / 2);
+
+		MeshData mesh;
+
+		for (uint32_t z = 0; z < countPerSide; ++z) {
+			for (uint32_t x = 0; x < countPerSide; ++x) {
+
+				uint32_t baseVertex = static_cast<uint32_t>(mesh.vertices.size());
+
+				for (MeshVertex vertex : sphere.vertices) {
+					vertex.position.x += x * 3.0f;
+					vertex.position.z += z * 3.0f;
+					mesh.vertices.push_back(vertex);
+				}
+
+				for (uint32_t index : sphere.indices) {
+					mesh.indices.push_back(baseVertex + index);
+				}
+
+			}
+		}
+
+		float size = (countPerSide - 1) * 3.0f;
+
+		mesh.bounds.min = { -1.0f, -1.0f, -1.0f };
+		mesh.bounds.max = { size + 1.0f, 1.0f, size + 1.0f };
+
+		return mesh;
+
+	}
+
+	struct BenchmarkView {
+
+		Vector3 cameraPosition;
+		Matrix4x4 viewProjectionMatrix;
+
+	};
+
+	//場面の周りを回りながら、低い位置から中央を見る
+	std::vector<BenchmarkView> MakeViews(const MeshData& mesh, int viewCount) {
+
+		std::vector<BenchmarkView> views;
+
+		Vector3 center = { (mesh.bounds.min.x + mesh.bounds.max.x) * 0.5f, 0.0f, (mesh.bounds.min.z + mesh.bounds.max.z) * 0.5f };
+
+		float radius = (mesh.bounds.max.x - mesh.bounds.min.x) * 0.6f;
+
+		Matrix4x4 projection = MakeTestPerspectiveMatrix(0.8f, 16.0f / 9.0f, 0.1f, 1000.0f);
+
+		for (int i = 0; i < viewCount; ++i) {
+
+			float angle = 6.2831853f * i / viewCount;
+
+			Vector3 eye = { center.x + std::cos(angle) * radius, 1.5f + (i % 3), center.z + std::sin(angle) * radius };
+
+			views.push_back({ eye, MultiplyMatrix(MakeTestLookAtMatrix(eye, center), projection) });
+
+		}
+
+		return views;
+
+	}
+
+	bool IsFrontFacing(const MeshData& mesh, const uint32_t* triangle, const Vector3& cameraPosition) {
+
+		const Vector4& p0 = mesh.vertices[triangle[0]].position;
+		const Vector4& p1 = mesh.vertices[triangle[1]].position;
+		const Vector4& p2 = mesh.vertices[triangle[2]].position;
+
+		float e1x = p1.x - p0.x, e1y = p1.y - p0.y, e1z = p1.z - p0.z;
+		float e2x = p2.x - p0.x, e2y = p2.y - p0.y, e2z = p2.z - p0.z;
+
+		float nx = e1y * e2z - e1z * e2y;
+		float ny = e1z * e2x - e1x * e2z;
+		float nz = e1x * e2y - e1y * e2x;
+
+		return nx * (cameraPosition.x - p0.x) + ny * (cameraPosition.y - p0.y) + nz * (cameraPosition.z - p0.z) > 0.0f;
+
+	}
+
+}
+
+int main(int argc, char** argv) {
+
+	bool isQuick = IsQuickBenchmark(argc, argv);
+
+	//128x64の球(約1.6万三角形)を8x8個並べると約100万三角形
+	MeshData mesh = isQuick ? MakeSphereField(64, 2) : MakeSphereField(128, 8);
+
+	int repeatCount = isQuick ? 1 : 5;
+
+	int viewCount = isQuick ? 4 : 16;
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	std::printf("%zu triangles, %zu vertices, %u threads\n", mesh.indices.size() / 3, mesh.vertices.size(), jobSystem.GetThreadCount());
+
+	//構築(毎回元のメッシュから)
+	MeshData built;
+
+	double buildMilliseconds = MeasureBestMilliseconds(isQuick ? 1 : 3, [&]() {
+		built = mesh;
+		BuildMeshlets(built);
+	});
+
+	mesh = std::move(built);
+
+	size_t meshletCount = mesh.meshlets.size();
+
+	size_t cullableConeCount = 0;
+
+	for (const Meshlet& meshlet : mesh.meshlets) {
+		if (meshlet.coneCutoff < 1.0f) {
+			cullableConeCount++;
+		}
+	}
+
+	std::printf("  build %.1f ms (%.2f Mtri/s), %zu meshlets, %.1f vertices / %.1f triangles per meshlet, %.1f%% with a cone\n",
+		buildMilliseconds, mesh.indices.size() / 3 / buildMilliseconds / 1000.0, meshletCount,
+		double(mesh.meshletVertices.size()) / meshletCount, double(mesh.indices.size() / 3) / meshletCount, 100.0 * cullableConeCount / meshletCount);
+
+	std::vector<Vector4> positions;
+
+	for (const MeshVertex& vertex : mesh.vertices) {
+		positions.push_back(vertex.position);
+	}
+
+	OcclusionBuffer occlusionBuffer;
+	occlusionBuffer.Initialize(320, 180);
+
+	std::vector<uint32_t> single(meshletCount);
+	std::vector<uint32_t> parallel(meshletCount);
+
+	std::vector<MeshletDrawRange> ranges(meshletCount);
+
+	double singleMilliseconds = 0.0;
+	double parallelMilliseconds = 0.0;
+	double occluderMilliseconds = 0.0;
+
+	MeshletCullStatistics total{};
+
+	size_t totalVisibleCount = 0;
+	size_t totalRangeCount = 0;
+
+	size_t mismatchCount = 0;
+	size_t frontFacingCulledCount = 0;
+
+	for (const BenchmarkView& view : MakeViews(mesh, viewCount)) {
+
+		//メッシュ自身を遮蔽物として描く(本来は大きな遮蔽物だけを描くので、描画の時間は参考値)
+		BenchmarkTimer occluderTimer;
+
+		occlusionBuffer.Clear();
+		occlusionBuffer.RenderOccluder(positions.data(), mesh.indices.data(), mesh.indices.size(), view.viewProjectionMatrix);
+		occlusionBuffer.BuildHierarchy();
+
+		occluderMilliseconds += occluderTimer.GetMilliseconds();
+
+		MeshletCullParameters parameters = MakeMeshletCullParameters(view.viewProjectionMatrix, view.cameraPosition, &occlusionBuffer);
+
+		MeshletCullStatistics statistics{};
+
+		size_t singleCount = 0;
+
+		singleMilliseconds += MeasureBestMilliseconds(repeatCount, [&]() {
+			statistics = {};
+			singleCount = CullMeshlets(mesh.meshlets.data(), meshletCount, parameters, single.data(), nullptr, &statistics);
+		});
+
+		size_t parallelCount = 0;
+
+		parallelMilliseconds += MeasureBestMilliseconds(repeatCount, [&]() {
+			parallelCount = CullMeshlets(mesh.meshlets.data(), meshletCount, parameters, parallel.data(), &jobSystem);
+		});
+
+		if (singleCount != parallelCount || !std::equal(single.begin(), single.begin() + singleCount, parallel.begin())) {
+			mismatchCount++;
+		}
+
+		total.frustumCulledCount += statistics.frustumCulledCount;
+		total.backfaceCulledCount += statistics.backfaceCulledCount;
+		total.occlusionCulledCount += statistics.occlusionCulledCount;
+
+		totalVisibleCount += singleCount;
+
+		totalRangeCount += MakeMeshletDrawRanges(mesh.meshlets.data(), single.data(), singleCount, 0, ranges.data());
+
+		//円錐の判定だけで捨てたものに、表を向いた三角形が入っていないか
+		MeshletCullParameters backfaceParameters = MakeMeshletCullParameters(view.viewProjectionMatrix, view.cameraPosition, nullptr, kMeshletCullBackface);
+
+		size_t backfaceVisibleCount = CullMeshlets(mesh.meshlets.data(), meshletCount, backfaceParameters, single.data(), &jobSystem);
+
+		std::vector<bool> isVisible(meshletCount, false);
+
+		for (size_t i = 0; i < backfaceVisibleCount; ++i) {
+			isVisible[single[i]] = true;
+		}
+
+		for (size_t i = 0; i < meshletCount; ++i) {
+
+			if (isVisible[i]) {
+				continue;
+			}
+
+			const Meshlet& meshlet = mesh.meshlets[i];
+
+			for (uint32_t triangle = meshlet.triangleOffset; triangle < meshlet.triangleOffset + meshlet.triangleCount; ++triangle) {
+				if (IsFrontFacing(mesh, &mesh.indices[triangle * 3], view.cameraPosition)) {
+					frontFacingCulledCount++;
+				}
+			}
+
+		}
+
+	}
+
+	double totalCount = double(meshletCount) * viewCount;
+
+	std::printf("  cull per view: single %.3f ms, jobs %.3f ms (occluder raster %.2f ms)\n",
+		singleMilliseconds / viewCount, parallelMilliseconds / viewCount, occluderMilliseconds / viewCount);
+	std::printf("  culled: frustum %.1f%%, backface %.1f%%, occlusion %.1f%%, visible %.1f%% in %.1f draw ranges per view\n",
+		100.0 * total.frustumCulledCount / totalCount, 100.0 * total.backfaceCulledCount / totalCount, 100.0 * total.occlusionCulledCount / totalCount,
+		100.0 * totalVisibleCount / totalCount, double(totalRangeCount) / viewCount);
+
+	int result = 0;
+
+	if (mismatchCount > 0) {
+		std::printf("%zu views differ between jobs and a single thread\n", mismatchCount);
+		result = 1;
+	}
+
+	if (frontFacingCulledCount > 0) {
+		std::printf("%zu front-facing triangles were culled by the cone test\n", frontFacingCulledCount);
+		result = 1;
+	}
+
+	jobSystem.Finalize();
+
+	return result;
+
+}
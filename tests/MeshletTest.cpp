@@ -0,0 +1,419 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "Meshlet.h"
+#include "MeshSimplifier.h"
+#include "OcclusionCulling.h"
+#include "JobSystem.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+	//起伏のある格子(向きの違う面が混ざるので、円錐が開いたメッシュレットもできる)
+	MeshData MakeWavyGridMesh(uint32_t size) {
+
+		MeshData mesh = MakeGridMesh(size);
+
+		for (auto& vertex : mesh.vertices) {
+			vertex.position.y = std::sin(vertex.position.x * 0.4f) * std::cos(vertex.position.z * 0.3f) * 3.0f;
+		}
+
+		mesh.bounds.min.y = -3.0f;
+		mesh.bounds.max.y = 3.0f;
+
+		return mesh;
+
+	}
+
+	std::vector<Vector4> GetPositions(const MeshData& mesh) {
+
+		std::vector<Vector4> positions;
+
+		for (const auto& vertex : mesh.vertices) {
+			positions.push_back(vertex.position);
+		}
+
+		return positions;
+
+	}
+
+	//表(左手系で時計回り)がカメラを向いているか
+	bool IsFrontFacing(const MeshData& mesh, const uint32_t* triangle, const Vector3& cameraPosition) {
+
+		const Vector4& p0 = mesh.vertices[triangle[0]].position;
+		const Vector4& p1 = mesh.vertices[triangle[1]].position;
+		const Vector4& p2 = mesh.vertices[triangle[2]].position;
+
+		Vector3 edge1 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+		Vector3 edge2 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+		Vector3 normal = { edge1.y * edge2.z - edge1.z * edge2.y, edge1.z * edge2.x - edge1.x * edge2.z, edge1.x * edge2.y - edge1.y * edge2.x };
+
+		return normal.x * (cameraPosition.x - p0.x) + normal.y * (cameraPosition.y - p0.y) + normal.z * (cameraPosition.z - p0.z) > 0.0f;
+
+	}
+
+	//centerの周りでdistanceだけ離れたランダムな位置からcenterを見る
+	struct TestView {
+
+		Vector3 cameraPosition;
+		Matrix4x4 viewProjectionMatrix;
+
+	};
+
+	TestView MakeRandomView(std::mt19937& random, const Vector3& center, float distance) {
+
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		Vector3 direction;
+		float length = 0.0f;
+
+		do {
+			direction = { unit(random), unit(random), unit(random) };
+			length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+		} while (length < 0.1f || length > 1.0f || std::fabs(direction.y) > 0.95f * length);
+
+		Vector3 eye = { center.x + direction.x / length * distance, center.y + direction.y / length * distance, center.z + direction.z / length * distance };
+
+		Matrix4x4 view = MakeTestLookAtMatrix(eye, center);
+
+		return { eye, MultiplyMatrix(view, MakeTestPerspectiveMatrix(0.8f, 16.0f / 9.0f, 0.1f, 1000.0f)) };
+
+	}
+
+}
+
+TEST_CASE(MeshletsCoverEveryTriangleWithinLimits) {
+
+	MeshData meshes[] = { MakeSphereMesh(48), MakeWavyGridMesh(60) };
+
+	for (MeshData& mesh : meshes) {
+
+		//LODの段を足してからでも、並べ替えるのはLOD0だけで段の範囲は変わらない
+		GenerateMeshLods(mesh);
+
+		std::vector<MeshLod> lods = mesh.lods;
+
+		std::vector<uint32_t> coarseIndices(mesh.indices.begin() + lods[0].indexCount, mesh.indices.end());
+
+		auto originalTriangles = MakeTriangleSet(mesh.indices.data(), lods[0].indexCount);
+
+		BuildMeshlets(mesh);
+
+		REQUIRE(!mesh.meshlets.empty());
+
+		CHECK(mesh.lods.size() == lods.size());
+		CHECK(std::vector<uint32_t>(mesh.indices.begin() + lods[0].indexCount, mesh.indices.end()) == coarseIndices);
+		CHECK(MakeTriangleSet(mesh.indices.data(), lods[0].indexCount) == originalTriangles);
+
+		uint32_t triangleOffset = 0;
+
+		size_t outsideCount = 0;
+
+		size_t decodeMismatchCount = 0;
+
+		for (const Meshlet& meshlet : mesh.meshlets) {
+
+			CHECK(meshlet.vertexCount <= kMaxMeshletVertices);
+			CHECK(meshlet.triangleCount > 0);
+			CHECK(meshlet.triangleCount <= kMaxMeshletTriangles);
+
+			//メッシュレットの順にLOD0のインデックスが並ぶ
+			CHECK(meshlet.triangleOffset == triangleOffset);
+
+			triangleOffset += meshlet.triangleCount;
+
+			for (uint32_t triangle = 0; triangle < meshlet.triangleCount; ++triangle) {
+
+				uint32_t packed = mesh.meshletTriangles[meshlet.triangleOffset + triangle];
+
+				for (uint32_t corner = 0; corner < 3; ++corner) {
+
+					uint32_t localIndex = (packed >> (corner * 8)) & 0xff;
+
+					if (localIndex >= meshlet.vertexCount) {
+						decodeMismatchCount++;
+						continue;
+					}
+
+					uint32_t vertex = mesh.meshletVertices[meshlet.vertexOffset + localIndex];
+
+					if (vertex != mesh.indices[(meshlet.triangleOffset + triangle) * 3 + corner]) {
+						decodeMismatchCount++;
+					}
+
+					const Vector4& position = mesh.vertices[vertex].position;
+
+					float dx = position.x - meshlet.center.x;
+					float dy = position.y - meshlet.center.y;
+					float dz = position.z - meshlet.center.z;
+
+					if (std::sqrt(dx * dx + dy * dy + dz * dz) > meshlet.radius * 1.0001f + 1e-6f) {
+						outsideCount++;
+					}
+
+				}
+
+			}
+
+		}
+
+		CHECK(triangleOffset == lods[0].indexCount / 3);
+		CHECK(decodeMismatchCount == 0);
+		CHECK(outsideCount == 0);
+
+	}
+
+}
+
+TEST_CASE(ConeCullNeverRemovesFrontFacingTriangles) {
+
+	MeshData meshes[] = { MakeSphereMesh(48), MakeWavyGridMesh(60) };
+
+	std::mt19937 random(46);
+
+	for (MeshData& mesh : meshes) {
+
+		BuildMeshlets(mesh);
+
+		Vector3 center = {
+			(mesh.bounds.min.x + mesh.bounds.max.x) * 0.5f,
+			(mesh.bounds.min.y + mesh.bounds.max.y) * 0.5f,
+			(mesh.bounds.min.z + mesh.bounds.max.z) * 0.5f,
+		};
+
+		float size = mesh.bounds.max.x - mesh.bounds.min.x;
+
+		std::vector<uint32_t> visibleIndices(mesh.meshlets.size());
+
+		size_t frontFacingCulledCount = 0;
+
+		size_t backfaceCulledCount = 0;
+
+		//近いものから遠いものまで、カメラが中にある場合も含める
+		for (int i = 0; i < 200; ++i) {
+
+			float distance = size * (0.05f + 0.05f * (i % 40));
+
+			TestView view = MakeRandomView(random, center, distance);
+
+			MeshletCullParameters parameters = MakeMeshletCullParameters(view.viewProjectionMatrix, view.cameraPosition, nullptr, kMeshletCullBackface);
+
+			MeshletCullStatistics statistics{};
+
+			size_t visibleCount = CullMeshlets(mesh.meshlets.data(), mesh.meshlets.size(), parameters, visibleIndices.data(), nullptr, &statistics);
+
+			CHECK(visibleCount + statistics.backfaceCulledCount == mesh.meshlets.size());
+			CHECK(statistics.frustumCulledCount == 0);
+			CHECK(statistics.occlusionCulledCount == 0);
+
+			backfaceCulledCount += statistics.backfaceCulledCount;
+
+			std::vector<bool> isVisible(mesh.meshlets.size(), false);
+
+			for (size_t k = 0; k < visibleCount; ++k) {
+				isVisible[visibleIndices[k]] = true;
+			}
+
+			for (size_t k = 0; k < mesh.meshlets.size(); ++k) {
+
+				if (isVisible[k]) {
+					continue;
+				}
+
+				const Meshlet& meshlet = mesh.meshlets[k];
+
+				for (uint32_t triangle = meshlet.triangleOffset; triangle < meshlet.triangleOffset + meshlet.triangleCount; ++triangle) {
+					if (IsFrontFacing(mesh, &mesh.indices[triangle * 3], view.cameraPosition)) {
+						frontFacingCulledCount++;
+					}
+				}
+
+			}
+
+		}
+
+		CHECK(frontFacingCulledCount == 0);
+
+		//裏を向いたものはちゃんと捨てている
+		CHECK(backfaceCulledCount > 0);
+
+	}
+
+}
+
+TEST_CASE(CullMeshletsCountsEachTestAndMatchesSingleThread) {
+
+	MeshData mesh = MakeWavyGridMesh(200);
+
+	BuildMeshlets(mesh);
+
+	std::vector<Vector4> positions = GetPositions(mesh);
+
+	JobSystem jobSystem;
+	jobSystem.Initialize(3);
+
+	OcclusionBuffer occlusionBuffer;
+	occlusionBuffer.Initialize(320, 180);
+
+	std::mt19937 random(47);
+
+	std::vector<uint32_t> single(mesh.meshlets.size());
+	std::vector<uint32_t> parallel(mesh.meshlets.size());
+
+	MeshletCullStatistics total{};
+
+	for (int i = 0; i < 20; ++i) {
+
+		TestView view = MakeRandomView(random, { 100.0f, 0.0f, 100.0f }, 60.0f + 10.0f * i);
+
+		//メッシュ自身を遮蔽物として描く
+		occlusionBuffer.Clear();
+		occlusionBuffer.RenderOccluder(positions.data(), mesh.indices.data(), mesh.indices.size(), view.viewProjectionMatrix);
+		occlusionBuffer.BuildHierarchy();
+
+		MeshletCullParameters parameters = MakeMeshletCullParameters(view.viewProjectionMatrix, view.cameraPosition, &occlusionBuffer);
+
+		MeshletCullStatistics singleStatistics{};
+		MeshletCullStatistics parallelStatistics{};
+
+		size_t singleCount = CullMeshlets(mesh.meshlets.data(), mesh.meshlets.size(), parameters, single.data(), nullptr, &singleStatistics);
+		size_t parallelCount = CullMeshlets(mesh.meshlets.data(), mesh.meshlets.size(), parameters, parallel.data(), &jobSystem, &parallelStatistics);
+
+		//どれか1つの判定で捨てたものとして数える
+		CHECK(singleCount + singleStatistics.frustumCulledCount + singleStatistics.backfaceCulledCount + singleStatistics.occlusionCulledCount == mesh.meshlets.size());
+
+		REQUIRE(singleCount == parallelCount);
+		CHECK(std::equal(single.begin(), single.begin() + singleCount, parallel.begin()));
+		CHECK(singleStatistics.frustumCulledCount == parallelStatistics.frustumCulledCount);
+		CHECK(singleStatistics.backfaceCulledCount == parallelStatistics.backfaceCulledCount);
+		CHECK(singleStatistics.occlusionCulledCount == parallelStatistics.occlusionCulledCount);
+
+		//見えるものは昇順
+		CHECK(std::is_sorted(single.begin(), single.begin() + singleCount));
+
+		total.frustumCulledCount += singleStatistics.frustumCulledCount;
+		total.backfaceCulledCount += singleStatistics.backfaceCulledCount;
+		total.occlusionCulledCount += singleStatistics.occlusionCulledCount;
+
+	}
+
+	CHECK(total.frustumCulledCount > 0);
+	CHECK(total.backfaceCulledCount > 0);
+
+	//判定をしなければ全て見える
+	MeshletCullParameters none = MakeMeshletCullParameters(MakeTestPerspectiveMatrix(0.8f, 1.0f, 0.1f, 10.0f), { 0.0f, 0.0f, 0.0f }, nullptr, kMeshletCullNone);
+
+	CHECK(CullMeshlets(mesh.meshlets.data(), mesh.meshlets.size(), none, single.data(), &jobSystem) == mesh.meshlets.size());
+	CHECK(CullMeshlets(mesh.meshlets.data(), 0, none, single.data(), &jobSystem) == 0);
+
+	jobSystem.Finalize();
+
+}
+
+TEST_CASE(OcclusionCullsMeshletsBehindWall) {
+
+	MeshData mesh = MakeWavyGridMesh(60);
+
+	BuildMeshlets(mesh);
+
+	Vector3 cameraPosition = { 30.0f, 20.0f, -40.0f };
+
+	Matrix4x4 viewProjection = MultiplyMatrix(MakeTestLookAtMatrix(cameraPosition, { 30.0f, 0.0f, 30.0f }), MakeTestPerspectiveMatrix(0.8f, 16.0f / 9.0f, 0.1f, 1000.0f));
+
+	OcclusionBuffer occlusionBuffer;
+	occlusionBuffer.Initialize(320, 180);
+
+	std::vector<uint32_t> visibleIndices(mesh.meshlets.size());
+
+	MeshletCullParameters parameters = MakeMeshletCullParameters(viewProjection, cameraPosition, &occlusionBuffer, kMeshletCullOcclusion);
+
+	//遮蔽物がなければ何も捨てない
+	occlusionBuffer.Clear();
+	occlusionBuffer.BuildHierarchy();
+
+	CHECK(CullMeshlets(mesh.meshlets.data(), mesh.meshlets.size(), parameters, visibleIndices.data(), nullptr) == mesh.meshlets.size());
+
+	//カメラと格子の間に、格子の左半分を隠す壁を立てる
+	const Vector4 wall[] = {
+		{ -200.0f, -50.0f, -20.0f, 1.0f },
+		{ 30.0f, -50.0f, -20.0f, 1.0f },
+		{ -200.0f, 200.0f, -20.0f, 1.0f },
+		{ 30.0f, 200.0f, -20.0f, 1.0f },
+	};
+
+	const uint32_t wallIndices[] = { 0, 2, 1, 1, 2, 3 };
+
+	occlusionBuffer.Clear();
+	occlusionBuffer.RenderOccluder(wall, wallIndices, 6, viewProjection);
+	occlusionBuffer.BuildHierarchy();
+
+	MeshletCullStatistics statistics{};
+
+	size_t visibleCount = CullMeshlets(mesh.meshlets.data(), mesh.meshlets.size(), parameters, visibleIndices.data(), nullptr, &statistics);
+
+	CHECK(statistics.occlusionCulledCount > 0);
+	CHECK(visibleCount + statistics.occlusionCulledCount == mesh.meshlets.size());
+
+	//隠れたものは壁の側にあり、右半分は残る
+	std::vector<bool> isVisible(mesh.meshlets.size(), false);
+
+	for (size_t i = 0; i < visibleCount; ++i) {
+		isVisible[visibleIndices[i]] = true;
+	}
+
+	size_t rightVisibleCount = 0;
+
+	for (size_t i = 0; i < mesh.meshlets.size(); ++i) {
+
+		const Meshlet& meshlet = mesh.meshlets[i];
+
+		if (!isVisible[i]) {
+			CHECK(meshlet.center.x + meshlet.radius <= 30.5f);
+		} else if (meshlet.center.x - meshlet.radius > 30.0f) {
+			rightVisibleCount++;
+		}
+
+	}
+
+	CHECK(rightVisibleCount > 0);
+
+}
+
+TEST_CASE(DrawRangesMergeContiguousMeshlets) {
+
+	MeshData mesh = MakeWavyGridMesh(40);
+
+	BuildMeshlets(mesh);
+
+	REQUIRE(mesh.meshlets.size() >= 6);
+
+	//0,1,2は続いているので1つに、4と5も1つになる
+	const uint32_t visibleIndices[] = { 0, 1, 2, 4, 5 };
+
+	MeshletDrawRange ranges[5];
+
+	size_t rangeCount = MakeMeshletDrawRanges(mesh.meshlets.data(), visibleIndices, 5, 300, ranges);
+
+	REQUIRE(rangeCount == 2);
+
+	const std::vector<Meshlet>& meshlets = mesh.meshlets;
+
+	CHECK(ranges[0].startIndex == 300);
+	CHECK(ranges[0].indexCount == (meshlets[0].triangleCount + meshlets[1].triangleCount + meshlets[2].triangleCount) * 3);
+	CHECK(ranges[1].startIndex == 300 + meshlets[4].triangleOffset * 3);
+	CHECK(ranges[1].indexCount == (meshlets[4].triangleCount + meshlets[5].triangleCount) * 3);
+
+	//全て見えれば1回で描ける
+	std::vector<uint32_t> all(meshlets.size());
+
+	for (uint32_t i = 0; i < all.size(); ++i) {
+		all[i] = i;
+	}
+
+	std::vector<MeshletDrawRange> allRanges(meshlets.size());
+
+	CHECK(MakeMeshletDrawRanges(meshlets.data(), all.data(), all.size(), 0, allRanges.data()) == 1);
+	CHECK(allRanges[0].indexCount == mesh.indices.size());
+
+}
@@ -0,0 +1,226 @@
+#include "TestFramework.h"
+#include "MipGenerator.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+//SSE2とMIPGENERATOR_NO_SIMDの両方でビルドする。2x2の平均はテストの中で同じ順に計算した値とビット単位で一致させるので、
+//両方のビルドが通れば同じ画素になる(Kaiserも同じ足し算のループを通る)
+
+namespace {
+
+	void FillRandom(TextureData& texture, uint32_t seed) {
+
+		std::mt19937 random(seed);
+
+		for (size_t i = 0; i < texture.mips[0].size; ++i) {
+			texture.pixels[i] = static_cast<uint8_t>(random() & 0xff);
+		}
+
+	}
+
+	//2x2の平均で縮めた全段(縦横は片方ずつ、前の段は丸めずに次の元にする)
+	std::vector<uint8_t> MakeBoxReference(const TextureData& texture) {
+
+		bool isSrgb = IsSrgbFormat(texture.format);
+
+		uint32_t width = texture.width;
+		uint32_t height = texture.height;
+
+		std::vector<float> source(size_t(width) * height * 4);
+
+		for (size_t i = 0; i < source.size(); ++i) {
+			uint8_t value = texture.pixels[i];
+			source[i] = (isSrgb && i % 4 != 3) ? SrgbToLinear(value) : static_cast<float>(value) * (1.0f / 255.0f);
+		}
+
+		std::vector<uint8_t> pixels(texture.pixels.begin(), texture.pixels.begin() + texture.mips[0].size);
+
+		while (width > 1 || height > 1) {
+
+			if (width > 1) {
+
+				std::vector<float> horizontal(size_t(width / 2) * height * 4);
+
+				for (uint32_t y = 0; y < height; ++y) {
+					for (uint32_t x = 0; x < width / 2; ++x) {
+						for (int c = 0; c < 4; ++c) {
+							const float* row = &source[size_t(y) * width * 4];
+							horizontal[(size_t(y) * (width / 2) + x) * 4 + c] = 0.5f * row[(x * 2) * 4 + c] + 0.5f * row[(x * 2 + 1) * 4 + c];
+						}
+					}
+				}
+
+				width /= 2;
+				source.swap(horizontal);
+
+			}
+
+			if (height > 1) {
+
+				std::vector<float> vertical(size_t(width) * (height / 2) * 4);
+
+				for (uint32_t y = 0; y < height / 2; ++y) {
+					for (size_t i = 0; i < size_t(width) * 4; ++i) {
+						vertical[size_t(y) * width * 4 + i] = 0.5f * source[size_t(y * 2) * width * 4 + i] + 0.5f * source[size_t(y * 2 + 1) * width * 4 + i];
+					}
+				}
+
+				height /= 2;
+				source.swap(vertical);
+
+			}
+
+			for (size_t i = 0; i < source.size(); ++i) {
+				if (isSrgb && i % 4 != 3) {
+					pixels.push_back(LinearToSrgb(source[i]));
+				} else {
+					pixels.push_back(static_cast<uint8_t>((std::min)((std::max)(source[i], 0.0f), 1.0f) * 255.0f + 0.5f));
+				}
+			}
+
+		}
+
+		return pixels;
+
+	}
+
+}
+
+TEST_CASE(BoxMipsMatchReferenceBitExact) {
+
+	JobSystem jobSystem;
+	jobSystem.Initialize(3);
+
+	MipSettings settings;
+	settings.filter = MipFilter::kBox;
+
+	//正方形と、先に縦が1になる横長の両方
+	const uint32_t sizes[][2] = { { 64, 64 }, { 256, 8 }, { 4, 32 } };
+
+	for (TextureFormat format : { TextureFormat::kRGBA8, TextureFormat::kRGBA8Srgb }) {
+		for (const auto& size : sizes) {
+
+			TextureData texture;
+			InitializeTexture(texture, format, size[0], size[1], 1);
+
+			FillRandom(texture, size[0] * 31 + size[1]);
+
+			std::vector<uint8_t> reference = MakeBoxReference(texture);
+
+			TextureData parallel = texture;
+
+			REQUIRE(GenerateMips(texture, settings));
+			REQUIRE(GenerateMips(parallel, settings, &jobSystem));
+
+			CHECK(texture.mips.size() == ComputeMipCount(size[0], size[1]));
+			CHECK(texture.pixels == reference);
+			CHECK(parallel.pixels == reference);
+
+		}
+	}
+
+	jobSystem.Finalize();
+
+}
+
+TEST_CASE(SrgbIsAveragedInLinearSpace) {
+
+	//白黒の市松模様は線形で0.5になり、sRGBでは188になる。アルファはそのまま平均して128
+	for (MipFilter filter : { MipFilter::kBox, MipFilter::kKaiser }) {
+
+		TextureData texture;
+		InitializeTexture(texture, TextureFormat::kRGBA8Srgb, 8, 8, 1);
+
+		for (uint32_t i = 0; i < 64; ++i) {
+			uint8_t value = ((i % 8 + i / 8) % 2) ? 255 : 0;
+			std::memset(&texture.pixels[i * 4], value, 4);
+		}
+
+		MipSettings settings;
+		settings.filter = filter;
+
+		REQUIRE(GenerateMips(texture, settings));
+
+		const uint8_t* last = &texture.pixels[texture.mips.back().offset];
+
+		CHECK(last[0] == 188);
+		CHECK(last[1] == 188);
+		CHECK(last[2] == 188);
+		CHECK(last[3] == 128);
+
+	}
+
+	CHECK(LinearToSrgb(0.0f) == 0);
+	CHECK(LinearToSrgb(1.0f) == 255);
+	CHECK(LinearToSrgb(2.0f) == 255);
+
+	for (uint32_t value = 0; value < 256; ++value) {
+		CHECK(LinearToSrgb(SrgbToLinear(static_cast<uint8_t>(value))) == value);
+	}
+
+}
+
+TEST_CASE(KaiserKeepsConstantAndMatchesJobs) {
+
+	JobSystem jobSystem;
+	jobSystem.Initialize(3);
+
+	//奇数や2のべき乗でない大きさでも、一様な色は変わらない(重みの和が1)
+	TextureData constant;
+	InitializeTexture(constant, TextureFormat::kRGBA8Srgb, 13, 5, 1);
+
+	for (size_t i = 0; i < constant.pixels.size(); i += 4) {
+		constant.pixels[i] = 30;
+		constant.pixels[i + 1] = 100;
+		constant.pixels[i + 2] = 200;
+		constant.pixels[i + 3] = 77;
+	}
+
+	REQUIRE(GenerateMips(constant, {}, &jobSystem));
+
+	CHECK(constant.mips.size() == 4);
+
+	bool isConstant = true;
+
+	for (size_t i = 0; i < constant.pixels.size(); i += 4) {
+		isConstant &= constant.pixels[i] == 30 && constant.pixels[i + 1] == 100 && constant.pixels[i + 2] == 200 && constant.pixels[i + 3] == 77;
+	}
+
+	CHECK(isConstant);
+
+	//行を分けても同じ画素になる
+	TextureData single;
+	InitializeTexture(single, TextureFormat::kRGBA8, 300, 200, 1);
+
+	FillRandom(single, 47);
+
+	TextureData parallel = single;
+
+	REQUIRE(GenerateMips(single));
+	REQUIRE(GenerateMips(parallel, {}, &jobSystem));
+
+	CHECK(single.pixels == parallel.pixels);
+
+	//最後の段は全体の平均に近い(乱数なので約127.5)
+	const uint8_t* last = &single.pixels[single.mips.back().offset];
+
+	for (int c = 0; c < 4; ++c) {
+		CHECK(last[c] >= 124 && last[c] <= 131);
+	}
+
+	jobSystem.Finalize();
+
+}
+
+TEST_CASE(GenerateMipsRejectsCompressedFormats) {
+
+	TextureData texture;
+	InitializeTexture(texture, TextureFormat::kBC1, 8, 8, 1);
+
+	CHECK(!GenerateMips(texture));
+	CHECK(texture.mips.size() == 1);
+
+}
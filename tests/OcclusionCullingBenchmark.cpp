@@ -0,0 +1,164 @@
+#include "Benchmark.h"
+#include "TestMeshes.h"
+#include "OcclusionCulling.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//遮蔽カリングの速さを測る(本来の大きさは遮蔽される候補100万個)
+//街のように並べた建物を遮蔽物として描き、階層Zを作ってから、建物の間にばらまいた箱を1スレッドとJobSystemで判定する。結果はIsVisibleと一致させる
+
+namespace {
+
+	//箱の12枚の三角形を足す
+	void AppendBox(const Vector3& center, const Vector3& extent, std::vector<Vector4>& positions, std::vector<uint32_t>& indices) {
+
+		uint32_t base = static_cast<uint32_t>(positions.size());
+
+		for (int corner = 0; corner < 8; ++corner) {
+			positions.push_back({
+				center.x + ((corner & 1) ? extent.x : -extent.x),
+				center.y + ((corner & 2) ? extent.y : -extent.y),
+				center.z + ((corner & 4) ? extent.z : -extent.z),
+				1.0f,
+			});
+		}
+
+		//-x, +x, -y, +y, -z, +zの面
+		const uint32_t faces[6][4] = { { 0, 2, 6, 4 }, { 1, 5, 7, 3 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 6, 7, 5 } };
+
+		for (const auto& face : faces) {
+			uint32_t quad[6] = { face[0], face[1], face[2], face[0], face[2], face[3] };
+			for (uint32_t index : quad) {
+				indices.push_back(base + index);
+			}
+		}
+
+	}
+
+}
+
+int main(int argc, char** argv) {
+
+	bool isQuick = IsQuickBenchmark(argc, argv);
+
+	size_t candidateCount = isQuick ? 50000 : 1000000;
+
+	int repeatCount = isQuick ? 1 : 5;
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	//建物の間の通りから+Zを見る
+	Matrix4x4 view = MakeTestLookAtMatrix({ 0.0f, 2.0f, 0.0f }, { 0.0f, 2.0f, 1.0f });
+
+	Matrix4x4 viewProjection = MultiplyMatrix(view, MakeTestPerspectiveMatrix(0.8f, 16.0f / 9.0f, 0.1f, 400.0f));
+
+	std::mt19937 random(37);
+
+	std::uniform_real_distribution<float> height(4.0f, 30.0f);
+
+	//20mおきの区画に幅14mの建物を建てる
+	std::vector<Vector4> positions;
+	std::vector<uint32_t> indices;
+
+	for (int z = 1; z < 20; ++z) {
+		for (int x = -10; x <= 10; ++x) {
+			if (x == 0) {
+				continue;
+			}
+			float buildingHeight = height(random);
+			AppendBox({ x * 20.0f, buildingHeight * 0.5f, z * 20.0f }, { 7.0f, buildingHeight * 0.5f, 7.0f }, positions, indices);
+		}
+	}
+
+	//遮蔽される候補は建物の高さまでの小さな箱
+	std::uniform_real_distribution<float> positionX(-200.0f, 200.0f);
+	std::uniform_real_distribution<float> positionY(0.5f, 20.0f);
+	std::uniform_real_distribution<float> positionZ(5.0f, 390.0f);
+
+	AABBArray aabbs;
+	aabbs.Resize(candidateCount);
+
+	std::vector<Vector3> centers(candidateCount);
+
+	for (size_t i = 0; i < candidateCount; ++i) {
+		Vector3 center = { positionX(random), positionY(random), positionZ(random) };
+		centers[i] = center;
+		aabbs.Set(i, { { center.x - 0.5f, center.y - 0.5f, center.z - 0.5f }, { center.x + 0.5f, center.y + 0.5f, center.z + 0.5f } });
+	}
+
+	//先に視錐台で絞った候補を遮蔽で判定する(フレームと同じ順)
+	std::vector<uint32_t> candidates(candidateCount);
+
+	size_t frustumVisibleCount = FrustumCull(MakeFrustum(viewProjection), aabbs, candidates.data(), &jobSystem);
+
+	candidates.resize(frustumVisibleCount);
+
+	OcclusionBuffer buffer;
+	buffer.Initialize(256, 144);
+
+	double rasterMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+		buffer.Clear();
+		buffer.RenderOccluder(positions.data(), indices.data(), indices.size(), viewProjection);
+	});
+
+	double hierarchyMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+		buffer.BuildHierarchy();
+	});
+
+	std::printf("occluders %zu triangles, %ux%u buffer, %u threads\n", indices.size() / 3, buffer.GetWidth(), buffer.GetHeight(), jobSystem.GetThreadCount());
+	std::printf("  %-14s %8.2f ms\n", "rasterize", rasterMilliseconds);
+	std::printf("  %-14s %8.2f ms\n", "hierarchy", hierarchyMilliseconds);
+
+	std::printf("candidates %zu (%zu in frustum)\n", candidateCount, candidates.size());
+
+	//1つずつIsVisibleで判定したものを正解にする
+	std::vector<uint32_t> expected(candidates.size());
+
+	size_t expectedCount = 0;
+
+	double isVisibleMilliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+		expectedCount = 0;
+		for (uint32_t index : candidates) {
+			if (buffer.IsVisible(centers[index], { 0.5f, 0.5f, 0.5f }, viewProjection)) {
+				expected[expectedCount++] = index;
+			}
+		}
+	});
+
+	std::printf("  %-14s %8.2f ms %8.1f Mboxes/s  visible %zu\n", "IsVisible loop", isVisibleMilliseconds, candidates.size() / isVisibleMilliseconds / 1000.0, expectedCount);
+
+	std::vector<uint32_t> visibleIndices(candidates.size());
+
+	int result = 0;
+
+	const char* names[] = { "cull 1 thread", "cull jobs" };
+
+	JobSystem* jobSystems[] = { nullptr, &jobSystem };
+
+	for (int i = 0; i < 2; ++i) {
+
+		size_t visibleCount = 0;
+
+		double milliseconds = MeasureBestMilliseconds(repeatCount, [&]() {
+			visibleCount = buffer.Cull(aabbs, candidates.data(), candidates.size(), viewProjection, visibleIndices.data(), jobSystems[i]);
+		});
+
+		if (visibleCount != expectedCount || !std::equal(expected.begin(), expected.begin() + expectedCount, visibleIndices.begin())) {
+			std::printf("  %s: result differs from IsVisible\n", names[i]);
+			result = 1;
+			continue;
+		}
+
+		std::printf("  %-14s %8.2f ms %8.1f Mboxes/s  visible %zu (%.1f%% culled)\n", names[i], milliseconds, candidates.size() / milliseconds / 1000.0, visibleCount, 100.0 * (candidates.size() - visibleCount) / (std::max)(candidates.size(), size_t(1)));
+
+	}
+
+	jobSystem.Finalize();
+
+	return result;
+
+}
@@ -0,0 +1,406 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "OcclusionCulling.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+//同じテストをSSE2とSIMDなし(OCCLUSION_NO_SIMD)でビルドしたOcclusionCulling.cppに対して動かす
+//どちらでも、本当に見えている箱を隠れていると判定しないことを確かめる
+
+namespace {
+
+	const float kNearClip = 0.1f;
+	const float kFarClip = 100.0f;
+
+	//z = kWallDepthに置く正面の壁の大きさの半分(画面の中央だけを覆う)
+	const float kWallDepth = 10.0f;
+	const float kWallHalfSize = 2.0f;
+
+	//原点から+Zを見るカメラ
+	Matrix4x4 MakeTestViewProjection() {
+		return MakeTestPerspectiveMatrix(0.8f, 16.0f / 9.0f, kNearClip, kFarClip);
+	}
+
+	//ビュー空間の深さzのreversed-Zの深度
+	float GetReversedDepth(float z) {
+		return kNearClip / (kNearClip - kFarClip) - kFarClip * kNearClip / (kNearClip - kFarClip) / z;
+	}
+
+	//z = depthの平面の[-halfSize, halfSize]の正方形をdivision x divisionの格子で三角形にする
+	void MakeWall(float depth, float halfSize, uint32_t division, std::vector<Vector4>& positions, std::vector<uint32_t>& indices) {
+
+		positions.clear();
+		indices.clear();
+
+		for (uint32_t y = 0; y <= division; ++y) {
+			for (uint32_t x = 0; x <= division; ++x) {
+				positions.push_back({ -halfSize + 2.0f * halfSize * x / division, -halfSize + 2.0f * halfSize * y / division, depth, 1.0f });
+			}
+		}
+
+		for (uint32_t y = 0; y < division; ++y) {
+			for (uint32_t x = 0; x < division; ++x) {
+				uint32_t index = y * (division + 1) + x;
+				uint32_t quad[6] = { index, index + division + 1, index + 1, index + 1, index + division + 1, index + division + 2 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+
+	}
+
+	//正面の壁を描いたバッファ
+	void RenderTestWall(OcclusionBuffer& buffer, uint32_t division) {
+
+		std::vector<Vector4> positions;
+		std::vector<uint32_t> indices;
+
+		MakeWall(kWallDepth, kWallHalfSize, division, positions, indices);
+
+		buffer.Initialize(256, 144);
+		buffer.Clear();
+		buffer.RenderOccluder(positions.data(), indices.data(), indices.size(), MakeTestViewProjection());
+		buffer.BuildHierarchy();
+
+	}
+
+	//原点から見て、箱の8頂点が全て壁の後ろに隠れているか
+	bool IsBehindTestWall(const Vector3& center, const Vector3& extent) {
+
+		for (int corner = 0; corner < 8; ++corner) {
+
+			float x = center.x + ((corner & 1) ? extent.x : -extent.x);
+			float y = center.y + ((corner & 2) ? extent.y : -extent.y);
+			float z = center.z + ((corner & 4) ? extent.z : -extent.z);
+
+			if (z <= kWallDepth || std::fabs(x * kWallDepth / z) > kWallHalfSize || std::fabs(y * kWallDepth / z) > kWallHalfSize) {
+				return false;
+			}
+
+		}
+
+		return true;
+
+	}
+
+	//画面に映るか(視錐台の中に少しでも入るか)
+	bool IsOnScreen(const Vector3& center, const Vector3& extent, const Matrix4x4& viewProjection) {
+
+		Frustum frustum = MakeFrustum(viewProjection);
+
+		AABBArray aabbs;
+		aabbs.Resize(1);
+		aabbs.Set(0, { { center.x - extent.x, center.y - extent.y, center.z - extent.z }, { center.x + extent.x, center.y + extent.y, center.z + extent.z } });
+
+		uint32_t visibleIndex;
+
+		return CullAABBs(frustum, aabbs, 0, 1, &visibleIndex) == 1;
+
+	}
+
+}
+
+TEST_CASE(InitializeRoundsWidthAndBuildsLevels) {
+
+	OcclusionBuffer buffer;
+	buffer.Initialize(250, 141);
+
+	CHECK(buffer.GetWidth() == 252);
+	CHECK(buffer.GetHeight() == 141);
+
+	//252x141から1x1まで半分ずつ(切り上げ)
+	CHECK(buffer.GetLevelCount() == 9);
+
+	buffer.Clear();
+
+	for (uint32_t i = 0; i < 252 * 141; ++i) {
+		REQUIRE(buffer.GetDepth(0)[i] == 0.0f);
+	}
+
+}
+
+TEST_CASE(WallDepthMatchesPlane) {
+
+	OcclusionBuffer buffer;
+	RenderTestWall(buffer, 1);
+
+	const float* depth = buffer.GetDepth(0);
+
+	//正面の壁は深度が一定なので、画素の中で奥へずらしても同じ値になる
+	float expected = GetReversedDepth(kWallDepth);
+
+	CHECK(std::fabs(depth[72 * 256 + 128] - expected) < 1e-6f);
+
+	//壁の外(画面の隅)は何も描かれない
+	CHECK(depth[0] == 0.0f);
+	CHECK(depth[143 * 256 + 255] == 0.0f);
+
+	//描かれた深度は壁より手前にならない
+	for (uint32_t i = 0; i < 256 * 144; ++i) {
+		REQUIRE(depth[i] <= expected + 1e-6f);
+	}
+
+}
+
+TEST_CASE(SharedEdgesDoNotLeak) {
+
+	//細かく分けた壁でも、三角形の境目に描かれない画素ができない
+	OcclusionBuffer buffer;
+	RenderTestWall(buffer, 16);
+
+	Matrix4x4 viewProjection = MakeTestViewProjection();
+
+	//壁の角を画面に映した位置
+	float right = (kWallHalfSize * viewProjection.m[0][0] / kWallDepth + 1.0f) * 0.5f * 256.0f;
+	float bottom = (1.0f + kWallHalfSize * viewProjection.m[1][1] / kWallDepth) * 0.5f * 144.0f;
+
+	uint32_t beginX = static_cast<uint32_t>(256.0f - right) + 1;
+	uint32_t endX = static_cast<uint32_t>(right) - 1;
+	uint32_t beginY = static_cast<uint32_t>(144.0f - bottom) + 1;
+	uint32_t endY = static_cast<uint32_t>(bottom) - 1;
+
+	REQUIRE(beginX < endX);
+	REQUIRE(beginY < endY);
+
+	size_t holeCount = 0;
+
+	for (uint32_t y = beginY; y <= endY; ++y) {
+		for (uint32_t x = beginX; x <= endX; ++x) {
+			if (buffer.GetDepth(0)[y * 256 + x] == 0.0f) {
+				holeCount++;
+			}
+		}
+	}
+
+	CHECK(holeCount == 0);
+
+}
+
+TEST_CASE(WallHidesBoxesBehindIt) {
+
+	OcclusionBuffer buffer;
+	RenderTestWall(buffer, 1);
+
+	Matrix4x4 viewProjection = MakeTestViewProjection();
+
+	Vector3 extent = { 1.0f, 1.0f, 1.0f };
+
+	CHECK(!buffer.IsVisible({ 0.0f, 0.0f, 20.0f }, extent, viewProjection));
+	CHECK(!buffer.IsVisible({ 5.0f, -5.0f, 60.0f }, extent, viewProjection));
+
+	//手前、横、壁をまたぐ箱は見える
+	CHECK(buffer.IsVisible({ 0.0f, 0.0f, 5.0f }, extent, viewProjection));
+	CHECK(buffer.IsVisible({ 8.0f, 0.0f, 20.0f }, extent, viewProjection));
+	CHECK(buffer.IsVisible({ 0.0f, 0.0f, 10.0f }, extent, viewProjection));
+
+	//壁の縁からはみ出す箱は見える
+	CHECK(buffer.IsVisible({ 4.5f, 0.0f, 20.0f }, extent, viewProjection));
+
+	//近クリップ面をまたぐ箱は見えるものとする
+	CHECK(buffer.IsVisible({ 0.0f, 0.0f, 0.0f }, extent, viewProjection));
+
+}
+
+TEST_CASE(NearClippedFloorHidesBoxesBelow) {
+
+	//カメラの下を通って奥まで続く床(近クリップ面で切られる)
+	Vector4 floor[4] = { { -50.0f, -1.0f, -5.0f, 1.0f }, { 50.0f, -1.0f, -5.0f, 1.0f }, { 50.0f, -1.0f, 90.0f, 1.0f }, { -50.0f, -1.0f, 90.0f, 1.0f } };
+
+	uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+
+	Matrix4x4 viewProjection = MakeTestViewProjection();
+
+	OcclusionBuffer buffer;
+	buffer.Initialize(256, 144);
+	buffer.Clear();
+	buffer.RenderOccluder(floor, indices, 6, viewProjection);
+	buffer.BuildHierarchy();
+
+	CHECK(!buffer.IsVisible({ 0.0f, -3.0f, 20.0f }, { 1.0f, 1.0f, 1.0f }, viewProjection));
+	CHECK(buffer.IsVisible({ 0.0f, 1.0f, 20.0f }, { 1.0f, 1.0f, 1.0f }, viewProjection));
+
+	//床を突き抜ける箱は見える
+	CHECK(buffer.IsVisible({ 0.0f, -1.0f, 20.0f }, { 1.0f, 1.0f, 1.0f }, viewProjection));
+
+}
+
+TEST_CASE(HierarchyKeepsFarthestDepth) {
+
+	//ばらばらの三角形を描き、各段が下の段の2x2の最も奥の深度になっている
+	std::mt19937 random(37);
+
+	std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+	std::uniform_real_distribution<float> depth(1.0f, 60.0f);
+
+	std::vector<Vector4> positions(300);
+	std::vector<uint32_t> indices(300);
+
+	for (size_t i = 0; i < positions.size(); ++i) {
+		positions[i] = { position(random), position(random), depth(random), 1.0f };
+		indices[i] = static_cast<uint32_t>(i);
+	}
+
+	OcclusionBuffer buffer;
+	buffer.Initialize(200, 120);
+	buffer.Clear();
+	buffer.RenderOccluder(positions.data(), indices.data(), indices.size(), MakeTestViewProjection());
+	buffer.BuildHierarchy();
+
+	uint32_t width = buffer.GetWidth();
+	uint32_t height = buffer.GetHeight();
+
+	size_t mismatchCount = 0;
+
+	for (uint32_t level = 1; level < buffer.GetLevelCount(); ++level) {
+
+		uint32_t levelWidth = (width + 1) / 2;
+		uint32_t levelHeight = (height + 1) / 2;
+
+		const float* source = buffer.GetDepth(level - 1);
+		const float* destination = buffer.GetDepth(level);
+
+		for (uint32_t y = 0; y < levelHeight; ++y) {
+			for (uint32_t x = 0; x < levelWidth; ++x) {
+
+				float expected = 1.0f;
+
+				for (uint32_t sy = y * 2; sy <= (std::min)(y * 2 + 1, height - 1); ++sy) {
+					for (uint32_t sx = x * 2; sx <= (std::min)(x * 2 + 1, width - 1); ++sx) {
+						expected = (std::min)(expected, source[sy * width + sx]);
+					}
+				}
+
+				if (destination[y * levelWidth + x] != expected) {
+					mismatchCount++;
+				}
+
+			}
+		}
+
+		width = levelWidth;
+		height = levelHeight;
+
+	}
+
+	CHECK(width == 1);
+	CHECK(height == 1);
+	CHECK(mismatchCount == 0);
+
+}
+
+TEST_CASE(VisibleBoxesAreNeverCulled) {
+
+	//壁の周りにばらまいた箱のうち、本当に見えているものは必ず見えると判定する
+	OcclusionBuffer buffer;
+	RenderTestWall(buffer, 4);
+
+	Matrix4x4 viewProjection = MakeTestViewProjection();
+
+	std::mt19937 random(38);
+
+	std::uniform_real_distribution<float> position(-15.0f, 15.0f);
+	std::uniform_real_distribution<float> depth(1.0f, 90.0f);
+	std::uniform_real_distribution<float> size(0.05f, 3.0f);
+
+	size_t hiddenCount = 0;
+	size_t culledHiddenCount = 0;
+	size_t wrongCount = 0;
+
+	for (int i = 0; i < 20000; ++i) {
+
+		Vector3 center = { position(random), position(random), depth(random) };
+		Vector3 extent = { size(random), size(random), size(random) };
+
+		if (!IsOnScreen(center, extent, viewProjection)) {
+			continue;
+		}
+
+		bool isVisible = buffer.IsVisible(center, extent, viewProjection);
+
+		if (IsBehindTestWall(center, extent)) {
+			hiddenCount++;
+			culledHiddenCount += isVisible ? 0 : 1;
+		} else if (!isVisible) {
+			wrongCount++;
+		}
+
+	}
+
+	CHECK(wrongCount == 0);
+
+	//隠れている箱の多くは実際に取り除ける(階層Zで粗くなる縁の近くだけが残る)
+	CHECK(hiddenCount > 1000);
+	CHECK(culledHiddenCount >= hiddenCount * 3 / 4);
+
+}
+
+TEST_CASE(CullMatchesIsVisible) {
+
+	OcclusionBuffer buffer;
+	RenderTestWall(buffer, 2);
+
+	Matrix4x4 viewProjection = MakeTestViewProjection();
+
+	const size_t kCount = 20000;
+
+	std::mt19937 random(39);
+
+	std::uniform_real_distribution<float> position(-15.0f, 15.0f);
+	std::uniform_real_distribution<float> depth(1.0f, 90.0f);
+
+	AABBArray aabbs;
+	aabbs.Resize(kCount);
+
+	for (size_t i = 0; i < kCount; ++i) {
+		Vector3 center = { position(random), position(random), depth(random) };
+		aabbs.Set(i, { { center.x - 0.5f, center.y - 0.5f, center.z - 0.5f }, { center.x + 0.5f, center.y + 0.5f, center.z + 0.5f } });
+	}
+
+	//候補は1つおき
+	std::vector<uint32_t> candidates;
+
+	for (uint32_t i = 0; i < kCount; i += 2) {
+		candidates.push_back(i);
+	}
+
+	std::vector<uint32_t> expected;
+
+	for (uint32_t index : candidates) {
+		Vector3 center = { aabbs.GetCenterX()[index], aabbs.GetCenterY()[index], aabbs.GetCenterZ()[index] };
+		Vector3 extent = { aabbs.GetExtentX()[index], aabbs.GetExtentY()[index], aabbs.GetExtentZ()[index] };
+		if (buffer.IsVisible(center, extent, viewProjection)) {
+			expected.push_back(index);
+		}
+	}
+
+	CHECK(expected.size() < candidates.size());
+
+	JobSystem jobSystem;
+	jobSystem.Initialize(3);
+
+	std::vector<uint32_t> visible(candidates.size());
+
+	for (JobSystem* system : { static_cast<JobSystem*>(nullptr), &jobSystem }) {
+
+		size_t visibleCount = buffer.Cull(aabbs, candidates.data(), candidates.size(), viewProjection, visible.data(), system);
+
+		CHECK(std::vector<uint32_t>(visible.begin(), visible.begin() + visibleCount) == expected);
+
+	}
+
+	//候補の配列にそのまま詰めてもよい
+	std::vector<uint32_t> inPlace = candidates;
+
+	size_t visibleCount = buffer.Cull(aabbs, inPlace.data(), inPlace.size(), viewProjection, inPlace.data(), &jobSystem);
+
+	inPlace.resize(visibleCount);
+
+	CHECK(inPlace == expected);
+
+	CHECK(buffer.Cull(aabbs, nullptr, 0, viewProjection, visible.data(), &jobSystem) == 0);
+
+	jobSystem.Finalize();
+
+}
@@ -0,0 +1,412 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "Picking.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+//同じテストをSSE2とSIMDなし(PICKING_NO_SIMD)でビルドしたPicking.cppに対して動かす
+//レイと三角形の判定、BVHをたどった結果が全ての三角形を調べた結果と一致することを確かめる
+
+namespace {
+
+	//1つ目のレーンだけに三角形を入れたもの(残りは面積0なので当たらない)
+	TrianglePacket MakeSinglePacket(const Vector3& p0, const Vector3& p1, const Vector3& p2) {
+
+		TrianglePacket packet = {};
+
+		packet.v0x[0] = p0.x;
+		packet.v0y[0] = p0.y;
+		packet.v0z[0] = p0.z;
+		packet.edge1x[0] = p1.x - p0.x;
+		packet.edge1y[0] = p1.y - p0.y;
+		packet.edge1z[0] = p1.z - p0.z;
+		packet.edge2x[0] = p2.x - p0.x;
+		packet.edge2y[0] = p2.y - p0.y;
+		packet.edge2z[0] = p2.z - p0.z;
+
+		for (uint32_t& triangleIndex : packet.triangleIndices) {
+			triangleIndex = Bvh::kInvalidIndex;
+		}
+
+		packet.triangleIndices[0] = 0;
+
+		return packet;
+
+	}
+
+	//全ての三角形を1つずつ調べて一番近いもの
+	bool IntersectBruteForce(const MeshData& mesh, const Ray& ray, float maxDistance, float& distance, uint32_t& triangleIndex) {
+
+		bool isHit = false;
+
+		for (size_t i = 0; i < mesh.indices.size() / 3; ++i) {
+
+			const Vector4& p0 = mesh.vertices[mesh.indices[i * 3 + 0]].position;
+			const Vector4& p1 = mesh.vertices[mesh.indices[i * 3 + 1]].position;
+			const Vector4& p2 = mesh.vertices[mesh.indices[i * 3 + 2]].position;
+
+			TrianglePacket packet = MakeSinglePacket({ p0.x, p0.y, p0.z }, { p1.x, p1.y, p1.z }, { p2.x, p2.y, p2.z });
+
+			uint32_t lane = 0;
+
+			if (IntersectRayTrianglePacket(ray, packet, maxDistance, distance, lane)) {
+				maxDistance = distance;
+				triangleIndex = static_cast<uint32_t>(i);
+				isHit = true;
+			}
+
+		}
+
+		return isHit;
+
+	}
+
+	PickingMesh BuildPickingMesh(const MeshData& mesh) {
+
+		std::vector<Vector4> positions;
+
+		for (const auto& vertex : mesh.vertices) {
+			positions.push_back(vertex.position);
+		}
+
+		PickingMesh pickingMesh;
+
+		pickingMesh.Build(positions.data(), mesh.indices.data(), mesh.indices.size());
+
+		return pickingMesh;
+
+	}
+
+	//起伏のある格子(レイが斜めに何枚もの三角形の近くを通る)
+	MeshData MakeHeightFieldMesh(uint32_t size) {
+
+		MeshData mesh = MakeGridMesh(size);
+
+		std::mt19937 random(39);
+
+		std::uniform_real_distribution<float> height(0.0f, 3.0f);
+
+		for (auto& vertex : mesh.vertices) {
+			vertex.position.y = height(random);
+		}
+
+		mesh.bounds.max.y = 3.0f;
+
+		return mesh;
+
+	}
+
+	//MakeTestPerspectiveMatrixの逆行列(射影は対角と深度の4つだけなので解いて求める)
+	Matrix4x4 MakeInversePerspectiveMatrix(float fovY, float aspectRatio, float nearClip, float farClip) {
+
+		Matrix4x4 projection = MakeTestPerspectiveMatrix(fovY, aspectRatio, nearClip, farClip);
+
+		Matrix4x4 result{};
+
+		result.m[0][0] = 1.0f / projection.m[0][0];
+		result.m[1][1] = 1.0f / projection.m[1][1];
+		result.m[2][3] = 1.0f / projection.m[3][2];
+		result.m[3][2] = 1.0f;
+		result.m[3][3] = -projection.m[2][2] / projection.m[3][2];
+
+		return result;
+
+	}
+
+	Matrix4x4 MakeTranslationMatrix(const Vector3& translation) {
+
+		Matrix4x4 result{};
+
+		for (int i = 0; i < 4; ++i) {
+			result.m[i][i] = 1.0f;
+		}
+
+		result.m[3][0] = translation.x;
+		result.m[3][1] = translation.y;
+		result.m[3][2] = translation.z;
+
+		return result;
+
+	}
+
+	Vector3 GetRayPoint(const Ray& ray, float distance) {
+		return { ray.origin.x + ray.direction.x * distance, ray.origin.y + ray.direction.y * distance, ray.origin.z + ray.direction.z * distance };
+	}
+
+	bool IsNear(float a, float b, float tolerance) {
+		return std::fabs(a - b) <= tolerance;
+	}
+
+}
+
+TEST_CASE(RayHitsInsideTriangleOnly) {
+
+	//z = 5の直角三角形
+	TrianglePacket packet = MakeSinglePacket({ 0.0f, 0.0f, 5.0f }, { 2.0f, 0.0f, 5.0f }, { 0.0f, 2.0f, 5.0f });
+
+	float distance = 0.0f;
+
+	uint32_t lane = 4;
+
+	CHECK(IntersectRayTrianglePacket({ { 0.5f, 0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, packet, 100.0f, distance, lane));
+	CHECK(IsNear(distance, 5.0f, 1e-5f));
+	CHECK(lane == 0);
+
+	//距離はdirectionの長さが単位
+	CHECK(IntersectRayTrianglePacket({ { 0.5f, 0.5f, 0.0f }, { 0.0f, 0.0f, 2.0f } }, packet, 100.0f, distance, lane));
+	CHECK(IsNear(distance, 2.5f, 1e-5f));
+
+	//斜辺の外と負の側
+	CHECK(!IntersectRayTrianglePacket({ { 1.5f, 1.5f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, packet, 100.0f, distance, lane));
+	CHECK(!IntersectRayTrianglePacket({ { -0.1f, 0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, packet, 100.0f, distance, lane));
+
+	//裏からも当たる
+	CHECK(IntersectRayTrianglePacket({ { 0.5f, 0.5f, 10.0f }, { 0.0f, 0.0f, -1.0f } }, packet, 100.0f, distance, lane));
+	CHECK(IsNear(distance, 5.0f, 1e-5f));
+
+	//後ろ、平行、maxDistanceより先は当たらない
+	CHECK(!IntersectRayTrianglePacket({ { 0.5f, 0.5f, 10.0f }, { 0.0f, 0.0f, 1.0f } }, packet, 100.0f, distance, lane));
+	CHECK(!IntersectRayTrianglePacket({ { 0.5f, 0.5f, 5.0f }, { 1.0f, 0.0f, 0.0f } }, packet, 100.0f, distance, lane));
+	CHECK(!IntersectRayTrianglePacket({ { 0.5f, 0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, packet, 5.0f, distance, lane));
+
+}
+
+TEST_CASE(PacketReturnsClosestLane) {
+
+	//同じ形の三角形をレーンごとに違う深さに置く
+	const float kDepths[4] = { 7.0f, 3.0f, 9.0f, 4.0f };
+
+	TrianglePacket packet = {};
+
+	for (uint32_t lane = 0; lane < 4; ++lane) {
+		packet.v0x[lane] = -1.0f;
+		packet.v0y[lane] = -1.0f;
+		packet.v0z[lane] = kDepths[lane];
+		packet.edge1x[lane] = 3.0f;
+		packet.edge2y[lane] = 3.0f;
+		packet.triangleIndices[lane] = lane;
+	}
+
+	Ray ray = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+
+	float distance = 0.0f;
+
+	uint32_t lane = 4;
+
+	CHECK(IntersectRayTrianglePacket(ray, packet, 100.0f, distance, lane));
+	CHECK(lane == 1);
+	CHECK(IsNear(distance, 3.0f, 1e-5f));
+
+	//maxDistanceより近いものだけ残る
+	CHECK(!IntersectRayTrianglePacket(ray, packet, 3.0f, distance, lane));
+
+	//原点を動かすと3より先にある中で一番近いもの
+	CHECK(IntersectRayTrianglePacket({ { 0.0f, 0.0f, 3.5f }, { 0.0f, 0.0f, 1.0f } }, packet, 100.0f, distance, lane));
+	CHECK(lane == 3);
+	CHECK(IsNear(distance, 0.5f, 1e-5f));
+
+	//面積0のレーンには当たらない
+	TrianglePacket empty = {};
+
+	CHECK(!IntersectRayTrianglePacket(ray, empty, 100.0f, distance, lane));
+
+}
+
+TEST_CASE(PickingMeshMatchesBruteForce) {
+
+	MeshData meshes[] = { MakeSphereMesh(24), MakeHeightFieldMesh(40) };
+
+	std::mt19937 random(40);
+
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	for (const MeshData& mesh : meshes) {
+
+		PickingMesh pickingMesh = BuildPickingMesh(mesh);
+
+		CHECK(pickingMesh.GetTriangleCount() == mesh.indices.size() / 3);
+
+		Vector3 center = {
+			(mesh.bounds.min.x + mesh.bounds.max.x) * 0.5f,
+			(mesh.bounds.min.y + mesh.bounds.max.y) * 0.5f,
+			(mesh.bounds.min.z + mesh.bounds.max.z) * 0.5f,
+		};
+
+		float size = mesh.bounds.max.x - mesh.bounds.min.x;
+
+		int hitCount = 0;
+
+		const int kRayCount = 2000;
+
+		for (int i = 0; i < kRayCount; ++i) {
+
+			//メッシュを囲む箱の外から中の点へ向ける
+			Vector3 origin = { center.x + unit(random) * size * 2.0f, center.y + size * 2.0f, center.z + unit(random) * size * 2.0f };
+
+			Vector3 target = { center.x + unit(random) * size * 0.6f, center.y + unit(random) * size * 0.6f, center.z + unit(random) * size * 0.6f };
+
+			Ray ray = { origin, { target.x - origin.x, target.y - origin.y, target.z - origin.z } };
+
+			float expectedDistance = 0.0f;
+
+			uint32_t expectedTriangle = Bvh::kInvalidIndex;
+
+			bool isExpectedHit = IntersectBruteForce(mesh, ray, 2.0f, expectedDistance, expectedTriangle);
+
+			float distance = 0.0f;
+
+			uint32_t triangleIndex = Bvh::kInvalidIndex;
+
+			bool isHit = pickingMesh.Intersect(ray, 2.0f, distance, &triangleIndex);
+
+			CHECK(isHit == isExpectedHit);
+
+			if (!isHit || !isExpectedHit) {
+				continue;
+			}
+
+			hitCount++;
+
+			//共有する辺に当たった時はどちらの三角形でもよいが、距離は同じ
+			CHECK(distance == expectedDistance);
+
+			if (triangleIndex != expectedTriangle) {
+				float otherDistance = 0.0f;
+				uint32_t lane = 0;
+				const Vector4& p0 = mesh.vertices[mesh.indices[triangleIndex * 3 + 0]].position;
+				const Vector4& p1 = mesh.vertices[mesh.indices[triangleIndex * 3 + 1]].position;
+				const Vector4& p2 = mesh.vertices[mesh.indices[triangleIndex * 3 + 2]].position;
+				CHECK(IntersectRayTrianglePacket(ray, MakeSinglePacket({ p0.x, p0.y, p0.z }, { p1.x, p1.y, p1.z }, { p2.x, p2.y, p2.z }), 2.0f, otherDistance, lane));
+				CHECK(otherDistance == distance);
+			}
+
+		}
+
+		//ほとんどのレイがメッシュに当たる
+		CHECK(hitCount > kRayCount / 2);
+
+	}
+
+}
+
+TEST_CASE(PickingMeshHandlesSmallAndEmptyMeshes) {
+
+	//三角形が4の倍数でなければ残りのレーンは空のまま
+	std::vector<Vector4> positions = {
+		{ 0.0f, 0.0f, 5.0f, 1.0f },
+		{ 2.0f, 0.0f, 5.0f, 1.0f },
+		{ 0.0f, 2.0f, 5.0f, 1.0f },
+		{ 0.0f, 0.0f, 8.0f, 1.0f },
+		{ 2.0f, 0.0f, 8.0f, 1.0f },
+		{ 0.0f, 2.0f, 8.0f, 1.0f },
+	};
+
+	std::vector<uint32_t> indices = { 0, 1, 2, 3, 4, 5 };
+
+	PickingMesh mesh;
+	mesh.Build(positions.data(), indices.data(), indices.size());
+
+	CHECK(mesh.GetTriangleCount() == 2);
+
+	float distance = 0.0f;
+
+	uint32_t triangleIndex = Bvh::kInvalidIndex;
+
+	CHECK(mesh.Intersect({ { 0.5f, 0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, 100.0f, distance, &triangleIndex));
+	CHECK(triangleIndex == 0);
+	CHECK(IsNear(distance, 5.0f, 1e-5f));
+
+	//後ろからは奥の三角形が先に当たる
+	CHECK(mesh.Intersect({ { 0.5f, 0.5f, 10.0f }, { 0.0f, 0.0f, -1.0f } }, 100.0f, distance, &triangleIndex));
+	CHECK(triangleIndex == 1);
+	CHECK(IsNear(distance, 2.0f, 1e-5f));
+
+	CHECK(!mesh.Intersect({ { 3.0f, 3.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, 100.0f, distance, &triangleIndex));
+
+	//triangleIndexはなくてもよい
+	CHECK(mesh.Intersect({ { 0.5f, 0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, 100.0f, distance, nullptr));
+
+	PickingMesh empty;
+	empty.Build(nullptr, nullptr, 0);
+
+	CHECK(empty.GetTriangleCount() == 0);
+	CHECK(!empty.Intersect({ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, 100.0f, distance, &triangleIndex));
+
+}
+
+TEST_CASE(PickingRaySpansNearToFarPlane) {
+
+	const float kNearClip = 0.1f;
+	const float kFarClip = 100.0f;
+	const float kFovY = 0.8f;
+	const float kAspectRatio = 16.0f / 9.0f;
+
+	//(0, 0, -5)から+Zを見るカメラ(ビューは平行移動だけなので逆行列は逆向きの平行移動)
+	Matrix4x4 inverseViewProjection = MultiplyMatrix(MakeInversePerspectiveMatrix(kFovY, kAspectRatio, kNearClip, kFarClip), MakeTranslationMatrix({ 0.0f, 0.0f, -5.0f }));
+
+	//画面の中央は視線の上で、距離0が近クリップ面、1が遠クリップ面
+	Ray ray = MakePickingRay(640.0f, 360.0f, 1280.0f, 720.0f, inverseViewProjection);
+
+	Vector3 nearPoint = GetRayPoint(ray, 0.0f);
+	Vector3 farPoint = GetRayPoint(ray, 1.0f);
+
+	CHECK(IsNear(nearPoint.x, 0.0f, 1e-4f));
+	CHECK(IsNear(nearPoint.y, 0.0f, 1e-4f));
+	CHECK(IsNear(nearPoint.z, -5.0f + kNearClip, 1e-4f));
+	CHECK(IsNear(farPoint.x, 0.0f, 1e-3f));
+	CHECK(IsNear(farPoint.z, -5.0f + kFarClip, 1e-2f));
+
+	//左上の角は視野の端(スクリーンのYは下向き)
+	Ray cornerRay = MakePickingRay(0.0f, 0.0f, 1280.0f, 720.0f, inverseViewProjection);
+
+	Vector3 cornerPoint = GetRayPoint(cornerRay, 1.0f);
+
+	float halfHeight = std::tan(kFovY * 0.5f) * kFarClip;
+
+	CHECK(IsNear(cornerPoint.x, -halfHeight * kAspectRatio, 1e-2f));
+	CHECK(IsNear(cornerPoint.y, halfHeight, 1e-2f));
+
+	//原点の球を画面の中央で選ぶと、手前の面z = -1付近に当たる
+	MeshData sphere = MakeSphereMesh(32);
+
+	PickingMesh pickingMesh = BuildPickingMesh(sphere);
+
+	float distance = 0.0f;
+
+	REQUIRE(pickingMesh.Intersect(ray, 1.0f, distance, nullptr));
+
+	CHECK(IsNear(GetRayPoint(ray, distance).z, -1.0f, 0.01f));
+
+}
+
+TEST_CASE(TransformRayKeepsHitDistance) {
+
+	//ワールドで(10, 0, 0)に2倍の大きさで置いたメッシュを、ローカル空間に移したレイで調べる
+	MeshData sphere = MakeSphereMesh(16);
+
+	PickingMesh pickingMesh = BuildPickingMesh(sphere);
+
+	Matrix4x4 worldToLocal{};
+	worldToLocal.m[0][0] = 0.5f;
+	worldToLocal.m[1][1] = 0.5f;
+	worldToLocal.m[2][2] = 0.5f;
+	worldToLocal.m[3][0] = -5.0f;
+	worldToLocal.m[3][3] = 1.0f;
+
+	Ray worldRay = { { 10.0f, 0.1f, -20.0f }, { 0.0f, 0.0f, 4.0f } };
+
+	Ray localRay = TransformRay(worldRay, worldToLocal);
+
+	CHECK(IsNear(localRay.origin.x, 0.0f, 1e-5f));
+	CHECK(IsNear(localRay.origin.z, -10.0f, 1e-5f));
+	CHECK(IsNear(localRay.direction.z, 2.0f, 1e-5f));
+
+	float distance = 0.0f;
+
+	REQUIRE(pickingMesh.Intersect(localRay, 100.0f, distance, nullptr));
+
+	//ローカルで求めた距離をそのままワールドのレイに使うと、ワールドの球の表面(z = -2付近)になる
+	CHECK(IsNear(GetRayPoint(worldRay, distance).z, -2.0f, 0.05f));
+
+}
@@ -0,0 +1,243 @@
+#include "TestFramework.h"
+#include "PipelineStateDesc.h"
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+	const uint8_t kVertexShader[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	const uint8_t kPixelShader[] = { 9, 10, 11, 12 };
+
+	const D3D12_INPUT_ELEMENT_DESC kInputElements[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+
+	//main.cppと同じ設定のDescを、パディングをfillで埋めたメモリに作る
+	std::unique_ptr<D3D12_GRAPHICS_PIPELINE_STATE_DESC> MakeDesc(uint8_t fill) {
+
+		std::unique_ptr<D3D12_GRAPHICS_PIPELINE_STATE_DESC> desc = std::make_unique<D3D12_GRAPHICS_PIPELINE_STATE_DESC>();
+
+		std::memset(desc.get(), fill, sizeof(*desc));
+
+		desc->pRootSignature = nullptr;
+		desc->VS = { kVertexShader, sizeof(kVertexShader) };
+		desc->PS = { kPixelShader, sizeof(kPixelShader) };
+		desc->DS = {};
+		desc->HS = {};
+		desc->GS = {};
+		desc->StreamOutput = {};
+
+		desc->BlendState.AlphaToCoverageEnable = false;
+		desc->BlendState.IndependentBlendEnable = false;
+		for (D3D12_RENDER_TARGET_BLEND_DESC& renderTarget : desc->BlendState.RenderTarget) {
+			renderTarget.BlendEnable = false;
+			renderTarget.LogicOpEnable = false;
+			renderTarget.SrcBlend = D3D12_BLEND_ONE;
+			renderTarget.DestBlend = D3D12_BLEND_ZERO;
+			renderTarget.BlendOp = D3D12_BLEND_OP_ADD;
+			renderTarget.SrcBlendAlpha = D3D12_BLEND_ONE;
+			renderTarget.DestBlendAlpha = D3D12_BLEND_ZERO;
+			renderTarget.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+			renderTarget.LogicOp = D3D12_LOGIC_OP_NOOP;
+			renderTarget.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+		}
+		desc->SampleMask = D3D12_DEFAULT_SAMPLE_MASK;
+
+		desc->RasterizerState = { D3D12_FILL_MODE_SOLID, D3D12_CULL_MODE_BACK, false, 0, 0.0f, 0.0f, true, false, false, 0, D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF };
+
+		desc->DepthStencilState.DepthEnable = true;
+		desc->DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+		desc->DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+		desc->DepthStencilState.StencilEnable = false;
+		desc->DepthStencilState.StencilReadMask = 0xff;
+		desc->DepthStencilState.StencilWriteMask = 0xff;
+		desc->DepthStencilState.FrontFace = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+		desc->DepthStencilState.BackFace = desc->DepthStencilState.FrontFace;
+
+		desc->InputLayout = { kInputElements, 2 };
+		desc->IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
+		desc->PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+		desc->NumRenderTargets = 1;
+		desc->RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+		desc->DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		desc->SampleDesc = { 1, 0 };
+		desc->NodeMask = 0;
+		desc->CachedPSO = {};
+		desc->Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+
+		return desc;
+
+	}
+
+}
+
+TEST_CASE(HashIgnoresPadding) {
+
+	//RenderTargetWriteMaskとStencilWriteMaskの後のパディングだけが違う
+	std::unique_ptr<D3D12_GRAPHICS_PIPELINE_STATE_DESC> a = MakeDesc(0x00);
+	std::unique_ptr<D3D12_GRAPHICS_PIPELINE_STATE_DESC> b = MakeDesc(0xcd);
+
+	CHECK(std::memcmp(a.get(), b.get(), sizeof(*a)) != 0);
+	CHECK(HashGraphicsPipelineStateDesc(*a, 1) == HashGraphicsPipelineStateDesc(*b, 1));
+
+}
+
+TEST_CASE(HashUsesShaderContentsAndRootSignature) {
+
+	std::unique_ptr<D3D12_GRAPHICS_PIPELINE_STATE_DESC> a = MakeDesc(0);
+
+	//同じ中身の別のバッファを指していても同じハッシュになる
+	std::vector<uint8_t> vertexShader(std::begin(kVertexShader), std::end(kVertexShader));
+	std::vector<std::string> semanticNames = { "POSITION", "TEXCOORD" };
+	std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements(std::begin(kInputElements), std::end(kInputElements));
+	inputElements[0].SemanticName = semanticNames[0].c_str();
+	inputElements[1].SemanticName = semanticNames[1].c_str();
+
+	std::unique_ptr<D3D12_GRAPHICS_PIPELINE_STATE_DESC> b = MakeDesc(0);
+	b->VS.pShaderBytecode = vertexShader.data();
+	b->InputLayout.pInputElementDescs = inputElements.data();
+
+	CHECK(HashGraphicsPipelineStateDesc(*a, 1) == HashGraphicsPipelineStateDesc(*b, 1));
+	CHECK(HashGraphicsPipelineStateDesc(*a, 1) != HashGraphicsPipelineStateDesc(*a, 2));
+
+	vertexShader[3] ^= 1;
+	CHECK(HashGraphicsPipelineStateDesc(*a, 1) != HashGraphicsPipelineStateDesc(*b, 1));
+
+}
+
+TEST_CASE(HashChangesWithEveryState) {
+
+	std::unique_ptr<D3D12_GRAPHICS_PIPELINE_STATE_DESC> base = MakeDesc(0);
+
+	uint64_t baseHash = HashGraphicsPipelineStateDesc(*base, 1);
+
+	//1つずつ変えてハッシュが変わることを確かめる
+	std::vector<void (*)(D3D12_GRAPHICS_PIPELINE_STATE_DESC&)> changes = {
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.BlendState.AlphaToCoverageEnable = true; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.BlendState.RenderTarget[0].BlendEnable = true; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.BlendState.RenderTarget[0].SrcBlend = D3D12_BLEND_SRC_ALPHA; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.BlendState.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.BlendState.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_RED; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.BlendState.RenderTarget[7].LogicOp = D3D12_LOGIC_OP_COPY; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.SampleMask = 1; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.RasterizerState.SlopeScaledDepthBias = 1.0f; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_EQUAL; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.DepthStencilState.StencilWriteMask = 0x0f; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.DepthStencilState.BackFace.StencilPassOp = D3D12_STENCIL_OP_REPLACE; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.PS = {}; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.InputLayout.NumElements = 1; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.NumRenderTargets = 0; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.DSVFormat = DXGI_FORMAT_D32_FLOAT; },
+		[](D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { desc.SampleDesc.Count = 4; },
+	};
+
+	std::vector<uint64_t> hashes = { baseHash };
+
+	for (auto change : changes) {
+
+		std::unique_ptr<D3D12_GRAPHICS_PIPELINE_STATE_DESC> desc = MakeDesc(0);
+
+		change(*desc);
+
+		uint64_t hash = HashGraphicsPipelineStateDesc(*desc, 1);
+
+		for (uint64_t other : hashes) {
+			CHECK(hash != other);
+		}
+
+		hashes.push_back(hash);
+
+	}
+
+}
+
+TEST_CASE(HashSeparatesStreamOutputStrides) {
+
+	//ストライドの数だけが違うもの(エントリーと同じように数も入れて、ストライドの並びの区切りを決める)
+	static const UINT kStrides[] = { 16, 0, 0 };
+
+	std::vector<uint64_t> hashes;
+
+	for (UINT strideCount = 0; strideCount <= 3; ++strideCount) {
+
+		std::unique_ptr<D3D12_GRAPHICS_PIPELINE_STATE_DESC> desc = MakeDesc(0);
+		desc->StreamOutput.pBufferStrides = kStrides;
+		desc->StreamOutput.NumStrides = strideCount;
+
+		uint64_t hash = HashGraphicsPipelineStateDesc(*desc, 1);
+
+		for (uint64_t other : hashes) {
+			CHECK(hash != other);
+		}
+
+		hashes.push_back(hash);
+
+	}
+
+	//ストライドの値とラスタライズするストリームも区別する
+	static const UINT kOtherStrides[] = { 32, 0, 0 };
+
+	std::unique_ptr<D3D12_GRAPHICS_PIPELINE_STATE_DESC> a = MakeDesc(0);
+	a->StreamOutput.pBufferStrides = kStrides;
+	a->StreamOutput.NumStrides = 1;
+
+	std::unique_ptr<D3D12_GRAPHICS_PIPELINE_STATE_DESC> b = MakeDesc(0);
+	b->StreamOutput.pBufferStrides = kOtherStrides;
+	b->StreamOutput.NumStrides = 1;
+
+	CHECK(HashGraphicsPipelineStateDesc(*a, 1) != HashGraphicsPipelineStateDesc(*b, 1));
+
+	b->StreamOutput.pBufferStrides = kStrides;
+	b->StreamOutput.RasterizedStream = 1;
+
+	CHECK(HashGraphicsPipelineStateDesc(*a, 1) != HashGraphicsPipelineStateDesc(*b, 1));
+
+}
+
+TEST_CASE(PipelineStateName) {
+
+	CHECK(MakePipelineStateName(0) == L"PSO_0000000000000000");
+	CHECK(MakePipelineStateName(0x0123456789abcdefull) == L"PSO_0123456789abcdef");
+
+}
+
+TEST_CASE(DescCopyOwnsReferencedData) {
+
+	std::unique_ptr<D3D12_GRAPHICS_PIPELINE_STATE_DESC> source = MakeDesc(0);
+
+	std::vector<uint8_t> vertexShader(std::begin(kVertexShader), std::end(kVertexShader));
+	std::vector<std::string> semanticNames = { "POSITION", "TEXCOORD" };
+	std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements(std::begin(kInputElements), std::end(kInputElements));
+	inputElements[0].SemanticName = semanticNames[0].c_str();
+	inputElements[1].SemanticName = semanticNames[1].c_str();
+
+	source->VS.pShaderBytecode = vertexShader.data();
+	source->InputLayout.pInputElementDescs = inputElements.data();
+
+	uint64_t hash = HashGraphicsPipelineStateDesc(*source, 1);
+
+	GraphicsPipelineStateDescCopy copy(*source);
+
+	//元のDescが指すものを壊してもコピーは変わらない
+	std::fill(vertexShader.begin(), vertexShader.end(), uint8_t(0));
+	semanticNames[0].assign("XXXXXXXX");
+	inputElements[1].Format = DXGI_FORMAT_UNKNOWN;
+
+	const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc = copy.Get();
+
+	CHECK(desc.VS.pShaderBytecode != source->VS.pShaderBytecode);
+	CHECK(desc.PS.pShaderBytecode != source->PS.pShaderBytecode);
+	CHECK(desc.DS.pShaderBytecode == nullptr);
+	CHECK(std::strcmp(desc.InputLayout.pInputElementDescs[0].SemanticName, "POSITION") == 0);
+	CHECK(HashGraphicsPipelineStateDesc(desc, 1) == hash);
+
+}
@@ -0,0 +1,473 @@
+#include "TestFramework.h"
+#include "RenderGraph.h"
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+	const RenderGraphTextureDesc kTextureDesc{ 64, 64, 0, 1000, 256 };
+
+	//実行したパスの順と、送られたバリアをそれまでに実行したパスの数と一緒に記録する
+	struct RecordedBarrier {
+		uint32_t passesBefore;
+		uint32_t batch;
+		RenderGraphBarrier barrier;
+	};
+
+	struct ExecutionTrace {
+
+		std::vector<std::string> passes;
+
+		std::vector<RecordedBarrier> barriers;
+
+		uint32_t batchCount = 0;
+
+		//resourceの遷移だけを取り出す
+		std::vector<RecordedBarrier> GetTransitions(uint32_t resource) const {
+
+			std::vector<RecordedBarrier> result;
+
+			for (const RecordedBarrier& recorded : barriers) {
+				if (recorded.barrier.type == RenderGraphBarrierType::kTransition && recorded.barrier.resource == resource) {
+					result.push_back(recorded);
+				}
+			}
+
+			return result;
+
+		}
+
+	};
+
+	uint32_t AddTracedPass(RenderGraph& graph, ExecutionTrace& trace, const std::string& name) {
+		return graph.AddPass(name, [&trace, name]() { trace.passes.push_back(name); });
+	}
+
+	void ExecuteTraced(const RenderGraph& graph, ExecutionTrace& trace) {
+
+		graph.Execute([&trace](const RenderGraphBarrier* barriers, size_t count) {
+
+			for (size_t i = 0; i < count; ++i) {
+				trace.barriers.push_back({ static_cast<uint32_t>(trace.passes.size()), trace.batchCount, barriers[i] });
+			}
+
+			trace.batchCount++;
+
+		});
+
+	}
+
+	bool IsMemoryOverlapped(const RenderGraph& graph, uint32_t a, uint32_t b) {
+
+		uint64_t aBegin = graph.GetHeapOffset(a);
+		uint64_t bBegin = graph.GetHeapOffset(b);
+
+		return aBegin < bBegin + graph.GetTextureDesc(b).size && bBegin < aBegin + graph.GetTextureDesc(a).size;
+
+	}
+
+}
+
+TEST_CASE(PassesWithUnusedOutputsAreCulled) {
+
+	RenderGraph graph;
+
+	ExecutionTrace trace;
+
+	uint32_t backBuffer = graph.ImportResource("BackBuffer", kResourceStatePresent, kResourceStatePresent);
+
+	uint32_t scene = graph.CreateTexture("Scene", kTextureDesc);
+	uint32_t debug = graph.CreateTexture("Debug", kTextureDesc);
+	uint32_t debugBlur = graph.CreateTexture("DebugBlur", kTextureDesc);
+
+	uint32_t scenePass = AddTracedPass(graph, trace, "Scene");
+	graph.Write(scenePass, scene, kResourceStateRenderTarget);
+
+	//Debug -> DebugBlurと続くが、DebugBlurを読むパスがないので2つとも消える
+	uint32_t debugPass = AddTracedPass(graph, trace, "Debug");
+	graph.Read(debugPass, scene, kResourceStatePixelShaderResource);
+	graph.Write(debugPass, debug, kResourceStateRenderTarget);
+
+	uint32_t debugBlurPass = AddTracedPass(graph, trace, "DebugBlur");
+	graph.Read(debugBlurPass, debug, kResourceStatePixelShaderResource);
+	graph.Write(debugBlurPass, debugBlur, kResourceStateRenderTarget);
+
+	//出力がなくても副作用のあるパスは残す
+	uint32_t readbackPass = AddTracedPass(graph, trace, "Readback");
+	graph.SetSideEffect(readbackPass);
+
+	uint32_t presentPass = AddTracedPass(graph, trace, "Present");
+	graph.Read(presentPass, scene, kResourceStatePixelShaderResource);
+	graph.Write(presentPass, backBuffer, kResourceStateRenderTarget);
+
+	graph.Compile();
+
+	CHECK(!graph.IsPassCulled(scenePass));
+	CHECK(graph.IsPassCulled(debugPass));
+	CHECK(graph.IsPassCulled(debugBlurPass));
+	CHECK(!graph.IsPassCulled(readbackPass));
+	CHECK(!graph.IsPassCulled(presentPass));
+
+	ExecuteTraced(graph, trace);
+
+	CHECK((trace.passes == std::vector<std::string>{ "Scene", "Readback", "Present" }));
+
+	//消えたパスだけが使うリソースにはバリアを出さない
+	for (const RecordedBarrier& recorded : trace.barriers) {
+		CHECK(recorded.barrier.resource != debug);
+		CHECK(recorded.barrier.resource != debugBlur);
+	}
+
+}
+
+TEST_CASE(PassWritingOnlyImportedResourceIsKept) {
+
+	RenderGraph graph;
+
+	uint32_t backBuffer = graph.ImportResource("BackBuffer", kResourceStatePresent, kResourceStatePresent);
+
+	uint32_t pass = graph.AddPass("Clear", nullptr);
+	graph.Write(pass, backBuffer, kResourceStateRenderTarget);
+
+	graph.Compile();
+
+	CHECK(!graph.IsPassCulled(pass));
+
+	ExecutionTrace trace;
+	ExecuteTraced(graph, trace);
+
+	//グラフの最後で元の状態に戻す
+	std::vector<RecordedBarrier> transitions = trace.GetTransitions(backBuffer);
+
+	REQUIRE(transitions.size() == 2);
+	CHECK(transitions[0].barrier.stateBefore == kResourceStatePresent);
+	CHECK(transitions[0].barrier.stateAfter == kResourceStateRenderTarget);
+	CHECK(transitions[1].barrier.stateBefore == kResourceStateRenderTarget);
+	CHECK(transitions[1].barrier.stateAfter == kResourceStatePresent);
+
+}
+
+TEST_CASE(ConsecutiveReadsAreMergedIntoOneState) {
+
+	RenderGraph graph;
+
+	ExecutionTrace trace;
+
+	uint32_t backBuffer = graph.ImportResource("BackBuffer", kResourceStatePresent, kResourceStatePresent);
+
+	uint32_t depth = graph.CreateTexture("Depth", kTextureDesc);
+	uint32_t color = graph.CreateTexture("Color", kTextureDesc);
+
+	uint32_t depthPass = AddTracedPass(graph, trace, "Depth");
+	graph.Write(depthPass, depth, kResourceStateDepthWrite);
+
+	//ピクセルシェーダーとそれ以外のシェーダーから続けて読む
+	uint32_t lightPass = AddTracedPass(graph, trace, "Light");
+	graph.Read(lightPass, depth, kResourceStatePixelShaderResource);
+	graph.Write(lightPass, color, kResourceStateRenderTarget);
+
+	uint32_t fogPass = AddTracedPass(graph, trace, "Fog");
+	graph.Read(fogPass, depth, kResourceStateNonPixelShaderResource);
+	graph.Read(fogPass, color, kResourceStatePixelShaderResource);
+	graph.Write(fogPass, backBuffer, kResourceStateRenderTarget);
+
+	graph.Compile();
+
+	ExecuteTraced(graph, trace);
+
+	std::vector<RecordedBarrier> transitions = trace.GetTransitions(depth);
+
+	//一時リソースは前のフレームの最後の状態から始まるので、最初の書き込みの前にも遷移がある
+	CHECK(graph.GetInitialState(depth) == (kResourceStatePixelShaderResource | kResourceStateNonPixelShaderResource));
+
+	REQUIRE(transitions.size() == 2);
+	CHECK(transitions[0].passesBefore == 0);
+	CHECK(transitions[0].barrier.stateAfter == kResourceStateDepthWrite);
+
+	//書き込みの後の1回だけで、2つの読み込みの状態をまとめたものにする
+	CHECK(transitions[1].passesBefore == 1);
+	CHECK(transitions[1].barrier.stateBefore == kResourceStateDepthWrite);
+	CHECK(transitions[1].barrier.stateAfter == (kResourceStatePixelShaderResource | kResourceStateNonPixelShaderResource));
+
+}
+
+TEST_CASE(SplitBarriersSpanIdlePasses) {
+
+	RenderGraph graph;
+
+	ExecutionTrace trace;
+
+	uint32_t backBuffer = graph.ImportResource("BackBuffer", kResourceStatePresent, kResourceStatePresent);
+
+	uint32_t shadow = graph.CreateTexture("Shadow", kTextureDesc);
+	uint32_t color = graph.CreateTexture("Color", kTextureDesc);
+
+	uint32_t shadowPass = AddTracedPass(graph, trace, "Shadow");
+	graph.Write(shadowPass, shadow, kResourceStateDepthWrite);
+
+	//影を使わないパスが2つ挟まる
+	uint32_t colorPass = AddTracedPass(graph, trace, "Color");
+	graph.Write(colorPass, color, kResourceStateRenderTarget);
+
+	uint32_t computePass = AddTracedPass(graph, trace, "Compute");
+	graph.SetSideEffect(computePass);
+
+	uint32_t lightPass = AddTracedPass(graph, trace, "Light");
+	graph.Read(lightPass, shadow, kResourceStatePixelShaderResource);
+	graph.Read(lightPass, color, kResourceStatePixelShaderResource);
+	graph.Write(lightPass, backBuffer, kResourceStateRenderTarget);
+
+	graph.Compile();
+
+	ExecuteTraced(graph, trace);
+
+	CHECK((trace.passes == std::vector<std::string>{ "Shadow", "Color", "Compute", "Light" }));
+
+	std::vector<RecordedBarrier> shadowTransitions = trace.GetTransitions(shadow);
+
+	//フレームの最初の遷移、書いた直後の開始、読む直前の終了
+	REQUIRE(shadowTransitions.size() == 3);
+
+	const RecordedBarrier& begin = shadowTransitions[1];
+	const RecordedBarrier& end = shadowTransitions[2];
+
+	CHECK(begin.barrier.flag == RenderGraphBarrierFlag::kBeginOnly);
+	CHECK(begin.passesBefore == 1);
+	CHECK(end.barrier.flag == RenderGraphBarrierFlag::kEndOnly);
+	CHECK(end.passesBefore == 3);
+
+	//開始と終了は同じ遷移
+	CHECK(begin.barrier.stateBefore == kResourceStateDepthWrite);
+	CHECK(begin.barrier.stateAfter == kResourceStatePixelShaderResource);
+	CHECK(end.barrier.stateBefore == begin.barrier.stateBefore);
+	CHECK(end.barrier.stateAfter == begin.barrier.stateAfter);
+
+	//開始は次のパスの前のバリアと同じまとまりで送る
+	bool isBatchedWithColor = false;
+
+	for (const RecordedBarrier& recorded : trace.GetTransitions(color)) {
+		if (recorded.batch == begin.batch) {
+			isBatchedWithColor = true;
+		}
+	}
+
+	CHECK(isBatchedWithColor);
+
+	CHECK(trace.batchCount == graph.GetBarrierBatchCount());
+	CHECK(trace.barriers.size() >= graph.GetBarrierCount());
+
+}
+
+TEST_CASE(AdjacentUsesUseWholeBarriers) {
+
+	RenderGraph graph;
+
+	ExecutionTrace trace;
+
+	uint32_t backBuffer = graph.ImportResource("BackBuffer", kResourceStatePresent, kResourceStatePresent);
+
+	uint32_t color = graph.CreateTexture("Color", kTextureDesc);
+
+	uint32_t colorPass = AddTracedPass(graph, trace, "Color");
+	graph.Write(colorPass, color, kResourceStateRenderTarget);
+
+	uint32_t presentPass = AddTracedPass(graph, trace, "Present");
+	graph.Read(presentPass, color, kResourceStatePixelShaderResource);
+	graph.Write(presentPass, backBuffer, kResourceStateRenderTarget);
+
+	graph.Compile();
+
+	ExecuteTraced(graph, trace);
+
+	for (const RecordedBarrier& recorded : trace.barriers) {
+		CHECK(recorded.barrier.flag == RenderGraphBarrierFlag::kNone);
+	}
+
+}
+
+TEST_CASE(OverlappingLifetimesGetSeparateMemory) {
+
+	RenderGraph graph;
+
+	ExecutionTrace trace;
+
+	uint32_t backBuffer = graph.ImportResource("BackBuffer", kResourceStatePresent, kResourceStatePresent);
+
+	uint32_t a = graph.CreateTexture("A", kTextureDesc);
+	uint32_t b = graph.CreateTexture("B", kTextureDesc);
+	uint32_t c = graph.CreateTexture("C", kTextureDesc);
+
+	uint32_t pass0 = AddTracedPass(graph, trace, "P0");
+	graph.Write(pass0, a, kResourceStateRenderTarget);
+
+	uint32_t pass1 = AddTracedPass(graph, trace, "P1");
+	graph.Read(pass1, a, kResourceStatePixelShaderResource);
+	graph.Write(pass1, b, kResourceStateRenderTarget);
+
+	uint32_t pass2 = AddTracedPass(graph, trace, "P2");
+	graph.Read(pass2, b, kResourceStatePixelShaderResource);
+	graph.Write(pass2, c, kResourceStateRenderTarget);
+
+	//Aを最後まで使うので3つとも寿命が重なる
+	uint32_t pass3 = AddTracedPass(graph, trace, "P3");
+	graph.Read(pass3, a, kResourceStatePixelShaderResource);
+	graph.Read(pass3, c, kResourceStatePixelShaderResource);
+	graph.Write(pass3, backBuffer, kResourceStateRenderTarget);
+
+	graph.Compile();
+
+	CHECK(!IsMemoryOverlapped(graph, a, b));
+	CHECK(!IsMemoryOverlapped(graph, a, c));
+	CHECK(!IsMemoryOverlapped(graph, b, c));
+
+	//1000バイトを256でそろえて並べる
+	CHECK(graph.GetTransientHeapSize() == 1024 * 2 + 1000);
+
+	ExecuteTraced(graph, trace);
+
+	for (const RecordedBarrier& recorded : trace.barriers) {
+		CHECK(recorded.barrier.type != RenderGraphBarrierType::kAliasing);
+	}
+
+}
+
+TEST_CASE(DisjointLifetimesShareMemory) {
+
+	RenderGraph graph;
+
+	ExecutionTrace trace;
+
+	uint32_t backBuffer = graph.ImportResource("BackBuffer", kResourceStatePresent, kResourceStatePresent);
+
+	//T0 -> T1 -> T2 -> T3と1つ前だけを読むので、1つおきに同じメモリを使える
+	uint32_t textures[4];
+
+	for (int i = 0; i < 4; ++i) {
+		textures[i] = graph.CreateTexture("T" + std::to_string(i), kTextureDesc);
+	}
+
+	uint32_t pass = AddTracedPass(graph, trace, "P0");
+	graph.Write(pass, textures[0], kResourceStateRenderTarget);
+
+	for (int i = 1; i < 4; ++i) {
+		pass = AddTracedPass(graph, trace, "P" + std::to_string(i));
+		graph.Read(pass, textures[i - 1], kResourceStatePixelShaderResource);
+		graph.Write(pass, textures[i], kResourceStateRenderTarget);
+	}
+
+	pass = AddTracedPass(graph, trace, "Present");
+	graph.Read(pass, textures[3], kResourceStatePixelShaderResource);
+	graph.Write(pass, backBuffer, kResourceStateRenderTarget);
+
+	graph.Compile();
+
+	CHECK(graph.GetHeapOffset(textures[0]) == graph.GetHeapOffset(textures[2]));
+	CHECK(graph.GetHeapOffset(textures[1]) == graph.GetHeapOffset(textures[3]));
+	CHECK(!IsMemoryOverlapped(graph, textures[0], textures[1]));
+	CHECK(graph.GetTransientHeapSize() == 1024 + 1000);
+
+	ExecuteTraced(graph, trace);
+
+	//T2はT0のメモリを引き継ぐので、最初に使う前にエイリアシングバリアを送る
+	bool hasAliasing = false;
+
+	for (const RecordedBarrier& recorded : trace.barriers) {
+
+		if (recorded.barrier.type != RenderGraphBarrierType::kAliasing || recorded.barrier.resource != textures[2]) {
+			continue;
+		}
+
+		hasAliasing = true;
+
+		CHECK(recorded.barrier.aliasBefore == textures[0]);
+		CHECK(recorded.passesBefore == 2);
+
+	}
+
+	CHECK(hasAliasing);
+
+}
+
+TEST_CASE(RandomGraphsNeverAliasLiveResources) {
+
+	std::mt19937 random(31);
+
+	for (int graphIndex = 0; graphIndex < 200; ++graphIndex) {
+
+		RenderGraph graph;
+
+		uint32_t passCount = 2 + random() % 12;
+		uint32_t textureCount = 1 + random() % 10;
+
+		std::vector<uint32_t> textures(textureCount);
+
+		for (uint32_t i = 0; i < textureCount; ++i) {
+			uint64_t alignment = 1ull << (8 + random() % 4);
+			textures[i] = graph.CreateTexture("T", { 16, 16, 0, 100 + random() % 5000, alignment });
+		}
+
+		//パスの並びでの最初と最後の使用を自分で数える(すべて副作用ありにして消さない)
+		std::vector<int> firstUse(textureCount, -1);
+		std::vector<int> lastUse(textureCount, -1);
+
+		for (uint32_t p = 0; p < passCount; ++p) {
+
+			uint32_t pass = graph.AddPass("P", nullptr);
+
+			graph.SetSideEffect(pass);
+
+			uint32_t accessCount = random() % 3;
+
+			for (uint32_t k = 0; k < accessCount; ++k) {
+
+				uint32_t texture = random() % textureCount;
+
+				if (random() % 2 == 0) {
+					graph.Write(pass, textures[texture], kResourceStateRenderTarget);
+				} else {
+					graph.Read(pass, textures[texture], kResourceStatePixelShaderResource);
+				}
+
+				if (firstUse[texture] < 0) {
+					firstUse[texture] = p;
+				}
+
+				lastUse[texture] = p;
+
+			}
+
+		}
+
+		graph.Compile();
+
+		for (uint32_t i = 0; i < textureCount; ++i) {
+
+			if (firstUse[i] < 0) {
+				continue;
+			}
+
+			const RenderGraphTextureDesc& desc = graph.GetTextureDesc(textures[i]);
+
+			CHECK(graph.GetHeapOffset(textures[i]) % desc.alignment == 0);
+			CHECK(graph.GetHeapOffset(textures[i]) + desc.size <= graph.GetTransientHeapSize());
+
+			for (uint32_t j = i + 1; j < textureCount; ++j) {
+
+				if (firstUse[j] < 0) {
+					continue;
+				}
+
+				bool isLifetimeOverlapped = firstUse[i] <= lastUse[j] && firstUse[j] <= lastUse[i];
+
+				if (isLifetimeOverlapped) {
+					CHECK(!IsMemoryOverlapped(graph, textures[i], textures[j]));
+				}
+
+			}
+
+		}
+
+	}
+
+}
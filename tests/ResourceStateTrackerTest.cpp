@@ -0,0 +1,266 @@
+#include "TestFramework.h"
+#include "ResourceStateTracker.h"
+#include "RenderGraph.h"
+#include <vector>
+
+namespace {
+
+	//ResourceBarrierをまとめごとに記録するコマンドリスト
+	struct MockCommandList : ID3D12GraphicsCommandList {
+
+		std::vector<std::vector<D3D12_RESOURCE_BARRIER>> batches;
+
+		uint32_t drawCount = 0;
+
+		void ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER* barriers) override {
+			batches.emplace_back(barriers, barriers + numBarriers);
+		}
+
+		void DrawInstanced(UINT, UINT, UINT, UINT) override {
+			drawCount++;
+		}
+
+	};
+
+	bool IsTransition(const D3D12_RESOURCE_BARRIER& barrier, ID3D12Resource* resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after, D3D12_RESOURCE_BARRIER_FLAGS flags) {
+		return barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && barrier.Flags == flags && barrier.Transition.pResource == resource &&
+			barrier.Transition.StateBefore == before && barrier.Transition.StateAfter == after;
+	}
+
+	//main.cppのSubmitRenderGraphBarriersと同じ渡し方
+	void SubmitBarriers(ResourceStateTracker& tracker, ID3D12Resource* const* resources, const RenderGraphBarrier* barriers, size_t count) {
+
+		for (size_t i = 0; i < count; ++i) {
+
+			if (barriers[i].type == RenderGraphBarrierType::kAliasing) {
+				tracker.AliasingBarrier(barriers[i].aliasBefore != RenderGraph::kInvalidResource ? resources[barriers[i].aliasBefore] : nullptr, resources[barriers[i].resource]);
+				continue;
+			}
+
+			D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+
+			if (barriers[i].flag == RenderGraphBarrierFlag::kBeginOnly) {
+				flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+			} else if (barriers[i].flag == RenderGraphBarrierFlag::kEndOnly) {
+				flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+			}
+
+			tracker.TransitionResource(resources[barriers[i].resource], static_cast<D3D12_RESOURCE_STATES>(barriers[i].stateBefore),
+				static_cast<D3D12_RESOURCE_STATES>(barriers[i].stateAfter), flags);
+
+		}
+
+		tracker.FlushBarriers();
+
+	}
+
+}
+
+TEST_CASE(FirstUseResolvesAgainstTable) {
+
+	MockCommandList commandList;
+	MockCommandList barrierCommandList;
+	ID3D12Resource resource;
+
+	ResourceStateTable table;
+	table.Register(&resource, D3D12_RESOURCE_STATE_COPY_DEST);
+
+	ResourceStateTracker tracker;
+	tracker.Initialize(&commandList);
+
+	tracker.TransitionResource(&resource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.DrawInstanced(3, 1, 0, 0);
+
+	//最初の遷移は記録中には積まない
+	CHECK(commandList.batches.empty());
+	CHECK(commandList.drawCount == 1);
+
+	CHECK(tracker.ResolvePendingBarriers(table, &barrierCommandList) == 1);
+	REQUIRE(barrierCommandList.batches.size() == 1);
+	CHECK(IsTransition(barrierCommandList.batches[0][0], &resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_NONE));
+
+	std::lock_guard<std::mutex> lock(table.GetMutex());
+	CHECK(table.Get(&resource) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+}
+
+TEST_CASE(TransitionsMergeAndCancel) {
+
+	MockCommandList commandList;
+	ID3D12Resource a;
+	ID3D12Resource b;
+
+	ResourceStateTracker tracker;
+	tracker.Initialize(&commandList);
+
+	tracker.TransitionResource(&a, D3D12_RESOURCE_STATE_COMMON);
+	tracker.TransitionResource(&b, D3D12_RESOURCE_STATE_COMMON);
+
+	//aはCOMMON→COPY_DEST→PIXEL_SHADER_RESOURCEを1つにまとめ、bは行って戻るので消える
+	tracker.TransitionResource(&a, D3D12_RESOURCE_STATE_COPY_DEST);
+	tracker.TransitionResource(&b, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	tracker.TransitionResource(&a, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.TransitionResource(&b, D3D12_RESOURCE_STATE_COMMON);
+	tracker.TransitionResource(&a, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	tracker.FlushBarriers();
+
+	REQUIRE(commandList.batches.size() == 1);
+	REQUIRE(commandList.batches[0].size() == 1);
+	CHECK(IsTransition(commandList.batches[0][0], &a, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_NONE));
+	CHECK(tracker.GetFlushCount() == 1);
+
+	//空ならResourceBarrierを呼ばない
+	tracker.FlushBarriers();
+	CHECK(commandList.batches.size() == 1);
+
+}
+
+TEST_CASE(SplitBarrierOnTrackedResource) {
+
+	MockCommandList commandList;
+	ID3D12Resource resource;
+
+	ResourceStateTracker tracker;
+	tracker.Initialize(&commandList);
+
+	tracker.TransitionResource(&resource, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	tracker.TransitionResource(&resource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+	tracker.FlushBarriers();
+	tracker.TransitionResource(&resource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+	tracker.FlushBarriers();
+
+	REQUIRE(commandList.batches.size() == 2);
+	CHECK(IsTransition(commandList.batches[0][0], &resource, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY));
+	CHECK(IsTransition(commandList.batches[1][0], &resource, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+
+}
+
+TEST_CASE(SplitBeginOnUntrackedResourceWithoutStateBefore) {
+
+	MockCommandList commandList;
+	MockCommandList barrierCommandList;
+	ID3D12Resource resource;
+
+	ResourceStateTable table;
+	table.Register(&resource, D3D12_RESOURCE_STATE_COMMON);
+
+	ResourceStateTracker tracker;
+	tracker.Initialize(&commandList);
+
+	//遷移前の状態がわからないので分割せず、最初の使用として実行直前に遷移させる
+	tracker.TransitionResource(&resource, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+	tracker.FlushBarriers();
+	tracker.TransitionResource(&resource, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+	tracker.FlushBarriers();
+
+	CHECK(commandList.batches.empty());
+
+	CHECK(tracker.ResolvePendingBarriers(table, &barrierCommandList) == 1);
+	REQUIRE(barrierCommandList.batches.size() == 1);
+	CHECK(IsTransition(barrierCommandList.batches[0][0], &resource, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_BARRIER_FLAG_NONE));
+
+}
+
+TEST_CASE(SplitEndWithoutBeginBecomesFullBarrier) {
+
+	MockCommandList commandList;
+	ID3D12Resource resource;
+
+	ResourceStateTracker tracker;
+	tracker.Initialize(&commandList);
+
+	tracker.TransitionResource(&resource, D3D12_RESOURCE_STATE_COPY_DEST);
+	tracker.TransitionResource(&resource, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+	tracker.FlushBarriers();
+
+	REQUIRE(commandList.batches.size() == 1);
+	CHECK(IsTransition(commandList.batches[0][0], &resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_BARRIER_FLAG_NONE));
+
+}
+
+TEST_CASE(SplitBeginSeededFromStateBefore) {
+
+	MockCommandList commandList;
+	MockCommandList barrierCommandList;
+	ID3D12Resource resource;
+
+	ResourceStateTable table;
+	table.Register(&resource, D3D12_RESOURCE_STATE_COMMON);
+
+	ResourceStateTracker tracker;
+	tracker.Initialize(&commandList);
+
+	//前のパスでRENDER_TARGETとして(遷移なしで)使い、分割バリアの開始から追いかけ始める
+	tracker.TransitionResource(&resource, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+	tracker.FlushBarriers();
+	tracker.TransitionResource(&resource, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+	tracker.FlushBarriers();
+
+	REQUIRE(commandList.batches.size() == 2);
+	CHECK(IsTransition(commandList.batches[0][0], &resource, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY));
+	CHECK(IsTransition(commandList.batches[1][0], &resource, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+
+	//リストの最初はstateBeforeにしておく
+	CHECK(tracker.ResolvePendingBarriers(table, &barrierCommandList) == 1);
+	REQUIRE(barrierCommandList.batches.size() == 1);
+	CHECK(IsTransition(barrierCommandList.batches[0][0], &resource, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_BARRIER_FLAG_NONE));
+
+	std::lock_guard<std::mutex> lock(table.GetMutex());
+	CHECK(table.Get(&resource) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+}
+
+TEST_CASE(RenderGraphSplitBarrierOnFirstUse) {
+
+	RenderGraph renderGraph;
+
+	//最初のパスでは初期状態のまま書くのでバリアがなく、1つ空けて読むので分割バリアになる
+	uint32_t texture = renderGraph.ImportResource("Texture", kResourceStateRenderTarget, kResourceStateRenderTarget);
+	uint32_t other = renderGraph.ImportResource("Other", kResourceStateRenderTarget, kResourceStateRenderTarget);
+
+	uint32_t write = renderGraph.AddPass("Write", []() {});
+	renderGraph.Write(write, texture, kResourceStateRenderTarget);
+
+	uint32_t middle = renderGraph.AddPass("Middle", []() {});
+	renderGraph.Write(middle, other, kResourceStateRenderTarget);
+	renderGraph.SetSideEffect(middle);
+
+	uint32_t read = renderGraph.AddPass("Read", []() {});
+	renderGraph.Read(read, texture, kResourceStatePixelShaderResource);
+	renderGraph.Write(read, other, kResourceStateRenderTarget);
+
+	renderGraph.Compile();
+
+	MockCommandList commandList;
+	MockCommandList barrierCommandList;
+	ID3D12Resource textureResource;
+	ID3D12Resource otherResource;
+	ID3D12Resource* resources[] = { &textureResource, &otherResource };
+
+	ResourceStateTable table;
+	table.Register(&textureResource, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	table.Register(&otherResource, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+	ResourceStateTracker tracker;
+	tracker.Initialize(&commandList);
+
+	renderGraph.Execute([&](const RenderGraphBarrier* barriers, size_t count) {
+		SubmitBarriers(tracker, resources, barriers, count);
+	});
+
+	//開始と終了、最後に戻す遷移が記録中に積まれる
+	std::vector<D3D12_RESOURCE_BARRIER> recorded;
+	for (const std::vector<D3D12_RESOURCE_BARRIER>& batch : commandList.batches) {
+		recorded.insert(recorded.end(), batch.begin(), batch.end());
+	}
+
+	REQUIRE(recorded.size() == 3);
+	CHECK(IsTransition(recorded[0], &textureResource, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY));
+	CHECK(IsTransition(recorded[1], &textureResource, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+	CHECK(IsTransition(recorded[2], &textureResource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_BARRIER_FLAG_NONE));
+
+	//表と同じ状態から始まるので実行直前の遷移はない
+	CHECK(tracker.ResolvePendingBarriers(table, &barrierCommandList) == 0);
+	CHECK(barrierCommandList.batches.empty());
+
+}
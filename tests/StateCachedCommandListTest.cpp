@@ -0,0 +1,239 @@
+#include "TestFramework.h"
+#include "StateCachedCommandList.h"
+#include <cstring>
+
+namespace {
+
+	const D3D12_VIEWPORT kViewport = { 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f };
+	const D3D12_RECT kScissorRect = { 0, 0, 1280, 720 };
+
+	//main.cppの1回の描画と同じ順に設定する
+	void SetDrawState(StateCachedCommandList& commandList, ID3D12DescriptorHeap* heap, ID3D12RootSignature* rootSignature, ID3D12PipelineState* pipelineState) {
+
+		ID3D12DescriptorHeap* heaps[] = { heap };
+
+		D3D12_VERTEX_BUFFER_VIEW vertexBufferView = { 0x1000, 256, 32 };
+		D3D12_INDEX_BUFFER_VIEW indexBufferView = { 0x2000, 64, DXGI_FORMAT_R32_FLOAT };
+
+		commandList.SetDescriptorHeaps(1, heaps);
+		commandList.RSSetViewports(1, &kViewport);
+		commandList.RSSetScissorRects(1, &kScissorRect);
+		commandList.SetGraphicsRootSignature(rootSignature);
+		commandList.SetPipelineState(pipelineState);
+		commandList.IASetVertexBuffers(0, 1, &vertexBufferView);
+		commandList.IASetIndexBuffer(&indexBufferView);
+		commandList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		commandList.SetGraphicsRootShaderResourceView(1, 0x3000);
+		commandList.SetGraphicsRootDescriptorTable(3, { 0x4000 });
+
+	}
+
+}
+
+TEST_CASE(RedundantStateIsSkipped) {
+
+	RecordingGraphicsCommandSink sink;
+
+	StateCachedCommandList commandList;
+	commandList.Initialize(&sink);
+
+	ID3D12DescriptorHeap heap;
+	ID3D12RootSignature rootSignature;
+	ID3D12PipelineState pipelineState;
+
+	SetDrawState(commandList, &heap, &rootSignature, &pipelineState);
+	CHECK(sink.GetCommands().size() == 10);
+	CHECK(commandList.GetIssuedCount() == 10);
+
+	//2回目はすべて省かれる
+	SetDrawState(commandList, &heap, &rootSignature, &pipelineState);
+	CHECK(sink.GetCommands().size() == 10);
+	CHECK(commandList.GetSkippedCount() == 10);
+
+	const RecordedGraphicsCommand& viewport = sink.GetCommands()[1];
+	CHECK(viewport.type == GraphicsCommandType::kRSSetViewports);
+	CHECK(viewport.count == 1);
+	CHECK(viewport.data.size() == sizeof(D3D12_VIEWPORT) && std::memcmp(viewport.data.data(), &kViewport, sizeof(kViewport)) == 0);
+
+	CHECK(sink.GetCommands()[4].type == GraphicsCommandType::kSetPipelineState);
+	CHECK(sink.GetCommands()[4].value == reinterpret_cast<uintptr_t>(&pipelineState));
+
+}
+
+TEST_CASE(PipelineChangeIssuesOnlyPipeline) {
+
+	RecordingGraphicsCommandSink sink;
+
+	StateCachedCommandList commandList;
+	commandList.Initialize(&sink);
+
+	ID3D12DescriptorHeap heap;
+	ID3D12RootSignature rootSignature;
+	ID3D12PipelineState a;
+	ID3D12PipelineState b;
+
+	SetDrawState(commandList, &heap, &rootSignature, &a);
+	sink.Clear();
+
+	SetDrawState(commandList, &heap, &rootSignature, &b);
+
+	REQUIRE(sink.GetCommands().size() == 1);
+	CHECK(sink.GetCommands()[0].type == GraphicsCommandType::kSetPipelineState);
+	CHECK(sink.GetCommands()[0].value == reinterpret_cast<uintptr_t>(&b));
+
+}
+
+TEST_CASE(RootSignatureChangeResetsRootArguments) {
+
+	RecordingGraphicsCommandSink sink;
+
+	StateCachedCommandList commandList;
+	commandList.Initialize(&sink);
+
+	ID3D12DescriptorHeap heap;
+	ID3D12RootSignature a;
+	ID3D12RootSignature b;
+	ID3D12PipelineState pipelineState;
+
+	SetDrawState(commandList, &heap, &a, &pipelineState);
+	sink.Clear();
+
+	//ルート引数は同じ値でも積み直す
+	SetDrawState(commandList, &heap, &b, &pipelineState);
+
+	REQUIRE(sink.GetCommands().size() == 3);
+	CHECK(sink.GetCommands()[0].type == GraphicsCommandType::kSetGraphicsRootSignature);
+	CHECK(sink.GetCommands()[1].type == GraphicsCommandType::kSetGraphicsRootShaderResourceView);
+	CHECK(sink.GetCommands()[1].index == 1 && sink.GetCommands()[1].value == 0x3000);
+	CHECK(sink.GetCommands()[2].type == GraphicsCommandType::kSetGraphicsRootDescriptorTable);
+
+}
+
+TEST_CASE(DescriptorHeapChangeResetsTables) {
+
+	RecordingGraphicsCommandSink sink;
+
+	StateCachedCommandList commandList;
+	commandList.Initialize(&sink);
+
+	ID3D12DescriptorHeap a;
+	ID3D12DescriptorHeap b;
+	ID3D12RootSignature rootSignature;
+	ID3D12PipelineState pipelineState;
+
+	SetDrawState(commandList, &a, &rootSignature, &pipelineState);
+	sink.Clear();
+
+	//テーブルだけが積み直され、ルートSRVは残る
+	SetDrawState(commandList, &b, &rootSignature, &pipelineState);
+
+	REQUIRE(sink.GetCommands().size() == 2);
+	CHECK(sink.GetCommands()[0].type == GraphicsCommandType::kSetDescriptorHeaps);
+	CHECK(sink.GetCommands()[1].type == GraphicsCommandType::kSetGraphicsRootDescriptorTable);
+	CHECK(sink.GetCommands()[1].index == 3 && sink.GetCommands()[1].value == 0x4000);
+
+}
+
+TEST_CASE(RootConstantsComparePerValue) {
+
+	RecordingGraphicsCommandSink sink;
+
+	StateCachedCommandList commandList;
+	commandList.Initialize(&sink);
+
+	uint32_t constants[4] = { 1, 2, 3, 4 };
+
+	commandList.SetGraphicsRoot32BitConstants(2, 4, constants, 0);
+	commandList.SetGraphicsRoot32BitConstants(2, 4, constants, 0);
+	CHECK(sink.GetCommands().size() == 1);
+
+	//一部だけ同じ値を設定し直しても省き、違えば積む
+	commandList.SetGraphicsRoot32BitConstants(2, 2, constants + 1, 1);
+	CHECK(sink.GetCommands().size() == 1);
+
+	uint32_t changed = 7;
+	commandList.SetGraphicsRoot32BitConstants(2, 1, &changed, 3);
+	REQUIRE(sink.GetCommands().size() == 2);
+
+	const RecordedGraphicsCommand& command = sink.GetCommands()[1];
+	CHECK(command.type == GraphicsCommandType::kSetGraphicsRoot32BitConstants);
+	CHECK(command.index == 2 && command.count == 1 && command.value == 3);
+	CHECK(command.data.size() == sizeof(uint32_t) && std::memcmp(command.data.data(), &changed, sizeof(changed)) == 0);
+
+	//まだ設定していない位置は同じ値でも積む
+	commandList.SetGraphicsRoot32BitConstants(2, 1, &changed, 4);
+	CHECK(sink.GetCommands().size() == 3);
+
+}
+
+TEST_CASE(InvalidateReissuesEverything) {
+
+	RecordingGraphicsCommandSink sink;
+
+	StateCachedCommandList commandList;
+	commandList.Initialize(&sink);
+
+	ID3D12DescriptorHeap heap;
+	ID3D12RootSignature rootSignature;
+	ID3D12PipelineState pipelineState;
+
+	SetDrawState(commandList, &heap, &rootSignature, &pipelineState);
+	commandList.Invalidate();
+	SetDrawState(commandList, &heap, &rootSignature, &pipelineState);
+
+	CHECK(sink.GetCommands().size() == 20);
+
+}
+
+TEST_CASE(VertexBufferSlotsCompareIndividually) {
+
+	RecordingGraphicsCommandSink sink;
+
+	StateCachedCommandList commandList;
+	commandList.Initialize(&sink);
+
+	D3D12_VERTEX_BUFFER_VIEW views[2] = { { 0x1000, 256, 32 }, { 0x2000, 128, 16 } };
+
+	commandList.IASetVertexBuffers(0, 2, views);
+	commandList.IASetVertexBuffers(1, 1, &views[1]);
+	CHECK(sink.GetCommands().size() == 1);
+
+	//設定していないスロットを含めば積む
+	commandList.IASetVertexBuffers(1, 2, views);
+	REQUIRE(sink.GetCommands().size() == 2);
+	CHECK(sink.GetCommands()[1].index == 1 && sink.GetCommands()[1].count == 2);
+
+}
+
+TEST_CASE(D3D12SinkForwardsToCommandList) {
+
+	struct MockCommandList : ID3D12GraphicsCommandList {
+
+		ID3D12PipelineState* pipelineState = nullptr;
+
+		uint32_t callCount = 0;
+
+		void SetPipelineState(ID3D12PipelineState* state) override {
+			pipelineState = state;
+			callCount++;
+		}
+
+	};
+
+	MockCommandList mock;
+
+	D3D12GraphicsCommandSink sink;
+	sink.Initialize(&mock);
+
+	StateCachedCommandList commandList;
+	commandList.Initialize(&sink);
+
+	ID3D12PipelineState pipelineState;
+
+	commandList.SetPipelineState(&pipelineState);
+	commandList.SetPipelineState(&pipelineState);
+
+	CHECK(mock.pipelineState == &pipelineState);
+	CHECK(mock.callCount == 1);
+
+}
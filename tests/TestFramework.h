@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdio>
+#include <vector>
+
+//テストの小さな仕組み
+//TEST_CASEで登録した関数をTestMain.cppのmainが順に呼ぶ
+//CHECKはassertと違いNDEBUGでも消えない(中で呼んだ関数も必ず実行される)
+
+struct TestCase {
+	const char* name;
+	void (*function)();
+};
+
+inline std::vector<TestCase>& GetTestCases() {
+	static std::vector<TestCase> testCases;
+	return testCases;
+}
+
+inline int& GetTestFailureCount() {
+	static int failureCount = 0;
+	return failureCount;
+}
+
+inline void ReportTestFailure(const char* file, int line, const char* expression) {
+	std::printf("%s:%d: CHECK failed: %s\n", file, line, expression);
+	++GetTestFailureCount();
+}
+
+struct TestRegistrar {
+	TestRegistrar(const char* name, void (*function)()) {
+		GetTestCases().push_back({ name, function });
+	}
+};
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static TestRegistrar name##Registrar(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			ReportTestFailure(__FILE__, __LINE__, #condition); \
+		} \
+	} while (0)
+
+//失敗したらそのテストを打ち切る(続けると壊れたデータを触る時に使う)
+#define REQUIRE(condition) \
+	do { \
+		if (!(condition)) { \
+			ReportTestFailure(__FILE__, __LINE__, #condition); \
+			return; \
+		} \
+	} while (0)
@@ -0,0 +1,31 @@
+#include "TestFramework.h"
+#include <cstring>
+
+//引数を渡すと名前にそれを含むテストだけを動かす
+int main(int argc, char** argv) {
+
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+
+	int runCount = 0;
+
+	for (const TestCase& testCase : GetTestCases()) {
+
+		if (filter != nullptr && std::strstr(testCase.name, filter) == nullptr) {
+			continue;
+		}
+
+		int failureCount = GetTestFailureCount();
+
+		testCase.function();
+
+		std::printf("[%s] %s\n", GetTestFailureCount() == failureCount ? "  OK  " : "FAILED", testCase.name);
+
+		++runCount;
+
+	}
+
+	std::printf("%d tests, %d failures\n", runCount, GetTestFailureCount());
+
+	return GetTestFailureCount() == 0 ? 0 : 1;
+
+}
@@ -0,0 +1,280 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <vector>
+#include "MeshImporter.h"
+
+//テストとベンチマークで使う形と行列
+
+//半径1の緯度経度の球(縫い目の頂点は共有しない)
+inline MeshData MakeSphereMesh(uint32_t rings) {
+
+	MeshData mesh;
+
+	uint32_t segments = rings * 2;
+
+	const float kPi = 3.14159265f;
+
+	for (uint32_t i = 0; i <= rings; ++i) {
+		for (uint32_t j = 0; j <= segments; ++j) {
+
+			float theta = kPi * i / rings;
+			float phi = kPi * j / rings;
+
+			Vector3 normal = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+
+			mesh.vertices.push_back({ { normal.x, normal.y, normal.z, 1.0f }, normal, { float(j) / segments, float(i) / rings } });
+
+		}
+	}
+
+	uint32_t width = segments + 1;
+
+	for (uint32_t i = 0; i < rings; ++i) {
+		for (uint32_t j = 0; j < segments; ++j) {
+
+			uint32_t a = i * width + j;
+			uint32_t b = a + 1;
+			uint32_t c = a + width;
+			uint32_t d = c + 1;
+
+			//外から見て時計回り(左手系の表)
+			mesh.indices.insert(mesh.indices.end(), { a, b, c, b, d, c });
+
+		}
+	}
+
+	mesh.bounds = { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } };
+
+	return mesh;
+
+}
+
+//XZ平面の[0, size]の格子(縁が開いている)
+inline MeshData MakeGridMesh(uint32_t size) {
+
+	MeshData mesh;
+
+	for (uint32_t z = 0; z <= size; ++z) {
+		for (uint32_t x = 0; x <= size; ++x) {
+			mesh.vertices.push_back({ { float(x), 0.0f, float(z), 1.0f }, { 0.0f, 1.0f, 0.0f }, { float(x) / size, float(z) / size } });
+		}
+	}
+
+	for (uint32_t z = 0; z < size; ++z) {
+		for (uint32_t x = 0; x < size; ++x) {
+
+			uint32_t a = z * (size + 1) + x;
+			uint32_t b = a + 1;
+			uint32_t c = a + size + 1;
+			uint32_t d = c + 1;
+
+			mesh.indices.insert(mesh.indices.end(), { a, c, b, b, c, d });
+
+		}
+	}
+
+	mesh.bounds = { { 0.0f, 0.0f, 0.0f }, { float(size), 0.0f, float(size) } };
+
+	return mesh;
+
+}
+
+//半径1の閉じた緯度経度の球(極に面積0の三角形を作らない。縫い目と極の頂点はUVだけ違う同じ位置で複製する)
+inline MeshData MakeClosedSphereMesh(uint32_t segments, uint32_t rings) {
+
+	MeshData mesh;
+
+	const float kPi = 3.14159265f;
+
+	for (uint32_t i = 0; i <= rings; ++i) {
+		for (uint32_t j = 0; j <= segments; ++j) {
+
+			float theta = kPi * i / rings;
+			float phi = j == segments ? 0.0f : 2.0f * kPi * j / segments;
+
+			Vector3 normal = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+
+			//極は位置がそろうようにちょうどの値にする
+			if (i == 0 || i == rings) {
+				normal = { 0.0f, i == 0 ? 1.0f : -1.0f, 0.0f };
+			}
+
+			mesh.vertices.push_back({ { normal.x, normal.y, normal.z, 1.0f }, normal, { float(j) / segments, float(i) / rings } });
+
+		}
+	}
+
+	uint32_t width = segments + 1;
+
+	for (uint32_t i = 0; i < rings; ++i) {
+		for (uint32_t j = 0; j < segments; ++j) {
+
+			uint32_t a = i * width + j;
+			uint32_t b = a + 1;
+			uint32_t c = a + width;
+			uint32_t d = c + 1;
+
+			//外から見て時計回り
+			if (i != 0) {
+				mesh.indices.insert(mesh.indices.end(), { a, b, c });
+			}
+
+			if (i != rings - 1) {
+				mesh.indices.insert(mesh.indices.end(), { b, d, c });
+			}
+
+		}
+	}
+
+	mesh.bounds = { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } };
+
+	return mesh;
+
+}
+
+//位置で頂点をまとめて数えた辺の使われ方(UVの継ぎ目で分かれた頂点も1つとみなす)
+struct MeshEdgeCounts {
+
+	//1つの三角形にしか使われていない辺
+	size_t openEdgeCount;
+
+	//3つ以上の三角形に使われている辺
+	size_t nonManifoldEdgeCount;
+
+};
+
+inline MeshEdgeCounts CountMeshEdges(const std::vector<MeshVertex>& vertices, const uint32_t* indices, size_t indexCount) {
+
+	std::map<std::tuple<float, float, float>, uint32_t> positionIds;
+
+	auto getPositionId = [&](uint32_t index) {
+		const Vector4& position = vertices[index].position;
+		return positionIds.emplace(std::make_tuple(position.x, position.y, position.z), static_cast<uint32_t>(positionIds.size())).first->second;
+	};
+
+	std::map<std::pair<uint32_t, uint32_t>, uint32_t> edgeUseCounts;
+
+	for (size_t i = 0; i + 2 < indexCount; i += 3) {
+
+		uint32_t corners[3] = { getPositionId(indices[i]), getPositionId(indices[i + 1]), getPositionId(indices[i + 2]) };
+
+		for (int k = 0; k < 3; ++k) {
+			uint32_t a = corners[k];
+			uint32_t b = corners[(k + 1) % 3];
+			edgeUseCounts[{ (std::min)(a, b), (std::max)(a, b) }]++;
+		}
+
+	}
+
+	MeshEdgeCounts counts = {};
+
+	for (const auto& [edge, useCount] : edgeUseCounts) {
+		if (useCount == 1) {
+			counts.openEdgeCount++;
+		} else if (useCount > 2) {
+			counts.nonManifoldEdgeCount++;
+		}
+	}
+
+	return counts;
+
+}
+
+//三角形の集合を比べるために、頂点の巡回を保ったまま最小の頂点から始まる形にそろえて並べる
+inline std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> MakeTriangleSet(const uint32_t* indices, size_t indexCount) {
+
+	std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> triangles;
+
+	for (size_t i = 0; i + 2 < indexCount; i += 3) {
+
+		uint32_t a = indices[i];
+		uint32_t b = indices[i + 1];
+		uint32_t c = indices[i + 2];
+
+		if (b < a && b < c) {
+			triangles.emplace_back(b, c, a);
+		} else if (c < a && c < b) {
+			triangles.emplace_back(c, a, b);
+		} else {
+			triangles.emplace_back(a, b, c);
+		}
+
+	}
+
+	std::sort(triangles.begin(), triangles.end());
+
+	return triangles;
+
+}
+
+inline Matrix4x4 MultiplyMatrix(const Matrix4x4& a, const Matrix4x4& b) {
+
+	Matrix4x4 result{};
+
+	for (int i = 0; i < 4; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			for (int k = 0; k < 4; ++k) {
+				result.m[i][j] += a.m[i][k] * b.m[k][j];
+			}
+		}
+	}
+
+	return result;
+
+}
+
+//main.cppのMakePerspectiveFovMatrixと同じreversed-Zの射影(左手系、手前ほど深度が大きい)
+inline Matrix4x4 MakeTestPerspectiveMatrix(float fovY, float aspectRatio, float nearClip, float farClip) {
+
+	Matrix4x4 result{};
+
+	float cot = 1.0f / std::tan(fovY / 2.0f);
+
+	result.m[0][0] = cot / aspectRatio;
+	result.m[1][1] = cot;
+	result.m[2][2] = nearClip / (nearClip - farClip);
+	result.m[2][3] = 1.0f;
+	result.m[3][2] = -farClip * nearClip / (nearClip - farClip);
+
+	return result;
+
+}
+
+//eyeからtargetを見るビュー行列(左手系、上はY)
+inline Matrix4x4 MakeTestLookAtMatrix(const Vector3& eye, const Vector3& target) {
+
+	Vector3 forward = { target.x - eye.x, target.y - eye.y, target.z - eye.z };
+
+	float length = std::sqrt(forward.x * forward.x + forward.y * forward.y + forward.z * forward.z);
+	forward = { forward.x / length, forward.y / length, forward.z / length };
+
+	Vector3 right = { forward.z, 0.0f, -forward.x };
+
+	length = std::sqrt(right.x * right.x + right.z * right.z);
+	right = { right.x / length, 0.0f, right.z / length };
+
+	Vector3 up = { forward.y * right.z - forward.z * right.y, forward.z * right.x - forward.x * right.z, forward.x * right.y - forward.y * right.x };
+
+	Matrix4x4 result{};
+
+	result.m[0][0] = right.x;
+	result.m[1][0] = right.y;
+	result.m[2][0] = right.z;
+	result.m[0][1] = up.x;
+	result.m[1][1] = up.y;
+	result.m[2][1] = up.z;
+	result.m[0][2] = forward.x;
+	result.m[1][2] = forward.y;
+	result.m[2][2] = forward.z;
+	result.m[3][0] = -(eye.x * right.x + eye.y * right.y + eye.z * right.z);
+	result.m[3][1] = -(eye.x * up.x + eye.y * up.y + eye.z * up.z);
+	result.m[3][2] = -(eye.x * forward.x + eye.y * forward.y + eye.z * forward.z);
+	result.m[3][3] = 1.0f;
+
+	return result;
+
+}
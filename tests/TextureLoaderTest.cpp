@@ -0,0 +1,344 @@
+#include "TestFramework.h"
+#include "TextureLoader.h"
+#include "BlockCompression.h"
+#include "MipGenerator.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+namespace {
+
+	//DDSのヘッダーの中の位置(マジックの4バイトを含む)
+	const size_t kDdsFlagsOffset = 8;
+	const size_t kDdsHeightOffset = 12;
+	const size_t kDdsWidthOffset = 16;
+	const size_t kDdsDepthOffset = 24;
+	const size_t kDdsMipMapCountOffset = 28;
+	const size_t kDdsPixelFormatFlagsOffset = 80;
+	const size_t kDdsFourCCOffset = 84;
+	const size_t kDdsCaps2Offset = 112;
+	const size_t kDdsDxgiFormatOffset = 128;
+	const size_t kDdsResourceDimensionOffset = 132;
+	const size_t kDdsMiscFlagOffset = 136;
+	const size_t kDdsArraySizeOffset = 140;
+
+	void PatchUint32(std::vector<uint8_t>& data, size_t offset, uint32_t value) {
+		std::memcpy(&data[offset], &value, sizeof(value));
+	}
+
+	void PatchUint64(std::vector<uint8_t>& data, size_t offset, uint64_t value) {
+		std::memcpy(&data[offset], &value, sizeof(value));
+	}
+
+	void FillRandom(TextureData& texture, uint32_t seed) {
+
+		std::mt19937 random(seed);
+
+		for (size_t i = 0; i < texture.mips[0].size; ++i) {
+			texture.pixels[i] = static_cast<uint8_t>(random() & 0xff);
+		}
+
+	}
+
+	//mipを全部持つ乱数の画像
+	TextureData MakeMippedTexture(TextureFormat format, uint32_t width, uint32_t height) {
+
+		TextureData texture;
+		InitializeTexture(texture, format, width, height, 1);
+
+		FillRandom(texture, width * 7 + height);
+
+		GenerateMips(texture);
+
+		return texture;
+
+	}
+
+	bool IsSameTexture(const TextureData& a, const TextureData& b) {
+
+		if (a.format != b.format || a.width != b.width || a.height != b.height || a.mips.size() != b.mips.size() || a.pixels != b.pixels) {
+			return false;
+		}
+
+		for (size_t i = 0; i < a.mips.size(); ++i) {
+			if (a.mips[i].offset != b.mips[i].offset || a.mips[i].size != b.mips[i].size || a.mips[i].width != b.mips[i].width || a.mips[i].height != b.mips[i].height) {
+				return false;
+			}
+		}
+
+		return true;
+
+	}
+
+	const uint8_t kKtx2Identifier[12] = { 0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a };
+
+	//KTX2のヘッダーの中の位置
+	const size_t kKtx2VkFormatOffset = 12;
+	const size_t kKtx2PixelDepthOffset = 28;
+	const size_t kKtx2LayerCountOffset = 32;
+	const size_t kKtx2FaceCountOffset = 36;
+	const size_t kKtx2LevelCountOffset = 40;
+	const size_t kKtx2SupercompressionOffset = 44;
+	const size_t kKtx2LevelIndexOffset = 80;
+
+	//RGBA8(VK_FORMAT_R8G8B8A8_UNORM)のKTX2。段は仕様どおり小さい順にファイルへ置き、表は大きい順に並べる
+	std::vector<uint8_t> MakeKtx2(const TextureData& texture) {
+
+		uint32_t levelCount = static_cast<uint32_t>(texture.mips.size());
+
+		std::vector<uint8_t> data(kKtx2LevelIndexOffset + 24 * levelCount, 0);
+
+		std::memcpy(data.data(), kKtx2Identifier, sizeof(kKtx2Identifier));
+
+		PatchUint32(data, kKtx2VkFormatOffset, 37);
+		PatchUint32(data, 16, 1);
+		PatchUint32(data, 20, texture.width);
+		PatchUint32(data, 24, texture.height);
+		PatchUint32(data, kKtx2FaceCountOffset, 1);
+		PatchUint32(data, kKtx2LevelCountOffset, levelCount);
+
+		for (uint32_t i = levelCount; i-- > 0;) {
+
+			const TextureMip& mip = texture.mips[i];
+
+			PatchUint64(data, kKtx2LevelIndexOffset + 24 * i, data.size());
+			PatchUint64(data, kKtx2LevelIndexOffset + 24 * i + 8, mip.size);
+			PatchUint64(data, kKtx2LevelIndexOffset + 24 * i + 16, mip.size);
+
+			data.insert(data.end(), texture.pixels.begin() + mip.offset, texture.pixels.begin() + mip.offset + mip.size);
+
+		}
+
+		return data;
+
+	}
+
+}
+
+TEST_CASE(DdsRoundTripKeepsFormatsAndMips) {
+
+	TextureData rgba = MakeMippedTexture(TextureFormat::kRGBA8, 64, 32);
+	TextureData srgb = MakeMippedTexture(TextureFormat::kRGBA8Srgb, 40, 24);
+
+	std::vector<TextureData> textures = { rgba, srgb };
+
+	//BCは4で割り切れない段(2x1や1x1)も1ブロックとして入る
+	for (TextureFormat format : { TextureFormat::kBC1, TextureFormat::kBC3, TextureFormat::kBC5, TextureFormat::kBC7 }) {
+		TextureData compressed;
+		REQUIRE(CompressTexture(srgb, format, compressed));
+		textures.push_back(compressed);
+	}
+
+	for (const TextureData& texture : textures) {
+
+		std::vector<uint8_t> data = WriteDdsToMemory(texture);
+
+		REQUIRE(data.size() == kMaxDdsHeaderSize + texture.pixels.size());
+
+		TextureData parsed;
+
+		REQUIRE(ParseDds(data.data(), data.size(), parsed));
+		CHECK(IsSameTexture(parsed, texture));
+
+		//ヘッダーだけでも同じ段になり、画素はヘッダーの直後にある
+		TextureData layout;
+
+		size_t pixelOffset = 0;
+
+		REQUIRE(ParseDdsLayout(data.data(), kMaxDdsHeaderSize, data.size(), layout, pixelOffset));
+		CHECK(pixelOffset == kMaxDdsHeaderSize);
+		CHECK(layout.mips.size() == texture.mips.size());
+		CHECK(layout.pixels.size() == texture.pixels.size());
+
+	}
+
+	//ファイルを通しても同じ
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "TextureLoaderTest.dds";
+
+	REQUIRE(WriteDds(path.string().c_str(), textures.back()));
+
+	TextureData loaded;
+
+	CHECK(LoadTexture(path.string().c_str(), loaded));
+	CHECK(IsSameTexture(loaded, textures.back()));
+
+	std::filesystem::remove(path);
+
+	//DDSにない形式は書かない
+	TextureData unknown;
+
+	CHECK(WriteDdsToMemory(unknown).empty());
+
+}
+
+TEST_CASE(DdsLegacyBgraIsSwizzled) {
+
+	TextureData texture;
+	InitializeTexture(texture, TextureFormat::kRGBA8, 4, 4, 1);
+
+	FillRandom(texture, 3);
+
+	std::vector<uint8_t> data = WriteDdsToMemory(texture);
+
+	//DX10の拡張ヘッダーを外し、アルファのない古いBGRAのヘッダーにする
+	data.erase(data.begin() + kDdsDxgiFormatOffset, data.begin() + kMaxDdsHeaderSize);
+
+	PatchUint32(data, kDdsPixelFormatFlagsOffset, 0x40);
+	PatchUint32(data, kDdsFourCCOffset, 0);
+	PatchUint32(data, 88, 32);
+	PatchUint32(data, 92, 0x00ff0000);
+	PatchUint32(data, 96, 0x0000ff00);
+	PatchUint32(data, 100, 0x000000ff);
+
+	TextureData parsed;
+
+	REQUIRE(ParseDds(data.data(), data.size(), parsed));
+	CHECK(parsed.format == TextureFormat::kRGBA8);
+
+	bool isSwizzled = true;
+
+	for (size_t i = 0; i < texture.pixels.size(); i += 4) {
+		isSwizzled &= parsed.pixels[i] == texture.pixels[i + 2] && parsed.pixels[i + 1] == texture.pixels[i + 1] && parsed.pixels[i + 2] == texture.pixels[i] && parsed.pixels[i + 3] == 0xff;
+	}
+
+	CHECK(isSwizzled);
+
+	//並べ替えが要るものはそのまま写せない
+	size_t pixelOffset = 0;
+
+	CHECK(!ParseDdsLayout(data.data(), data.size(), data.size(), parsed, pixelOffset));
+
+}
+
+TEST_CASE(DdsRejectsTruncatedCubeVolumeAndBadMipCounts) {
+
+	TextureData texture;
+	REQUIRE(CompressTexture(MakeMippedTexture(TextureFormat::kRGBA8, 32, 16), TextureFormat::kBC1, texture));
+
+	const std::vector<uint8_t> data = WriteDdsToMemory(texture);
+
+	TextureData parsed;
+
+	//どこで切れても読めない
+	for (size_t size = 0; size < data.size(); ++size) {
+		CHECK(!ParseDds(data.data(), size, parsed));
+	}
+
+	struct Patch {
+		size_t offset;
+		uint32_t value;
+	};
+
+	const Patch patches[] = {
+		{ 0, 0x20534443 },
+		//キューブマップと体積テクスチャ
+		{ kDdsCaps2Offset, 0x200 | 0xfc00 },
+		{ kDdsCaps2Offset, 0x200000 },
+		{ kDdsMiscFlagOffset, 0x4 },
+		{ kDdsResourceDimensionOffset, 4 },
+		{ kDdsArraySizeOffset, 2 },
+		//段の数が大きさに合わない(32x16は6段まで)
+		{ kDdsMipMapCountOffset, 7 },
+		{ kDdsMipMapCountOffset, 0xffffffff },
+		//大きさと形式
+		{ kDdsWidthOffset, 0 },
+		{ kDdsHeightOffset, 16385 },
+		{ kDdsDxgiFormatOffset, 2 },
+	};
+
+	for (const Patch& patch : patches) {
+		std::vector<uint8_t> patched = data;
+		PatchUint32(patched, patch.offset, patch.value);
+		CHECK(!ParseDds(patched.data(), patched.size(), parsed));
+	}
+
+	std::vector<uint8_t> volume = data;
+	PatchUint32(volume, kDdsFlagsOffset, 0x800000 | 0x1007);
+	PatchUint32(volume, kDdsDepthOffset, 4);
+
+	CHECK(!ParseDds(volume.data(), volume.size(), parsed));
+
+	//幅を大きくすると画素が足りなくなる
+	std::vector<uint8_t> wide = data;
+	PatchUint32(wide, kDdsWidthOffset, 64);
+
+	CHECK(!ParseDds(wide.data(), wide.size(), parsed));
+
+	//段の数を持たないものは1段として読む
+	std::vector<uint8_t> single = data;
+	PatchUint32(single, kDdsFlagsOffset, 0x1007);
+
+	REQUIRE(ParseDds(single.data(), single.size(), parsed));
+	CHECK(parsed.mips.size() == 1);
+
+}
+
+TEST_CASE(Ktx2ReadsLevelsAndChecksLevelIndex) {
+
+	TextureData texture = MakeMippedTexture(TextureFormat::kRGBA8, 16, 8);
+
+	const std::vector<uint8_t> data = MakeKtx2(texture);
+
+	TextureData parsed;
+
+	REQUIRE(ParseKtx2(data.data(), data.size(), parsed));
+	CHECK(IsSameTexture(parsed, texture));
+
+	for (size_t size = 0; size < data.size(); size += 5) {
+		CHECK(!ParseKtx2(data.data(), size, parsed));
+	}
+
+	//levelCountが0なら1段として読む
+	std::vector<uint8_t> zeroLevels = data;
+	PatchUint32(zeroLevels, kKtx2LevelCountOffset, 0);
+
+	REQUIRE(ParseKtx2(zeroLevels.data(), zeroLevels.size(), parsed));
+	CHECK(parsed.mips.size() == 1);
+
+	const struct {
+		size_t offset;
+		uint32_t value;
+	} headerPatches[] = {
+		{ 0, 0 },
+		{ kKtx2VkFormatOffset, 0 },
+		{ kKtx2PixelDepthOffset, 2 },
+		{ kKtx2LayerCountOffset, 2 },
+		{ kKtx2FaceCountOffset, 6 },
+		{ kKtx2SupercompressionOffset, 2 },
+		//16x8は5段まで
+		{ kKtx2LevelCountOffset, 6 },
+		{ kKtx2LevelCountOffset, 0xffffffff },
+	};
+
+	for (const auto& patch : headerPatches) {
+		std::vector<uint8_t> patched = data;
+		PatchUint32(patched, patch.offset, patch.value);
+		CHECK(!ParseKtx2(patched.data(), patched.size(), parsed));
+	}
+
+	//段の表の位置と長さ
+	const struct {
+		size_t field;
+		uint64_t value;
+	} levelPatches[] = {
+		{ 0, data.size() },
+		{ 0, data.size() - 4 },
+		{ 0, 0xffffffffffffff00ull },
+		{ 8, texture.mips[0].size + 4 },
+		{ 8, 0xffffffffffffffffull },
+	};
+
+	for (const auto& patch : levelPatches) {
+		std::vector<uint8_t> patched = data;
+		PatchUint64(patched, kKtx2LevelIndexOffset + patch.field, patch.value);
+		CHECK(!ParseKtx2(patched.data(), patched.size(), parsed));
+	}
+
+	//表が途中で切れている(段の数は合っているが、ファイルが表の途中で終わる)
+	std::vector<uint8_t> shortIndex(data.begin(), data.begin() + kKtx2LevelIndexOffset + 24 * 2);
+
+	CHECK(!ParseKtx2(shortIndex.data(), shortIndex.size(), parsed));
+
+}
@@ -0,0 +1,562 @@
+#include "TestFramework.h"
+#include "TextureStreaming.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+	//4x4の3段(64, 16, 4バイト)。1x1の段だけを最初から常駐させる
+	const uint64_t kSmallMipSizes[] = { 64, 16, 4 };
+
+	TextureStreamingSettings MakeSmallSettings(uint64_t budget) {
+
+		TextureStreamingSettings settings;
+		settings.budget = budget;
+		settings.tailMipDimension = 1;
+		settings.maxRequestsPerFrame = 8;
+		settings.maxRequestBytesPerFrame = 1024;
+
+		return settings;
+
+	}
+
+	uint32_t RegisterSmallTexture(TextureStreamer& streamer) {
+		return streamer.RegisterTexture(4, 4, kSmallMipSizes, 3);
+	}
+
+	//要求を全部すぐに読み込み終わったことにする
+	void CompleteAllRequests(TextureStreamer& streamer) {
+		for (const MipRequest& request : streamer.GetRequests()) {
+			streamer.CompleteRequest(request.textureIndex, request.mip);
+		}
+	}
+
+	//BC1と同じ大きさ(4x4で8バイト)
+	uint64_t ComputeBlockMipSize(uint32_t width, uint32_t height) {
+		return uint64_t((width + 3) / 4) * ((height + 3) / 4) * 8;
+	}
+
+}
+
+TEST_CASE(TailMipsAreResidentFromRegistration) {
+
+	TextureStreamingSettings settings;
+	settings.tailMipDimension = 64;
+
+	TextureStreamer streamer;
+	streamer.Initialize(settings);
+
+	std::vector<uint64_t> mipSizes;
+
+	for (uint32_t mip = 0; mip < 11; ++mip) {
+		mipSizes.push_back(ComputeBlockMipSize((std::max)(1024u >> mip, 1u), (std::max)(512u >> mip, 1u)));
+	}
+
+	uint32_t textureIndex = streamer.RegisterTexture(1024, 512, mipSizes.data(), 11);
+
+	//幅が64以下になるのは4段目から
+	CHECK(streamer.GetTailMip(textureIndex) == 4);
+	CHECK(streamer.GetResidentMip(textureIndex) == 4);
+	CHECK(streamer.GetPendingMip(textureIndex) == TextureStreamer::kNoMip);
+
+	uint64_t tailSize = 0;
+
+	for (uint32_t mip = 4; mip < 11; ++mip) {
+		tailSize += mipSizes[mip];
+	}
+
+	CHECK(streamer.GetStatistics().residentSize == tailSize);
+
+	//全ての段が小さければ0段目から常駐する
+	uint64_t tinySizes[] = { 8, 8 };
+
+	CHECK(streamer.GetTailMip(streamer.RegisterTexture(2, 2, tinySizes, 2)) == 0);
+
+}
+
+TEST_CASE(RequestsStepOneMipAtATime) {
+
+	TextureStreamer streamer;
+	streamer.Initialize(MakeSmallSettings(1024));
+
+	uint32_t texture = RegisterSmallTexture(streamer);
+
+	streamer.BeginFrame();
+	streamer.ReportUsage(texture, 0.0f, 100.0f);
+	streamer.Update();
+
+	//0段目が必要でも、まず1段目を要求する
+	REQUIRE(streamer.GetRequests().size() == 1);
+	CHECK(streamer.GetRequests()[0].mip == 1);
+	CHECK(streamer.GetPendingMip(texture) == 1);
+	CHECK(streamer.GetStatistics().pendingSize == 16);
+
+	//読み込み中は次の段を要求しない
+	streamer.BeginFrame();
+	streamer.ReportUsage(texture, 0.0f, 100.0f);
+	streamer.Update();
+
+	CHECK(streamer.GetRequests().empty());
+
+	streamer.CompleteRequest(texture, 1);
+
+	CHECK(streamer.GetResidentMip(texture) == 1);
+	CHECK(streamer.GetStatistics().pendingSize == 0);
+	CHECK(streamer.GetStatistics().residentSize == 20);
+
+	streamer.BeginFrame();
+	streamer.ReportUsage(texture, 0.0f, 100.0f);
+	streamer.Update();
+
+	REQUIRE(streamer.GetRequests().size() == 1);
+	CHECK(streamer.GetRequests()[0].mip == 0);
+
+	//読めなければ取り消し、まだ必要なら次のフレームで要求し直す
+	streamer.CancelRequest(texture, 0);
+
+	CHECK(streamer.GetPendingMip(texture) == TextureStreamer::kNoMip);
+	CHECK(streamer.GetStatistics().pendingSize == 0);
+
+	streamer.BeginFrame();
+	streamer.ReportUsage(texture, 0.3f, 100.0f);
+	streamer.Update();
+
+	REQUIRE(streamer.GetRequests().size() == 1);
+	CHECK(streamer.GetRequests()[0].mip == 0);
+
+}
+
+TEST_CASE(RequestsAreOrderedAndCapped) {
+
+	TextureStreamingSettings settings = MakeSmallSettings(1024);
+	settings.maxRequestsPerFrame = 2;
+
+	TextureStreamer streamer;
+	streamer.Initialize(settings);
+
+	uint32_t a = RegisterSmallTexture(streamer);
+	uint32_t b = RegisterSmallTexture(streamer);
+	uint32_t c = RegisterSmallTexture(streamer);
+
+	//足りない段が多いaが先、次は画面で大きいc
+	streamer.BeginFrame();
+	streamer.ReportUsage(b, 1.0f, 100.0f);
+	streamer.ReportUsage(c, 1.0f, 300.0f);
+	streamer.ReportUsage(a, 0.0f, 10.0f);
+	streamer.Update();
+
+	REQUIRE(streamer.GetRequests().size() == 2);
+	CHECK(streamer.GetRequests()[0].textureIndex == a);
+	CHECK(streamer.GetRequests()[1].textureIndex == c);
+
+	//同じフレームで何度も伝えれば面積を足す
+	settings.maxRequestsPerFrame = 1;
+	streamer.Initialize(settings);
+
+	a = RegisterSmallTexture(streamer);
+	b = RegisterSmallTexture(streamer);
+
+	streamer.BeginFrame();
+	streamer.ReportUsage(a, 1.0f, 200.0f);
+	streamer.ReportUsage(b, 1.0f, 150.0f);
+	streamer.ReportUsage(b, 1.0f, 150.0f);
+	streamer.Update();
+
+	REQUIRE(streamer.GetRequests().size() == 1);
+	CHECK(streamer.GetRequests()[0].textureIndex == b);
+
+}
+
+TEST_CASE(RequestBytesAreCappedPerFrame) {
+
+	TextureStreamingSettings settings = MakeSmallSettings(1024);
+	settings.maxRequestBytesPerFrame = 20;
+
+	TextureStreamer streamer;
+	streamer.Initialize(settings);
+
+	uint32_t a = RegisterSmallTexture(streamer);
+	uint32_t b = RegisterSmallTexture(streamer);
+
+	streamer.BeginFrame();
+	streamer.ReportUsage(a, 1.0f, 200.0f);
+	streamer.ReportUsage(b, 1.0f, 100.0f);
+	streamer.Update();
+
+	//16 + 16は20を超えるので1つだけ
+	REQUIRE(streamer.GetRequests().size() == 1);
+	CHECK(streamer.GetRequests()[0].textureIndex == a);
+
+	CompleteAllRequests(streamer);
+
+	//上限より大きい段でも、そのフレームの最初の要求なら出す
+	streamer.BeginFrame();
+	streamer.ReportUsage(a, 0.0f, 200.0f);
+	streamer.ReportUsage(b, 1.0f, 100.0f);
+	streamer.Update();
+
+	REQUIRE(streamer.GetRequests().size() == 1);
+	CHECK(streamer.GetRequests()[0].textureIndex == a);
+	CHECK(streamer.GetRequests()[0].mip == 0);
+
+}
+
+TEST_CASE(EvictsLeastRecentlyUsedMip) {
+
+	//1x1の段3つと、1段目を2つ分
+	TextureStreamer streamer;
+	streamer.Initialize(MakeSmallSettings(12 + 32));
+
+	uint32_t a = RegisterSmallTexture(streamer);
+	uint32_t b = RegisterSmallTexture(streamer);
+	uint32_t c = RegisterSmallTexture(streamer);
+
+	//フレーム1でa、フレーム2でbを読む
+	streamer.BeginFrame();
+	streamer.ReportUsage(a, 1.0f, 100.0f);
+	streamer.Update();
+	CompleteAllRequests(streamer);
+
+	streamer.BeginFrame();
+	streamer.ReportUsage(b, 1.0f, 100.0f);
+	streamer.Update();
+	CompleteAllRequests(streamer);
+
+	CHECK(streamer.GetStatistics().residentSize == 44);
+	CHECK(streamer.GetStatistics().evictedCount == 0);
+
+	//フレーム3でaとcを使うので、最後に使ったのが古いbを追い出す
+	streamer.BeginFrame();
+	streamer.ReportUsage(a, 1.0f, 100.0f);
+	streamer.ReportUsage(c, 1.0f, 100.0f);
+	streamer.Update();
+
+	REQUIRE(streamer.GetEvictions().size() == 1);
+	CHECK(streamer.GetEvictions()[0].textureIndex == b);
+	CHECK(streamer.GetEvictions()[0].mip == 1);
+	CHECK(streamer.GetResidentMip(b) == 2);
+
+	REQUIRE(streamer.GetRequests().size() == 1);
+	CHECK(streamer.GetRequests()[0].textureIndex == c);
+	CHECK(streamer.GetStatistics().residentSize + streamer.GetStatistics().pendingSize == 44);
+
+	CompleteAllRequests(streamer);
+
+	//このフレームで使う段は追い出さないので、bの要求は見送る
+	streamer.BeginFrame();
+	streamer.ReportUsage(a, 1.0f, 100.0f);
+	streamer.ReportUsage(c, 1.0f, 100.0f);
+	streamer.ReportUsage(b, 1.0f, 100.0f);
+	streamer.Update();
+
+	CHECK(streamer.GetRequests().empty());
+	CHECK(streamer.GetEvictions().empty());
+	CHECK(streamer.GetStatistics().deniedCount == 1);
+	CHECK(streamer.GetResidentMip(a) == 1);
+	CHECK(streamer.GetResidentMip(c) == 1);
+
+	//次のフレームでcを使わなければ、cを追い出してbを読む
+	streamer.BeginFrame();
+	streamer.ReportUsage(a, 1.0f, 100.0f);
+	streamer.ReportUsage(b, 1.0f, 100.0f);
+	streamer.Update();
+
+	REQUIRE(streamer.GetEvictions().size() == 1);
+	CHECK(streamer.GetEvictions()[0].textureIndex == c);
+	REQUIRE(streamer.GetRequests().size() == 1);
+	CHECK(streamer.GetRequests()[0].textureIndex == b);
+	CHECK(streamer.GetStatistics().deniedCount == 0);
+
+}
+
+TEST_CASE(EvictsFinestMipFirst) {
+
+	//1x1の段2つと、aの0段目と1段目
+	TextureStreamer streamer;
+	streamer.Initialize(MakeSmallSettings(8 + 80));
+
+	uint32_t a = RegisterSmallTexture(streamer);
+	uint32_t b = RegisterSmallTexture(streamer);
+
+	for (int i = 0; i < 2; ++i) {
+		streamer.BeginFrame();
+		streamer.ReportUsage(a, 0.0f, 100.0f);
+		streamer.Update();
+		CompleteAllRequests(streamer);
+	}
+
+	CHECK(streamer.GetResidentMip(a) == 0);
+
+	//bの1段目のために、aは0段目だけを追い出して1段目を残す
+	streamer.BeginFrame();
+	streamer.ReportUsage(b, 1.0f, 100.0f);
+	streamer.Update();
+
+	REQUIRE(streamer.GetEvictions().size() == 1);
+	CHECK(streamer.GetEvictions()[0].textureIndex == a);
+	CHECK(streamer.GetEvictions()[0].mip == 0);
+	CHECK(streamer.GetResidentMip(a) == 1);
+	CHECK(streamer.GetRequests().size() == 1);
+
+}
+
+TEST_CASE(PendingTextureIsNotEvicted) {
+
+	TextureStreamer streamer;
+	streamer.Initialize(MakeSmallSettings(8 + 16 + 64));
+
+	uint32_t a = RegisterSmallTexture(streamer);
+	uint32_t b = RegisterSmallTexture(streamer);
+
+	streamer.BeginFrame();
+	streamer.ReportUsage(a, 0.0f, 100.0f);
+	streamer.Update();
+	CompleteAllRequests(streamer);
+
+	//aの0段目を読み込み中にする
+	streamer.BeginFrame();
+	streamer.ReportUsage(a, 0.0f, 100.0f);
+	streamer.Update();
+
+	REQUIRE(streamer.GetRequests().size() == 1);
+	CHECK(streamer.GetPendingMip(a) == 0);
+
+	//aの1段目は古いが、読み込み中のテクスチャは追い出さないので見送る
+	streamer.BeginFrame();
+	streamer.ReportUsage(b, 1.0f, 100.0f);
+	streamer.Update();
+
+	CHECK(streamer.GetEvictions().empty());
+	CHECK(streamer.GetRequests().empty());
+	CHECK(streamer.GetStatistics().deniedCount == 1);
+
+	//読み込みが終われば追い出せる
+	streamer.CompleteRequest(a, 0);
+
+	streamer.BeginFrame();
+	streamer.ReportUsage(b, 1.0f, 100.0f);
+	streamer.Update();
+
+	REQUIRE(streamer.GetEvictions().size() == 1);
+	CHECK(streamer.GetEvictions()[0].textureIndex == a);
+	CHECK(streamer.GetEvictions()[0].mip == 0);
+	CHECK(streamer.GetRequests().size() == 1);
+
+}
+
+TEST_CASE(MipLargerThanBudgetIsDenied) {
+
+	TextureStreamer streamer;
+	streamer.Initialize(MakeSmallSettings(40));
+
+	uint32_t a = RegisterSmallTexture(streamer);
+
+	streamer.BeginFrame();
+	streamer.ReportUsage(a, 0.0f, 100.0f);
+	streamer.Update();
+	CompleteAllRequests(streamer);
+
+	streamer.BeginFrame();
+	streamer.ReportUsage(a, 0.0f, 100.0f);
+	streamer.Update();
+
+	CHECK(streamer.GetRequests().empty());
+	CHECK(streamer.GetEvictions().empty());
+	CHECK(streamer.GetStatistics().deniedCount == 1);
+	CHECK(streamer.GetResidentMip(a) == 1);
+
+}
+
+TEST_CASE(DesiredMipFollowsProjectedSize) {
+
+	CHECK(ComputeDesiredMip(1024, 1024, 1024.0f) == 0.0f);
+	CHECK(ComputeDesiredMip(1024, 1024, 4096.0f) == 0.0f);
+	CHECK(ComputeDesiredMip(1024, 512, 256.0f) == 2.0f);
+	CHECK(std::fabs(ComputeDesiredMip(1024, 1024, 384.0f) - std::log2(1024.0f / 384.0f)) < 1e-5f);
+
+	//画面で1ピクセル未満でも一番粗い段より先には行かない
+	CHECK(ComputeDesiredMip(1024, 1024, 0.0f) == 10.0f);
+
+}
+
+TEST_CASE(SimulatedCameraStaysWithinBudget) {
+
+	//4000枚(512～4096ピクセル)を256MBで、動くカメラから1～4フレーム遅れて読み込む
+	const uint32_t kTextureCount = 4000;
+	const uint32_t kFrameCount = 3000;
+	const float kWorldSize = 1000.0f;
+	const float kViewDistance = 120.0f;
+
+	TextureStreamingSettings settings;
+	settings.budget = 256ull * 1024 * 1024;
+
+	TextureStreamer streamer;
+	streamer.Initialize(settings);
+
+	std::mt19937 random(48);
+
+	struct SimulatedTexture {
+		float x;
+		float z;
+		uint32_t size;
+		std::vector<uint64_t> mipSizes;
+	};
+
+	std::vector<SimulatedTexture> textures(kTextureCount);
+
+	for (SimulatedTexture& texture : textures) {
+
+		texture.x = std::uniform_real_distribution<float>(0.0f, kWorldSize)(random);
+		texture.z = std::uniform_real_distribution<float>(0.0f, kWorldSize)(random);
+		texture.size = 512u << (random() % 4);
+
+		uint32_t mipCount = 1;
+
+		while ((texture.size >> mipCount) != 0) {
+			++mipCount;
+		}
+
+		for (uint32_t mip = 0; mip < mipCount; ++mip) {
+			texture.mipSizes.push_back(ComputeBlockMipSize((std::max)(texture.size >> mip, 1u), (std::max)(texture.size >> mip, 1u)));
+		}
+
+		streamer.RegisterTexture(texture.size, texture.size, texture.mipSizes.data(), mipCount);
+
+	}
+
+	//読み込みが終わるフレーム
+	struct PendingLoad {
+		uint64_t completeFrame;
+		MipRequest request;
+	};
+
+	std::vector<PendingLoad> pendingLoads;
+
+	std::vector<uint32_t> desiredMips(kTextureCount);
+
+	uint64_t usageCount = 0;
+	uint64_t satisfiedCount = 0;
+	uint64_t cancelCount = 0;
+	uint64_t evictedCount = 0;
+
+	for (uint64_t frame = 1; frame <= kFrameCount; ++frame) {
+
+		//先に読み込みを終わらせ、たまに失敗させる
+		for (size_t i = 0; i < pendingLoads.size();) {
+
+			if (pendingLoads[i].completeFrame > frame) {
+				++i;
+				continue;
+			}
+
+			const MipRequest& request = pendingLoads[i].request;
+
+			if (random() % 100 == 0) {
+				streamer.CancelRequest(request.textureIndex, request.mip);
+				cancelCount++;
+			} else {
+				streamer.CompleteRequest(request.textureIndex, request.mip);
+			}
+
+			pendingLoads[i] = pendingLoads.back();
+			pendingLoads.pop_back();
+
+		}
+
+		streamer.BeginFrame();
+
+		//世界の中を円を描いて回る
+		float angle = frame * 0.002f;
+		float cameraX = kWorldSize * (0.5f + 0.35f * std::cos(angle));
+		float cameraZ = kWorldSize * (0.5f + 0.35f * std::sin(angle));
+
+		std::fill(desiredMips.begin(), desiredMips.end(), TextureStreamer::kNoMip);
+
+		for (uint32_t textureIndex = 0; textureIndex < kTextureCount; ++textureIndex) {
+
+			const SimulatedTexture& texture = textures[textureIndex];
+
+			float distance = std::hypot(texture.x - cameraX, texture.z - cameraZ);
+
+			if (distance > kViewDistance) {
+				continue;
+			}
+
+			float projectedSize = 8000.0f / (std::max)(distance, 1.0f);
+
+			float desiredMip = ComputeDesiredMip(texture.size, texture.size, projectedSize);
+
+			streamer.ReportUsage(textureIndex, desiredMip, projectedSize * projectedSize);
+
+			desiredMips[textureIndex] = static_cast<uint32_t>(desiredMip);
+
+			usageCount++;
+
+			if (streamer.GetResidentMip(textureIndex) <= desiredMips[textureIndex]) {
+				satisfiedCount++;
+			}
+
+		}
+
+		streamer.Update();
+
+		const TextureStreamingStatistics& statistics = streamer.GetStatistics();
+
+		REQUIRE(statistics.residentSize + statistics.pendingSize <= settings.budget);
+
+		evictedCount += statistics.evictedCount;
+
+		//このフレームで使う段は追い出さない
+		for (const MipEviction& eviction : streamer.GetEvictions()) {
+			CHECK(eviction.mip < desiredMips[eviction.textureIndex]);
+			CHECK(eviction.mip < streamer.GetTailMip(eviction.textureIndex));
+		}
+
+		for (const MipRequest& request : streamer.GetRequests()) {
+
+			CHECK(request.mip + 1 == streamer.GetResidentMip(request.textureIndex));
+
+			pendingLoads.push_back({ frame + 1 + random() % 4, request });
+
+		}
+
+	}
+
+	//統計が段ごとの合計と一致する
+	uint64_t residentSize = 0;
+	uint64_t pendingSize = 0;
+
+	for (uint32_t textureIndex = 0; textureIndex < kTextureCount; ++textureIndex) {
+
+		const SimulatedTexture& texture = textures[textureIndex];
+
+		uint32_t residentMip = streamer.GetResidentMip(textureIndex);
+
+		CHECK(residentMip <= streamer.GetTailMip(textureIndex));
+
+		for (uint32_t mip = residentMip; mip < texture.mipSizes.size(); ++mip) {
+			residentSize += texture.mipSizes[mip];
+		}
+
+		uint32_t pendingMip = streamer.GetPendingMip(textureIndex);
+
+		if (pendingMip != TextureStreamer::kNoMip) {
+			pendingSize += texture.mipSizes[pendingMip];
+		}
+
+	}
+
+	CHECK(streamer.GetStatistics().residentSize == residentSize);
+	CHECK(streamer.GetStatistics().pendingSize == pendingSize);
+
+	//予算に収めるために追い出しが起きている
+	CHECK(evictedCount > 0);
+	CHECK(cancelCount > 0);
+
+	//ほとんどの使用で必要な段がそろっている
+	CHECK(usageCount > 0);
+	CHECK(satisfiedCount >= usageCount * 9 / 10);
+
+}
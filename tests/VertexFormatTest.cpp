@@ -0,0 +1,620 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "VertexFormat.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VERTEX_FORMAT_TEST_HAS_F16C_REFERENCE
+#endif
+
+//同じテストをSSE2、F16C、SIMDなし(VERTEX_FORMAT_NO_SIMD)でビルドしたVertexFormat.cppに対して動かす
+//どの組み合わせでも、ここに書いたスカラーの手順とビット単位で同じ結果になることを確かめる
+
+namespace {
+
+	uint32_t FloatBits(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	float BitsFloat(uint32_t bits) {
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	bool IsHalfNaN(uint16_t half) {
+		return (half & 0x7c00u) == 0x7c00u && (half & 0x3ffu) != 0;
+	}
+
+	//halfの定義どおりにdoubleで求める
+	float ReferenceHalfToFloat(uint16_t half) {
+
+		uint32_t exponent = (half >> 10) & 0x1f;
+
+		uint32_t mantissa = half & 0x3ff;
+
+		double value;
+
+		if (exponent == 0) {
+			value = std::ldexp(static_cast<double>(mantissa), -24);
+		} else if (exponent == 31) {
+			value = mantissa == 0 ? HUGE_VAL : NAN;
+		} else {
+			value = std::ldexp(static_cast<double>(1024 + mantissa), static_cast<int>(exponent) - 25);
+		}
+
+		return static_cast<float>((half & 0x8000u) ? -value : value);
+
+	}
+
+#if defined(VERTEX_FORMAT_TEST_HAS_F16C_REFERENCE)
+
+	bool HasF16c() {
+		return __builtin_cpu_supports("f16c");
+	}
+
+	__attribute__((target("f16c"))) uint16_t HardwareFloatToHalf(float value) {
+		return static_cast<uint16_t>(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT));
+	}
+
+#endif
+
+	//NaNはどのNaNでもよい(F16Cは元のNaNの上位ビットを残す)。それ以外はビット単位で一致させる
+	bool IsSameHalf(uint16_t a, uint16_t b) {
+		return IsHalfNaN(a) ? IsHalfNaN(b) : a == b;
+	}
+
+	bool IsSameFloat(float a, float b) {
+		return std::isnan(a) ? std::isnan(b) : FloatBits(a) == FloatBits(b);
+	}
+
+	//全てのfloatのビット列[0, 2^32)を塊に分けてfunction(begin, end)を並列に呼ぶ
+	template<typename Function>
+	void ForEveryFloat(JobSystem& jobSystem, const Function& function) {
+
+		const uint32_t kJobCount = 1024;
+
+		const uint64_t kJobSize = (uint64_t(UINT32_MAX) + 1) / kJobCount;
+
+		jobSystem.Dispatch(kJobCount, [&](uint32_t jobIndex) {
+			function(kJobSize * jobIndex, kJobSize * (jobIndex + 1));
+		});
+
+	}
+
+	//以下はVertexFormat.cppのスカラーの手順を仕様として書き直したもの
+
+	uint16_t ReferenceQuantizeUnorm16(float value) {
+
+		if (!(value > 0.0f)) {
+			return 0;
+		}
+
+		return static_cast<uint16_t>((std::min)(value, 65535.0f) + 0.5f);
+
+	}
+
+	void ReferenceEncodeOctahedral(const Vector3& normal, int16_t encoded[2]) {
+
+		float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+
+		if (!(length > 0.0f)) {
+			encoded[0] = 0;
+			encoded[1] = 0;
+			return;
+		}
+
+		float inverseLength = 1.0f / length;
+
+		float x = normal.x * inverseLength;
+		float y = normal.y * inverseLength;
+
+		if (normal.z < 0.0f) {
+			float foldedX = (1.0f - std::fabs(y)) * std::copysign(1.0f, x);
+			float foldedY = (1.0f - std::fabs(x)) * std::copysign(1.0f, y);
+			x = foldedX;
+			y = foldedY;
+		}
+
+		encoded[0] = static_cast<int16_t>(std::lrint(x * 32767.0f));
+		encoded[1] = static_cast<int16_t>(std::lrint(y * 32767.0f));
+
+	}
+
+	Vector3 ReferenceDecodeOctahedral(const int16_t encoded[2]) {
+
+		const float kInverseMax = 1.0f / 32767.0f;
+
+		float x = (std::max)(encoded[0] * kInverseMax, -1.0f);
+		float y = (std::max)(encoded[1] * kInverseMax, -1.0f);
+		float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+		float t = (std::max)(-z, 0.0f);
+
+		x += x >= 0.0f ? -t : t;
+		y += y >= 0.0f ? -t : t;
+
+		float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+
+		return { x * inverseLength, y * inverseLength, z * inverseLength };
+
+	}
+
+	//向きも長さもばらばらな頂点と、軸、0、折り返しの境目の法線を混ぜる
+	std::vector<MeshVertex> MakeRandomVertices(size_t count, uint32_t seed) {
+
+		std::mt19937 random(seed);
+
+		std::uniform_real_distribution<float> position(-50.0f, 80.0f);
+		std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> texcoord(-4.0f, 4.0f);
+
+		const Vector3 specialNormals[] = {
+			{ 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+			{ 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }, { 0.5f, -0.5f, -0.5f }, { -0.3f, 0.2f, -0.0f }, { 3.0f, 4.0f, -12.0f },
+		};
+
+		std::vector<MeshVertex> vertices(count);
+
+		for (size_t i = 0; i < count; ++i) {
+
+			MeshVertex& vertex = vertices[i];
+
+			vertex.position = { position(random), position(random), position(random), 1.0f };
+
+			if (i % 7 == 0) {
+				vertex.normal = specialNormals[(i / 7) % std::size(specialNormals)];
+			} else {
+				vertex.normal = { direction(random), direction(random), direction(random) };
+			}
+
+			vertex.texcoord = { texcoord(random), texcoord(random) };
+
+		}
+
+		return vertices;
+
+	}
+
+}
+
+TEST_CASE(LayoutsHaveExpectedStrides) {
+
+	VertexLayout full(kFullVertexLayoutDesc);
+
+	CHECK(full.GetStride() == sizeof(MeshVertex));
+	CHECK(full.GetPositionOffset() == 0);
+	CHECK(full.GetNormalOffset() == 16);
+	CHECK(full.GetTexcoordOffset() == 28);
+
+	VertexLayout compact(kCompactVertexLayoutDesc);
+
+	CHECK(compact.GetStride() == 16);
+	CHECK(compact.GetElementCount() == 3);
+	CHECK(compact.GetPositionOffset() == 0);
+	CHECK(compact.GetNormalOffset() == 8);
+	CHECK(compact.GetTexcoordOffset() == 12);
+
+	VertexLayout positionOnly({ PositionEncoding::kUnorm16, NormalEncoding::kNone, TexcoordEncoding::kNone });
+
+	CHECK(positionOnly.GetStride() == 8);
+	CHECK(positionOnly.GetNormalOffset() == UINT32_MAX);
+	CHECK(positionOnly.GetTexcoordOffset() == UINT32_MAX);
+
+}
+
+TEST_CASE(HalfToFloatMatchesReferenceForEveryHalf) {
+
+	VertexLayout layout(kCompactVertexLayoutDesc);
+
+	VertexQuantization quantization = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+
+	//全てのhalfをUVに並べてDecodeVerticesのSIMDの経路も通す
+	const size_t kVertexCount = 65536 / 2;
+
+	std::vector<uint8_t> encoded(layout.GetStride() * kVertexCount, 0);
+
+	for (uint32_t half = 0; half < 65536; ++half) {
+		uint16_t value = static_cast<uint16_t>(half);
+		std::memcpy(encoded.data() + layout.GetStride() * (half / 2) + layout.GetTexcoordOffset() + (half % 2) * 2, &value, sizeof(value));
+	}
+
+	std::vector<MeshVertex> decoded(kVertexCount);
+
+	DecodeVertices(decoded.data(), encoded.data(), kVertexCount, layout, quantization);
+
+	uint32_t mismatchCount = 0;
+
+	for (uint32_t half = 0; half < 65536; ++half) {
+
+		float expected = ReferenceHalfToFloat(static_cast<uint16_t>(half));
+
+		float scalar = HalfToFloat(static_cast<uint16_t>(half));
+
+		const Vector2& texcoord = decoded[half / 2].texcoord;
+
+		float vectorized = half % 2 == 0 ? texcoord.x : texcoord.y;
+
+		if (!IsSameFloat(scalar, expected) || !IsSameFloat(vectorized, expected)) {
+			mismatchCount++;
+		}
+
+		//halfに戻すと元の値になる
+		if (!IsSameHalf(FloatToHalf(scalar), static_cast<uint16_t>(half))) {
+			mismatchCount++;
+		}
+
+	}
+
+	CHECK(mismatchCount == 0);
+
+}
+
+#if defined(VERTEX_FORMAT_NO_SIMD)
+
+namespace {
+
+	//最近接偶数への丸めをdoubleで行う(F16Cがない時の参照)
+	uint16_t ReferenceFloatToHalf(float value) {
+
+		uint16_t sign = (FloatBits(value) >> 16) & 0x8000u;
+
+		double absolute = std::fabs(static_cast<double>(value));
+
+		if (std::isnan(absolute)) {
+			return sign | 0x7e00u;
+		}
+
+		//65504と65536の中間より大きければ無限大
+		if (absolute >= 65520.0) {
+			return sign | 0x7c00u;
+		}
+
+		if (absolute < std::ldexp(1.0, -14)) {
+			return sign | static_cast<uint16_t>(std::nearbyint(std::ldexp(absolute, 24)));
+		}
+
+		int exponent = std::ilogb(absolute);
+
+		uint32_t mantissa = static_cast<uint32_t>(std::nearbyint(std::ldexp(absolute, 10 - exponent)));
+
+		//仮数が2048に繰り上がれば指数に足される
+		return sign | static_cast<uint16_t>(((exponent + 15) << 10) + (mantissa - 1024));
+
+	}
+
+	//1つのfloatの参照の結果(F16Cがあれば命令、なければdoubleで求める)
+	uint16_t GetReferenceHalf(float value) {
+
+#if defined(VERTEX_FORMAT_TEST_HAS_F16C_REFERENCE)
+		if (HasF16c()) {
+			return HardwareFloatToHalf(value);
+		}
+#endif
+
+		return ReferenceFloatToHalf(value);
+
+	}
+
+}
+
+//FloatToHalfはどのビルドでも同じスカラーの関数なので、全てのfloatとの比較はSIMDなしのビルドでだけ行う
+TEST_CASE(FloatToHalfMatchesReferenceForEveryFloat) {
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	std::atomic<uint64_t> mismatchCount = 0;
+
+	ForEveryFloat(jobSystem, [&](uint64_t begin, uint64_t end) {
+
+		uint64_t count = 0;
+
+		for (uint64_t bits = begin; bits < end; ++bits) {
+
+			float value = BitsFloat(static_cast<uint32_t>(bits));
+
+			if (!IsSameHalf(FloatToHalf(value), GetReferenceHalf(value))) {
+				count++;
+			}
+
+		}
+
+		mismatchCount += count;
+
+	});
+
+	CHECK(mismatchCount == 0);
+
+	jobSystem.Finalize();
+
+}
+
+#else
+
+namespace {
+
+	//UVの2つ分をstrideバイトおきにvertexCount組読み、参照の結果をhalvesに並べる
+	//全てのfloatとFloatToHalfが一致することは別に確かめるので、F16Cがなければそちらを使う
+	void GetReferenceHalves(const float* texcoords, size_t stride, size_t vertexCount, uint16_t* halves) {
+
+		for (size_t i = 0; i < vertexCount; ++i) {
+
+			const float* texcoord = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(texcoords) + stride * i);
+
+#if defined(VERTEX_FORMAT_TEST_HAS_F16C_REFERENCE)
+			if (HasF16c()) {
+				halves[i * 2] = HardwareFloatToHalf(texcoord[0]);
+				halves[i * 2 + 1] = HardwareFloatToHalf(texcoord[1]);
+				continue;
+			}
+#endif
+
+			halves[i * 2] = FloatToHalf(texcoord[0]);
+			halves[i * 2 + 1] = FloatToHalf(texcoord[1]);
+
+		}
+
+	}
+
+}
+
+//SIMDなしのEncodeVerticesはFloatToHalfをそのまま呼ぶので、SIMDのあるビルドでだけ全てのfloatを通す
+TEST_CASE(EncodedTexcoordsMatchFloatToHalfForEveryFloat) {
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	VertexLayout layout(kCompactVertexLayoutDesc);
+
+	VertexQuantization quantization = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+
+	std::atomic<uint64_t> mismatchCount = 0;
+
+	//1頂点にUVの2つ分を入れ、全てのfloatをEncodeVerticesに通す
+	ForEveryFloat(jobSystem, [&](uint64_t begin, uint64_t end) {
+
+		const size_t kVertexCount = 1 << 12;
+
+		std::vector<MeshVertex> vertices(kVertexCount);
+
+		std::vector<uint8_t> encoded(layout.GetStride() * kVertexCount);
+
+		std::vector<uint16_t> expected(kVertexCount * 2);
+
+		uint64_t count = 0;
+
+		for (uint64_t base = begin; base < end; base += kVertexCount * 2) {
+
+			for (size_t i = 0; i < kVertexCount; ++i) {
+				vertices[i].texcoord.x = BitsFloat(static_cast<uint32_t>(base + i * 2));
+				vertices[i].texcoord.y = BitsFloat(static_cast<uint32_t>(base + i * 2 + 1));
+			}
+
+			EncodeVertices(encoded.data(), vertices.data(), kVertexCount, layout, quantization);
+
+			GetReferenceHalves(&vertices[0].texcoord.x, sizeof(MeshVertex), kVertexCount, expected.data());
+
+			for (size_t i = 0; i < kVertexCount; ++i) {
+
+				uint16_t halves[2];
+
+				std::memcpy(halves, encoded.data() + layout.GetStride() * i + layout.GetTexcoordOffset(), sizeof(halves));
+
+				if (!IsSameHalf(halves[0], expected[i * 2]) || !IsSameHalf(halves[1], expected[i * 2 + 1])) {
+					count++;
+				}
+
+			}
+
+		}
+
+		mismatchCount += count;
+
+	});
+
+	CHECK(mismatchCount == 0);
+
+	jobSystem.Finalize();
+
+}
+
+#endif
+
+TEST_CASE(CompactEncodingMatchesScalarReference) {
+
+	VertexLayout layout(kCompactVertexLayoutDesc);
+
+	//SIMDの塊と端数の両方を通る数にする
+	std::vector<MeshVertex> vertices = MakeRandomVertices(1003, 11);
+
+	VertexQuantization quantization = ComputeVertexQuantization(vertices.data(), vertices.size());
+
+	std::vector<uint8_t> encoded(layout.GetStride() * vertices.size());
+
+	EncodeVertices(encoded.data(), vertices.data(), vertices.size(), layout, quantization);
+
+	Vector3 factor = { 65535.0f / quantization.scale.x, 65535.0f / quantization.scale.y, 65535.0f / quantization.scale.z };
+
+	uint32_t positionMismatchCount = 0;
+	uint32_t normalMismatchCount = 0;
+	uint32_t texcoordMismatchCount = 0;
+
+	for (size_t i = 0; i < vertices.size(); ++i) {
+
+		const MeshVertex& vertex = vertices[i];
+
+		const uint8_t* bytes = encoded.data() + layout.GetStride() * i;
+
+		uint16_t position[4];
+		std::memcpy(position, bytes + layout.GetPositionOffset(), sizeof(position));
+
+		uint16_t expectedPosition[4] = {
+			ReferenceQuantizeUnorm16((vertex.position.x - quantization.offset.x) * factor.x),
+			ReferenceQuantizeUnorm16((vertex.position.y - quantization.offset.y) * factor.y),
+			ReferenceQuantizeUnorm16((vertex.position.z - quantization.offset.z) * factor.z),
+			65535,
+		};
+
+		if (std::memcmp(position, expectedPosition, sizeof(position)) != 0) {
+			positionMismatchCount++;
+		}
+
+		int16_t normal[2];
+		std::memcpy(normal, bytes + layout.GetNormalOffset(), sizeof(normal));
+
+		int16_t expectedNormal[2];
+		ReferenceEncodeOctahedral(vertex.normal, expectedNormal);
+
+		if (normal[0] != expectedNormal[0] || normal[1] != expectedNormal[1]) {
+			normalMismatchCount++;
+		}
+
+		uint16_t texcoord[2];
+		std::memcpy(texcoord, bytes + layout.GetTexcoordOffset(), sizeof(texcoord));
+
+		if (texcoord[0] != FloatToHalf(vertex.texcoord.x) || texcoord[1] != FloatToHalf(vertex.texcoord.y)) {
+			texcoordMismatchCount++;
+		}
+
+	}
+
+	CHECK(positionMismatchCount == 0);
+	CHECK(normalMismatchCount == 0);
+	CHECK(texcoordMismatchCount == 0);
+
+}
+
+TEST_CASE(CompactDecodingMatchesScalarReference) {
+
+	VertexLayout layout(kCompactVertexLayoutDesc);
+
+	VertexQuantization quantization = { { -3.0f, 1.5f, 10.0f }, { 7.0f, 0.25f, 100.0f } };
+
+	//全ての八面体の値を含めるため、ビット列を直接並べる
+	std::mt19937 random(5);
+
+	const size_t kVertexCount = 4099;
+
+	std::vector<uint8_t> encoded(layout.GetStride() * kVertexCount);
+
+	for (size_t i = 0; i < encoded.size(); ++i) {
+		encoded[i] = static_cast<uint8_t>(random());
+	}
+
+	std::vector<MeshVertex> decoded(kVertexCount);
+
+	DecodeVertices(decoded.data(), encoded.data(), kVertexCount, layout, quantization);
+
+	const float kInverseMax = 1.0f / 65535.0f;
+
+	uint32_t mismatchCount = 0;
+
+	for (size_t i = 0; i < kVertexCount; ++i) {
+
+		const uint8_t* bytes = encoded.data() + layout.GetStride() * i;
+
+		uint16_t position[4];
+		std::memcpy(position, bytes + layout.GetPositionOffset(), sizeof(position));
+
+		Vector4 expectedPosition = {
+			position[0] * (quantization.scale.x * kInverseMax) + quantization.offset.x,
+			position[1] * (quantization.scale.y * kInverseMax) + quantization.offset.y,
+			position[2] * (quantization.scale.z * kInverseMax) + quantization.offset.z,
+			1.0f,
+		};
+
+		int16_t normal[2];
+		std::memcpy(normal, bytes + layout.GetNormalOffset(), sizeof(normal));
+
+		Vector3 expectedNormal = ReferenceDecodeOctahedral(normal);
+
+		uint16_t texcoord[2];
+		std::memcpy(texcoord, bytes + layout.GetTexcoordOffset(), sizeof(texcoord));
+
+		const MeshVertex& vertex = decoded[i];
+
+		bool isSame =
+			IsSameFloat(vertex.position.x, expectedPosition.x) && IsSameFloat(vertex.position.y, expectedPosition.y) &&
+			IsSameFloat(vertex.position.z, expectedPosition.z) && IsSameFloat(vertex.position.w, expectedPosition.w) &&
+			IsSameFloat(vertex.normal.x, expectedNormal.x) && IsSameFloat(vertex.normal.y, expectedNormal.y) && IsSameFloat(vertex.normal.z, expectedNormal.z) &&
+			IsSameFloat(vertex.texcoord.x, HalfToFloat(texcoord[0])) && IsSameFloat(vertex.texcoord.y, HalfToFloat(texcoord[1]));
+
+		if (!isSame) {
+			mismatchCount++;
+		}
+
+	}
+
+	CHECK(mismatchCount == 0);
+
+}
+
+TEST_CASE(JobSystemEncodingMatchesSingleThread) {
+
+	JobSystem jobSystem;
+	jobSystem.Initialize();
+
+	VertexLayout layout(kCompactVertexLayoutDesc);
+
+	//塊に分かれる大きさにする
+	std::vector<MeshVertex> vertices = MakeRandomVertices(70001, 12);
+
+	VertexQuantization quantization = ComputeVertexQuantization(vertices.data(), vertices.size());
+
+	std::vector<uint8_t> single(layout.GetStride() * vertices.size());
+	std::vector<uint8_t> parallel(layout.GetStride() * vertices.size());
+
+	EncodeVertices(single.data(), vertices.data(), vertices.size(), layout, quantization);
+	EncodeVertices(parallel.data(), vertices.data(), vertices.size(), layout, quantization, &jobSystem);
+
+	CHECK(single == parallel);
+
+	std::vector<MeshVertex> singleDecoded(vertices.size());
+	std::vector<MeshVertex> parallelDecoded(vertices.size());
+
+	DecodeVertices(singleDecoded.data(), single.data(), vertices.size(), layout, quantization);
+	DecodeVertices(parallelDecoded.data(), single.data(), vertices.size(), layout, quantization, &jobSystem);
+
+	CHECK(std::memcmp(singleDecoded.data(), parallelDecoded.data(), sizeof(MeshVertex) * vertices.size()) == 0);
+
+	jobSystem.Finalize();
+
+}
+
+TEST_CASE(CompactEncodingErrorIsBounded) {
+
+	MeshData mesh = MakeSphereMesh(48);
+
+	VertexLayout layout(kCompactVertexLayoutDesc);
+
+	VertexQuantization quantization = ComputeVertexQuantization(mesh.vertices.data(), mesh.vertices.size());
+
+	std::vector<uint8_t> encoded(layout.GetStride() * mesh.vertices.size());
+
+	EncodeVertices(encoded.data(), mesh.vertices.data(), mesh.vertices.size(), layout, quantization);
+
+	VertexEncodingError error = MeasureVertexEncodingError(mesh.vertices.data(), encoded.data(), mesh.vertices.size(), layout, quantization);
+
+	//位置は1段(直径2を65535に分けた幅)まで、法線は0.05度まで、UVはhalfの丸めまで
+	CHECK(error.maxPositionError <= 2.0f / 65535.0f);
+	CHECK(error.maxNormalError < 0.05f);
+	CHECK(error.maxTexcoordError <= 1.0f / 2048.0f);
+
+	//全部floatで持てば誤差はない
+	VertexLayout full(kFullVertexLayoutDesc);
+
+	std::vector<uint8_t> fullEncoded(full.GetStride() * mesh.vertices.size());
+
+	EncodeVertices(fullEncoded.data(), mesh.vertices.data(), mesh.vertices.size(), full, quantization);
+
+	CHECK(std::memcmp(fullEncoded.data(), mesh.vertices.data(), fullEncoded.size()) == 0);
+
+}
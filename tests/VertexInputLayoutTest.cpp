@@ -0,0 +1,62 @@
+#include "TestFramework.h"
+#include "VertexInputLayout.h"
+#include <cstring>
+
+TEST_CASE(CompactLayoutMapsToQuantizedFormats) {
+
+	VertexLayout layout(kCompactVertexLayoutDesc);
+
+	std::vector<D3D12_INPUT_ELEMENT_DESC> descs = MakeInputElementDescs(layout);
+
+	REQUIRE(descs.size() == 3);
+
+	//Object3d.VS.hlslの入力と同じ並び
+	CHECK(std::strcmp(descs[0].SemanticName, "POSITION") == 0);
+	CHECK(descs[0].Format == DXGI_FORMAT_R16G16B16A16_UNORM);
+	CHECK(descs[0].AlignedByteOffset == 0);
+
+	CHECK(std::strcmp(descs[1].SemanticName, "NORMAL") == 0);
+	CHECK(descs[1].Format == DXGI_FORMAT_R16G16_SNORM);
+	CHECK(descs[1].AlignedByteOffset == 8);
+
+	CHECK(std::strcmp(descs[2].SemanticName, "TEXCOORD") == 0);
+	CHECK(descs[2].Format == DXGI_FORMAT_R16G16_FLOAT);
+	CHECK(descs[2].AlignedByteOffset == 12);
+
+	for (const D3D12_INPUT_ELEMENT_DESC& desc : descs) {
+		CHECK(desc.SemanticIndex == 0);
+		CHECK(desc.InputSlot == 0);
+		CHECK(desc.InputSlotClass == D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA);
+		CHECK(desc.InstanceDataStepRate == 0);
+	}
+
+}
+
+TEST_CASE(FullLayoutMapsToFloatFormats) {
+
+	VertexLayout layout(kFullVertexLayoutDesc);
+
+	std::vector<D3D12_INPUT_ELEMENT_DESC> descs = MakeInputElementDescs(layout);
+
+	REQUIRE(descs.size() == 3);
+
+	CHECK(descs[0].Format == DXGI_FORMAT_R32G32B32A32_FLOAT);
+	CHECK(descs[1].Format == DXGI_FORMAT_R32G32B32_FLOAT);
+	CHECK(descs[1].AlignedByteOffset == 16);
+	CHECK(descs[2].Format == DXGI_FORMAT_R32G32_FLOAT);
+	CHECK(descs[2].AlignedByteOffset == 28);
+
+}
+
+TEST_CASE(MissingElementsAreNotEmitted) {
+
+	VertexLayout layout({ PositionEncoding::kUnorm16, NormalEncoding::kNone, TexcoordEncoding::kFloat16 });
+
+	std::vector<D3D12_INPUT_ELEMENT_DESC> descs = MakeInputElementDescs(layout);
+
+	REQUIRE(descs.size() == 2);
+
+	CHECK(std::strcmp(descs[1].SemanticName, "TEXCOORD") == 0);
+	CHECK(descs[1].AlignedByteOffset == 8);
+
+}